@@ -1,4 +1,5 @@
 #include "Engine/Core/BinaryStream.hpp"
+#include "Engine/Core/crt_compat.h"
 
 BinaryStream::BinaryStream()
 {
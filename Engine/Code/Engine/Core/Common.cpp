@@ -1,4 +1,5 @@
 #include "Engine/Core/Common.hpp"
+#include "Engine/Core/crt_compat.h"
 #include <stdio.h>
 
 char* bytes_to_string(char* out_bytes_string, size_t string_len, size_t bytes)
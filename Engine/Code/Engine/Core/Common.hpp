@@ -3,6 +3,15 @@
 #include <stdint.h>
 #include <memory.h>
 
+#if !defined(_MSC_VER)
+// glibc's <endian.h> defines LITTLE_ENDIAN and BIG_ENDIAN as macros, which would
+// eat the Endianness enum below. Pull it in now and drop them, its include guard
+// keeps them from coming back.
+#include <stdlib.h>
+#undef LITTLE_ENDIAN
+#undef BIG_ENDIAN
+#endif
+
 //----------------------------------------------------------
 // Types
 //
@@ -1,9 +1,10 @@
 #include "Engine/Core/Config.hpp"
+#include "Engine/Core/crt_compat.h"
 #include "Engine/Core/Common.hpp"
 #include "Engine/Core/ErrorWarningAssert.hpp"
 #include "Engine/Core/StringUtils.hpp"
 #include "Engine/Core/Rgba.hpp"
-#include "Engine/Core/Console.hpp"
+#include "Engine/Core/console_command.h"
 
 #include <vector>
 #include <algorithm>
@@ -440,7 +441,7 @@ void ConvertRawValueToRgba(Rgba* out_rgba, const char* rawValue)
 void ConvertAndSetRawValue(const char* key, const char* rawValue)
 {
 	// Don't allow null strings for either keys or values
-	if(key[0] == '\0' || rawValue == '\0'){
+	if(key[0] == '\0' || rawValue[0] == '\0'){
 		return;
 	}
 
@@ -695,6 +696,11 @@ bool ConfigGetString(char** out_value, const char* name)
 	return ConfigGetValue(out_value, name, CONFIG_TYPE_STRING);
 }
 
+bool ConfigGetString(const char** out_value, const char* name)
+{
+	return ConfigGetValue(out_value, name, CONFIG_TYPE_STRING);
+}
+
 bool ConfigGetBool(bool* out_value, const char* name)
 {
 	return ConfigGetValue(out_value, name, CONFIG_TYPE_BOOL);
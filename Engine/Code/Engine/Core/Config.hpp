@@ -14,6 +14,7 @@ void ConfigSet(const char* name, const float value);
 void ConfigSet(const char* name, const Rgba& rgba);
 
 bool ConfigGetString(char** out_value, const char* name);
+bool ConfigGetString(const char** out_value, const char* name);
 bool ConfigGetBool(bool* out_value, const char* name);
 bool ConfigGetInt(int* out_value, const char* name);
 bool ConfigGetFloat(float* out_value, const char* name);
@@ -49,45 +49,6 @@
 
 #define CURSOR_BLINK_COOLDOWN_SECONDS 0.5f
 
-static CriticalSection s_lock;
-static Event<const std::string&> s_print_event;
-
-//---------------------------------------------------------------------------------
-CommandSelfRegister::CommandSelfRegister(const std::string& command_name, ConsoleFunction func, const std::string& desc)
-{
-	console_register_command(command_name, func, desc);
-}
-
-
-
-//---------------------------------------------------------------------------------
-struct ConsoleCommand
-{
-	ConsoleCommand(){};
-	ConsoleCommand(const std::string description, ConsoleFunction function)
-		:m_description(description)
-		, m_function(function)
-	{}
-
-	std::string m_description;
-	ConsoleFunction m_function;
-};
-
-class CommandSystem
-{
-public:
-	std::map<std::string, ConsoleCommand> m_commands;
-
-public:
-	CommandSystem();
-	~CommandSystem();
-
-	void register_command(const std::string& command_name, ConsoleFunction func, const std::string& desc = "");
-	ConsoleCommand* find_command(const std::string& command_name);
-	void run(const std::string& command_name, const std::string& args);
-};
-
-
 
 //---------------------------------------------------------------------------------
 struct ConsoleLine
@@ -175,8 +136,8 @@ private:
 
 
 //---------------------------------------------------------------------------------
+static CriticalSection s_lock;
 static ConsoleDisplay* s_console = nullptr;
-static CommandSystem* s_command_system = nullptr;
 
 
 
@@ -672,8 +633,6 @@ void ConsoleDisplay::PushConsoleLine(const Rgba& color, const std::string& text)
 
 	m_consoleLog.push_back(newInputLine);
 
-    s_print_event.trigger(text);
-
 	if(m_consoleLogScrollOffset != 0){
 		m_consoleLogScrollOffset--;
 	}
@@ -703,25 +662,7 @@ void ConsoleDisplay::ProcessInputBuffer()
 		m_enteredCommands.push_back(m_inputBuffer);
 	}
 
-	std::string commandName;
-	std::string args;
-
-	unsigned int firstWhitespacechar = 0;
-	for(unsigned int charIndex = 0; charIndex < m_inputBuffer.size(); ++charIndex){
-		if(m_inputBuffer[charIndex] == ' '){
-			firstWhitespacechar = charIndex;
-			break;
-		}
-
-		firstWhitespacechar = charIndex;
-		commandName += m_inputBuffer[charIndex];
-	}
-
-	for(unsigned int charIndex = firstWhitespacechar + 1; charIndex < m_inputBuffer.size(); ++charIndex){
-		args += m_inputBuffer[charIndex];
-	}
-
-	s_command_system->run(commandName, args);
+	console_run_command_and_args(m_inputBuffer);
 
 	ResetInputPrompt();
 }
@@ -738,20 +679,6 @@ static void ClearCommand(ConsoleArgs& args)
 	console_clear();
 }
 
-static void HelpCommand(ConsoleArgs& args)
-{
-	for(std::pair<const std::string, ConsoleCommand> commandPair : s_command_system->m_commands){
-		ConsoleCommand command = commandPair.second;
-
-		std::string output;
-		output += commandPair.first;
-		output += ": ";
-		output += command.m_description;
-
-		console_printf(Rgba::WHITE, output);
-	}
-}
-
 static void ExitCommand(ConsoleArgs& args)
 {
 	s_console->Hide();
@@ -788,7 +715,6 @@ static void SaveConsoleCommand(ConsoleArgs& args)
 void ConsoleDisplay::RegisterBuiltInCommands()
 {
 	console_register_command("clear", ClearCommand, "clears the developer console");
-	console_register_command("help", HelpCommand, "shows all registered console commands");
 	console_register_command("exit", ExitCommand, "exits the developer console");
 	console_register_command("save_console", SaveConsoleCommand, "[string:filepath] :saves the console log out to a file. Spaces not currently supported in filepath.");
 }
@@ -841,196 +767,25 @@ std::string ConsoleDisplay::GetSelectedInputText() const
 
 
 //---------------------------------------------------------------------------------
-CommandSystem::CommandSystem()
-{
-}
-
-CommandSystem::~CommandSystem()
-{
-}
-
-void CommandSystem::register_command(const std::string& command_name, ConsoleFunction func, const std::string& desc)
-{
-	if(find_command(command_name)){
-		console_warning("Console command registered twice: " + command_name);
-	}
-	else{
-		m_commands[command_name] = ConsoleCommand(desc, func);
-	}
-}
-
-ConsoleCommand* CommandSystem::find_command(const std::string& command_name)
-{
-	auto iter = m_commands.find(command_name);
-	if(iter != m_commands.end()) {
-		return &iter->second;
-	}
-	else {
-		return nullptr;
-	}
-}
-
-void CommandSystem::run(const std::string& command_name, const std::string& args)
-{
-	ConsoleCommand* command = find_command(command_name);
-
-	if(command){
-		console_success(command_name + " " + args);
-		ConsoleArgs console_args(args);
-        SCOPE_LOCK(&s_console->m_lock); // make sure that we only allow further printing to the console from this command
-		command->m_function(console_args);
-	}
-	else{
-		console_error("Command %s not found!", command_name.c_str());
-	}
-}
-
-
-
-//---------------------------------------------------------------------------------
-ConsoleArgs::ConsoleArgs()
-	:m_raw_args("")
-	,m_cursor(0)
-{
-}
-
-ConsoleArgs::ConsoleArgs(const std::string& raw_args)
-	:m_raw_args(raw_args)
-	,m_cursor(0)
-{
-}
-
-std::string ConsoleArgs::next_string_arg()
-{
-	advance_to_next_token();
-
-	if(is_at_end()){
-		console_warning("A console command tried to get a string arg, but prematurely reached the end");
-		return "";
-	}
-
-	unsigned int token_start = m_cursor;
-	unsigned int token_end = token_start;
-
-	if(m_raw_args[token_start] == '\"'){
-		++m_cursor;
-		token_start = m_cursor;
-
-		while(m_raw_args[m_cursor] != '\"' && !is_at_end()){
-			++m_cursor;
-		}
-
-		token_end = m_cursor;
-		m_cursor++;
-	}
-	else{
-		while(m_raw_args[m_cursor] != ' ' && m_raw_args[m_cursor] != ',' && !is_at_end()){
-			++m_cursor;
-		}
-
-		token_end = m_cursor;
-	}
-
-	return std::string(m_raw_args.begin() + token_start, m_raw_args.begin() + token_end);
-}
-
-unsigned int ConsoleArgs::next_uint_arg()
-{
-	return (unsigned int)next_int_arg();
-}
-
-int ConsoleArgs::next_int_arg()
-{
-	advance_to_next_token();
-
-	if(is_at_end()){
-		console_warning("A console command tried to get an int arg, but prematurely reached the end");
-		return 0;
-	}
-
-	std::string arg_as_string = next_string_arg();
-	return atoi(arg_as_string.c_str());
-}
-
-float ConsoleArgs::next_float_arg()
-{
-	advance_to_next_token();
-
-	if(is_at_end()){
-		console_warning("A console command tried to get a float arg, but prematurely reached the end");
-		return 0.0f;
-	}
-
-	std::string arg_as_string = next_string_arg();
-	return (float)atof(arg_as_string.c_str());
-}
-
-bool ConsoleArgs::next_bool_arg()
+static void push_console_line(const Rgba& color, const std::string& text)
 {
-	advance_to_next_token();
-
-	if(is_at_end()){
-		console_warning("A console command tried to get a bool arg, but prematurely reached the end. Returning false.");
-		return false;
-	}
-
-	std::string arg_as_string = next_string_arg();
-
-	if(arg_as_string == "true" || arg_as_string == "TRUE"){
-		return true;
-	}
-
-	if(arg_as_string == "false" || arg_as_string == "false"){
-		return false;
-	}
-
-	console_error("Could not parse console argument to bool. Returning false.");
-	return false;
+	s_console->PushConsoleLine(color, text);
 }
 
-void ConsoleArgs::advance_to_next_token()
-{
-	if(is_at_end()){
-		return;
-	}
-
-	while(m_raw_args[m_cursor] == ' ' || m_raw_args[m_cursor] == ','){
-		++m_cursor;
-
-		if(is_at_end()){
-			break;
-		}
-	}
-}
-
-std::string ConsoleArgs::get_remaining_args_as_string()
-{
-    advance_to_next_token();
-    return std::string(m_raw_args.begin() + m_cursor, m_raw_args.end());
-}
-
-bool ConsoleArgs::is_at_end()
-{
-	return m_cursor == m_raw_args.size();
-}
-
-
-
-//---------------------------------------------------------------------------------
 void console_init(Font& font)
 {
-    if(nullptr == s_command_system){
-    	s_command_system = new CommandSystem();
-    }
     if(nullptr == s_console){
     	s_console = new ConsoleDisplay(font);
+    	console_set_output(push_console_line);
     }
 }
 
 void console_shutdown()
 {
+    // Waits out any print in flight before the display goes away
+    console_set_output(nullptr);
+
     SCOPE_LOCK(&s_lock);
-	SAFE_DELETE(s_command_system);
 	SAFE_DELETE(s_console);
 }
 
@@ -1090,161 +845,3 @@ void console_register_non_char_key_up(unsigned char uc)
 {
 	s_console->RegisterNonCharKeyUp(uc);
 }
-
-void console_printf(const Rgba& color, const char* format, ...)
-{
-    SCOPE_LOCK(&s_lock);
-	const int MESSAGE_MAX_LENGTH = 2048;
-	char msg_literal[MESSAGE_MAX_LENGTH];
-	va_list arg_list;
-	va_start(arg_list, format);
-	vsnprintf_s(msg_literal, MESSAGE_MAX_LENGTH, _TRUNCATE, format, arg_list);
-	va_end(arg_list);
-	msg_literal[MESSAGE_MAX_LENGTH - 1] = '\0';
-
-	if(s_console){
-		s_console->PushConsoleLine(color, msg_literal);
-	}
-	else{
-		printf("%s\n", msg_literal);
-	}
-}
-
-void console_printf(const Rgba& color, const std::string& text)
-{
-    SCOPE_LOCK(&s_lock);
-	if(s_console){
-		s_console->PushConsoleLine(color, text);
-	}
-	else{
-		printf("%s\n", text.c_str());
-	}
-}
-
-void console_info(const char* format, ...)
-{
-    SCOPE_LOCK(&s_lock);
-	const int MESSAGE_MAX_LENGTH = 2048;
-	char msg_literal[MESSAGE_MAX_LENGTH];
-	va_list arg_list;
-	va_start(arg_list, format);
-	vsnprintf_s(msg_literal, MESSAGE_MAX_LENGTH, _TRUNCATE, format, arg_list);
-	va_end(arg_list);
-	msg_literal[MESSAGE_MAX_LENGTH - 1] = '\0';
-
-	if(s_console){
-		s_console->PushConsoleLine(Rgba::WHITE, msg_literal);
-	}
-	else{
-		printf("%s\n", msg_literal);
-	}
-}
-
-void console_info(const std::string& text)
-{
-	console_printf(Rgba::WHITE, text);
-}
-
-void console_warning(const char* format, ...)
-{
-    SCOPE_LOCK(&s_lock);
-	const int MESSAGE_MAX_LENGTH = 2048;
-	char msg_literal[MESSAGE_MAX_LENGTH];
-	va_list arg_list;
-	va_start(arg_list, format);
-	vsnprintf_s(msg_literal, MESSAGE_MAX_LENGTH, _TRUNCATE, format, arg_list);
-	va_end(arg_list);
-	msg_literal[MESSAGE_MAX_LENGTH - 1] = '\0';
-
-	console_printf(Rgba::YELLOW, msg_literal);
-}
-
-void console_warning(const std::string& text)
-{
-	console_printf(Rgba::YELLOW, text);
-}
-
-void console_error(const char* format, ...)
-{
-    SCOPE_LOCK(&s_lock);
-	const int MESSAGE_MAX_LENGTH = 2048;
-	char msg_literal[MESSAGE_MAX_LENGTH];
-	va_list arg_list;
-	va_start(arg_list, format);
-	vsnprintf_s(msg_literal, MESSAGE_MAX_LENGTH, _TRUNCATE, format, arg_list);
-	va_end(arg_list);
-	msg_literal[MESSAGE_MAX_LENGTH - 1] = '\0';
-
-	console_printf(Rgba::RED, msg_literal);
-}
-
-void console_error(const std::string& text)
-{
-	console_printf(Rgba::RED, text);
-}
-
-void console_success(const char* format, ...)
-{
-    SCOPE_LOCK(&s_lock);
-	const int MESSAGE_MAX_LENGTH = 2048;
-	char msg_literal[MESSAGE_MAX_LENGTH];
-	va_list arg_list;
-	va_start(arg_list, format);
-	vsnprintf_s(msg_literal, MESSAGE_MAX_LENGTH, _TRUNCATE, format, arg_list);
-	va_end(arg_list);
-	msg_literal[MESSAGE_MAX_LENGTH - 1] = '\0';
-
-	console_printf(Rgba::GREEN, msg_literal);
-}
-
-void console_success(const std::string& text)
-{
-	console_printf(Rgba::GREEN, text);
-}
-
-void console_register_command(const std::string& command_name, ConsoleFunction func, const std::string& desc)
-{
-	if(!s_command_system){
-		s_command_system = new CommandSystem();
-	}
-
-	s_command_system->register_command(command_name, func, desc);
-}
-
-void console_run_command(const std::string& command_name)
-{
-	if(!s_command_system){
-		s_command_system = new CommandSystem();
-	}
-
-	s_command_system->run(command_name, "");
-}
-
-void console_run_command_and_args(const std::string& command_and_args)
-{
-	if(!s_command_system){
-		s_command_system = new CommandSystem();
-	}
-
-    size_t split =command_and_args.find_first_of(' ');
-
-    if(split == std::string::npos){
-        s_command_system->run(command_and_args, "");
-        return;
-    }
-
-    std::string command_name = command_and_args.substr(0, split);
-    std::string command_args = command_and_args.substr(split + 1);
-
-	s_command_system->run(command_name, command_args);
-}
-
-void console_register_to_print_event(void* user_arg, print_cb cb)
-{
-    s_print_event.subscribe(user_arg, cb);
-}
-
-void console_unregister_to_print_event(void* user_arg, print_cb cb)
-{
-    s_print_event.unsubscribe(user_arg, cb);
-}
\ No newline at end of file
@@ -13,8 +13,11 @@
 #include "Engine/Core/ErrorWarningAssert.hpp"
 #include "Engine/Core/StringUtils.hpp"
 #include "Engine/Core/log.h"
+#include "Engine/Core/crt_compat.h"
 #include <stdarg.h>
 #include <iostream>
+#include <stdlib.h>
+#include <string.h>
 
 
 //-----------------------------------------------------------------------------------------------
@@ -183,7 +186,7 @@ int SystemDialogue_YesNoCancel( const std::string& messageTitle, const std::stri
 
 
 //-----------------------------------------------------------------------------------------------
-__declspec( noreturn ) void FatalError( const char* filePath, const char* functionName, int lineNum, const std::string& reasonForError, const char* conditionText )
+[[noreturn]] void FatalError( const char* filePath, const char* functionName, int lineNum, const std::string& reasonForError, const char* conditionText )
 {
 	std::string errorMessage = reasonForError;
 	if( reasonForError.empty() )
@@ -200,7 +203,7 @@ __declspec( noreturn ) void FatalError( const char* filePath, const char* functi
 	std::string fullMessageTitle = appName + " :: Error";
 	std::string fullMessageText = errorMessage;
 	fullMessageText += "\n\nThe application will now close.\n";
-	bool isDebuggerPresent = (IsDebuggerPresent() == TRUE);
+	bool isDebuggerPresent = IsDebuggerAvailable();
 	if( isDebuggerPresent )
 	{
 		fullMessageText += "\nDEBUGGER DETECTED!\nWould you like to break and debug?\n  (Yes=debug, No=quit)\n";
@@ -228,7 +231,9 @@ __declspec( noreturn ) void FatalError( const char* filePath, const char* functi
 	if( isDebuggerPresent )
 	{
 		bool isAnswerYes = SystemDialogue_YesNo( fullMessageTitle, fullMessageText, SEVERITY_FATAL );
+		#if defined( PLATFORM_WINDOWS )
 		ShowCursor( TRUE );
+		#endif
 		if( isAnswerYes )
 		{
 		__debugbreak();
@@ -237,12 +242,14 @@ __declspec( noreturn ) void FatalError( const char* filePath, const char* functi
 	else
 	{
 		SystemDialogue_Okay( fullMessageTitle, fullMessageText, SEVERITY_FATAL );
+		#if defined( PLATFORM_WINDOWS )
 		ShowCursor( TRUE );
+		#endif
 	}
 
     log_shutdown();
 
-	exit( 0 );
+	exit( EXIT_FAILURE );
 }
 
 
@@ -264,7 +271,7 @@ void RecoverableWarning( const char* filePath, const char* functionName, int lin
 	std::string fullMessageTitle = appName + " :: Warning";
 	std::string fullMessageText = errorMessage;
 
-	bool isDebuggerPresent = (IsDebuggerPresent() == TRUE);
+	bool isDebuggerPresent = IsDebuggerAvailable();
 	if( isDebuggerPresent )
 	{
 		fullMessageText += "\n\nDEBUGGER DETECTED!\nWould you like to continue running?\n  (Yes=continue, No=quit, Cancel=debug)\n";
@@ -296,7 +303,9 @@ void RecoverableWarning( const char* filePath, const char* functionName, int lin
 	if( isDebuggerPresent )
 	{
 		int answerCode = SystemDialogue_YesNoCancel( fullMessageTitle, fullMessageText, SEVERITY_WARNING );
+		#if defined( PLATFORM_WINDOWS )
 		ShowCursor( TRUE );
+		#endif
 		if( answerCode == 0 ) // "NO"
 		{
             log_shutdown();
@@ -310,7 +319,9 @@ void RecoverableWarning( const char* filePath, const char* functionName, int lin
 	else
 	{
 		bool isAnswerYes = SystemDialogue_YesNo( fullMessageTitle, fullMessageText, SEVERITY_WARNING );
+		#if defined( PLATFORM_WINDOWS )
 		ShowCursor( TRUE );
+		#endif
 		if( !isAnswerYes )
 		{
             log_shutdown();
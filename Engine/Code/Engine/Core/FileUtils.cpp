@@ -1,4 +1,5 @@
 #include "Engine/Core/FileUtils.hpp"
+#include "Engine/Core/crt_compat.h"
 #include "Engine/Core/ErrorWarningAssert.hpp"
 #include "Engine/Core/StringUtils.hpp"
 #include <stdlib.h>
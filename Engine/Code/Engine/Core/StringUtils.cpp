@@ -1,4 +1,5 @@
 #include "Engine/Core/StringUtils.hpp"
+#include "Engine/Core/crt_compat.h"
 #include <stdarg.h>
 
 
@@ -5,13 +5,43 @@
 
 //-----------------------------------------------------------------------------------------------
 #include "Engine/Core/Time.hpp"
+
+#if defined(_WIN32)
 #define WIN32_LEAN_AND_MEAN
 #include <Windows.h>
-
-#include "Engine/Profile/profiler.h"
+#else
+#include <time.h>
+#endif
 
 static uint64_t s_start;
 
+uint64_t get_current_perf_counter()
+{
+#if defined(_WIN32)
+    uint64_t counter;
+    QueryPerformanceCounter((LARGE_INTEGER*)&counter);
+    return counter;
+#else
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((uint64_t)now.tv_sec * 1000000000ULL) + (uint64_t)now.tv_nsec;
+#endif
+}
+
+double perf_counter_to_seconds(uint64_t counter)
+{
+#if defined(_WIN32)
+    static uint64_t s_perf_freq = 0;
+    if(0 == s_perf_freq){
+        QueryPerformanceFrequency((LARGE_INTEGER*)&s_perf_freq);
+    }
+
+    return (double)counter / (double)s_perf_freq;
+#else
+    return (double)counter / 1000000000.0; // CLOCK_MONOTONIC counts nanoseconds
+#endif
+}
+
 void time_init()
 {
     s_start = get_current_perf_counter();
@@ -22,4 +52,26 @@ double get_current_time_seconds()
     uint64_t current = get_current_perf_counter();
     uint64_t elapsed = current - s_start;
     return perf_counter_to_seconds(elapsed);
+}
+
+double get_process_cpu_seconds()
+{
+#if defined(_WIN32)
+    FILETIME creation_time;
+    FILETIME exit_time;
+    FILETIME kernel_time;
+    FILETIME user_time;
+    if(!GetProcessTimes(GetCurrentProcess(), &creation_time, &exit_time, &kernel_time, &user_time)){
+        return 0.0;
+    }
+
+    // 100 ns ticks
+    uint64_t kernel_ticks = ((uint64_t)kernel_time.dwHighDateTime << 32) | kernel_time.dwLowDateTime;
+    uint64_t user_ticks = ((uint64_t)user_time.dwHighDateTime << 32) | user_time.dwLowDateTime;
+    return (double)(kernel_ticks + user_ticks) / 10000000.0;
+#else
+    timespec now;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &now);
+    return (double)now.tv_sec + ((double)now.tv_nsec / 1000000000.0);
+#endif
 }
\ No newline at end of file
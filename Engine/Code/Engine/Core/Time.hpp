@@ -1,4 +1,13 @@
 #pragma once
 
-void    time_init();
-double  get_current_time_seconds();
\ No newline at end of file
+#include <stdint.h>
+
+void        time_init();
+double      get_current_time_seconds();
+
+// Raw high resolution counter, only differences of two mean anything
+uint64_t    get_current_perf_counter();
+double      perf_counter_to_seconds(uint64_t counter);
+
+// CPU time every thread of the process has used, kernel included
+double      get_process_cpu_seconds();
\ No newline at end of file
@@ -0,0 +1,408 @@
+#include "Engine/Core/console_command.h"
+#include "Engine/Core/crt_compat.h"
+#include "Engine/Core/event.h"
+#include "Engine/Thread/critical_section.h"
+#include <map>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+static CriticalSection s_lock;
+static Event<const std::string&> s_print_event;
+static console_output_cb s_output_cb = nullptr;
+
+//---------------------------------------------------------------------------------
+CommandSelfRegister::CommandSelfRegister(const std::string& command_name, ConsoleFunction func, const std::string& desc)
+{
+	console_register_command(command_name, func, desc);
+}
+
+
+
+//---------------------------------------------------------------------------------
+struct ConsoleCommand
+{
+	ConsoleCommand(){};
+	ConsoleCommand(const std::string description, ConsoleFunction function)
+		:m_description(description)
+		, m_function(function)
+	{}
+
+	std::string m_description;
+	ConsoleFunction m_function;
+};
+
+class CommandSystem
+{
+public:
+	std::map<std::string, ConsoleCommand> m_commands;
+
+public:
+	CommandSystem();
+	~CommandSystem();
+
+	void register_command(const std::string& command_name, ConsoleFunction func, const std::string& desc = "");
+	ConsoleCommand* find_command(const std::string& command_name);
+	void run(const std::string& command_name, const std::string& args);
+};
+
+static CommandSystem* s_command_system = nullptr;
+
+
+
+//---------------------------------------------------------------------------------
+static void output_line(const Rgba& color, const std::string& text)
+{
+	if(nullptr != s_output_cb){
+		s_output_cb(color, text);
+	}
+	else{
+		printf("%s\n", text.c_str());
+	}
+
+	s_print_event.trigger(text);
+}
+
+static void HelpCommand(ConsoleArgs& args)
+{
+	for(std::pair<const std::string, ConsoleCommand> commandPair : s_command_system->m_commands){
+		ConsoleCommand command = commandPair.second;
+
+		std::string output;
+		output += commandPair.first;
+		output += ": ";
+		output += command.m_description;
+
+		console_printf(Rgba::WHITE, output);
+	}
+}
+
+static CommandSystem* get_command_system()
+{
+	if(!s_command_system){
+		s_command_system = new CommandSystem();
+		s_command_system->register_command("help", HelpCommand, "shows all registered console commands");
+	}
+
+	return s_command_system;
+}
+
+
+
+//---------------------------------------------------------------------------------
+CommandSystem::CommandSystem()
+{
+}
+
+CommandSystem::~CommandSystem()
+{
+}
+
+void CommandSystem::register_command(const std::string& command_name, ConsoleFunction func, const std::string& desc)
+{
+	if(find_command(command_name)){
+		console_warning("Console command registered twice: " + command_name);
+	}
+	else{
+		m_commands[command_name] = ConsoleCommand(desc, func);
+	}
+}
+
+ConsoleCommand* CommandSystem::find_command(const std::string& command_name)
+{
+	auto iter = m_commands.find(command_name);
+	if(iter != m_commands.end()) {
+		return &iter->second;
+	}
+	else {
+		return nullptr;
+	}
+}
+
+void CommandSystem::run(const std::string& command_name, const std::string& args)
+{
+	ConsoleCommand* command = find_command(command_name);
+
+	if(command){
+		console_success(command_name + " " + args);
+		ConsoleArgs console_args(args);
+        SCOPE_LOCK(&s_lock); // make sure that we only allow further printing to the console from this command
+		command->m_function(console_args);
+	}
+	else{
+		console_error("Command %s not found!", command_name.c_str());
+	}
+}
+
+
+
+//---------------------------------------------------------------------------------
+ConsoleArgs::ConsoleArgs()
+	:m_raw_args("")
+	,m_cursor(0)
+{
+}
+
+ConsoleArgs::ConsoleArgs(const std::string& raw_args)
+	:m_raw_args(raw_args)
+	,m_cursor(0)
+{
+}
+
+std::string ConsoleArgs::next_string_arg()
+{
+	advance_to_next_token();
+
+	if(is_at_end()){
+		console_warning("A console command tried to get a string arg, but prematurely reached the end");
+		return "";
+	}
+
+	unsigned int token_start = m_cursor;
+	unsigned int token_end = token_start;
+
+	if(m_raw_args[token_start] == '\"'){
+		++m_cursor;
+		token_start = m_cursor;
+
+		while(m_raw_args[m_cursor] != '\"' && !is_at_end()){
+			++m_cursor;
+		}
+
+		token_end = m_cursor;
+		m_cursor++;
+	}
+	else{
+		while(m_raw_args[m_cursor] != ' ' && m_raw_args[m_cursor] != ',' && !is_at_end()){
+			++m_cursor;
+		}
+
+		token_end = m_cursor;
+	}
+
+	return std::string(m_raw_args.begin() + token_start, m_raw_args.begin() + token_end);
+}
+
+unsigned int ConsoleArgs::next_uint_arg()
+{
+	return (unsigned int)next_int_arg();
+}
+
+int ConsoleArgs::next_int_arg()
+{
+	advance_to_next_token();
+
+	if(is_at_end()){
+		console_warning("A console command tried to get an int arg, but prematurely reached the end");
+		return 0;
+	}
+
+	std::string arg_as_string = next_string_arg();
+	return atoi(arg_as_string.c_str());
+}
+
+float ConsoleArgs::next_float_arg()
+{
+	advance_to_next_token();
+
+	if(is_at_end()){
+		console_warning("A console command tried to get a float arg, but prematurely reached the end");
+		return 0.0f;
+	}
+
+	std::string arg_as_string = next_string_arg();
+	return (float)atof(arg_as_string.c_str());
+}
+
+bool ConsoleArgs::next_bool_arg()
+{
+	advance_to_next_token();
+
+	if(is_at_end()){
+		console_warning("A console command tried to get a bool arg, but prematurely reached the end. Returning false.");
+		return false;
+	}
+
+	std::string arg_as_string = next_string_arg();
+
+	if(arg_as_string == "true" || arg_as_string == "TRUE"){
+		return true;
+	}
+
+	if(arg_as_string == "false" || arg_as_string == "false"){
+		return false;
+	}
+
+	console_error("Could not parse console argument to bool. Returning false.");
+	return false;
+}
+
+void ConsoleArgs::advance_to_next_token()
+{
+	if(is_at_end()){
+		return;
+	}
+
+	while(m_raw_args[m_cursor] == ' ' || m_raw_args[m_cursor] == ','){
+		++m_cursor;
+
+		if(is_at_end()){
+			break;
+		}
+	}
+}
+
+std::string ConsoleArgs::get_remaining_args_as_string()
+{
+    advance_to_next_token();
+    return std::string(m_raw_args.begin() + m_cursor, m_raw_args.end());
+}
+
+bool ConsoleArgs::is_at_end()
+{
+	return m_cursor == m_raw_args.size();
+}
+
+
+
+
+
+//---------------------------------------------------------------------------------
+void console_printf(const Rgba& color, const char* format, ...)
+{
+    SCOPE_LOCK(&s_lock);
+	const int MESSAGE_MAX_LENGTH = 2048;
+	char msg_literal[MESSAGE_MAX_LENGTH];
+	va_list arg_list;
+	va_start(arg_list, format);
+	vsnprintf_s(msg_literal, MESSAGE_MAX_LENGTH, _TRUNCATE, format, arg_list);
+	va_end(arg_list);
+	msg_literal[MESSAGE_MAX_LENGTH - 1] = '\0';
+
+	output_line(color, msg_literal);
+}
+
+void console_printf(const Rgba& color, const std::string& text)
+{
+    SCOPE_LOCK(&s_lock);
+	output_line(color, text);
+}
+
+void console_info(const char* format, ...)
+{
+    SCOPE_LOCK(&s_lock);
+	const int MESSAGE_MAX_LENGTH = 2048;
+	char msg_literal[MESSAGE_MAX_LENGTH];
+	va_list arg_list;
+	va_start(arg_list, format);
+	vsnprintf_s(msg_literal, MESSAGE_MAX_LENGTH, _TRUNCATE, format, arg_list);
+	va_end(arg_list);
+	msg_literal[MESSAGE_MAX_LENGTH - 1] = '\0';
+
+	output_line(Rgba::WHITE, msg_literal);
+}
+
+void console_info(const std::string& text)
+{
+	console_printf(Rgba::WHITE, text);
+}
+
+void console_warning(const char* format, ...)
+{
+    SCOPE_LOCK(&s_lock);
+	const int MESSAGE_MAX_LENGTH = 2048;
+	char msg_literal[MESSAGE_MAX_LENGTH];
+	va_list arg_list;
+	va_start(arg_list, format);
+	vsnprintf_s(msg_literal, MESSAGE_MAX_LENGTH, _TRUNCATE, format, arg_list);
+	va_end(arg_list);
+	msg_literal[MESSAGE_MAX_LENGTH - 1] = '\0';
+
+	console_printf(Rgba::YELLOW, msg_literal);
+}
+
+void console_warning(const std::string& text)
+{
+	console_printf(Rgba::YELLOW, text);
+}
+
+void console_error(const char* format, ...)
+{
+    SCOPE_LOCK(&s_lock);
+	const int MESSAGE_MAX_LENGTH = 2048;
+	char msg_literal[MESSAGE_MAX_LENGTH];
+	va_list arg_list;
+	va_start(arg_list, format);
+	vsnprintf_s(msg_literal, MESSAGE_MAX_LENGTH, _TRUNCATE, format, arg_list);
+	va_end(arg_list);
+	msg_literal[MESSAGE_MAX_LENGTH - 1] = '\0';
+
+	console_printf(Rgba::RED, msg_literal);
+}
+
+void console_error(const std::string& text)
+{
+	console_printf(Rgba::RED, text);
+}
+
+void console_success(const char* format, ...)
+{
+    SCOPE_LOCK(&s_lock);
+	const int MESSAGE_MAX_LENGTH = 2048;
+	char msg_literal[MESSAGE_MAX_LENGTH];
+	va_list arg_list;
+	va_start(arg_list, format);
+	vsnprintf_s(msg_literal, MESSAGE_MAX_LENGTH, _TRUNCATE, format, arg_list);
+	va_end(arg_list);
+	msg_literal[MESSAGE_MAX_LENGTH - 1] = '\0';
+
+	console_printf(Rgba::GREEN, msg_literal);
+}
+
+void console_success(const std::string& text)
+{
+	console_printf(Rgba::GREEN, text);
+}
+
+void console_register_command(const std::string& command_name, ConsoleFunction func, const std::string& desc)
+{
+	get_command_system()->register_command(command_name, func, desc);
+}
+
+void console_run_command(const std::string& command_name)
+{
+	get_command_system()->run(command_name, "");
+}
+
+void console_run_command_and_args(const std::string& command_and_args)
+{
+	CommandSystem* command_system = get_command_system();
+
+    size_t split =command_and_args.find_first_of(' ');
+
+    if(split == std::string::npos){
+        command_system->run(command_and_args, "");
+        return;
+    }
+
+    std::string command_name = command_and_args.substr(0, split);
+    std::string command_args = command_and_args.substr(split + 1);
+
+	command_system->run(command_name, command_args);
+}
+
+void console_register_to_print_event(void* user_arg, print_cb cb)
+{
+    s_print_event.subscribe(user_arg, cb);
+}
+
+void console_unregister_to_print_event(void* user_arg, print_cb cb)
+{
+    s_print_event.unsubscribe(user_arg, (void*)cb);
+}
+
+void console_set_output(console_output_cb output_cb)
+{
+    SCOPE_LOCK(&s_lock);
+    s_output_cb = output_cb;
+}
@@ -0,0 +1,146 @@
+#include "Engine/Core/cpu.h"
+#include "Engine/Core/console_command.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#include <immintrin.h>
+#else
+#include <cpuid.h>
+#endif
+
+//-----------------------------------------------------
+// Internal helpers
+
+static SimdLevel s_max_simd_level = NUM_SIMD_LEVELS;
+
+static void cpuid(int* out_regs, int leaf, int subleaf)
+{
+#if defined(_MSC_VER)
+    __cpuidex(out_regs, leaf, subleaf);
+#else
+    unsigned int a = 0, b = 0, c = 0, d = 0;
+    __get_cpuid_count((unsigned int)leaf, (unsigned int)subleaf, &a, &b, &c, &d);
+    out_regs[0] = (int)a;
+    out_regs[1] = (int)b;
+    out_regs[2] = (int)c;
+    out_regs[3] = (int)d;
+#endif
+}
+
+static unsigned long long read_xcr0()
+{
+#if defined(_MSC_VER)
+    return _xgetbv(0);
+#else
+    // _xgetbv needs -mxsave on gcc/clang, the instruction itself doesn't
+    unsigned int lo = 0, hi = 0;
+    __asm__ volatile("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+    return ((unsigned long long)hi << 32) | lo;
+#endif
+}
+
+struct cpu_features_t
+{
+    bool sse41;
+    bool avx2;
+
+    cpu_features_t()
+        :sse41(false)
+        ,avx2(false)
+    {
+        int regs[4];
+        cpuid(regs, 0, 0);
+        int max_leaf = regs[0];
+
+        cpuid(regs, 1, 0);
+        sse41 = (regs[2] & (1 << 19)) != 0;
+
+        bool has_osxsave = (regs[2] & (1 << 27)) != 0;
+        bool has_avx = (regs[2] & (1 << 28)) != 0;
+
+        // AVX state has to be enabled by the OS as well, not just the CPU
+        bool os_saves_ymm = false;
+        if(has_osxsave && has_avx){
+            unsigned long long xcr0 = read_xcr0();
+            os_saves_ymm = (xcr0 & 0x6) == 0x6;
+        }
+
+        if(max_leaf >= 7 && os_saves_ymm){
+            cpuid(regs, 7, 0);
+            avx2 = (regs[1] & (1 << 5)) != 0;
+        }
+    }
+};
+
+static const cpu_features_t& get_cpu_features()
+{
+    static cpu_features_t s_features;
+    return s_features;
+}
+
+//-----------------------------------------------------
+// Public API
+
+bool cpu_has_sse41()
+{
+    return get_cpu_features().sse41;
+}
+
+bool cpu_has_avx2()
+{
+    return get_cpu_features().avx2;
+}
+
+SimdLevel cpu_get_detected_simd_level()
+{
+    if(cpu_has_avx2()){
+        return SIMD_LEVEL_AVX2;
+    }
+
+    if(cpu_has_sse41()){
+        return SIMD_LEVEL_SSE41;
+    }
+
+    return SIMD_LEVEL_SCALAR;
+}
+
+SimdLevel cpu_get_simd_level()
+{
+    SimdLevel detected = cpu_get_detected_simd_level();
+    return (detected < s_max_simd_level) ? detected : s_max_simd_level;
+}
+
+void cpu_set_max_simd_level(SimdLevel level)
+{
+    s_max_simd_level = level;
+}
+
+const char* cpu_get_simd_level_name(SimdLevel level)
+{
+    switch(level)
+    {
+        case SIMD_LEVEL_SCALAR: return "scalar";
+        case SIMD_LEVEL_SSE41:  return "sse4.1";
+        case SIMD_LEVEL_AVX2:   return "avx2";
+        default:                return "unknown";
+    }
+}
+
+COMMAND(cpu_simd, "[string:scalar|sse4.1|avx2|auto] Caps the SIMD level used by batched math paths")
+{
+    std::string level = args.is_at_end() ? "auto" : args.next_string_arg();
+    if(level == "scalar"){
+        cpu_set_max_simd_level(SIMD_LEVEL_SCALAR);
+    }else if(level == "sse4.1"){
+        cpu_set_max_simd_level(SIMD_LEVEL_SSE41);
+    }else if(level == "avx2"){
+        cpu_set_max_simd_level(SIMD_LEVEL_AVX2);
+    }else if(level == "auto"){
+        cpu_set_max_simd_level(NUM_SIMD_LEVELS);
+    }else{
+        console_warning("Unknown simd level \"%s\"", level.c_str());
+        return;
+    }
+
+    console_info("simd level: %s (detected %s)", cpu_get_simd_level_name(cpu_get_simd_level()), cpu_get_simd_level_name(cpu_get_detected_simd_level()));
+}
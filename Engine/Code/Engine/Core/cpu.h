@@ -0,0 +1,23 @@
+#pragma once
+
+//-----------------------------------------------------
+// CPU feature detection
+//
+// Used by the batched math paths to pick the widest SIMD kernel the
+// current machine supports. Detection runs once and is cached, the
+// level can be capped (e.g. for benchmarking the fallback paths).
+enum SimdLevel : unsigned int
+{
+    SIMD_LEVEL_SCALAR,
+    SIMD_LEVEL_SSE41,
+    SIMD_LEVEL_AVX2,
+    NUM_SIMD_LEVELS
+};
+
+bool            cpu_has_sse41();
+bool            cpu_has_avx2();
+
+SimdLevel       cpu_get_detected_simd_level();
+SimdLevel       cpu_get_simd_level();
+void            cpu_set_max_simd_level(SimdLevel level);
+const char*     cpu_get_simd_level_name(SimdLevel level);
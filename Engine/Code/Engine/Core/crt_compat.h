@@ -0,0 +1,84 @@
+#pragma once
+
+//-----------------------------------------------------
+// CRT Compat
+//
+// The engine is written against MSVC's CRT, *_s calls included. Other
+// compilers get thin versions of the ones the headless modules use so those
+// files build as is. Nothing here on MSVC.
+
+#if !defined(_MSC_VER)
+
+#include <alloca.h>
+#include <errno.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#define __forceinline   inline __attribute__((always_inline))
+#define __debugbreak()  __builtin_trap()
+#define _alloca         alloca
+
+#define _TRUNCATE       ((size_t)-1)
+
+typedef int errno_t;
+
+inline errno_t fopen_s(FILE** out_file, const char* filename, const char* mode)
+{
+    *out_file = fopen(filename, mode);
+    return (nullptr == *out_file) ? errno : 0;
+}
+
+inline size_t fread_s(void* buffer, size_t buffer_size, size_t element_size, size_t count, FILE* file)
+{
+    if((element_size == 0) || (count > buffer_size / element_size)){
+        return 0;
+    }
+    return fread(buffer, element_size, count, file);
+}
+
+inline errno_t memcpy_s(void* dest, size_t dest_size, const void* src, size_t count)
+{
+    if(count > dest_size){
+        return ERANGE;
+    }
+    memcpy(dest, src, count);
+    return 0;
+}
+
+// Same argument order as MSVC, the C11 one is swapped
+inline errno_t localtime_s(struct tm* out_time, const time_t* time)
+{
+    return (nullptr == localtime_r(time, out_time)) ? EINVAL : 0;
+}
+
+// Only the _TRUNCATE flavour is used, long output is cut rather than failing
+inline int vsnprintf_s(char* buffer, size_t buffer_size, size_t max_count, const char* format, va_list args)
+{
+    (void)max_count;
+    int written = vsnprintf(buffer, buffer_size, format, args);
+    return ((written < 0) || ((size_t)written >= buffer_size)) ? -1 : written;
+}
+
+inline int sprintf_s(char* buffer, size_t buffer_size, const char* format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    int written = vsnprintf(buffer, buffer_size, format, args);
+    va_end(args);
+    return written;
+}
+
+template <size_t SIZE>
+inline int sprintf_s(char (&buffer)[SIZE], const char* format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    int written = vsnprintf(buffer, SIZE, format, args);
+    va_end(args);
+    return written;
+}
+
+#endif
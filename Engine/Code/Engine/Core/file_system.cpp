@@ -0,0 +1,235 @@
+#include "Engine/Core/file_system.h"
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#else
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <string.h>
+
+//-----------------------------------------------------
+// Internal helpers
+
+static bool ends_with(const std::string& text, const char* suffix)
+{
+    size_t suffix_length = strlen(suffix);
+    return (text.size() >= suffix_length) && (text.compare(text.size() - suffix_length, suffix_length, suffix) == 0);
+}
+
+static bool create_directory(const char* path)
+{
+#if defined(_WIN32)
+    return CreateDirectoryA(path, NULL) || (GetLastError() == ERROR_ALREADY_EXISTS);
+#else
+    return (mkdir(path, 0777) == 0) || (errno == EEXIST);
+#endif
+}
+
+//-----------------------------------------------------
+// Public API
+
+bool file_create_directories(const char* path)
+{
+    // The OS calls only make the last level, so walk the path
+    std::string directory = path;
+    if(!directory.empty() && (directory.back() != '/') && (directory.back() != '\\')){
+        directory += "/";
+    }
+
+    for(size_t i = 0; i < directory.size(); ++i){
+        if((directory[i] != '/') && (directory[i] != '\\')){
+            continue;
+        }
+
+        std::string parent = directory.substr(0, i);
+        if(parent.empty() || (parent.back() == ':') || (parent == ".") || (parent == "..")){
+            continue;
+        }
+
+        if(!create_directory(parent.c_str())){
+            return false;
+        }
+    }
+    return true;
+}
+
+void file_find(const char* directory, const char* extension, std::vector<file_entry_t>* out_entries)
+{
+    std::string prefix = directory;
+    if(!prefix.empty() && (prefix.back() != '/') && (prefix.back() != '\\')){
+        prefix += "/";
+    }
+
+#if defined(_WIN32)
+    std::string search = prefix + "*" + extension;
+
+    WIN32_FIND_DATAA file_data;
+    HANDLE fh = FindFirstFileA(search.c_str(), &file_data);
+    if(fh == INVALID_HANDLE_VALUE){
+        return;
+    }
+
+    do{
+        // *.vol also matches *.vole on Windows, the 8.3 names see to that
+        if((file_data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) || !ends_with(file_data.cFileName, extension)){
+            continue;
+        }
+
+        file_entry_t entry;
+        entry.name              = file_data.cFileName;
+        entry.size              = ((uint64_t)file_data.nFileSizeHigh << 32) | file_data.nFileSizeLow;
+        entry.last_write_time   = ((uint64_t)file_data.ftLastWriteTime.dwHighDateTime << 32) | file_data.ftLastWriteTime.dwLowDateTime;
+        out_entries->push_back(entry);
+    }while(FindNextFileA(fh, &file_data));
+
+    FindClose(fh);
+#else
+    DIR* dir = opendir(prefix.empty() ? "." : prefix.c_str());
+    if(nullptr == dir){
+        return;
+    }
+
+    while(struct dirent* dir_entry = readdir(dir)){
+        if(!ends_with(dir_entry->d_name, extension)){
+            continue;
+        }
+
+        struct stat file_stat;
+        std::string path = prefix + dir_entry->d_name;
+        if((stat(path.c_str(), &file_stat) != 0) || !S_ISREG(file_stat.st_mode)){
+            continue;
+        }
+
+        file_entry_t entry;
+        entry.name              = dir_entry->d_name;
+        entry.size              = (uint64_t)file_stat.st_size;
+        entry.last_write_time   = ((uint64_t)file_stat.st_mtim.tv_sec * 1000000000ULL) + (uint64_t)file_stat.st_mtim.tv_nsec;
+        out_entries->push_back(entry);
+    }
+
+    closedir(dir);
+#endif
+}
+
+bool file_touch(const char* path)
+{
+#if defined(_WIN32)
+    HANDLE file = CreateFileA(path, FILE_WRITE_ATTRIBUTES, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if(file == INVALID_HANDLE_VALUE){
+        return false;
+    }
+
+    FILETIME now;
+    GetSystemTimeAsFileTime(&now);
+    BOOL touched = SetFileTime(file, NULL, NULL, &now);
+    CloseHandle(file);
+    return touched != 0;
+#else
+    return utimensat(AT_FDCWD, path, nullptr, 0) == 0;
+#endif
+}
+
+bool file_replace(const char* from, const char* to)
+{
+#if defined(_WIN32)
+    return MoveFileExA(from, to, MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+    return rename(from, to) == 0;
+#endif
+}
+
+bool file_delete(const char* path)
+{
+#if defined(_WIN32)
+    return DeleteFileA(path) != 0;
+#else
+    return unlink(path) == 0;
+#endif
+}
+
+bool file_map(const char* path, file_mapping_t* out_mapping)
+{
+    *out_mapping = file_mapping_t();
+
+#if defined(_WIN32)
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if(file == INVALID_HANDLE_VALUE){
+        return false;
+    }
+
+    LARGE_INTEGER file_size;
+    if(!GetFileSizeEx(file, &file_size) || (file_size.QuadPart == 0)){
+        CloseHandle(file);
+        return false;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if(mapping == NULL){
+        CloseHandle(file);
+        return false;
+    }
+
+    const void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if(data == NULL){
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+
+    out_mapping->data           = (const unsigned char*)data;
+    out_mapping->size           = (uint64_t)file_size.QuadPart;
+    out_mapping->file_handle    = file;
+    out_mapping->mapping_handle = mapping;
+    return true;
+#else
+    int fd = open(path, O_RDONLY);
+    if(fd < 0){
+        return false;
+    }
+
+    struct stat file_stat;
+    if((fstat(fd, &file_stat) != 0) || (file_stat.st_size <= 0)){
+        close(fd);
+        return false;
+    }
+
+    // The mapping holds its own reference to the file
+    void* data = mmap(nullptr, (size_t)file_stat.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if(data == MAP_FAILED){
+        return false;
+    }
+
+    out_mapping->data = (const unsigned char*)data;
+    out_mapping->size = (uint64_t)file_stat.st_size;
+    return true;
+#endif
+}
+
+void file_unmap(file_mapping_t* mapping)
+{
+#if defined(_WIN32)
+    if(nullptr != mapping->data){
+        UnmapViewOfFile(mapping->data);
+    }
+    if(nullptr != mapping->mapping_handle){
+        CloseHandle((HANDLE)mapping->mapping_handle);
+    }
+    if(nullptr != mapping->file_handle){
+        CloseHandle((HANDLE)mapping->file_handle);
+    }
+#else
+    if(nullptr != mapping->data){
+        munmap((void*)mapping->data, (size_t)mapping->size);
+    }
+#endif
+    *mapping = file_mapping_t();
+}
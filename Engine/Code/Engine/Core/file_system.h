@@ -0,0 +1,54 @@
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+//-----------------------------------------------------
+// File System
+//
+// The handful of OS file calls the engine's data modules need beyond stdio,
+// Win32 or POSIX underneath, so those modules build for the headless tools
+// on any platform. Paths take either kind of slash.
+
+// Read-only view of a whole file, see file_map
+struct file_mapping_t
+{
+    const unsigned char*    data;
+    uint64_t                size;
+    void*                   file_handle;    // Win32 only, POSIX keeps nothing open
+    void*                   mapping_handle;
+
+    file_mapping_t()
+        :data(nullptr)
+        ,size(0)
+        ,file_handle(nullptr)
+        ,mapping_handle(nullptr)
+    {}
+};
+
+struct file_entry_t
+{
+    std::string     name;               // no directory
+    uint64_t        size;
+    uint64_t        last_write_time;    // OS ticks, only good for ordering
+};
+
+// Creates every missing directory along <path>. A path that doesn't end in a
+// slash counts its last part as a directory too.
+bool    file_create_directories(const char* path);
+
+// Regular files in <directory> whose names end in <extension>, in no particular order
+void    file_find(const char* directory, const char* extension, std::vector<file_entry_t>* out_entries);
+
+// Stamps the last write time with now
+bool    file_touch(const char* path);
+
+// Renames over whatever is at <to> in one step
+bool    file_replace(const char* from, const char* to);
+bool    file_delete(const char* path);
+
+// Maps <path> read-only, pages come in as they're touched. Empty files fail,
+// there's nothing to map.
+bool    file_map(const char* path, file_mapping_t* out_mapping);
+void    file_unmap(file_mapping_t* mapping);
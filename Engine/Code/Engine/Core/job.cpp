@@ -5,9 +5,14 @@
 #include "Engine/Thread/thread.h"
 #include "Engine/Thread/signal.h"
 #include "Engine/Thread/thread_safe_queue.h"
+#include "Engine/Thread/work_stealing_deque.h"
+#include "Engine/Thread/fiber.h"
 #include "Engine/Thread/atomic.h"
 #include "Engine/Profile/profiler.h"
 #include "Engine/Memory/thread_safe_block_allocator.h"
+#include "Engine/Math/MathUtils.hpp"
+#include <limits.h>
+#include <string.h>
 #include <thread>
 
 //-----------------------------------------------------
@@ -16,6 +21,81 @@
 static JobConsumer                  s_main_thread_consumer;
 static ThreadSafeBlockAllocator*    s_job_allocator;
 
+static const char* s_job_scheduler_names[NUM_JOB_SCHEDULERS] = {
+    "stealing",
+    "shared",
+};
+
+static const char* s_job_priority_names[NUM_JOB_PRIORITIES] = {
+    "critical",
+    "frame",
+    "background",
+};
+
+struct generic_worker_t;
+
+// A pooled fiber jobs run on, always on the same worker
+struct job_fiber_t
+{
+    fiber_t*            fiber;
+    generic_worker_t*   worker;
+    Job*                job;                // nullptr once it's finished
+    job_counter_t*      wait_counter;       // what it's parked on, if anything
+    Job*                wait_job;
+};
+
+// One per generic thread. Only the worker touches its fibers and counters.
+struct generic_worker_t
+{
+    WorkStealingDeque<Job>      deques[NUM_JOB_PRIORITIES];
+    unsigned int                victim_seed;        // xorshift, where to start looking for a job to steal
+    unsigned int                num_jobs_run;
+    unsigned int                num_steals;
+    unsigned int                num_sleeps;
+    unsigned int                num_parks;
+
+    fiber_t*                    thread_fiber;       // the worker's own stack, nullptr without fibers
+    job_fiber_t*                current_fiber;      // nullptr while on the thread's stack
+    std::vector<job_fiber_t*>   free_fibers;
+    std::vector<job_fiber_t*>   parked_fibers;
+    std::vector<Job*>           skipped_jobs;       // scratch for looking through its own deques
+
+    generic_worker_t(unsigned int worker_id)
+        :victim_seed(worker_id * 2654435761u + 1)
+        ,num_jobs_run(0)
+        ,num_steals(0)
+        ,num_sleeps(0)
+        ,num_parks(0)
+        ,thread_fiber(nullptr)
+        ,current_fiber(nullptr)
+    {}
+};
+
+// The worker the calling thread is, nullptr off the generic threads
+static thread_local generic_worker_t* s_current_worker = nullptr;
+
+// The job the calling thread is running, innermost when one runs inside another's wait
+static thread_local Job* s_current_job = nullptr;
+
+struct parallel_for_t
+{
+    job_item_cb     item_cb;
+    void*           user_data;
+    unsigned int    num_items;
+    unsigned int    next_item;
+};
+
+struct parallel_range_t
+{
+    job_range_cb        range_cb;
+    void*               user_data;
+    job_range_options_t options;
+    unsigned int        target_items;       // piece size when no axis has a grain
+    unsigned int        max_jobs;
+    job_counter_t       jobs_out;           // split off halves not done yet
+    unsigned int        num_pieces;
+};
+
 static unsigned int calculate_num_generic_threads_to_create(int num_generic_threads_requested)
 {
     int num_generic_threads_to_create = 0;
@@ -27,48 +107,78 @@ static unsigned int calculate_num_generic_threads_to_create(int num_generic_thre
         int core_count = (int)std::thread::hardware_concurrency();
         num_generic_threads_to_create = core_count + num_generic_threads_requested;
     }
-    num_generic_threads_to_create = max(1, num_generic_threads_to_create);
+    num_generic_threads_to_create = Max(1, num_generic_threads_to_create);
     return num_generic_threads_to_create;
 }
 
 class JobSystem
 {
 public:
+    JobScheduler            m_scheduler;
+    unsigned int            m_fibers_per_worker;
     unsigned int            m_num_generic_threads;
     thread_handle_t*        m_generic_threads;
+    generic_worker_t**      m_generic_workers;
+    unsigned int            m_num_sleeping_workers;
+    unsigned int            m_num_parked_fibers;    // across every worker, so finishing jobs know to wake them
     JobConsumer             m_generic_consumer;
 
     unsigned int            m_num_queues;
-    ThreadSafeQueue<Job*>*  m_queues;
+    ThreadSafeQueue<Job*>*  m_queues;           // per type, then per priority
     Signal**                m_signals;
+    job_deadline_stats_t    m_deadline_stats[NUM_JOB_PRIORITIES];
+    unsigned int            m_num_injected[NUM_JOB_PRIORITIES];   // in the GENERIC queues, a hint to skip their lock
+    unsigned int            m_num_deadlines_out[NUM_JOB_TYPES][NUM_JOB_PRIORITIES];   // dispatched with a deadline and not run yet, same
 
     bool                    m_is_running;
 
 public:
-    JobSystem(unsigned int num_generic_threads_to_create);
+    JobSystem(unsigned int num_generic_threads_to_create, JobScheduler scheduler, unsigned int fibers_per_worker);
     ~JobSystem();
 
     void init();
     void shutdown();
+    void run_generic_worker(generic_worker_t* worker);
+    void run_worker_job(generic_worker_t* worker, Job* job);
+    Job* sleep_generic_worker(generic_worker_t* worker);
+    bool run_ready_job(JobType type, JobPriority least_urgent = JOB_PRIORITY_BACKGROUND);
+    bool run_waited_job(JobType type, job_counter_t* counter, Job* job);
+
+    static bool is_waited_work(Job* ready, job_counter_t* counter, Job* job);
+    static void run_job_fiber(void* user_data);
 };
 
 static JobSystem* g_job_system = nullptr;
 
-JobSystem::JobSystem(unsigned int num_generic_threads_to_create)
-    :m_num_generic_threads(num_generic_threads_to_create)
+JobSystem::JobSystem(unsigned int num_generic_threads_to_create, JobScheduler scheduler, unsigned int fibers_per_worker)
+    :m_scheduler(scheduler)
+    ,m_fibers_per_worker((scheduler == JOB_SCHEDULER_WORK_STEALING) ? fibers_per_worker : 0)
+    ,m_num_generic_threads(num_generic_threads_to_create)
     ,m_generic_threads(nullptr)
-    ,m_num_queues(NUM_JOB_TYPES)
+    ,m_generic_workers(nullptr)
+    ,m_num_sleeping_workers(0)
+    ,m_num_parked_fibers(0)
+    ,m_num_queues(NUM_JOB_TYPES * NUM_JOB_PRIORITIES)
     ,m_queues(nullptr)
     ,m_signals(nullptr)
     ,m_is_running(false)
 {
     m_generic_threads       = new thread_handle_t[num_generic_threads_to_create];
-    m_queues                = new ThreadSafeQueue<Job*>[NUM_JOB_TYPES];
+    m_generic_workers       = new generic_worker_t*[num_generic_threads_to_create];
+    m_queues                = new ThreadSafeQueue<Job*>[m_num_queues];
     m_signals               = new Signal*[NUM_JOB_TYPES];
 
     memset(m_signals, 0, sizeof(Signal*) * NUM_JOB_TYPES);
+    memset(m_deadline_stats, 0, sizeof(m_deadline_stats));
+    memset(m_num_injected, 0, sizeof(m_num_injected));
+    memset(m_num_deadlines_out, 0, sizeof(m_num_deadlines_out));
     memset(m_generic_threads, 0, sizeof(thread_handle_t) * num_generic_threads_to_create);
 
+    // Separate allocations so the deques don't share cache lines
+    for(unsigned int i = 0; i < num_generic_threads_to_create; ++i){
+        m_generic_workers[i] = new generic_worker_t(i);
+    }
+
     m_signals[JOB_TYPE_GENERIC]  = new Signal();
     m_generic_consumer.add_type(JOB_TYPE_GENERIC);
 }
@@ -78,17 +188,508 @@ JobSystem::~JobSystem()
     shutdown();
 }
 
+static bool is_work_stealing(JobType type)
+{
+    return (type == JOB_TYPE_GENERIC) && (g_job_system->m_scheduler == JOB_SCHEDULER_WORK_STEALING);
+}
+
+static ThreadSafeQueue<Job*>& get_job_queue(JobType type, unsigned int priority)
+{
+    return g_job_system->m_queues[(type * NUM_JOB_PRIORITIES) + priority];
+}
+
+static Job* steal_generic_job(generic_worker_t* worker, unsigned int priority)
+{
+    unsigned int num_workers = g_job_system->m_num_generic_threads;
+    unsigned int first = 0;
+    if(nullptr != worker){
+        worker->victim_seed ^= worker->victim_seed << 13;
+        worker->victim_seed ^= worker->victim_seed >> 17;
+        worker->victim_seed ^= worker->victim_seed << 5;
+        first = worker->victim_seed % num_workers;
+    }
+
+    for(unsigned int i = 0; i < num_workers; ++i){
+        generic_worker_t* victim = g_job_system->m_generic_workers[(first + i) % num_workers];
+        if(victim == worker){
+            continue;
+        }
+
+        if(victim->deques[priority].empty()){
+            continue;
+        }
+
+        Job* job = victim->deques[priority].steal();
+        if(nullptr != job){
+            if(nullptr != worker){
+                ++worker->num_steals;
+            }
+            return job;
+        }
+    }
+    return nullptr;
+}
+
+// A job of <type> from the priority below whose deadline has passed. It
+// counts as <priority> now and goes ahead of the jobs already there.
+static Job* pop_overdue_job(JobType type, unsigned int priority)
+{
+    unsigned int below = priority + 1;
+    if((below >= NUM_JOB_PRIORITIES) || (atomic_load_acquire(&g_job_system->m_num_deadlines_out[type][below]) == 0)){
+        return nullptr;
+    }
+
+    double now = get_current_time_seconds();
+    auto is_overdue = [now](Job* queued) -> bool{
+        return (queued->m_deadline_seconds > 0.0) && (now > queued->m_deadline_seconds);
+    };
+
+    Job* job = nullptr;
+    if(!get_job_queue(type, below).pop_first(is_overdue, &job)){
+        return nullptr;
+    }
+
+    if(is_work_stealing(type)){
+        atomic_decr(&g_job_system->m_num_injected[below]);
+    }
+    return job;
+}
+
+// Overdue jobs from the priority below, own deque newest first, then what other threads
+// dispatched, then someone else's oldest. Every priority is looked at for every job, so
+// empty ones are skipped without a fence or a lock.
+static Job* find_generic_job_at(generic_worker_t* worker, unsigned int priority)
+{
+    Job* job = pop_overdue_job(JOB_TYPE_GENERIC, priority);
+    if(nullptr != job){
+        return job;
+    }
+
+    if((nullptr != worker) && !worker->deques[priority].empty()){
+        job = worker->deques[priority].pop();
+        if(nullptr != job){
+            return job;
+        }
+    }
+
+    if((atomic_load_acquire(&g_job_system->m_num_injected[priority]) > 0) && get_job_queue(JOB_TYPE_GENERIC, priority).pop(&job)){
+        atomic_decr(&g_job_system->m_num_injected[priority]);
+        return job;
+    }
+    return steal_generic_job(worker, priority);
+}
+
+// The most urgent job, down to <least_urgent>
+static Job* find_generic_job(generic_worker_t* worker, JobPriority least_urgent = JOB_PRIORITY_BACKGROUND)
+{
+    for(unsigned int priority = 0; priority <= (unsigned int)least_urgent; ++priority){
+        Job* job = find_generic_job_at(worker, priority);
+        if(nullptr != job){
+            return job;
+        }
+    }
+    return nullptr;
+}
+
+static Job* pop_job_at(JobType type, unsigned int priority)
+{
+    if(is_work_stealing(type)){
+        return find_generic_job_at(s_current_worker, priority);
+    }
+
+    Job* job = pop_overdue_job(type, priority);
+    if(nullptr == job){
+        get_job_queue(type, priority).pop(&job);
+    }
+    return job;
+}
+
+static Job* pop_job(JobType type, JobPriority least_urgent = JOB_PRIORITY_BACKGROUND)
+{
+    for(unsigned int priority = 0; priority <= (unsigned int)least_urgent; ++priority){
+        Job* job = pop_job_at(type, priority);
+        if(nullptr != job){
+            return job;
+        }
+    }
+    return nullptr;
+}
+
+// Across <types>, a critical job of the last type beats a frame job of the first
+static Job* pop_most_urgent_job(const std::vector<JobType>& types)
+{
+    for(unsigned int priority = 0; priority < NUM_JOB_PRIORITIES; ++priority){
+        for(JobType type : types){
+            Job* job = pop_job_at(type, priority);
+            if(nullptr != job){
+                return job;
+            }
+        }
+    }
+    return nullptr;
+}
+
+// The oldest ready job of <type> at <priority> that finishing brings <counter> or
+// <job> closer. Only looks through the caller's own deque and the shared queue,
+// a job stolen off another worker would have nowhere to go back to.
+static Job* pop_waited_job_at(JobType type, unsigned int priority, job_counter_t* counter, Job* job)
+{
+    auto is_waited = [counter, job](Job* ready) -> bool{
+        return JobSystem::is_waited_work(ready, counter, job);
+    };
+
+    Job* waited = nullptr;
+    generic_worker_t* worker = s_current_worker;
+    if(is_work_stealing(type)){
+        if((nullptr != worker) && !worker->deques[priority].empty()){
+            // Newest first, whatever was in the way goes back in the same order
+            std::vector<Job*>& skipped = worker->skipped_jobs;
+            Job* ready = nullptr;
+            while((nullptr == waited) && (nullptr != (ready = worker->deques[priority].pop()))){
+                if(is_waited(ready)){
+                    waited = ready;
+                }else{
+                    skipped.push_back(ready);
+                }
+            }
+
+            while(!skipped.empty()){
+                worker->deques[priority].push(skipped.back());
+                skipped.pop_back();
+            }
+
+            if(nullptr != waited){
+                return waited;
+            }
+        }
+
+        if((atomic_load_acquire(&g_job_system->m_num_injected[priority]) > 0) && get_job_queue(JOB_TYPE_GENERIC, priority).pop_first(is_waited, &waited)){
+            atomic_decr(&g_job_system->m_num_injected[priority]);
+            return waited;
+        }
+        return nullptr;
+    }
+
+    get_job_queue(type, priority).pop_first(is_waited, &waited);
+    return waited;
+}
+
+static void wake_generic_workers()
+{
+    // Pairs with the fence a worker puts between saying it's asleep and its
+    // last look for a job, one of the two sees the other
+    atomic_fence();
+    if(atomic_load_acquire(&g_job_system->m_num_sleeping_workers) > 0){
+        g_job_system->m_signals[JOB_TYPE_GENERIC]->signal_all();
+    }
+}
+
+// nullptr when the fiber couldn't be made
+static job_fiber_t* create_job_fiber(generic_worker_t* worker)
+{
+    job_fiber_t* job_fiber = new job_fiber_t();
+    job_fiber->worker       = worker;
+    job_fiber->job          = nullptr;
+    job_fiber->wait_counter = nullptr;
+    job_fiber->wait_job     = nullptr;
+    job_fiber->fiber        = fiber_create(JobSystem::run_job_fiber, job_fiber);
+    if(nullptr == job_fiber->fiber){
+        delete job_fiber;
+        return nullptr;
+    }
+    return job_fiber;
+}
+
+static void start_worker_fibers(generic_worker_t* worker, unsigned int num_fibers)
+{
+    if(num_fibers == 0){
+        return;
+    }
+
+    worker->thread_fiber = fiber_convert_thread();
+    for(unsigned int i = 0; i < num_fibers; ++i){
+        job_fiber_t* job_fiber = create_job_fiber(worker);
+        if(nullptr == job_fiber){
+            log_warningf("Generic worker only got %u of %u fibers", i, num_fibers);
+            break;
+        }
+        worker->free_fibers.push_back(job_fiber);
+    }
+}
+
+// Everything's finished by now, so every fiber is back in the free list
+static void stop_worker_fibers(generic_worker_t* worker)
+{
+    for(job_fiber_t* job_fiber : worker->free_fibers){
+        fiber_destroy(job_fiber->fiber);
+        delete job_fiber;
+    }
+    worker->free_fibers.clear();
+
+    if(nullptr != worker->thread_fiber){
+        fiber_convert_back(worker->thread_fiber);
+        worker->thread_fiber = nullptr;
+    }
+}
+
+// Back here when the job finishes or parks
+static void switch_to_job_fiber(generic_worker_t* worker, job_fiber_t* job_fiber)
+{
+    Job* thread_job = s_current_job;
+    worker->current_fiber = job_fiber;
+    fiber_switch(worker->thread_fiber, job_fiber->fiber);
+    worker->current_fiber = nullptr;
+    s_current_job = thread_job;
+
+    if(nullptr == job_fiber->job){
+        worker->free_fibers.push_back(job_fiber);
+    }else{
+        worker->parked_fibers.push_back(job_fiber);
+        atomic_incr(&g_job_system->m_num_parked_fibers);
+    }
+}
+
+static bool is_fiber_wait_over(const job_fiber_t& job_fiber)
+{
+    if(nullptr != job_fiber.wait_counter){
+        return atomic_load_acquire(&job_fiber.wait_counter->num_left) == 0;
+    }
+    return *(volatile JobStage*)&job_fiber.wait_job->m_stage == JOB_STAGE_FINISHED;
+}
+
+static bool is_any_fiber_wait_over(const generic_worker_t& worker)
+{
+    for(const job_fiber_t* job_fiber : worker.parked_fibers){
+        if(is_fiber_wait_over(*job_fiber)){
+            return true;
+        }
+    }
+    return false;
+}
+
+// Once a job has finished, a worker may be asleep with a fiber parked on it or its counter
+static void wake_parked_fiber_workers()
+{
+    if(g_job_system->m_fibers_per_worker == 0){
+        return;
+    }
+
+    // Pairs with the fence a worker puts between saying it's asleep and its
+    // last look at its parked fibers, one of the two sees the other
+    atomic_fence();
+    if((atomic_load_acquire(&g_job_system->m_num_parked_fibers) > 0) && (atomic_load_acquire(&g_job_system->m_num_sleeping_workers) > 0)){
+        g_job_system->m_signals[JOB_TYPE_GENERIC]->signal_all();
+    }
+}
+
+// Picks up every parked fiber whose wait is over, true if there were any
+static bool resume_parked_fibers(generic_worker_t* worker)
+{
+    bool has_resumed = false;
+    std::vector<job_fiber_t*>& parked = worker->parked_fibers;
+    for(size_t i = 0; i < parked.size();){
+        job_fiber_t* job_fiber = parked[i];
+        if(!is_fiber_wait_over(*job_fiber)){
+            ++i;
+            continue;
+        }
+
+        parked[i] = parked.back();
+        parked.pop_back();
+        atomic_decr(&g_job_system->m_num_parked_fibers);
+        switch_to_job_fiber(worker, job_fiber);
+        has_resumed = true;
+    }
+    return has_resumed;
+}
+
+// Parks the job fiber the calling thread is on until <counter> drains or
+// <job> finishes. False, having done nothing, when it isn't on one.
+static bool park_job_fiber(job_counter_t* counter, Job* job)
+{
+    generic_worker_t* worker = s_current_worker;
+    if((nullptr == worker) || (nullptr == worker->current_fiber)){
+        return false;
+    }
+
+    job_fiber_t* job_fiber = worker->current_fiber;
+    Job* fiber_job = s_current_job;
+    job_fiber->wait_counter = counter;
+    job_fiber->wait_job     = job;
+    ++worker->num_parks;
+    fiber_switch(job_fiber->fiber, worker->thread_fiber);
+
+    s_current_job           = fiber_job;
+    job_fiber->wait_counter = nullptr;
+    job_fiber->wait_job     = nullptr;
+    return true;
+}
+
+void JobSystem::run_job_fiber(void* user_data)
+{
+    job_fiber_t* job_fiber = (job_fiber_t*)user_data;
+    for(;;){
+        job_fiber->job->run();
+        job_fiber->job = nullptr;
+        fiber_switch(job_fiber->fiber, job_fiber->worker->thread_fiber);
+    }
+}
+
+// On a fiber, a new one when they're all parked: a job on the thread's stack
+// can't park, and its waits can't run what the parked fibers wait on. Right
+// here on the thread's stack only without fibers, or when making one failed.
+void JobSystem::run_worker_job(generic_worker_t* worker, Job* job)
+{
+    job_fiber_t* job_fiber = nullptr;
+    if(!worker->free_fibers.empty()){
+        job_fiber = worker->free_fibers.back();
+        worker->free_fibers.pop_back();
+    }else if(nullptr != worker->thread_fiber){
+        job_fiber = create_job_fiber(worker);
+    }
+
+    if(nullptr == job_fiber){
+        job->run();
+    }else{
+        job_fiber->job = job;
+        switch_to_job_fiber(worker, job_fiber);
+    }
+    ++worker->num_jobs_run;
+}
+
+void JobSystem::run_generic_worker(generic_worker_t* worker)
+{
+    s_current_worker = worker;
+    start_worker_fibers(worker, m_fibers_per_worker);
+
+    while(m_is_running){
+        bool has_resumed = resume_parked_fibers(worker);
+        Job* job = find_generic_job(worker);
+        if(nullptr == job){
+            // What a resumed fiber finished may have woken another parked one
+            if(has_resumed){
+                continue;
+            }
+            job = sleep_generic_worker(worker);
+        }
+
+        if(nullptr != job){
+            run_worker_job(worker, job);
+        }
+    }
+
+    // Parked fibers included, whatever they wait on finishes on another thread
+    for(;;){
+        resume_parked_fibers(worker);
+        Job* job = find_generic_job(worker);
+        if(nullptr == job){
+            if(worker->parked_fibers.empty()){
+                break;
+            }
+            job = sleep_generic_worker(worker);
+        }
+
+        if(nullptr != job){
+            run_worker_job(worker, job);
+        }
+    }
+
+    stop_worker_fibers(worker);
+    s_current_worker = nullptr;
+}
+
+// Until a job is dispatched or finishes while fibers are parked. It says it's
+// asleep before a last look, so neither can slip in unseen. Returns the job
+// that last look found, if any.
+Job* JobSystem::sleep_generic_worker(generic_worker_t* worker)
+{
+    atomic_incr(&m_num_sleeping_workers);
+    atomic_fence();
+    Job* job = find_generic_job(worker);
+    bool has_work = (nullptr != job) || is_any_fiber_wait_over(*worker);
+    if(!has_work && (m_is_running || !worker->parked_fibers.empty())){
+        ++worker->num_sleeps;
+        m_signals[JOB_TYPE_GENERIC]->wait();
+    }
+    atomic_decr(&m_num_sleeping_workers);
+    return job;
+}
+
+// The most urgent job of <type> on the calling thread, false when none was ready
+bool JobSystem::run_ready_job(JobType type, JobPriority least_urgent)
+{
+    Job* job = pop_job(type, least_urgent);
+    if(nullptr == job){
+        return false;
+    }
+
+    job->run();
+    return true;
+}
+
+// Whether finishing <ready> brings <counter> or <job> closer, itself or through
+// the jobs that depend on it. Nothing else is safe for a waiter to run, the
+// job it's waiting in may be what that job waits on.
+bool JobSystem::is_waited_work(Job* ready, job_counter_t* counter, Job* job)
+{
+    if((ready == job) || ((nullptr != counter) && (ready->m_counter == counter))){
+        return true;
+    }
+
+    bool is_waited = false;
+    ready->lock_dependents();
+    for(size_t i = 0; !is_waited && (i < ready->m_dependents.size()); ++i){
+        is_waited = is_waited_work(ready->m_dependents[i], counter, job);
+    }
+    ready->unlock_dependents();
+    return is_waited;
+}
+
+// The most urgent ready job <counter> or <job> waits on, false when the calling thread couldn't get at one
+bool JobSystem::run_waited_job(JobType type, job_counter_t* counter, Job* job)
+{
+    for(unsigned int priority = 0; priority < NUM_JOB_PRIORITIES; ++priority){
+        Job* waited = pop_waited_job_at(type, priority, counter, job);
+        if(nullptr != waited){
+            waited->run();
+            return true;
+        }
+    }
+    return false;
+}
+
+// Runs the ready jobs of <type> <counter> waits on until it drains, yields when
+// there are none. A job on a fiber parks instead.
+static void help_until_counter_done(job_counter_t* counter, JobType type)
+{
+    if((atomic_load_acquire(&counter->num_left) > 0) && park_job_fiber(counter, nullptr)){
+        return;
+    }
+
+    while(atomic_load_acquire(&counter->num_left) > 0){
+        if(!g_job_system->run_waited_job(type, counter, nullptr)){
+            thread_yield();
+        }
+    }
+}
+
 static void generic_job_consumer_thread(int worker_id)
 {
     std::string thread_name = Stringf("Generic Job Worker #%i", worker_id);
     thread_set_name(thread_name.c_str()); 
 
+    if(g_job_system->m_scheduler == JOB_SCHEDULER_WORK_STEALING){
+        g_job_system->run_generic_worker(g_job_system->m_generic_workers[worker_id]);
+        return;
+    }
+
+    generic_worker_t* worker = g_job_system->m_generic_workers[worker_id];
     while(g_job_system->m_is_running){
         g_job_system->m_signals[JOB_TYPE_GENERIC]->wait();
-        g_job_system->m_generic_consumer.consume_all();
+        worker->num_jobs_run += g_job_system->m_generic_consumer.consume_all();
     }
 
-    g_job_system->m_generic_consumer.consume_all();
+    worker->num_jobs_run += g_job_system->m_generic_consumer.consume_all();
 }
 
 void JobSystem::init()
@@ -118,27 +719,138 @@ void JobSystem::shutdown()
         }
     }
 
+    if(nullptr != m_generic_workers){
+        for(unsigned int i = 0; i < m_num_generic_threads; ++i){
+            SAFE_DELETE(m_generic_workers[i]);
+        }
+    }
+    SAFE_DELETE(m_generic_workers);
     SAFE_DELETE(m_generic_threads);
     SAFE_DELETE(m_signals[JOB_TYPE_GENERIC]);
     SAFE_DELETE(m_signals);
 }
 
+static void run_parallel_for_items(void* user_data)
+{
+    parallel_for_t* parallel = (parallel_for_t*)user_data;
+    for(;;){
+        unsigned int item = atomic_incr(&parallel->next_item) - 1;
+        if(item >= parallel->num_items){
+            break;
+        }
+        parallel->item_cb(item, parallel->user_data);
+    }
+}
+
+static uint64_t get_range_num_items(const job_range_t& range)
+{
+    return (uint64_t)(range.end[0] - range.begin[0]) * (range.end[1] - range.begin[1]) * (range.end[2] - range.begin[2]);
+}
+
+// Picks the axis to cut, false when the range is small enough already
+static bool get_range_split_axis(const parallel_range_t& parallel, const job_range_t& range, unsigned int* out_axis)
+{
+    const unsigned int* grain = parallel.options.grain;
+    bool has_grain = (grain[0] | grain[1] | grain[2]) != 0;
+
+    float best_ratio = 1.0f;
+    for(unsigned int axis = 0; axis < 3; ++axis){
+        unsigned int extent = range.end[axis] - range.begin[axis];
+        if(has_grain){
+            // Most grains across first
+            float ratio = (grain[axis] > 0) ? ((float)extent / (float)grain[axis]) : 0.0f;
+            if(ratio > best_ratio){
+                best_ratio = ratio;
+                *out_axis = axis;
+            }
+        }else if((extent > 1) && ((float)extent > best_ratio)){
+            best_ratio = (float)extent;
+            *out_axis = axis;
+        }
+    }
+
+    if(has_grain){
+        return best_ratio > 1.0f;
+    }
+    return (best_ratio > 1.0f) && (get_range_num_items(range) > parallel.target_items);
+}
+
+static void run_parallel_range(parallel_range_t* parallel, job_range_t range)
+{
+    unsigned int axis = 0;
+    while(get_range_split_axis(*parallel, range, &axis)){
+        unsigned int grain = Max(1u, parallel->options.grain[axis]);
+        unsigned int num_grains = (range.end[axis] - range.begin[axis] + grain - 1) / grain;
+
+        job_range_t upper = range;
+        upper.begin[axis] = range.begin[axis] + ((num_grains / 2) * grain);
+        range.end[axis] = upper.begin[axis];
+
+        // Over the job limit, both halves stay on this thread
+        if(atomic_incr(&parallel->jobs_out.num_left) > parallel->max_jobs){
+            atomic_decr(&parallel->jobs_out.num_left);
+            run_parallel_range(parallel, upper);
+            continue;
+        }
+
+        // Already counted, tagged so whoever waits on the range knows the piece is theirs to help with
+        Job* piece = job_create(parallel->options.type, run_parallel_range, parallel, upper);
+        piece->m_counter = &parallel->jobs_out;
+        job_dispatch_and_release(piece);
+    }
+
+    atomic_incr(&parallel->num_pieces);
+    if(nullptr != parallel->options.profile_tag){
+        PROFILE_SCOPE(parallel->options.profile_tag);
+        parallel->range_cb(range, parallel->user_data);
+    }else{
+        parallel->range_cb(range, parallel->user_data);
+    }
+}
+
 //-----------------------------------------------------
 // Job
 Job::Job(JobType type, job_work_cb work_cb, void* user_data)
     :m_type(type)
     ,m_work_cb(work_cb)
     ,m_user_data(user_data)
+    ,m_dependents_lock(0)
     ,m_num_dependencies(1)
     ,m_stage(JOB_STAGE_CREATED)
     ,m_ref_count(1)
+    ,m_counter(nullptr)
+    ,m_priority(job_get_current_priority())
+    ,m_deadline_seconds(0.0)
+{
+}
+
+void Job::lock_dependents()
+{
+    while(compare_and_set(&m_dependents_lock, 0, 1) != 0){
+        thread_yield();
+    }
+}
+
+void Job::unlock_dependents()
 {
+    atomic_store_release(&m_dependents_lock, 0);
 }
 
 void Job::on_finish()
 {
-    for(Job* dependent : m_dependents){
+    // Anyone calling depends_on from here on sees the job finished and doesn't add itself
+    std::vector<Job*> dependents;
+    lock_dependents();
+    m_stage = JOB_STAGE_FINISHED;
+    dependents.swap(m_dependents);
+    unlock_dependents();
+
+    for(Job* dependent : dependents){
         dependent->on_dependency_finished();
+    }
+
+    // Each dependent held a reference, run() still holds one so this can't be the last
+    for(size_t i = 0; i < dependents.size(); ++i){
         job_release(this);
     }
 }
@@ -150,18 +862,41 @@ void Job::on_dependency_finished()
 
 void Job::depends_on(Job* dependency)
 {
-    atomic_incr(&m_num_dependencies);
-    atomic_incr(&dependency->m_ref_count);
-    dependency->m_dependents.push_back(this);
+    dependency->lock_dependents();
+    if(dependency->m_stage != JOB_STAGE_FINISHED){
+        atomic_incr(&m_num_dependencies);
+        atomic_incr(&dependency->m_ref_count);
+        dependency->m_dependents.push_back(this);
+    }
+    dependency->unlock_dependents();
 }
 
 void Job::run()
 {
+    Job* outer_job = s_current_job;
+    s_current_job = this;
     m_stage = JOB_STAGE_RUNNING;
+    if(m_deadline_seconds > 0.0){
+        atomic_decr(&g_job_system->m_num_deadlines_out[m_type][m_priority]);
+    }
     m_work_cb(m_user_data);
+    s_current_job = outer_job;
 
-    m_stage = JOB_STAGE_FINISHED;
+    if(m_deadline_seconds > 0.0){
+        job_deadline_stats_t& stats = g_job_system->m_deadline_stats[m_priority];
+        atomic_incr(&stats.num_deadlines);
+        if(get_current_time_seconds() > m_deadline_seconds){
+            atomic_incr(&stats.num_missed);
+        }
+    }
+
+    // The counter can be gone as soon as it reaches 0, so read it first
+    job_counter_t* counter = m_counter;
     on_finish();
+    if(nullptr != counter){
+        atomic_decr_release(&counter->num_left);
+    }
+    wake_parked_fiber_workers();
 
     job_release(this);
 }
@@ -175,16 +910,13 @@ void JobConsumer::add_type(JobType type)
 
 void JobConsumer::consume_job()
 {
-    Job* job = nullptr;
-    for(JobType type : types){
-        ThreadSafeQueue<Job*>& queue = g_job_system->m_queues[type];
-        if(queue.pop(&job)){
-            job->run();
-            return;
-        }
+    Job* job = pop_most_urgent_job(types);
+    if(nullptr != job){
+        job->run();
     }
 }
 
+// Picks again after every job, so urgent work dispatched meanwhile goes next
 unsigned int JobConsumer::consume_for_ms(unsigned int ms)
 {
     double start = get_current_time_seconds();
@@ -192,17 +924,14 @@ unsigned int JobConsumer::consume_for_ms(unsigned int ms)
     unsigned int num_processed_jobs = 0;
     Job* job = nullptr;
 
-    for(JobType type : types){
-        ThreadSafeQueue<Job*>& queue = g_job_system->m_queues[type];
-        while(queue.pop(&job)){
-            job->run();
-            ++num_processed_jobs;
+    while(nullptr != (job = pop_most_urgent_job(types))){
+        job->run();
+        ++num_processed_jobs;
 
-            double elapsed_seconds = get_current_time_seconds() - start;
-            unsigned int elapsed_ms = (unsigned int)(elapsed_seconds * 1000.0f);
-            if(elapsed_ms >= ms){
-                return num_processed_jobs;
-            }
+        double elapsed_seconds = get_current_time_seconds() - start;
+        unsigned int elapsed_ms = (unsigned int)(elapsed_seconds * 1000.0f);
+        if(elapsed_ms >= ms){
+            return num_processed_jobs;
         }
     }
 
@@ -217,12 +946,12 @@ unsigned int JobConsumer::consume_all()
 //-----------------------------------------------------
 // Public API
 
-void job_system_init(int num_generic_threads_requested)
+void job_system_init(int num_generic_threads_requested, JobScheduler scheduler, unsigned int fibers_per_worker)
 {
     s_job_allocator = new ThreadSafeBlockAllocator(sizeof(Job));
 
     unsigned int num_generic_threads_to_create = calculate_num_generic_threads_to_create(num_generic_threads_requested);
-    g_job_system = new JobSystem(num_generic_threads_to_create);
+    g_job_system = new JobSystem(num_generic_threads_to_create, scheduler, fibers_per_worker);
     g_job_system->init();
 
     s_main_thread_consumer.add_type(JOB_TYPE_MAIN);
@@ -233,6 +962,9 @@ void job_system_shutdown()
 {
     SAFE_DELETE(g_job_system);
     SAFE_DELETE(s_job_allocator);
+
+    // So another init doesn't add them twice
+    s_main_thread_consumer.types.clear();
 }
 
 void job_system_set_type_signal(JobType type, Signal* signal)
@@ -252,6 +984,58 @@ void job_system_main_step_for_ms(unsigned int ms)
     s_main_thread_consumer.consume_for_ms(ms);
 }
 
+JobScheduler job_system_get_scheduler()
+{
+    return (nullptr != g_job_system) ? g_job_system->m_scheduler : JOB_SCHEDULER_WORK_STEALING;
+}
+
+unsigned int job_system_get_fibers_per_worker()
+{
+    return (nullptr != g_job_system) ? g_job_system->m_fibers_per_worker : 0;
+}
+
+void job_system_get_stats(job_system_stats_t* out_stats)
+{
+    memset(out_stats, 0, sizeof(*out_stats));
+    if(nullptr == g_job_system){
+        return;
+    }
+
+    for(unsigned int i = 0; i < g_job_system->m_num_generic_threads; ++i){
+        const generic_worker_t* worker = g_job_system->m_generic_workers[i];
+        out_stats->num_jobs_run += worker->num_jobs_run;
+        out_stats->num_steals   += worker->num_steals;
+        out_stats->num_sleeps   += worker->num_sleeps;
+        out_stats->num_parks    += worker->num_parks;
+    }
+
+    for(unsigned int i = 0; i < NUM_JOB_PRIORITIES; ++i){
+        out_stats->deadlines[i].num_deadlines   = atomic_load_acquire(&g_job_system->m_deadline_stats[i].num_deadlines);
+        out_stats->deadlines[i].num_missed      = atomic_load_acquire(&g_job_system->m_deadline_stats[i].num_missed);
+    }
+}
+
+const char* job_get_scheduler_name(JobScheduler scheduler)
+{
+    return (scheduler < NUM_JOB_SCHEDULERS) ? s_job_scheduler_names[scheduler] : "unknown";
+}
+
+bool job_get_scheduler_from_name(JobScheduler* out_scheduler, const char* name)
+{
+    for(unsigned int i = 0; i < NUM_JOB_SCHEDULERS; ++i){
+        if(strcmp(s_job_scheduler_names[i], name) == 0){
+            *out_scheduler = (JobScheduler)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char* job_get_priority_name(JobPriority priority)
+{
+    return (priority < NUM_JOB_PRIORITIES) ? s_job_priority_names[priority] : "unknown";
+}
+
 Job* job_create(JobType type, job_work_cb work_cb, void* user_data)
 {
     return s_job_allocator->create<Job>(type, work_cb, user_data);
@@ -268,7 +1052,26 @@ void job_dispatch(Job* job)
     }
 
     job->m_stage = JOB_STAGE_ENQUEUED;
-    g_job_system->m_queues[job->m_type].push(job);
+
+    // Only the shared queues are looked through for overdue jobs
+    bool has_deadline = (job->m_deadline_seconds > 0.0);
+    if(has_deadline){
+        atomic_incr(&g_job_system->m_num_deadlines_out[job->m_type][job->m_priority]);
+    }
+
+    if(is_work_stealing(job->m_type)){
+        generic_worker_t* worker = s_current_worker;
+        if((nullptr != worker) && !has_deadline){
+            worker->deques[job->m_priority].push(job);
+        }else{
+            get_job_queue(JOB_TYPE_GENERIC, job->m_priority).push(job);
+            atomic_incr(&g_job_system->m_num_injected[job->m_priority]);
+        }
+        wake_generic_workers();
+        return;
+    }
+
+    get_job_queue(job->m_type, job->m_priority).push(job);
 
     Signal* signal = g_job_system->m_signals[job->m_type];
     if(nullptr != signal){
@@ -298,13 +1101,150 @@ void job_run(JobType type, job_work_cb work_cb, void* user_data)
 
 void job_wait(Job* job)
 {
+    if((job->m_stage != JOB_STAGE_FINISHED) && park_job_fiber(nullptr, job)){
+        return;
+    }
+
     while(job->m_stage != JOB_STAGE_FINISHED){
-        thread_yield();
+        if(!g_job_system->run_waited_job(JOB_TYPE_GENERIC, nullptr, job)){
+            thread_yield();
+        }
+    }
+}
+
+bool job_is_finished(Job* job)
+{
+    return job->m_stage == JOB_STAGE_FINISHED;
+}
+
+void job_set_priority(Job* job, JobPriority priority)
+{
+    job->m_priority = priority;
+}
+
+void job_set_deadline(Job* job, double deadline_seconds)
+{
+    job->m_deadline_seconds = deadline_seconds;
+}
+
+JobPriority job_get_current_priority()
+{
+    return (nullptr != s_current_job) ? s_current_job->m_priority : JOB_PRIORITY_FRAME;
+}
+
+unsigned int job_yield()
+{
+    Job* current_job = s_current_job;
+    if((nullptr == current_job) || (current_job->m_priority == JOB_PRIORITY_CRITICAL)){
+        return 0;
+    }
+
+    JobPriority least_urgent = (JobPriority)(current_job->m_priority - 1);
+    unsigned int num_run = 0;
+    while(g_job_system->run_ready_job(current_job->m_type, least_urgent)){
+        ++num_run;
     }
+    return num_run;
 }
 
 void job_wait_and_release(Job* job)
 {
     job_wait(job);
     job_release(job);
+}
+
+void job_dispatch_with_counter(Job* job, job_counter_t* counter)
+{
+    atomic_incr(&counter->num_left);
+    job->m_counter = counter;
+    job_dispatch(job);
+}
+
+void job_run_with_counter(JobType type, job_work_cb work_cb, void* user_data, job_counter_t* counter)
+{
+    Job* job = job_create(type, work_cb, user_data);
+    job_dispatch_with_counter(job, counter);
+    job_release(job);
+}
+
+bool job_counter_is_done(job_counter_t* counter)
+{
+    return atomic_load_acquire(&counter->num_left) == 0;
+}
+
+void job_counter_wait(job_counter_t* counter)
+{
+    help_until_counter_done(counter, JOB_TYPE_GENERIC);
+}
+
+unsigned int job_get_max_workers()
+{
+    // The caller works too, but it's one of the cores the generic threads were sized to
+    return (nullptr != g_job_system) ? g_job_system->m_num_generic_threads : 1;
+}
+
+unsigned int job_parallel_for(unsigned int num_items, job_item_cb item_cb, void* user_data, unsigned int max_workers)
+{
+    parallel_for_t parallel;
+    parallel.item_cb    = item_cb;
+    parallel.user_data  = user_data;
+    parallel.num_items  = num_items;
+    parallel.next_item  = 0;
+
+    unsigned int num_workers = (max_workers > 0) ? max_workers : job_get_max_workers();
+    num_workers = (num_workers < num_items) ? num_workers : num_items;
+    if(num_workers == 0){
+        return 0;
+    }
+
+    // The calling thread is one of the workers, it'd only be waiting otherwise
+    job_counter_t counter;
+    for(unsigned int i = 1; i < num_workers; ++i){
+        job_run_with_counter(JOB_TYPE_GENERIC, run_parallel_for_items, &parallel, &counter);
+    }
+
+    run_parallel_for_items(&parallel);
+    job_counter_wait(&counter);
+    return num_workers;
+}
+
+unsigned int job_parallel_for_range(unsigned int num_items, job_range_cb range_cb, void* user_data, const job_range_options_t& options)
+{
+    return job_parallel_for_3d(num_items, 1, 1, range_cb, user_data, options);
+}
+
+unsigned int job_parallel_for_2d(unsigned int width, unsigned int height, job_range_cb range_cb, void* user_data, const job_range_options_t& options)
+{
+    return job_parallel_for_3d(width, height, 1, range_cb, user_data, options);
+}
+
+unsigned int job_parallel_for_3d(unsigned int width, unsigned int height, unsigned int depth, job_range_cb range_cb, void* user_data, const job_range_options_t& options)
+{
+    job_range_t range;
+    range.begin[0]  = range.begin[1] = range.begin[2] = 0;
+    range.end[0]    = width;
+    range.end[1]    = height;
+    range.end[2]    = depth;
+
+    uint64_t num_items = get_range_num_items(range);
+    if(num_items == 0){
+        return 0;
+    }
+
+    unsigned int num_workers = (options.max_workers > 0) ? options.max_workers : job_get_max_workers();
+    uint64_t target_items = (num_items + (num_workers * 8) - 1) / (num_workers * 8);
+
+    parallel_range_t parallel;
+    parallel.range_cb       = range_cb;
+    parallel.user_data      = user_data;
+    parallel.options        = options;
+    parallel.target_items   = (unsigned int)Min(target_items, (uint64_t)UINT_MAX);
+    parallel.max_jobs       = num_workers - 1;
+    parallel.num_pieces     = 0;
+
+    run_parallel_range(&parallel, range);
+
+    // Helps with the pieces split off above while it waits
+    help_until_counter_done(&parallel.jobs_out, options.type);
+    return parallel.num_pieces;
 }
\ No newline at end of file
@@ -28,30 +28,66 @@ enum JobStage : unsigned int
     JOB_STAGE_FINISHED
 };
 
+// Most urgent first
+enum JobPriority : unsigned int
+{
+    JOB_PRIORITY_CRITICAL,      // something is blocked on it right now
+    JOB_PRIORITY_FRAME,         // this frame's work, the default
+    JOB_PRIORITY_BACKGROUND,    // bakes and loads that can slip a frame
+    NUM_JOB_PRIORITIES
+};
+
 typedef void(*job_work_cb)(void*);
 
+struct job_counter_t;
+
 class Job
 {
 friend class JobConsumer;
+friend class JobSystem;
 
 public:
     JobType             m_type;
     job_work_cb         m_work_cb;
     void*               m_user_data;
     std::vector<Job*>   m_dependents;
+    unsigned int        m_dependents_lock;      // spin lock, against depends_on racing on_finish
     unsigned int        m_num_dependencies;
     JobStage            m_stage;
     unsigned int        m_ref_count;
+    job_counter_t*      m_counter;              // taken down by one when the job finishes
+    JobPriority         m_priority;
+    double              m_deadline_seconds;     // get_current_time_seconds() it should be done by, 0 for none
 
 public:
     Job(JobType type, job_work_cb work_cb, void* user_data);
 
     void on_finish();
     void on_dependency_finished();
+
+    // Nothing to wait for once <dependency> has finished
     void depends_on(Job* dependency);
 
 private:
     void run();
+    void lock_dependents();
+    void unlock_dependents();
+};
+
+//-----------------------------------------------------
+// Job counter
+//
+// Fan-in without a Job to wait on per job: every job dispatched with a
+// counter adds one to it and takes it off again when it finishes, so
+// waiting on the counter waits on all of them. Nothing is allocated per
+// job. A counter that's done can be used again.
+struct job_counter_t
+{
+    unsigned int    num_left;
+
+    job_counter_t()
+        :num_left(0)
+    {}
 };
 
 //-----------------------------------------------------
@@ -70,20 +106,162 @@ public:
 
 //-----------------------------------------------------
 // Job System
-void            job_system_init(int num_generic_threads_requested = -1);
+//
+// GENERIC jobs go to the worker threads. Under JOB_SCHEDULER_WORK_STEALING
+// every worker has its own deque: what a worker dispatches goes on its own
+// deque and it works newest first, an idle worker steals the oldest job off
+// another's. Dispatches from other threads go on a shared queue the workers
+// check after their own deque. Workers are only woken when one is asleep.
+// JOB_SCHEDULER_SHARED_QUEUE is the one locked queue every worker pulls
+// from, kept to compare against. The other types always use a shared queue.
+//
+// Each priority has its own queues and deques. Workers and consumers take
+// the most urgent ready job, waiting threads the most urgent one they wait
+// on. A job created while another runs gets that job's priority, so
+// whatever a background bake forks stays background. Nothing preempts a
+// running job, long background jobs call job_yield between pieces instead.
+// A job still queued once its deadline has passed goes up one priority,
+// ahead of the jobs already there. Jobs with a deadline always go on the
+// shared queue so the late ones can be found. Every deadline counts toward
+// the stats of the priority the job was dispatched at.
+//
+// With <fibers_per_worker> set, work stealing workers run each job on a
+// fiber from their own pool. A job that waits in job_wait, job_counter_wait
+// or a parallel for parks its fiber instead of blocking the thread, and the
+// worker carries on with other jobs. It resumes the fiber, on the same
+// thread, once what it waited on is done, and sleeps until then when it has
+// nothing else to run. <fibers_per_worker> is what each pool starts with, a
+// worker whose fibers are all parked makes another rather than run a job on
+// its own stack where it couldn't park. Fiber stacks are
+// FIBER_DEFAULT_STACK_SIZE.
+enum JobScheduler : unsigned int
+{
+    JOB_SCHEDULER_WORK_STEALING,
+    JOB_SCHEDULER_SHARED_QUEUE,
+    NUM_JOB_SCHEDULERS
+};
+
+struct job_deadline_stats_t
+{
+    unsigned int    num_deadlines;      // jobs that had one, whoever ran them
+    unsigned int    num_missed;
+};
+
+struct job_system_stats_t
+{
+    unsigned int            num_jobs_run;       // GENERIC jobs the workers ran
+    unsigned int            num_steals;
+    unsigned int            num_sleeps;
+    unsigned int            num_parks;          // waits that parked a fiber
+    job_deadline_stats_t    deadlines[NUM_JOB_PRIORITIES];
+};
+
+void            job_system_init(int num_generic_threads_requested = -1, JobScheduler scheduler = JOB_SCHEDULER_WORK_STEALING, unsigned int fibers_per_worker = 0);
 void            job_system_shutdown();
 void            job_system_set_type_signal(JobType type, Signal* signal);
 void            job_system_main_step();
 void            job_system_main_step_for_ms(unsigned int ms);
+JobScheduler    job_system_get_scheduler();
+unsigned int    job_system_get_fibers_per_worker();
+
+// Counted by the workers as they go, only settled once they're idle
+void            job_system_get_stats(job_system_stats_t* out_stats);
+
+const char*     job_get_scheduler_name(JobScheduler scheduler);
+bool            job_get_scheduler_from_name(JobScheduler* out_scheduler, const char* name);
+const char*     job_get_priority_name(JobPriority priority);
 
 Job*            job_create(JobType type, job_work_cb work_cb, void* user_data);
 void            job_dispatch(Job* job);
 void            job_release(Job* job);
 void            job_dispatch_and_release(Job* job);
 void            job_run(JobType type, job_work_cb work_cb, void* user_data);
+bool            job_is_finished(Job* job);
+
+// Both before the job is dispatched
+void            job_set_priority(Job* job, JobPriority priority);
+void            job_set_deadline(Job* job, double deadline_seconds);
+
+// Of the job the calling thread is running, JOB_PRIORITY_FRAME outside of one
+JobPriority     job_get_current_priority();
+
+// A safe point for the running job: runs ready jobs of its type that are
+// more urgent than it first. Returns how many ran. Those jobs run on top of
+// it, so none of them may wait on it.
+unsigned int    job_yield();
+
+// Waiting threads help rather than spin, but only with the ready GENERIC jobs
+// that make up what they wait on: the job or the counter's jobs and whatever
+// those depend on, from their own deque or the shared queue. Any other job
+// could end up waiting on the job the thread is waiting in, so with none of
+// those in reach it yields.
 void            job_wait(Job* job);
 void            job_wait_and_release(Job* job);
 
+// Dispatches <job> counted against <counter>
+void            job_dispatch_with_counter(Job* job, job_counter_t* counter);
+void            job_run_with_counter(JobType type, job_work_cb work_cb, void* user_data, job_counter_t* counter);
+bool            job_counter_is_done(job_counter_t* counter);
+void            job_counter_wait(job_counter_t* counter);
+
+//-----------------------------------------------------
+// Parallel for
+//
+// The calling thread plus up to (max_workers - 1) GENERIC jobs pull items off
+// a shared counter until none are left, so uneven items don't leave workers
+// idle. Blocks until every item is done.
+typedef void(*job_item_cb)(unsigned int item, void* user_data);
+
+// How many threads a parallel for can spread over, the caller included
+unsigned int    job_get_max_workers();
+
+// <max_workers> 0 uses job_get_max_workers(). Returns how many threads took part.
+unsigned int    job_parallel_for(unsigned int num_items, job_item_cb item_cb, void* user_data, unsigned int max_workers = 0);
+
+//-----------------------------------------------------
+// Parallel ranges
+//
+// Splits a 1, 2 or 3D range in halves until the pieces are down to the
+// grain. Each split hands the upper half to a job of <type> and carries on
+// with the lower, so under work stealing the worker that split a range
+// works through its own pieces and idle workers steal the biggest ones
+// left. The calling thread does the first piece and then helps with the
+// others until every piece is done.
+//
+// grain[axis] is the most items a piece spans on that axis, 0 doesn't limit
+// it. All 0 splits along the longest axis until pieces hold about an eighth
+// of a worker's share. Splits land on multiples of the grain from the start,
+// so pieces line up with bricks or cache lines when the grain does. When
+// max_workers jobs are already out, whoever splits does both halves itself.
+struct job_range_t
+{
+    unsigned int    begin[3];
+    unsigned int    end[3];
+};
+
+typedef void(*job_range_cb)(const job_range_t& range, void* user_data);
+
+struct job_range_options_t
+{
+    JobType         type;
+    unsigned int    grain[3];
+    unsigned int    max_workers;        // the caller included, 0 uses job_get_max_workers()
+    const char*     profile_tag;        // profiler scope around every piece, nullptr for none
+
+    job_range_options_t()
+        :type(JOB_TYPE_GENERIC)
+        ,max_workers(0)
+        ,profile_tag(nullptr)
+    {
+        grain[0] = grain[1] = grain[2] = 0;
+    }
+};
+
+// Return how many pieces the range was cut into, on however many threads
+unsigned int    job_parallel_for_range(unsigned int num_items, job_range_cb range_cb, void* user_data, const job_range_options_t& options = job_range_options_t());
+unsigned int    job_parallel_for_2d(unsigned int width, unsigned int height, job_range_cb range_cb, void* user_data, const job_range_options_t& options = job_range_options_t());
+unsigned int    job_parallel_for_3d(unsigned int width, unsigned int height, unsigned int depth, job_range_cb range_cb, void* user_data, const job_range_options_t& options = job_range_options_t());
+
 //-----------------------------------------------------
 // Friendly parameter passing
 template<typename WORK_CB, typename ...ARGS>
@@ -0,0 +1,156 @@
+//------------------------------------------------------------
+// Headless stand in for log.cpp, for the tools that build without the
+// renderer or a logging thread. Same API and tag filtering, but every message
+// goes straight out through the console (stdout when there's no display) and
+// nothing is written to disk. Link one or the other, never both.
+
+#include "Engine/Core/log.h"
+#include "Engine/Core/Common.hpp"
+#include "Engine/Core/ErrorWarningAssert.hpp"
+#include "Engine/Core/console_command.h"
+#include "Engine/Core/crt_compat.h"
+#include "Engine/Thread/critical_section.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <map>
+#include <set>
+#include <string>
+
+static CriticalSection                  s_lock;
+static std::map<std::string, Rgba>      s_tag_colors;
+static bool                             s_is_whitelist_mode     = false;
+static std::set<std::string>            s_tags;
+
+#define DEFAULT_TAG     "default"
+#define ERROR_TAG       "error"
+#define WARNING_TAG     "warning"
+
+//------------------------------------------------------------
+// Internal
+static bool filter_message(const char* tag)
+{
+    bool is_tag_present = (s_tags.find(tag) != s_tags.end());
+    return s_is_whitelist_mode ? !is_tag_present : is_tag_present;
+}
+
+static void log_tagged_printf_valist(const char* tag, const char* format, va_list arg_list)
+{
+    char message_text[MAX_MESSAGE_SIZE];
+    vsnprintf_s(message_text, MAX_MESSAGE_SIZE, _TRUNCATE, format, arg_list);
+    message_text[MAX_MESSAGE_SIZE - 1] = '\0';
+
+    SCOPE_LOCK(&s_lock);
+    if(filter_message(tag)){
+        return;
+    }
+
+    std::map<std::string, Rgba>::iterator found = s_tag_colors.find(tag);
+    Rgba tag_color = (found != s_tag_colors.end()) ? found->second : Rgba::WHITE;
+    console_printf(tag_color, "[%s] %s", tag, message_text);
+}
+
+//------------------------------------------------------------
+// External
+void log_init(const char* log_directory)
+{
+    UNUSED(log_directory);
+    log_set_console_tag_color(ERROR_TAG, Rgba::RED);
+    log_set_console_tag_color(WARNING_TAG, Rgba::YELLOW);
+}
+
+void log_shutdown()
+{
+    fflush(stdout);
+}
+
+void log_flush()
+{
+    fflush(stdout);
+}
+
+void log_printf(const char* format, ...)
+{
+    va_list arg_list;
+    va_start(arg_list, format);
+    log_tagged_printf_valist(DEFAULT_TAG, format, arg_list);
+    va_end(arg_list);
+}
+
+void log_tagged_printf(const char* tag, const char* format, ...)
+{
+    va_list arg_list;
+    va_start(arg_list, format);
+    log_tagged_printf_valist(tag, format, arg_list);
+    va_end(arg_list);
+}
+
+void log_warningf(const char* format, ...)
+{
+    va_list arg_list;
+    va_start(arg_list, format);
+    log_tagged_printf_valist(WARNING_TAG, format, arg_list);
+    va_end(arg_list);
+}
+
+void log_errorf(const char* format, ...)
+{
+    va_list arg_list;
+    va_start(arg_list, format);
+    log_tagged_printf_valist(ERROR_TAG, format, arg_list);
+    va_end(arg_list);
+
+    log_flush();
+    DIE("Fatal Error Encountered");
+}
+
+// No callstack capture off Windows, these log the message alone
+void log_printf_with_callstack(const char* format, ...)
+{
+    va_list arg_list;
+    va_start(arg_list, format);
+    log_tagged_printf_valist(DEFAULT_TAG, format, arg_list);
+    va_end(arg_list);
+}
+
+void log_tagged_printf_with_callstack(const char* tag, const char* format, ...)
+{
+    va_list arg_list;
+    va_start(arg_list, format);
+    log_tagged_printf_valist(tag, format, arg_list);
+    va_end(arg_list);
+}
+
+void log_disable_tag(const char* tag)
+{
+    SCOPE_LOCK(&s_lock);
+    s_is_whitelist_mode = false;
+    s_tags.insert(tag);
+}
+
+void log_enable_tag(const char* tag)
+{
+    SCOPE_LOCK(&s_lock);
+    s_is_whitelist_mode = true;
+    s_tags.insert(tag);
+}
+
+void log_disable_all_tags()
+{
+    SCOPE_LOCK(&s_lock);
+    s_tags.clear();
+    s_is_whitelist_mode = true;
+}
+
+void log_enable_all_tags()
+{
+    SCOPE_LOCK(&s_lock);
+    s_tags.clear();
+    s_is_whitelist_mode = false;
+}
+
+void log_set_console_tag_color(const char* tag, const Rgba& color)
+{
+    SCOPE_LOCK(&s_lock);
+    s_tag_colors[tag] = color;
+}
@@ -237,9 +237,9 @@ Matrix4 Matrix4::get_inverse() const
 
 void Matrix4::orthonormalize()
 {
-	Vector3 i_basis = get_i_basis().xyz;
-	Vector3 j_basis = get_j_basis().xyz;
-	Vector3 k_basis = get_k_basis().xyz;
+	Vector3 i_basis = get_i_basis().GetXYZ();
+	Vector3 j_basis = get_j_basis().GetXYZ();
+	Vector3 k_basis = get_k_basis().GetXYZ();
 
 	Vector3 new_i_basis = i_basis;
 	Vector3 new_j_basis = j_basis - (DotProduct(j_basis, i_basis) * i_basis);
@@ -265,6 +265,12 @@ Vector4 Matrix4::get_translation() const
 	return Vector4(data[3], data[7], data[11], data[15]);
 }
 
+Vector4 Matrix4::get_row(unsigned int row_index) const
+{
+	const float* row = &data[row_index * 4];
+	return Vector4(row[0], row[1], row[2], row[3]);
+}
+
 void Matrix4::set_i_basis(const Vector3& i_basis, float homogenous_coordinate)
 {
 	data[0] = i_basis.x;
@@ -332,25 +338,25 @@ void Matrix4::set_translation(const Vector4& translation)
 Vector3 Matrix4::apply_rotation(const Vector3& vec3) const
 {
 	Vector3 rotated_vec3;
-	rotated_vec3.x = DotProduct(vec3, first_row.xyz);
-	rotated_vec3.y = DotProduct(vec3, second_row.xyz);
-	rotated_vec3.z = DotProduct(vec3, third_row.xyz);
+	rotated_vec3.x = DotProduct(vec3, get_row(0).GetXYZ());
+	rotated_vec3.y = DotProduct(vec3, get_row(1).GetXYZ());
+	rotated_vec3.z = DotProduct(vec3, get_row(2).GetXYZ());
 	return rotated_vec3;
 }
 
 Vector4 Matrix4::apply_rotation(const Vector4& vec4) const
 {
 	Vector3 rotated_vec3;
-	rotated_vec3.x = DotProduct(vec4.xyz, first_row.xyz);
-	rotated_vec3.y = DotProduct(vec4.xyz, second_row.xyz);
-	rotated_vec3.z = DotProduct(vec4.xyz, third_row.xyz);
+	rotated_vec3.x = DotProduct(vec4.GetXYZ(), get_row(0).GetXYZ());
+	rotated_vec3.y = DotProduct(vec4.GetXYZ(), get_row(1).GetXYZ());
+	rotated_vec3.z = DotProduct(vec4.GetXYZ(), get_row(2).GetXYZ());
 	return Vector4(rotated_vec3, vec4.w);
 }
 
 Vector3 Matrix4::apply_translation(const Vector3& vec3) const
 {
 	Vector4 translation = get_translation();
-	return vec3 + translation.xyz;
+	return vec3 + translation.GetXYZ();
 }
 
 Vector4 Matrix4::apply_translation(const Vector4& vec4) const
@@ -362,7 +368,7 @@ Vector4 Matrix4::apply_translation(const Vector4& vec4) const
 Vector3 Matrix4::apply_transformation(const Vector3& vec3) const
 {
 	Vector4 transformed_vec = Vector4(vec3, 1.0f) * (*this);
-	return transformed_vec.xyz;
+	return transformed_vec.GetXYZ();
 }
 
 Vector4 Matrix4::apply_transformation(const Vector4& vec4) const
@@ -690,10 +696,10 @@ Vector4 operator*(const Vector4& vec4, const Matrix4& transform)
 
 void operator*=(Vector4& vec4, const Matrix4& transform)
 {
-	float new_x = DotProduct(vec4, transform.first_row);
-	float new_y = DotProduct(vec4, transform.second_row);
-	float new_z = DotProduct(vec4, transform.third_row);
-	float new_w = DotProduct(vec4, transform.fourth_row);
+	float new_x = DotProduct(vec4, transform.get_row(0));
+	float new_y = DotProduct(vec4, transform.get_row(1));
+	float new_z = DotProduct(vec4, transform.get_row(2));
+	float new_w = DotProduct(vec4, transform.get_row(3));
 	
 	vec4.x = new_x;
 	vec4.y = new_y;
@@ -704,16 +710,16 @@ void operator*=(Vector4& vec4, const Matrix4& transform)
 Matrix4 nlerp(const Matrix4& a, const Matrix4& b, float t)
 {
 	//slerp the i,j,k basis vectors
-	Vector3 a_i_basis = a.get_i_basis().xyz;
-	Vector3 a_j_basis = a.get_j_basis().xyz;
-	Vector3 a_k_basis = a.get_k_basis().xyz;
+	Vector3 a_i_basis = a.get_i_basis().GetXYZ();
+	Vector3 a_j_basis = a.get_j_basis().GetXYZ();
+	Vector3 a_k_basis = a.get_k_basis().GetXYZ();
 
-	Vector3 b_i_basis = b.get_i_basis().xyz;
-	Vector3 b_j_basis = b.get_j_basis().xyz;
-	Vector3 b_k_basis = b.get_k_basis().xyz;
+	Vector3 b_i_basis = b.get_i_basis().GetXYZ();
+	Vector3 b_j_basis = b.get_j_basis().GetXYZ();
+	Vector3 b_k_basis = b.get_k_basis().GetXYZ();
 
-	Vector3 a_trans = a.get_translation().xyz;
-	Vector3 b_trans = b.get_translation().xyz;
+	Vector3 a_trans = a.get_translation().GetXYZ();
+	Vector3 b_trans = b.get_translation().GetXYZ();
 
 	Vector3 i_slerped = slerp(a_i_basis, b_i_basis, t);
 	Vector3 j_slerped = slerp(a_j_basis, b_j_basis, t);
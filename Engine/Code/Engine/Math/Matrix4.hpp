@@ -1,5 +1,4 @@
 #pragma once
-#pragma warning(disable: 4201)
 
 #include "Engine/Math/Vector2.hpp"
 #include "Engine/Math/Vector3.hpp"
@@ -24,17 +23,7 @@
 class Matrix4
 {
 public:
-	union
-	{
-		struct
-		{
-			Vector4 first_row;
-			Vector4 second_row;
-			Vector4 third_row;
-			Vector4 fourth_row;
-		};
-		float data[16];
-	};
+	float data[16];
 
 public:
 	Matrix4();
@@ -58,6 +47,7 @@ public:
 	Vector4 get_j_basis() const;
 	Vector4 get_k_basis() const;
 	Vector4 get_translation() const;
+	Vector4 get_row(unsigned int row_index) const;
 
 	void set_i_basis(const Vector3& i_basis, float homogenous_coordinate);
 	void set_j_basis(const Vector3& j_basis, float homogenous_coordinate);
@@ -126,12 +116,17 @@ template<>
 inline
 bool BinaryStream::write(const Matrix4& v)
 {
-	return write(v.first_row) && write(v.second_row) && write(v.third_row) && write(v.fourth_row);
+	return write(v.get_row(0)) && write(v.get_row(1)) && write(v.get_row(2)) && write(v.get_row(3));
 }
 
 template<>
 inline
 bool BinaryStream::read(Matrix4& v)
 {
-	return read(v.first_row) && read(v.second_row) && read(v.third_row) && read(v.fourth_row);
+	for(unsigned int i = 0; i < 16; ++i){
+		if(!read(v.data[i])){
+			return false;
+		}
+	}
+	return true;
 }
\ No newline at end of file
@@ -497,7 +497,16 @@ float Compute2dPerlinNoiseZeroToOne(float posX, float posY, float scale, unsigne
 //
 // In 3D, gradients are unit-length vectors in random (3D) directions.
 //
-float Compute3dPerlinNoise( float posX, float posY, float posZ, float scale, unsigned int numOctaves, float octavePersistence, float octaveScale, bool renormalize, unsigned int seed )
+// <wrap> > 0 tiles the lattice the same way the noise-gen shaders' "Wrapped" Perlin does:
+//	indices become (index + 1) mod wrap, with the same period for every octave.
+//
+static int WrapPerlinIndex( int index, int wrap )
+{
+	int wrapped = (index + 1) % wrap;
+	return (wrapped < 0) ? wrapped + wrap : wrapped;
+}
+
+static float Compute3dPerlinNoiseInternal( float posX, float posY, float posZ, float scale, unsigned int numOctaves, float octavePersistence, float octaveScale, int wrap, bool renormalize, unsigned int seed )
 {
 	const float OCTAVE_OFFSET = 0.636764989593174f; // Translation/bias to add to each octave
 	const float fSQRT_3_OVER_3 = sqrtf(3.0f) / 3.0f;
@@ -532,6 +541,16 @@ float Compute3dPerlinNoise( float posX, float posY, float posZ, float scale, uns
 		int indexNorthY = indexSouthY + 1;
 		int indexAboveZ = indexBelowZ + 1;
 
+		if( wrap > 0 )
+		{
+			indexWestX  = WrapPerlinIndex( indexWestX, wrap );
+			indexSouthY = WrapPerlinIndex( indexSouthY, wrap );
+			indexBelowZ = WrapPerlinIndex( indexBelowZ, wrap );
+			indexEastX  = WrapPerlinIndex( indexEastX, wrap );
+			indexNorthY = WrapPerlinIndex( indexNorthY, wrap );
+			indexAboveZ = WrapPerlinIndex( indexAboveZ, wrap );
+		}
+
 		unsigned int noiseBelowSW = Get3dNoiseUint( indexWestX, indexSouthY, indexBelowZ, seed );
 		unsigned int noiseBelowSE = Get3dNoiseUint( indexEastX, indexSouthY, indexBelowZ, seed );
 		unsigned int noiseBelowNW = Get3dNoiseUint( indexWestX, indexNorthY, indexBelowZ, seed );
@@ -610,6 +629,11 @@ float Compute3dPerlinNoise( float posX, float posY, float posZ, float scale, uns
 	return totalNoise;
 }
 
+float Compute3dPerlinNoise( float posX, float posY, float posZ, float scale, unsigned int numOctaves, float octavePersistence, float octaveScale, bool renormalize, unsigned int seed )
+{
+	return Compute3dPerlinNoiseInternal( posX, posY, posZ, scale, numOctaves, octavePersistence, octaveScale, 0, renormalize, seed );
+}
+
 float Compute3dPerlinNoiseZeroToOne(float posX, float posY, float posZ, float scale, unsigned int numOctaves, float octavePersistence, float octaveScale, bool renormalize, unsigned int seed)
 {
 	float noise = Compute3dPerlinNoise(posX, posY, posZ, scale, numOctaves, octavePersistence, octaveScale, renormalize, seed);
@@ -617,6 +641,18 @@ float Compute3dPerlinNoiseZeroToOne(float posX, float posY, float posZ, float sc
 	return noise;
 }
 
+float Compute3dPerlinNoiseWrapped( float posX, float posY, float posZ, float scale, unsigned int numOctaves, float octavePersistence, float octaveScale, int wrap, bool renormalize, unsigned int seed )
+{
+	return Compute3dPerlinNoiseInternal( posX, posY, posZ, scale, numOctaves, octavePersistence, octaveScale, wrap, renormalize, seed );
+}
+
+float Compute3dPerlinNoiseZeroToOneWrapped( float posX, float posY, float posZ, float scale, unsigned int numOctaves, float octavePersistence, float octaveScale, int wrap, bool renormalize, unsigned int seed )
+{
+	float noise = Compute3dPerlinNoiseWrapped( posX, posY, posZ, scale, numOctaves, octavePersistence, octaveScale, wrap, renormalize, seed );
+	noise = (noise * 0.5f) + 0.5f;
+	return noise;
+}
+
 //-----------------------------------------------------------------------------------------------
 // Perlin noise is fractal noise with "gradient vector smoothing" applied.
 //
@@ -951,4 +987,118 @@ float get_worley_noise_3d(Vector3 position, float scale, unsigned int num_octave
 float get_worley_noise_3d(float x, float y, float z, float scale, unsigned int num_octaves, float octave_persistence, float octave_scale, bool renormalize)
 {
     return get_worley_noise_3d(Vector3(x, y, z), scale, num_octaves, octave_persistence, octave_scale, renormalize);
-}
\ No newline at end of file
+}
+
+//-----------------------------------------------------------------------------------------------
+static inline int wrap_worley_cell(int cell, int period)
+{
+    if(period <= 0){
+        return cell;
+    }
+
+    int wrapped = cell % period;
+    return (wrapped < 0) ? wrapped + period : wrapped;
+}
+
+//-----------------------------------------------------------------------------------------------
+// Feature point in [0,1)^3 for a cell, 10 bits of the hash per axis
+static inline Vector3 get_worley_feature_point(int cell_x, int cell_y, int cell_z, unsigned int seed)
+{
+    const float ONE_OVER_1024 = 1.f / 1024.f;
+
+    unsigned int hash = Get3dNoiseUint(cell_x, cell_y, cell_z, seed);
+    return Vector3((float)(hash & 0x3FF) * ONE_OVER_1024,
+                   (float)((hash >> 10) & 0x3FF) * ONE_OVER_1024,
+                   (float)((hash >> 20) & 0x3FF) * ONE_OVER_1024);
+}
+
+//-----------------------------------------------------------------------------------------------
+void get_hashed_worley_noise_3d(const Vector3& position, float* out_f1, float* out_f2, int period, unsigned int seed)
+{
+    Vector3 i_st(floorf(position.x), floorf(position.y), floorf(position.z));
+    Vector3 f_st(position.x - i_st.x, position.y - i_st.y, position.z - i_st.z);
+
+    int cell_x = (int)i_st.x;
+    int cell_y = (int)i_st.y;
+    int cell_z = (int)i_st.z;
+
+    float f1_sq = 1e9f;
+    float f2_sq = 1e9f;
+    for(int z = -1; z <= 1; z++){
+        for(int y = -1; y <= 1; y++){
+            for(int x = -1; x <= 1; x++){
+                Vector3 p = get_worley_feature_point(wrap_worley_cell(cell_x + x, period),
+                                                     wrap_worley_cell(cell_y + y, period),
+                                                     wrap_worley_cell(cell_z + z, period),
+                                                     seed);
+
+                // Vector between the pixel and the point
+                float dx = ((float)x + p.x) - f_st.x;
+                float dy = ((float)y + p.y) - f_st.y;
+                float dz = ((float)z + p.z) - f_st.z;
+                float dist_sq = (dx * dx) + (dy * dy) + (dz * dz);
+
+                // Keep the two closest
+                f2_sq = Min(f2_sq, Max(f1_sq, dist_sq));
+                f1_sq = Min(f1_sq, dist_sq);
+            }
+        }
+    }
+
+    if(nullptr != out_f1){
+        *out_f1 = Min(sqrtf(f1_sq), 1.0f);
+    }
+
+    if(nullptr != out_f2){
+        *out_f2 = sqrtf(f2_sq);
+    }
+}
+
+//-----------------------------------------------------------------------------------------------
+float get_hashed_worley_noise_3d(const Vector3& position, WorleyFeature feature, int period, unsigned int seed)
+{
+    float f1;
+    float f2;
+    get_hashed_worley_noise_3d(position, &f1, &f2, period, seed);
+
+    switch(feature)
+    {
+        case WORLEY_F2:             return f2;
+        case WORLEY_F2_MINUS_F1:    return f2 - f1;
+        default:                    return f1;
+    }
+}
+
+//-----------------------------------------------------------------------------------------------
+float get_hashed_worley_noise_3d(Vector3 position, float scale, unsigned int num_octaves, float octave_persistence, float octave_scale, bool renormalize, WorleyFeature feature, int period, unsigned int seed)
+{
+    float total_noise = 0.f;
+    float total_amplitude = 0.f;
+    float current_amplitude = 1.f;
+    float current_period = (float)period;
+    Vector3 current_position = position * scale;
+
+    for(unsigned int octave = 0; octave < num_octaves; ++octave)
+    {
+        float noise_this_octave = get_hashed_worley_noise_3d(current_position, feature, (int)(current_period + 0.5f), seed);
+
+        // Accumulate results and prepare for next octave (if any)
+        total_noise += noise_this_octave * current_amplitude;
+        total_amplitude += current_amplitude;
+        current_amplitude *= octave_persistence;
+        current_position *= octave_scale;
+        current_period *= octave_scale;
+        ++seed; // octaves with integer scales would otherwise share feature points
+    }
+
+    // Re-normalize total noise to within [-1,1] and fix octaves pulling us far away from limits
+    if(renormalize && total_amplitude > 0.f)
+    {
+        total_noise /= total_amplitude;				// Amplitude exceeds 1.0 if octaves are used
+        total_noise = (total_noise * 0.5f) + 0.5f;	// Map to [0,1]
+        total_noise = SmoothStep3(total_noise);		// Push towards extents (octaves pull us away)
+        total_noise = (total_noise * 2.0f) - 1.f;		// Map back to [-1,1]
+    }
+
+    return total_noise;
+}
@@ -108,6 +108,29 @@ float Compute2dPerlinNoiseZeroToOne( float posX, float posY, float scale=1.f, un
 float Compute3dPerlinNoiseZeroToOne( float posX, float posY, float posZ, float scale=1.f, unsigned int numOctaves=1, float octavePersistence=0.5f, float octaveScale=2.f, bool renormalize=true, unsigned int seed=0 );
 float Compute4dPerlinNoiseZeroToOne( float posX, float posY, float posZ, float posT, float scale=1.f, unsigned int numOctaves=1, float octavePersistence=0.5f, float octaveScale=2.f, bool renormalize=true, unsigned int seed=0 );
 
+// Same as Compute3dPerlinNoise, but lattice indices repeat every <wrap> cells (matches the
+//	Compute3dPerlinNoise*Wrapped functions in Data/HLSL/Util/noise.h used by the noise-gen shaders).
+float Compute3dPerlinNoiseWrapped( float posX, float posY, float posZ, float scale, unsigned int numOctaves, float octavePersistence, float octaveScale, int wrap, bool renormalize=true, unsigned int seed=0 );
+float Compute3dPerlinNoiseZeroToOneWrapped( float posX, float posY, float posZ, float scale, unsigned int numOctaves, float octavePersistence, float octaveScale, int wrap, bool renormalize=true, unsigned int seed=0 );
+
+//-----------------------------------------------------------------------------------------------
+// Batched Perlin noise (NoiseBatch.cpp)
+//
+// Evaluates <count> positions given as separate x/y/z arrays (SoA) and writes one value per
+//	position to <out_noise>. Uses AVX2 (8 lanes) or SSE4.1 (4 lanes) when available, falling
+//	back to the scalar functions above otherwise (see cpu.h).
+//
+// Lanes follow the scalar float op order, so results are bit-identical to the scalar versions
+//	unless the compiler contracts the scalar path into FMAs; they are always within
+//	NOISE_BATCH_TOLERANCE.
+//
+#define NOISE_BATCH_TOLERANCE 1e-5f
+
+void Compute3dPerlinNoiseBatch( const float* posXs, const float* posYs, const float* posZs, float* out_noise, unsigned int count, float scale=1.f, unsigned int numOctaves=1, float octavePersistence=0.5f, float octaveScale=2.f, bool renormalize=true, unsigned int seed=0 );
+void Compute3dPerlinNoiseZeroToOneBatch( const float* posXs, const float* posYs, const float* posZs, float* out_noise, unsigned int count, float scale=1.f, unsigned int numOctaves=1, float octavePersistence=0.5f, float octaveScale=2.f, bool renormalize=true, unsigned int seed=0 );
+void Compute3dPerlinNoiseWrappedBatch( const float* posXs, const float* posYs, const float* posZs, float* out_noise, unsigned int count, float scale, unsigned int numOctaves, float octavePersistence, float octaveScale, int wrap, bool renormalize=true, unsigned int seed=0 );
+void Compute3dPerlinNoiseZeroToOneWrappedBatch( const float* posXs, const float* posYs, const float* posZs, float* out_noise, unsigned int count, float scale, unsigned int numOctaves, float octavePersistence, float octaveScale, int wrap, bool renormalize=true, unsigned int seed=0 );
+
 //-----------------------------------------------------------------------------------------------
 // Simplex noise functions (random-access / deterministic)
 //
@@ -226,4 +249,32 @@ float get_worley_noise_3d(float x, float y, float z);
 
 //-----------------------------------------------------------------------------------------------
 float get_worley_noise_3d(Vector3 position, float scale, unsigned int num_octaves, float octave_persistence, float octave_scale, bool renormalize);
-float get_worley_noise_3d(float x, float y, float z, float scale, unsigned int num_octaves, float octave_persistence, float octave_scale, bool renormalize);
\ No newline at end of file
+float get_worley_noise_3d(float x, float y, float z, float scale, unsigned int num_octaves, float octave_persistence, float octave_scale, bool renormalize);
+
+//-----------------------------------------------------------------------------------------------
+// Hashed Worley noise
+//
+// Same cellular noise as above, but feature points come from the integer Get3dNoiseUint hash
+//	instead of the sin-based random3, cells use floor (so negative positions don't mirror), and
+//	the nearest two distances are tracked. F1 is clamped to 1 like the versions above.
+//
+// <period>		If > 0, cell coordinates wrap every <period> cells so the noise tiles. The octave
+//				versions scale the period by octave_scale each octave (use integer octave scales).
+//
+enum WorleyFeature : unsigned int
+{
+    WORLEY_F1,
+    WORLEY_F2,
+    WORLEY_F2_MINUS_F1
+};
+
+void  get_hashed_worley_noise_3d(const Vector3& position, float* out_f1, float* out_f2, int period = 0, unsigned int seed = 0);
+float get_hashed_worley_noise_3d(const Vector3& position, WorleyFeature feature = WORLEY_F1, int period = 0, unsigned int seed = 0);
+float get_hashed_worley_noise_3d(Vector3 position, float scale, unsigned int num_octaves, float octave_persistence, float octave_scale, bool renormalize, WorleyFeature feature = WORLEY_F1, int period = 0, unsigned int seed = 0);
+
+//-----------------------------------------------------------------------------------------------
+// Batched hashed Worley noise (NoiseBatch.cpp), SoA positions in, one value per position out.
+//	Matches the scalar versions above within NOISE_BATCH_TOLERANCE.
+//
+void get_hashed_worley_noise_3d_batch(const float* xs, const float* ys, const float* zs, float* out_f1, float* out_f2, unsigned int count, int period = 0, unsigned int seed = 0);
+void get_hashed_worley_noise_3d_batch(const float* xs, const float* ys, const float* zs, float* out_noise, unsigned int count, float scale, unsigned int num_octaves, float octave_persistence, float octave_scale, bool renormalize, WorleyFeature feature = WORLEY_F1, int period = 0, unsigned int seed = 0);
@@ -0,0 +1,246 @@
+//-----------------------------------------------------------------------------------------------
+// NoiseBatch.cpp
+//
+// Batched (SoA) versions of the noise functions in Noise.cpp. Each kernel is written once as a
+//	template over the SIMD lane type (see simd.h) and mirrors the scalar float op order exactly,
+//	so lanes produce the same bits as the scalar functions (see NOISE_BATCH_TOLERANCE). The
+//	kernels live in NoiseBatchLanes.hpp, the AVX2 instantiations in NoiseBatchAVX2.cpp.
+//
+#include "Engine/Math/NoiseBatchLanes.hpp"
+#include "Engine/Core/cpu.h"
+#include "Engine/Core/console_command.h"
+#include "Engine/Core/Time.hpp"
+#include "Engine/Core/log.h"
+#include <math.h>
+#include <vector>
+
+
+//-----------------------------------------------------------------------------------------------
+static void Compute3dPerlinNoiseBatchScalar( const float* posXs, const float* posYs, const float* posZs, float* out_noise, unsigned int count, float scale, unsigned int numOctaves, float octavePersistence, float octaveScale, int wrap, bool renormalize, unsigned int seed, bool zeroToOne )
+{
+	for( unsigned int index = 0; index < count; ++ index )
+	{
+		out_noise[index] = zeroToOne ? Compute3dPerlinNoiseZeroToOneWrapped( posXs[index], posYs[index], posZs[index], scale, numOctaves, octavePersistence, octaveScale, wrap, renormalize, seed )
+									 : Compute3dPerlinNoiseWrapped( posXs[index], posYs[index], posZs[index], scale, numOctaves, octavePersistence, octaveScale, wrap, renormalize, seed );
+	}
+}
+
+
+//-----------------------------------------------------------------------------------------------
+static void Compute3dPerlinNoiseBatchDispatch( const float* posXs, const float* posYs, const float* posZs, float* out_noise, unsigned int count, float scale, unsigned int numOctaves, float octavePersistence, float octaveScale, int wrap, bool renormalize, unsigned int seed, bool zeroToOne )
+{
+	switch( cpu_get_simd_level() )
+	{
+		case SIMD_LEVEL_AVX2:
+			Compute3dPerlinNoiseBatchAVX2( posXs, posYs, posZs, out_noise, count, scale, numOctaves, octavePersistence, octaveScale, wrap, renormalize, seed, zeroToOne );
+			break;
+		case SIMD_LEVEL_SSE41:
+			Compute3dPerlinNoiseBatchKernel<simd4_t>( posXs, posYs, posZs, out_noise, count, scale, numOctaves, octavePersistence, octaveScale, wrap, renormalize, seed, zeroToOne );
+			break;
+		default:
+			Compute3dPerlinNoiseBatchScalar( posXs, posYs, posZs, out_noise, count, scale, numOctaves, octavePersistence, octaveScale, wrap, renormalize, seed, zeroToOne );
+			break;
+	}
+}
+
+
+//-----------------------------------------------------------------------------------------------
+void Compute3dPerlinNoiseBatch( const float* posXs, const float* posYs, const float* posZs, float* out_noise, unsigned int count, float scale, unsigned int numOctaves, float octavePersistence, float octaveScale, bool renormalize, unsigned int seed )
+{
+	Compute3dPerlinNoiseBatchDispatch( posXs, posYs, posZs, out_noise, count, scale, numOctaves, octavePersistence, octaveScale, 0, renormalize, seed, false );
+}
+
+
+//-----------------------------------------------------------------------------------------------
+void Compute3dPerlinNoiseZeroToOneBatch( const float* posXs, const float* posYs, const float* posZs, float* out_noise, unsigned int count, float scale, unsigned int numOctaves, float octavePersistence, float octaveScale, bool renormalize, unsigned int seed )
+{
+	Compute3dPerlinNoiseBatchDispatch( posXs, posYs, posZs, out_noise, count, scale, numOctaves, octavePersistence, octaveScale, 0, renormalize, seed, true );
+}
+
+
+//-----------------------------------------------------------------------------------------------
+void Compute3dPerlinNoiseWrappedBatch( const float* posXs, const float* posYs, const float* posZs, float* out_noise, unsigned int count, float scale, unsigned int numOctaves, float octavePersistence, float octaveScale, int wrap, bool renormalize, unsigned int seed )
+{
+	Compute3dPerlinNoiseBatchDispatch( posXs, posYs, posZs, out_noise, count, scale, numOctaves, octavePersistence, octaveScale, wrap, renormalize, seed, false );
+}
+
+
+//-----------------------------------------------------------------------------------------------
+void Compute3dPerlinNoiseZeroToOneWrappedBatch( const float* posXs, const float* posYs, const float* posZs, float* out_noise, unsigned int count, float scale, unsigned int numOctaves, float octavePersistence, float octaveScale, int wrap, bool renormalize, unsigned int seed )
+{
+	Compute3dPerlinNoiseBatchDispatch( posXs, posYs, posZs, out_noise, count, scale, numOctaves, octavePersistence, octaveScale, wrap, renormalize, seed, true );
+}
+
+
+//-----------------------------------------------------------------------------------------------
+void get_hashed_worley_noise_3d_batch( const float* xs, const float* ys, const float* zs, float* out_f1, float* out_f2, unsigned int count, int period, unsigned int seed )
+{
+	switch( cpu_get_simd_level() )
+	{
+		case SIMD_LEVEL_AVX2:
+			GetHashedWorleyNoise3dBatchAVX2( xs, ys, zs, out_f1, out_f2, count, period, seed );
+			break;
+		case SIMD_LEVEL_SSE41:
+			GetHashedWorleyNoise3dBatchKernel<simd4_t>( xs, ys, zs, out_f1, out_f2, count, period, seed );
+			break;
+		default:
+			for( unsigned int index = 0; index < count; ++ index )
+			{
+				get_hashed_worley_noise_3d( Vector3( xs[index], ys[index], zs[index] ), (nullptr != out_f1) ? out_f1 + index : nullptr, (nullptr != out_f2) ? out_f2 + index : nullptr, period, seed );
+			}
+			break;
+	}
+}
+
+
+//-----------------------------------------------------------------------------------------------
+void get_hashed_worley_noise_3d_batch( const float* xs, const float* ys, const float* zs, float* out_noise, unsigned int count, float scale, unsigned int num_octaves, float octave_persistence, float octave_scale, bool renormalize, WorleyFeature feature, int period, unsigned int seed )
+{
+	switch( cpu_get_simd_level() )
+	{
+		case SIMD_LEVEL_AVX2:
+			GetHashedWorleyNoise3dOctavesBatchAVX2( xs, ys, zs, out_noise, count, scale, num_octaves, octave_persistence, octave_scale, renormalize, feature, period, seed );
+			break;
+		case SIMD_LEVEL_SSE41:
+			GetHashedWorleyNoise3dOctavesBatchKernel<simd4_t>( xs, ys, zs, out_noise, count, scale, num_octaves, octave_persistence, octave_scale, renormalize, feature, period, seed );
+			break;
+		default:
+			for( unsigned int index = 0; index < count; ++ index )
+			{
+				out_noise[index] = get_hashed_worley_noise_3d( Vector3( xs[index], ys[index], zs[index] ), scale, num_octaves, octave_persistence, octave_scale, renormalize, feature, period, seed );
+			}
+			break;
+	}
+}
+
+
+//-----------------------------------------------------------------------------------------------
+// Benchmark: samples/sec of the scalar path vs. the batched path, plus the max error between them
+//
+COMMAND(bench_perlin_batch, "[uint:num_samples] [uint:num_octaves] Compares scalar and batched 3D Perlin throughput")
+{
+	unsigned int numSamples = args.is_at_end() ? (1u << 20) : args.next_uint_arg();
+	unsigned int numOctaves = args.is_at_end() ? 4 : args.next_uint_arg();
+	numSamples = (numSamples == 0) ? 1 : numSamples;
+
+	std::vector<float> posXs( numSamples );
+	std::vector<float> posYs( numSamples );
+	std::vector<float> posZs( numSamples );
+	std::vector<float> scalarNoise( numSamples );
+	std::vector<float> batchNoise( numSamples );
+
+	for( unsigned int index = 0; index < numSamples; ++ index )
+	{
+		posXs[index] = (Get1dNoiseZeroToOne( (int) index, 0 ) * 512.f) - 256.f;
+		posYs[index] = (Get1dNoiseZeroToOne( (int) index, 1 ) * 512.f) - 256.f;
+		posZs[index] = (Get1dNoiseZeroToOne( (int) index, 2 ) * 512.f) - 256.f;
+	}
+
+	const float scale = 16.f;
+
+	double scalarStart = get_current_time_seconds();
+	Compute3dPerlinNoiseBatchScalar( posXs.data(), posYs.data(), posZs.data(), scalarNoise.data(), numSamples, scale, numOctaves, 0.5f, 2.f, 0, true, 0, false );
+	double scalarSeconds = get_current_time_seconds() - scalarStart;
+
+	double batchStart = get_current_time_seconds();
+	Compute3dPerlinNoiseBatch( posXs.data(), posYs.data(), posZs.data(), batchNoise.data(), numSamples, scale, numOctaves, 0.5f, 2.f, true, 0 );
+	double batchSeconds = get_current_time_seconds() - batchStart;
+
+	float maxError = 0.f;
+	for( unsigned int index = 0; index < numSamples; ++ index )
+	{
+		float error = fabsf( scalarNoise[index] - batchNoise[index] );
+		maxError = (error > maxError) ? error : maxError;
+	}
+
+	double scalarRate = (double) numSamples / scalarSeconds;
+	double batchRate = (double) numSamples / batchSeconds;
+	const char* levelName = cpu_get_simd_level_name( cpu_get_simd_level() );
+
+	console_info( "perlin 3d, %u samples, %u octaves", numSamples, numOctaves );
+	console_info( "  scalar: %.2f Msamples/sec", scalarRate / 1000000.0 );
+	console_info( "  %s: %.2f Msamples/sec (%.2fx)", levelName, batchRate / 1000000.0, batchRate / scalarRate );
+	if( maxError <= NOISE_BATCH_TOLERANCE )
+	{
+		console_success( "  max error %g (tolerance %g)", maxError, NOISE_BATCH_TOLERANCE );
+	}
+	else
+	{
+		console_error( "  max error %g exceeds tolerance %g", maxError, NOISE_BATCH_TOLERANCE );
+	}
+
+	log_tagged_printf( "bench", "perlin_batch samples=%u octaves=%u scalar=%.0f/s %s=%.0f/s max_error=%g", numSamples, numOctaves, scalarRate, levelName, batchRate, maxError );
+}
+
+
+//-----------------------------------------------------------------------------------------------
+// Benchmark: sin-based worley vs. hashed scalar worley vs. batched hashed worley
+//
+COMMAND(bench_worley_batch, "[uint:num_samples] [uint:num_octaves] Compares scalar and batched 3D Worley throughput")
+{
+	unsigned int numSamples = args.is_at_end() ? (1u << 18) : args.next_uint_arg();
+	unsigned int numOctaves = args.is_at_end() ? 3 : args.next_uint_arg();
+	numSamples = (numSamples == 0) ? 1 : numSamples;
+
+	std::vector<float> xs( numSamples );
+	std::vector<float> ys( numSamples );
+	std::vector<float> zs( numSamples );
+	std::vector<float> legacyNoise( numSamples );
+	std::vector<float> scalarNoise( numSamples );
+	std::vector<float> batchNoise( numSamples );
+
+	for( unsigned int index = 0; index < numSamples; ++ index )
+	{
+		xs[index] = Get1dNoiseZeroToOne( (int) index, 0 );
+		ys[index] = Get1dNoiseZeroToOne( (int) index, 1 );
+		zs[index] = Get1dNoiseZeroToOne( (int) index, 2 );
+	}
+
+	const float scale = 8.f;
+	const int period = 8;
+
+	double legacyStart = get_current_time_seconds();
+	for( unsigned int index = 0; index < numSamples; ++ index )
+	{
+		legacyNoise[index] = get_worley_noise_3d( Vector3( xs[index], ys[index], zs[index] ), scale, numOctaves, 0.5f, 2.f, true );
+	}
+	double legacySeconds = get_current_time_seconds() - legacyStart;
+
+	double scalarStart = get_current_time_seconds();
+	for( unsigned int index = 0; index < numSamples; ++ index )
+	{
+		scalarNoise[index] = get_hashed_worley_noise_3d( Vector3( xs[index], ys[index], zs[index] ), scale, numOctaves, 0.5f, 2.f, true, WORLEY_F1, period );
+	}
+	double scalarSeconds = get_current_time_seconds() - scalarStart;
+
+	double batchStart = get_current_time_seconds();
+	get_hashed_worley_noise_3d_batch( xs.data(), ys.data(), zs.data(), batchNoise.data(), numSamples, scale, numOctaves, 0.5f, 2.f, true, WORLEY_F1, period );
+	double batchSeconds = get_current_time_seconds() - batchStart;
+
+	float maxError = 0.f;
+	for( unsigned int index = 0; index < numSamples; ++ index )
+	{
+		float error = fabsf( scalarNoise[index] - batchNoise[index] );
+		maxError = (error > maxError) ? error : maxError;
+	}
+
+	double legacyRate = (double) numSamples / legacySeconds;
+	double scalarRate = (double) numSamples / scalarSeconds;
+	double batchRate = (double) numSamples / batchSeconds;
+	const char* levelName = cpu_get_simd_level_name( cpu_get_simd_level() );
+
+	console_info( "worley 3d, %u samples, %u octaves", numSamples, numOctaves );
+	console_info( "  random3: %.2f Msamples/sec", legacyRate / 1000000.0 );
+	console_info( "  hashed: %.2f Msamples/sec (%.2fx)", scalarRate / 1000000.0, scalarRate / legacyRate );
+	console_info( "  hashed %s: %.2f Msamples/sec (%.2fx)", levelName, batchRate / 1000000.0, batchRate / legacyRate );
+	if( maxError <= NOISE_BATCH_TOLERANCE )
+	{
+		console_success( "  max error %g (tolerance %g)", maxError, NOISE_BATCH_TOLERANCE );
+	}
+	else
+	{
+		console_error( "  max error %g exceeds tolerance %g", maxError, NOISE_BATCH_TOLERANCE );
+	}
+
+	log_tagged_printf( "bench", "worley_batch samples=%u octaves=%u random3=%.0f/s hashed=%.0f/s %s=%.0f/s max_error=%g", numSamples, numOctaves, legacyRate, scalarRate, levelName, batchRate, maxError );
+}
@@ -0,0 +1,28 @@
+//-----------------------------------------------------------------------------------------------
+// NoiseBatchAVX2.cpp
+//
+// simd8_t instantiations of the NoiseBatchLanes.hpp kernels. This is the only noise file built
+//	with AVX2 enabled, NoiseBatch.cpp picks these at runtime when cpu_get_simd_level() allows.
+//
+#include "Engine/Math/NoiseBatchLanes.hpp"
+
+
+//-----------------------------------------------------------------------------------------------
+void Compute3dPerlinNoiseBatchAVX2( const float* posXs, const float* posYs, const float* posZs, float* out_noise, unsigned int count, float scale, unsigned int numOctaves, float octavePersistence, float octaveScale, int wrap, bool renormalize, unsigned int seed, bool zeroToOne )
+{
+	Compute3dPerlinNoiseBatchKernel<simd8_t>( posXs, posYs, posZs, out_noise, count, scale, numOctaves, octavePersistence, octaveScale, wrap, renormalize, seed, zeroToOne );
+}
+
+
+//-----------------------------------------------------------------------------------------------
+void GetHashedWorleyNoise3dBatchAVX2( const float* xs, const float* ys, const float* zs, float* out_f1, float* out_f2, unsigned int count, int period, unsigned int seed )
+{
+	GetHashedWorleyNoise3dBatchKernel<simd8_t>( xs, ys, zs, out_f1, out_f2, count, period, seed );
+}
+
+
+//-----------------------------------------------------------------------------------------------
+void GetHashedWorleyNoise3dOctavesBatchAVX2( const float* xs, const float* ys, const float* zs, float* out_noise, unsigned int count, float scale, unsigned int num_octaves, float octave_persistence, float octave_scale, bool renormalize, WorleyFeature feature, int period, unsigned int seed )
+{
+	GetHashedWorleyNoise3dOctavesBatchKernel<simd8_t>( xs, ys, zs, out_noise, count, scale, num_octaves, octave_persistence, octave_scale, renormalize, feature, period, seed );
+}
@@ -0,0 +1,444 @@
+//-----------------------------------------------------------------------------------------------
+// NoiseBatchLanes.hpp
+//
+// The lane templates behind NoiseBatch.cpp, shared with NoiseBatchAVX2.cpp. NoiseBatch.cpp
+//	instantiates them for simd4_t and NoiseBatchAVX2.cpp, the only file built for AVX2, for
+//	simd8_t. They are static so each file compiles its own copy for its own instruction set.
+//
+#pragma once
+#include "Engine/Math/Noise.hpp"
+#include "Engine/Math/Vector3.hpp"
+#include "Engine/Math/simd.h"
+#include "Engine/Core/crt_compat.h"
+
+
+//-----------------------------------------------------------------------------------------------
+// The AVX2 kernels, only call them after checking cpu_has_avx2()
+//
+void Compute3dPerlinNoiseBatchAVX2( const float* posXs, const float* posYs, const float* posZs, float* out_noise, unsigned int count, float scale, unsigned int numOctaves, float octavePersistence, float octaveScale, int wrap, bool renormalize, unsigned int seed, bool zeroToOne );
+void GetHashedWorleyNoise3dBatchAVX2( const float* xs, const float* ys, const float* zs, float* out_f1, float* out_f2, unsigned int count, int period, unsigned int seed );
+void GetHashedWorleyNoise3dOctavesBatchAVX2( const float* xs, const float* ys, const float* zs, float* out_noise, unsigned int count, float scale, unsigned int num_octaves, float octave_persistence, float octave_scale, bool renormalize, WorleyFeature feature, int period, unsigned int seed );
+
+
+//-----------------------------------------------------------------------------------------------
+// Squirrel's Get1dNoiseUint, one hash per lane
+//
+template<typename SIMD>
+static __forceinline typename SIMD::vint Get1dNoiseUintLanes( typename SIMD::vint positionX, typename SIMD::vint seed )
+{
+	typedef typename SIMD::vint vint;
+
+	const vint BIT_NOISE1 = SIMD::set1_int( (int) 0x68E31DA4 );
+	const vint BIT_NOISE2 = SIMD::set1_int( (int) 0xB5297A4D );
+	const vint BIT_NOISE3 = SIMD::set1_int( (int) 0x1B56C4E9 );
+
+	vint mangledBits = positionX;
+	mangledBits = SIMD::mul_int( mangledBits, BIT_NOISE1 );
+	mangledBits = SIMD::add_int( mangledBits, seed );
+	mangledBits = SIMD::xor_int( mangledBits, SIMD::template shift_right<8>( mangledBits ) );
+	mangledBits = SIMD::add_int( mangledBits, BIT_NOISE2 );
+	mangledBits = SIMD::xor_int( mangledBits, SIMD::template shift_left<8>( mangledBits ) );
+	mangledBits = SIMD::mul_int( mangledBits, BIT_NOISE3 );
+	mangledBits = SIMD::xor_int( mangledBits, SIMD::template shift_right<8>( mangledBits ) );
+	return mangledBits;
+}
+
+
+//-----------------------------------------------------------------------------------------------
+template<typename SIMD>
+static __forceinline typename SIMD::vint Get3dNoiseUintLanes( typename SIMD::vint indexX, typename SIMD::vint indexY, typename SIMD::vint indexZ, typename SIMD::vint seed )
+{
+	const typename SIMD::vint PRIME1 = SIMD::set1_int( 198491317 );
+	const typename SIMD::vint PRIME2 = SIMD::set1_int( 6542989 );
+	typename SIMD::vint index = SIMD::add_int( SIMD::add_int( indexX, SIMD::mul_int( PRIME1, indexY ) ), SIMD::mul_int( PRIME2, indexZ ) );
+	return Get1dNoiseUintLanes<SIMD>( index, seed );
+}
+
+
+//-----------------------------------------------------------------------------------------------
+// Same arithmetic as SmoothStep3 (Crossfade of SmoothStart2 / SmoothStop2)
+//
+template<typename SIMD>
+static __forceinline typename SIMD::vfloat SmoothStep3Lanes( typename SIMD::vfloat t )
+{
+	typedef typename SIMD::vfloat vfloat;
+
+	const vfloat one = SIMD::set1( 1.f );
+	vfloat flip = SIMD::sub( one, t );
+	vfloat smoothStart = SIMD::mul( t, t );
+	vfloat smoothStop = SIMD::sub( one, SIMD::mul( flip, flip ) );
+	return SIMD::add( SIMD::mul( smoothStart, SIMD::sub( one, t ) ), SIMD::mul( smoothStop, t ) );
+}
+
+
+//-----------------------------------------------------------------------------------------------
+// Gradients are (+-sqrt(3)/3, +-sqrt(3)/3, +-sqrt(3)/3), so the dot product against a corner is
+//	just the displacement scaled by sqrt(3)/3 with the sign bits flipped by the hash bits.
+//
+template<typename SIMD>
+static __forceinline typename SIMD::vfloat GradientDotLanes( typename SIMD::vint hash, typename SIMD::vfloat scaledDx, typename SIMD::vfloat scaledDy, typename SIMD::vfloat scaledDz )
+{
+	typedef typename SIMD::vfloat vfloat;
+	typedef typename SIMD::vint vint;
+
+	const vint one = SIMD::set1_int( 1 );
+	vint signX = SIMD::template shift_left<31>( SIMD::and_int( hash, one ) );
+	vint signY = SIMD::template shift_left<31>( SIMD::and_int( SIMD::template shift_right<1>( hash ), one ) );
+	vint signZ = SIMD::template shift_left<31>( SIMD::and_int( SIMD::template shift_right<2>( hash ), one ) );
+
+	vfloat dotX = SIMD::bit_xor( scaledDx, SIMD::as_float( signX ) );
+	vfloat dotY = SIMD::bit_xor( scaledDy, SIMD::as_float( signY ) );
+	vfloat dotZ = SIMD::bit_xor( scaledDz, SIMD::as_float( signZ ) );
+	return SIMD::add( SIMD::add( dotX, dotY ), dotZ );
+}
+
+
+//-----------------------------------------------------------------------------------------------
+// (index + 1) mod wrap, same as WrapPerlinIndex in Noise.cpp. Lattice indices are exact in
+//	floats, so the modulo is done in float math and fixed up for the rounded reciprocal.
+//
+template<typename SIMD>
+static __forceinline typename SIMD::vint WrapPerlinIndexLanes( typename SIMD::vint index, typename SIMD::vfloat wrapF, typename SIMD::vfloat invWrap )
+{
+	typedef typename SIMD::vfloat vfloat;
+
+	vfloat shifted = SIMD::to_float( SIMD::add_int( index, SIMD::set1_int( 1 ) ) );
+	vfloat wrapped = SIMD::sub( shifted, SIMD::mul( SIMD::floor( SIMD::mul( shifted, invWrap ) ), wrapF ) );
+	wrapped = SIMD::select( SIMD::cmp_lt( wrapped, SIMD::zero() ), SIMD::add( wrapped, wrapF ), wrapped );
+	wrapped = SIMD::select( SIMD::cmp_le( wrapF, wrapped ), SIMD::sub( wrapped, wrapF ), wrapped );
+	return SIMD::to_int_truncate( wrapped );
+}
+
+
+//-----------------------------------------------------------------------------------------------
+template<typename SIMD>
+static __forceinline typename SIMD::vfloat Compute3dPerlinNoiseLanes( typename SIMD::vfloat posX, typename SIMD::vfloat posY, typename SIMD::vfloat posZ, float scale, unsigned int numOctaves, float octavePersistence, float octaveScale, int wrap, bool renormalize, unsigned int seed )
+{
+	typedef typename SIMD::vfloat vfloat;
+	typedef typename SIMD::vint vint;
+
+	const float OCTAVE_OFFSET = 0.636764989593174f;
+	const float fSQRT_3_OVER_3 = sqrtf(3.0f) / 3.0f;
+
+	const vfloat one = SIMD::set1( 1.f );
+	const vint oneInt = SIMD::set1_int( 1 );
+	const vfloat gradientScale = SIMD::set1( fSQRT_3_OVER_3 );
+	const vfloat wrapF = SIMD::set1( (float) wrap );
+	const vfloat invWrap = SIMD::set1( (wrap > 0) ? 1.f / (float) wrap : 0.f );
+
+	vfloat totalNoise = SIMD::zero();
+	float totalAmplitude = 0.f;
+	float currentAmplitude = 1.f;
+	vfloat invScale = SIMD::set1( 1.f / scale );
+	vfloat currentX = SIMD::mul( posX, invScale );
+	vfloat currentY = SIMD::mul( posY, invScale );
+	vfloat currentZ = SIMD::mul( posZ, invScale );
+
+	for( unsigned int octaveNum = 0; octaveNum < numOctaves; ++ octaveNum )
+	{
+		vint octaveSeed = SIMD::set1_int( (int) seed );
+
+		vfloat minX = SIMD::floor( currentX );
+		vfloat minY = SIMD::floor( currentY );
+		vfloat minZ = SIMD::floor( currentZ );
+		vfloat maxX = SIMD::add( minX, one );
+		vfloat maxY = SIMD::add( minY, one );
+		vfloat maxZ = SIMD::add( minZ, one );
+
+		vint indexWestX  = SIMD::to_int_truncate( minX );
+		vint indexSouthY = SIMD::to_int_truncate( minY );
+		vint indexBelowZ = SIMD::to_int_truncate( minZ );
+		vint indexEastX  = SIMD::add_int( indexWestX, oneInt );
+		vint indexNorthY = SIMD::add_int( indexSouthY, oneInt );
+		vint indexAboveZ = SIMD::add_int( indexBelowZ, oneInt );
+
+		if( wrap > 0 )
+		{
+			indexWestX  = WrapPerlinIndexLanes<SIMD>( indexWestX, wrapF, invWrap );
+			indexSouthY = WrapPerlinIndexLanes<SIMD>( indexSouthY, wrapF, invWrap );
+			indexBelowZ = WrapPerlinIndexLanes<SIMD>( indexBelowZ, wrapF, invWrap );
+			indexEastX  = WrapPerlinIndexLanes<SIMD>( indexEastX, wrapF, invWrap );
+			indexNorthY = WrapPerlinIndexLanes<SIMD>( indexNorthY, wrapF, invWrap );
+			indexAboveZ = WrapPerlinIndexLanes<SIMD>( indexAboveZ, wrapF, invWrap );
+		}
+
+		vint noiseBelowSW = Get3dNoiseUintLanes<SIMD>( indexWestX, indexSouthY, indexBelowZ, octaveSeed );
+		vint noiseBelowSE = Get3dNoiseUintLanes<SIMD>( indexEastX, indexSouthY, indexBelowZ, octaveSeed );
+		vint noiseBelowNW = Get3dNoiseUintLanes<SIMD>( indexWestX, indexNorthY, indexBelowZ, octaveSeed );
+		vint noiseBelowNE = Get3dNoiseUintLanes<SIMD>( indexEastX, indexNorthY, indexBelowZ, octaveSeed );
+		vint noiseAboveSW = Get3dNoiseUintLanes<SIMD>( indexWestX, indexSouthY, indexAboveZ, octaveSeed );
+		vint noiseAboveSE = Get3dNoiseUintLanes<SIMD>( indexEastX, indexSouthY, indexAboveZ, octaveSeed );
+		vint noiseAboveNW = Get3dNoiseUintLanes<SIMD>( indexWestX, indexNorthY, indexAboveZ, octaveSeed );
+		vint noiseAboveNE = Get3dNoiseUintLanes<SIMD>( indexEastX, indexNorthY, indexAboveZ, octaveSeed );
+
+		// Displacements from the min and max corners, pre-scaled by the gradient magnitude
+		vfloat displacementMinX = SIMD::sub( currentX, minX );
+		vfloat displacementMinY = SIMD::sub( currentY, minY );
+		vfloat displacementMinZ = SIMD::sub( currentZ, minZ );
+		vfloat scaledMinX = SIMD::mul( gradientScale, displacementMinX );
+		vfloat scaledMinY = SIMD::mul( gradientScale, displacementMinY );
+		vfloat scaledMinZ = SIMD::mul( gradientScale, displacementMinZ );
+		vfloat scaledMaxX = SIMD::mul( gradientScale, SIMD::sub( currentX, maxX ) );
+		vfloat scaledMaxY = SIMD::mul( gradientScale, SIMD::sub( currentY, maxY ) );
+		vfloat scaledMaxZ = SIMD::mul( gradientScale, SIMD::sub( currentZ, maxZ ) );
+
+		vfloat dotBelowSW = GradientDotLanes<SIMD>( noiseBelowSW, scaledMinX, scaledMinY, scaledMinZ );
+		vfloat dotBelowSE = GradientDotLanes<SIMD>( noiseBelowSE, scaledMaxX, scaledMinY, scaledMinZ );
+		vfloat dotBelowNW = GradientDotLanes<SIMD>( noiseBelowNW, scaledMinX, scaledMaxY, scaledMinZ );
+		vfloat dotBelowNE = GradientDotLanes<SIMD>( noiseBelowNE, scaledMaxX, scaledMaxY, scaledMinZ );
+		vfloat dotAboveSW = GradientDotLanes<SIMD>( noiseAboveSW, scaledMinX, scaledMinY, scaledMaxZ );
+		vfloat dotAboveSE = GradientDotLanes<SIMD>( noiseAboveSE, scaledMaxX, scaledMinY, scaledMaxZ );
+		vfloat dotAboveNW = GradientDotLanes<SIMD>( noiseAboveNW, scaledMinX, scaledMaxY, scaledMaxZ );
+		vfloat dotAboveNE = GradientDotLanes<SIMD>( noiseAboveNE, scaledMaxX, scaledMaxY, scaledMaxZ );
+
+		vfloat weightEast  = SmoothStep3Lanes<SIMD>( displacementMinX );
+		vfloat weightNorth = SmoothStep3Lanes<SIMD>( displacementMinY );
+		vfloat weightAbove = SmoothStep3Lanes<SIMD>( displacementMinZ );
+		vfloat weightWest  = SIMD::sub( one, weightEast );
+		vfloat weightSouth = SIMD::sub( one, weightNorth );
+		vfloat weightBelow = SIMD::sub( one, weightAbove );
+
+		// 8-way blend (8 -> 4 -> 2 -> 1)
+		vfloat blendBelowSouth = SIMD::add( SIMD::mul( weightEast, dotBelowSE ), SIMD::mul( weightWest, dotBelowSW ) );
+		vfloat blendBelowNorth = SIMD::add( SIMD::mul( weightEast, dotBelowNE ), SIMD::mul( weightWest, dotBelowNW ) );
+		vfloat blendAboveSouth = SIMD::add( SIMD::mul( weightEast, dotAboveSE ), SIMD::mul( weightWest, dotAboveSW ) );
+		vfloat blendAboveNorth = SIMD::add( SIMD::mul( weightEast, dotAboveNE ), SIMD::mul( weightWest, dotAboveNW ) );
+		vfloat blendBelow = SIMD::add( SIMD::mul( weightSouth, blendBelowSouth ), SIMD::mul( weightNorth, blendBelowNorth ) );
+		vfloat blendAbove = SIMD::add( SIMD::mul( weightSouth, blendAboveSouth ), SIMD::mul( weightNorth, blendAboveNorth ) );
+		vfloat blendTotal = SIMD::add( SIMD::mul( weightBelow, blendBelow ), SIMD::mul( weightAbove, blendAbove ) );
+		vfloat noiseThisOctave = SIMD::mul( SIMD::set1( 1.66666666f ), blendTotal );
+
+		// Accumulate results and prepare for next octave (if any)
+		totalNoise = SIMD::add( totalNoise, SIMD::mul( noiseThisOctave, SIMD::set1( currentAmplitude ) ) );
+		totalAmplitude += currentAmplitude;
+		currentAmplitude *= octavePersistence;
+		vfloat vOctaveScale = SIMD::set1( octaveScale );
+		vfloat vOctaveOffset = SIMD::set1( OCTAVE_OFFSET );
+		currentX = SIMD::add( SIMD::mul( currentX, vOctaveScale ), vOctaveOffset );
+		currentY = SIMD::add( SIMD::mul( currentY, vOctaveScale ), vOctaveOffset );
+		currentZ = SIMD::add( SIMD::mul( currentZ, vOctaveScale ), vOctaveOffset );
+		++ seed;
+	}
+
+	// Re-normalize total noise to within [-1,1] and fix octaves pulling us far away from limits
+	if( renormalize && totalAmplitude > 0.f )
+	{
+		totalNoise = SIMD::div( totalNoise, SIMD::set1( totalAmplitude ) );
+		totalNoise = SIMD::add( SIMD::mul( totalNoise, SIMD::set1( 0.5f ) ), SIMD::set1( 0.5f ) );
+		totalNoise = SmoothStep3Lanes<SIMD>( totalNoise );
+		totalNoise = SIMD::sub( SIMD::mul( totalNoise, SIMD::set1( 2.0f ) ), one );
+	}
+
+	return totalNoise;
+}
+
+
+//-----------------------------------------------------------------------------------------------
+template<typename SIMD>
+static void Compute3dPerlinNoiseBatchKernel( const float* posXs, const float* posYs, const float* posZs, float* out_noise, unsigned int count, float scale, unsigned int numOctaves, float octavePersistence, float octaveScale, int wrap, bool renormalize, unsigned int seed, bool zeroToOne )
+{
+	typedef typename SIMD::vfloat vfloat;
+
+	unsigned int index = 0;
+	for( ; index + SIMD::WIDTH <= count; index += SIMD::WIDTH )
+	{
+		vfloat noise = Compute3dPerlinNoiseLanes<SIMD>( SIMD::load( posXs + index ), SIMD::load( posYs + index ), SIMD::load( posZs + index ), scale, numOctaves, octavePersistence, octaveScale, wrap, renormalize, seed );
+		if( zeroToOne )
+		{
+			noise = SIMD::add( SIMD::mul( noise, SIMD::set1( 0.5f ) ), SIMD::set1( 0.5f ) );
+		}
+		SIMD::store( out_noise + index, noise );
+	}
+
+	// Leftovers go through the scalar path, which produces identical results
+	for( ; index < count; ++ index )
+	{
+		out_noise[index] = zeroToOne ? Compute3dPerlinNoiseZeroToOneWrapped( posXs[index], posYs[index], posZs[index], scale, numOctaves, octavePersistence, octaveScale, wrap, renormalize, seed )
+									 : Compute3dPerlinNoiseWrapped( posXs[index], posYs[index], posZs[index], scale, numOctaves, octavePersistence, octaveScale, wrap, renormalize, seed );
+	}
+}
+
+
+//-----------------------------------------------------------------------------------------------
+// Hashed Worley noise
+//
+// Each lane is one sample position; the 27 neighbor cells are walked for all lanes at once.
+//	Integer cell coordinates stay exact in floats, so periodic wrapping is done in float math.
+//
+template<typename SIMD>
+static __forceinline typename SIMD::vint WrapWorleyCellLanes( typename SIMD::vint cell, int period, typename SIMD::vfloat periodF, typename SIMD::vfloat invPeriod )
+{
+	typedef typename SIMD::vfloat vfloat;
+
+	if( period <= 0 )
+	{
+		return cell;
+	}
+
+	vfloat cellF = SIMD::to_float( cell );
+	vfloat wrapped = SIMD::sub( cellF, SIMD::mul( SIMD::floor( SIMD::mul( cellF, invPeriod ) ), periodF ) );
+
+	// invPeriod is rounded, so fix up anything that landed one period off
+	wrapped = SIMD::select( SIMD::cmp_lt( wrapped, SIMD::zero() ), SIMD::add( wrapped, periodF ), wrapped );
+	wrapped = SIMD::select( SIMD::cmp_le( periodF, wrapped ), SIMD::sub( wrapped, periodF ), wrapped );
+	return SIMD::to_int_truncate( wrapped );
+}
+
+
+//-----------------------------------------------------------------------------------------------
+template<typename SIMD>
+static __forceinline void GetHashedWorleyNoise3dLanes( typename SIMD::vfloat posX, typename SIMD::vfloat posY, typename SIMD::vfloat posZ, int period, unsigned int seed, typename SIMD::vfloat* out_f1, typename SIMD::vfloat* out_f2 )
+{
+	typedef typename SIMD::vfloat vfloat;
+	typedef typename SIMD::vint vint;
+
+	const vfloat ONE_OVER_1024 = SIMD::set1( 1.f / 1024.f );
+	const vint BITS_MASK = SIMD::set1_int( 0x3FF );
+	const vint PRIME1 = SIMD::set1_int( 198491317 );
+	const vint PRIME2 = SIMD::set1_int( 6542989 );
+	const vint seedLanes = SIMD::set1_int( (int) seed );
+	const vfloat periodF = SIMD::set1( (float) period );
+	const vfloat invPeriod = SIMD::set1( (period > 0) ? (1.f / (float) period) : 0.f );
+
+	vfloat cellMinX = SIMD::floor( posX );
+	vfloat cellMinY = SIMD::floor( posY );
+	vfloat cellMinZ = SIMD::floor( posZ );
+	vfloat fracX = SIMD::sub( posX, cellMinX );
+	vfloat fracY = SIMD::sub( posY, cellMinY );
+	vfloat fracZ = SIMD::sub( posZ, cellMinZ );
+	vint cellX = SIMD::to_int_truncate( cellMinX );
+	vint cellY = SIMD::to_int_truncate( cellMinY );
+	vint cellZ = SIMD::to_int_truncate( cellMinZ );
+
+	// The hash index is x + PRIME1*y + PRIME2*z, so each axis term only has to be built 3 times
+	vint hashTermX[3];
+	vint hashTermY[3];
+	vint hashTermZ[3];
+	for( int offset = -1; offset <= 1; ++ offset )
+	{
+		vint offsetLanes = SIMD::set1_int( offset );
+		hashTermX[offset + 1] = WrapWorleyCellLanes<SIMD>( SIMD::add_int( cellX, offsetLanes ), period, periodF, invPeriod );
+		hashTermY[offset + 1] = SIMD::mul_int( PRIME1, WrapWorleyCellLanes<SIMD>( SIMD::add_int( cellY, offsetLanes ), period, periodF, invPeriod ) );
+		hashTermZ[offset + 1] = SIMD::mul_int( PRIME2, WrapWorleyCellLanes<SIMD>( SIMD::add_int( cellZ, offsetLanes ), period, periodF, invPeriod ) );
+	}
+
+	vfloat f1Sq = SIMD::set1( 1e9f );
+	vfloat f2Sq = SIMD::set1( 1e9f );
+	for( int z = -1; z <= 1; ++ z )
+	{
+		for( int y = -1; y <= 1; ++ y )
+		{
+			vint hashTermYZ = SIMD::add_int( hashTermY[y + 1], hashTermZ[z + 1] );
+			for( int x = -1; x <= 1; ++ x )
+			{
+				vint hash = Get1dNoiseUintLanes<SIMD>( SIMD::add_int( hashTermX[x + 1], hashTermYZ ), seedLanes );
+				vfloat pointX = SIMD::mul( SIMD::to_float( SIMD::and_int( hash, BITS_MASK ) ), ONE_OVER_1024 );
+				vfloat pointY = SIMD::mul( SIMD::to_float( SIMD::and_int( SIMD::template shift_right<10>( hash ), BITS_MASK ) ), ONE_OVER_1024 );
+				vfloat pointZ = SIMD::mul( SIMD::to_float( SIMD::and_int( SIMD::template shift_right<20>( hash ), BITS_MASK ) ), ONE_OVER_1024 );
+
+				vfloat dx = SIMD::sub( SIMD::add( SIMD::set1( (float) x ), pointX ), fracX );
+				vfloat dy = SIMD::sub( SIMD::add( SIMD::set1( (float) y ), pointY ), fracY );
+				vfloat dz = SIMD::sub( SIMD::add( SIMD::set1( (float) z ), pointZ ), fracZ );
+				vfloat distSq = SIMD::add( SIMD::add( SIMD::mul( dx, dx ), SIMD::mul( dy, dy ) ), SIMD::mul( dz, dz ) );
+
+				f2Sq = SIMD::min( f2Sq, SIMD::max( f1Sq, distSq ) );
+				f1Sq = SIMD::min( f1Sq, distSq );
+			}
+		}
+	}
+
+	*out_f1 = SIMD::min( SIMD::sqrt( f1Sq ), SIMD::set1( 1.f ) );
+	*out_f2 = SIMD::sqrt( f2Sq );
+}
+
+
+//-----------------------------------------------------------------------------------------------
+template<typename SIMD>
+static __forceinline typename SIMD::vfloat SelectWorleyFeatureLanes( typename SIMD::vfloat f1, typename SIMD::vfloat f2, WorleyFeature feature )
+{
+	switch( feature )
+	{
+		case WORLEY_F2:				return f2;
+		case WORLEY_F2_MINUS_F1:	return SIMD::sub( f2, f1 );
+		default:					return f1;
+	}
+}
+
+
+//-----------------------------------------------------------------------------------------------
+template<typename SIMD>
+static void GetHashedWorleyNoise3dBatchKernel( const float* xs, const float* ys, const float* zs, float* out_f1, float* out_f2, unsigned int count, int period, unsigned int seed )
+{
+	typedef typename SIMD::vfloat vfloat;
+
+	unsigned int index = 0;
+	for( ; index + SIMD::WIDTH <= count; index += SIMD::WIDTH )
+	{
+		vfloat f1;
+		vfloat f2;
+		GetHashedWorleyNoise3dLanes<SIMD>( SIMD::load( xs + index ), SIMD::load( ys + index ), SIMD::load( zs + index ), period, seed, &f1, &f2 );
+		if( nullptr != out_f1 ) SIMD::store( out_f1 + index, f1 );
+		if( nullptr != out_f2 ) SIMD::store( out_f2 + index, f2 );
+	}
+
+	for( ; index < count; ++ index )
+	{
+		get_hashed_worley_noise_3d( Vector3( xs[index], ys[index], zs[index] ), (nullptr != out_f1) ? out_f1 + index : nullptr, (nullptr != out_f2) ? out_f2 + index : nullptr, period, seed );
+	}
+}
+
+
+//-----------------------------------------------------------------------------------------------
+template<typename SIMD>
+static void GetHashedWorleyNoise3dOctavesBatchKernel( const float* xs, const float* ys, const float* zs, float* out_noise, unsigned int count, float scale, unsigned int num_octaves, float octave_persistence, float octave_scale, bool renormalize, WorleyFeature feature, int period, unsigned int seed )
+{
+	typedef typename SIMD::vfloat vfloat;
+
+	unsigned int index = 0;
+	for( ; index + SIMD::WIDTH <= count; index += SIMD::WIDTH )
+	{
+		vfloat vScale = SIMD::set1( scale );
+		vfloat currentX = SIMD::mul( SIMD::load( xs + index ), vScale );
+		vfloat currentY = SIMD::mul( SIMD::load( ys + index ), vScale );
+		vfloat currentZ = SIMD::mul( SIMD::load( zs + index ), vScale );
+
+		vfloat totalNoise = SIMD::zero();
+		float totalAmplitude = 0.f;
+		float currentAmplitude = 1.f;
+		float currentPeriod = (float) period;
+		unsigned int octaveSeed = seed;
+
+		for( unsigned int octave = 0; octave < num_octaves; ++ octave )
+		{
+			vfloat f1;
+			vfloat f2;
+			GetHashedWorleyNoise3dLanes<SIMD>( currentX, currentY, currentZ, (int)(currentPeriod + 0.5f), octaveSeed, &f1, &f2 );
+			vfloat noiseThisOctave = SelectWorleyFeatureLanes<SIMD>( f1, f2, feature );
+
+			totalNoise = SIMD::add( totalNoise, SIMD::mul( noiseThisOctave, SIMD::set1( currentAmplitude ) ) );
+			totalAmplitude += currentAmplitude;
+			currentAmplitude *= octave_persistence;
+			vfloat vOctaveScale = SIMD::set1( octave_scale );
+			currentX = SIMD::mul( currentX, vOctaveScale );
+			currentY = SIMD::mul( currentY, vOctaveScale );
+			currentZ = SIMD::mul( currentZ, vOctaveScale );
+			currentPeriod *= octave_scale;
+			++ octaveSeed;
+		}
+
+		if( renormalize && totalAmplitude > 0.f )
+		{
+			totalNoise = SIMD::div( totalNoise, SIMD::set1( totalAmplitude ) );
+			totalNoise = SIMD::add( SIMD::mul( totalNoise, SIMD::set1( 0.5f ) ), SIMD::set1( 0.5f ) );
+			totalNoise = SmoothStep3Lanes<SIMD>( totalNoise );
+			totalNoise = SIMD::sub( SIMD::mul( totalNoise, SIMD::set1( 2.0f ) ), SIMD::set1( 1.f ) );
+		}
+
+		SIMD::store( out_noise + index, totalNoise );
+	}
+
+	for( ; index < count; ++ index )
+	{
+		out_noise[index] = get_hashed_worley_noise_3d( Vector3( xs[index], ys[index], zs[index] ), scale, num_octaves, octave_persistence, octave_scale, renormalize, feature, period, seed );
+	}
+}
@@ -68,7 +68,7 @@ public:
 	friend float			CalcDistanceSquared(const Vector2& start, const Vector2& end);
 	friend const Vector2	operator*(float scale, const Vector2& vectorToScale);
 	friend float			DotProduct(const Vector2& a, const Vector2& b);
-	friend bool				AreMostlyEqual(const Vector2& a, const Vector2& b, float epsilon = 0.001f);
+	friend bool				AreMostlyEqual(const Vector2& a, const Vector2& b, float epsilon);
 	friend Vector2			Interpolate(const Vector2& start, const Vector2& end, float fractionToEnd);
 	friend Vector2			GetRandomDirection();
 	friend void				BounceVector2(Vector2& bounceVector, const Vector2& normal);
@@ -87,6 +87,8 @@ public:
 	static const Vector2	NEGATIVE_Y_AXIS;
 };
 
+bool AreMostlyEqual(const Vector2& a, const Vector2& b, float epsilon = 0.001f);
+
 inline
 Vector2::Vector2()
 {
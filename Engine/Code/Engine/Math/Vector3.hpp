@@ -54,7 +54,7 @@ public:
 	friend const Vector3	operator*(float scale, const Vector3& vectorToScale);
 	friend float			DotProduct(const Vector3& a, const Vector3& b);
 	friend Vector3			CrossProduct(const Vector3& a, const Vector3& b);
-	friend bool				AreMostlyEqual(const Vector3& a, const Vector3& b, float epsilon = 0.001f);
+	friend bool				AreMostlyEqual(const Vector3& a, const Vector3& b, float epsilon);
 	friend Vector3			Interpolate(const Vector3& start, const Vector3& end, float fractionToEnd);
 
 	friend float			calc_radians_angle_between(const Vector3& a, const Vector3& b);
@@ -68,6 +68,8 @@ public:
 	static const Vector3	Z_AXIS;
 };
 
+bool AreMostlyEqual(const Vector3& a, const Vector3& b, float epsilon = 0.001f);
+
 inline 
 Vector3::Vector3()
 {
@@ -37,6 +37,10 @@ void Vector4::GetXYZW(float &outX, float &outY, float &outZ, float &outW) const{
 	outW = w;
 }
 
+Vector3 Vector4::GetXYZ() const{
+	return Vector3(x, y, z);
+}
+
 const float* Vector4::GetAsFloatArray() const{
 	return &x;
 }
@@ -80,6 +84,12 @@ void Vector4::SetXYZW(float newX, float newY, float newZ, float newW){
 	w = newW;
 }
 
+void Vector4::SetXYZ(const Vector3& newXYZ){
+	x = newXYZ.x;
+	y = newXYZ.y;
+	z = newXYZ.z;
+}
+
 float Vector4::Normalize3D(){
 	float length = CalcLength3D();
 	if(length > 0.f){
@@ -12,11 +12,6 @@ public:
 			float x, y, z, w;
 		};
 
-		struct{
-			Vector3 xyz;
-			float w;
-		};
-
 		float values[4];
 	};
 
@@ -26,6 +21,7 @@ public:
 	explicit Vector4(float initialX, float initialY, float initialZ, float initialW);
 
 	void					GetXYZW(float &outX, float &outY, float &outZ, float &outW)												const;
+	Vector3					GetXYZ()																								const;
 	const float*			GetAsFloatArray()																						const;
 	float*					GetAsFloatArray();
 	float					CalcLength3D()																							const;
@@ -36,6 +32,7 @@ public:
 	bool					IsMostlyEqual(float compareX, float compareY, float compareZ, float compareW, float epsilon = 0.001f)	const;
 
 	void					SetXYZW(float newX, float newY, float newZ, float newW);
+	void					SetXYZ(const Vector3& newXYZ);
 	float					Normalize3D();
 	Vector4					Normalized3D()																							const;
 	float					Normalize4D();
@@ -67,12 +64,14 @@ public:
 	friend float			CalcDistanceSquared(const Vector4& start, const Vector4& end);
 	friend const Vector4	operator*(float scale, const Vector4& vectorToScale);
 	friend float			DotProduct(const Vector4& a, const Vector4& b);
-	friend bool				AreMostlyEqual(const Vector4& a, const Vector4& b, float epsilon = 0.001f);
+	friend bool				AreMostlyEqual(const Vector4& a, const Vector4& b, float epsilon);
 	friend Vector4			Interpolate(const Vector4& start, const Vector4& end, float fractionToEnd);
 
 	static const Vector4	ZERO;
 };
 
+bool AreMostlyEqual(const Vector4& a, const Vector4& b, float epsilon = 0.001f);
+
 template<>
 inline
 bool BinaryStream::write(const Vector4& v)
@@ -0,0 +1,139 @@
+#pragma once
+
+#include "Engine/Core/crt_compat.h"
+#include <immintrin.h>
+
+//-----------------------------------------------------
+// SIMD lane wrappers
+//
+// Thin static wrappers over SSE4.1 (4 wide) and AVX2 (8 wide) so batched
+// kernels can be written once as a template over the lane type and then
+// instantiated per instruction set. Keep the ops 1:1 with the intrinsics,
+// the kernels rely on the exact order of float ops to match scalar code.
+//
+// The AVX2 kernels must only be called after checking cpu_has_avx2(). With
+// gcc and clang only the *_avx2.cpp files are built with -mavx2, so simd8_t
+// is only there in those; everything else stays runnable on SSE4.1 machines.
+
+#define SIMD_ALIGN_BYTES 32
+
+struct simd4_t
+{
+    typedef __m128  vfloat;
+    typedef __m128i vint;
+    static const unsigned int WIDTH = 4;
+
+    static __forceinline vfloat load(const float* p)                    { return _mm_loadu_ps(p); }
+    static __forceinline vfloat load_u8(const unsigned char* p)         { return _mm_cvtepi32_ps(_mm_cvtepu8_epi32(_mm_cvtsi32_si128(*(const int*)p))); } // 4 bytes widened to float
+    static __forceinline void   store(float* p, vfloat a)               { _mm_storeu_ps(p, a); }
+    static __forceinline vint   load_int(const int* p)                  { return _mm_loadu_si128((const __m128i*)p); }
+    static __forceinline void   store_int(int* p, vint a)               { _mm_storeu_si128((__m128i*)p, a); }
+    static __forceinline vfloat set1(float f)                           { return _mm_set1_ps(f); }
+    static __forceinline vint   set1_int(int i)                         { return _mm_set1_epi32(i); }
+    static __forceinline vfloat zero()                                  { return _mm_setzero_ps(); }
+
+    static __forceinline vfloat add(vfloat a, vfloat b)                 { return _mm_add_ps(a, b); }
+    static __forceinline vfloat sub(vfloat a, vfloat b)                 { return _mm_sub_ps(a, b); }
+    static __forceinline vfloat mul(vfloat a, vfloat b)                 { return _mm_mul_ps(a, b); }
+    static __forceinline vfloat div(vfloat a, vfloat b)                 { return _mm_div_ps(a, b); }
+    static __forceinline vfloat min(vfloat a, vfloat b)                 { return _mm_min_ps(a, b); }
+    static __forceinline vfloat max(vfloat a, vfloat b)                 { return _mm_max_ps(a, b); }
+    static __forceinline vfloat sqrt(vfloat a)                          { return _mm_sqrt_ps(a); }
+    static __forceinline vfloat floor(vfloat a)                         { return _mm_floor_ps(a); }
+    static __forceinline vfloat bit_and(vfloat a, vfloat b)             { return _mm_and_ps(a, b); }
+    static __forceinline vfloat bit_or(vfloat a, vfloat b)              { return _mm_or_ps(a, b); }
+    static __forceinline vfloat bit_xor(vfloat a, vfloat b)             { return _mm_xor_ps(a, b); }
+    static __forceinline vfloat cmp_lt(vfloat a, vfloat b)              { return _mm_cmplt_ps(a, b); }
+    static __forceinline vfloat cmp_le(vfloat a, vfloat b)              { return _mm_cmple_ps(a, b); }
+    static __forceinline vfloat cmp_gt(vfloat a, vfloat b)              { return _mm_cmpgt_ps(a, b); }
+    static __forceinline vfloat select(vfloat mask, vfloat a, vfloat b) { return _mm_blendv_ps(b, a, mask); } // mask ? a : b
+    static __forceinline int    move_mask(vfloat a)                     { return _mm_movemask_ps(a); }
+
+    static __forceinline vint   add_int(vint a, vint b)                 { return _mm_add_epi32(a, b); }
+    static __forceinline vint   sub_int(vint a, vint b)                 { return _mm_sub_epi32(a, b); }
+    static __forceinline vint   mul_int(vint a, vint b)                 { return _mm_mullo_epi32(a, b); }
+    static __forceinline vint   and_int(vint a, vint b)                 { return _mm_and_si128(a, b); }
+    static __forceinline vint   xor_int(vint a, vint b)                 { return _mm_xor_si128(a, b); }
+    static __forceinline vint   min_int(vint a, vint b)                 { return _mm_min_epi32(a, b); }
+    static __forceinline vint   max_int(vint a, vint b)                 { return _mm_max_epi32(a, b); }
+    static __forceinline vint   cmp_eq_int(vint a, vint b)              { return _mm_cmpeq_epi32(a, b); }
+    template<int BITS>
+    static __forceinline vint   shift_left(vint a)                      { return _mm_slli_epi32(a, BITS); }
+    template<int BITS>
+    static __forceinline vint   shift_right(vint a)                     { return _mm_srli_epi32(a, BITS); } // logical
+
+    static __forceinline vint   to_int_truncate(vfloat a)               { return _mm_cvttps_epi32(a); }
+    static __forceinline vfloat to_float(vint a)                        { return _mm_cvtepi32_ps(a); }
+    static __forceinline vfloat as_float(vint a)                        { return _mm_castsi128_ps(a); }
+    static __forceinline vint   as_int(vfloat a)                        { return _mm_castps_si128(a); }
+
+    static __forceinline vfloat gather(const float* base, vint indices)
+    {
+        alignas(16) int idx[4];
+        _mm_store_si128((__m128i*)idx, indices);
+        return _mm_set_ps(base[idx[3]], base[idx[2]], base[idx[1]], base[idx[0]]);
+    }
+
+    static __forceinline vint gather_int(const int* base, vint indices)
+    {
+        alignas(16) int idx[4];
+        _mm_store_si128((__m128i*)idx, indices);
+        return _mm_set_epi32(base[idx[3]], base[idx[2]], base[idx[1]], base[idx[0]]);
+    }
+};
+
+#if defined(_MSC_VER) || defined(__AVX2__)
+struct simd8_t
+{
+    typedef __m256  vfloat;
+    typedef __m256i vint;
+    static const unsigned int WIDTH = 8;
+
+    static __forceinline vfloat load(const float* p)                    { return _mm256_loadu_ps(p); }
+    static __forceinline vfloat load_u8(const unsigned char* p)         { return _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)p))); } // 8 bytes widened to float
+    static __forceinline void   store(float* p, vfloat a)               { _mm256_storeu_ps(p, a); }
+    static __forceinline vint   load_int(const int* p)                  { return _mm256_loadu_si256((const __m256i*)p); }
+    static __forceinline void   store_int(int* p, vint a)               { _mm256_storeu_si256((__m256i*)p, a); }
+    static __forceinline vfloat set1(float f)                           { return _mm256_set1_ps(f); }
+    static __forceinline vint   set1_int(int i)                         { return _mm256_set1_epi32(i); }
+    static __forceinline vfloat zero()                                  { return _mm256_setzero_ps(); }
+
+    static __forceinline vfloat add(vfloat a, vfloat b)                 { return _mm256_add_ps(a, b); }
+    static __forceinline vfloat sub(vfloat a, vfloat b)                 { return _mm256_sub_ps(a, b); }
+    static __forceinline vfloat mul(vfloat a, vfloat b)                 { return _mm256_mul_ps(a, b); }
+    static __forceinline vfloat div(vfloat a, vfloat b)                 { return _mm256_div_ps(a, b); }
+    static __forceinline vfloat min(vfloat a, vfloat b)                 { return _mm256_min_ps(a, b); }
+    static __forceinline vfloat max(vfloat a, vfloat b)                 { return _mm256_max_ps(a, b); }
+    static __forceinline vfloat sqrt(vfloat a)                          { return _mm256_sqrt_ps(a); }
+    static __forceinline vfloat floor(vfloat a)                         { return _mm256_floor_ps(a); }
+    static __forceinline vfloat bit_and(vfloat a, vfloat b)             { return _mm256_and_ps(a, b); }
+    static __forceinline vfloat bit_or(vfloat a, vfloat b)              { return _mm256_or_ps(a, b); }
+    static __forceinline vfloat bit_xor(vfloat a, vfloat b)             { return _mm256_xor_ps(a, b); }
+    static __forceinline vfloat cmp_lt(vfloat a, vfloat b)              { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+    static __forceinline vfloat cmp_le(vfloat a, vfloat b)              { return _mm256_cmp_ps(a, b, _CMP_LE_OQ); }
+    static __forceinline vfloat cmp_gt(vfloat a, vfloat b)              { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+    static __forceinline vfloat select(vfloat mask, vfloat a, vfloat b) { return _mm256_blendv_ps(b, a, mask); } // mask ? a : b
+    static __forceinline int    move_mask(vfloat a)                     { return _mm256_movemask_ps(a); }
+
+    static __forceinline vint   add_int(vint a, vint b)                 { return _mm256_add_epi32(a, b); }
+    static __forceinline vint   sub_int(vint a, vint b)                 { return _mm256_sub_epi32(a, b); }
+    static __forceinline vint   mul_int(vint a, vint b)                 { return _mm256_mullo_epi32(a, b); }
+    static __forceinline vint   and_int(vint a, vint b)                 { return _mm256_and_si256(a, b); }
+    static __forceinline vint   xor_int(vint a, vint b)                 { return _mm256_xor_si256(a, b); }
+    static __forceinline vint   min_int(vint a, vint b)                 { return _mm256_min_epi32(a, b); }
+    static __forceinline vint   max_int(vint a, vint b)                 { return _mm256_max_epi32(a, b); }
+    static __forceinline vint   cmp_eq_int(vint a, vint b)              { return _mm256_cmpeq_epi32(a, b); }
+    template<int BITS>
+    static __forceinline vint   shift_left(vint a)                      { return _mm256_slli_epi32(a, BITS); }
+    template<int BITS>
+    static __forceinline vint   shift_right(vint a)                     { return _mm256_srli_epi32(a, BITS); } // logical
+
+    static __forceinline vint   to_int_truncate(vfloat a)               { return _mm256_cvttps_epi32(a); }
+    static __forceinline vfloat to_float(vint a)                        { return _mm256_cvtepi32_ps(a); }
+    static __forceinline vfloat as_float(vint a)                        { return _mm256_castsi256_ps(a); }
+    static __forceinline vint   as_int(vfloat a)                        { return _mm256_castps_si256(a); }
+
+    static __forceinline vfloat gather(const float* base, vint indices)   { return _mm256_i32gather_ps(base, indices, 4); }
+    static __forceinline vint   gather_int(const int* base, vint indices) { return _mm256_i32gather_epi32(base, indices, 4); }
+};
+#endif
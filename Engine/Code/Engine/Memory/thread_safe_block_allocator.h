@@ -21,9 +21,9 @@ public:
     CriticalSection lock;
 
 public:
-    ThreadSafeBlockAllocator::ThreadSafeBlockAllocator(size_t bs);
-    ThreadSafeBlockAllocator::~ThreadSafeBlockAllocator();
+    ThreadSafeBlockAllocator(size_t bs);
+    ~ThreadSafeBlockAllocator();
 
-    void* ThreadSafeBlockAllocator::alloc(size_t size);
-    void ThreadSafeBlockAllocator::free(void *ptr);
+    void* alloc(size_t size);
+    void free(void *ptr);
 };
@@ -12,8 +12,6 @@
 
 #pragma warning(disable:4505)
 
-static uint64_t s_perf_freq;
-
 enum class ProfilerEventType
 {
     PUSH,
@@ -166,24 +164,6 @@ static void profiler_handle_events()
     }
 }
 
-uint64_t get_current_perf_counter()
-{
-    uint64_t counter;
-    QueryPerformanceCounter((LARGE_INTEGER*)&counter);
-    return counter;
-}
-
-double perf_counter_to_seconds(uint64_t counter)
-{
-    static bool get_freq = false;
-    if(!get_freq){
-        QueryPerformanceFrequency((LARGE_INTEGER*)&s_perf_freq);
-        get_freq = true;
-    }
-
-    return (double)counter / (double)s_perf_freq;
-}
-
 #if defined(PROFILED_BUILD)
 
 void main_profiler_thread(void* data)
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Engine/Config/build_config.h"
+#include "Engine/Core/Time.hpp"
 #include "Engine/Profile/auto_profile_scope.h"
 #include "Engine/Profile/auto_profile_log_scope.h"
 #include "Engine/Profile/thread_profile.h"
@@ -9,9 +10,6 @@
 #include <memory>
 #include <vector>
 
-uint64_t                            get_current_perf_counter();
-double                              perf_counter_to_seconds(uint64_t counter);
-
 void                                profiler_init();
 void                                profiler_shutdown();
 void                                profiler_set_thread_name(const thread_id_t& id, const char* name);
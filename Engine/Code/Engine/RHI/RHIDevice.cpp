@@ -188,6 +188,10 @@ RHITexture2D* RHIDevice::load_rhitexture2d_async(const std::string& filename, te
     Job* image_to_texture_job = job_create(JOB_TYPE_RENDERING, load_texture_from_image_job, job_data);
     Job* cleanup_job = job_create(JOB_TYPE_GENERIC, cleanup_resources_job, job_data);
 
+    // Nothing waits on the file read, it shouldn't hold up frame work
+    job_set_priority(load_image_job, JOB_PRIORITY_BACKGROUND);
+    job_set_priority(cleanup_job, JOB_PRIORITY_BACKGROUND);
+
     if(nullptr != cb){
         Job* cb_job = job_create(JOB_TYPE_MAIN, call_texture_loaded_cb, cb, job_data);
         cb_job->depends_on(image_to_texture_job);
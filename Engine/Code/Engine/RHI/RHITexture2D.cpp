@@ -1,6 +1,7 @@
 #include "Engine/RHI/RHITexture2D.hpp"
 #include "Engine/RHI/RHIDevice.hpp"
 #include "Engine/RHI/RHIOutput.hpp"
+#include "Engine/RHI/RHIDeviceContext.hpp"
 #include "Engine/RHI/DX11.hpp"
 #include "Engine/Engine.hpp"
 
@@ -311,6 +312,22 @@ bool RHITexture2D::LoadFromPerlinNoise(const unsigned int width,
 	return m_dxShaderResourceView != nullptr;
 }
 
+void RHITexture2D::UpdateRegionRGBA8(unsigned int x, unsigned int y, unsigned int width, unsigned int height, const void* data, size_t row_pitch)
+{
+	if((nullptr == m_dxTexture2D) || (width == 0) || (height == 0)){
+		return;
+	}
+
+	D3D11_BOX box;
+	box.left = x;
+	box.top = y;
+	box.front = 0;
+	box.right = x + width;
+	box.bottom = y + height;
+	box.back = 1;
+	m_device->m_immediateContext->m_dxDeviceContext->UpdateSubresource(m_dxTexture2D, 0, &box, data, (UINT)row_pitch, 0);
+}
+
 void RHITexture2D::CreateViews()
 {
 	if (m_dxBindFlags & D3D11_BIND_RENDER_TARGET){
@@ -45,6 +45,11 @@ public:
 	bool LoadFromImage(const Image& image);
 	bool LoadFromColor(const Rgba& color);
 
+	// Overwrites the <width> x <height> texels at <x, y> from tightly packed RGBA8
+	// rows <row_pitch> bytes apart. Needs a DEFAULT usage RGBA8 texture, like
+	// the width/height/format constructor makes.
+	void UpdateRegionRGBA8(unsigned int x, unsigned int y, unsigned int width, unsigned int height, const void* data, size_t row_pitch);
+
 	bool LoadFromPerlinNoise(const unsigned int width, 
 							 const unsigned int height, 
 							 const bool greyscale = false, 
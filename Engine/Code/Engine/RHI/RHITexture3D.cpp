@@ -7,6 +7,9 @@
 
 #include "Engine/Core/ErrorWarningAssert.hpp"
 #include "Engine/Math/Noise.hpp"
+#include "Engine/Volume/volume_file.h"
+#include "Engine/Volume/volume_fill.h"
+#include "Engine/Volume/volume_mips.h"
 
 #include "Engine/Core/FileUtils.hpp"
 
@@ -58,46 +61,13 @@ RHITexture3D::~RHITexture3D()
 
 bool RHITexture3D::LoadFromFilenameRGBA8(const char* filename, unsigned int width, unsigned int height, unsigned int depth)
 {
-	destroy_current_views();
-
-	m_width = width;
-	m_height = height;
-    m_depth = depth;
-
-	m_dxBindFlags = make_bind_flags();
-	D3D11_TEXTURE3D_DESC tex_desc = make_desc();
-
-    std::vector<unsigned char> image_data;
-    LoadBinaryFileToBuffer(filename, image_data);
-
-	// Setup Initial Data
-	D3D11_SUBRESOURCE_DATA data;
-	D3D11_SUBRESOURCE_DATA* data_ptr = nullptr;
-
-	unsigned int pitch = m_width * 4;
-    unsigned int depth_pitch = m_height * m_width * 4;
-
-	if(!m_generate_mips){
-		memset(&data, 0, sizeof(data));
-
-		data.pSysMem = image_data.data();
-		data.SysMemPitch = pitch;
-	    data.SysMemSlicePitch = depth_pitch;
-		data_ptr = &data;
-	}
-
-	HRESULT result = m_device->m_dxDevice->CreateTexture3D(&tex_desc, data_ptr, &m_dxTexture3D);
-	if (SUCCEEDED(result)){
-		CreateViews();
-	}
-
-	if(m_generate_mips){
-		m_device->m_immediateContext->m_dxDeviceContext->UpdateSubresource(m_dxTexture3D, 0, NULL, image_data.data(), pitch, depth_pitch);
-	    m_device->m_immediateContext->m_dxDeviceContext->GenerateMips(m_dxShaderResourceView);
+	// Headerless legacy files, see LoadFromVolumeFile for the self-describing format
+	volume_buffer_t volume;
+	if(!volume_file_load_raw(filename, VOLUME_FORMAT_RGBA8, width, height, depth, &volume)){
+		return false;
 	}
 
-	// If we actually generated a shader resource view, then we succeeded
-	return m_dxShaderResourceView != nullptr;
+	return LoadFromVolumeRGBA8(volume);
 }
 
 bool RHITexture3D::LoadFromColor(const Rgba& color)
@@ -187,55 +157,6 @@ bool RHITexture3D::LoadFromNoiseSingleChannel(unsigned int width, unsigned int h
 	return m_dxShaderResourceView != nullptr;
 }
 
-#include "Engine/Thread/thread.h"
-
-struct noise_data
-{
-    unsigned int w;
-    unsigned int h;
-    unsigned int d;
-
-    unsigned int from_slice;
-    unsigned int to_slice;
-
-    unsigned char* data;
-
-    noise_func r_noise;
-    noise_func g_noise;
-    noise_func b_noise;
-    noise_func a_noise;
-};
-
-void make_some_noise(void* data)
-{
-    noise_data* nd = (noise_data*)data;
-
-    for(unsigned int z = nd->from_slice; z <= nd->to_slice; ++z){
-    	for (unsigned int y = 0; y < nd->h; ++y){
-    		for (unsigned int x = 0; x < nd->w; ++x){
-    			int index = (z * nd->w * nd->h) + (y * nd->w) + x;
-    			index *= 4;
-
-                float x_f = (float)x;
-                float y_f = (float)y;
-                float z_f = (float)z;
-
-				float r = Clamp(nd->r_noise(x_f, y_f, z_f), 0.0f, 1.0f);
-				float g = Clamp(nd->g_noise(x_f, y_f, z_f), 0.0f, 1.0f);
-				float b = Clamp(nd->b_noise(x_f, y_f, z_f), 0.0f, 1.0f);
-    			float a = Clamp(nd->a_noise(x_f, y_f, z_f), 0.0f, 1.0f);
-
-				nd->data[index]     = (unsigned char)MapFloatToRange(r, 0.0f, 1.0f, 0.0f, 255.0f);
-				nd->data[index + 1] = (unsigned char)MapFloatToRange(g, 0.0f, 1.0f, 0.0f, 255.0f);
-				nd->data[index + 2] = (unsigned char)MapFloatToRange(b, 0.0f, 1.0f, 0.0f, 255.0f);
-    			nd->data[index + 3] = (unsigned char)MapFloatToRange(a, 0.0f, 1.0f, 0.0f, 255.0f);
-
-            }
-		}
-	}
-
-}
-
 #include "Engine/Profile/profiler.h"
 
 bool RHITexture3D::LoadFromNoiseMultichannel(unsigned int width, 
@@ -248,74 +169,132 @@ bool RHITexture3D::LoadFromNoiseMultichannel(unsigned int width,
 {
     PROFILE_LOG_SCOPE_FUNCTION();
 
-	m_width = width;
-	m_height = height;
-	m_depth = depth;
+    volume_buffer_t volume;
+    volume_fill_rgba8(&volume, width, height, depth, r_noise, g_noise, b_noise, a_noise);
 
-	unsigned int numTexels = width * height * depth;
-	unsigned int colorChannelsPerTexel = 4; // RGBA
-	
-	// Actually generate the noise
-	unsigned char* textureNoiseData = new unsigned char[numTexels * colorChannelsPerTexel];
-    const int NUM_THREADS = 8;
-    thread_handle_t threads[NUM_THREADS];
+    return LoadFromVolumeRGBA8(volume);
+}
+
+bool RHITexture3D::LoadFromVolumeRGBA8(const volume_buffer_t& volume)
+{
+	volume_view_t view = volume.get_view();
+	return LoadFromVolumeViews(&view, 1, DXGI_FORMAT_R8G8B8A8_UNORM);
+}
+
+bool RHITexture3D::LoadFromVolumeFile(const char* filename)
+{
+	PROFILE_LOG_SCOPE_FUNCTION();
 
-    int slices_per_thread = depth / NUM_THREADS;
+	volume_file_t file;
+	if(!volume_file_open(&file, filename)){
+		return false;
+	}
 
-    for(int i = 0; i < NUM_THREADS; i++){
-        noise_data* d = new noise_data();
+	bool loaded = LoadFromVolumeFile(file);
+	volume_file_close(&file);
+	return loaded;
+}
 
-        d->w = width;
-        d->h = height;
-        d->d = depth;
+bool RHITexture3D::LoadFromVolumeFile(const volume_file_t& file)
+{
+	// Views point into the mapping, the upload reads the file pages directly.
+	// Compressed mips are decoded first, the device only sees plain voxels.
+	VolumeFormat format = volume_file_get_format(file);
+	volume_view_t mips[VOLUME_FILE_MAX_MIPS];
+	std::vector<volume_buffer_t> decoded;
+	unsigned int num_mips = volume_file_get_num_mips(file);
+	if(volume_format_is_compressed(format)){
+		decoded.resize(num_mips);
+		for(unsigned int i = 0; i < num_mips; ++i){
+			if(!volume_file_copy_mip(file, i, &decoded[i])){
+				return false;
+			}
+			mips[i] = decoded[i].get_view();
+		}
+	}else{
+		for(unsigned int i = 0; i < num_mips; ++i){
+			mips[i] = volume_file_get_mip(file, i);
+		}
+	}
 
-        d->data = textureNoiseData;
+	return LoadFromVolumeViews(mips, num_mips, get_dx_format(volume_format_get_decoded(format)));
+}
 
-        d->from_slice = i * slices_per_thread;
-        d->to_slice = d->from_slice + slices_per_thread - 1;
+bool RHITexture3D::LoadFromVolumeViews(const volume_view_t* mips, unsigned int num_mips, DXGI_FORMAT format)
+{
+	const volume_view_t& top = mips[0];
+	ID3D11DeviceContext* dx_context = m_device->m_immediateContext->m_dxDeviceContext;
 
-        d->r_noise = r_noise;
-        d->g_noise = g_noise;
-        d->b_noise = b_noise;
-        d->a_noise = a_noise;
+	for(unsigned int i = 0; i < num_mips; ++i){
+		if(mips[i].layout != VOLUME_LAYOUT_LINEAR){
+			return false;
+		}
+	}
 
-        threads[i] = thread_create(make_some_noise, (void*)d);
-    }
+	// Textures made any other way never set m_dxFormat, and those are all RGBA8
+	DXGI_FORMAT current_format = (m_dxFormat == DXGI_FORMAT_UNKNOWN) ? DXGI_FORMAT_R8G8B8A8_UNORM : m_dxFormat;
 
-    for(int i = 0; i < NUM_THREADS; i++){
-        thread_join(threads[i]);
-    }
+	// Same size and updatable, patch it in place so existing views stay valid
+	bool same_size = (m_width == top.width) && (m_height == top.height) && (m_depth == top.depth) && (current_format == format);
+	if(!IsValid() || !same_size || !m_generate_mips){
+		destroy_current_views();
 
-	m_dxBindFlags = make_bind_flags();
-	D3D11_TEXTURE3D_DESC tex_desc = make_desc();
+		m_width = top.width;
+		m_height = top.height;
+		m_depth = top.depth;
+		m_dxFormat = format;
 
-	// Setup Initial Data
-	D3D11_SUBRESOURCE_DATA data;
-	D3D11_SUBRESOURCE_DATA* data_ptr = nullptr;
+		// Immutable textures take whatever chain was provided, generated ones always get a full chain
+		if(!m_generate_mips){
+			m_mip_levels = num_mips;
+		}
 
-	uint pitch = width * colorChannelsPerTexel;
-	uint depth_pitch = height * pitch;
+		m_dxBindFlags = make_bind_flags();
+		D3D11_TEXTURE3D_DESC tex_desc = make_desc();
+		tex_desc.Format = format;
+
+		// Setup Initial Data
+		D3D11_SUBRESOURCE_DATA data[VOLUME_FILE_MAX_MIPS];
+		D3D11_SUBRESOURCE_DATA* data_ptr = nullptr;
+
+		if(!m_generate_mips){
+			memset(data, 0, sizeof(data));
+			for(unsigned int i = 0; i < num_mips; ++i){
+				data[i].pSysMem = mips[i].data;
+				data[i].SysMemPitch = (uint)mips[i].row_pitch;
+				data[i].SysMemSlicePitch = (uint)mips[i].slice_pitch;
+			}
+			data_ptr = data;
+		}
 
-	if(!m_generate_mips){
-		memset(&data, 0, sizeof(data));
-		data.pSysMem = textureNoiseData;
-		data.SysMemPitch = pitch;
-	    data.SysMemSlicePitch = depth_pitch;
-		data_ptr = &data;
+		HRESULT result = m_device->m_dxDevice->CreateTexture3D(&tex_desc, data_ptr, &m_dxTexture3D);
+		if (SUCCEEDED(result)){
+			CreateViews();
+		}
+
+		if(!m_generate_mips){
+			// If we actually generated a shader resource view, then we succeeded
+			return m_dxShaderResourceView != nullptr;
+		}
 	}
 
-	HRESULT result = m_device->m_dxDevice->CreateTexture3D(&tex_desc, data_ptr, &m_dxTexture3D);
-	if (SUCCEEDED(result)){
-		CreateViews();
+	if(nullptr == m_dxShaderResourceView){
+		return false;
 	}
 
-	if(m_generate_mips){
-		m_device->m_immediateContext->m_dxDeviceContext->UpdateSubresource(m_dxTexture3D, 0, NULL, textureNoiseData, pitch, depth_pitch);
-	    m_device->m_immediateContext->m_dxDeviceContext->GenerateMips(m_dxShaderResourceView);
+	// Upload every mip we were given, only fall back to the GPU when the chain is short
+	D3D11_TEXTURE3D_DESC created_desc;
+	m_dxTexture3D->GetDesc(&created_desc);
+
+	unsigned int num_uploaded = (num_mips < created_desc.MipLevels) ? num_mips : created_desc.MipLevels;
+	for(unsigned int i = 0; i < num_uploaded; ++i){
+		dx_context->UpdateSubresource(m_dxTexture3D, i, NULL, mips[i].data, (uint)mips[i].row_pitch, (uint)mips[i].slice_pitch);
 	}
 
-	// If we actually generated a shader resource view, then we succeeded
-	return m_dxShaderResourceView != nullptr;
+	if(num_uploaded < created_desc.MipLevels){
+	    dx_context->GenerateMips(m_dxShaderResourceView);
+	}
+	return true;
 }
 
 void RHITexture3D::CreateViews()
@@ -335,25 +314,82 @@ void RHITexture3D::CreateViews()
 	}
 }
 
-void RHITexture3D::save_to_file(const char* filename)
+bool RHITexture3D::save_to_file(const char* filename, VolumeMipFilter filter)
 {
-	UNUSED(filename);
-	/* old save code, need to use staging texture method to be correct though
-    // SAVE TEXTURE TO FILE
-    {
-        size_t size = width * height * depth * 4;
+	PROFILE_LOG_SCOPE_FUNCTION();
 
-        std::vector<unsigned char> test;
-        test.resize(size);
-        memcpy(test.data(), textureNoiseData, size);
+	DXGI_FORMAT dx_format = (m_dxFormat == DXGI_FORMAT_UNKNOWN) ? DXGI_FORMAT_R8G8B8A8_UNORM : m_dxFormat;
+	VolumeFormat format;
+	if(!IsValid() || !get_volume_format(dx_format, &format)){
+		return false;
+	}
 
-        SaveBufferToBinaryFile("3d_noise.texture", test);
-    }
+	// Copy the top level somewhere the CPU can read it
+	D3D11_TEXTURE3D_DESC staging_desc;
+	memset(&staging_desc, 0, sizeof(staging_desc));
+	staging_desc.Width = m_width;
+	staging_desc.Height = m_height;
+	staging_desc.Depth = m_depth;
+	staging_desc.MipLevels = 1;
+	staging_desc.Format = dx_format;
+	staging_desc.Usage = D3D11_USAGE_STAGING;
+	staging_desc.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
+
+	ID3D11Texture3D* staging = nullptr;
+	HRESULT result = m_device->m_dxDevice->CreateTexture3D(&staging_desc, nullptr, &staging);
+	if(FAILED(result)){
+		return false;
+	}
 
-	// Free up the dynamic memory we allocated to store the perlin noise in
-	delete[] textureNoiseData;
-	*/
+	ID3D11DeviceContext* dx_context = m_device->m_immediateContext->m_dxDeviceContext;
+	dx_context->CopySubresourceRegion(staging, 0, 0, 0, 0, m_dxTexture3D, 0, nullptr);
 
+	D3D11_MAPPED_SUBRESOURCE mapped;
+	result = dx_context->Map(staging, 0, D3D11_MAP_READ, 0, &mapped);
+	if(FAILED(result)){
+		DX_SAFE_RELEASE(staging);
+		return false;
+	}
+
+	// Driver pitches can be padded, repack into a linear volume
+	volume_buffer_t volume;
+	volume.resize(m_width, m_height, m_depth, volume_format_get_bytes_per_voxel(format));
+	for(unsigned int z = 0; z < m_depth; ++z){
+		for(unsigned int y = 0; y < m_height; ++y){
+			const unsigned char* src = (const unsigned char*)mapped.pData + (z * mapped.DepthPitch) + (y * mapped.RowPitch);
+			memcpy(volume.get_voxel(0, y, z), src, volume.get_row_pitch());
+		}
+	}
+
+	dx_context->Unmap(staging, 0);
+	DX_SAFE_RELEASE(staging);
+
+	// Lower mips are rebuilt on the CPU rather than read back, so the file gets the filter asked for
+	std::vector<volume_buffer_t> mips;
+	volume_mips_build(volume.get_view(), format, filter, &mips);
+
+	std::vector<volume_view_t> views;
+	volume_mips_get_views(volume.get_view(), mips, &views);
+	return volume_file_save(filename, format, views.data(), (unsigned int)views.size());
+}
+
+DXGI_FORMAT RHITexture3D::get_dx_format(VolumeFormat format)
+{
+	switch(format){
+		case VOLUME_FORMAT_R8:		return DXGI_FORMAT_R8_UNORM;
+		case VOLUME_FORMAT_R16F:	return DXGI_FORMAT_R16_FLOAT;
+		default:					return DXGI_FORMAT_R8G8B8A8_UNORM;
+	}
+}
+
+bool RHITexture3D::get_volume_format(DXGI_FORMAT dx_format, VolumeFormat* out_format)
+{
+	switch(dx_format){
+		case DXGI_FORMAT_R8G8B8A8_UNORM:	*out_format = VOLUME_FORMAT_RGBA8;	return true;
+		case DXGI_FORMAT_R8_UNORM:			*out_format = VOLUME_FORMAT_R8;		return true;
+		case DXGI_FORMAT_R16_FLOAT:			*out_format = VOLUME_FORMAT_R16F;	return true;
+		default:							return false;
+	}
 }
 
 D3D11_TEXTURE3D_DESC RHITexture3D::make_desc()
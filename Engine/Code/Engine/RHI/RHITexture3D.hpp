@@ -5,6 +5,7 @@
 #include <map>
 
 #include "Engine/RHI/DX11.hpp"
+#include "Engine/Volume/volume_mips.h"
 
 class RHIDevice;
 class RHIOutput;
@@ -52,9 +53,30 @@ class RHITexture3D : public RHITextureBase
 	                                   noise_func b_noise, 
 	                                   noise_func a_noise);
 
+		// Uploads a CPU-side RGBA8 volume (see volume_fill.h). Updates in place when
+		// the texture already exists at that size and was created with m_generate_mips.
+		bool LoadFromVolumeRGBA8(const volume_buffer_t& volume);
+
+		// Maps a volume file (see volume_file.h) and uploads straight from the mapping.
+		// Size, format and any stored mips come from the file header.
+		bool LoadFromVolumeFile(const char* filename);
+
+		// Same for a file that's already open, e.g. a volume_cache_open entry
+		bool LoadFromVolumeFile(const volume_file_t& file);
+
+		// <mips> largest first. Uploads every level given and lets the GPU build the rest
+		// when m_generate_mips is set, otherwise the texture gets exactly <num_mips> levels.
+		// Linear views only, see volume_convert_layout.
+		bool LoadFromVolumeViews(const volume_view_t* mips, unsigned int num_mips, DXGI_FORMAT format);
+
 		void CreateViews();
 
-	    void save_to_file(const char* filename);
+		// Reads the top level back, builds the rest of the chain on the CPU and writes
+		// a volume file, so loading it later never has to generate mips
+		bool save_to_file(const char* filename, VolumeMipFilter filter = VOLUME_MIP_FILTER_KAISER);
+
+		static DXGI_FORMAT get_dx_format(VolumeFormat format);
+		static bool get_volume_format(DXGI_FORMAT dx_format, VolumeFormat* out_format);
 
 		D3D11_TEXTURE3D_DESC make_desc();
 		uint make_bind_flags();
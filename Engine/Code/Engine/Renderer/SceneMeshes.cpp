@@ -4,21 +4,21 @@ void Meshes::build_scene_axes(MeshBuilder& mb, const Matrix4& local_to_world, fl
 {
 	Matrix4 world_to_local = local_to_world.transposed();
 
-	Vector3 origin = local_to_world.get_translation().xyz;
+	Vector3 origin = local_to_world.get_translation().GetXYZ();
 
 	mb.begin(PRIMITIVE_LINES, false);
 
 	mb.set_color(Rgba::RED);
 	mb.add_vertex(origin);
-	mb.add_vertex(origin + world_to_local.apply_transformation(Vector4(Vector3::X_AXIS, 0.0f)).xyz * axis_length);
+	mb.add_vertex(origin + world_to_local.apply_transformation(Vector4(Vector3::X_AXIS, 0.0f)).GetXYZ() * axis_length);
 
 	mb.set_color(Rgba::GREEN);
 	mb.add_vertex(origin);
-	mb.add_vertex(origin + world_to_local.apply_transformation(Vector4(Vector3::Y_AXIS, 0.0f)).xyz * axis_length);
+	mb.add_vertex(origin + world_to_local.apply_transformation(Vector4(Vector3::Y_AXIS, 0.0f)).GetXYZ() * axis_length);
 
 	mb.set_color(Rgba::BLUE);
 	mb.add_vertex(origin);
-	mb.add_vertex(origin + world_to_local.apply_transformation(Vector4(Vector3::Z_AXIS, 0.0f)).xyz * axis_length);
+	mb.add_vertex(origin + world_to_local.apply_transformation(Vector4(Vector3::Z_AXIS, 0.0f)).GetXYZ() * axis_length);
 
 	mb.end();
 }
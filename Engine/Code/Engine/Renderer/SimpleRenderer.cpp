@@ -337,7 +337,7 @@ void SimpleRenderer::SetProjection(const Matrix4& projection)
 
 void SimpleRenderer::SetEyePosition(const Vector3& eye)
 {
-	m_lightBufferData.cameraEyePosition.xyz = eye;
+	m_lightBufferData.cameraEyePosition.SetXYZ(eye);
 	m_lightBuffer->Update(m_deviceContext, &m_lightBufferData);
 }
 
@@ -353,7 +353,7 @@ void SimpleRenderer::SetDirectionalLight(unsigned int index, const Vector3& dire
 	ASSERT_OR_DIE(index < MAX_DIRECTIONAL_LIGHTS, Stringf("Trying to enable invalid directional light index. Max index is %u\n", MAX_DIRECTIONAL_LIGHTS - 1));
 
 	// Set the direction
-	m_lightBufferData.directionalLights[index].direction.xyz = direction;
+	m_lightBufferData.directionalLights[index].direction.SetXYZ(direction);
 	
 	// Set the color & intensity
 	color.GetAsFloats(&m_lightBufferData.directionalLights[index].color.x);
@@ -384,10 +384,10 @@ void SimpleRenderer::SetPointLight(unsigned int index, const Vector3& position,
 	m_lightBufferData.pointLights[index].color.w = intensity;
 
 	// Set the attunuation
-	m_lightBufferData.pointLights[index].attenuation.xyz = attenuation;
+	m_lightBufferData.pointLights[index].attenuation.SetXYZ(attenuation);
 
 	// Set the spec attenuation
-	m_lightBufferData.pointLights[index].specAttenuation.xyz = specAttenuation;
+	m_lightBufferData.pointLights[index].specAttenuation.SetXYZ(specAttenuation);
 
 	// Update the buffer
 	m_lightBuffer->Update(m_deviceContext, &m_lightBufferData);
@@ -916,7 +916,7 @@ void SimpleRenderer::DebugDrawDirectionalLights()
 	for(int dirLightIndex = 0; dirLightIndex < MAX_DIRECTIONAL_LIGHTS; ++dirLightIndex){
 		const DirectionalLight& dirLight = m_lightBufferData.directionalLights[dirLightIndex];
 
-		DebugDrawCross3d(dirLight.direction.xyz * -5.0f, Rgba(dirLight.color), 0.25f );
+		DebugDrawCross3d(dirLight.direction.GetXYZ() * -5.0f, Rgba(dirLight.color), 0.25f );
 	}
 }
 
@@ -927,7 +927,7 @@ void SimpleRenderer::DebugDrawPointLights()
 
 	for(int pointLightIndex = 0; pointLightIndex < MAX_POINT_LIGHTS; ++pointLightIndex){
 		const PointLight& light = m_lightBufferData.pointLights[pointLightIndex];
-		DebugDrawCross3d(light.position.xyz, Rgba(light.color), 0.25f);
+		DebugDrawCross3d(light.position.GetXYZ(), Rgba(light.color), 0.25f);
 	}
 }
 
@@ -27,7 +27,7 @@ void Skeleton::scale(float scale)
 	m_scale = scale;
 
 	for(Matrix4& transform : m_transform_hierarchy.m_transforms){
-		Vector3 translation = transform.get_translation().xyz;
+		Vector3 translation = transform.get_translation().GetXYZ();
 		translation *= scale;
 		transform.set_translation(translation, 1.0f);
 	}
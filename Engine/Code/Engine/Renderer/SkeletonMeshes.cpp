@@ -6,8 +6,8 @@ static void draw_bone(MeshBuilder& mb,
 					  const Matrix4& bone_start_global_transform,
 					  const Matrix4& bone_end_global_transform)
 {
-	Vector3 start_pos = bone_start_global_transform.get_translation().xyz;
-	Vector3 end_pos = bone_end_global_transform.get_translation().xyz;
+	Vector3 start_pos = bone_start_global_transform.get_translation().GetXYZ();
+	Vector3 end_pos = bone_end_global_transform.get_translation().GetXYZ();
 
 	Vector3 displacement = end_pos - start_pos;
 	Vector3 dir = displacement.Normalized();
@@ -15,9 +15,9 @@ static void draw_bone(MeshBuilder& mb,
 	float cross_length = displacement.CalcLength() * 0.1f;
 	Vector3 cross_section_pos = start_pos + (displacement * 0.2f);
 
-	Vector3 i = bone_start_global_transform.get_i_basis().xyz;
-	Vector3 j = bone_start_global_transform.get_j_basis().xyz;
-	Vector3 k = bone_start_global_transform.get_k_basis().xyz;
+	Vector3 i = bone_start_global_transform.get_i_basis().GetXYZ();
+	Vector3 j = bone_start_global_transform.get_j_basis().GetXYZ();
+	Vector3 k = bone_start_global_transform.get_k_basis().GetXYZ();
 
 	Meshes::build_line_3d(mb, start_pos, end_pos, 1.0f, Rgba::WHITE, Rgba::WHITE);
 
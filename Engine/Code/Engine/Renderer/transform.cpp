@@ -39,7 +39,7 @@ Transform Transform::calc_world_transform() const
 
 void Transform::look_at(const Vector3& location, const Vector3& up)
 {
-    Vector3 center = m_local.get_translation().xyz;
+    Vector3 center = m_local.get_translation().GetXYZ();
 
 	Vector3 k_basis = (center - location).Normalized();
 	Vector3 i_basis = CrossProduct(up, k_basis);
@@ -1,35 +1,137 @@
 #pragma once
 
+#include "Engine/Core/crt_compat.h"
+
+#if defined(_WIN32)
 #define WIN32_LEAN_AND_MEAN
 #include <Windows.h>
+#endif
 #include <stdint.h>
 
+// Add, incr and decr hand back the new value, compare_and_set the old one
+
 __forceinline
 unsigned int atomic_add(unsigned int volatile *ptr, unsigned int const value)
 {
+#if defined(_WIN32)
     return (unsigned int) ::InterlockedAddNoFence((LONG volatile*)ptr, (LONG)value);
+#else
+    return __atomic_add_fetch(ptr, value, __ATOMIC_RELAXED);
+#endif
 }
 
 __forceinline
 unsigned int atomic_incr(unsigned int *ptr)
 {
+#if defined(_WIN32)
     return (unsigned int) ::InterlockedIncrementNoFence((LONG volatile*)ptr);
+#else
+    return __atomic_add_fetch(ptr, 1, __ATOMIC_RELAXED);
+#endif
 }
 
 __forceinline
 unsigned int atomic_decr(unsigned int *ptr)
 {
+#if defined(_WIN32)
     return (unsigned int) ::InterlockedDecrementNoFence((LONG volatile*)ptr);
+#else
+    return __atomic_sub_fetch(ptr, 1, __ATOMIC_RELAXED);
+#endif
+}
+
+// Everything written before it is visible to whoever sees the new value with an acquire load
+__forceinline
+unsigned int atomic_decr_release(unsigned int *ptr)
+{
+#if defined(_WIN32)
+    return (unsigned int) ::InterlockedDecrementRelease((LONG volatile*)ptr);
+#else
+    return __atomic_sub_fetch(ptr, 1, __ATOMIC_RELEASE);
+#endif
 }
 
 __forceinline
 unsigned int compare_and_set(unsigned int volatile *ptr, unsigned int const comparand, unsigned int const value)
 {
+#if defined(_WIN32)
     return ::InterlockedCompareExchange(ptr, value, comparand);
+#else
+    unsigned int expected = comparand;
+    __atomic_compare_exchange_n(ptr, &expected, value, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+    return expected;
+#endif
 }
 
 template <typename T>
 __forceinline T* compare_and_set_ptr(T *volatile *ptr, T *comparand, T *value)
 {
+#if defined(_WIN32)
     return (T*)::InterlockedCompareExchangePointerNoFence((PVOID volatile*)ptr, (PVOID)value, (PVOID)comparand);
-}
\ No newline at end of file
+#else
+    T* expected = comparand;
+    __atomic_compare_exchange_n(ptr, &expected, value, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+    return expected;
+#endif
+}
+
+// Acquire loads and release stores, for handing data to another thread
+// without a lock. x86 loads and stores already order that way, so MSVC
+// only needs to keep the compiler from moving them.
+
+__forceinline
+unsigned int atomic_load_acquire(unsigned int volatile *ptr)
+{
+#if defined(_WIN32)
+    unsigned int value = *ptr;
+    _ReadWriteBarrier();
+    return value;
+#else
+    return __atomic_load_n(ptr, __ATOMIC_ACQUIRE);
+#endif
+}
+
+__forceinline
+void atomic_store_release(unsigned int volatile *ptr, unsigned int const value)
+{
+#if defined(_WIN32)
+    _ReadWriteBarrier();
+    *ptr = value;
+#else
+    __atomic_store_n(ptr, value, __ATOMIC_RELEASE);
+#endif
+}
+
+template <typename T>
+__forceinline T* atomic_load_ptr_acquire(T *volatile *ptr)
+{
+#if defined(_WIN32)
+    T* value = *ptr;
+    _ReadWriteBarrier();
+    return value;
+#else
+    return __atomic_load_n(ptr, __ATOMIC_ACQUIRE);
+#endif
+}
+
+template <typename T>
+__forceinline void atomic_store_ptr_release(T *volatile *ptr, T *value)
+{
+#if defined(_WIN32)
+    _ReadWriteBarrier();
+    *ptr = value;
+#else
+    __atomic_store_n(ptr, value, __ATOMIC_RELEASE);
+#endif
+}
+
+// Full fence, nothing moves across it in either direction
+__forceinline
+void atomic_fence()
+{
+#if defined(_WIN32)
+    ::MemoryBarrier();
+#else
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+#endif
+}
@@ -2,22 +2,42 @@
 
 CriticalSection::CriticalSection()
 {
+#if defined(_WIN32)
     ::InitializeCriticalSection(&cs);
+#else
+    pthread_mutexattr_t attributes;
+    pthread_mutexattr_init(&attributes);
+    pthread_mutexattr_settype(&attributes, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(&cs, &attributes);
+    pthread_mutexattr_destroy(&attributes);
+#endif
 }
 
 CriticalSection::~CriticalSection()
 {
+#if defined(_WIN32)
     ::DeleteCriticalSection(&cs);
+#else
+    pthread_mutex_destroy(&cs);
+#endif
 }
 
 void CriticalSection::lock()
 {
+#if defined(_WIN32)
     ::EnterCriticalSection(&cs);
+#else
+    pthread_mutex_lock(&cs);
+#endif
 }
 
 void CriticalSection::unlock()
 {
+#if defined(_WIN32)
     ::LeaveCriticalSection(&cs);
+#else
+    pthread_mutex_unlock(&cs);
+#endif
 }
 
 ScopeCriticalSection::ScopeCriticalSection(CriticalSection* cs)
@@ -2,13 +2,21 @@
 
 #include "Engine/Core/StringUtils.hpp"
 
+#if defined(_WIN32)
 #define WIN32_LEAN_AND_MEAN
 #include <windows.h>
+#else
+#include <pthread.h>
+#endif
 
 class CriticalSection
 {
 public:
+#if defined(_WIN32)
     CRITICAL_SECTION cs;
+#else
+    pthread_mutex_t cs;     // recursive, same as a critical section
+#endif
 
 public:
     CriticalSection();
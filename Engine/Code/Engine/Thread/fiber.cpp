@@ -0,0 +1,301 @@
+#include "Engine/Thread/fiber.h"
+#include "Engine/Core/Common.hpp"
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#if defined(_WIN32)
+
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+
+struct fiber_t
+{
+    LPVOID      os_fiber;
+    bool        is_thread;
+    fiber_cb    cb;
+    void*       user_data;
+};
+
+static VOID CALLBACK fiber_entry_point(LPVOID param)
+{
+    fiber_t* fiber = (fiber_t*)param;
+    fiber->cb(fiber->user_data);
+
+    // Returning from a fiber function ends the thread
+    abort();
+}
+
+fiber_t* fiber_convert_thread()
+{
+    fiber_t* fiber = new fiber_t();
+    fiber->os_fiber     = ::ConvertThreadToFiber(nullptr);
+    fiber->is_thread    = true;
+    fiber->cb           = nullptr;
+    fiber->user_data    = nullptr;
+    return fiber;
+}
+
+void fiber_convert_back(fiber_t* thread_fiber)
+{
+    ::ConvertFiberToThread();
+    delete thread_fiber;
+}
+
+fiber_t* fiber_create(fiber_cb cb, void* user_data, size_t stack_size)
+{
+    fiber_t* fiber = new fiber_t();
+    fiber->is_thread    = false;
+    fiber->cb           = cb;
+    fiber->user_data    = user_data;
+    fiber->os_fiber     = ::CreateFiber(stack_size, fiber_entry_point, fiber);
+    if(nullptr == fiber->os_fiber){
+        delete fiber;
+        return nullptr;
+    }
+    return fiber;
+}
+
+void fiber_destroy(fiber_t* fiber)
+{
+    ::DeleteFiber(fiber->os_fiber);
+    delete fiber;
+}
+
+void fiber_switch(fiber_t* from, fiber_t* to)
+{
+    UNUSED(from);
+    ::SwitchToFiber(to->os_fiber);
+}
+
+const char* fiber_get_backend_name()
+{
+    return "win32 fibers";
+}
+
+#else
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+// Stacks come straight from mmap with the lowest page left unmapped, so an
+// overflow faults instead of writing over the next fiber
+static void* alloc_fiber_stack(size_t* stack_size)
+{
+    size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+    *stack_size = (*stack_size + page_size - 1) & ~(page_size - 1);
+
+    void* memory = mmap(nullptr, *stack_size + page_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(memory == MAP_FAILED){
+        return nullptr;
+    }
+    mprotect(memory, page_size, PROT_NONE);
+    return memory;
+}
+
+static void free_fiber_stack(void* memory, size_t stack_size)
+{
+    munmap(memory, stack_size + (size_t)sysconf(_SC_PAGESIZE));
+}
+
+#if defined(__x86_64__)
+
+struct fiber_t
+{
+    void*       stack_pointer;      // where the registers were pushed when it last switched away
+    void*       stack_memory;       // nullptr for a thread
+    size_t      stack_size;
+    fiber_cb    cb;
+    void*       user_data;
+};
+
+extern "C" void engine_fiber_switch_context(void** out_from_stack_pointer, void* to_stack_pointer);
+extern "C" void engine_fiber_start();
+
+// Pushes the registers the System V ABI keeps across calls plus the SSE and
+// x87 control words, swaps stacks and pops the other fiber's. A new fiber's
+// stack is made to look like it switched away from engine_fiber_start, which
+// hands r12 (the fiber) to engine_fiber_entry.
+asm(R"(
+    .text
+    .globl  engine_fiber_switch_context
+    .type   engine_fiber_switch_context, @function
+engine_fiber_switch_context:
+    pushq   %rbp
+    pushq   %rbx
+    pushq   %r12
+    pushq   %r13
+    pushq   %r14
+    pushq   %r15
+    subq    $8, %rsp
+    stmxcsr (%rsp)
+    fnstcw  4(%rsp)
+    movq    %rsp, (%rdi)
+    movq    %rsi, %rsp
+    ldmxcsr (%rsp)
+    fldcw   4(%rsp)
+    addq    $8, %rsp
+    popq    %r15
+    popq    %r14
+    popq    %r13
+    popq    %r12
+    popq    %rbx
+    popq    %rbp
+    ret
+    .size   engine_fiber_switch_context, .-engine_fiber_switch_context
+
+    .globl  engine_fiber_start
+    .type   engine_fiber_start, @function
+engine_fiber_start:
+    movq    %r12, %rdi
+    call    engine_fiber_entry
+    ud2
+    .size   engine_fiber_start, .-engine_fiber_start
+)");
+
+extern "C" void engine_fiber_entry(fiber_t* fiber)
+{
+    fiber->cb(fiber->user_data);
+    abort();
+}
+
+fiber_t* fiber_convert_thread()
+{
+    fiber_t* fiber = new fiber_t();
+    fiber->stack_pointer    = nullptr;
+    fiber->stack_memory     = nullptr;
+    fiber->stack_size       = 0;
+    fiber->cb               = nullptr;
+    fiber->user_data        = nullptr;
+    return fiber;
+}
+
+void fiber_convert_back(fiber_t* thread_fiber)
+{
+    delete thread_fiber;
+}
+
+fiber_t* fiber_create(fiber_cb cb, void* user_data, size_t stack_size)
+{
+    void* stack_memory = alloc_fiber_stack(&stack_size);
+    if(nullptr == stack_memory){
+        return nullptr;
+    }
+
+    fiber_t* fiber = new fiber_t();
+    fiber->stack_memory     = stack_memory;
+    fiber->stack_size       = stack_size;
+    fiber->cb               = cb;
+    fiber->user_data        = user_data;
+
+    // What engine_fiber_switch_context pops, top down. The return address
+    // sits 8 below a 16 byte boundary so the call in engine_fiber_start
+    // lands aligned.
+    uintptr_t top = ((uintptr_t)stack_memory + (size_t)sysconf(_SC_PAGESIZE) + stack_size) & ~(uintptr_t)15;
+    uint64_t* slots = (uint64_t*)top;
+    slots[-1] = (uint64_t)(uintptr_t)engine_fiber_start;    // ret
+    slots[-2] = 0;                                          // rbp
+    slots[-3] = 0;                                          // rbx
+    slots[-4] = (uint64_t)(uintptr_t)fiber;                 // r12
+    slots[-5] = 0;                                          // r13
+    slots[-6] = 0;                                          // r14
+    slots[-7] = 0;                                          // r15
+    slots[-8] = 0x1f80 | ((uint64_t)0x037f << 32);          // default mxcsr, x87 control word
+    fiber->stack_pointer = &slots[-8];
+    return fiber;
+}
+
+void fiber_destroy(fiber_t* fiber)
+{
+    free_fiber_stack(fiber->stack_memory, fiber->stack_size);
+    delete fiber;
+}
+
+void fiber_switch(fiber_t* from, fiber_t* to)
+{
+    engine_fiber_switch_context(&from->stack_pointer, to->stack_pointer);
+}
+
+const char* fiber_get_backend_name()
+{
+    return "x86-64 asm";
+}
+
+#else
+
+#include <ucontext.h>
+
+struct fiber_t
+{
+    ucontext_t  context;
+    void*       stack_memory;       // nullptr for a thread
+    size_t      stack_size;
+    fiber_cb    cb;
+    void*       user_data;
+};
+
+// makecontext only passes ints, so the pointer goes over in two halves
+static void fiber_entry_point(unsigned int high, unsigned int low)
+{
+    fiber_t* fiber = (fiber_t*)(((uintptr_t)high << 16 << 16) | (uintptr_t)low);
+    fiber->cb(fiber->user_data);
+    abort();
+}
+
+fiber_t* fiber_convert_thread()
+{
+    fiber_t* fiber = new fiber_t();
+    fiber->stack_memory     = nullptr;
+    fiber->stack_size       = 0;
+    fiber->cb               = nullptr;
+    fiber->user_data        = nullptr;
+    return fiber;
+}
+
+void fiber_convert_back(fiber_t* thread_fiber)
+{
+    delete thread_fiber;
+}
+
+fiber_t* fiber_create(fiber_cb cb, void* user_data, size_t stack_size)
+{
+    void* stack_memory = alloc_fiber_stack(&stack_size);
+    if(nullptr == stack_memory){
+        return nullptr;
+    }
+
+    fiber_t* fiber = new fiber_t();
+    fiber->stack_memory     = stack_memory;
+    fiber->stack_size       = stack_size;
+    fiber->cb               = cb;
+    fiber->user_data        = user_data;
+
+    getcontext(&fiber->context);
+    fiber->context.uc_stack.ss_sp   = (char*)stack_memory + sysconf(_SC_PAGESIZE);
+    fiber->context.uc_stack.ss_size = stack_size;
+    fiber->context.uc_link          = nullptr;
+
+    uintptr_t address = (uintptr_t)fiber;
+    makecontext(&fiber->context, (void(*)())fiber_entry_point, 2, (unsigned int)(address >> 16 >> 16), (unsigned int)address);
+    return fiber;
+}
+
+void fiber_destroy(fiber_t* fiber)
+{
+    free_fiber_stack(fiber->stack_memory, fiber->stack_size);
+    delete fiber;
+}
+
+void fiber_switch(fiber_t* from, fiber_t* to)
+{
+    swapcontext(&from->context, &to->context);
+}
+
+const char* fiber_get_backend_name()
+{
+    return "ucontext";
+}
+
+#endif
+
+#endif
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <stddef.h>
+
+//-----------------------------------------------------
+// Fiber
+//
+// A stack and a saved register set that a thread can switch onto and off
+// again, all in user mode. Windows uses its own fibers. x86-64 elsewhere
+// switches with a few lines of assembly that save only what the calling
+// convention says survives a call, other POSIX targets fall back to
+// ucontext, which also saves the signal mask with a syscall per switch.
+//
+// A thread has to become a fiber itself before it can switch to another,
+// and back to a plain thread before it exits. A fiber's function must never
+// return, it switches away for the last time instead.
+
+struct fiber_t;
+
+typedef void(*fiber_cb)(void* user_data);
+
+#define FIBER_DEFAULT_STACK_SIZE    (256 * 1024)
+
+// The calling thread as a fiber to switch back to
+fiber_t*    fiber_convert_thread();
+void        fiber_convert_back(fiber_t* thread_fiber);
+
+// Starts on <cb> the first time it's switched to. nullptr when the stack can't be had.
+fiber_t*    fiber_create(fiber_cb cb, void* user_data, size_t stack_size = FIBER_DEFAULT_STACK_SIZE);
+void        fiber_destroy(fiber_t* fiber);
+
+// <from> is the fiber the calling thread is on now
+void        fiber_switch(fiber_t* from, fiber_t* to);
+
+// Which implementation this build switches with
+const char* fiber_get_backend_name();
@@ -1,5 +1,7 @@
 #include "Engine/Thread/signal.h"
 
+#if defined(_WIN32)
+
 Signal::Signal()
 {
    os_event = ::CreateEvent( nullptr, // security attributes, not needed
@@ -53,4 +55,78 @@ bool Signal::wait_for(unsigned int ms)
    }
 
    return false;
-}
\ No newline at end of file
+}
+
+#else
+
+#include <errno.h>
+#include <time.h>
+
+Signal::Signal()
+    :is_signaled(false)
+    ,generation(0)
+{
+    pthread_mutex_init(&os_lock, nullptr);
+    pthread_cond_init(&os_condition, nullptr);
+}
+
+//------------------------------------------------------------------------
+Signal::~Signal()
+{
+    pthread_cond_destroy(&os_condition);
+    pthread_mutex_destroy(&os_lock);
+}
+
+//------------------------------------------------------------------------
+void Signal::signal_all()
+{
+    pthread_mutex_lock(&os_lock);
+    is_signaled = true;
+    ++generation;
+    pthread_cond_broadcast(&os_condition);
+    pthread_mutex_unlock(&os_lock);
+}
+
+//------------------------------------------------------------------------
+void Signal::wait()
+{
+    pthread_mutex_lock(&os_lock);
+
+    // Leave on the generation bump too, another waiter woken by the same
+    // signal may have reset it already
+    unsigned int wait_generation = generation;
+    while(!is_signaled && (wait_generation == generation)){
+        pthread_cond_wait(&os_condition, &os_lock);
+    }
+
+    is_signaled = false;
+    pthread_mutex_unlock(&os_lock);
+}
+
+bool Signal::wait_for(unsigned int ms)
+{
+    timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += ms / 1000;
+    deadline.tv_nsec += (long)(ms % 1000) * 1000000L;
+    if(deadline.tv_nsec >= 1000000000L){
+        deadline.tv_sec += 1;
+        deadline.tv_nsec -= 1000000000L;
+    }
+
+    pthread_mutex_lock(&os_lock);
+
+    unsigned int wait_generation = generation;
+    while(!is_signaled && (wait_generation == generation)){
+        if(pthread_cond_timedwait(&os_condition, &os_lock, &deadline) == ETIMEDOUT){
+            break;
+        }
+    }
+
+    bool was_signaled = is_signaled || (wait_generation != generation);
+    is_signaled = false;
+    pthread_mutex_unlock(&os_lock);
+    return was_signaled;
+}
+
+#endif
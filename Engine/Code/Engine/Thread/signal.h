@@ -2,8 +2,12 @@
 
 #include "Engine/Thread/thread.h"
 
+#if defined(_WIN32)
 #define WIN32_LEAN_AND_MEAN
 #include <windows.h>
+#else
+#include <pthread.h>
+#endif
 
 class Signal
 {
@@ -16,5 +20,14 @@ public:
     bool wait_for(unsigned int ms);
 
 public:
+#if defined(_WIN32)
     HANDLE os_event;
+#else
+    // Manual reset event: a signal releases everyone already waiting, and
+    // stays set for the next waiter if nobody was
+    pthread_mutex_t os_lock;
+    pthread_cond_t  os_condition;
+    bool            is_signaled;
+    unsigned int    generation;
+#endif
 };
\ No newline at end of file
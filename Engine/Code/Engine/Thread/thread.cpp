@@ -4,6 +4,8 @@
 #include "Engine/Thread/atomic.h"
 #include "Engine/Profile/profiler.h"
 
+#if defined(_WIN32)
+
 #define WIN32_LEAN_AND_MEAN
 #include <windows.h>
 
@@ -101,6 +103,104 @@ void thread_set_name(const char* name)
         {
         }
 
+#if defined(PROFILED_BUILD)
         profiler_set_thread_name(id, name);
+#endif
+    }
+}
+
+#else
+
+#include <pthread.h>
+#include <sched.h>
+#include <string.h>
+#include <time.h>
+
+struct thread_pass_data_t
+{
+    thread_cb cb;
+    void *arg;
+};
+
+static void* thread_entry_point_common(void *arg)
+{
+    thread_pass_data_t *pass_ptr = (thread_pass_data_t*)arg;
+
+    pass_ptr->cb(pass_ptr->arg);
+    delete pass_ptr;
+    return nullptr;
+}
+
+// pthread_t isn't guaranteed to fit a pointer, so the handle owns a copy
+thread_handle_t thread_create(thread_cb cb, void *data)
+{
+    thread_pass_data_t *pass = new thread_pass_data_t();
+    pass->cb = cb;
+    pass->arg = data;
+
+    pthread_t* th = new pthread_t();
+    if(pthread_create(th, nullptr, thread_entry_point_common, pass) != 0){
+        delete th;
+        delete pass;
+        return nullptr;
     }
-}
\ No newline at end of file
+
+    return (thread_handle_t)th;
+}
+
+void thread_sleep(unsigned int ms)
+{
+    timespec duration;
+    duration.tv_sec = ms / 1000;
+    duration.tv_nsec = (long)(ms % 1000) * 1000000L;
+    while(nanosleep(&duration, &duration) != 0){
+    }
+}
+
+void thread_yield()
+{
+    sched_yield();
+}
+
+void thread_detach(thread_handle_t th)
+{
+    pthread_t* pth = (pthread_t*)th;
+    pthread_detach(*pth);
+    delete pth;
+}
+
+void thread_join(thread_handle_t th)
+{
+    pthread_t* pth = (pthread_t*)th;
+    pthread_join(*pth, nullptr);
+    delete pth;
+}
+
+thread_id_t thread_get_id()
+{
+    return (thread_id_t)(uintptr_t)pthread_self();
+}
+
+void thread_set_name(const char* name)
+{
+    if(nullptr == name){
+        return;
+    }
+
+    // Linux caps names at 15 characters plus the terminator
+    char short_name[16];
+    strncpy(short_name, name, sizeof(short_name) - 1);
+    short_name[sizeof(short_name) - 1] = '\0';
+
+#if defined(__APPLE__)
+    pthread_setname_np(short_name);
+#else
+    pthread_setname_np(pthread_self(), short_name);
+#endif
+
+#if defined(PROFILED_BUILD)
+    profiler_set_thread_name(thread_get_id(), name);
+#endif
+}
+
+#endif
\ No newline at end of file
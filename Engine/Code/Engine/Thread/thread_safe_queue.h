@@ -2,7 +2,7 @@
 
 #include "Engine/Thread/thread.h"
 #include "Engine/Thread/critical_section.h"
-#include <queue>
+#include <deque>
 
 template <typename T>
 class ThreadSafeQueue
@@ -13,8 +13,13 @@ public:
     bool pop(T* out);
     T    front();
 
+    // Takes the oldest item <pred> is true for, the rest keep their order.
+    // <pred> runs under the queue's lock.
+    template <typename PRED>
+    bool pop_first(PRED pred, T* out);
+
 private:
-    std::queue<T>    m_queue;
+    std::deque<T>    m_queue;
     CriticalSection  m_lock;
 };
 
@@ -29,7 +34,7 @@ template<typename T>
 void ThreadSafeQueue<T>::push(const T& v)
 {
     SCOPE_LOCK(&m_lock);
-    m_queue.push(v);
+    m_queue.push_back(v);
 }
 
 template<typename T>
@@ -41,7 +46,7 @@ bool ThreadSafeQueue<T>::pop(T* out)
         return false;
     }else{
         *out = m_queue.front();
-        m_queue.pop();
+        m_queue.pop_front();
         return true;
     }
 }
@@ -51,4 +56,20 @@ T ThreadSafeQueue<T>::front()
 {
     SCOPE_LOCK(&m_lock);
     return m_queue.front();
-}
\ No newline at end of file
+}
+
+template<typename T>
+template<typename PRED>
+bool ThreadSafeQueue<T>::pop_first(PRED pred, T* out)
+{
+    SCOPE_LOCK(&m_lock);
+
+    for(typename std::deque<T>::iterator it = m_queue.begin(); it != m_queue.end(); ++it){
+        if(pred(*it)){
+            *out = *it;
+            m_queue.erase(it);
+            return true;
+        }
+    }
+    return false;
+}
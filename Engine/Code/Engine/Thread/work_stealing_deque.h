@@ -0,0 +1,163 @@
+#pragma once
+
+#include "Engine/Thread/atomic.h"
+
+#include <vector>
+
+//-----------------------------------------------------
+// Work stealing deque
+//
+// Chase-Lev deque of pointers. One thread owns it and pushes and pops the
+// bottom, last in first out, so what it just made is still in cache. Any
+// other thread can steal from the top, oldest first, which tends to be the
+// biggest piece of work left. The owner only touches the top when it takes
+// the last item, so an owner working through its own items never waits on
+// a lock.
+//
+// The ring doubles when full. The old rings stay alive until the deque goes,
+// a thief may still be reading one. Bottom and top only ever count up and
+// compare as signed differences, so they can wrap.
+
+template <typename T>
+class WorkStealingDeque
+{
+public:
+    WorkStealingDeque(unsigned int capacity = 1024);
+    ~WorkStealingDeque();
+
+    // Owner only
+    void push(T* item);
+    T*   pop();
+
+    // Any thread, nullptr when empty or when another thread won the race for the item
+    T*   steal();
+
+    // Only a hint while other threads are at it
+    bool empty();
+
+private:
+    struct ring_t
+    {
+        unsigned int    mask;
+        T* volatile*    items;
+
+        ring_t(unsigned int capacity)
+            :mask(capacity - 1)
+            ,items(new T* volatile[capacity])
+        {}
+        ~ring_t() { delete[] items; }
+
+        T*   get(unsigned int index) const  { return atomic_load_ptr_acquire(&items[index & mask]); }
+        void put(unsigned int index, T* item) { atomic_store_ptr_release(&items[index & mask], item); }
+    };
+
+    ring_t* grow(ring_t* ring, unsigned int bottom, unsigned int top);
+
+private:
+    // Thieves hammer the top, keep it off the owner's cache line
+    unsigned int volatile   m_top;
+    char                    m_top_padding[64 - sizeof(unsigned int)];
+    unsigned int volatile   m_bottom;
+    ring_t* volatile        m_ring;
+    std::vector<ring_t*>    m_old_rings;    // owner only
+};
+
+template <typename T>
+WorkStealingDeque<T>::WorkStealingDeque(unsigned int capacity)
+    :m_top(0)
+    ,m_bottom(0)
+    ,m_ring(nullptr)
+{
+    unsigned int ring_capacity = 1;
+    while(ring_capacity < capacity){
+        ring_capacity <<= 1;
+    }
+    m_ring = new ring_t(ring_capacity);
+}
+
+template <typename T>
+WorkStealingDeque<T>::~WorkStealingDeque()
+{
+    delete m_ring;
+    for(ring_t* ring : m_old_rings){
+        delete ring;
+    }
+}
+
+template <typename T>
+typename WorkStealingDeque<T>::ring_t* WorkStealingDeque<T>::grow(ring_t* ring, unsigned int bottom, unsigned int top)
+{
+    ring_t* bigger = new ring_t((ring->mask + 1) * 2);
+    for(unsigned int i = top; i != bottom; ++i){
+        bigger->put(i, ring->get(i));
+    }
+    m_old_rings.push_back(ring);
+    atomic_store_ptr_release(&m_ring, bigger);
+    return bigger;
+}
+
+template <typename T>
+void WorkStealingDeque<T>::push(T* item)
+{
+    unsigned int bottom = m_bottom;
+    unsigned int top = atomic_load_acquire(&m_top);
+    ring_t* ring = m_ring;
+    if((int)(bottom - top) > (int)ring->mask){
+        ring = grow(ring, bottom, top);
+    }
+
+    ring->put(bottom, item);
+    atomic_store_release(&m_bottom, bottom + 1);
+}
+
+template <typename T>
+T* WorkStealingDeque<T>::pop()
+{
+    // Claim the bottom item first, then see whether a thief got to it
+    unsigned int bottom = m_bottom - 1;
+    ring_t* ring = m_ring;
+    m_bottom = bottom;
+    atomic_fence();
+    unsigned int top = m_top;
+
+    if((int)(bottom - top) < 0){
+        m_bottom = bottom + 1;
+        return nullptr;
+    }
+
+    T* item = ring->get(bottom);
+    if(bottom == top){
+        // The last item, the owner and the thieves race for it on the top
+        if(compare_and_set(&m_top, top, top + 1) != top){
+            item = nullptr;
+        }
+        m_bottom = bottom + 1;
+    }
+    return item;
+}
+
+template <typename T>
+T* WorkStealingDeque<T>::steal()
+{
+    unsigned int top = atomic_load_acquire(&m_top);
+    atomic_fence();
+    unsigned int bottom = atomic_load_acquire(&m_bottom);
+    if((int)(bottom - top) <= 0){
+        return nullptr;
+    }
+
+    ring_t* ring = atomic_load_ptr_acquire(&m_ring);
+    T* item = ring->get(top);
+    if(compare_and_set(&m_top, top, top + 1) != top){
+        return nullptr;
+    }
+    return item;
+}
+
+template <typename T>
+bool WorkStealingDeque<T>::empty()
+{
+    unsigned int top = atomic_load_acquire(&m_top);
+    unsigned int bottom = atomic_load_acquire(&m_bottom);
+    return (int)(bottom - top) <= 0;
+}
@@ -0,0 +1,646 @@
+#include "Engine/Volume/volume_bc.h"
+
+#include "Engine/Core/Time.hpp"
+#include "Engine/Core/cpu.h"
+#include "Engine/Core/job.h"
+
+#include <immintrin.h>
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
+
+//-----------------------------------------------------
+// Internal helpers
+
+#define BC_NUM_LEVELS       8
+#define BC_MAX_REFITS       4
+
+struct bc_error_t
+{
+    double          sse[VOLUME_BC_MAX_CHANNELS];
+    unsigned int    max_error[VOLUME_BC_MAX_CHANNELS];
+};
+
+struct bc_encode_pass_t
+{
+    volume_view_t               src;
+    volume_bc_t*                dst;
+    std::vector<bc_error_t>     slab_errors;    // one per brick slab, summed once every slab is done
+};
+
+struct bc_decode_pass_t
+{
+    volume_bc_view_t    src;
+    volume_buffer_t*    dst;
+    SimdLevel           simd_level;
+};
+
+struct bc_page_pass_t
+{
+    volume_bc_cache_t*          cache;
+    std::vector<unsigned int>   pages;
+    SimdLevel                   simd_level;
+};
+
+static unsigned int min_uint(unsigned int a, unsigned int b)
+{
+    return (a < b) ? a : b;
+}
+
+static unsigned char clamp_to_byte(double value)
+{
+    value = (value < 0.0) ? 0.0 : ((value > 255.0) ? 255.0 : value);
+    return (unsigned char)(value + 0.5);
+}
+
+// BC4's 8 value mode, endpoints included and the 6 values between them rounded
+static void build_palette(unsigned int e0, unsigned int e1, unsigned char* out_palette)
+{
+    for(unsigned int k = 0; k < BC_NUM_LEVELS; ++k){
+        out_palette[k] = (unsigned char)(((e0 * (7 - k)) + (e1 * k) + 3) / 7);
+    }
+}
+
+// 8 three bit indices (24 bits) spread out to one per byte
+static uint64_t unpack_index_group(const unsigned char* bits)
+{
+    uint64_t word = (uint64_t)bits[0] | ((uint64_t)bits[1] << 8) | ((uint64_t)bits[2] << 16);
+    word = (word | (word << 20)) & 0x00000fff00000fffULL;
+    word = (word | (word << 10)) & 0x003f003f003f003fULL;
+    word = (word | (word << 5)) & 0x0707070707070707ULL;
+    return word;
+}
+
+static void unpack_indices(const unsigned char* block, unsigned char* out_indices)
+{
+    const unsigned char* bits = block + 2;
+    for(unsigned int group = 0; group < VOLUME_BC_BRICK_VOXELS / 8; ++group){
+        uint64_t indices = unpack_index_group(bits + (group * 3));
+        memcpy(out_indices + (group * 8), &indices, sizeof(indices));
+    }
+}
+
+static void decode_block(const unsigned char* block, unsigned char* out_values)
+{
+    unsigned char palette[BC_NUM_LEVELS];
+    build_palette(block[0], block[1], palette);
+
+    unsigned char indices[VOLUME_BC_BRICK_VOXELS];
+    unpack_indices(block, indices);
+    for(unsigned int i = 0; i < VOLUME_BC_BRICK_VOXELS; ++i){
+        out_values[i] = palette[indices[i]];
+    }
+}
+
+// Whole RGBA8 bricks: the palette sits in a register and pshufb looks up 16
+// voxels at once, then the four channel planes are zipped back into voxels
+// one 4x4 z slice at a time. Same bytes as decode_block.
+static void decode_brick_rgba8_sse41(const unsigned char* brick, unsigned char* out, size_t row_pitch, size_t slice_pitch)
+{
+    __m128i planes[VOLUME_BC_MAX_CHANNELS][VOLUME_BC_BRICK_SIZE];
+    for(unsigned int c = 0; c < 4; ++c){
+        const unsigned char* block = brick + (c * VOLUME_BC_BLOCK_BYTES);
+
+        unsigned char palette[16] = { 0 };
+        build_palette(block[0], block[1], palette);
+        __m128i palette_lanes = _mm_loadu_si128((const __m128i*)palette);
+
+        unsigned char indices[VOLUME_BC_BRICK_VOXELS];
+        unpack_indices(block, indices);
+        for(unsigned int z = 0; z < VOLUME_BC_BRICK_SIZE; ++z){
+            __m128i index_lanes = _mm_loadu_si128((const __m128i*)(indices + (z * 16)));
+            planes[c][z] = _mm_shuffle_epi8(palette_lanes, index_lanes);
+        }
+    }
+
+    for(unsigned int z = 0; z < VOLUME_BC_BRICK_SIZE; ++z){
+        __m128i rg_lo = _mm_unpacklo_epi8(planes[0][z], planes[1][z]);
+        __m128i rg_hi = _mm_unpackhi_epi8(planes[0][z], planes[1][z]);
+        __m128i ba_lo = _mm_unpacklo_epi8(planes[2][z], planes[3][z]);
+        __m128i ba_hi = _mm_unpackhi_epi8(planes[2][z], planes[3][z]);
+
+        unsigned char* slice = out + (z * slice_pitch);
+        _mm_storeu_si128((__m128i*)(slice + (0 * row_pitch)), _mm_unpacklo_epi16(rg_lo, ba_lo));
+        _mm_storeu_si128((__m128i*)(slice + (1 * row_pitch)), _mm_unpackhi_epi16(rg_lo, ba_lo));
+        _mm_storeu_si128((__m128i*)(slice + (2 * row_pitch)), _mm_unpacklo_epi16(rg_hi, ba_hi));
+        _mm_storeu_si128((__m128i*)(slice + (3 * row_pitch)), _mm_unpackhi_epi16(rg_hi, ba_hi));
+    }
+}
+
+static void decode_brick(const volume_bc_view_t& src, unsigned int bx, unsigned int by, unsigned int bz, unsigned char* out, size_t row_pitch, size_t slice_pitch, SimdLevel simd_level)
+{
+    const unsigned char* brick = src.get_brick(bx, by, bz);
+    unsigned int channels = src.num_channels;
+
+    unsigned int size_x = min_uint(VOLUME_BC_BRICK_SIZE, src.width - (bx * VOLUME_BC_BRICK_SIZE));
+    unsigned int size_y = min_uint(VOLUME_BC_BRICK_SIZE, src.height - (by * VOLUME_BC_BRICK_SIZE));
+    unsigned int size_z = min_uint(VOLUME_BC_BRICK_SIZE, src.depth - (bz * VOLUME_BC_BRICK_SIZE));
+
+    bool is_whole = (size_x == VOLUME_BC_BRICK_SIZE) && (size_y == VOLUME_BC_BRICK_SIZE) && (size_z == VOLUME_BC_BRICK_SIZE);
+    if(is_whole && (channels == 4) && (simd_level >= SIMD_LEVEL_SSE41)){
+        decode_brick_rgba8_sse41(brick, out, row_pitch, slice_pitch);
+        return;
+    }
+
+    unsigned char values[VOLUME_BC_MAX_CHANNELS][VOLUME_BC_BRICK_VOXELS];
+    for(unsigned int c = 0; c < channels; ++c){
+        decode_block(brick + (c * VOLUME_BC_BLOCK_BYTES), values[c]);
+    }
+
+    for(unsigned int z = 0; z < size_z; ++z){
+        for(unsigned int y = 0; y < size_y; ++y){
+            unsigned char* row = out + (z * slice_pitch) + (y * row_pitch);
+            unsigned int first = ((z * VOLUME_BC_BRICK_SIZE) + y) * VOLUME_BC_BRICK_SIZE;
+
+            // Interleave the channels back into voxels
+            for(unsigned int x = 0; x < size_x; ++x){
+                for(unsigned int c = 0; c < channels; ++c){
+                    row[(x * channels) + c] = values[c][first + x];
+                }
+            }
+        }
+    }
+}
+
+static void write_block(unsigned int e0, unsigned int e1, const unsigned char* indices, unsigned char* out_block)
+{
+    out_block[0] = (unsigned char)e0;
+    out_block[1] = (unsigned char)e1;
+
+    unsigned char* bits = out_block + 2;
+    for(unsigned int group = 0; group < VOLUME_BC_BRICK_VOXELS / 8; ++group){
+        unsigned int word = 0;
+        for(unsigned int i = 0; i < 8; ++i){
+            word |= (unsigned int)indices[(group * 8) + i] << (i * 3);
+        }
+        bits[0] = (unsigned char)word;
+        bits[1] = (unsigned char)(word >> 8);
+        bits[2] = (unsigned char)(word >> 16);
+        bits += 3;
+    }
+}
+
+// Nearest palette entry for every value, returns the squared error
+static unsigned int fit_indices(const unsigned char* values, unsigned int e0, unsigned int e1, unsigned char* out_indices)
+{
+    unsigned char palette[BC_NUM_LEVELS];
+    build_palette(e0, e1, palette);
+
+    unsigned int sse = 0;
+    for(unsigned int i = 0; i < VOLUME_BC_BRICK_VOXELS; ++i){
+        unsigned int best_index = 0;
+        unsigned int best_error = 0xffffffff;
+        for(unsigned int k = 0; k < BC_NUM_LEVELS; ++k){
+            int diff = (int)values[i] - (int)palette[k];
+            unsigned int error = (unsigned int)(diff * diff);
+            if(error < best_error){
+                best_error = error;
+                best_index = k;
+            }
+        }
+        out_indices[i] = (unsigned char)best_index;
+        sse += best_error;
+    }
+    return sse;
+}
+
+// Starts from the block's range, then alternates between picking indices and
+// solving for the endpoints that best fit those indices, keeping whichever
+// pass had the least error. Min/max alone wastes levels on outliers.
+static void encode_block(const unsigned char* values, unsigned char* out_block)
+{
+    unsigned int lo = 255;
+    unsigned int hi = 0;
+    for(unsigned int i = 0; i < VOLUME_BC_BRICK_VOXELS; ++i){
+        lo = (values[i] < lo) ? values[i] : lo;
+        hi = (values[i] > hi) ? values[i] : hi;
+    }
+
+    unsigned char indices[VOLUME_BC_BRICK_VOXELS];
+    if(lo == hi){
+        memset(indices, 0, sizeof(indices));
+        write_block(lo, hi, indices, out_block);
+        return;
+    }
+
+    unsigned char best_indices[VOLUME_BC_BRICK_VOXELS];
+    unsigned int best_sse = fit_indices(values, lo, hi, best_indices);
+    unsigned int best_e0 = lo;
+    unsigned int best_e1 = hi;
+
+    unsigned int e0 = lo;
+    unsigned int e1 = hi;
+    memcpy(indices, best_indices, sizeof(indices));
+
+    for(unsigned int refit = 0; (refit < BC_MAX_REFITS) && (best_sse > 0); ++refit){
+        // Least squares for value = e0 * (1 - t) + e1 * t over the current t = index / 7
+        double sum_aa = 0.0;
+        double sum_ab = 0.0;
+        double sum_bb = 0.0;
+        double sum_av = 0.0;
+        double sum_bv = 0.0;
+        for(unsigned int i = 0; i < VOLUME_BC_BRICK_VOXELS; ++i){
+            double t = (double)indices[i] / 7.0;
+            double a = 1.0 - t;
+            sum_aa += a * a;
+            sum_ab += a * t;
+            sum_bb += t * t;
+            sum_av += a * values[i];
+            sum_bv += t * values[i];
+        }
+
+        double determinant = (sum_aa * sum_bb) - (sum_ab * sum_ab);
+        if(fabs(determinant) < 1e-9){
+            break;
+        }
+
+        unsigned int new_e0 = clamp_to_byte(((sum_av * sum_bb) - (sum_bv * sum_ab)) / determinant);
+        unsigned int new_e1 = clamp_to_byte(((sum_aa * sum_bv) - (sum_ab * sum_av)) / determinant);
+        if((new_e0 == e0) && (new_e1 == e1)){
+            break;
+        }
+
+        e0 = new_e0;
+        e1 = new_e1;
+        unsigned int sse = fit_indices(values, e0, e1, indices);
+        if(sse < best_sse){
+            best_sse = sse;
+            best_e0 = e0;
+            best_e1 = e1;
+            memcpy(best_indices, indices, sizeof(indices));
+        }
+    }
+
+    write_block(best_e0, best_e1, best_indices, out_block);
+}
+
+static void encode_slab(unsigned int bz, void* user_data)
+{
+    bc_encode_pass_t* pass = (bc_encode_pass_t*)user_data;
+    const volume_view_t& src = pass->src;
+    volume_bc_view_t dst = pass->dst->get_view();
+    unsigned int channels = dst.num_channels;
+
+    bc_error_t& error = pass->slab_errors[bz];
+    memset(&error, 0, sizeof(error));
+
+    unsigned char values[VOLUME_BC_BRICK_VOXELS];
+    unsigned char decoded[VOLUME_BC_BRICK_VOXELS];
+    for(unsigned int by = 0; by < dst.get_num_bricks_y(); ++by){
+        for(unsigned int bx = 0; bx < dst.get_num_bricks_x(); ++bx){
+            unsigned char* brick = (unsigned char*)dst.get_brick(bx, by, bz);
+            unsigned int min_x = bx * VOLUME_BC_BRICK_SIZE;
+            unsigned int min_y = by * VOLUME_BC_BRICK_SIZE;
+            unsigned int min_z = bz * VOLUME_BC_BRICK_SIZE;
+
+            for(unsigned int c = 0; c < channels; ++c){
+                // Edge bricks repeat the last voxel, it costs the fit nothing
+                for(unsigned int i = 0; i < VOLUME_BC_BRICK_VOXELS; ++i){
+                    unsigned int x = min_uint(min_x + (i % 4), src.width - 1);
+                    unsigned int y = min_uint(min_y + ((i / 4) % 4), src.height - 1);
+                    unsigned int z = min_uint(min_z + (i / 16), src.depth - 1);
+                    values[i] = src.get_voxel(x, y, z)[c];
+                }
+
+                unsigned char* block = brick + (c * VOLUME_BC_BLOCK_BYTES);
+                encode_block(values, block);
+                decode_block(block, decoded);
+
+                // Error is only counted for voxels that exist
+                for(unsigned int i = 0; i < VOLUME_BC_BRICK_VOXELS; ++i){
+                    bool is_inside = (min_x + (i % 4) < src.width) && (min_y + ((i / 4) % 4) < src.height) && (min_z + (i / 16) < src.depth);
+                    if(!is_inside){
+                        continue;
+                    }
+
+                    int diff = (int)values[i] - (int)decoded[i];
+                    unsigned int abs_diff = (unsigned int)((diff < 0) ? -diff : diff);
+                    error.sse[c] += (double)(diff * diff);
+                    error.max_error[c] = (abs_diff > error.max_error[c]) ? abs_diff : error.max_error[c];
+                }
+            }
+        }
+    }
+}
+
+static void decode_slab(unsigned int bz, void* user_data)
+{
+    bc_decode_pass_t* pass = (bc_decode_pass_t*)user_data;
+    volume_buffer_t* dst = pass->dst;
+
+    size_t row_pitch = dst->get_row_pitch();
+    size_t slice_pitch = dst->get_slice_pitch();
+    for(unsigned int by = 0; by < pass->src.get_num_bricks_y(); ++by){
+        for(unsigned int bx = 0; bx < pass->src.get_num_bricks_x(); ++bx){
+            unsigned char* out = dst->get_voxel(bx * VOLUME_BC_BRICK_SIZE, by * VOLUME_BC_BRICK_SIZE, bz * VOLUME_BC_BRICK_SIZE);
+            decode_brick(pass->src, bx, by, bz, out, row_pitch, slice_pitch, pass->simd_level);
+        }
+    }
+}
+
+static void decode_page(unsigned int item, void* user_data)
+{
+    bc_page_pass_t* pass = (bc_page_pass_t*)user_data;
+    volume_bc_cache_t* cache = pass->cache;
+    const volume_bc_view_t& src = cache->source;
+
+    unsigned int page = pass->pages[item];
+    unsigned int px = page % cache->num_pages_x;
+    unsigned int py = (page / cache->num_pages_x) % cache->num_pages_y;
+    unsigned int pz = page / (cache->num_pages_x * cache->num_pages_y);
+
+    unsigned char* slot = cache->slot_data.data() + ((size_t)cache->page_slots[page] * cache->page_bytes);
+    size_t row_pitch = (size_t)VOLUME_BC_PAGE_SIZE * src.num_channels;
+    size_t slice_pitch = row_pitch * VOLUME_BC_PAGE_SIZE;
+
+    const unsigned int bricks_per_page = VOLUME_BC_PAGE_SIZE / VOLUME_BC_BRICK_SIZE;
+    unsigned int end_bx = min_uint((px + 1) * bricks_per_page, src.get_num_bricks_x());
+    unsigned int end_by = min_uint((py + 1) * bricks_per_page, src.get_num_bricks_y());
+    unsigned int end_bz = min_uint((pz + 1) * bricks_per_page, src.get_num_bricks_z());
+    for(unsigned int bz = pz * bricks_per_page; bz < end_bz; ++bz){
+        for(unsigned int by = py * bricks_per_page; by < end_by; ++by){
+            for(unsigned int bx = px * bricks_per_page; bx < end_bx; ++bx){
+                unsigned int local_x = (bx % bricks_per_page) * VOLUME_BC_BRICK_SIZE;
+                unsigned int local_y = (by % bricks_per_page) * VOLUME_BC_BRICK_SIZE;
+                unsigned int local_z = (bz % bricks_per_page) * VOLUME_BC_BRICK_SIZE;
+                unsigned char* out = slot + (local_z * slice_pitch) + (local_y * row_pitch) + ((size_t)local_x * src.num_channels);
+                decode_brick(src, bx, by, bz, out, row_pitch, slice_pitch, pass->simd_level);
+            }
+        }
+    }
+}
+
+// A free slot if there is one, otherwise the least recently used slot that
+// the current request hasn't claimed
+static int find_slot(const volume_bc_cache_t& cache)
+{
+    int best_slot = -1;
+    for(unsigned int i = 0; i < cache.num_slots; ++i){
+        if(cache.slot_pages[i] < 0){
+            return (int)i;
+        }
+        if(cache.slot_last_used[i] == cache.tick){
+            continue;
+        }
+        if((best_slot < 0) || (cache.slot_last_used[i] < cache.slot_last_used[best_slot])){
+            best_slot = (int)i;
+        }
+    }
+    return best_slot;
+}
+
+//-----------------------------------------------------
+// Public API
+
+double volume_bc_stats_t::psnr(unsigned int channel) const
+{
+    return (mse[channel] > 0.0) ? 10.0 * log10((255.0 * 255.0) / mse[channel]) : HUGE_VAL;
+}
+
+size_t volume_bc_get_size(unsigned int width, unsigned int height, unsigned int depth, unsigned int num_channels)
+{
+    volume_bc_view_t view;
+    view.data           = nullptr;
+    view.width          = width;
+    view.height         = height;
+    view.depth          = depth;
+    view.num_channels   = num_channels;
+    return view.get_size();
+}
+
+VolumeFormat volume_bc_get_format(unsigned int num_channels)
+{
+    return (num_channels == 4) ? VOLUME_FORMAT_BC_RGBA8 : VOLUME_FORMAT_BC_R8;
+}
+
+bool volume_bc_encode(const volume_view_t& src, VolumeFormat format, volume_bc_t* out_volume, unsigned int max_workers, volume_bc_stats_t* out_stats)
+{
+    if(((format != VOLUME_FORMAT_RGBA8) && (format != VOLUME_FORMAT_R8)) || (src.bytes_per_voxel != volume_format_get_bytes_per_voxel(format))){
+        return false;
+    }
+
+    double start = get_current_time_seconds();
+
+    unsigned int channels = volume_format_get_num_channels(format);
+    out_volume->width           = src.width;
+    out_volume->height          = src.height;
+    out_volume->depth           = src.depth;
+    out_volume->num_channels    = channels;
+    out_volume->data.resize(volume_bc_get_size(src.width, src.height, src.depth, channels));
+
+    bc_encode_pass_t pass;
+    pass.src = src;
+    pass.dst = out_volume;
+    pass.slab_errors.resize(out_volume->get_view().get_num_bricks_z());
+
+    unsigned int num_workers = job_parallel_for((unsigned int)pass.slab_errors.size(), encode_slab, &pass, max_workers);
+
+    if(nullptr != out_stats){
+        memset(out_stats, 0, sizeof(*out_stats));
+        out_stats->seconds          = get_current_time_seconds() - start;
+        out_stats->num_workers      = num_workers;
+        out_stats->num_channels     = channels;
+        out_stats->raw_bytes        = (size_t)src.width * src.height * src.depth * channels;
+        out_stats->compressed_bytes = out_volume->data.size();
+
+        double num_voxels = (double)src.width * src.height * src.depth;
+        for(unsigned int c = 0; c < channels; ++c){
+            double sse = 0.0;
+            for(const bc_error_t& error : pass.slab_errors){
+                sse += error.sse[c];
+                out_stats->max_error[c] = (error.max_error[c] > out_stats->max_error[c]) ? error.max_error[c] : out_stats->max_error[c];
+            }
+            out_stats->mse[c] = sse / num_voxels;
+        }
+    }
+    return true;
+}
+
+void volume_bc_decode_brick(const volume_bc_view_t& src, unsigned int bx, unsigned int by, unsigned int bz, unsigned char* out, size_t row_pitch, size_t slice_pitch)
+{
+    decode_brick(src, bx, by, bz, out, row_pitch, slice_pitch, cpu_get_simd_level());
+}
+
+bool volume_bc_decode(const volume_bc_view_t& src, volume_buffer_t* out_volume, unsigned int max_workers, volume_bc_stats_t* out_stats)
+{
+    double start = get_current_time_seconds();
+
+    if((nullptr == src.data) || (src.num_channels == 0) || (src.num_channels > VOLUME_BC_MAX_CHANNELS)){
+        out_volume->resize(0, 0, 0, 0);
+        return false;
+    }
+
+    out_volume->resize(src.width, src.height, src.depth, src.num_channels);
+
+    bc_decode_pass_t pass;
+    pass.src        = src;
+    pass.dst        = out_volume;
+    pass.simd_level = cpu_get_simd_level();
+    unsigned int num_workers = job_parallel_for(src.get_num_bricks_z(), decode_slab, &pass, max_workers);
+
+    if(nullptr != out_stats){
+        memset(out_stats, 0, sizeof(*out_stats));
+        out_stats->seconds          = get_current_time_seconds() - start;
+        out_stats->num_workers      = num_workers;
+        out_stats->num_channels     = src.num_channels;
+        out_stats->raw_bytes        = out_volume->data.size();
+        out_stats->compressed_bytes = src.get_size();
+    }
+    return true;
+}
+
+void volume_bc_measure_error(const volume_view_t& reference, const volume_view_t& decoded, volume_bc_stats_t* out_stats)
+{
+    unsigned int channels = reference.bytes_per_voxel;
+
+    double sse[VOLUME_BC_MAX_CHANNELS] = { 0.0 };
+    unsigned int max_error[VOLUME_BC_MAX_CHANNELS] = { 0 };
+    for(unsigned int z = 0; z < reference.depth; ++z){
+        for(unsigned int y = 0; y < reference.height; ++y){
+            const unsigned char* a = reference.get_voxel(0, y, z);
+            const unsigned char* b = decoded.get_voxel(0, y, z);
+            for(unsigned int i = 0; i < reference.width * channels; ++i){
+                int diff = (int)a[i] - (int)b[i];
+                unsigned int abs_diff = (unsigned int)((diff < 0) ? -diff : diff);
+                unsigned int c = i % channels;
+                sse[c] += (double)(diff * diff);
+                max_error[c] = (abs_diff > max_error[c]) ? abs_diff : max_error[c];
+            }
+        }
+    }
+
+    double num_voxels = (double)reference.width * reference.height * reference.depth;
+    out_stats->num_channels = channels;
+    for(unsigned int c = 0; c < channels; ++c){
+        out_stats->mse[c] = sse[c] / num_voxels;
+        out_stats->max_error[c] = max_error[c];
+    }
+}
+
+//-----------------------------------------------------
+// Brick Cache
+
+void volume_bc_cache_init(volume_bc_cache_t* cache, const volume_bc_view_t& source, size_t max_bytes)
+{
+    cache->source       = source;
+    cache->num_pages_x  = (source.width + VOLUME_BC_PAGE_SIZE - 1) / VOLUME_BC_PAGE_SIZE;
+    cache->num_pages_y  = (source.height + VOLUME_BC_PAGE_SIZE - 1) / VOLUME_BC_PAGE_SIZE;
+    cache->num_pages_z  = (source.depth + VOLUME_BC_PAGE_SIZE - 1) / VOLUME_BC_PAGE_SIZE;
+    cache->page_bytes   = (size_t)VOLUME_BC_PAGE_SIZE * VOLUME_BC_PAGE_SIZE * VOLUME_BC_PAGE_SIZE * source.num_channels;
+
+    // Never more slots than pages, a cache bigger than the volume is just the volume
+    size_t num_pages = (size_t)cache->num_pages_x * cache->num_pages_y * cache->num_pages_z;
+    size_t num_slots = max_bytes / cache->page_bytes;
+    num_slots = (num_slots < num_pages) ? num_slots : num_pages;
+    cache->num_slots = (num_slots > 0) ? (unsigned int)num_slots : 1;
+
+    cache->page_slots.resize(num_pages);
+    cache->slot_pages.resize(cache->num_slots);
+    cache->slot_last_used.resize(cache->num_slots);
+    cache->slot_data.resize(cache->num_slots * cache->page_bytes);
+    volume_bc_cache_clear(cache);
+}
+
+void volume_bc_cache_clear(volume_bc_cache_t* cache)
+{
+    std::fill(cache->page_slots.begin(), cache->page_slots.end(), -1);
+    std::fill(cache->slot_pages.begin(), cache->slot_pages.end(), -1);
+    std::fill(cache->slot_last_used.begin(), cache->slot_last_used.end(), 0);
+
+    cache->tick             = 0;
+    cache->num_hits         = 0;
+    cache->num_misses       = 0;
+    cache->num_evictions    = 0;
+    cache->decode_seconds   = 0.0;
+}
+
+bool volume_bc_cache_request(volume_bc_cache_t* cache, const volume_brick_t& region, unsigned int max_workers)
+{
+    if((region.min_x >= region.max_x) || (region.min_y >= region.max_y) || (region.min_z >= region.max_z)){
+        return true;
+    }
+
+    unsigned int first_x = region.min_x / VOLUME_BC_PAGE_SIZE;
+    unsigned int first_y = region.min_y / VOLUME_BC_PAGE_SIZE;
+    unsigned int first_z = region.min_z / VOLUME_BC_PAGE_SIZE;
+    unsigned int end_x = min_uint(((region.max_x - 1) / VOLUME_BC_PAGE_SIZE) + 1, cache->num_pages_x);
+    unsigned int end_y = min_uint(((region.max_y - 1) / VOLUME_BC_PAGE_SIZE) + 1, cache->num_pages_y);
+    unsigned int end_z = min_uint(((region.max_z - 1) / VOLUME_BC_PAGE_SIZE) + 1, cache->num_pages_z);
+    if((first_x >= end_x) || (first_y >= end_y) || (first_z >= end_z)){
+        return true;
+    }
+
+    size_t num_pages = (size_t)(end_x - first_x) * (end_y - first_y) * (end_z - first_z);
+    if(num_pages > cache->num_slots){
+        return false;
+    }
+
+    // Stamp what's already in first so none of it gets evicted for the misses
+    ++cache->tick;
+
+    bc_page_pass_t pass;
+    pass.cache      = cache;
+    pass.simd_level = cpu_get_simd_level();
+    for(unsigned int pz = first_z; pz < end_z; ++pz){
+        for(unsigned int py = first_y; py < end_y; ++py){
+            for(unsigned int px = first_x; px < end_x; ++px){
+                unsigned int page = ((pz * cache->num_pages_y) + py) * cache->num_pages_x + px;
+                int slot = cache->page_slots[page];
+                if(slot >= 0){
+                    cache->slot_last_used[slot] = cache->tick;
+                    ++cache->num_hits;
+                }else{
+                    pass.pages.push_back(page);
+                }
+            }
+        }
+    }
+
+    for(unsigned int page : pass.pages){
+        int slot = find_slot(*cache);
+        int old_page = cache->slot_pages[slot];
+        if(old_page >= 0){
+            cache->page_slots[old_page] = -1;
+            ++cache->num_evictions;
+        }
+
+        cache->slot_pages[slot] = (int)page;
+        cache->slot_last_used[slot] = cache->tick;
+        cache->page_slots[page] = slot;
+        ++cache->num_misses;
+    }
+
+    if(!pass.pages.empty()){
+        double start = get_current_time_seconds();
+        job_parallel_for((unsigned int)pass.pages.size(), decode_page, &pass, max_workers);
+        cache->decode_seconds += get_current_time_seconds() - start;
+    }
+    return true;
+}
+
+const unsigned char* volume_bc_cache_get_voxel(volume_bc_cache_t* cache, unsigned int x, unsigned int y, unsigned int z)
+{
+    // num_slots is only 0 before volume_bc_cache_init, when there are no pages to look up either
+    if(cache->num_slots == 0){
+        return nullptr;
+    }
+    if((x >= cache->source.width) || (y >= cache->source.height) || (z >= cache->source.depth)){
+        return nullptr;
+    }
+
+    unsigned int page = (((z / VOLUME_BC_PAGE_SIZE) * cache->num_pages_y) + (y / VOLUME_BC_PAGE_SIZE)) * cache->num_pages_x + (x / VOLUME_BC_PAGE_SIZE);
+    if(cache->page_slots[page] < 0){
+        // One page always fits, but don't index with a -1 slot if that ever changes
+        volume_brick_t region = { x, y, z, x + 1, y + 1, z + 1 };
+        if(!volume_bc_cache_request(cache, region, 1) || (cache->page_slots[page] < 0)){
+            return nullptr;
+        }
+    }
+
+    unsigned int local_x = x % VOLUME_BC_PAGE_SIZE;
+    unsigned int local_y = y % VOLUME_BC_PAGE_SIZE;
+    unsigned int local_z = z % VOLUME_BC_PAGE_SIZE;
+    size_t offset = ((((size_t)local_z * VOLUME_BC_PAGE_SIZE) + local_y) * VOLUME_BC_PAGE_SIZE + local_x) * cache->source.num_channels;
+    return cache->slot_data.data() + ((size_t)cache->page_slots[page] * cache->page_bytes) + offset;
+}
@@ -0,0 +1,179 @@
+#pragma once
+
+#include "Engine/Volume/volume_buffer.h"
+#include "Engine/Volume/volume_fill.h"
+
+#include <vector>
+
+//-----------------------------------------------------
+// Volume Block Compression
+//
+// BC4 carried over to 3D. Every 4x4x4 brick of an 8 bit channel is stored as
+// two endpoint bytes and 64 three bit indices picking one of 8 values spaced
+// evenly between them: 26 bytes instead of 64. Channels are compressed
+// separately, and a brick's channel blocks sit next to each other so decoding
+// a brick touches one contiguous run. Bricks are laid out x fastest like
+// voxels; edge bricks of sizes that aren't a multiple of 4 are padded by
+// repeating the last voxel.
+//
+// Blocks are fixed size, so any brick can be found and expanded on its own.
+// volume_bc_decode expands a whole volume across the job system, and
+// volume_bc_cache_t expands pages on demand into a fixed amount of CPU memory
+// for callers that only need part of a volume at a time.
+//
+// Only 8 bit unorm formats (RGBA8 and R8) compress.
+
+#define VOLUME_BC_BRICK_SIZE        4
+#define VOLUME_BC_BRICK_VOXELS      (VOLUME_BC_BRICK_SIZE * VOLUME_BC_BRICK_SIZE * VOLUME_BC_BRICK_SIZE)
+#define VOLUME_BC_BLOCK_BYTES       26      // 2 endpoints + 64 * 3 bit indices
+#define VOLUME_BC_MAX_CHANNELS      4
+
+// Edge of a volume_bc_cache_t page in voxels, a whole number of bricks
+#define VOLUME_BC_PAGE_SIZE         16
+
+// Read-only compressed volume, owned by a volume_bc_t or a mapped volume file
+struct volume_bc_view_t
+{
+    const unsigned char*    data;
+    unsigned int            width;
+    unsigned int            height;
+    unsigned int            depth;
+    unsigned int            num_channels;
+
+    unsigned int            get_num_bricks_x() const    { return (width + VOLUME_BC_BRICK_SIZE - 1) / VOLUME_BC_BRICK_SIZE; }
+    unsigned int            get_num_bricks_y() const    { return (height + VOLUME_BC_BRICK_SIZE - 1) / VOLUME_BC_BRICK_SIZE; }
+    unsigned int            get_num_bricks_z() const    { return (depth + VOLUME_BC_BRICK_SIZE - 1) / VOLUME_BC_BRICK_SIZE; }
+    size_t                  get_brick_bytes() const     { return (size_t)num_channels * VOLUME_BC_BLOCK_BYTES; }
+    size_t                  get_size() const            { return (size_t)get_num_bricks_x() * get_num_bricks_y() * get_num_bricks_z() * get_brick_bytes(); }
+
+    const unsigned char*    get_brick(unsigned int bx, unsigned int by, unsigned int bz) const
+    {
+        size_t brick_index = ((size_t)bz * get_num_bricks_y() + by) * get_num_bricks_x() + bx;
+        return data + (brick_index * get_brick_bytes());
+    }
+};
+
+struct volume_bc_t
+{
+    unsigned int                width;
+    unsigned int                height;
+    unsigned int                depth;
+    unsigned int                num_channels;
+    std::vector<unsigned char>  data;
+
+    volume_bc_t()
+        :width(0)
+        ,height(0)
+        ,depth(0)
+        ,num_channels(0)
+    {}
+
+    volume_bc_view_t get_view() const
+    {
+        volume_bc_view_t view;
+        view.data           = data.data();
+        view.width          = width;
+        view.height         = height;
+        view.depth          = depth;
+        view.num_channels   = num_channels;
+        return view;
+    }
+};
+
+struct volume_bc_stats_t
+{
+    double          seconds;
+    unsigned int    num_workers;
+    unsigned int    num_channels;
+    size_t          raw_bytes;
+    size_t          compressed_bytes;
+
+    // Against the source, only filled in by the encoder and volume_bc_measure_error
+    double          mse[VOLUME_BC_MAX_CHANNELS];
+    unsigned int    max_error[VOLUME_BC_MAX_CHANNELS];
+
+    double ratio() const                            { return (compressed_bytes > 0) ? (double)raw_bytes / (double)compressed_bytes : 0.0; }
+    double bytes_per_second() const                 { return (seconds > 0.0) ? (double)raw_bytes / seconds : 0.0; }
+    double psnr(unsigned int channel) const;        // dB, infinite when lossless
+};
+
+size_t          volume_bc_get_size(unsigned int width, unsigned int height, unsigned int depth, unsigned int num_channels);
+
+// The compressed format that goes with a channel count
+VolumeFormat    volume_bc_get_format(unsigned int num_channels);
+
+// Compresses <src>, which must be RGBA8 or R8. Endpoints start at each block's
+// min/max and are refit by least squares, so this is meant for offline bakes
+// rather than load time. <max_workers> 0 uses every core, needs job_system_init.
+bool            volume_bc_encode(const volume_view_t& src, VolumeFormat format, volume_bc_t* out_volume, unsigned int max_workers = 0, volume_bc_stats_t* out_stats = nullptr);
+
+// Expands one brick to <out>, which points at the brick's first voxel. Voxels
+// past the edge of the volume aren't written.
+void            volume_bc_decode_brick(const volume_bc_view_t& src, unsigned int bx, unsigned int by, unsigned int bz, unsigned char* out, size_t row_pitch, size_t slice_pitch);
+
+// Expands the whole volume, slabs of bricks split across GENERIC jobs plus the caller.
+// Fails on a view with no data or an unsupported channel count.
+bool            volume_bc_decode(const volume_bc_view_t& src, volume_buffer_t* out_volume, unsigned int max_workers = 0, volume_bc_stats_t* out_stats = nullptr);
+
+// Per channel error of <decoded> against <reference>, both 8 bit with the same size
+void            volume_bc_measure_error(const volume_view_t& reference, const volume_view_t& decoded, volume_bc_stats_t* out_stats);
+
+//-----------------------------------------------------
+// Brick Cache
+//
+// Decoded pages of VOLUME_BC_PAGE_SIZE^3 voxels kept in a fixed number of
+// slots, least recently requested pages are evicted first. Requesting a
+// region decodes every page it's missing in parallel and blocks until
+// they're in, after that voxel reads are plain loads.
+//
+// The cache belongs to one thread: requests and reads must come from the
+// same place, the jobs only ever write slots handed to them.
+
+struct volume_bc_cache_t
+{
+    volume_bc_view_t            source;
+    unsigned int                num_pages_x;
+    unsigned int                num_pages_y;
+    unsigned int                num_pages_z;
+    unsigned int                num_slots;
+    size_t                      page_bytes;
+
+    std::vector<int>            page_slots;         // page -> slot, -1 while not resident
+    std::vector<int>            slot_pages;         // slot -> page, -1 while free
+    std::vector<unsigned int>   slot_last_used;
+    std::vector<unsigned char>  slot_data;
+    unsigned int                tick;
+
+    size_t                      num_hits;           // pages, counted per request
+    size_t                      num_misses;
+    size_t                      num_evictions;
+    double                      decode_seconds;
+
+    volume_bc_cache_t()
+        :num_pages_x(0)
+        ,num_pages_y(0)
+        ,num_pages_z(0)
+        ,num_slots(0)
+        ,page_bytes(0)
+        ,tick(0)
+        ,num_hits(0)
+        ,num_misses(0)
+        ,num_evictions(0)
+        ,decode_seconds(0.0)
+    {}
+};
+
+// <source> has to outlive the cache. Holds at least one page whatever <max_bytes> says.
+void            volume_bc_cache_init(volume_bc_cache_t* cache, const volume_bc_view_t& source, size_t max_bytes);
+
+// Drops every page and zeroes the counters
+void            volume_bc_cache_clear(volume_bc_cache_t* cache);
+
+// Makes every page under <region> resident. Fails without decoding anything
+// if the region needs more pages than the cache has slots.
+bool            volume_bc_cache_request(volume_bc_cache_t* cache, const volume_brick_t& region, unsigned int max_workers = 0);
+
+// Voxel from a resident page. A page that isn't in yet is decoded on the
+// spot on this thread, which works but is the slow path. nullptr for a voxel
+// outside the volume or a cache that was never initialised.
+const unsigned char* volume_bc_cache_get_voxel(volume_bc_cache_t* cache, unsigned int x, unsigned int y, unsigned int z);
@@ -0,0 +1,285 @@
+#pragma once
+
+#include <stddef.h>
+#include <string.h>
+#include <vector>
+
+//-----------------------------------------------------
+// Volume Buffer
+//
+// Plain CPU-side 3D voxel storage, no device required. Voxels are linear by
+// default, x fastest then y then z, the same layout RHITexture3D uploads and
+// the baked .dat/.texture files use.
+//
+// Volumes can also be bricked: 8x8x8 bricks of linear voxels, the bricks
+// themselves x fastest then y then z. A ray in any direction then stays in a
+// few KB for 8 voxels instead of striding a slice per step. Bricked volumes
+// are padded up to whole bricks and are CPU only, volume_convert_layout
+// turns them back into linear ones for an upload or a save.
+
+#define VOLUME_BRICK_SHIFT      3
+#define VOLUME_BRICK_SIZE       (1 << VOLUME_BRICK_SHIFT)
+#define VOLUME_BRICK_MASK       (VOLUME_BRICK_SIZE - 1)
+#define VOLUME_BRICK_VOXELS     (VOLUME_BRICK_SIZE * VOLUME_BRICK_SIZE * VOLUME_BRICK_SIZE)
+
+// Voxel formats a volume can be stored in, values are written to volume files
+enum VolumeFormat
+{
+    VOLUME_FORMAT_RGBA8 = 0,
+    VOLUME_FORMAT_R8,
+    VOLUME_FORMAT_R16F,
+    VOLUME_FORMAT_BC_RGBA8,     // 4x4x4 brick compressed, see volume_bc.h
+    VOLUME_FORMAT_BC_R8,
+    NUM_VOLUME_FORMATS
+};
+
+enum VolumeLayout
+{
+    VOLUME_LAYOUT_LINEAR = 0,
+    VOLUME_LAYOUT_BRICKED,
+    NUM_VOLUME_LAYOUTS
+};
+
+inline const char* volume_layout_get_name(VolumeLayout layout)
+{
+    return (layout == VOLUME_LAYOUT_BRICKED) ? "bricked" : "linear";
+}
+
+// Bricks along an axis of <voxels>, the last one padded
+inline unsigned int volume_layout_get_num_bricks(unsigned int voxels)
+{
+    return (voxels + VOLUME_BRICK_MASK) >> VOLUME_BRICK_SHIFT;
+}
+
+// Byte offset of a voxel given the volume's pitches. Bricked pitches are per
+// row and per slice of bricks.
+inline size_t volume_layout_get_voxel_offset(VolumeLayout layout, unsigned int x, unsigned int y, unsigned int z, unsigned int bytes_per_voxel, size_t row_pitch, size_t slice_pitch)
+{
+    if(layout == VOLUME_LAYOUT_BRICKED){
+        size_t brick_offset = ((size_t)(z >> VOLUME_BRICK_SHIFT) * slice_pitch) + ((size_t)(y >> VOLUME_BRICK_SHIFT) * row_pitch) + ((size_t)(x >> VOLUME_BRICK_SHIFT) * VOLUME_BRICK_VOXELS * bytes_per_voxel);
+        unsigned int voxel_index = ((z & VOLUME_BRICK_MASK) << (2 * VOLUME_BRICK_SHIFT)) | ((y & VOLUME_BRICK_MASK) << VOLUME_BRICK_SHIFT) | (x & VOLUME_BRICK_MASK);
+        return brick_offset + ((size_t)voxel_index * bytes_per_voxel);
+    }
+    return ((size_t)z * slice_pitch) + ((size_t)y * row_pitch) + ((size_t)x * bytes_per_voxel);
+}
+
+inline bool volume_format_is_compressed(VolumeFormat format)
+{
+    return (format == VOLUME_FORMAT_BC_RGBA8) || (format == VOLUME_FORMAT_BC_R8);
+}
+
+// What a compressed format decodes to, uncompressed formats map to themselves
+inline VolumeFormat volume_format_get_decoded(VolumeFormat format)
+{
+    switch(format){
+        case VOLUME_FORMAT_BC_RGBA8:    return VOLUME_FORMAT_RGBA8;
+        case VOLUME_FORMAT_BC_R8:       return VOLUME_FORMAT_R8;
+        default:                        return format;
+    }
+}
+
+// 0 for compressed formats, they only have a size per brick
+inline unsigned int volume_format_get_bytes_per_voxel(VolumeFormat format)
+{
+    switch(format){
+        case VOLUME_FORMAT_RGBA8:   return 4;
+        case VOLUME_FORMAT_R8:      return 1;
+        case VOLUME_FORMAT_R16F:    return 2;
+        default:                    return 0;
+    }
+}
+
+inline const char* volume_format_get_name(VolumeFormat format)
+{
+    switch(format){
+        case VOLUME_FORMAT_RGBA8:       return "rgba8";
+        case VOLUME_FORMAT_R8:          return "r8";
+        case VOLUME_FORMAT_R16F:        return "r16f";
+        case VOLUME_FORMAT_BC_RGBA8:    return "bc_rgba8";
+        case VOLUME_FORMAT_BC_R8:       return "bc_r8";
+        default:                        return "unknown";
+    }
+}
+
+inline unsigned int volume_format_get_num_channels(VolumeFormat format)
+{
+    return ((format == VOLUME_FORMAT_RGBA8) || (format == VOLUME_FORMAT_BC_RGBA8)) ? 4 : 1;
+}
+
+// IEEE half <-> float for R16F voxels, rounds to nearest even
+inline float volume_half_to_float(unsigned short half)
+{
+    unsigned int sign = ((unsigned int)half & 0x8000) << 16;
+    unsigned int exponent = ((unsigned int)half >> 10) & 0x1f;
+    unsigned int mantissa = (unsigned int)half & 0x3ff;
+
+    if(exponent == 0){
+        float value = (float)mantissa * (1.0f / 16777216.0f);   // zero or denormal, mantissa * 2^-24
+        return (sign != 0) ? -value : value;
+    }
+
+    unsigned int bits = (exponent == 31)
+        ? (sign | 0x7f800000 | (mantissa << 13))
+        : (sign | ((exponent + 112) << 23) | (mantissa << 13));
+
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+inline unsigned short volume_float_to_half(float value)
+{
+    unsigned int bits;
+    memcpy(&bits, &value, sizeof(bits));
+
+    unsigned int sign = (bits >> 16) & 0x8000;
+    unsigned int float_exponent = (bits >> 23) & 0xff;
+    unsigned int mantissa = bits & 0x7fffff;
+
+    if(float_exponent == 0xff){
+        return (unsigned short)(sign | 0x7c00 | ((mantissa != 0) ? 0x200 : 0));
+    }
+
+    int exponent = (int)float_exponent - 127 + 15;
+    if(exponent >= 31){
+        return (unsigned short)(sign | 0x7c00);
+    }
+
+    if(exponent <= 0){
+        if(exponent < -10){
+            return (unsigned short)sign;
+        }
+
+        // Denormal, shift the implicit bit in and round what falls off
+        mantissa |= 0x800000;
+        unsigned int shift = (unsigned int)(14 - exponent);
+        unsigned int half_mantissa = mantissa >> shift;
+        unsigned int remainder = mantissa & ((1U << shift) - 1);
+        unsigned int halfway = 1U << (shift - 1);
+        if((remainder > halfway) || ((remainder == halfway) && (half_mantissa & 1))){
+            ++half_mantissa;
+        }
+        return (unsigned short)(sign | half_mantissa);
+    }
+
+    // A carry out of the mantissa bumps the exponent, which is the right answer
+    unsigned int half = sign | ((unsigned int)exponent << 10) | (mantissa >> 13);
+    unsigned int remainder = mantissa & 0x1fff;
+    if((remainder > 0x1000) || ((remainder == 0x1000) && (half & 1))){
+        ++half;
+    }
+    return (unsigned short)half;
+}
+
+// Read-only window onto voxels someone else owns, a volume_buffer_t or a
+// mapped volume file. Pitches are explicit so a slice of a bigger volume is
+// still a view.
+struct volume_view_t
+{
+    const unsigned char*    data;
+    unsigned int            width;
+    unsigned int            height;
+    unsigned int            depth;
+    unsigned int            bytes_per_voxel;
+    size_t                  row_pitch;
+    size_t                  slice_pitch;
+    VolumeLayout            layout;
+
+    volume_view_t()
+        :data(nullptr)
+        ,width(0)
+        ,height(0)
+        ,depth(0)
+        ,bytes_per_voxel(0)
+        ,row_pitch(0)
+        ,slice_pitch(0)
+        ,layout(VOLUME_LAYOUT_LINEAR)
+    {}
+
+    size_t get_size() const
+    {
+        return slice_pitch * ((layout == VOLUME_LAYOUT_BRICKED) ? volume_layout_get_num_bricks(depth) : depth);
+    }
+
+    const unsigned char*    get_voxel(unsigned int x, unsigned int y, unsigned int z) const
+    {
+        return data + volume_layout_get_voxel_offset(layout, x, y, z, bytes_per_voxel, row_pitch, slice_pitch);
+    }
+
+    // Voxels from <x> on that sit next to each other in memory
+    unsigned int            get_row_run(unsigned int x) const   { return (layout == VOLUME_LAYOUT_BRICKED) ? (VOLUME_BRICK_SIZE - (x & VOLUME_BRICK_MASK)) : (width - x); }
+
+    // Linear views only
+    volume_view_t get_slice(unsigned int z) const
+    {
+        volume_view_t slice = *this;
+        slice.data  = get_voxel(0, 0, z);
+        slice.depth = 1;
+        return slice;
+    }
+};
+
+struct volume_buffer_t
+{
+    unsigned int                width;
+    unsigned int                height;
+    unsigned int                depth;
+    unsigned int                bytes_per_voxel;
+    VolumeLayout                layout;
+    std::vector<unsigned char>  data;
+
+    volume_buffer_t()
+        :width(0)
+        ,height(0)
+        ,depth(0)
+        ,bytes_per_voxel(0)
+        ,layout(VOLUME_LAYOUT_LINEAR)
+    {}
+
+    void resize(unsigned int w, unsigned int h, unsigned int d, unsigned int voxel_size, VolumeLayout new_layout = VOLUME_LAYOUT_LINEAR)
+    {
+        width = w;
+        height = h;
+        depth = d;
+        bytes_per_voxel = voxel_size;
+        layout = new_layout;
+        data.resize(get_slice_pitch() * ((layout == VOLUME_LAYOUT_BRICKED) ? volume_layout_get_num_bricks(d) : d));
+    }
+
+    size_t                  get_num_voxels() const              { return (size_t)width * height * depth; }
+    size_t get_row_pitch() const
+    {
+        if(layout == VOLUME_LAYOUT_BRICKED){
+            return (size_t)volume_layout_get_num_bricks(width) * VOLUME_BRICK_VOXELS * bytes_per_voxel;
+        }
+        return (size_t)width * bytes_per_voxel;
+    }
+    size_t get_slice_pitch() const
+    {
+        return get_row_pitch() * ((layout == VOLUME_LAYOUT_BRICKED) ? volume_layout_get_num_bricks(height) : height);
+    }
+    size_t                  get_voxel_offset(unsigned int x, unsigned int y, unsigned int z) const
+    {
+        return volume_layout_get_voxel_offset(layout, x, y, z, bytes_per_voxel, get_row_pitch(), get_slice_pitch());
+    }
+
+    // Voxels from <x> on that sit next to each other in memory
+    unsigned int            get_row_run(unsigned int x) const   { return (layout == VOLUME_LAYOUT_BRICKED) ? (VOLUME_BRICK_SIZE - (x & VOLUME_BRICK_MASK)) : (width - x); }
+
+    unsigned char*          get_voxel(unsigned int x, unsigned int y, unsigned int z)           { return data.data() + get_voxel_offset(x, y, z); }
+    const unsigned char*    get_voxel(unsigned int x, unsigned int y, unsigned int z) const     { return data.data() + get_voxel_offset(x, y, z); }
+
+    volume_view_t get_view() const
+    {
+        volume_view_t view;
+        view.data               = data.data();
+        view.width              = width;
+        view.height             = height;
+        view.depth              = depth;
+        view.bytes_per_voxel    = bytes_per_voxel;
+        view.row_pitch          = get_row_pitch();
+        view.slice_pitch        = get_slice_pitch();
+        view.layout             = layout;
+        return view;
+    }
+};
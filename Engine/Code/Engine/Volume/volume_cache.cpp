@@ -0,0 +1,119 @@
+#include "Engine/Volume/volume_cache.h"
+#include "Engine/Core/crt_compat.h"
+
+#include "Engine/Core/file_system.h"
+
+#include <stdio.h>
+#include <algorithm>
+#include <vector>
+
+//-----------------------------------------------------
+// Internal helpers
+
+static const uint64_t FNV_PRIME = 0x100000001b3ULL;
+
+//-----------------------------------------------------
+// Public API
+
+uint64_t volume_cache_hash(const void* data, size_t byte_count, uint64_t hash)
+{
+    const unsigned char* bytes = (const unsigned char*)data;
+    for(size_t i = 0; i < byte_count; ++i){
+        hash ^= bytes[i];
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+bool volume_cache_init(volume_cache_t* cache, const char* directory, uint64_t max_bytes)
+{
+    cache->directory = directory;
+    if(cache->directory.empty()){
+        cache->directory = "./";
+    }else if((cache->directory.back() != '/') && (cache->directory.back() != '\\')){
+        cache->directory += "/";
+    }
+
+    cache->max_bytes = max_bytes;
+    return file_create_directories(cache->directory.c_str());
+}
+
+std::string volume_cache_get_path(const volume_cache_t& cache, uint64_t key)
+{
+    char filename[32];
+    sprintf_s(filename, "%016llx%s", (unsigned long long)key, VOLUME_CACHE_FILE_EXTENSION);
+    return cache.directory + filename;
+}
+
+bool volume_cache_open(const volume_cache_t& cache, uint64_t key, volume_file_t* out_file)
+{
+    std::string path = volume_cache_get_path(cache, key);
+
+    // A key collision shows up as a different key in the header, a damaged file as a bad checksum
+    if(!volume_file_open(out_file, path.c_str(), VOLUME_FILE_VERIFY_CHECKSUM)){
+        return false;
+    }
+
+    if(out_file->header->key != key){
+        volume_file_close(out_file);
+        return false;
+    }
+
+    file_touch(path.c_str());
+    return true;
+}
+
+bool volume_cache_load(const volume_cache_t& cache, uint64_t key, volume_buffer_t* out_volume)
+{
+    volume_file_t file;
+    if(!volume_cache_open(cache, key, &file)){
+        return false;
+    }
+
+    bool copied = volume_file_copy_mip(file, 0, out_volume);
+    volume_file_close(&file);
+    return copied;
+}
+
+bool volume_cache_store(const volume_cache_t& cache, uint64_t key, VolumeFormat format, const volume_view_t* mips, unsigned int num_mips)
+{
+    std::string path = volume_cache_get_path(cache, key);
+    std::string temp_path = path + ".tmp";
+
+    // Write then rename, so a reader never picks up a partial entry
+    bool written = volume_file_save(temp_path.c_str(), format, mips, num_mips, key);
+    if(!written || !file_replace(temp_path.c_str(), path.c_str())){
+        file_delete(temp_path.c_str());
+        return false;
+    }
+
+    volume_cache_trim(cache);
+    return true;
+}
+
+uint64_t volume_cache_trim(const volume_cache_t& cache)
+{
+    std::vector<file_entry_t> entries;
+    file_find(cache.directory.c_str(), VOLUME_CACHE_FILE_EXTENSION, &entries);
+
+    uint64_t total_bytes = 0;
+    for(const file_entry_t& entry : entries){
+        total_bytes += entry.size;
+    }
+
+    // sort newest to oldest
+    std::sort(entries.begin(), entries.end(), [](const file_entry_t& a, const file_entry_t& b) -> bool{
+        return a.last_write_time > b.last_write_time;
+    });
+
+    while((total_bytes > cache.max_bytes) && (entries.size() > 1)){
+        const file_entry_t& oldest = entries.back();
+
+        std::string path = cache.directory + oldest.name;
+        if(file_delete(path.c_str())){
+            total_bytes -= oldest.size;
+        }
+        entries.pop_back();
+    }
+    return total_bytes;
+}
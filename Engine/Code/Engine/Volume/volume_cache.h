@@ -0,0 +1,46 @@
+#pragma once
+
+#include "Engine/Volume/volume_file.h"
+
+#include <stdint.h>
+#include <string>
+
+//-----------------------------------------------------
+// Volume Cache
+//
+// Content-addressed store for baked volumes. Callers hash whatever produced
+// a volume (parameters, resolution, format) into a 64 bit key, and each key
+// maps to one volume file (volume_file.h) in the cache directory, with the key
+// repeated in its header to catch collisions. Loads refresh a file's timestamp,
+// stores evict the least recently used files once the directory grows past
+// max_bytes.
+
+#define VOLUME_CACHE_HASH_SEED      0xcbf29ce484222325ULL
+#define VOLUME_CACHE_FILE_EXTENSION VOLUME_FILE_EXTENSION
+
+struct volume_cache_t
+{
+    std::string     directory;  // always ends in a slash
+    uint64_t        max_bytes;
+};
+
+// FNV-1a, chain calls by passing the previous result as <hash>
+uint64_t        volume_cache_hash(const void* data, size_t byte_count, uint64_t hash = VOLUME_CACHE_HASH_SEED);
+
+// Creates the directory (and any missing parents)
+bool            volume_cache_init(volume_cache_t* cache, const char* directory, uint64_t max_bytes);
+std::string     volume_cache_get_path(const volume_cache_t& cache, uint64_t key);
+
+// Maps the entry for <key>, checksum verified. The caller closes it, views into it
+// (e.g. every mip for an upload) stay valid until then.
+bool            volume_cache_open(const volume_cache_t& cache, uint64_t key, volume_file_t* out_file);
+
+// Copies mip 0 of the entry for <key>
+bool            volume_cache_load(const volume_cache_t& cache, uint64_t key, volume_buffer_t* out_volume);
+
+// <mips> largest first, same rules as volume_file_save
+bool            volume_cache_store(const volume_cache_t& cache, uint64_t key, VolumeFormat format, const volume_view_t* mips, unsigned int num_mips);
+
+// Deletes least recently used entries until the cache fits in max_bytes, the
+// newest entry is always kept. Returns the bytes still in use.
+uint64_t        volume_cache_trim(const volume_cache_t& cache);
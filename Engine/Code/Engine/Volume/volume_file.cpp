@@ -0,0 +1,362 @@
+#include "Engine/Volume/volume_file.h"
+#include "Engine/Core/crt_compat.h"
+
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+//-----------------------------------------------------
+// Internal helpers
+
+static const uint64_t CHECKSUM_PRIME = 0x100000001b3ULL;
+
+static const unsigned char s_padding[VOLUME_FILE_DATA_ALIGNMENT] = { 0 };
+
+static uint64_t align_up(uint64_t value, uint64_t alignment)
+{
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+static unsigned int half_size(unsigned int size)
+{
+    return (size > 1) ? (size / 2) : 1;
+}
+
+static bool write_padding(FILE* file, uint64_t from, uint64_t to)
+{
+    size_t count = (size_t)(to - from);
+    return (count == 0) || (fwrite(s_padding, 1, count, file) == count);
+}
+
+static uint64_t get_mip_size(VolumeFormat format, unsigned int width, unsigned int height, unsigned int depth)
+{
+    if(volume_format_is_compressed(format)){
+        return volume_bc_get_size(width, height, depth, volume_format_get_num_channels(format));
+    }
+    return (uint64_t)width * height * depth * volume_format_get_bytes_per_voxel(format);
+}
+
+// Everything volume_file_get_mip relies on, so a truncated or hand edited file
+// fails here instead of reading past the mapping later
+static bool is_valid_header(const volume_file_header_t& header, uint64_t file_size)
+{
+    if((header.magic != VOLUME_FILE_MAGIC) || (header.version != VOLUME_FILE_VERSION) || (header.header_size != sizeof(volume_file_header_t))){
+        return false;
+    }
+
+    if((header.format >= NUM_VOLUME_FORMATS) || (header.num_mips == 0) || (header.num_mips > VOLUME_FILE_MAX_MIPS)){
+        return false;
+    }
+
+    VolumeFormat format = (VolumeFormat)header.format;
+    unsigned int width = header.width;
+    unsigned int height = header.height;
+    unsigned int depth = header.depth;
+
+    for(unsigned int i = 0; i < header.num_mips; ++i){
+        const volume_file_mip_t& mip = header.mips[i];
+        if((mip.width != width) || (mip.height != height) || (mip.depth != depth) || (width == 0) || (height == 0) || (depth == 0)){
+            return false;
+        }
+
+        uint64_t expected_size = get_mip_size(format, width, height, depth);
+        if((mip.size != expected_size) || ((mip.offset % VOLUME_FILE_DATA_ALIGNMENT) != 0) || (mip.offset < header.header_size) || (mip.offset + mip.size > file_size)){
+            return false;
+        }
+
+        width = half_size(width);
+        height = half_size(height);
+        depth = half_size(depth);
+    }
+    return true;
+}
+
+// Mips are already checked against the format, sizes come from the format
+static bool write_file(const char* filename, VolumeFormat format, const unsigned char* const* mip_data, const unsigned int (*mip_dims)[3], unsigned int num_mips, uint64_t key)
+{
+    volume_file_header_t header;
+    memset(&header, 0, sizeof(header));
+    header.magic        = VOLUME_FILE_MAGIC;
+    header.version      = VOLUME_FILE_VERSION;
+    header.header_size  = sizeof(header);
+    header.format       = format;
+    header.width        = mip_dims[0][0];
+    header.height       = mip_dims[0][1];
+    header.depth        = mip_dims[0][2];
+    header.num_mips     = num_mips;
+    header.key          = key;
+    header.checksum     = VOLUME_FILE_CHECKSUM_SEED;
+
+    uint64_t offset = align_up(sizeof(header), VOLUME_FILE_DATA_ALIGNMENT);
+    for(unsigned int i = 0; i < num_mips; ++i){
+        volume_file_mip_t& entry = header.mips[i];
+        entry.offset    = offset;
+        entry.width     = mip_dims[i][0];
+        entry.height    = mip_dims[i][1];
+        entry.depth     = mip_dims[i][2];
+        entry.size      = get_mip_size(format, entry.width, entry.height, entry.depth);
+
+        header.checksum = volume_file_checksum(mip_data[i], (size_t)entry.size, header.checksum);
+        offset = align_up(offset + entry.size, VOLUME_FILE_DATA_ALIGNMENT);
+    }
+
+    // Catches a chain that doesn't halve properly before anything hits the disk
+    if(!is_valid_header(header, offset)){
+        return false;
+    }
+
+    FILE* file;
+    errno_t error_code = fopen_s(&file, filename, "wb");
+    if(error_code != 0){
+        return false;
+    }
+
+    bool written = (fwrite(&header, sizeof(header), 1, file) == 1);
+    uint64_t position = sizeof(header);
+    for(unsigned int i = 0; written && (i < num_mips); ++i){
+        const volume_file_mip_t& entry = header.mips[i];
+        written = write_padding(file, position, entry.offset)
+            && (fwrite(mip_data[i], 1, (size_t)entry.size, file) == entry.size);
+        position = entry.offset + entry.size;
+    }
+    written = written && write_padding(file, position, offset);
+
+    fclose(file);
+    return written;
+}
+
+//-----------------------------------------------------
+// Public API
+
+uint64_t volume_file_checksum(const void* data, size_t byte_count, uint64_t hash)
+{
+    const unsigned char* bytes = (const unsigned char*)data;
+
+    size_t num_words = byte_count / sizeof(uint64_t);
+    for(size_t i = 0; i < num_words; ++i){
+        uint64_t word;
+        memcpy(&word, bytes + (i * sizeof(uint64_t)), sizeof(word));
+        hash ^= word;
+        hash *= CHECKSUM_PRIME;
+    }
+
+    for(size_t i = num_words * sizeof(uint64_t); i < byte_count; ++i){
+        hash ^= bytes[i];
+        hash *= CHECKSUM_PRIME;
+    }
+    return hash;
+}
+
+bool volume_file_save(const char* filename, VolumeFormat format, const volume_view_t* mips, unsigned int num_mips, uint64_t key)
+{
+    if((format >= NUM_VOLUME_FORMATS) || volume_format_is_compressed(format) || (num_mips == 0) || (num_mips > VOLUME_FILE_MAX_MIPS)){
+        return false;
+    }
+
+    unsigned int bytes_per_voxel = volume_format_get_bytes_per_voxel(format);
+    const unsigned char* mip_data[VOLUME_FILE_MAX_MIPS];
+    unsigned int mip_dims[VOLUME_FILE_MAX_MIPS][3];
+    for(unsigned int i = 0; i < num_mips; ++i){
+        const volume_view_t& mip = mips[i];
+        bool is_packed = (mip.layout == VOLUME_LAYOUT_LINEAR) && (mip.row_pitch == (size_t)mip.width * bytes_per_voxel) && (mip.slice_pitch == mip.row_pitch * mip.height);
+        if((mip.bytes_per_voxel != bytes_per_voxel) || !is_packed){
+            return false;
+        }
+
+        mip_data[i]     = mip.data;
+        mip_dims[i][0]  = mip.width;
+        mip_dims[i][1]  = mip.height;
+        mip_dims[i][2]  = mip.depth;
+    }
+    return write_file(filename, format, mip_data, mip_dims, num_mips, key);
+}
+
+bool volume_file_save_bc(const char* filename, const volume_bc_view_t* mips, unsigned int num_mips, uint64_t key)
+{
+    if((num_mips == 0) || (num_mips > VOLUME_FILE_MAX_MIPS)){
+        return false;
+    }
+
+    VolumeFormat format = volume_bc_get_format(mips[0].num_channels);
+    const unsigned char* mip_data[VOLUME_FILE_MAX_MIPS];
+    unsigned int mip_dims[VOLUME_FILE_MAX_MIPS][3];
+    for(unsigned int i = 0; i < num_mips; ++i){
+        if(mips[i].num_channels != mips[0].num_channels){
+            return false;
+        }
+
+        mip_data[i]     = mips[i].data;
+        mip_dims[i][0]  = mips[i].width;
+        mip_dims[i][1]  = mips[i].height;
+        mip_dims[i][2]  = mips[i].depth;
+    }
+    return write_file(filename, format, mip_data, mip_dims, num_mips, key);
+}
+
+bool volume_file_open(volume_file_t* out_file, const char* filename, unsigned int flags)
+{
+    *out_file = volume_file_t();
+
+    file_mapping_t mapping;
+    if(!file_map(filename, &mapping)){
+        return false;
+    }
+
+    if(mapping.size < sizeof(volume_file_header_t)){
+        file_unmap(&mapping);
+        return false;
+    }
+
+    out_file->header    = (const volume_file_header_t*)mapping.data;
+    out_file->base      = mapping.data;
+    out_file->size      = mapping.size;
+    out_file->mapping   = mapping;
+
+    bool is_valid = is_valid_header(*out_file->header, out_file->size);
+    if(is_valid && (flags & VOLUME_FILE_VERIFY_CHECKSUM)){
+        is_valid = volume_file_verify_checksum(*out_file);
+    }
+
+    if(!is_valid){
+        volume_file_close(out_file);
+        return false;
+    }
+    return true;
+}
+
+void volume_file_close(volume_file_t* file)
+{
+    file_unmap(&file->mapping);
+    *file = volume_file_t();
+}
+
+bool volume_file_is_open(const volume_file_t& file)
+{
+    return file.header != nullptr;
+}
+
+bool volume_file_verify_checksum(const volume_file_t& file)
+{
+    uint64_t checksum = VOLUME_FILE_CHECKSUM_SEED;
+    for(unsigned int i = 0; i < file.header->num_mips; ++i){
+        const volume_file_mip_t& mip = file.header->mips[i];
+        checksum = volume_file_checksum(file.base + mip.offset, (size_t)mip.size, checksum);
+    }
+    return checksum == file.header->checksum;
+}
+
+VolumeFormat volume_file_get_format(const volume_file_t& file)
+{
+    return (VolumeFormat)file.header->format;
+}
+
+unsigned int volume_file_get_num_mips(const volume_file_t& file)
+{
+    return file.header->num_mips;
+}
+
+volume_view_t volume_file_get_mip(const volume_file_t& file, unsigned int mip)
+{
+    const volume_file_mip_t& entry = file.header->mips[mip];
+
+    volume_view_t view;
+    view.data               = file.base + entry.offset;
+    view.width              = entry.width;
+    view.height             = entry.height;
+    view.depth              = entry.depth;
+    view.bytes_per_voxel    = volume_format_get_bytes_per_voxel(volume_file_get_format(file));
+    view.row_pitch          = (size_t)entry.width * view.bytes_per_voxel;
+    view.slice_pitch        = view.row_pitch * entry.height;
+    return view;
+}
+
+volume_bc_view_t volume_file_get_bc_mip(const volume_file_t& file, unsigned int mip)
+{
+    const volume_file_mip_t& entry = file.header->mips[mip];
+
+    volume_bc_view_t view;
+    view.data           = file.base + entry.offset;
+    view.width          = entry.width;
+    view.height         = entry.height;
+    view.depth          = entry.depth;
+    view.num_channels   = volume_format_get_num_channels(volume_file_get_format(file));
+    return view;
+}
+
+volume_view_t volume_file_get_slice(const volume_file_t& file, unsigned int mip, unsigned int z)
+{
+    return volume_file_get_mip(file, mip).get_slice(z);
+}
+
+bool volume_file_copy_mip(const volume_file_t& file, unsigned int mip, volume_buffer_t* out_volume)
+{
+    if(mip >= volume_file_get_num_mips(file)){
+        out_volume->resize(0, 0, 0, 0);
+        return false;
+    }
+
+    if(volume_format_is_compressed(volume_file_get_format(file))){
+        return volume_bc_decode(volume_file_get_bc_mip(file, mip), out_volume);
+    }
+
+    volume_view_t view = volume_file_get_mip(file, mip);
+    out_volume->resize(view.width, view.height, view.depth, view.bytes_per_voxel);
+    memcpy(out_volume->data.data(), view.data, view.get_size());
+    return true;
+}
+
+bool volume_file_infer_raw_dims(uint64_t file_size, unsigned int bytes_per_voxel, unsigned int* out_width, unsigned int* out_height, unsigned int* out_depth)
+{
+    if((bytes_per_voxel == 0) || (file_size == 0) || ((file_size % bytes_per_voxel) != 0)){
+        return false;
+    }
+
+    // cbrt can land a hair under the exact root, so check the neighbours too
+    uint64_t num_voxels = file_size / bytes_per_voxel;
+    uint64_t edge = (uint64_t)(cbrt((double)num_voxels) + 0.5);
+    for(uint64_t candidate = (edge > 0) ? edge - 1 : 0; candidate <= edge + 1; ++candidate){
+        if((candidate > 0) && (candidate * candidate * candidate == num_voxels)){
+            *out_width = (unsigned int)candidate;
+            *out_height = (unsigned int)candidate;
+            *out_depth = (unsigned int)candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool volume_file_load_raw(const char* filename, VolumeFormat format, unsigned int width, unsigned int height, unsigned int depth, volume_buffer_t* out_volume)
+{
+    FILE* file;
+    errno_t error_code = fopen_s(&file, filename, "rb");
+    if(error_code != 0){
+        return false;
+    }
+
+    fseek(file, 0, SEEK_END);
+    uint64_t file_size = (uint64_t)ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    unsigned int bytes_per_voxel = volume_format_get_bytes_per_voxel(format);
+    bool is_valid = (width > 0) || volume_file_infer_raw_dims(file_size, bytes_per_voxel, &width, &height, &depth);
+    is_valid = is_valid && (file_size >= (uint64_t)width * height * depth * bytes_per_voxel);
+
+    if(is_valid){
+        out_volume->resize(width, height, depth, bytes_per_voxel);
+        is_valid = (fread(out_volume->data.data(), 1, out_volume->data.size(), file) == out_volume->data.size());
+    }
+
+    fclose(file);
+    return is_valid;
+}
+
+bool volume_file_convert_raw(const char* raw_filename, const char* out_filename, VolumeFormat format, unsigned int width, unsigned int height, unsigned int depth)
+{
+    volume_buffer_t volume;
+    if(!volume_file_load_raw(raw_filename, format, width, height, depth, &volume)){
+        return false;
+    }
+    volume_view_t view = volume.get_view();
+    return volume_file_save(out_filename, format, &view, 1);
+}
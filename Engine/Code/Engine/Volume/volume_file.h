@@ -0,0 +1,119 @@
+#pragma once
+
+#include "Engine/Core/file_system.h"
+#include "Engine/Volume/volume_bc.h"
+#include "Engine/Volume/volume_buffer.h"
+
+#include <stdint.h>
+
+//-----------------------------------------------------
+// Volume File
+//
+// Self-describing container for baked volumes. A fixed size header records
+// the dimensions, voxel format, mip count and where each mip lives, followed
+// by the mips themselves (largest first, each 64 byte aligned, linear like
+// volume_buffer_t). Loading maps the file instead of reading it, so a mip or
+// a slice is just a view into the mapping and nothing is copied until the
+// caller (or the GPU upload) touches it.
+//
+// Compressed formats store each mip as volume_bc.h bricks instead of voxels.
+//
+// The old .dat/.texture files are the same voxels with no header at all,
+// volume_file_convert_raw turns them into this format.
+
+#define VOLUME_FILE_EXTENSION       ".vol"
+#define VOLUME_FILE_MAGIC           0x4D554C56 // "VLUM"
+#define VOLUME_FILE_VERSION         1
+#define VOLUME_FILE_MAX_MIPS        16
+#define VOLUME_FILE_DATA_ALIGNMENT  64
+#define VOLUME_FILE_CHECKSUM_SEED   0xcbf29ce484222325ULL
+
+// volume_file_open flags
+#define VOLUME_FILE_VERIFY_CHECKSUM (1 << 0)
+
+struct volume_file_mip_t
+{
+    uint64_t        offset;     // from the start of the file
+    uint64_t        size;
+    unsigned int    width;
+    unsigned int    height;
+    unsigned int    depth;
+    unsigned int    reserved;
+};
+
+struct volume_file_header_t
+{
+    unsigned int        magic;
+    unsigned int        version;
+    unsigned int        header_size;
+    unsigned int        format;         // VolumeFormat
+    unsigned int        width;
+    unsigned int        height;
+    unsigned int        depth;
+    unsigned int        num_mips;
+    uint64_t            key;            // whatever the writer wants, 0 if unused
+    uint64_t            checksum;       // volume_file_checksum over every mip in order
+    volume_file_mip_t   mips[VOLUME_FILE_MAX_MIPS];
+};
+
+// A mapped volume file, the header and mip views point straight into the mapping
+// and stay valid until volume_file_close
+struct volume_file_t
+{
+    const volume_file_header_t*     header;
+    const unsigned char*            base;
+    uint64_t                        size;
+    file_mapping_t                  mapping;
+
+    volume_file_t()
+        :header(nullptr)
+        ,base(nullptr)
+        ,size(0)
+    {}
+};
+
+// Word at a time FNV-1a variant, several times faster than the byte version
+// so verifying a large volume doesn't dominate the load
+uint64_t        volume_file_checksum(const void* data, size_t byte_count, uint64_t hash = VOLUME_FILE_CHECKSUM_SEED);
+
+// <mips> is the chain largest first, each one half the size of the one before
+// (rounded down, never below 1, see volume_mips.h). Every mip must match
+// <format>'s voxel size and be tightly packed and linear.
+bool            volume_file_save(const char* filename, VolumeFormat format, const volume_view_t* mips, unsigned int num_mips, uint64_t key = 0);
+
+// Same for a compressed chain, the format follows from the channel count
+bool            volume_file_save_bc(const char* filename, const volume_bc_view_t* mips, unsigned int num_mips, uint64_t key = 0);
+
+// Maps the file and validates the header and mip table against the file size.
+// The checksum is only checked when asked for, it means touching every page.
+bool            volume_file_open(volume_file_t* out_file, const char* filename, unsigned int flags = 0);
+void            volume_file_close(volume_file_t* file);
+bool            volume_file_is_open(const volume_file_t& file);
+bool            volume_file_verify_checksum(const volume_file_t& file);
+
+VolumeFormat    volume_file_get_format(const volume_file_t& file);
+unsigned int    volume_file_get_num_mips(const volume_file_t& file);
+
+// Uncompressed formats only
+volume_view_t   volume_file_get_mip(const volume_file_t& file, unsigned int mip);
+volume_view_t   volume_file_get_slice(const volume_file_t& file, unsigned int mip, unsigned int z);
+
+// Compressed formats only, the bricks stay in the mapping like any other mip
+volume_bc_view_t volume_file_get_bc_mip(const volume_file_t& file, unsigned int mip);
+
+// Copies one mip out of the mapping, for callers that need to own and edit the
+// voxels. Compressed mips are decoded on the job system. Fails for a mip the
+// file doesn't have or bricks that don't decode, <out_volume> is left empty.
+bool            volume_file_copy_mip(const volume_file_t& file, unsigned int mip, volume_buffer_t* out_volume);
+
+// Headerless .dat/.texture files only know their byte count. Picks the cube that
+// fits it, fails if there isn't one.
+bool            volume_file_infer_raw_dims(uint64_t file_size, unsigned int bytes_per_voxel, unsigned int* out_width, unsigned int* out_height, unsigned int* out_depth);
+
+// Reads a headerless file into <out_volume>. A width of 0 infers a cube from the size.
+// With explicit dims a longer file is fine, only the leading voxels are read, like
+// the old loaders did. A shorter one fails rather than leaving voxels unset.
+bool            volume_file_load_raw(const char* filename, VolumeFormat format, unsigned int width, unsigned int height, unsigned int depth, volume_buffer_t* out_volume);
+
+// Wraps a headerless file as a single mip volume file
+bool            volume_file_convert_raw(const char* raw_filename, const char* out_filename, VolumeFormat format, unsigned int width = 0, unsigned int height = 0, unsigned int depth = 0);
@@ -0,0 +1,353 @@
+#include "Engine/Volume/volume_fill.h"
+
+#include "Engine/Core/console_command.h"
+#include "Engine/Core/Time.hpp"
+#include "Engine/Core/job.h"
+#include "Engine/Math/MathUtils.hpp"
+#include "Engine/Math/Noise.hpp"
+#include "Engine/Thread/atomic.h"
+
+#include <vector>
+
+//-----------------------------------------------------
+// Internal helpers
+
+// One helper job of a time slice. Each gets its own copy of the slice's
+// deadline, since it can still be running when the next step starts.
+struct volume_fill_worker_t
+{
+    volume_fill_task_t*     task;
+    double                  deadline_seconds;
+    double                  brick_seconds_estimate;
+    Job*                    job;
+};
+
+struct channel_funcs_t
+{
+    volume_channel_func     funcs[4];
+};
+
+static unsigned int calculate_num_bricks(unsigned int voxels, unsigned int brick_size)
+{
+    return (voxels + brick_size - 1) / brick_size;
+}
+
+static unsigned int min_uint(unsigned int a, unsigned int b)
+{
+    return (a < b) ? a : b;
+}
+
+// Bricks are numbered x fastest, so neighbouring claims write neighbouring memory
+static volume_brick_t get_brick(const volume_fill_task_t& task, unsigned int brick_index)
+{
+    unsigned int brick_x = brick_index % task.num_bricks_x;
+    unsigned int brick_y = (brick_index / task.num_bricks_x) % task.num_bricks_y;
+    unsigned int brick_z = brick_index / (task.num_bricks_x * task.num_bricks_y);
+
+    volume_brick_t brick;
+    brick.min_x = brick_x * task.brick_size;
+    brick.min_y = brick_y * task.brick_size;
+    brick.min_z = brick_z * task.brick_size;
+    brick.max_x = min_uint(brick.min_x + task.brick_size, task.volume->width);
+    brick.max_y = min_uint(brick.min_y + task.brick_size, task.volume->height);
+    brick.max_z = min_uint(brick.min_z + task.brick_size, task.volume->depth);
+    return brick;
+}
+
+static bool fill_next_brick(volume_fill_task_t* task)
+{
+    unsigned int brick_index = atomic_incr(&task->next_brick) - 1;
+    if(brick_index >= task->num_bricks){
+        return false;
+    }
+
+    volume_brick_t brick = get_brick(*task, brick_index);
+    task->brick_cb(task->volume, brick, task->user_data);
+    atomic_incr(&task->num_bricks_done);
+    return true;
+}
+
+// Runs one brick for the blocking fill, where items are brick indices
+static void fill_brick(unsigned int brick_index, void* user_data)
+{
+    volume_fill_task_t* task = (volume_fill_task_t*)user_data;
+
+    volume_brick_t brick = get_brick(*task, brick_index);
+    task->brick_cb(task->volume, brick, task->user_data);
+    atomic_incr(&task->num_bricks_done);
+}
+
+// Time slice workers run until the counter passes the last brick, or until the next
+// brick (guessed from how long the previous one took) would run past the deadline.
+// Between bricks they let ready frame work go first.
+static void fill_bricks_until_deadline(volume_fill_worker_t* worker)
+{
+    double last_brick_seconds = worker->brick_seconds_estimate;
+    for(;;){
+        job_yield();
+        double brick_start = get_current_time_seconds();
+        if((brick_start + last_brick_seconds) > worker->deadline_seconds){
+            break;
+        }
+
+        if(!fill_next_brick(worker->task)){
+            break;
+        }
+        last_brick_seconds = get_current_time_seconds() - brick_start;
+    }
+}
+
+static void fill_worker_job(void* user_data)
+{
+    fill_bricks_until_deadline((volume_fill_worker_t*)user_data);
+}
+
+// Releases helpers that finished since the last step, or all of them (waiting
+// on any still running) with <wait_for_all>. Returns how many are still out.
+static unsigned int collect_fill_workers(volume_fill_task_t* task, bool wait_for_all)
+{
+    std::vector<volume_fill_worker_t*>& workers = task->workers;
+    for(size_t i = 0; i < workers.size();){
+        volume_fill_worker_t* worker = workers[i];
+        if(!wait_for_all && !job_is_finished(worker->job)){
+            ++i;
+            continue;
+        }
+
+        job_wait_and_release(worker->job);
+        delete worker;
+        workers[i] = workers.back();
+        workers.pop_back();
+    }
+    return (unsigned int)workers.size();
+}
+
+static unsigned int calculate_num_workers(const volume_fill_task_t& task, unsigned int max_workers)
+{
+    unsigned int num_workers = (max_workers > 0) ? max_workers : job_get_max_workers();
+    unsigned int num_bricks_left = (task.next_brick < task.num_bricks) ? (task.num_bricks - task.next_brick) : 0;
+    num_workers = min_uint(num_workers, num_bricks_left);
+    return (num_workers > 0) ? num_workers : 1;
+}
+
+static void fill_rgba8_brick(volume_buffer_t* volume, const volume_brick_t& brick, void* user_data)
+{
+    const channel_funcs_t* channels = (const channel_funcs_t*)user_data;
+
+    for(unsigned int z = brick.min_z; z < brick.max_z; ++z){
+        for(unsigned int y = brick.min_y; y < brick.max_y; ++y){
+            for(unsigned int x = brick.min_x; x < brick.max_x; ++x){
+                unsigned char* voxel = volume->get_voxel(x, y, z);
+                for(unsigned int c = 0; c < 4; ++c){
+                    float value = Clamp(channels->funcs[c]((float)x, (float)y, (float)z), 0.0f, 1.0f);
+                    voxel[c] = (unsigned char)MapFloatToRange(value, 0.0f, 1.0f, 0.0f, 255.0f);
+                }
+            }
+        }
+    }
+}
+
+//-----------------------------------------------------
+// Public API
+
+unsigned int volume_fill_calculate_brick_size(unsigned int bytes_per_voxel)
+{
+    unsigned int brick_size = 64;
+    while((brick_size > 4) && ((brick_size * brick_size * brick_size * bytes_per_voxel) > VOLUME_FILL_BRICK_TARGET_BYTES)){
+        brick_size /= 2;
+    }
+    return brick_size;
+}
+
+void volume_fill(volume_buffer_t* volume, volume_fill_brick_cb brick_cb, void* user_data, unsigned int brick_size, unsigned int max_workers, volume_fill_stats_t* out_stats)
+{
+    volume_fill_task_t task;
+    volume_fill_task_begin(&task, volume, brick_cb, user_data, brick_size);
+
+    unsigned int num_workers = job_parallel_for(task.num_bricks, fill_brick, &task, max_workers);
+
+    if(nullptr != out_stats){
+        out_stats->seconds      = get_current_time_seconds() - task.start_seconds;
+        out_stats->num_voxels   = volume->get_num_voxels();
+        out_stats->num_bricks   = task.num_bricks;
+        out_stats->num_workers  = num_workers;
+    }
+}
+
+void volume_fill_task_begin(volume_fill_task_t* task, volume_buffer_t* volume, volume_fill_brick_cb brick_cb, void* user_data, unsigned int brick_size)
+{
+    // Restarting a task that's still in flight
+    collect_fill_workers(task, true);
+
+    if(brick_size == 0){
+        brick_size = volume_fill_calculate_brick_size(volume->bytes_per_voxel);
+    }
+
+    // Whole storage bricks per fill brick, so workers never share one
+    if(volume->layout == VOLUME_LAYOUT_BRICKED){
+        brick_size = (brick_size + VOLUME_BRICK_MASK) & ~(unsigned int)VOLUME_BRICK_MASK;
+    }
+
+    task->volume            = volume;
+    task->brick_cb          = brick_cb;
+    task->user_data         = user_data;
+    task->brick_size        = brick_size;
+    task->num_bricks_x      = calculate_num_bricks(volume->width, brick_size);
+    task->num_bricks_y      = calculate_num_bricks(volume->height, brick_size);
+    task->num_bricks        = task->num_bricks_x * task->num_bricks_y * calculate_num_bricks(volume->depth, brick_size);
+    task->next_brick        = 0;
+    task->num_bricks_done   = 0;
+    task->start_seconds     = get_current_time_seconds();
+    task->step_seconds      = 0.0;
+    task->num_steps         = 0;
+}
+
+bool volume_fill_task_step(volume_fill_task_t* task, float budget_ms, unsigned int max_workers)
+{
+    unsigned int num_busy_workers = collect_fill_workers(task, false);
+    if(volume_fill_task_is_done(*task)){
+        // Every brick is in, so anything still out is only on its way out
+        collect_fill_workers(task, true);
+        return true;
+    }
+
+    double step_start = get_current_time_seconds();
+    double deadline = step_start + ((double)budget_ms / 1000.0);
+
+    // Guarantees progress even when one brick costs more than the whole budget,
+    // and tells the workers roughly what a brick costs before they start
+    fill_next_brick(task);
+    double brick_seconds = get_current_time_seconds() - step_start;
+
+    // Helpers from the last step still count against <max_workers>. Once they're
+    // all busy the caller just runs its own bricks, a slow helper never blocks a frame.
+    unsigned int num_workers = calculate_num_workers(*task, max_workers);
+    for(unsigned int i = 1 + num_busy_workers; i < num_workers; ++i){
+        volume_fill_worker_t* worker = new volume_fill_worker_t();
+        worker->task                    = task;
+        worker->deadline_seconds        = deadline;
+        worker->brick_seconds_estimate  = brick_seconds;
+        worker->job                     = job_create(JOB_TYPE_GENERIC, fill_worker_job, worker);
+        job_set_priority(worker->job, JOB_PRIORITY_BACKGROUND);
+        job_set_deadline(worker->job, deadline);
+        job_dispatch(worker->job);
+        task->workers.push_back(worker);
+    }
+
+    volume_fill_worker_t caller;
+    caller.task                     = task;
+    caller.deadline_seconds         = deadline;
+    caller.brick_seconds_estimate   = brick_seconds;
+    caller.job                      = nullptr;
+    fill_bricks_until_deadline(&caller);
+
+    // Helpers are left to run out their slice, the next step collects them
+    bool is_done = volume_fill_task_is_done(*task);
+    if(is_done){
+        collect_fill_workers(task, true);
+    }
+
+    task->step_seconds += get_current_time_seconds() - step_start;
+    ++task->num_steps;
+    return is_done;
+}
+
+void volume_fill_task_wait(volume_fill_task_t* task)
+{
+    collect_fill_workers(task, true);
+}
+
+bool volume_fill_task_is_done(const volume_fill_task_t& task)
+{
+    return task.num_bricks_done >= task.num_bricks;
+}
+
+float volume_fill_task_get_progress(const volume_fill_task_t& task)
+{
+    return (task.num_bricks > 0) ? ((float)task.num_bricks_done / (float)task.num_bricks) : 1.0f;
+}
+
+// Based on wall time since begin, so it accounts for the frames between steps
+double volume_fill_task_get_seconds_remaining(const volume_fill_task_t& task)
+{
+    if(task.num_bricks_done == 0){
+        return -1.0;
+    }
+
+    double elapsed = get_current_time_seconds() - task.start_seconds;
+    double seconds_per_brick = elapsed / (double)task.num_bricks_done;
+    return seconds_per_brick * (double)(task.num_bricks - task.num_bricks_done);
+}
+
+void volume_fill_rgba8(volume_buffer_t* volume, unsigned int width, unsigned int height, unsigned int depth, volume_channel_func r_func, volume_channel_func g_func, volume_channel_func b_func, volume_channel_func a_func, unsigned int max_workers, volume_fill_stats_t* out_stats)
+{
+    channel_funcs_t channels;
+    channels.funcs[0] = r_func;
+    channels.funcs[1] = g_func;
+    channels.funcs[2] = b_func;
+    channels.funcs[3] = a_func;
+
+    volume->resize(width, height, depth, 4);
+    volume_fill(volume, fill_rgba8_brick, &channels, 0, max_workers, out_stats);
+}
+
+//-----------------------------------------------------
+// Benchmark
+
+// Four octaves of batched Perlin per channel, roughly the cost of a cloud noise bake
+static void bench_perlin_brick(volume_buffer_t* volume, const volume_brick_t& brick, void* user_data)
+{
+    UNUSED(user_data);
+
+    float xs[64];
+    float ys[64];
+    float zs[64];
+    float noise[64];
+
+    unsigned int count = brick.max_x - brick.min_x;
+    for(unsigned int z = brick.min_z; z < brick.max_z; ++z){
+        for(unsigned int y = brick.min_y; y < brick.max_y; ++y){
+            for(unsigned int i = 0; i < count; ++i){
+                xs[i] = (float)(brick.min_x + i);
+                ys[i] = (float)y;
+                zs[i] = (float)z;
+            }
+
+            unsigned char* row = volume->get_voxel(brick.min_x, y, z);
+            for(unsigned int c = 0; c < 4; ++c){
+                Compute3dPerlinNoiseZeroToOneBatch(xs, ys, zs, noise, count, 16.0f * (float)(c + 1), 4, 0.5f, 2.0f, true, c);
+                for(unsigned int i = 0; i < count; ++i){
+                    row[(i * 4) + c] = (unsigned char)(Clamp(noise[i], 0.0f, 1.0f) * 255.0f + 0.5f);
+                }
+            }
+        }
+    }
+}
+
+COMMAND(bench_volume_fill, "[uint:size] [uint:brick_size] Times a brick volume fill at 1..N workers")
+{
+    unsigned int size = args.is_at_end() ? 128 : args.next_uint_arg();
+    unsigned int brick_size = args.is_at_end() ? 0 : args.next_uint_arg();
+    size = (size == 0) ? 1 : size;
+    brick_size = (brick_size == 0) ? volume_fill_calculate_brick_size(4) : Clamp(brick_size, 1U, 64U);
+
+    volume_buffer_t volume;
+    volume.resize(size, size, size, 4);
+
+    unsigned int max_workers = job_get_max_workers();
+    console_info("volume fill %u^3 rgba8, %u^3 bricks, 1..%u workers", size, brick_size, max_workers);
+
+    double single_rate = 0.0;
+    for(unsigned int workers = 1; workers <= max_workers; ++workers){
+        volume_fill_stats_t stats;
+        volume_fill(&volume, bench_perlin_brick, nullptr, brick_size, workers, &stats);
+
+        double rate = stats.voxels_per_second();
+        if(workers == 1){
+            single_rate = rate;
+        }
+
+        double speedup = (single_rate > 0.0) ? rate / single_rate : 0.0;
+        console_info("  %2u workers: %8.2f ms, %6.2f Mvoxels/sec, %.2fx (%.0f%% efficiency)", stats.num_workers, stats.seconds * 1000.0, rate / 1000000.0, speedup, (speedup / (double)stats.num_workers) * 100.0);
+    }
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+#include "Engine/Volume/volume_buffer.h"
+
+#include <vector>
+
+//-----------------------------------------------------
+// Volume Fill
+//
+// Fills a volume_buffer_t on the job system. The volume is cut into bricks
+// small enough to stay in L1/L2 while a callback writes them, and a handful
+// of GENERIC jobs (plus the calling thread) pull bricks off a shared counter
+// until none are left, so uneven bricks don't leave workers idle. Edge bricks
+// are clipped, any size works. Bricked volumes get fill bricks rounded up to
+// whole storage bricks, callbacks write them through get_voxel and get_row_run.
+
+// Bricks are sized so one brick of voxels fits in this many bytes
+#define VOLUME_FILL_BRICK_TARGET_BYTES (32 * 1024)
+
+// Voxel range [min, max) on each axis
+struct volume_brick_t
+{
+    unsigned int    min_x;
+    unsigned int    min_y;
+    unsigned int    min_z;
+    unsigned int    max_x;
+    unsigned int    max_y;
+    unsigned int    max_z;
+};
+
+struct volume_fill_stats_t
+{
+    double          seconds;
+    size_t          num_voxels;
+    unsigned int    num_bricks;
+    unsigned int    num_workers;
+
+    double voxels_per_second() const { return (seconds > 0.0) ? (double)num_voxels / seconds : 0.0; }
+};
+
+// Called once per brick, from any thread. Bricks never overlap, so writing
+// only inside <brick> needs no locking.
+typedef void (*volume_fill_brick_cb)(volume_buffer_t* volume, const volume_brick_t& brick, void* user_data);
+
+// Per-voxel channel function, same shape as RHITexture3D's noise_func
+typedef float (*volume_channel_func)(float x, float y, float z);
+
+struct volume_fill_worker_t;
+
+// A fill that can be advanced a slice of time at a time, for bakes that
+// shouldn't stall a frame. Owned and stepped by a single thread.
+struct volume_fill_task_t
+{
+    volume_buffer_t*        volume;
+    volume_fill_brick_cb    brick_cb;
+    void*                   user_data;
+
+    unsigned int            brick_size;
+    unsigned int            num_bricks_x;
+    unsigned int            num_bricks_y;
+    unsigned int            num_bricks;
+
+    unsigned int            next_brick;
+    unsigned int            num_bricks_done;
+
+    double                  start_seconds;
+    double                  step_seconds;
+    unsigned int            num_steps;
+
+    std::vector<volume_fill_worker_t*>  workers;    // helper jobs still out from earlier steps
+
+    volume_fill_task_t()
+        :volume(nullptr)
+        ,brick_cb(nullptr)
+        ,user_data(nullptr)
+        ,brick_size(0)
+        ,num_bricks_x(0)
+        ,num_bricks_y(0)
+        ,num_bricks(0)
+        ,next_brick(0)
+        ,num_bricks_done(0)
+        ,start_seconds(0.0)
+        ,step_seconds(0.0)
+        ,num_steps(0)
+    {}
+};
+
+unsigned int    volume_fill_calculate_brick_size(unsigned int bytes_per_voxel);
+
+// <volume> must already be sized. <brick_size> 0 picks one from the voxel size,
+// <max_workers> 0 uses job_get_max_workers(). Blocks until done, needs job_system_init.
+void            volume_fill(volume_buffer_t* volume, volume_fill_brick_cb brick_cb, void* user_data, unsigned int brick_size = 0, unsigned int max_workers = 0, volume_fill_stats_t* out_stats = nullptr);
+
+// Time-sliced fill. Each step runs bricks on up to <max_workers> threads (the
+// caller included) and stops claiming new ones once <budget_ms> would be
+// exceeded; the caller always gets at least one brick so tiny budgets still
+// make progress. A step never waits on its helper jobs, they finish their
+// slice in the background and the next step collects them. Returns true once
+// every brick is done, by then no helpers are left.
+void            volume_fill_task_begin(volume_fill_task_t* task, volume_buffer_t* volume, volume_fill_brick_cb brick_cb, void* user_data, unsigned int brick_size = 0);
+bool            volume_fill_task_step(volume_fill_task_t* task, float budget_ms, unsigned int max_workers = 0);
+
+// Waits out helpers still running from the last step. Needed before freeing
+// a task, or its volume, that was dropped before it was done.
+void            volume_fill_task_wait(volume_fill_task_t* task);
+bool            volume_fill_task_is_done(const volume_fill_task_t& task);
+float           volume_fill_task_get_progress(const volume_fill_task_t& task);
+double          volume_fill_task_get_seconds_remaining(const volume_fill_task_t& task);
+
+// Evaluates one function per channel and stores it as unorm8 (clamped, truncated)
+void            volume_fill_rgba8(volume_buffer_t* volume, unsigned int width, unsigned int height, unsigned int depth, volume_channel_func r_func, volume_channel_func g_func, volume_channel_func b_func, volume_channel_func a_func, unsigned int max_workers = 0, volume_fill_stats_t* out_stats = nullptr);
@@ -0,0 +1,57 @@
+#include "Engine/Volume/volume_layout.h"
+
+#include "Engine/Volume/volume_fill.h"
+
+#include <string.h>
+#include <utility>
+
+//-----------------------------------------------------
+// Internal helpers
+
+// Whole 8^3 bricks per fill brick, so no two workers write the same storage brick
+#define CONVERT_FILL_BRICK_SIZE     (2 * VOLUME_BRICK_SIZE)
+
+static void convert_brick(volume_buffer_t* volume, const volume_brick_t& brick, void* user_data)
+{
+    const volume_view_t& src = *(const volume_view_t*)user_data;
+    size_t bytes_per_voxel = volume->bytes_per_voxel;
+
+    // Runs never cross a storage brick on either side, both layouts are
+    // contiguous within an aligned group of 8 along x
+    for(unsigned int z = brick.min_z; z < brick.max_z; ++z){
+        for(unsigned int y = brick.min_y; y < brick.max_y; ++y){
+            for(unsigned int x = brick.min_x; x < brick.max_x; x += VOLUME_BRICK_SIZE){
+                unsigned int run = (brick.max_x - x < VOLUME_BRICK_SIZE) ? (brick.max_x - x) : VOLUME_BRICK_SIZE;
+                memcpy(volume->get_voxel(x, y, z), src.get_voxel(x, y, z), run * bytes_per_voxel);
+            }
+        }
+    }
+}
+
+//-----------------------------------------------------
+// Public API
+
+void volume_convert_layout(const volume_view_t& src, VolumeLayout layout, volume_buffer_t* out_dst, unsigned int max_workers, volume_layout_stats_t* out_stats)
+{
+    out_dst->resize(src.width, src.height, src.depth, src.bytes_per_voxel, layout);
+
+    volume_fill_stats_t fill_stats;
+    volume_fill(out_dst, convert_brick, (void*)&src, CONVERT_FILL_BRICK_SIZE, max_workers, &fill_stats);
+
+    if(nullptr != out_stats){
+        out_stats->seconds      = fill_stats.seconds;
+        out_stats->num_bytes    = out_dst->get_num_voxels() * out_dst->bytes_per_voxel;
+        out_stats->num_workers  = fill_stats.num_workers;
+    }
+}
+
+void volume_set_layout(volume_buffer_t* volume, VolumeLayout layout, unsigned int max_workers)
+{
+    if(volume->layout == layout){
+        return;
+    }
+
+    volume_buffer_t converted;
+    volume_convert_layout(volume->get_view(), layout, &converted, max_workers);
+    std::swap(*volume, converted);
+}
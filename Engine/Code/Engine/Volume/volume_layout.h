@@ -0,0 +1,26 @@
+#pragma once
+
+#include "Engine/Volume/volume_buffer.h"
+
+//-----------------------------------------------------
+// Volume Layout
+//
+// Conversion between linear and bricked volumes (see volume_buffer.h). Both
+// layouts keep runs of 8 voxels along x together, so a conversion is one
+// memcpy per run, split across GENERIC jobs through volume_fill.
+
+struct volume_layout_stats_t
+{
+    double          seconds;
+    size_t          num_bytes;
+    unsigned int    num_workers;
+
+    double bytes_per_second() const { return (seconds > 0.0) ? (double)num_bytes / seconds : 0.0; }
+};
+
+// Copies <src> into <out_dst> in <layout>, sizing it first. Either direction
+// works, as does a plain copy. Needs job_system_init, <max_workers> 0 uses every core.
+void    volume_convert_layout(const volume_view_t& src, VolumeLayout layout, volume_buffer_t* out_dst, unsigned int max_workers = 0, volume_layout_stats_t* out_stats = nullptr);
+
+// Converts <volume> in place, through a temporary copy. Nothing happens if it's already in <layout>.
+void    volume_set_layout(volume_buffer_t* volume, VolumeLayout layout, unsigned int max_workers = 0);
@@ -0,0 +1,382 @@
+#include "Engine/Volume/volume_mips.h"
+
+#include "Engine/Core/Time.hpp"
+#include "Engine/Core/cpu.h"
+#include "Engine/Core/job.h"
+#include "Engine/Volume/volume_mips_lanes.h"
+
+#include <math.h>
+#include <string.h>
+
+//-----------------------------------------------------
+// Internal helpers
+
+#define MIP_KERNEL_MAX_TAPS 6
+
+// Destination voxel i reads source voxels 2i + first_offset .. 2i + first_offset + num_taps - 1
+struct mip_kernel_t
+{
+    int             first_offset;
+    unsigned int    num_taps;
+    float           weights[MIP_KERNEL_MAX_TAPS];
+};
+
+struct mip_pass_t
+{
+    volume_view_t           src;
+    volume_buffer_t*        dst;
+    VolumeFormat            format;
+    const mip_kernel_t*     kernel;
+    SimdLevel               simd_level;
+    const float*            half_table;
+};
+
+static const char* s_filter_names[NUM_VOLUME_MIP_FILTERS] = {
+    "box",
+    "kaiser",
+};
+
+static unsigned int half_size(unsigned int size)
+{
+    return (size > 1) ? (size / 2) : 1;
+}
+
+static unsigned int wrap_index(int index, unsigned int size)
+{
+    int wrapped = index % (int)size;
+    return (unsigned int)((wrapped < 0) ? wrapped + (int)size : wrapped);
+}
+
+// Modified Bessel function of the first kind, order 0, for the Kaiser window
+static double bessel_i0(double x)
+{
+    double sum = 1.0;
+    double term = 1.0;
+    double half_x = x * 0.5;
+    for(unsigned int k = 1; k < 32; ++k){
+        term *= half_x / (double)k;
+        sum += term * term;
+    }
+    return sum;
+}
+
+// Every half maps to one float, a table beats decoding them one at a time
+static std::vector<float> make_half_to_float_table()
+{
+    std::vector<float> table(65536);
+    for(unsigned int i = 0; i < 65536; ++i){
+        table[i] = volume_half_to_float((unsigned short)i);
+    }
+    return table;
+}
+
+static const float* get_half_to_float_table()
+{
+    static const std::vector<float> s_table = make_half_to_float_table();
+    return s_table.data();
+}
+
+static mip_kernel_t make_box_kernel()
+{
+    mip_kernel_t kernel;
+    kernel.first_offset = 0;
+    kernel.num_taps = 2;
+    kernel.weights[0] = 0.5f;
+    kernel.weights[1] = 0.5f;
+    return kernel;
+}
+
+// Windowed sinc at half the source rate. Taps sit at +-0.5, 1.5, 2.5 source
+// voxels from the destination centre, the window reaches 3 so no tap is wasted.
+static mip_kernel_t make_kaiser_kernel()
+{
+    static const double ALPHA = 4.0;
+    static const double HALF_WIDTH = 3.0;
+    static const double PI = 3.14159265358979323846;
+
+    mip_kernel_t kernel;
+    kernel.first_offset = -2;
+    kernel.num_taps = 6;
+
+    double weights[MIP_KERNEL_MAX_TAPS];
+    double total = 0.0;
+    for(unsigned int i = 0; i < kernel.num_taps; ++i){
+        double distance = ((double)kernel.first_offset + (double)i) - 0.5;
+        double x = PI * distance * 0.5;
+        double sinc = sin(x) / x;
+        double ratio = distance / HALF_WIDTH;
+        double window = bessel_i0(ALPHA * sqrt(1.0 - (ratio * ratio))) / bessel_i0(ALPHA);
+        weights[i] = sinc * window;
+        total += weights[i];
+    }
+
+    for(unsigned int i = 0; i < kernel.num_taps; ++i){
+        kernel.weights[i] = (float)(weights[i] / total);
+    }
+    return kernel;
+}
+
+static const mip_kernel_t* get_kernel(VolumeMipFilter filter)
+{
+    static const mip_kernel_t s_box = make_box_kernel();
+    static const mip_kernel_t s_kaiser = make_kaiser_kernel();
+    return (filter == VOLUME_MIP_FILTER_KAISER) ? &s_kaiser : &s_box;
+}
+
+static void accumulate_u8(SimdLevel simd_level, float* acc, const unsigned char* src, float weight, size_t count)
+{
+    switch(simd_level){
+        case SIMD_LEVEL_AVX2:
+            volume_mips_accumulate_u8_avx2(acc, src, weight, count);
+            break;
+        case SIMD_LEVEL_SSE41:
+            accumulate_u8_kernel<simd4_t>(acc, src, weight, count);
+            break;
+        default:
+            for(size_t i = 0; i < count; ++i){
+                acc[i] += (float)src[i] * weight;
+            }
+            break;
+    }
+}
+
+static void accumulate_float(SimdLevel simd_level, float* acc, const float* src, float weight, size_t count)
+{
+    switch(simd_level){
+        case SIMD_LEVEL_AVX2:
+            volume_mips_accumulate_float_avx2(acc, src, weight, count);
+            break;
+        case SIMD_LEVEL_SSE41:
+            accumulate_float_kernel<simd4_t>(acc, src, weight, count);
+            break;
+        default:
+            for(size_t i = 0; i < count; ++i){
+                acc[i] += src[i] * weight;
+            }
+            break;
+    }
+}
+
+// A bricked row is gathered a brick row at a time into <scratch_bytes>, linear ones are read in place
+static const unsigned char* get_src_row(const volume_view_t& src, unsigned int y, unsigned int z, unsigned char* scratch_bytes)
+{
+    if(src.layout == VOLUME_LAYOUT_LINEAR){
+        return src.get_voxel(0, y, z);
+    }
+
+    for(unsigned int x = 0; x < src.width; x += VOLUME_BRICK_SIZE){
+        unsigned int run = (src.width - x < VOLUME_BRICK_SIZE) ? (src.width - x) : VOLUME_BRICK_SIZE;
+        memcpy(scratch_bytes + ((size_t)x * src.bytes_per_voxel), src.get_voxel(x, y, z), (size_t)run * src.bytes_per_voxel);
+    }
+    return scratch_bytes;
+}
+
+// Blends the source slices under destination slice <dst_z> into <out_rows>, one float per channel
+static void filter_z(const mip_pass_t& pass, unsigned int dst_z, float* out_rows, float* scratch_row, unsigned char* scratch_bytes)
+{
+    const volume_view_t& src = pass.src;
+    size_t row_count = (size_t)src.width * volume_format_get_num_channels(pass.format);
+    memset(out_rows, 0, row_count * src.height * sizeof(float));
+
+    for(unsigned int tap = 0; tap < pass.kernel->num_taps; ++tap){
+        unsigned int src_z = wrap_index((int)(dst_z * 2) + pass.kernel->first_offset + (int)tap, src.depth);
+        float weight = pass.kernel->weights[tap];
+
+        for(unsigned int y = 0; y < src.height; ++y){
+            const unsigned char* src_row = get_src_row(src, y, src_z, scratch_bytes);
+            float* acc = out_rows + (y * row_count);
+
+            if(pass.format == VOLUME_FORMAT_R16F){
+                const unsigned short* halves = (const unsigned short*)src_row;
+                for(size_t i = 0; i < row_count; ++i){
+                    scratch_row[i] = pass.half_table[halves[i]];
+                }
+                accumulate_float(pass.simd_level, acc, scratch_row, weight, row_count);
+            }else{
+                accumulate_u8(pass.simd_level, acc, src_row, weight, row_count);
+            }
+        }
+    }
+}
+
+static void filter_y(const mip_pass_t& pass, const float* z_rows, float* out_rows)
+{
+    size_t row_count = (size_t)pass.src.width * volume_format_get_num_channels(pass.format);
+    memset(out_rows, 0, row_count * pass.dst->height * sizeof(float));
+
+    for(unsigned int dst_y = 0; dst_y < pass.dst->height; ++dst_y){
+        float* acc = out_rows + (dst_y * row_count);
+        for(unsigned int tap = 0; tap < pass.kernel->num_taps; ++tap){
+            unsigned int src_y = wrap_index((int)(dst_y * 2) + pass.kernel->first_offset + (int)tap, pass.src.height);
+            accumulate_float(pass.simd_level, acc, z_rows + (src_y * row_count), pass.kernel->weights[tap], row_count);
+        }
+    }
+}
+
+// x is strided by the channel count, so it's done per voxel and written straight out
+static void filter_x_and_store(const mip_pass_t& pass, const float* y_rows, unsigned int dst_z)
+{
+    unsigned int channels = volume_format_get_num_channels(pass.format);
+    size_t src_row_count = (size_t)pass.src.width * channels;
+    volume_buffer_t* dst = pass.dst;
+
+    for(unsigned int dst_y = 0; dst_y < dst->height; ++dst_y){
+        const float* row = y_rows + (dst_y * src_row_count);
+        unsigned char* out = dst->get_voxel(0, dst_y, dst_z);
+        unsigned int run_start = 0;
+
+        for(unsigned int dst_x = 0; dst_x < dst->width; ++dst_x){
+            // Bricked rows restart every brick
+            if((dst->layout == VOLUME_LAYOUT_BRICKED) && ((dst_x & VOLUME_BRICK_MASK) == 0)){
+                out = dst->get_voxel(dst_x, dst_y, dst_z);
+                run_start = dst_x;
+            }
+
+            float values[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+            for(unsigned int tap = 0; tap < pass.kernel->num_taps; ++tap){
+                unsigned int src_x = wrap_index((int)(dst_x * 2) + pass.kernel->first_offset + (int)tap, pass.src.width);
+                const float* voxel = row + (src_x * channels);
+                for(unsigned int c = 0; c < channels; ++c){
+                    values[c] += voxel[c] * pass.kernel->weights[tap];
+                }
+            }
+
+            // Kaiser has negative lobes, so unorm results can overshoot either end
+            unsigned int out_x = dst_x - run_start;
+            if(pass.format == VOLUME_FORMAT_R16F){
+                ((unsigned short*)out)[out_x] = volume_float_to_half(values[0]);
+            }else{
+                for(unsigned int c = 0; c < channels; ++c){
+                    float value = (values[c] < 0.0f) ? 0.0f : ((values[c] > 255.0f) ? 255.0f : values[c]);
+                    out[(out_x * channels) + c] = (unsigned char)(value + 0.5f);
+                }
+            }
+        }
+    }
+}
+
+// Each worker thread keeps its rows between slices and between passes, so a
+// slice doesn't pay for allocating (and page faulting in) hundreds of KB
+struct mip_scratch_t
+{
+    std::vector<float>          z_rows;
+    std::vector<float>          y_rows;
+    std::vector<float>          scratch_row;
+    std::vector<unsigned char>  scratch_bytes;      // bricked source rows
+};
+
+static void downsample_slice(unsigned int dst_z, void* user_data)
+{
+    mip_pass_t* pass = (mip_pass_t*)user_data;
+
+    static thread_local mip_scratch_t scratch;
+    size_t row_count = (size_t)pass->src.width * volume_format_get_num_channels(pass->format);
+    scratch.z_rows.resize(row_count * pass->src.height);
+    scratch.y_rows.resize(row_count * pass->dst->height);
+    scratch.scratch_row.resize(row_count);
+    scratch.scratch_bytes.resize((size_t)pass->src.width * pass->src.bytes_per_voxel);
+
+    filter_z(*pass, dst_z, scratch.z_rows.data(), scratch.scratch_row.data(), scratch.scratch_bytes.data());
+    filter_y(*pass, scratch.z_rows.data(), scratch.y_rows.data());
+    filter_x_and_store(*pass, scratch.y_rows.data(), dst_z);
+}
+
+static unsigned int downsample(const volume_view_t& src, VolumeFormat format, VolumeMipFilter filter, volume_buffer_t* out_dst, unsigned int max_workers)
+{
+    out_dst->resize(half_size(src.width), half_size(src.height), half_size(src.depth), src.bytes_per_voxel, src.layout);
+
+    mip_pass_t pass;
+    pass.src        = src;
+    pass.dst        = out_dst;
+    pass.format     = format;
+    pass.kernel     = get_kernel(filter);
+    pass.simd_level = cpu_get_simd_level();
+    pass.half_table = (format == VOLUME_FORMAT_R16F) ? get_half_to_float_table() : nullptr;
+
+    return job_parallel_for(out_dst->depth, downsample_slice, &pass, max_workers);
+}
+
+//-----------------------------------------------------
+// Public API
+
+const char* volume_mip_filter_get_name(VolumeMipFilter filter)
+{
+    return (filter < NUM_VOLUME_MIP_FILTERS) ? s_filter_names[filter] : "unknown";
+}
+
+bool volume_mip_filter_from_name(VolumeMipFilter* out_filter, const char* name)
+{
+    for(unsigned int i = 0; i < NUM_VOLUME_MIP_FILTERS; ++i){
+        if(strcmp(s_filter_names[i], name) == 0){
+            *out_filter = (VolumeMipFilter)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+unsigned int volume_mips_get_full_count(unsigned int width, unsigned int height, unsigned int depth)
+{
+    unsigned int largest = (width > height) ? width : height;
+    largest = (largest > depth) ? largest : depth;
+
+    unsigned int count = 1;
+    while(largest > 1){
+        largest /= 2;
+        ++count;
+    }
+    return count;
+}
+
+void volume_mips_downsample(const volume_view_t& src, VolumeFormat format, VolumeMipFilter filter, volume_buffer_t* out_dst, unsigned int max_workers)
+{
+    downsample(src, format, filter, out_dst, max_workers);
+}
+
+bool volume_mips_build(const volume_view_t& top, VolumeFormat format, VolumeMipFilter filter, std::vector<volume_buffer_t>* out_mips, unsigned int num_mips, unsigned int max_workers, volume_mip_stats_t* out_stats)
+{
+    if((format >= NUM_VOLUME_FORMATS) || (top.bytes_per_voxel != volume_format_get_bytes_per_voxel(format))){
+        return false;
+    }
+
+    double start = get_current_time_seconds();
+
+    unsigned int full_count = volume_mips_get_full_count(top.width, top.height, top.depth);
+    num_mips = ((num_mips == 0) || (num_mips > full_count)) ? full_count : num_mips;
+
+    // Sized up front, each level reads the one before it
+    out_mips->resize(num_mips - 1);
+
+    unsigned int num_workers = 1;
+    size_t bytes_read = 0;
+    size_t bytes_written = 0;
+
+    volume_view_t src = top;
+    for(unsigned int i = 1; i < num_mips; ++i){
+        volume_buffer_t* dst = &(*out_mips)[i - 1];
+        unsigned int workers = downsample(src, format, filter, dst, max_workers);
+        num_workers = (workers > num_workers) ? workers : num_workers;
+
+        bytes_read += src.get_size();
+        bytes_written += dst->data.size();
+        src = dst->get_view();
+    }
+
+    if(nullptr != out_stats){
+        out_stats->seconds          = get_current_time_seconds() - start;
+        out_stats->num_mips         = num_mips;
+        out_stats->num_workers      = num_workers;
+        out_stats->bytes_read       = bytes_read;
+        out_stats->bytes_written    = bytes_written;
+    }
+    return true;
+}
+
+void volume_mips_get_views(const volume_view_t& top, const std::vector<volume_buffer_t>& lower_mips, std::vector<volume_view_t>* out_views)
+{
+    out_views->clear();
+    out_views->push_back(top);
+    for(const volume_buffer_t& mip : lower_mips){
+        out_views->push_back(mip.get_view());
+    }
+}
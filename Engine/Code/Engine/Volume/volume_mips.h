@@ -0,0 +1,54 @@
+#pragma once
+
+#include "Engine/Volume/volume_buffer.h"
+
+#include <vector>
+
+//-----------------------------------------------------
+// Volume Mips
+//
+// CPU mip chain builder, so volumes can ship with their mips instead of
+// leaning on GenerateMips at load. Each level halves every axis (rounded
+// down, never below 1) with a separable filter: the source slices under a
+// destination slice are blended along z, then y, then x, in float. Addressing
+// wraps, the cloud volumes all tile.
+//
+// The z and y passes (the bulk of the work) run on SSE4.1/AVX2 through the
+// simd.h lanes and give the same bits as the scalar path. Destination slices
+// are split across GENERIC jobs plus the calling thread. Mips come out in
+// the source's layout, bricked sources give bricked mips.
+
+enum VolumeMipFilter
+{
+    VOLUME_MIP_FILTER_BOX = 0,      // 2 taps per axis, the classic 2x2x2 average
+    VOLUME_MIP_FILTER_KAISER,       // 6 tap Kaiser windowed sinc, sharper with less aliasing
+    NUM_VOLUME_MIP_FILTERS
+};
+
+struct volume_mip_stats_t
+{
+    double          seconds;
+    unsigned int    num_mips;       // including the top level
+    unsigned int    num_workers;
+    size_t          bytes_read;
+    size_t          bytes_written;
+
+    double bytes_per_second() const { return (seconds > 0.0) ? (double)bytes_read / seconds : 0.0; }
+};
+
+const char*     volume_mip_filter_get_name(VolumeMipFilter filter);
+bool            volume_mip_filter_from_name(VolumeMipFilter* out_filter, const char* name);
+
+// Levels in a full chain down to 1x1x1, the top level included
+unsigned int    volume_mips_get_full_count(unsigned int width, unsigned int height, unsigned int depth);
+
+// One level down from <src>, <max_workers> 0 uses every core. Needs job_system_init.
+void            volume_mips_downsample(const volume_view_t& src, VolumeFormat format, VolumeMipFilter filter, volume_buffer_t* out_dst, unsigned int max_workers = 0);
+
+// Builds levels 1..num_mips-1 below <top> into <out_mips> (so out_mips[0] is mip 1).
+// <num_mips> counts the top level, 0 means the full chain. Fails if <top>
+// doesn't match <format>'s voxel size.
+bool            volume_mips_build(const volume_view_t& top, VolumeFormat format, VolumeMipFilter filter, std::vector<volume_buffer_t>* out_mips, unsigned int num_mips = 0, unsigned int max_workers = 0, volume_mip_stats_t* out_stats = nullptr);
+
+// <top> followed by views of <lower_mips>, ready for volume_file_save or an upload
+void            volume_mips_get_views(const volume_view_t& top, const std::vector<volume_buffer_t>& lower_mips, std::vector<volume_view_t>* out_views);
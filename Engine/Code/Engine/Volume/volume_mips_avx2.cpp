@@ -0,0 +1,14 @@
+#include "Engine/Volume/volume_mips_lanes.h"
+
+//-----------------------------------------------------
+// Public API
+
+void volume_mips_accumulate_u8_avx2(float* acc, const unsigned char* src, float weight, size_t count)
+{
+    accumulate_u8_kernel<simd8_t>(acc, src, weight, count);
+}
+
+void volume_mips_accumulate_float_avx2(float* acc, const float* src, float weight, size_t count)
+{
+    accumulate_float_kernel<simd8_t>(acc, src, weight, count);
+}
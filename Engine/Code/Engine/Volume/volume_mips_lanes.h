@@ -0,0 +1,45 @@
+#pragma once
+
+#include "Engine/Math/simd.h"
+
+#include <stddef.h>
+
+//-----------------------------------------------------
+// Volume Mips Lanes
+//
+// The accumulate kernels of the mip filters, shared by volume_mips.cpp
+// (simd4_t) and volume_mips_avx2.cpp (simd8_t), which is the only file built
+// for AVX2. Static so each file compiles its own copy.
+
+// The AVX2 kernels, only call them after checking cpu_has_avx2()
+void    volume_mips_accumulate_u8_avx2(float* acc, const unsigned char* src, float weight, size_t count);
+void    volume_mips_accumulate_float_avx2(float* acc, const float* src, float weight, size_t count);
+
+// acc += src * weight, the same mul then add in every path so results match bit for bit
+template<typename SIMD>
+static void accumulate_u8_kernel(float* acc, const unsigned char* src, float weight, size_t count)
+{
+    typename SIMD::vfloat lane_weight = SIMD::set1(weight);
+
+    size_t i = 0;
+    for(; i + SIMD::WIDTH <= count; i += SIMD::WIDTH){
+        SIMD::store(acc + i, SIMD::add(SIMD::load(acc + i), SIMD::mul(SIMD::load_u8(src + i), lane_weight)));
+    }
+    for(; i < count; ++i){
+        acc[i] += (float)src[i] * weight;
+    }
+}
+
+template<typename SIMD>
+static void accumulate_float_kernel(float* acc, const float* src, float weight, size_t count)
+{
+    typename SIMD::vfloat lane_weight = SIMD::set1(weight);
+
+    size_t i = 0;
+    for(; i + SIMD::WIDTH <= count; i += SIMD::WIDTH){
+        SIMD::store(acc + i, SIMD::add(SIMD::load(acc + i), SIMD::mul(SIMD::load(src + i), lane_weight)));
+    }
+    for(; i < count; ++i){
+        acc[i] += src[i] * weight;
+    }
+}
@@ -0,0 +1,165 @@
+#include "Engine/Volume/volume_sampler.h"
+
+#include "Engine/Core/cpu.h"
+#include "Engine/Volume/volume_sampler_lanes.h"
+
+#include <math.h>
+
+//-----------------------------------------------------
+// Internal helpers
+
+// Texel below <coord> along an axis of <size> texels and the weight of the
+// one after it, both wrapped or clamped into range
+static inline void get_texels(float coord, unsigned int size, VolumeAddressMode address, unsigned int* out_t0, unsigned int* out_t1, float* out_weight)
+{
+    float texel = (coord * (float)size) - 0.5f;
+    float texel_floor = floorf(texel);
+    *out_weight = texel - texel_floor;
+
+    if(address == VOLUME_ADDRESS_CLAMP){
+        // Clamped as a float first so the int conversion stays in range
+        float clamped = (texel_floor < -1.0f) ? -1.0f : ((texel_floor > (float)size) ? (float)size : texel_floor);
+        int t0 = (int)clamped;
+        int t1 = t0 + 1;
+        int last = (int)size - 1;
+        *out_t0 = (unsigned int)((t0 < 0) ? 0 : ((t0 > last) ? last : t0));
+        *out_t1 = (unsigned int)((t1 < 0) ? 0 : ((t1 > last) ? last : t1));
+        return;
+    }
+
+    // fmod keeps the int conversion in range however far a world position wanders
+    float wrapped = fmodf(texel_floor, (float)size);
+    int t0 = (int)wrapped;
+    if(t0 < 0){
+        t0 += (int)size;
+    }
+
+    *out_t0 = (unsigned int)t0;
+    *out_t1 = ((unsigned int)t0 + 1 < size) ? (unsigned int)t0 + 1 : 0;
+}
+
+static inline void read_voxel(const volume_view_t& mip, VolumeFormat format, unsigned int x, unsigned int y, unsigned int z, float* out_rgba)
+{
+    const unsigned char* voxel = mip.get_voxel(x, y, z);
+    switch(format){
+        case VOLUME_FORMAT_RGBA8:
+            out_rgba[0] = (float)voxel[0] * (1.0f / 255.0f);
+            out_rgba[1] = (float)voxel[1] * (1.0f / 255.0f);
+            out_rgba[2] = (float)voxel[2] * (1.0f / 255.0f);
+            out_rgba[3] = (float)voxel[3] * (1.0f / 255.0f);
+            break;
+        case VOLUME_FORMAT_R8:
+            out_rgba[0] = (float)voxel[0] * (1.0f / 255.0f);
+            out_rgba[1] = 0.0f;
+            out_rgba[2] = 0.0f;
+            out_rgba[3] = 1.0f;
+            break;
+        default:{
+            unsigned short half;
+            memcpy(&half, voxel, sizeof(half));
+            out_rgba[0] = volume_half_to_float(half);
+            out_rgba[1] = 0.0f;
+            out_rgba[2] = 0.0f;
+            out_rgba[3] = 1.0f;
+            break;
+        }
+    }
+}
+
+static void sample_mip(const volume_view_t& mip, VolumeFormat format, VolumeAddressMode address, float u, float v, float w, float* out_rgba)
+{
+    unsigned int x0, x1, y0, y1, z0, z1;
+    float fx, fy, fz;
+    get_texels(u, mip.width, address, &x0, &x1, &fx);
+    get_texels(v, mip.height, address, &y0, &y1, &fy);
+    get_texels(w, mip.depth, address, &z0, &z1, &fz);
+
+    float corners[8][4];
+    read_voxel(mip, format, x0, y0, z0, corners[0]);
+    read_voxel(mip, format, x1, y0, z0, corners[1]);
+    read_voxel(mip, format, x0, y1, z0, corners[2]);
+    read_voxel(mip, format, x1, y1, z0, corners[3]);
+    read_voxel(mip, format, x0, y0, z1, corners[4]);
+    read_voxel(mip, format, x1, y0, z1, corners[5]);
+    read_voxel(mip, format, x0, y1, z1, corners[6]);
+    read_voxel(mip, format, x1, y1, z1, corners[7]);
+
+    for(unsigned int c = 0; c < 4; ++c){
+        float x00 = corners[0][c] + ((corners[1][c] - corners[0][c]) * fx);
+        float x10 = corners[2][c] + ((corners[3][c] - corners[2][c]) * fx);
+        float x01 = corners[4][c] + ((corners[5][c] - corners[4][c]) * fx);
+        float x11 = corners[6][c] + ((corners[7][c] - corners[6][c]) * fx);
+
+        float y0_value = x00 + ((x10 - x00) * fy);
+        float y1_value = x01 + ((x11 - x01) * fy);
+
+        out_rgba[c] = y0_value + ((y1_value - y0_value) * fz);
+    }
+}
+
+//-----------------------------------------------------
+// Public API
+
+bool volume_sampler_init(volume_sampler_t* sampler, const volume_view_t* mips, unsigned int num_mips, VolumeFormat format, VolumeAddressMode address)
+{
+    if(volume_format_is_compressed(format) || (num_mips == 0)){
+        return false;
+    }
+
+    if(num_mips > VOLUME_SAMPLER_MAX_MIPS){
+        num_mips = VOLUME_SAMPLER_MAX_MIPS;
+    }
+
+    unsigned int bytes_per_voxel = volume_format_get_bytes_per_voxel(format);
+    for(unsigned int mip = 0; mip < num_mips; ++mip){
+        if((mips[mip].bytes_per_voxel != bytes_per_voxel) || (mips[mip].get_size() == 0)){
+            return false;
+        }
+        sampler->mips[mip] = mips[mip];
+    }
+
+    sampler->num_mips = num_mips;
+    sampler->format = format;
+    sampler->address = address;
+    return true;
+}
+
+void volume_sample_trilinear(const volume_sampler_t& sampler, float u, float v, float w, float mip, float* out_rgba)
+{
+    unsigned int mip0;
+    float mip_weight;
+    get_mip_levels(sampler, mip, &mip0, &mip_weight);
+
+    sample_mip(sampler.mips[mip0], sampler.format, sampler.address, u, v, w, out_rgba);
+    if((mip_weight <= 0.0f) || (mip0 + 1 >= sampler.num_mips)){
+        return;
+    }
+
+    float lower[4];
+    sample_mip(sampler.mips[mip0 + 1], sampler.format, sampler.address, u, v, w, lower);
+    for(unsigned int c = 0; c < 4; ++c){
+        out_rgba[c] += (lower[c] - out_rgba[c]) * mip_weight;
+    }
+}
+
+void volume_sample_trilinear_x4(const volume_sampler_t& sampler, __m128 u, __m128 v, __m128 w, float mip, __m128* out_rgba)
+{
+    sample_trilinear_lanes<simd4_t>(sampler, u, v, w, mip, out_rgba);
+}
+
+void volume_sample_trilinear_batch(const volume_sampler_t& sampler, const float* us, const float* vs, const float* ws, unsigned int count, float mip, float* out_rgba)
+{
+    switch(cpu_get_simd_level()){
+        case SIMD_LEVEL_AVX2:
+            volume_sample_trilinear_batch_avx2(sampler, us, vs, ws, count, mip, out_rgba);
+            break;
+        case SIMD_LEVEL_SSE41:
+            sample_trilinear_batch_kernel<simd4_t>(sampler, us, vs, ws, count, mip, out_rgba);
+            break;
+        default:
+            for(unsigned int i = 0; i < count; ++i){
+                volume_sample_trilinear(sampler, us[i], vs[i], ws[i], mip, out_rgba + ((size_t)i * 4));
+            }
+            break;
+    }
+}
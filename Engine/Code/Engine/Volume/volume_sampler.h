@@ -0,0 +1,62 @@
+#pragma once
+
+#include "Engine/Volume/volume_buffer.h"
+
+#include <immintrin.h>
+
+//-----------------------------------------------------
+// Volume Sampler
+//
+// CPU stand-in for Texture3D.SampleLevel through a trilinear sampler, which
+// is how the cloud shaders read their noise volumes. Texel centers sit at
+// (i + 0.5) / size like D3D, and a fractional mip level blends the two levels
+// around it, clamped to the chain that's there. Addressing wraps, like the
+// shaders' sampler, or clamps to the edge texels.
+//
+// Unorm formats come back in [0, 1]. Channels the format doesn't have read
+// as 0, alpha as 1, the same as a shader sees. Mips can be linear or
+// bricked, see volume_buffer.h.
+//
+// The x4/x8 and batch versions take 4 or 8 positions at a time through the
+// simd.h lanes, gathering the corners, and give the same bits as the single
+// sample path as long as coordinates stay within 2^24 texels.
+
+#define VOLUME_SAMPLER_MAX_MIPS     16
+
+enum VolumeAddressMode
+{
+    VOLUME_ADDRESS_WRAP = 0,
+    VOLUME_ADDRESS_CLAMP,
+    NUM_VOLUME_ADDRESS_MODES
+};
+
+struct volume_sampler_t
+{
+    volume_view_t       mips[VOLUME_SAMPLER_MAX_MIPS];
+    unsigned int        num_mips;
+    VolumeFormat        format;
+    VolumeAddressMode   address;
+
+    volume_sampler_t()
+        :num_mips(0)
+        ,format(VOLUME_FORMAT_RGBA8)
+        ,address(VOLUME_ADDRESS_WRAP)
+    {}
+};
+
+// <mips> is largest first, as volume_mips_get_views hands them out. The views
+// are kept, not copied, so the voxels have to outlive the sampler. Fails for
+// compressed formats and voxel sizes that don't match <format>.
+bool    volume_sampler_init(volume_sampler_t* sampler, const volume_view_t* mips, unsigned int num_mips, VolumeFormat format, VolumeAddressMode address = VOLUME_ADDRESS_WRAP);
+
+// One trilinear sample of level <mip>, <u, v, w> normalized
+void    volume_sample_trilinear(const volume_sampler_t& sampler, float u, float v, float w, float mip, float* out_rgba);
+
+// 4 or 8 samples of one <mip> with the positions already in registers,
+// <out_rgba> gets one register per channel. x8 needs cpu_has_avx2().
+void    volume_sample_trilinear_x4(const volume_sampler_t& sampler, __m128 u, __m128 v, __m128 w, float mip, __m128* out_rgba);
+void    volume_sample_trilinear_x8(const volume_sampler_t& sampler, __m256 u, __m256 v, __m256 w, float mip, __m256* out_rgba);
+
+// <count> samples of one <mip> at the widest cpu_get_simd_level(), rgba per
+// sample into <out_rgba>
+void    volume_sample_trilinear_batch(const volume_sampler_t& sampler, const float* us, const float* vs, const float* ws, unsigned int count, float mip, float* out_rgba);
@@ -0,0 +1,14 @@
+#include "Engine/Volume/volume_sampler_lanes.h"
+
+//-----------------------------------------------------
+// Public API
+
+void volume_sample_trilinear_x8(const volume_sampler_t& sampler, __m256 u, __m256 v, __m256 w, float mip, __m256* out_rgba)
+{
+    sample_trilinear_lanes<simd8_t>(sampler, u, v, w, mip, out_rgba);
+}
+
+void volume_sample_trilinear_batch_avx2(const volume_sampler_t& sampler, const float* us, const float* vs, const float* ws, unsigned int count, float mip, float* out_rgba)
+{
+    sample_trilinear_batch_kernel<simd8_t>(sampler, us, vs, ws, count, mip, out_rgba);
+}
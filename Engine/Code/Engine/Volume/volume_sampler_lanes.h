@@ -0,0 +1,208 @@
+#pragma once
+
+#include "Engine/Volume/volume_sampler.h"
+#include "Engine/Math/simd.h"
+
+#include <string.h>
+
+//-----------------------------------------------------
+// Volume Sampler Lanes
+//
+// The lane templates behind the x4/x8 and batch samplers, shared by
+// volume_sampler.cpp (simd4_t) and volume_sampler_avx2.cpp (simd8_t), which
+// is the only file built for AVX2. The helpers are static so each file keeps
+// its own copy, compiled for its own instruction set.
+
+// The AVX2 batch kernel, only call it after checking cpu_has_avx2()
+void    volume_sample_trilinear_batch_avx2(const volume_sampler_t& sampler, const float* us, const float* vs, const float* ws, unsigned int count, float mip, float* out_rgba);
+
+// The two levels a fractional <mip> blends and the weight of the lower one
+static void get_mip_levels(const volume_sampler_t& sampler, float mip, unsigned int* out_mip0, float* out_weight)
+{
+    float max_mip = (float)(sampler.num_mips - 1);
+    if(!(mip > 0.0f)){
+        mip = 0.0f;
+    }else if(mip > max_mip){
+        mip = max_mip;
+    }
+
+    *out_mip0 = (unsigned int)mip;
+    *out_weight = mip - (float)*out_mip0;
+}
+
+// get_texels across lanes, the wrap done in float since every value is a
+// whole number
+template<typename SIMD>
+static __forceinline void get_texels_lanes(typename SIMD::vfloat coord, unsigned int size, VolumeAddressMode address, typename SIMD::vint* out_t0, typename SIMD::vint* out_t1, typename SIMD::vfloat* out_weight)
+{
+    typedef typename SIMD::vfloat vfloat;
+    typedef typename SIMD::vint vint;
+
+    vfloat size_lanes = SIMD::set1((float)size);
+    vfloat texel = SIMD::sub(SIMD::mul(coord, size_lanes), SIMD::set1(0.5f));
+    vfloat texel_floor = SIMD::floor(texel);
+    *out_weight = SIMD::sub(texel, texel_floor);
+
+    vint last = SIMD::set1_int((int)size - 1);
+    if(address == VOLUME_ADDRESS_CLAMP){
+        vfloat clamped = SIMD::min(SIMD::max(texel_floor, SIMD::set1(-1.0f)), size_lanes);
+        vint t0 = SIMD::to_int_truncate(clamped);
+        vint t1 = SIMD::add_int(t0, SIMD::set1_int(1));
+        *out_t0 = SIMD::min_int(SIMD::max_int(t0, SIMD::set1_int(0)), last);
+        *out_t1 = SIMD::min_int(SIMD::max_int(t1, SIMD::set1_int(0)), last);
+        return;
+    }
+
+    vfloat wrapped = SIMD::sub(texel_floor, SIMD::mul(SIMD::floor(SIMD::mul(texel_floor, SIMD::set1(1.0f / (float)size))), size_lanes));
+
+    // 1 / size is rounded, so fix up anything that landed one size off
+    wrapped = SIMD::select(SIMD::cmp_lt(wrapped, SIMD::zero()), SIMD::add(wrapped, size_lanes), wrapped);
+    wrapped = SIMD::select(SIMD::cmp_le(size_lanes, wrapped), SIMD::sub(wrapped, size_lanes), wrapped);
+
+    vint t0 = SIMD::to_int_truncate(wrapped);
+    vint t1 = SIMD::add_int(t0, SIMD::set1_int(1));
+    vint is_past_end = SIMD::cmp_eq_int(t0, last);
+    *out_t0 = t0;
+    *out_t1 = SIMD::and_int(t1, SIMD::xor_int(is_past_end, SIMD::set1_int(-1)));
+}
+
+// One corner per lane. RGBA8 voxels are a whole int so they gather in one
+// go, the 1 and 2 byte formats are read a lane at a time so nothing reads
+// past the end of the mip.
+template<typename SIMD>
+static __forceinline void read_voxel_lanes(const volume_view_t& mip, VolumeFormat format, typename SIMD::vint x, typename SIMD::vint y, typename SIMD::vint z, typename SIMD::vfloat* out_rgba)
+{
+    typedef typename SIMD::vint vint;
+
+    if(format == VOLUME_FORMAT_RGBA8){
+        vint row = SIMD::set1_int((int)(mip.row_pitch / 4));
+        vint slice = SIMD::set1_int((int)(mip.slice_pitch / 4));
+        vint index;
+        if(mip.layout == VOLUME_LAYOUT_BRICKED){
+            // Brick from the top bits, voxel within it from the low ones
+            vint brick_mask = SIMD::set1_int(VOLUME_BRICK_MASK);
+            vint brick = SIMD::add_int(SIMD::add_int(SIMD::mul_int(SIMD::template shift_right<VOLUME_BRICK_SHIFT>(z), slice), SIMD::mul_int(SIMD::template shift_right<VOLUME_BRICK_SHIFT>(y), row)),
+                SIMD::template shift_left<3 * VOLUME_BRICK_SHIFT>(SIMD::template shift_right<VOLUME_BRICK_SHIFT>(x)));
+            vint voxel = SIMD::add_int(SIMD::add_int(SIMD::template shift_left<2 * VOLUME_BRICK_SHIFT>(SIMD::and_int(z, brick_mask)), SIMD::template shift_left<VOLUME_BRICK_SHIFT>(SIMD::and_int(y, brick_mask))),
+                SIMD::and_int(x, brick_mask));
+            index = SIMD::add_int(brick, voxel);
+        }else{
+            index = SIMD::add_int(SIMD::add_int(SIMD::mul_int(z, slice), SIMD::mul_int(y, row)), x);
+        }
+        vint voxels = SIMD::gather_int((const int*)mip.data, index);
+
+        vint byte_mask = SIMD::set1_int(0xff);
+        typename SIMD::vfloat scale = SIMD::set1(1.0f / 255.0f);
+        out_rgba[0] = SIMD::mul(SIMD::to_float(SIMD::and_int(voxels, byte_mask)), scale);
+        out_rgba[1] = SIMD::mul(SIMD::to_float(SIMD::and_int(SIMD::template shift_right<8>(voxels), byte_mask)), scale);
+        out_rgba[2] = SIMD::mul(SIMD::to_float(SIMD::and_int(SIMD::template shift_right<16>(voxels), byte_mask)), scale);
+        out_rgba[3] = SIMD::mul(SIMD::to_float(SIMD::template shift_right<24>(voxels)), scale);
+        return;
+    }
+
+    alignas(SIMD_ALIGN_BYTES) int xs[SIMD::WIDTH];
+    alignas(SIMD_ALIGN_BYTES) int ys[SIMD::WIDTH];
+    alignas(SIMD_ALIGN_BYTES) int zs[SIMD::WIDTH];
+    alignas(SIMD_ALIGN_BYTES) float values[SIMD::WIDTH];
+    SIMD::store_int(xs, x);
+    SIMD::store_int(ys, y);
+    SIMD::store_int(zs, z);
+    for(unsigned int lane = 0; lane < SIMD::WIDTH; ++lane){
+        const unsigned char* voxel = mip.get_voxel((unsigned int)xs[lane], (unsigned int)ys[lane], (unsigned int)zs[lane]);
+        if(format == VOLUME_FORMAT_R8){
+            values[lane] = (float)voxel[0] * (1.0f / 255.0f);
+        }else{
+            unsigned short half;
+            memcpy(&half, voxel, sizeof(half));
+            values[lane] = volume_half_to_float(half);
+        }
+    }
+
+    out_rgba[0] = SIMD::load(values);
+    out_rgba[1] = SIMD::zero();
+    out_rgba[2] = SIMD::zero();
+    out_rgba[3] = SIMD::set1(1.0f);
+}
+
+// sample_mip across lanes, same op order
+template<typename SIMD>
+static __forceinline void sample_mip_lanes(const volume_view_t& mip, VolumeFormat format, VolumeAddressMode address, typename SIMD::vfloat u, typename SIMD::vfloat v, typename SIMD::vfloat w, typename SIMD::vfloat* out_rgba)
+{
+    typedef typename SIMD::vfloat vfloat;
+    typedef typename SIMD::vint vint;
+
+    vint x0, x1, y0, y1, z0, z1;
+    vfloat fx, fy, fz;
+    get_texels_lanes<SIMD>(u, mip.width, address, &x0, &x1, &fx);
+    get_texels_lanes<SIMD>(v, mip.height, address, &y0, &y1, &fy);
+    get_texels_lanes<SIMD>(w, mip.depth, address, &z0, &z1, &fz);
+
+    vfloat corners[8][4];
+    read_voxel_lanes<SIMD>(mip, format, x0, y0, z0, corners[0]);
+    read_voxel_lanes<SIMD>(mip, format, x1, y0, z0, corners[1]);
+    read_voxel_lanes<SIMD>(mip, format, x0, y1, z0, corners[2]);
+    read_voxel_lanes<SIMD>(mip, format, x1, y1, z0, corners[3]);
+    read_voxel_lanes<SIMD>(mip, format, x0, y0, z1, corners[4]);
+    read_voxel_lanes<SIMD>(mip, format, x1, y0, z1, corners[5]);
+    read_voxel_lanes<SIMD>(mip, format, x0, y1, z1, corners[6]);
+    read_voxel_lanes<SIMD>(mip, format, x1, y1, z1, corners[7]);
+
+    for(unsigned int c = 0; c < 4; ++c){
+        vfloat x00 = SIMD::add(corners[0][c], SIMD::mul(SIMD::sub(corners[1][c], corners[0][c]), fx));
+        vfloat x10 = SIMD::add(corners[2][c], SIMD::mul(SIMD::sub(corners[3][c], corners[2][c]), fx));
+        vfloat x01 = SIMD::add(corners[4][c], SIMD::mul(SIMD::sub(corners[5][c], corners[4][c]), fx));
+        vfloat x11 = SIMD::add(corners[6][c], SIMD::mul(SIMD::sub(corners[7][c], corners[6][c]), fx));
+
+        vfloat y0_value = SIMD::add(x00, SIMD::mul(SIMD::sub(x10, x00), fy));
+        vfloat y1_value = SIMD::add(x01, SIMD::mul(SIMD::sub(x11, x01), fy));
+
+        out_rgba[c] = SIMD::add(y0_value, SIMD::mul(SIMD::sub(y1_value, y0_value), fz));
+    }
+}
+
+template<typename SIMD>
+static __forceinline void sample_trilinear_lanes(const volume_sampler_t& sampler, typename SIMD::vfloat u, typename SIMD::vfloat v, typename SIMD::vfloat w, float mip, typename SIMD::vfloat* out_rgba)
+{
+    unsigned int mip0;
+    float mip_weight;
+    get_mip_levels(sampler, mip, &mip0, &mip_weight);
+
+    sample_mip_lanes<SIMD>(sampler.mips[mip0], sampler.format, sampler.address, u, v, w, out_rgba);
+    if((mip_weight <= 0.0f) || (mip0 + 1 >= sampler.num_mips)){
+        return;
+    }
+
+    typename SIMD::vfloat lower[4];
+    typename SIMD::vfloat weight = SIMD::set1(mip_weight);
+    sample_mip_lanes<SIMD>(sampler.mips[mip0 + 1], sampler.format, sampler.address, u, v, w, lower);
+    for(unsigned int c = 0; c < 4; ++c){
+        out_rgba[c] = SIMD::add(out_rgba[c], SIMD::mul(SIMD::sub(lower[c], out_rgba[c]), weight));
+    }
+}
+
+template<typename SIMD>
+static void sample_trilinear_batch_kernel(const volume_sampler_t& sampler, const float* us, const float* vs, const float* ws, unsigned int count, float mip, float* out_rgba)
+{
+    unsigned int index = 0;
+    for(; index + SIMD::WIDTH <= count; index += SIMD::WIDTH){
+        typename SIMD::vfloat rgba[4];
+        sample_trilinear_lanes<SIMD>(sampler, SIMD::load(us + index), SIMD::load(vs + index), SIMD::load(ws + index), mip, rgba);
+
+        alignas(SIMD_ALIGN_BYTES) float channels[4][SIMD::WIDTH];
+        for(unsigned int c = 0; c < 4; ++c){
+            SIMD::store(channels[c], rgba[c]);
+        }
+        for(unsigned int lane = 0; lane < SIMD::WIDTH; ++lane){
+            float* out = out_rgba + ((size_t)(index + lane) * 4);
+            out[0] = channels[0][lane];
+            out[1] = channels[1][lane];
+            out[2] = channels[2][lane];
+            out[3] = channels[3][lane];
+        }
+    }
+
+    // Leftovers go through the single sample path, which gives the same bits
+    for(; index < count; ++index){
+        volume_sample_trilinear(sampler, us[index], vs[index], ws[index], mip, out_rgba + ((size_t)index * 4));
+    }
+}
@@ -0,0 +1,96 @@
+#include "CloudTool/cloudtool.h"
+
+#include "Engine/Core/Config.hpp"
+#include "Engine/Core/cpu.h"
+#include "Engine/Core/job.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+//-----------------------------------------------------
+// CloudTool
+//
+// Headless front end for the offline cloud pipeline. Nothing in here opens a
+// window or creates a device, so it runs fine on build machines.
+//
+//  CloudTool <verb> [verb args] [-config file] [-threads N] [-simd level]
+
+static const char* DEFAULT_CONFIG_FILE = "Data/Config.dat";
+
+//-----------------------------------------------------
+// Internal helpers
+
+static bool set_simd_level_from_name(const char* name)
+{
+    if(strcmp(name, "auto") == 0){
+        cpu_set_max_simd_level(NUM_SIMD_LEVELS);
+        return true;
+    }
+
+    for(unsigned int i = 0; i < NUM_SIMD_LEVELS; ++i){
+        if(strcmp(cpu_get_simd_level_name((SimdLevel)i), name) == 0){
+            cpu_set_max_simd_level((SimdLevel)i);
+            return true;
+        }
+    }
+    return false;
+}
+
+static void print_usage()
+{
+    printf("usage: CloudTool <verb> [args] [-config file] [-threads N] [-simd scalar|sse4.1|avx2|auto]\n");
+
+    std::vector<const tool_verb_t*> verbs;
+    tool_get_verbs(&verbs);
+    for(const tool_verb_t* verb : verbs){
+        if(verb->args[0] != '\0'){
+            printf("  %s %s\n", verb->name, verb->args);
+        }else{
+            printf("  %s\n", verb->name);
+        }
+        printf("      %s\n", verb->desc);
+    }
+}
+
+//-----------------------------------------------------
+// Entry point
+int main(int argc, char** argv)
+{
+    if(argc < 2){
+        print_usage();
+        return 1;
+    }
+
+    const tool_verb_t* verb = tool_find_verb(argv[1]);
+    if(nullptr == verb){
+        printf("unknown verb \"%s\"\n", argv[1]);
+        print_usage();
+        return 1;
+    }
+
+    int verb_argc = argc - 2;
+    char** verb_argv = argv + 2;
+
+    const char* config_file = get_option(verb_argc, verb_argv, "-config", DEFAULT_CONFIG_FILE);
+    if(!ConfigSystemStartup(config_file)){
+        printf("couldn't load \"%s\", using defaults\n", config_file);
+    }
+
+    const char* simd_level = get_option(verb_argc, verb_argv, "-simd", "auto");
+    if(!set_simd_level_from_name(simd_level)){
+        printf("unknown simd level \"%s\", using auto\n", simd_level);
+    }
+
+    // The main thread only waits, so give every core a worker by default
+    int num_threads_requested = atoi(get_option(verb_argc, verb_argv, "-threads", "0"));
+    job_system_init(num_threads_requested);
+    printf("%u worker threads, simd %s\n", job_get_max_workers(), cpu_get_simd_level_name(cpu_get_simd_level()));
+
+    int result = verb->cb(verb_argc, verb_argv);
+
+    job_system_shutdown();
+    ConfigSystemShutdown();
+    return result;
+}
@@ -0,0 +1,123 @@
+#include "CloudTool/cloudtool.h"
+
+#include <algorithm>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+//-----------------------------------------------------
+// Internal helpers
+
+// Function static, the verbs register from other files' static initializers
+static std::vector<tool_verb_t>& get_verbs()
+{
+    static std::vector<tool_verb_t> s_verbs;
+    return s_verbs;
+}
+
+//-----------------------------------------------------
+// Public API
+
+ToolVerbSelfRegister::ToolVerbSelfRegister(const char* name, const char* args, const char* desc, tool_verb_cb cb)
+{
+    tool_verb_t verb;
+    verb.name   = name;
+    verb.args   = args;
+    verb.desc   = desc;
+    verb.cb     = cb;
+    get_verbs().push_back(verb);
+}
+
+void tool_get_verbs(std::vector<const tool_verb_t*>* out_verbs)
+{
+    out_verbs->clear();
+    for(const tool_verb_t& verb : get_verbs()){
+        out_verbs->push_back(&verb);
+    }
+
+    std::sort(out_verbs->begin(), out_verbs->end(), [](const tool_verb_t* a, const tool_verb_t* b) -> bool{
+        return strcmp(a->name, b->name) < 0;
+    });
+}
+
+const tool_verb_t* tool_find_verb(const char* name)
+{
+    for(const tool_verb_t& verb : get_verbs()){
+        if(strcmp(verb.name, name) == 0){
+            return &verb;
+        }
+    }
+    return nullptr;
+}
+
+const char* get_option(int argc, char** argv, const char* name, const char* default_value)
+{
+    for(int i = 0; i < argc - 1; ++i){
+        if(strcmp(argv[i], name) == 0){
+            return argv[i + 1];
+        }
+    }
+    return default_value;
+}
+
+const char* get_positional_arg(int argc, char** argv, int index)
+{
+    int positional = 0;
+    for(int i = 0; i < argc; ++i){
+        if(argv[i][0] == '-'){
+            ++i;
+            continue;
+        }
+
+        if(positional == index){
+            return argv[i];
+        }
+        ++positional;
+    }
+    return nullptr;
+}
+
+bool has_extension(const char* path, const char* extension)
+{
+    size_t path_length = strlen(path);
+    size_t extension_length = strlen(extension);
+    return (path_length >= extension_length) && (strcmp(path + path_length - extension_length, extension) == 0);
+}
+
+float get_max_difference(const std::vector<float>& a, const std::vector<float>& b)
+{
+    float max_difference = 0.0f;
+    for(size_t i = 0; i < a.size(); ++i){
+        float difference = fabsf(a[i] - b[i]);
+        max_difference = (difference > max_difference) ? difference : max_difference;
+    }
+    return max_difference;
+}
+
+bool save_volume_with_mips(const char* path, VolumeFormat format, const volume_view_t& top, const char* filter_name, volume_mip_stats_t* out_stats)
+{
+    std::vector<volume_buffer_t> mips;
+    VolumeMipFilter filter;
+    if(volume_mip_filter_from_name(&filter, filter_name)){
+        volume_mips_build(top, format, filter, &mips, 0, 0, out_stats);
+    }else if(strcmp(filter_name, "none") != 0){
+        printf("unknown mip filter \"%s\", expected box, kaiser or none\n", filter_name);
+        return false;
+    }
+
+    std::vector<volume_view_t> views;
+    volume_mips_get_views(top, mips, &views);
+    return volume_file_save(path, format, views.data(), (unsigned int)views.size());
+}
+
+bool get_layout_option(int argc, char** argv, VolumeLayout* out_layout)
+{
+    const char* name = get_option(argc, argv, "-layout", "linear");
+    for(unsigned int i = 0; i < NUM_VOLUME_LAYOUTS; ++i){
+        if(strcmp(name, volume_layout_get_name((VolumeLayout)i)) == 0){
+            *out_layout = (VolumeLayout)i;
+            return true;
+        }
+    }
+    return false;
+}
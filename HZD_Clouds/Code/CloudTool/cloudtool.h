@@ -0,0 +1,64 @@
+#pragma once
+
+#include "Engine/Volume/volume_file.h"
+#include "Engine/Volume/volume_layout.h"
+#include "Engine/Volume/volume_mips.h"
+
+#include <stdint.h>
+#include <vector>
+
+//-----------------------------------------------------
+// CloudTool verbs
+//
+// Each verb lives with the others for its feature, cloudtool_noise.cpp,
+// cloudtool_volume.cpp, cloudtool_render.cpp and cloudtool_jobs.cpp, and
+// registers itself with TOOL_VERB the way engine code registers COMMANDs.
+// A verb gets the args after its name and returns the process exit code.
+//
+// check_ verbs are pass/fail versions of what the benches print, ctest runs
+// these. Each prints one line per case and returns nonzero if any case fails.
+typedef int (*tool_verb_cb)(int argc, char** argv);
+
+struct tool_verb_t
+{
+    const char*     name;
+    const char*     args;
+    const char*     desc;
+    tool_verb_cb    cb;
+};
+
+class ToolVerbSelfRegister
+{
+public:
+    ToolVerbSelfRegister(const char* name, const char* args, const char* desc, tool_verb_cb cb);
+};
+
+#define TOOL_VERB(verb_name, args, desc) \
+    static int ToolVerb_##verb_name(int argc, char** argv); \
+    static ToolVerbSelfRegister g_tool_verb_register_##verb_name(#verb_name, args, desc, ToolVerb_##verb_name); \
+    static int ToolVerb_##verb_name(int argc, char** argv)
+
+// Sorted by name
+void                tool_get_verbs(std::vector<const tool_verb_t*>* out_verbs);
+const tool_verb_t*  tool_find_verb(const char* name);
+
+//-----------------------------------------------------
+// Shared by the verbs
+
+static const char* const    DEFAULT_NOISE_CACHE_DIRECTORY = "Data/Cache/Noise/";
+static const uint64_t       DEFAULT_NOISE_CACHE_MAX_BYTES = 256ULL * 1024 * 1024;
+
+// Options are "-name value" pairs anywhere after the verb
+const char*     get_option(int argc, char** argv, const char* name, const char* default_value);
+
+// Positional args skip over any "-name value" pairs
+const char*     get_positional_arg(int argc, char** argv, int index);
+
+bool            has_extension(const char* path, const char* extension);
+float           get_max_difference(const std::vector<float>& a, const std::vector<float>& b);
+
+// <filter_name> "none" writes just the top level
+bool            save_volume_with_mips(const char* path, VolumeFormat format, const volume_view_t& top, const char* filter_name, volume_mip_stats_t* out_stats);
+
+// -layout linear|bricked, linear when it's not given
+bool            get_layout_option(int argc, char** argv, VolumeLayout* out_layout);
@@ -0,0 +1,899 @@
+#include "CloudTool/cloudtool.h"
+
+#include "Game/cloud_bench.h"
+
+#include "Engine/Core/Time.hpp"
+#include "Engine/Core/job.h"
+#include "Engine/Math/Noise.hpp"
+#include "Engine/Thread/atomic.h"
+#include "Engine/Thread/fiber.h"
+#include "Engine/Thread/thread.h"
+
+#include <algorithm>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+//-----------------------------------------------------
+// Job verbs
+//
+// Throughput, latency and correctness of the job system under each
+// scheduler, wait and priority setup. Most restart the job system and put
+// the original back when they're done.
+
+// Tiny jobs for bench_jobs, each only counts itself off
+struct bench_jobs_t
+{
+    unsigned int    num_done;
+};
+
+static bench_jobs_t s_bench_jobs;
+
+static void bench_flat_job(void*)
+{
+    atomic_incr(&s_bench_jobs.num_done);
+}
+
+// Splits its leaves in two jobs until there's one left, 2N - 1 jobs for N leaves
+static void bench_tree_job(void* user_data)
+{
+    unsigned int num_leaves = (unsigned int)(uintptr_t)user_data;
+    if(num_leaves == 1){
+        atomic_incr(&s_bench_jobs.num_done);
+        return;
+    }
+
+    unsigned int half = num_leaves / 2;
+    job_dispatch_and_release(job_create(JOB_TYPE_GENERIC, bench_tree_job, (void*)(uintptr_t)half));
+    job_dispatch_and_release(job_create(JOB_TYPE_GENERIC, bench_tree_job, (void*)(uintptr_t)(num_leaves - half)));
+}
+
+// Seconds until <num_done> leaves have run, negative when they didn't within the timeout
+static double run_bench_jobs(bool is_tree, unsigned int num_jobs, double timeout_seconds)
+{
+    s_bench_jobs.num_done = 0;
+    double start = get_current_time_seconds();
+    if(is_tree){
+        job_dispatch_and_release(job_create(JOB_TYPE_GENERIC, bench_tree_job, (void*)(uintptr_t)num_jobs));
+    }else{
+        for(unsigned int i = 0; i < num_jobs; ++i){
+            job_dispatch_and_release(job_create(JOB_TYPE_GENERIC, bench_flat_job, nullptr));
+        }
+    }
+
+    while(atomic_load_acquire(&s_bench_jobs.num_done) < num_jobs){
+        if((get_current_time_seconds() - start) > timeout_seconds){
+            return -1.0;
+        }
+        thread_yield();
+    }
+    return get_current_time_seconds() - start;
+}
+
+// 1..-threads workers
+TOOL_VERB(bench_jobs, "[-jobs N] [-runs N] [-timeout s]", "tiny job throughput per scheduler at 1..-threads workers, fails if jobs go missing")
+{
+    unsigned int num_jobs = (unsigned int)atoi(get_option(argc, argv, "-jobs", "1000000"));
+    unsigned int num_runs = (unsigned int)atoi(get_option(argc, argv, "-runs", "3"));
+    double timeout_seconds = atof(get_option(argc, argv, "-timeout", "60"));
+    if((num_jobs == 0) || (num_runs == 0) || (timeout_seconds <= 0.0)){
+        printf("bench_jobs: invalid job count, run count or timeout\n");
+        return 1;
+    }
+
+    // Restarts the job system for every thread count and scheduler, then puts it back
+    unsigned int max_threads = job_get_max_workers();
+    JobScheduler original_scheduler = job_system_get_scheduler();
+    printf("bench_jobs %u tiny jobs, best of %u, 1..%u threads\n", num_jobs, num_runs, max_threads);
+    printf("  flat dispatches every job from the main thread, tree has each job dispatch two more (%u jobs)\n", (num_jobs * 2) - 1);
+    printf("  %-8s %-9s %12s %12s %10s %10s\n", "threads", "scheduler", "flat Mjob/s", "tree Mjob/s", "steals", "sleeps");
+
+    int result = 0;
+    for(unsigned int threads = 1; threads <= max_threads; ++threads){
+        for(unsigned int s = 0; s < NUM_JOB_SCHEDULERS; ++s){
+            job_system_shutdown();
+            job_system_init((int)threads, (JobScheduler)s);
+
+            double best[2] = { 0.0, 0.0 };
+            for(unsigned int run = 0; run < num_runs; ++run){
+                for(unsigned int tree = 0; tree < 2; ++tree){
+                    double seconds = run_bench_jobs(tree == 1, num_jobs, timeout_seconds);
+                    if(seconds < 0.0){
+                        printf("  %u threads %s %s: only %u of %u jobs done after %.0f s\n", threads, job_get_scheduler_name((JobScheduler)s), (tree == 1) ? "tree" : "flat",
+                            s_bench_jobs.num_done, num_jobs, timeout_seconds);
+                        result = 1;
+                        continue;
+                    }
+                    best[tree] = ((best[tree] == 0.0) || (seconds < best[tree])) ? seconds : best[tree];
+                }
+            }
+
+            job_system_stats_t stats;
+            job_system_get_stats(&stats);
+            double flat_rate = (best[0] > 0.0) ? ((double)num_jobs / best[0]) / 1000000.0 : 0.0;
+            double tree_rate = (best[1] > 0.0) ? ((double)((num_jobs * 2) - 1) / best[1]) / 1000000.0 : 0.0;
+            printf("  %-8u %-9s %12.2f %12.2f %10u %10u\n", threads, job_get_scheduler_name((JobScheduler)s), flat_rate, tree_rate, stats.num_steals, stats.num_sleeps);
+        }
+    }
+
+    job_system_shutdown();
+    job_system_init((int)max_threads, original_scheduler);
+    return result;
+}
+
+// Volume fill and mesh style loops for bench_parallel_for
+struct bench_parallel_t
+{
+    unsigned int        size;
+    std::vector<float>  voxels;
+
+    std::vector<Vector3> positions;
+    std::vector<Vector3> normals;
+    std::vector<Vector3> out_positions;
+    std::vector<Vector3> out_normals;
+};
+
+static void fill_bench_voxel(bench_parallel_t* bench, unsigned int x, unsigned int y, unsigned int z)
+{
+    size_t index = ((size_t)z * bench->size * bench->size) + ((size_t)y * bench->size) + x;
+    bench->voxels[index] = Compute3dPerlinNoise((float)x, (float)y, (float)z, 16.0f, 2);
+}
+
+static void fill_bench_slice(unsigned int z, void* user_data)
+{
+    bench_parallel_t* bench = (bench_parallel_t*)user_data;
+    for(unsigned int y = 0; y < bench->size; ++y){
+        for(unsigned int x = 0; x < bench->size; ++x){
+            fill_bench_voxel(bench, x, y, z);
+        }
+    }
+}
+
+static void fill_bench_range(const job_range_t& range, void* user_data)
+{
+    bench_parallel_t* bench = (bench_parallel_t*)user_data;
+    for(unsigned int z = range.begin[2]; z < range.end[2]; ++z){
+        for(unsigned int y = range.begin[1]; y < range.end[1]; ++y){
+            for(unsigned int x = range.begin[0]; x < range.end[0]; ++x){
+                fill_bench_voxel(bench, x, y, z);
+            }
+        }
+    }
+}
+
+// Skinning-ish: move, scale and renormalize every vertex
+static void process_bench_vertex(unsigned int vertex, void* user_data)
+{
+    bench_parallel_t* bench = (bench_parallel_t*)user_data;
+    const Vector3& position = bench->positions[vertex];
+    const Vector3& normal = bench->normals[vertex];
+    bench->out_positions[vertex] = Vector3((position.x * 0.75f) + (position.z * 0.25f), position.y * 1.5f, (position.z * 0.75f) - (position.x * 0.25f));
+
+    Vector3 bent(normal.x + (normal.z * 0.25f), normal.y * 0.5f, normal.z - (normal.x * 0.25f));
+    float length = bent.CalcLength();
+    bench->out_normals[vertex] = (length > 0.0f) ? (bent * (1.0f / length)) : Vector3(0.0f, 1.0f, 0.0f);
+}
+
+static void process_bench_vertex_range(const job_range_t& range, void* user_data)
+{
+    for(unsigned int vertex = range.begin[0]; vertex < range.end[0]; ++vertex){
+        process_bench_vertex(vertex, user_data);
+    }
+}
+
+TOOL_VERB(bench_parallel_for, "[-size N] [-vertices N] [-runs N]", "volume fill and mesh loops split as ranges against per item, fails if a split result differs")
+{
+    unsigned int size = (unsigned int)atoi(get_option(argc, argv, "-size", "128"));
+    unsigned int num_vertices = (unsigned int)atoi(get_option(argc, argv, "-vertices", "1000000"));
+    unsigned int num_runs = (unsigned int)atoi(get_option(argc, argv, "-runs", "3"));
+    if((size == 0) || (num_vertices == 0) || (num_runs == 0)){
+        printf("bench_parallel_for: invalid size, vertex count or run count\n");
+        return 1;
+    }
+
+    bench_parallel_t bench;
+    bench.size = size;
+    bench.voxels.resize((size_t)size * size * size);
+    bench.positions.resize(num_vertices);
+    bench.normals.resize(num_vertices);
+    bench.out_positions.resize(num_vertices);
+    bench.out_normals.resize(num_vertices);
+    unsigned int state = 0x3c6ef372;
+    for(unsigned int i = 0; i < num_vertices; ++i){
+        float values[6];
+        for(float& value : values){
+            state ^= state << 13;
+            state ^= state >> 17;
+            state ^= state << 5;
+            value = ((float)(state & 0xffff) / 32767.5f) - 1.0f;
+        }
+        bench.positions[i] = Vector3(values[0], values[1], values[2]) * 100.0f;
+        bench.normals[i] = Vector3(values[3], values[4], values[5]);
+    }
+
+    unsigned int max_workers = job_get_max_workers();
+    printf("bench_parallel_for %u^3 perlin volume, %u vertices, best of %u, %u workers\n", size, num_vertices, num_runs, max_workers);
+    printf("  %-26s %10s %9s %8s\n", "", "ms", "speedup", "pieces");
+
+    // Serial first, everything else has to match it exactly
+    enum { BENCH_VOLUME, BENCH_MESH };
+    int result = 0;
+    double serial_seconds[2] = { 0.0, 0.0 };
+    std::vector<float> serial_voxels;
+    std::vector<Vector3> serial_positions;
+    std::vector<Vector3> serial_normals;
+
+    struct bench_case_t
+    {
+        unsigned int    workload;
+        const char*     name;
+        unsigned int    grain;          // items per piece on every axis, 0 picks, UINT_MAX runs serial
+        bool            is_range;
+    };
+    const bench_case_t cases[] = {
+        { BENCH_VOLUME, "volume serial",            UINT_MAX, false },
+        { BENCH_VOLUME, "volume for, z slices",     0,        false },
+        { BENCH_VOLUME, "volume 3d, auto grain",    0,        true },
+        { BENCH_VOLUME, "volume 3d, 16^3 grain",    16,       true },
+        { BENCH_VOLUME, "volume 3d, 4^3 grain",     4,        true },
+        { BENCH_MESH,   "mesh serial",              UINT_MAX, false },
+        { BENCH_MESH,   "mesh for, vertex items",   0,        false },
+        { BENCH_MESH,   "mesh range, auto grain",   0,        true },
+        { BENCH_MESH,   "mesh range, 4096 grain",   4096,     true },
+        { BENCH_MESH,   "mesh range, 64 grain",     64,       true },
+    };
+
+    for(const bench_case_t& bench_case : cases){
+        bool is_volume = (bench_case.workload == BENCH_VOLUME);
+        bool is_serial = (bench_case.grain == UINT_MAX);
+        double best = 0.0;
+        unsigned int num_pieces = 0;
+        for(unsigned int run = 0; run < num_runs; ++run){
+            std::fill(bench.voxels.begin(), bench.voxels.end(), 0.0f);
+            std::fill(bench.out_normals.begin(), bench.out_normals.end(), Vector3(0.0f, 0.0f, 0.0f));
+
+            job_range_options_t options;
+            options.grain[0] = options.grain[1] = options.grain[2] = bench_case.grain;
+            options.profile_tag = bench_case.name;
+
+            double start = get_current_time_seconds();
+            if(is_serial){
+                if(is_volume){
+                    for(unsigned int z = 0; z < size; ++z){
+                        fill_bench_slice(z, &bench);
+                    }
+                }else{
+                    for(unsigned int vertex = 0; vertex < num_vertices; ++vertex){
+                        process_bench_vertex(vertex, &bench);
+                    }
+                }
+                num_pieces = 1;
+            }else if(!bench_case.is_range){
+                num_pieces = is_volume ? size : num_vertices;
+                if(is_volume){
+                    job_parallel_for(size, fill_bench_slice, &bench);
+                }else{
+                    job_parallel_for(num_vertices, process_bench_vertex, &bench);
+                }
+            }else if(is_volume){
+                num_pieces = job_parallel_for_3d(size, size, size, fill_bench_range, &bench, options);
+            }else{
+                num_pieces = job_parallel_for_range(num_vertices, process_bench_vertex_range, &bench, options);
+            }
+            double seconds = get_current_time_seconds() - start;
+            best = ((run == 0) || (seconds < best)) ? seconds : best;
+        }
+
+        bool matches = true;
+        if(is_serial){
+            serial_seconds[bench_case.workload] = best;
+            if(is_volume){
+                serial_voxels = bench.voxels;
+            }else{
+                serial_positions = bench.out_positions;
+                serial_normals = bench.out_normals;
+            }
+        }else if(is_volume){
+            matches = (bench.voxels == serial_voxels);
+        }else{
+            matches = (memcmp(bench.out_positions.data(), serial_positions.data(), num_vertices * sizeof(Vector3)) == 0) &&
+                (memcmp(bench.out_normals.data(), serial_normals.data(), num_vertices * sizeof(Vector3)) == 0);
+        }
+        result = matches ? result : 1;
+
+        printf("  %-26s %10.2f %8.2fx %8u%s\n", bench_case.name, best * 1000.0, serial_seconds[bench_case.workload] / best, num_pieces, matches ? "" : "  DOESN'T MATCH SERIAL");
+    }
+    return result;
+}
+
+// Fixed arithmetic for bench_fork_join jobs, so time lost to waiting doesn't count as work
+struct bench_fork_t
+{
+    unsigned int    num_iterations;
+    unsigned int    sink;
+};
+
+static void bench_fork_job(void* user_data)
+{
+    bench_fork_t* fork = (bench_fork_t*)user_data;
+    unsigned int state = 0x9e3779b9;
+    for(unsigned int i = 0; i < fork->num_iterations; ++i){
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+    }
+    atomic_add(&fork->sink, state);
+}
+
+enum BenchJoinMode
+{
+    BENCH_JOIN_SPIN,            // what job_wait used to do
+    BENCH_JOIN_WAIT,
+    BENCH_JOIN_COUNTER,
+    NUM_BENCH_JOIN_MODES
+};
+
+static const char* s_bench_join_names[NUM_BENCH_JOIN_MODES] = {
+    "spin on each job",
+    "job_wait each job",
+    "job_counter_wait",
+};
+
+TOOL_VERB(bench_fork_join, "[-jobs N] [-work us] [-iterations N]", "fork-join latency and CPU use per way of waiting")
+{
+    unsigned int num_jobs = (unsigned int)atoi(get_option(argc, argv, "-jobs", "64"));
+    float work_us = (float)atof(get_option(argc, argv, "-work", "50"));
+    unsigned int num_iterations = (unsigned int)atoi(get_option(argc, argv, "-iterations", "200"));
+    if((num_jobs == 0) || (work_us <= 0.0f) || (num_iterations == 0)){
+        printf("bench_fork_join: invalid job count, work or iteration count\n");
+        return 1;
+    }
+
+    // How many xorshift steps make <work_us> on this thread
+    bench_fork_t fork;
+    fork.num_iterations = 1000000;
+    fork.sink = 0;
+    double calibrate_start = get_current_time_seconds();
+    bench_fork_job(&fork);
+    double step_us = ((get_current_time_seconds() - calibrate_start) * 1000000.0) / (double)fork.num_iterations;
+    fork.num_iterations = Max(1u, (unsigned int)((double)work_us / step_us));
+
+    printf("bench_fork_join %u jobs of ~%.0f us, %u fork-joins, %u workers\n", num_jobs, work_us, num_iterations, job_get_max_workers());
+    printf("  %-18s %10s %10s %10s %10s %12s\n", "join", "mean ms", "p50 ms", "p99 ms", "cpu/wall", "caller ran");
+
+    std::vector<Job*> jobs(num_jobs);
+    for(unsigned int mode = 0; mode < NUM_BENCH_JOIN_MODES; ++mode){
+        std::vector<double> latencies(num_iterations);
+        job_system_stats_t stats_before;
+        job_system_get_stats(&stats_before);
+        double cpu_start = get_process_cpu_seconds();
+        double wall_start = get_current_time_seconds();
+
+        for(unsigned int iteration = 0; iteration < num_iterations; ++iteration){
+            double start = get_current_time_seconds();
+            if(mode == BENCH_JOIN_COUNTER){
+                job_counter_t counter;
+                for(unsigned int i = 0; i < num_jobs; ++i){
+                    job_run_with_counter(JOB_TYPE_GENERIC, bench_fork_job, &fork, &counter);
+                }
+                job_counter_wait(&counter);
+            }else{
+                for(unsigned int i = 0; i < num_jobs; ++i){
+                    jobs[i] = job_create(JOB_TYPE_GENERIC, bench_fork_job, &fork);
+                    job_dispatch(jobs[i]);
+                }
+                for(Job* job : jobs){
+                    if(mode == BENCH_JOIN_SPIN){
+                        while(!job_is_finished(job)){
+                            thread_yield();
+                        }
+                        job_release(job);
+                    }else{
+                        job_wait_and_release(job);
+                    }
+                }
+            }
+            latencies[iteration] = get_current_time_seconds() - start;
+        }
+
+        double wall_seconds = get_current_time_seconds() - wall_start;
+        double cpu_seconds = get_process_cpu_seconds() - cpu_start;
+
+        // Workers count what they run, the rest was the caller helping
+        job_system_stats_t stats_after;
+        job_system_get_stats(&stats_after);
+        unsigned int num_total = num_jobs * num_iterations;
+        unsigned int num_by_workers = Min(num_total, stats_after.num_jobs_run - stats_before.num_jobs_run);
+
+        cloud_bench_summary_t summary;
+        cloud_bench_get_summary(latencies, &summary);
+        printf("  %-18s %10.3f %10.3f %10.3f %10.2f %11.1f%%\n", s_bench_join_names[mode], summary.mean * 1000.0, summary.p50 * 1000.0, summary.p99 * 1000.0,
+            cpu_seconds / wall_seconds, 100.0 * (double)(num_total - num_by_workers) / (double)num_total);
+    }
+    return 0;
+}
+
+// Fiber ping-pong for bench_fibers, the fiber switches straight back every time
+struct bench_switch_t
+{
+    fiber_t*        thread_fiber;
+    fiber_t*        fiber;
+    unsigned int    num_switches;
+};
+
+static void bench_switch_fiber(void* user_data)
+{
+    bench_switch_t* bench = (bench_switch_t*)user_data;
+    for(;;){
+        ++bench->num_switches;
+        fiber_switch(bench->fiber, bench->thread_fiber);
+    }
+}
+
+// A tree of jobs that each fork <fanout> children and wait on them, the
+// leaves do the work. Every level blocks, which is what fibers are for.
+struct bench_deep_t
+{
+    bench_fork_t    fork;
+    unsigned int    fanout;
+    unsigned int    num_leaves_done;
+};
+
+static bench_deep_t s_bench_deep;
+
+static void bench_deep_job(void* user_data)
+{
+    unsigned int depth = (unsigned int)(uintptr_t)user_data;
+    if(depth == 0){
+        bench_fork_job(&s_bench_deep.fork);
+        atomic_incr(&s_bench_deep.num_leaves_done);
+        return;
+    }
+
+    job_counter_t counter;
+    for(unsigned int i = 0; i < s_bench_deep.fanout; ++i){
+        job_run_with_counter(JOB_TYPE_GENERIC, bench_deep_job, (void*)(uintptr_t)(depth - 1), &counter);
+    }
+    job_counter_wait(&counter);
+}
+
+TOOL_VERB(bench_fibers, "[-switches N] [-width N] [-depth N] [-fanout N] [-work us] [-runs N] [-fibers N]", "fiber switch cost and deep fork-join trees parked on fibers against helping, fails if leaves go missing")
+{
+    unsigned int num_switches = (unsigned int)atoi(get_option(argc, argv, "-switches", "1000000"));
+    unsigned int width = (unsigned int)atoi(get_option(argc, argv, "-width", "64"));
+    unsigned int depth = (unsigned int)atoi(get_option(argc, argv, "-depth", "4"));
+    unsigned int fanout = (unsigned int)atoi(get_option(argc, argv, "-fanout", "2"));
+    float work_us = (float)atof(get_option(argc, argv, "-work", "5"));
+    unsigned int num_runs = (unsigned int)atoi(get_option(argc, argv, "-runs", "3"));
+    unsigned int fibers_per_worker = (unsigned int)atoi(get_option(argc, argv, "-fibers", "32"));
+    if((num_switches == 0) || (width == 0) || (fanout == 0) || (work_us <= 0.0f) || (num_runs == 0) || (fibers_per_worker == 0)){
+        printf("bench_fibers: invalid switch count, width, fanout, work, run count or fiber count\n");
+        return 1;
+    }
+
+    // Raw switch cost, there and back counts as two
+    bench_switch_t bench;
+    bench.thread_fiber = fiber_convert_thread();
+    bench.fiber = fiber_create(bench_switch_fiber, &bench);
+    bench.num_switches = 0;
+    if(nullptr == bench.fiber){
+        printf("bench_fibers: couldn't create a fiber\n");
+        fiber_convert_back(bench.thread_fiber);
+        return 1;
+    }
+
+    double switch_start = get_current_time_seconds();
+    for(unsigned int i = 0; i < num_switches; ++i){
+        fiber_switch(bench.thread_fiber, bench.fiber);
+    }
+    double switch_seconds = get_current_time_seconds() - switch_start;
+    fiber_destroy(bench.fiber);
+    fiber_convert_back(bench.thread_fiber);
+    printf("bench_fibers %s, %.1f ns per switch\n", fiber_get_backend_name(), (switch_seconds * 1000000000.0) / (double)(num_switches * 2));
+
+    // Same calibration as bench_fork_join
+    s_bench_deep.fork.num_iterations = 1000000;
+    s_bench_deep.fork.sink = 0;
+    double calibrate_start = get_current_time_seconds();
+    bench_fork_job(&s_bench_deep.fork);
+    double step_us = ((get_current_time_seconds() - calibrate_start) * 1000000.0) / (double)s_bench_deep.fork.num_iterations;
+    s_bench_deep.fork.num_iterations = Max(1u, (unsigned int)((double)work_us / step_us));
+    s_bench_deep.fanout = fanout;
+
+    unsigned int num_leaves = width;
+    for(unsigned int i = 0; i < depth; ++i){
+        num_leaves *= fanout;
+    }
+
+    // Restarts the job system with and without fibers, then puts it back
+    unsigned int max_threads = job_get_max_workers();
+    JobScheduler original_scheduler = job_system_get_scheduler();
+    unsigned int original_fibers = job_system_get_fibers_per_worker();
+    printf("  %u trees %u deep, fanout %u, %u leaves of ~%.0f us, best of %u, %u workers\n", width, depth, fanout, num_leaves, work_us, num_runs, max_threads);
+    printf("  %-18s %10s %10s %10s %10s\n", "waits", "ms", "leaves/ms", "parks", "sleeps");
+
+    int result = 0;
+    unsigned int fiber_counts[2] = { 0, fibers_per_worker };
+    for(unsigned int f = 0; f < 2; ++f){
+        job_system_shutdown();
+        job_system_init((int)max_threads, JOB_SCHEDULER_WORK_STEALING, fiber_counts[f]);
+
+        double best = 0.0;
+        for(unsigned int run = 0; run < num_runs; ++run){
+            s_bench_deep.num_leaves_done = 0;
+            double start = get_current_time_seconds();
+            job_counter_t counter;
+            for(unsigned int i = 0; i < width; ++i){
+                job_run_with_counter(JOB_TYPE_GENERIC, bench_deep_job, (void*)(uintptr_t)depth, &counter);
+            }
+            job_counter_wait(&counter);
+            double seconds = get_current_time_seconds() - start;
+
+            if(atomic_load_acquire(&s_bench_deep.num_leaves_done) != num_leaves){
+                printf("  only %u of %u leaves ran with %u fibers per worker\n", s_bench_deep.num_leaves_done, num_leaves, fiber_counts[f]);
+                result = 1;
+            }
+            best = ((best == 0.0) || (seconds < best)) ? seconds : best;
+        }
+
+        job_system_stats_t stats;
+        job_system_get_stats(&stats);
+        char label[32];
+        if(fiber_counts[f] == 0){
+            snprintf(label, sizeof(label), "help on the stack");
+        }else{
+            snprintf(label, sizeof(label), "park, %u fibers", fiber_counts[f]);
+        }
+        printf("  %-18s %10.3f %10.1f %10u %10u\n", label, best * 1000.0, (double)num_leaves / (best * 1000.0), stats.num_parks, stats.num_sleeps);
+    }
+
+    job_system_shutdown();
+    job_system_init((int)max_threads, original_scheduler, original_fibers);
+    return result;
+}
+
+// A progressive bake for bench_priorities that keeps every worker busy, each
+// job runs its slices and dispatches the next until told to stop
+struct bench_bake_t
+{
+    bench_fork_t    slice;
+    unsigned int    num_slices;
+    bool            should_yield;
+    unsigned int    should_stop;
+    unsigned int    num_yielded_to;
+    job_counter_t   counter;
+};
+
+static bench_bake_t s_bench_bake;
+
+static void bench_bake_job(void*)
+{
+    for(unsigned int i = 0; i < s_bench_bake.num_slices; ++i){
+        bench_fork_job(&s_bench_bake.slice);
+        if(s_bench_bake.should_yield){
+            atomic_add(&s_bench_bake.num_yielded_to, job_yield());
+        }
+    }
+
+    // Takes this job's priority
+    if(atomic_load_acquire(&s_bench_bake.should_stop) == 0){
+        job_run_with_counter(JOB_TYPE_GENERIC, bench_bake_job, nullptr, &s_bench_bake.counter);
+    }
+}
+
+enum BenchBakeMode
+{
+    BENCH_BAKE_FRAME,           // no priorities, what the queues used to do
+    BENCH_BAKE_BACKGROUND,
+    BENCH_BAKE_YIELD,
+    NUM_BENCH_BAKE_MODES
+};
+
+static const char* s_bench_bake_names[NUM_BENCH_BAKE_MODES] = {
+    "bake as frame work",
+    "background bake",
+    "background + yield",
+};
+
+// Which job ran when, for check_deadline_promotion
+struct bench_order_t
+{
+    unsigned int    order[3];
+    unsigned int    num_run;
+};
+
+static bench_order_t s_bench_order;
+
+static void bench_order_job(void* user_data)
+{
+    s_bench_order.order[s_bench_order.num_run++] = (unsigned int)(uintptr_t)user_data;
+}
+
+// MAIN jobs the main thread runs itself, so the order is exact: a background
+// job past its deadline goes ahead of frame work, one still in time doesn't
+static bool check_deadline_promotion()
+{
+    double now = get_current_time_seconds();
+    Job* on_time = job_create(JOB_TYPE_MAIN, bench_order_job, (void*)(uintptr_t)0);
+    job_set_priority(on_time, JOB_PRIORITY_BACKGROUND);
+    job_set_deadline(on_time, now + 60.0);
+    Job* frame = job_create(JOB_TYPE_MAIN, bench_order_job, (void*)(uintptr_t)1);
+    job_set_priority(frame, JOB_PRIORITY_FRAME);
+    Job* late = job_create(JOB_TYPE_MAIN, bench_order_job, (void*)(uintptr_t)2);
+    job_set_priority(late, JOB_PRIORITY_BACKGROUND);
+    job_set_deadline(late, now - 1.0);
+
+    s_bench_order.num_run = 0;
+    job_dispatch_and_release(on_time, frame, late);
+    job_system_main_step();
+
+    const unsigned int expected[3] = { 2, 1, 0 };
+    return (s_bench_order.num_run == 3) && (memcmp(s_bench_order.order, expected, sizeof(expected)) == 0);
+}
+
+TOOL_VERB(bench_priorities, "[-frames N] [-jobs N] [-work us] [-budget ms] [-bake-ms ms]", "frame job latency and deadline misses under a running bake per priority setup, fails if deadlines go uncounted or unpromoted")
+{
+    unsigned int num_frames = (unsigned int)atoi(get_option(argc, argv, "-frames", "200"));
+    unsigned int num_jobs = (unsigned int)atoi(get_option(argc, argv, "-jobs", "8"));
+    float work_us = (float)atof(get_option(argc, argv, "-work", "50"));
+    float budget_ms = (float)atof(get_option(argc, argv, "-budget", "1"));
+    float bake_ms = (float)atof(get_option(argc, argv, "-bake-ms", "4"));
+    if((num_frames == 0) || (num_jobs == 0) || (work_us <= 0.0f) || (budget_ms <= 0.0f) || (bake_ms <= 0.0f)){
+        printf("bench_priorities: invalid frame count, job count, work, budget or bake time\n");
+        return 1;
+    }
+
+    // Frame jobs get <work_us> each, the bake runs in 50 us slices
+    bench_fork_t frame_work;
+    frame_work.num_iterations = 1000000;
+    frame_work.sink = 0;
+    double calibrate_start = get_current_time_seconds();
+    bench_fork_job(&frame_work);
+    double step_us = ((get_current_time_seconds() - calibrate_start) * 1000000.0) / (double)frame_work.num_iterations;
+    frame_work.num_iterations = Max(1u, (unsigned int)((double)work_us / step_us));
+
+    const float slice_us = 50.0f;
+    s_bench_bake.slice.num_iterations = Max(1u, (unsigned int)((double)slice_us / step_us));
+    s_bench_bake.slice.sink = 0;
+    s_bench_bake.num_slices = Max(1u, (unsigned int)((bake_ms * 1000.0f) / slice_us));
+
+    unsigned int num_workers = job_get_max_workers();
+    printf("bench_priorities %u frames of %u jobs of ~%.0f us, %.1f ms deadline, %u bake jobs of ~%.1f ms, %u workers\n",
+        num_frames, num_jobs, work_us, budget_ms, num_workers, bake_ms, num_workers);
+    printf("  %-20s %10s %10s %10s %10s %12s\n", "bake", "mean ms", "p50 ms", "p99 ms", "missed", "yielded to");
+
+    int result = 0;
+    if(!check_deadline_promotion()){
+        printf("  a background job past its deadline didn't go ahead of frame work\n");
+        result = 1;
+    }
+
+    for(unsigned int mode = 0; mode < NUM_BENCH_BAKE_MODES; ++mode){
+        JobPriority bake_priority = (mode == BENCH_BAKE_FRAME) ? JOB_PRIORITY_FRAME : JOB_PRIORITY_BACKGROUND;
+        s_bench_bake.should_yield = (mode == BENCH_BAKE_YIELD);
+        s_bench_bake.should_stop = 0;
+        s_bench_bake.num_yielded_to = 0;
+        for(unsigned int i = 0; i < num_workers; ++i){
+            Job* job = job_create(JOB_TYPE_GENERIC, bench_bake_job, nullptr);
+            job_set_priority(job, bake_priority);
+            job_dispatch_with_counter(job, &s_bench_bake.counter);
+            job_release(job);
+        }
+
+        job_system_stats_t stats_before;
+        job_system_get_stats(&stats_before);
+
+        std::vector<double> latencies(num_frames);
+        for(unsigned int frame = 0; frame < num_frames; ++frame){
+            double start = get_current_time_seconds();
+            job_counter_t counter;
+            for(unsigned int i = 0; i < num_jobs; ++i){
+                Job* job = job_create(JOB_TYPE_GENERIC, bench_fork_job, &frame_work);
+                job_set_deadline(job, start + ((double)budget_ms / 1000.0));
+                job_dispatch_with_counter(job, &counter);
+                job_release(job);
+            }
+            job_counter_wait(&counter);
+            latencies[frame] = get_current_time_seconds() - start;
+        }
+
+        atomic_store_release(&s_bench_bake.should_stop, 1u);
+        job_counter_wait(&s_bench_bake.counter);
+
+        // Every frame job had a deadline, so every one of them has to be counted
+        job_system_stats_t stats_after;
+        job_system_get_stats(&stats_after);
+        unsigned int num_deadlines = stats_after.deadlines[JOB_PRIORITY_FRAME].num_deadlines - stats_before.deadlines[JOB_PRIORITY_FRAME].num_deadlines;
+        unsigned int num_missed = stats_after.deadlines[JOB_PRIORITY_FRAME].num_missed - stats_before.deadlines[JOB_PRIORITY_FRAME].num_missed;
+        if(num_deadlines != num_frames * num_jobs){
+            printf("  %s: counted %u deadlines for %u frame jobs\n", s_bench_bake_names[mode], num_deadlines, num_frames * num_jobs);
+            result = 1;
+        }
+
+        cloud_bench_summary_t summary;
+        cloud_bench_get_summary(latencies, &summary);
+        printf("  %-20s %10.3f %10.3f %10.3f %9.1f%% %12u\n", s_bench_bake_names[mode], summary.mean * 1000.0, summary.p50 * 1000.0, summary.p99 * 1000.0,
+            100.0 * (double)num_missed / (double)num_deadlines, s_bench_bake.num_yielded_to);
+    }
+    return result;
+}
+
+// Waits inside waits for check_nested_waits, each case counts its jobs as they finish
+struct check_nested_t
+{
+    Job*            outer;          // what the critical job waits on
+    job_counter_t   done;
+    unsigned int    num_run;
+};
+
+static check_nested_t s_check_nested;
+
+static void check_nested_leaf_job(void*)
+{
+    atomic_incr(&s_check_nested.num_run);
+}
+
+// Critical, so a waiter that helps with any ready job takes it before the leaf
+static void check_nested_critical_job(void*)
+{
+    job_wait(s_check_nested.outer);
+    atomic_incr(&s_check_nested.num_run);
+}
+
+// Forks a leaf and waits on it with a critical job waiting on this one in the queue
+static void check_nested_outer_job(void*)
+{
+    job_counter_t children;
+    job_run_with_counter(JOB_TYPE_GENERIC, check_nested_leaf_job, nullptr, &children);
+
+    Job* critical = job_create(JOB_TYPE_GENERIC, check_nested_critical_job, nullptr);
+    job_set_priority(critical, JOB_PRIORITY_CRITICAL);
+    job_dispatch_with_counter(critical, &s_check_nested.done);
+    job_release(critical);
+
+    job_counter_wait(&children);
+    atomic_incr(&s_check_nested.num_run);
+}
+
+// Waits on a job that can't start until another one it depends on has run
+static void check_nested_chain_job(void*)
+{
+    Job* first = job_create(JOB_TYPE_GENERIC, check_nested_leaf_job, nullptr);
+    Job* second = job_create(JOB_TYPE_GENERIC, check_nested_leaf_job, nullptr);
+    second->depends_on(first);
+    job_dispatch(second);
+    job_dispatch_and_release(first);
+    job_wait_and_release(second);
+    atomic_incr(&s_check_nested.num_run);
+}
+
+static void check_nested_item(unsigned int, void*)
+{
+    atomic_incr(&s_check_nested.num_run);
+}
+
+static void check_nested_range(const job_range_t& range, void*)
+{
+    for(unsigned int i = range.begin[0]; i < range.end[0]; ++i){
+        job_parallel_for(4, check_nested_item, nullptr, 4);
+    }
+}
+
+// A parallel for in every piece of a range, both waits on counters
+static void check_nested_ranges_job(void*)
+{
+    job_range_options_t options;
+    options.max_workers = 4;
+    job_parallel_for_range(16, check_nested_range, nullptr, options);
+}
+
+// Parks on a MAIN job, which only runs once the main thread gets to it
+static void check_nested_parked_job(void*)
+{
+    job_counter_t main_jobs;
+    job_run_with_counter(JOB_TYPE_MAIN, check_nested_leaf_job, nullptr, &main_jobs);
+    job_counter_wait(&main_jobs);
+    atomic_incr(&s_check_nested.num_run);
+}
+
+static const unsigned int CHECK_NESTED_PARKED_MS = 200;
+
+struct check_nested_case_t
+{
+    const char*     name;
+    job_work_cb     work_cb;
+    bool            has_outer;      // the case's job is what the critical job waits on
+    bool            is_parked;      // fibers only, the worker should sleep while the main thread holds its job back
+    unsigned int    num_run;        // jobs and items that count themselves
+};
+
+static const check_nested_case_t s_check_nested_cases[] = {
+    { "job_wait in a counter wait", check_nested_outer_job,  true,  false, 3 },
+    { "dependency chain",           check_nested_chain_job,  false, false, 3 },
+    { "parallel for in ranges",     check_nested_ranges_job, false, false, 64 },
+    { "parked on the main thread",  check_nested_parked_job, false, true,  2 },
+};
+
+struct check_nested_setup_t
+{
+    JobScheduler    scheduler;
+    unsigned int    fibers_per_worker;
+};
+
+// One fiber is all parked as soon as its job waits
+static const check_nested_setup_t s_check_nested_setups[] = {
+    { JOB_SCHEDULER_WORK_STEALING, 0 },
+    { JOB_SCHEDULER_SHARED_QUEUE,  0 },
+    { JOB_SCHEDULER_WORK_STEALING, 1 },
+};
+
+// Every case on a single worker per scheduler and fiber setup
+TOOL_VERB(check_nested_waits, "[-timeout s]", "fails if a wait inside another job's wait hangs or loses jobs, or a worker spins on parked fibers")
+{
+    double timeout_seconds = atof(get_option(argc, argv, "-timeout", "10"));
+    if(timeout_seconds <= 0.0){
+        printf("check_nested_waits: invalid timeout\n");
+        return 1;
+    }
+
+    // One worker leaves nobody else to run what a waiter skips, so a wrong pick hangs
+    unsigned int max_threads = job_get_max_workers();
+    JobScheduler original_scheduler = job_system_get_scheduler();
+    unsigned int original_fibers = job_system_get_fibers_per_worker();
+    printf("check_nested_waits on 1 worker, %.0f s timeout\n", timeout_seconds);
+    printf("  %-9s %6s %s\n", "scheduler", "fibers", "case");
+
+    int result = 0;
+    for(const check_nested_setup_t& setup : s_check_nested_setups){
+        const char* scheduler_name = job_get_scheduler_name(setup.scheduler);
+        for(const check_nested_case_t& check_case : s_check_nested_cases){
+            if(check_case.is_parked && (setup.fibers_per_worker == 0)){
+                continue;
+            }
+
+            job_system_shutdown();
+            job_system_init(1, setup.scheduler, setup.fibers_per_worker);
+
+            s_check_nested.num_run = 0;
+            Job* job = job_create(JOB_TYPE_GENERIC, check_case.work_cb, nullptr);
+            s_check_nested.outer = check_case.has_outer ? job : nullptr;
+            job_dispatch_with_counter(job, &s_check_nested.done);
+
+            // The only worker has nothing to do but wait on the main thread, it should be asleep
+            double parked_cpu = 0.0;
+            if(check_case.is_parked){
+                double cpu_start = get_process_cpu_seconds();
+                double wall_start = get_current_time_seconds();
+                thread_sleep(CHECK_NESTED_PARKED_MS);
+                parked_cpu = (get_process_cpu_seconds() - cpu_start) / (get_current_time_seconds() - wall_start);
+            }
+
+            double start = get_current_time_seconds();
+            while(!job_counter_is_done(&s_check_nested.done)){
+                if((get_current_time_seconds() - start) > timeout_seconds){
+                    // The stuck worker would keep job_system_shutdown waiting forever
+                    printf("  %-9s %6u %-28s HUNG, %u of %u done\n", scheduler_name, setup.fibers_per_worker, check_case.name, atomic_load_acquire(&s_check_nested.num_run), check_case.num_run);
+                    fflush(stdout);
+                    _Exit(1);
+                }
+                job_system_main_step();
+                thread_yield();
+            }
+            job_release(job);
+
+            bool passed = (s_check_nested.num_run == check_case.num_run) && (parked_cpu < 0.5);
+            result = passed ? result : 1;
+            if(check_case.is_parked){
+                printf("  %-9s %6u %-28s %s, %.0f%% of a core while parked\n", scheduler_name, setup.fibers_per_worker, check_case.name, passed ? "ok" : "FAILED", parked_cpu * 100.0);
+            }else{
+                printf("  %-9s %6u %-28s %s\n", scheduler_name, setup.fibers_per_worker, check_case.name, passed ? "ok" : "FAILED");
+            }
+        }
+    }
+
+    job_system_shutdown();
+    job_system_init((int)max_threads, original_scheduler, original_fibers);
+    return result;
+}
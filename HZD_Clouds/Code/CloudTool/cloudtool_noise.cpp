@@ -0,0 +1,523 @@
+#include "CloudTool/cloudtool.h"
+
+#include "Game/cloud_noise_gen.h"
+
+#include "Engine/Core/FileUtils.hpp"
+#include "Engine/Core/Time.hpp"
+#include "Engine/Core/cpu.h"
+#include "Engine/Core/job.h"
+#include "Engine/Math/Noise.hpp"
+#include "Engine/Volume/volume_cache.h"
+#include "Engine/Volume/volume_file.h"
+
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+//-----------------------------------------------------
+// Noise verbs
+//
+// Baking the base and detail noise volumes, rebakes and progressive regens
+// of them, and getting them on and off disk.
+
+// One slider edit for bench_rebake, floats get scaled and ints get bumped
+struct rebake_edit_t
+{
+    CloudNoiseType  type;
+    const char*     name;
+    size_t          offset;
+    bool            is_int;
+};
+
+#define REBAKE_EDIT(type, field, is_int) { type, #field, offsetof(noise_gen_paramters_data_t, field), is_int }
+
+static const rebake_edit_t s_rebake_edits[] = {
+    REBAKE_EDIT(CLOUD_NOISE_BASE,   perlin_num_octaves,         true),
+    REBAKE_EDIT(CLOUD_NOISE_BASE,   worley_one_scale,           false),
+    REBAKE_EDIT(CLOUD_NOISE_BASE,   worley_two_scale,           false),
+    REBAKE_EDIT(CLOUD_NOISE_BASE,   worley_three_scale,         false),
+    REBAKE_EDIT(CLOUD_NOISE_BASE,   worley_only_num_octaves,    true),
+    REBAKE_EDIT(CLOUD_NOISE_BASE,   generation_z_scale,         false),
+    REBAKE_EDIT(CLOUD_NOISE_DETAIL, detail_worley_one_scale,    false),
+    REBAKE_EDIT(CLOUD_NOISE_DETAIL, detail_worley_two_scale,    false),
+    REBAKE_EDIT(CLOUD_NOISE_DETAIL, detail_worley_three_scale,  false),
+    REBAKE_EDIT(CLOUD_NOISE_DETAIL, detail_worley_num_octaves,  true),
+};
+
+TOOL_VERB(bake, "<base|detail> <out.dat|out.vol> [-size N] [-cache dir|none] [-mips kaiser|box|none]", "bakes a noise volume, raw RGBA8 or a volume file")
+{
+    const char* type_name = get_positional_arg(argc, argv, 0);
+    const char* out_path = get_positional_arg(argc, argv, 1);
+    if((nullptr == type_name) || (nullptr == out_path)){
+        printf("bake: missing arguments\n");
+        return 1;
+    }
+
+    CloudNoiseType type;
+    if(!cloud_noise_get_type_from_name(&type, type_name)){
+        printf("bake: unknown noise type \"%s\"\n", type_name);
+        return 1;
+    }
+
+    const char* default_size = (type == CLOUD_NOISE_BASE) ? "128" : "32";
+    unsigned int size = (unsigned int)atoi(get_option(argc, argv, "-size", default_size));
+    if(size == 0){
+        printf("bake: invalid size\n");
+        return 1;
+    }
+
+    noise_gen_paramters_data_t params;
+    cloud_noise_gen_set_defaults(&params);
+    cloud_noise_gen_load_from_config(&params);
+
+    // Same cache the game uses, "-cache none" always bakes
+    const char* cache_directory = get_option(argc, argv, "-cache", DEFAULT_NOISE_CACHE_DIRECTORY);
+    bool use_cache = (strcmp(cache_directory, "none") != 0);
+
+    volume_cache_t cache;
+    if(use_cache && !volume_cache_init(&cache, cache_directory, DEFAULT_NOISE_CACHE_MAX_BYTES)){
+        printf("bake: couldn't create cache directory \"%s\", not caching\n", cache_directory);
+        use_cache = false;
+    }
+
+    cloud_noise_volume_t noise_volume;
+    cloud_noise_volume_init(&noise_volume, type, size);
+
+    bool from_cache = use_cache && cloud_noise_volume_load_from_cache(&noise_volume, cache, params);
+
+    volume_fill_stats_t stats;
+    if(!from_cache){
+        cloud_noise_volume_update(&noise_volume, params, 0, &stats);
+        if(use_cache){
+            cloud_noise_volume_save_to_cache(noise_volume, cache);
+        }
+    }
+
+    // Volume files get a mip chain by default, raw files can't hold one
+    const char* mip_filter = get_option(argc, argv, "-mips", "kaiser");
+    bool saved = has_extension(out_path, VOLUME_FILE_EXTENSION)
+        ? save_volume_with_mips(out_path, VOLUME_FORMAT_RGBA8, noise_volume.volume.get_view(), mip_filter, nullptr)
+        : SaveBufferToBinaryFile(out_path, noise_volume.volume.data);
+
+    if(!saved){
+        printf("bake: failed to write \"%s\"\n", out_path);
+        return 1;
+    }
+
+    printf("baked %s noise %ux%ux%u -> %s\n", cloud_noise_get_type_name(type), size, size, size, out_path);
+    if(from_cache){
+        uint64_t key = cloud_noise_get_cache_key(type, params, size, size, size);
+        printf("  from cache %s\n", volume_cache_get_path(cache, key).c_str());
+    }else{
+        printf("  %.3f s, %.2f Mvoxels/sec (%u bricks, %u workers, %s)\n", stats.seconds, stats.voxels_per_second() / 1000000.0, stats.num_bricks, stats.num_workers, cpu_get_simd_level_name(cpu_get_simd_level()));
+    }
+    return 0;
+}
+
+TOOL_VERB(bench_bake, "<base|detail> [-size N] [-runs N]", "times the bake at 1..N workers")
+{
+    const char* type_name = get_positional_arg(argc, argv, 0);
+    CloudNoiseType type;
+    if((nullptr == type_name) || !cloud_noise_get_type_from_name(&type, type_name)){
+        printf("bench_bake: expected base or detail\n");
+        return 1;
+    }
+
+    unsigned int size = (unsigned int)atoi(get_option(argc, argv, "-size", "128"));
+    unsigned int num_runs = (unsigned int)atoi(get_option(argc, argv, "-runs", "3"));
+    if((size == 0) || (num_runs == 0)){
+        printf("bench_bake: invalid size or run count\n");
+        return 1;
+    }
+
+    noise_gen_paramters_data_t params;
+    cloud_noise_gen_set_defaults(&params);
+    cloud_noise_gen_load_from_config(&params);
+
+    unsigned int max_workers = job_get_max_workers();
+    printf("bench_bake %s %ux%ux%u, best of %u, 1..%u workers\n", cloud_noise_get_type_name(type), size, size, size, num_runs, max_workers);
+
+    volume_buffer_t volume;
+    double single_rate = 0.0;
+    for(unsigned int workers = 1; workers <= max_workers; ++workers){
+        volume_fill_stats_t best;
+        best.seconds = 0.0;
+        for(unsigned int run = 0; run < num_runs; ++run){
+            volume_fill_stats_t stats;
+            cloud_noise_bake(type, params, size, size, size, &volume, workers, &stats);
+            if((run == 0) || (stats.seconds < best.seconds)){
+                best = stats;
+            }
+        }
+
+        double rate = best.voxels_per_second();
+        if(workers == 1){
+            single_rate = rate;
+        }
+
+        double speedup = (single_rate > 0.0) ? rate / single_rate : 0.0;
+        printf("  %2u workers: %8.2f ms, %6.2f Mvoxels/sec, %.2fx (%.0f%% efficiency)\n", best.num_workers, best.seconds * 1000.0, rate / 1000000.0, speedup, (speedup / (double)best.num_workers) * 100.0);
+    }
+    return 0;
+}
+
+static void apply_rebake_edit(noise_gen_paramters_data_t* params, const rebake_edit_t& edit)
+{
+    unsigned char* field = (unsigned char*)params + edit.offset;
+    if(edit.is_int){
+        *(unsigned int*)field += 1;
+    }else{
+        *(float*)field *= 1.25f;
+    }
+}
+
+TOOL_VERB(bench_rebake, "<base|detail> [-size N]", "times single-channel rebakes against a full bake")
+{
+    const char* type_name = get_positional_arg(argc, argv, 0);
+    CloudNoiseType type;
+    if((nullptr == type_name) || !cloud_noise_get_type_from_name(&type, type_name)){
+        printf("bench_rebake: expected base or detail\n");
+        return 1;
+    }
+
+    unsigned int size = (unsigned int)atoi(get_option(argc, argv, "-size", "128"));
+    if(size == 0){
+        printf("bench_rebake: invalid size\n");
+        return 1;
+    }
+
+    noise_gen_paramters_data_t params;
+    cloud_noise_gen_set_defaults(&params);
+    cloud_noise_gen_load_from_config(&params);
+
+    cloud_noise_volume_t noise_volume;
+    cloud_noise_volume_init(&noise_volume, type, size);
+
+    volume_fill_stats_t full_stats;
+    cloud_noise_volume_update(&noise_volume, params, 0, &full_stats);
+    printf("bench_rebake %s %ux%ux%u, full bake %.2f ms\n", cloud_noise_get_type_name(type), size, size, size, full_stats.seconds * 1000.0);
+
+    int result = 0;
+    volume_buffer_t reference;
+    for(const rebake_edit_t& edit : s_rebake_edits){
+        if(edit.type != type){
+            continue;
+        }
+
+        apply_rebake_edit(&params, edit);
+
+        volume_fill_stats_t stats;
+        unsigned int channels = cloud_noise_volume_update(&noise_volume, params, 0, &stats);
+
+        // The patched volume has to match a from-scratch bake with the same params
+        cloud_noise_bake(type, params, size, size, size, &reference);
+        bool matches = (reference.data == noise_volume.volume.data);
+        result = matches ? result : 1;
+
+        printf("  %-28s channels %c%c%c%c  %8.2f ms  %5.1f%% of full  %s\n", edit.name,
+            (channels & CLOUD_NOISE_CHANNEL_R) ? 'R' : '-',
+            (channels & CLOUD_NOISE_CHANNEL_G) ? 'G' : '-',
+            (channels & CLOUD_NOISE_CHANNEL_B) ? 'B' : '-',
+            (channels & CLOUD_NOISE_CHANNEL_A) ? 'A' : '-',
+            stats.seconds * 1000.0, (stats.seconds / full_stats.seconds) * 100.0,
+            matches ? "matches full bake" : "MISMATCH");
+    }
+    return result;
+}
+
+TOOL_VERB(bench_regen, "<base|detail> [-size N] [-budget ms]", "steps a progressive regen frame by frame")
+{
+    const char* type_name = get_positional_arg(argc, argv, 0);
+    CloudNoiseType type;
+    if((nullptr == type_name) || !cloud_noise_get_type_from_name(&type, type_name)){
+        printf("bench_regen: expected base or detail\n");
+        return 1;
+    }
+
+    unsigned int size = (unsigned int)atoi(get_option(argc, argv, "-size", "128"));
+    float budget_ms = (float)atof(get_option(argc, argv, "-budget", "4"));
+    if((size == 0) || (budget_ms <= 0.0f)){
+        printf("bench_regen: invalid size or budget\n");
+        return 1;
+    }
+
+    noise_gen_paramters_data_t params;
+    cloud_noise_gen_set_defaults(&params);
+    cloud_noise_gen_load_from_config(&params);
+
+    cloud_noise_volume_t noise_volume;
+    cloud_noise_volume_init(&noise_volume, type, size);
+    cloud_noise_volume_begin_regen(&noise_volume, params);
+
+    // Step once per "frame" like App does and track how long each frame was blocked
+    double worst_step_ms = 0.0;
+    bool is_done = false;
+    while(!is_done){
+        double step_start = get_current_time_seconds();
+        is_done = cloud_noise_volume_step_regen(&noise_volume, budget_ms);
+        double step_ms = (get_current_time_seconds() - step_start) * 1000.0;
+        worst_step_ms = (step_ms > worst_step_ms) ? step_ms : worst_step_ms;
+    }
+
+    volume_buffer_t reference;
+    cloud_noise_bake(type, params, size, size, size, &reference);
+    bool matches = (reference.data == noise_volume.volume.data);
+
+    const volume_fill_task_t& task = noise_volume.regen_task;
+    printf("bench_regen %s %ux%ux%u at %.2f ms/frame\n", cloud_noise_get_type_name(type), size, size, size, budget_ms);
+    printf("  %u frames, %.2f ms average step, %.2f ms worst step, %s\n", task.num_steps, (task.step_seconds * 1000.0) / (double)task.num_steps, worst_step_ms, matches ? "matches full bake" : "MISMATCH");
+    return matches ? 0 : 1;
+}
+
+TOOL_VERB(convert, "<in.dat|in.texture> <out.vol> [-size N]", "wraps a headerless RGBA8 volume in a volume file")
+{
+    const char* in_path = get_positional_arg(argc, argv, 0);
+    const char* out_path = get_positional_arg(argc, argv, 1);
+    if((nullptr == in_path) || (nullptr == out_path)){
+        printf("convert: missing arguments\n");
+        return 1;
+    }
+
+    // Without -size the file has to be a whole RGBA8 cube
+    unsigned int size = (unsigned int)atoi(get_option(argc, argv, "-size", "0"));
+    if(!volume_file_convert_raw(in_path, out_path, VOLUME_FORMAT_RGBA8, size, size, size)){
+        printf("convert: \"%s\" isn't a %s RGBA8 volume\n", in_path, (size > 0) ? "matching" : "cube shaped");
+        return 1;
+    }
+
+    volume_file_t file;
+    if(!volume_file_open(&file, out_path, VOLUME_FILE_VERIFY_CHECKSUM)){
+        printf("convert: \"%s\" didn't read back\n", out_path);
+        return 1;
+    }
+
+    const volume_file_header_t& header = *file.header;
+    printf("converted %s -> %s, %ux%ux%u %s, %u mip(s), checksum %016llx\n", in_path, out_path, header.width, header.height, header.depth, volume_format_get_name(volume_file_get_format(file)), header.num_mips, (unsigned long long)header.checksum);
+    volume_file_close(&file);
+    return 0;
+}
+
+// Stands in for the upload, both load paths have to read every byte once
+static uint64_t touch_volume(const unsigned char* data, size_t size)
+{
+    return volume_file_checksum(data, size);
+}
+
+static void fill_bench_volume(volume_buffer_t* volume, unsigned int size)
+{
+    volume->resize(size, size, size, 4);
+
+    unsigned int state = 0x9e3779b9;
+    for(unsigned char& value : volume->data){
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        value = (unsigned char)state;
+    }
+}
+
+struct load_timing_t
+{
+    double          open_ms;
+    double          total_ms;
+
+    load_timing_t()
+        :open_ms(0.0)
+        ,total_ms(0.0)
+    {}
+};
+
+static void keep_best(load_timing_t* best, const load_timing_t& timing, unsigned int run)
+{
+    if((run == 0) || (timing.total_ms < best->total_ms)){
+        *best = timing;
+    }
+}
+
+TOOL_VERB(bench_load, "[-size N] [-runs N] [-dir path]", "times raw .dat reads against mapped .vol loads")
+{
+    const char* size_option = get_option(argc, argv, "-size", nullptr);
+    unsigned int num_runs = (unsigned int)atoi(get_option(argc, argv, "-runs", "5"));
+    std::string directory = get_option(argc, argv, "-dir", ".");
+    if(num_runs == 0){
+        printf("bench_load: invalid run count\n");
+        return 1;
+    }
+
+    std::vector<unsigned int> sizes;
+    if(nullptr != size_option){
+        sizes.push_back((unsigned int)atoi(size_option));
+    }else{
+        sizes.push_back(128);
+        sizes.push_back(256);
+    }
+
+    printf("bench_load RGBA8, best of %u, files already in the page cache\n", num_runs);
+
+    int result = 0;
+    for(unsigned int size : sizes){
+        if(size == 0){
+            printf("bench_load: invalid size\n");
+            return 1;
+        }
+
+        std::string raw_path = directory + "/bench_load.dat";
+        std::string file_path = directory + "/bench_load" + VOLUME_FILE_EXTENSION;
+
+        volume_buffer_t volume;
+        fill_bench_volume(&volume, size);
+        uint64_t expected = touch_volume(volume.data.data(), volume.data.size());
+
+        volume_view_t view = volume.get_view();
+        if(!SaveBufferToBinaryFile(raw_path, volume.data) || !volume_file_save(file_path.c_str(), VOLUME_FORMAT_RGBA8, &view, 1)){
+            printf("bench_load: couldn't write test files to \"%s\"\n", directory.c_str());
+            return 1;
+        }
+
+        // Warm both files so the runs compare the load paths, not the disk
+        std::vector<unsigned char> buffer;
+        LoadBinaryFileToBuffer(raw_path, buffer);
+
+        load_timing_t raw_best;
+        load_timing_t mapped_best;
+        load_timing_t verified_best;
+        bool matches = true;
+
+        for(unsigned int run = 0; run < num_runs; ++run){
+            // Old path, read the whole file into a heap copy then upload from that
+            load_timing_t timing;
+            double start = get_current_time_seconds();
+            buffer.clear();
+            buffer.shrink_to_fit();
+            LoadBinaryFileToBuffer(raw_path, buffer);
+            timing.open_ms = (get_current_time_seconds() - start) * 1000.0;
+            matches = matches && (touch_volume(buffer.data(), buffer.size()) == expected);
+            timing.total_ms = (get_current_time_seconds() - start) * 1000.0;
+            keep_best(&raw_best, timing, run);
+
+            // Mapped, the view is the file
+            volume_file_t file;
+            start = get_current_time_seconds();
+            bool opened = volume_file_open(&file, file_path.c_str());
+            timing.open_ms = (get_current_time_seconds() - start) * 1000.0;
+            if(opened){
+                volume_view_t view = volume_file_get_mip(file, 0);
+                matches = matches && (touch_volume(view.data, view.get_size()) == expected);
+                volume_file_close(&file);
+            }
+            timing.total_ms = (get_current_time_seconds() - start) * 1000.0;
+            matches = matches && opened;
+            keep_best(&mapped_best, timing, run);
+
+            // Mapped and checksummed first, so every byte gets read twice
+            start = get_current_time_seconds();
+            opened = volume_file_open(&file, file_path.c_str(), VOLUME_FILE_VERIFY_CHECKSUM);
+            timing.open_ms = (get_current_time_seconds() - start) * 1000.0;
+            if(opened){
+                volume_view_t view = volume_file_get_mip(file, 0);
+                matches = matches && (touch_volume(view.data, view.get_size()) == expected);
+                volume_file_close(&file);
+            }
+            timing.total_ms = (get_current_time_seconds() - start) * 1000.0;
+            matches = matches && opened;
+            keep_best(&verified_best, timing, run);
+        }
+
+        remove(raw_path.c_str());
+        remove(file_path.c_str());
+
+        double megabytes = (double)volume.data.size() / (1024.0 * 1024.0);
+        printf("  %u^3 (%.1f MB)\n", size, megabytes);
+        printf("    raw .dat read       open %8.3f ms  open+read %8.3f ms  %8.1f MB/s  %.1f MB copied\n", raw_best.open_ms, raw_best.total_ms, megabytes / (raw_best.total_ms / 1000.0), megabytes);
+        printf("    mapped .vol         open %8.3f ms  open+read %8.3f ms  %8.1f MB/s  0.0 MB copied\n", mapped_best.open_ms, mapped_best.total_ms, megabytes / (mapped_best.total_ms / 1000.0));
+        printf("    mapped .vol+verify  open %8.3f ms  open+read %8.3f ms  %8.1f MB/s  0.0 MB copied\n", verified_best.open_ms, verified_best.total_ms, megabytes / (verified_best.total_ms / 1000.0));
+        printf("    %.2fx faster mapped, %s\n", raw_best.total_ms / mapped_best.total_ms, matches ? "contents match" : "MISMATCH");
+        result = matches ? result : 1;
+    }
+    return result;
+}
+
+static void fill_check_positions(std::vector<float>* xs, std::vector<float>* ys, std::vector<float>* zs, unsigned int count)
+{
+    xs->resize(count);
+    ys->resize(count);
+    zs->resize(count);
+
+    // Negative and lattice aligned positions too, the floor and wrap paths are where the lanes go wrong
+    unsigned int state = 0x9e3779b9;
+    for(unsigned int i = 0; i < count; ++i){
+        float* axes[3] = { &(*xs)[i], &(*ys)[i], &(*zs)[i] };
+        for(float* axis : axes){
+            state ^= state << 13;
+            state ^= state >> 17;
+            state ^= state << 5;
+            float value = ((float)(state & 0xffff) / 65535.0f) * 256.0f - 128.0f;
+            *axis = ((i % 16) == 0) ? (float)(int)value : value;
+        }
+    }
+}
+
+TOOL_VERB(check_noise, "[-samples N]", "fails if batched noise leaves NOISE_BATCH_TOLERANCE at any simd level")
+{
+    unsigned int num_samples = (unsigned int)atoi(get_option(argc, argv, "-samples", "4099"));
+    if(num_samples == 0){
+        printf("check_noise: invalid sample count\n");
+        return 1;
+    }
+
+    // Odd count so every level runs its remainder lanes as well
+    std::vector<float> xs, ys, zs;
+    fill_check_positions(&xs, &ys, &zs, num_samples);
+
+    struct perlin_case_t { float scale; unsigned int num_octaves; int wrap; };
+    static const perlin_case_t perlin_cases[] = { { 8.0f, 1, 0 }, { 32.0f, 5, 0 }, { 16.0f, 4, 8 } };
+
+    struct worley_case_t { float scale; unsigned int num_octaves; WorleyFeature feature; int period; };
+    static const worley_case_t worley_cases[] = { { 0.1f, 1, WORLEY_F1, 0 }, { 0.05f, 3, WORLEY_F2, 0 }, { 0.125f, 3, WORLEY_F1, 4 }, { 0.125f, 2, WORLEY_F2_MINUS_F1, 8 } };
+
+    printf("check_noise %u samples, tolerance %g\n", num_samples, NOISE_BATCH_TOLERANCE);
+
+    int result = 0;
+    SimdLevel detected_level = cpu_get_simd_level();
+    std::vector<float> reference(num_samples);
+    std::vector<float> batch(num_samples);
+    for(unsigned int level = 0; level <= (unsigned int)detected_level; ++level){
+        cpu_set_max_simd_level((SimdLevel)level);
+        const char* level_name = cpu_get_simd_level_name((SimdLevel)level);
+
+        for(const perlin_case_t& perlin : perlin_cases){
+            for(unsigned int i = 0; i < num_samples; ++i){
+                reference[i] = (perlin.wrap > 0)
+                    ? Compute3dPerlinNoiseWrapped(xs[i], ys[i], zs[i], perlin.scale, perlin.num_octaves, 0.5f, 2.f, perlin.wrap, true, 0)
+                    : Compute3dPerlinNoise(xs[i], ys[i], zs[i], perlin.scale, perlin.num_octaves, 0.5f, 2.f, true, 0);
+            }
+            if(perlin.wrap > 0){
+                Compute3dPerlinNoiseWrappedBatch(xs.data(), ys.data(), zs.data(), batch.data(), num_samples, perlin.scale, perlin.num_octaves, 0.5f, 2.f, perlin.wrap, true, 0);
+            }else{
+                Compute3dPerlinNoiseBatch(xs.data(), ys.data(), zs.data(), batch.data(), num_samples, perlin.scale, perlin.num_octaves, 0.5f, 2.f, true, 0);
+            }
+
+            float max_difference = get_max_difference(reference, batch);
+            bool passed = (max_difference <= NOISE_BATCH_TOLERANCE);
+            result = passed ? result : 1;
+            printf("  perlin %-7s scale %5.1f, %u octaves, wrap %2d: max diff %g  %s\n", level_name, perlin.scale, perlin.num_octaves, perlin.wrap, max_difference, passed ? "ok" : "FAILED");
+        }
+
+        for(const worley_case_t& worley : worley_cases){
+            for(unsigned int i = 0; i < num_samples; ++i){
+                reference[i] = get_hashed_worley_noise_3d(Vector3(xs[i], ys[i], zs[i]), worley.scale, worley.num_octaves, 0.5f, 2.f, true, worley.feature, worley.period);
+            }
+            get_hashed_worley_noise_3d_batch(xs.data(), ys.data(), zs.data(), batch.data(), num_samples, worley.scale, worley.num_octaves, 0.5f, 2.f, true, worley.feature, worley.period);
+
+            float max_difference = get_max_difference(reference, batch);
+            bool passed = (max_difference <= NOISE_BATCH_TOLERANCE);
+            result = passed ? result : 1;
+            printf("  worley %-7s scale %5.3f, %u octaves, feature %d, period %d: max diff %g  %s\n", level_name, worley.scale, worley.num_octaves, (int)worley.feature, worley.period, max_difference, passed ? "ok" : "FAILED");
+        }
+    }
+    cpu_set_max_simd_level(detected_level);
+    return result;
+}
@@ -0,0 +1,1080 @@
+#include "CloudTool/cloudtool.h"
+
+#include "Game/cloud_bench.h"
+#include "Game/cloud_light.h"
+#include "Game/cloud_noise_gen.h"
+#include "Game/cloud_occupancy.h"
+#include "Game/cloud_raymarch.h"
+#include "Game/cloud_reproject.h"
+#include "Game/cloud_upsample.h"
+#include "Game/cloud_weather.h"
+
+#include "Engine/Core/Time.hpp"
+#include "Engine/Core/cpu.h"
+#include "Engine/Core/job.h"
+#include "Engine/Volume/volume_cache.h"
+#include "Engine/Volume/volume_layout.h"
+#include "Engine/Volume/volume_mips.h"
+#include "Engine/Volume/volume_sampler.h"
+
+#include <algorithm>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <utility>
+#include <vector>
+
+//-----------------------------------------------------
+// Render verbs
+//
+// CPU renders of the clouds and the raymarch features that speed them up:
+// occupancy, the light volume, reprojection, packets, upsampling and the
+// weather map.
+
+// Base and detail noise with their mip chains, the samplers point into these
+struct render_volumes_t
+{
+    volume_buffer_t                 base;
+    volume_buffer_t                 detail;
+    std::vector<volume_buffer_t>    base_mips;
+    std::vector<volume_buffer_t>    detail_mips;
+    cloud_weather_map_t             weather;
+    cloud_light_volume_t            light;
+    cloud_raymarch_volumes_t        samplers;
+};
+
+// Through the noise cache when it's there, box mips like GenerateMips gives the game
+static bool load_render_volume(CloudNoiseType type, unsigned int size, VolumeLayout layout, const noise_gen_paramters_data_t& params, volume_cache_t* cache, volume_buffer_t* out_top, std::vector<volume_buffer_t>* out_mips, volume_sampler_t* out_sampler)
+{
+    cloud_noise_volume_t noise_volume;
+    cloud_noise_volume_init(&noise_volume, type, size, layout);
+
+    if((nullptr == cache) || !cloud_noise_volume_load_from_cache(&noise_volume, *cache, params)){
+        cloud_noise_volume_update(&noise_volume, params);
+        if(nullptr != cache){
+            cloud_noise_volume_save_to_cache(noise_volume, *cache);
+        }
+    }
+    std::swap(*out_top, noise_volume.volume);
+
+    volume_mips_build(out_top->get_view(), VOLUME_FORMAT_RGBA8, VOLUME_MIP_FILTER_BOX, out_mips);
+
+    std::vector<volume_view_t> views;
+    volume_mips_get_views(out_top->get_view(), *out_mips, &views);
+    return volume_sampler_init(out_sampler, views.data(), (unsigned int)views.size(), VOLUME_FORMAT_RGBA8);
+}
+
+// Shared by the render verbs: -base N, -detail N, -cache dir|none and -layout linear|bricked
+static bool load_render_volumes(int argc, char** argv, render_volumes_t* out_volumes)
+{
+    unsigned int base_size = (unsigned int)atoi(get_option(argc, argv, "-base", "128"));
+    unsigned int detail_size = (unsigned int)atoi(get_option(argc, argv, "-detail", "32"));
+    if((base_size == 0) || (detail_size == 0)){
+        printf("invalid base or detail size\n");
+        return false;
+    }
+
+    VolumeLayout layout;
+    if(!get_layout_option(argc, argv, &layout)){
+        printf("invalid layout, expected linear or bricked\n");
+        return false;
+    }
+
+    noise_gen_paramters_data_t params;
+    cloud_noise_gen_set_defaults(&params);
+    cloud_noise_gen_load_from_config(&params);
+
+    const char* cache_directory = get_option(argc, argv, "-cache", DEFAULT_NOISE_CACHE_DIRECTORY);
+    volume_cache_t cache;
+    bool use_cache = (strcmp(cache_directory, "none") != 0) && volume_cache_init(&cache, cache_directory, DEFAULT_NOISE_CACHE_MAX_BYTES);
+
+    double start = get_current_time_seconds();
+    bool loaded = load_render_volume(CLOUD_NOISE_BASE, base_size, layout, params, use_cache ? &cache : nullptr, &out_volumes->base, &out_volumes->base_mips, &out_volumes->samplers.base)
+        && load_render_volume(CLOUD_NOISE_DETAIL, detail_size, layout, params, use_cache ? &cache : nullptr, &out_volumes->detail, &out_volumes->detail_mips, &out_volumes->samplers.detail);
+
+    printf("  noise: base %u^3, detail %u^3 %s with mips in %.2f s\n", base_size, detail_size, volume_layout_get_name(layout), get_current_time_seconds() - start);
+    return loaded;
+}
+
+// Shared by the render verbs: -weather texel_m [-weather-size N] bakes a
+// weather map around the camera for coverage, without it coverage is per sample
+static bool load_render_weather(int argc, char** argv, const cloud_raymarch_params_t& params, render_volumes_t* volumes)
+{
+    float texel_size = (float)atof(get_option(argc, argv, "-weather", "0"));
+    unsigned int size = (unsigned int)atoi(get_option(argc, argv, "-weather-size", "2048"));
+    if(!(texel_size > 0.0f)){
+        return (texel_size == 0.0f);
+    }
+    if(size == 0){
+        printf("invalid weather map size\n");
+        return false;
+    }
+
+    Vector3 eye_pos, unused_dir;
+    cloud_raymarch_get_ray(params, 0.5f, 0.5f, &eye_pos, &unused_dir);
+    cloud_weather_init(&volumes->weather, size, texel_size);
+    cloud_weather_update(&volumes->weather, params, eye_pos.x, eye_pos.z, 0.0f);
+    volumes->samplers.weather = &volumes->weather;
+
+    printf("  weather: %u^2 texels of %.0f m, baked in %.2f ms\n", size, texel_size, volumes->weather.bake_seconds * 1000.0);
+    return true;
+}
+
+// Shared by the render verbs: -light cell_m [-light-height m] [-light-radius m]
+// builds a light volume around the camera, without it every sample marches the light cone
+static bool load_render_light(int argc, char** argv, const cloud_raymarch_params_t& params, render_volumes_t* volumes)
+{
+    float cell_size = (float)atof(get_option(argc, argv, "-light", "0"));
+    float cell_height = (float)atof(get_option(argc, argv, "-light-height", "100"));
+    float radius = (float)atof(get_option(argc, argv, "-light-radius", "20000"));
+    if(!(cell_size > 0.0f)){
+        return (cell_size == 0.0f);
+    }
+    if(!(cell_height > 0.0f) || !(radius > 0.0f)){
+        printf("invalid light volume cell height or radius\n");
+        return false;
+    }
+
+    Vector3 eye_pos, unused_dir;
+    cloud_raymarch_get_ray(params, 0.5f, 0.5f, &eye_pos, &unused_dir);
+    cloud_light_init(&volumes->light, radius, cell_size, cell_height);
+    cloud_light_build(&volumes->light, params, volumes->samplers, eye_pos.x, eye_pos.z);
+    volumes->samplers.light = &volumes->light;
+
+    printf("  light: %ux%ux%u points of %.0f m x %.0f m, sampled in %.2f ms, gathered in %.2f ms\n", volumes->light.num_points_x, volumes->light.num_points_y, volumes->light.num_points_z,
+        cell_size, cell_height, volumes->light.sample_seconds * 1000.0, volumes->light.gather_seconds * 1000.0);
+    return true;
+}
+
+TOOL_VERB(render, "[out.png] [-width N] [-height N] [-runs N] [-base N] [-detail N] [-cache dir|none] [-occupancy cell_m] [-weather texel_m] [-light cell_m] [-layout linear|bricked]", "CPU reference render of hzd_clouds_new.frag")
+{
+    const char* out_path = get_positional_arg(argc, argv, 0);
+    unsigned int width = (unsigned int)atoi(get_option(argc, argv, "-width", "320"));
+    unsigned int height = (unsigned int)atoi(get_option(argc, argv, "-height", "180"));
+    unsigned int num_runs = (unsigned int)atoi(get_option(argc, argv, "-runs", "1"));
+    float occupancy_cell_size = (float)atof(get_option(argc, argv, "-occupancy", "0"));
+    if((width == 0) || (height == 0) || (num_runs == 0) || (occupancy_cell_size < 0.0f)){
+        printf("render: invalid size, run count or occupancy cell size\n");
+        return 1;
+    }
+
+    render_volumes_t volumes;
+    if(!load_render_volumes(argc, argv, &volumes)){
+        printf("render: couldn't set up the noise volumes\n");
+        return 1;
+    }
+
+    cloud_raymarch_params_t params;
+    cloud_raymarch_set_defaults(&params);
+    cloud_raymarch_load_from_config(&params);
+    if(!load_render_weather(argc, argv, params, &volumes)){
+        printf("render: couldn't bake the weather map\n");
+        return 1;
+    }
+    if(!load_render_light(argc, argv, params, &volumes)){
+        printf("render: couldn't build the light volume\n");
+        return 1;
+    }
+
+    printf("render %ux%u, %u steps per ray, best of %u\n", width, height, (unsigned int)(params.sliders[5] * 128.0f), num_runs);
+
+    // Out to the horizon from the camera, same reach as bench_occupancy's default
+    cloud_occupancy_t occupancy;
+    bool use_occupancy = (occupancy_cell_size > 0.0f);
+    if(use_occupancy){
+        Vector3 eye_pos, unused_dir;
+        cloud_raymarch_get_ray(params, 0.5f, 0.5f, &eye_pos, &unused_dir);
+        cloud_occupancy_init(&occupancy, eye_pos.x, eye_pos.z, 96000.0f, occupancy_cell_size, 10);
+        cloud_occupancy_build(&occupancy, params, volumes.samplers);
+        printf("  occupancy: %.0f m cells, built in %.2f ms\n", occupancy_cell_size, occupancy.build_seconds * 1000.0);
+    }
+
+    cloud_image_t image;
+    cloud_raymarch_stats_t best;
+    best.seconds = 0.0;
+    for(unsigned int run = 0; run < num_runs; ++run){
+        cloud_raymarch_stats_t stats;
+        cloud_raymarch_render(params, volumes.samplers, width, height, &image, 0, &stats, use_occupancy ? &occupancy : nullptr);
+        if((run == 0) || (stats.seconds < best.seconds)){
+            best = stats;
+        }
+    }
+
+    printf("  %.2f ms/frame, %u tiles, %u workers\n", best.seconds * 1000.0, best.num_tiles, best.num_workers);
+    printf("  %.1f%% of pixels hit the cloud layer, %.2f steps/pixel, %.2f density samples/pixel\n", (best.num_pixels > 0) ? 100.0 * best.num_rays / best.num_pixels : 0.0,
+        best.steps_per_pixel(), (best.num_pixels > 0) ? (double)best.num_density_samples / best.num_pixels : 0.0);
+    printf("  %.2f M density samples/sec\n", best.samples_per_second() / 1000000.0);
+
+    // The light volume only approximates the cone, so this reports how far off the frame is
+    if(nullptr != volumes.samplers.light){
+        cloud_raymarch_volumes_t cone_samplers = volumes.samplers;
+        cone_samplers.light = nullptr;
+
+        cloud_image_t cone_image;
+        cloud_raymarch_stats_t cone_stats;
+        cloud_raymarch_render(params, cone_samplers, width, height, &cone_image, 0, &cone_stats, use_occupancy ? &occupancy : nullptr);
+
+        float max_difference = 0.0f;
+        double total_difference = 0.0;
+        for(size_t i = 0; i < image.pixels.size(); ++i){
+            float difference = fabsf(image.pixels[i] - cone_image.pixels[i]);
+            max_difference = (difference > max_difference) ? difference : max_difference;
+            total_difference += difference;
+        }
+        printf("  %.1f%% of light cones looked up, %.2f ms/frame marching them (%.2fx), mean difference %.4f, max %.4f\n",
+            (best.num_steps > 0) ? 100.0 * best.num_light_lookups / best.num_steps : 0.0, cone_stats.seconds * 1000.0, (best.seconds > 0.0) ? cone_stats.seconds / best.seconds : 0.0,
+            image.pixels.empty() ? 0.0 : total_difference / image.pixels.size(), max_difference);
+    }
+
+    // Skipping has to land on the full march's frame exactly
+    int result = 0;
+    if(use_occupancy){
+        cloud_image_t reference;
+        cloud_raymarch_stats_t reference_stats;
+        cloud_raymarch_render(params, volumes.samplers, width, height, &reference, 0, &reference_stats);
+
+        bool matches = (memcmp(reference.pixels.data(), image.pixels.data(), image.pixels.size() * sizeof(float)) == 0);
+        result = matches ? 0 : 1;
+        printf("  %.2f skipped steps/pixel, %.2f ms/frame without, %s the full march\n", (best.num_pixels > 0) ? (double)best.num_skipped_steps / best.num_pixels : 0.0,
+            reference_stats.seconds * 1000.0, matches ? "matches" : "DOESN'T MATCH");
+    }
+
+    if(nullptr != out_path){
+        if(!cloud_image_save_png(image, out_path)){
+            printf("render: failed to write \"%s\"\n", out_path);
+            return 1;
+        }
+        printf("  -> %s\n", out_path);
+    }
+    return result;
+}
+
+TOOL_VERB(bench_occupancy, "[-rays N] [-cell m] [-layers N] [-radius m] [-pitch deg] [-base N] [-detail N] [-cache dir|none] [-weather texel_m]", "density evals per ray with and without empty space skipping")
+{
+    unsigned int num_rays_across = (unsigned int)atoi(get_option(argc, argv, "-rays", "64"));
+    float cell_size = (float)atof(get_option(argc, argv, "-cell", "1000"));
+    unsigned int num_layers = (unsigned int)atoi(get_option(argc, argv, "-layers", "10"));
+    float radius = (float)atof(get_option(argc, argv, "-radius", "96000"));
+    if((num_rays_across == 0) || !(cell_size > 0.0f) || (num_layers == 0) || !(radius > 0.0f)){
+        printf("bench_occupancy: invalid ray count, cell size, layer count or radius\n");
+        return 1;
+    }
+
+    render_volumes_t volumes;
+    if(!load_render_volumes(argc, argv, &volumes)){
+        printf("bench_occupancy: couldn't set up the noise volumes\n");
+        return 1;
+    }
+
+    cloud_raymarch_params_t params;
+    cloud_raymarch_set_defaults(&params);
+    cloud_raymarch_load_from_config(&params);
+    if(nullptr != get_option(argc, argv, "-pitch", nullptr)){
+        cloud_raymarch_set_camera(&params, Vector3(0.0f, 100.0f, 0.0f), 0.0f, (float)atof(get_option(argc, argv, "-pitch", "0")), 60.0f);
+    }
+    if(!load_render_weather(argc, argv, params, &volumes)){
+        printf("bench_occupancy: couldn't bake the weather map\n");
+        return 1;
+    }
+
+    Vector3 eye_pos, unused_dir;
+    cloud_raymarch_get_ray(params, 0.5f, 0.5f, &eye_pos, &unused_dir);
+
+    cloud_occupancy_t occupancy;
+    cloud_occupancy_init(&occupancy, eye_pos.x, eye_pos.z, radius, cell_size, num_layers);
+    cloud_occupancy_build(&occupancy, params, volumes.samplers);
+
+    const cloud_occupancy_level_t& finest = occupancy.levels[0];
+    size_t num_cells = finest.max_density.size();
+    printf("bench_occupancy: %ux%ux%u cells of %.0f m x %.0f m, %u levels, %u steps per ray\n", finest.num_cells_x, finest.num_cells_y, finest.num_cells_z, finest.cell_size, finest.cell_height,
+        occupancy.num_levels, (unsigned int)(params.sliders[5] * 128.0f));
+    printf("  build: %.2f ms on %u workers, %.1f%% of cells empty\n", occupancy.build_seconds * 1000.0, occupancy.num_workers, (num_cells > 0) ? 100.0 * occupancy.num_empty_cells / num_cells : 0.0);
+
+    // The grid of test rays, only the ones that cross the layer get marched
+    std::vector<std::pair<Vector3, Vector3>> segments;
+    for(unsigned int y = 0; y < num_rays_across; ++y){
+        for(unsigned int x = 0; x < num_rays_across; ++x){
+            Vector3 origin, dir, start, end;
+            cloud_raymarch_get_ray(params, (x + 0.5f) / num_rays_across, (y + 0.5f) / num_rays_across, &origin, &dir);
+            if(cloud_raymarch_get_cloud_layer(origin, dir, &start, &end)){
+                segments.push_back(std::make_pair(start, end));
+            }
+        }
+    }
+    if(segments.empty()){
+        printf("  no test rays cross the cloud layer\n");
+        return 1;
+    }
+
+    std::vector<cloud_density_ray_t> reference(segments.size());
+    double reference_start = get_current_time_seconds();
+    for(size_t i = 0; i < segments.size(); ++i){
+        cloud_occupancy_march(nullptr, params, volumes.samplers, segments[i].first, segments[i].second, &reference[i]);
+    }
+    double reference_seconds = get_current_time_seconds() - reference_start;
+
+    std::vector<cloud_density_ray_t> skipped(segments.size());
+    double skipped_start = get_current_time_seconds();
+    for(size_t i = 0; i < segments.size(); ++i){
+        cloud_occupancy_march(&occupancy, params, volumes.samplers, segments[i].first, segments[i].second, &skipped[i]);
+    }
+    double skipped_seconds = get_current_time_seconds() - skipped_start;
+
+    uint64_t num_reference_samples = 0;
+    uint64_t num_skipped_samples = 0;
+    uint64_t num_skipped_steps = 0;
+    unsigned int num_mismatches = 0;
+    for(size_t i = 0; i < segments.size(); ++i){
+        num_reference_samples += reference[i].num_density_samples;
+        num_skipped_samples += skipped[i].num_density_samples;
+        num_skipped_steps += skipped[i].num_skipped_steps;
+        num_mismatches += ((reference[i].transmittance != skipped[i].transmittance) || (reference[i].num_steps != skipped[i].num_steps)) ? 1 : 0;
+    }
+
+    // Every step of every reference ray against the finest bound, a cloudy step in an empty cell is a bad bound
+    unsigned int num_violations = 0;
+    unsigned int num_steps = (unsigned int)(params.sliders[5] * 128.0f);
+    for(size_t i = 0; i < segments.size(); ++i){
+        Vector3 ds = (segments[i].second - segments[i].first) / (float)num_steps;
+        Vector3 pos = segments[i].first;
+        for(unsigned int step = 0; step < reference[i].num_steps; ++step){
+            if((cloud_occupancy_get_max_density(occupancy, 0, pos) <= 0.0f) && (cloud_raymarch_sample_density(params, volumes.samplers, pos, params.knobs[1] * 10.0f, false) > 0.0f)){
+                ++num_violations;
+            }
+            pos = pos + ds;
+        }
+    }
+
+    double num_segments = (double)segments.size();
+    printf("  %zu of %u rays cross the layer\n", segments.size(), num_rays_across * num_rays_across);
+    printf("  every step: %7.2f density evals/ray, %8.2f ms\n", num_reference_samples / num_segments, reference_seconds * 1000.0);
+    printf("  skipping:   %7.2f density evals/ray, %8.2f ms, %.2f steps skipped/ray\n", num_skipped_samples / num_segments, skipped_seconds * 1000.0, num_skipped_steps / num_segments);
+    printf("  %.2fx fewer evals, %.2fx faster, transmittance %s, %u bound violations\n", (num_skipped_samples > 0) ? (double)num_reference_samples / num_skipped_samples : 0.0,
+        (skipped_seconds > 0.0) ? reference_seconds / skipped_seconds : 0.0, (num_mismatches == 0) ? "matches" : "MISMATCH", num_violations);
+    if(num_mismatches > 0){
+        printf("  %u rays differ\n", num_mismatches);
+    }
+
+    return ((num_mismatches == 0) && (num_violations == 0)) ? 0 : 1;
+}
+
+// Random points through the thickness of the layer, within <radius> of <center_x, center_z>
+static void fill_layer_points(float center_x, float center_z, float radius, unsigned int count, std::vector<Vector3>* out_points)
+{
+    out_points->resize(count);
+
+    unsigned int state = 0x2545f491;
+    float values[3];
+    for(unsigned int i = 0; i < count; ++i){
+        for(float& value : values){
+            state ^= state << 13;
+            state ^= state >> 17;
+            state ^= state << 5;
+            value = (float)(state & 0xffff) / 65535.0f;
+        }
+
+        double x = center_x + ((2.0 * values[0]) - 1.0) * radius;
+        double z = center_z + ((2.0 * values[1]) - 1.0) * radius;
+        double altitude = (double)CLOUD_PLANET_RADIUS + CLOUD_LAYER_INNER_HEIGHT + (values[2] * (CLOUD_LAYER_OUTER_HEIGHT - CLOUD_LAYER_INNER_HEIGHT));
+        double y = sqrt((altitude * altitude) - (x * x) - (z * z)) - (double)CLOUD_PLANET_RADIUS;
+        (*out_points)[i] = Vector3((float)x, (float)y, (float)z);
+    }
+}
+
+// Largest differences between two light volumes over the rows they share,
+// transmittance as optical depth, false unless their points line up. Rows sit
+// on multiples of the cell height, the lowest one depends on how far from the
+// planet's axis each was placed.
+static bool get_light_differences(const cloud_light_volume_t& a, const cloud_light_volume_t& b, float* out_max_density, float* out_max_depth)
+{
+    *out_max_density = 0.0f;
+    *out_max_depth = 0.0f;
+    if((a.num_points_x != b.num_points_x) || (a.num_points_z != b.num_points_z) || (a.origin_x != b.origin_x) || (a.origin_z != b.origin_z) || (a.cell_height != b.cell_height)){
+        return false;
+    }
+
+    int row_offset = (int)floorf(((b.min_y - a.min_y) / a.cell_height) + 0.5f);
+    for(unsigned int z = 0; z < a.num_points_z; ++z){
+        for(unsigned int y = 0; y < a.num_points_y; ++y){
+            int b_y = (int)y - row_offset;
+            if((b_y < 0) || (b_y >= (int)b.num_points_y)){
+                continue;
+            }
+            for(unsigned int x = 0; x < a.num_points_x; ++x){
+                size_t a_index = a.get_index(x, y, z);
+                size_t b_index = b.get_index(x, (unsigned int)b_y, z);
+                float density_difference = fabsf(a.density[a_index] - b.density[b_index]);
+                float depth_difference = fabsf(logf(a.transmittance[a_index]) - logf(b.transmittance[b_index]));
+                *out_max_density = (density_difference > *out_max_density) ? density_difference : *out_max_density;
+                *out_max_depth = (depth_difference > *out_max_depth) ? depth_difference : *out_max_depth;
+            }
+        }
+    }
+    return true;
+}
+
+// What an update did and how long it took, against a build from scratch.
+// With <expect_exact> the density has to match it to the bit, the optical
+// depth can be a hair off where the update kept a nearly equal sun direction.
+static bool report_light_update(const char* label, const cloud_light_volume_t& light, unsigned int flags, const cloud_raymarch_params_t& params, const cloud_raymarch_volumes_t& volumes,
+    float center_x, float center_z, bool expect_exact)
+{
+    double seconds = light.sample_seconds + light.gather_seconds;
+
+    cloud_light_volume_t reference;
+    cloud_light_init(&reference, 0.5f * (float)(light.num_points_x - 1) * light.cell_size, light.cell_size, light.cell_height);
+    cloud_light_build(&reference, params, volumes, center_x, center_z);
+    double build_seconds = reference.sample_seconds + reference.gather_seconds;
+
+    float max_density_difference, max_depth_difference;
+    bool is_same_lattice = get_light_differences(light, reference, &max_density_difference, &max_depth_difference);
+    bool matches = is_same_lattice && (!expect_exact || (max_density_difference == 0.0f));
+
+    const char* what = (flags & CLOUD_LIGHT_UPDATE_RESAMPLED) ? "resampled" : ((flags & CLOUD_LIGHT_UPDATE_SCROLLED) ? "scrolled" : "kept");
+    printf("  %-13s %-9s%-11s %8u density samples, %8.2f ms against %8.2f ms from scratch (%.1fx)\n", label, what, (flags & CLOUD_LIGHT_UPDATE_GATHERED) ? " + gathered" : "",
+        light.num_density_samples, seconds * 1000.0, build_seconds * 1000.0, (seconds > 0.0) ? build_seconds / seconds : 0.0);
+    printf("  %-13s max difference density %.5f, optical depth %.5f%s\n", "", max_density_difference, max_depth_difference, matches ? "" : ", DOESN'T MATCH");
+    return matches;
+}
+
+TOOL_VERB(bench_light, "[-cell m] [-height m] [-radius m] [-points N] [-sun deg] [-move m] [-wind m] [-base N] [-detail N] [-cache dir|none] [-weather texel_m]", "light volume lookups against the cone march, fails if an update drifts from a build")
+{
+    float cell_size = (float)atof(get_option(argc, argv, "-cell", "200"));
+    float cell_height = (float)atof(get_option(argc, argv, "-height", "100"));
+    float radius = (float)atof(get_option(argc, argv, "-radius", "20000"));
+    unsigned int num_points = (unsigned int)atoi(get_option(argc, argv, "-points", "200000"));
+    float sun_degrees = (float)atof(get_option(argc, argv, "-sun", "1"));
+    float move = (float)atof(get_option(argc, argv, "-move", "2000"));
+    float wind = (float)atof(get_option(argc, argv, "-wind", "200"));
+    if(!(cell_size > 0.0f) || !(cell_height > 0.0f) || !(radius > 0.0f) || (num_points == 0) || (wind < 0.0f)){
+        printf("bench_light: invalid cell size, cell height, radius, point count or wind\n");
+        return 1;
+    }
+
+    render_volumes_t volumes;
+    if(!load_render_volumes(argc, argv, &volumes)){
+        printf("bench_light: couldn't set up the noise volumes\n");
+        return 1;
+    }
+
+    // A breeze if the config has none, so the wind scroll below has something to do
+    cloud_raymarch_params_t params;
+    cloud_raymarch_set_defaults(&params);
+    cloud_raymarch_load_from_config(&params);
+    params.knobs[6] = (params.knobs[6] > 0.0f) ? params.knobs[6] : 0.01f;
+    if(!load_render_weather(argc, argv, params, &volumes)){
+        printf("bench_light: couldn't bake the weather map\n");
+        return 1;
+    }
+
+    Vector3 eye_pos, unused_dir;
+    cloud_raymarch_get_ray(params, 0.5f, 0.5f, &eye_pos, &unused_dir);
+
+    cloud_light_volume_t light;
+    cloud_light_init(&light, radius, cell_size, cell_height);
+    cloud_light_build(&light, params, volumes.samplers, eye_pos.x, eye_pos.z);
+
+    printf("bench_light: %ux%ux%u points of %.0f m x %.0f m, light step %.0f m\n", light.num_points_x, light.num_points_y, light.num_points_z, cell_size, cell_height, light.step_size);
+    printf("  build: sampled in %.2f ms, gathered in %.2f ms on %u workers\n", light.sample_seconds * 1000.0, light.gather_seconds * 1000.0, light.num_workers);
+
+    // The cone march against one lookup, over the middle of the lattice
+    std::vector<Vector3> points;
+    fill_layer_points(eye_pos.x, eye_pos.z, 0.8f * radius, num_points, &points);
+
+    std::vector<float> cone(num_points);
+    double cone_start = get_current_time_seconds();
+    for(unsigned int i = 0; i < num_points; ++i){
+        cone[i] = cloud_raymarch_get_light_transmittance(params, volumes.samplers, points[i]);
+    }
+    double cone_seconds = get_current_time_seconds() - cone_start;
+
+    std::vector<float> looked_up(num_points, -1.0f);
+    double lookup_start = get_current_time_seconds();
+    for(unsigned int i = 0; i < num_points; ++i){
+        cloud_light_get_transmittance(light, params, points[i], &looked_up[i]);
+    }
+    double lookup_seconds = get_current_time_seconds() - lookup_start;
+
+    // Negative densities push the shader's transmittance past 1, so the error
+    // is measured on the optical depth, -ln of it, and on the shadowed points
+    unsigned int num_missed = 0;
+    unsigned int num_shadowed = 0;
+    float max_depth_difference = 0.0f;
+    double total_depth_difference = 0.0;
+    double total_shadowed_difference = 0.0;
+    for(unsigned int i = 0; i < num_points; ++i){
+        if(looked_up[i] < 0.0f){
+            ++num_missed;
+            continue;
+        }
+        float depth_difference = fabsf(logf(looked_up[i] > 1e-30f ? looked_up[i] : 1e-30f) - logf(cone[i] > 1e-30f ? cone[i] : 1e-30f));
+        max_depth_difference = (depth_difference > max_depth_difference) ? depth_difference : max_depth_difference;
+        total_depth_difference += depth_difference;
+        if(cone[i] < 1.0f){
+            ++num_shadowed;
+            total_shadowed_difference += fabsf(looked_up[i] - cone[i]);
+        }
+    }
+    unsigned int num_compared = num_points - num_missed;
+
+    printf("  %u points: cone march %.2f M/sec, lookup %.2f M/sec (%.1fx)\n", num_points, (cone_seconds > 0.0) ? num_points / cone_seconds / 1000000.0 : 0.0,
+        (lookup_seconds > 0.0) ? num_points / lookup_seconds / 1000000.0 : 0.0, (lookup_seconds > 0.0) ? cone_seconds / lookup_seconds : 0.0);
+    printf("  against the cone: optical depth mean difference %.4f, max %.4f; transmittance mean difference %.4f over the %u shadowed points; %u points off the lattice\n",
+        (num_compared > 0) ? total_depth_difference / num_compared : 0.0, max_depth_difference, (num_shadowed > 0) ? total_shadowed_difference / num_shadowed : 0.0, num_shadowed, num_missed);
+
+    // Incremental updates, each against a build from scratch. Only the wind
+    // drifts the noise up, the others have to sample the same density to the bit.
+    bool matches = (num_missed == 0);
+
+    float angle = sun_degrees * (3.14159265f / 180.0f);
+    Vector3 sun = params.cloud.sun_position;
+    params.cloud.sun_position = Vector3((sun.x * cosf(angle)) - (sun.z * sinf(angle)), sun.y, (sun.x * sinf(angle)) + (sun.z * cosf(angle)));
+    unsigned int flags = cloud_light_update(&light, params, volumes.samplers, eye_pos.x, eye_pos.z);
+    matches &= report_light_update("sun moved:", light, flags, params, volumes.samplers, eye_pos.x, eye_pos.z, true);
+
+    float center_x = eye_pos.x + move;
+    float center_z = eye_pos.z - (0.5f * move);
+    flags = cloud_light_update(&light, params, volumes.samplers, center_x, center_z);
+    matches &= report_light_update("camera moved:", light, flags, params, volumes.samplers, center_x, center_z, true);
+
+    params.game_time += wind / (params.knobs[6] * 1000.0f);
+    flags = cloud_light_update(&light, params, volumes.samplers, center_x, center_z);
+    matches &= report_light_update("wind blew:", light, flags, params, volumes.samplers, center_x, center_z, false);
+
+    return matches ? 0 : 1;
+}
+
+// A smooth pattern painted on the cloud layer, so every pixel has a right
+// answer that only depends on the camera and costs nothing to shade
+static void shade_synthetic(float u, float v, void* user_data, float* out_rgba)
+{
+    const cloud_raymarch_params_t& params = *(const cloud_raymarch_params_t*)user_data;
+
+    Vector3 eye_pos, ray_dir, layer_start, layer_end;
+    cloud_raymarch_get_ray(params, u, v, &eye_pos, &ray_dir);
+    if(!cloud_raymarch_get_cloud_layer(eye_pos, ray_dir, &layer_start, &layer_end)){
+        out_rgba[0] = out_rgba[1] = out_rgba[2] = out_rgba[3] = 0.0f;
+        return;
+    }
+
+    float opacity = 0.5f + (0.5f * sinf(layer_start.x / 1700.0f) * cosf(layer_start.z / 2300.0f));
+    out_rgba[0] = opacity * 0.9f;
+    out_rgba[1] = opacity * (0.5f + (0.5f * sinf(layer_start.z / 900.0f)));
+    out_rgba[2] = opacity * 0.7f;
+    out_rgba[3] = opacity;
+}
+
+static float get_mean_difference(const cloud_image_t& a, const cloud_image_t& b)
+{
+    double total = 0.0;
+    for(size_t i = 0; i < a.pixels.size(); ++i){
+        total += fabsf(a.pixels[i] - b.pixels[i]);
+    }
+    return a.pixels.empty() ? 0.0f : (float)(total / a.pixels.size());
+}
+
+// What the difference looks like on screen, values clamped like cloud_image_save_png does
+static float get_display_difference(const cloud_image_t& a, const cloud_image_t& b)
+{
+    double total = 0.0;
+    for(size_t i = 0; i < a.pixels.size(); ++i){
+        total += fabsf(cloud_saturate(a.pixels[i]) - cloud_saturate(b.pixels[i]));
+    }
+    return a.pixels.empty() ? 0.0f : (float)(total / a.pixels.size());
+}
+
+TOOL_VERB(bench_reproject, "[-source clouds|synthetic] [-width N] [-height N] [-frames N] [-hold N] [-move m] [-yaw deg] [-base N] [-detail N] [-cache dir|none]", "marched pixels per frame along a camera path, fails if a still camera doesn't converge")
+{
+    const char* source = get_option(argc, argv, "-source", "clouds");
+    unsigned int width = (unsigned int)atoi(get_option(argc, argv, "-width", "320"));
+    unsigned int height = (unsigned int)atoi(get_option(argc, argv, "-height", "180"));
+    unsigned int num_frames = (unsigned int)atoi(get_option(argc, argv, "-frames", "32"));
+    unsigned int num_hold_frames = (unsigned int)atoi(get_option(argc, argv, "-hold", "16"));
+    float move = (float)atof(get_option(argc, argv, "-move", "50"));
+    float yaw_step = (float)atof(get_option(argc, argv, "-yaw", "0.2"));
+    bool is_synthetic = (strcmp(source, "synthetic") == 0);
+    if((!is_synthetic && (strcmp(source, "clouds") != 0)) || (width < 2) || (height < 2) || (num_frames == 0)){
+        printf("bench_reproject: invalid source, size or frame count\n");
+        return 1;
+    }
+
+    render_volumes_t volumes;
+    if(!is_synthetic && !load_render_volumes(argc, argv, &volumes)){
+        printf("bench_reproject: couldn't set up the noise volumes\n");
+        return 1;
+    }
+
+    cloud_raymarch_params_t params;
+    cloud_raymarch_set_defaults(&params);
+    cloud_raymarch_load_from_config(&params);
+
+    printf("bench_reproject: %s %ux%u, %u frames moving %.0f m and turning %.2f deg each, then %u still\n", source, width, height, num_frames, move, yaw_step, num_hold_frames);
+
+    // The scripted path: flies along x while turning, then holds the last pose
+    Vector3 start_pos(0.0f, 100.0f, 0.0f);
+    float pitch = -20.0f;
+    cloud_reproject_t reproject;
+    cloud_image_t image;
+    cloud_image_t reference;
+    double total_seconds = 0.0;
+    double total_reference_seconds = 0.0;
+    double total_marched = 0.0;
+    float last_difference = 0.0f;
+    for(unsigned int frame = 0; frame < num_frames + num_hold_frames; ++frame){
+        float t = (float)((frame < num_frames) ? frame : num_frames - 1);
+        cloud_raymarch_set_camera(&params, start_pos + Vector3(move * t, 0.0f, -0.25f * move * t), yaw_step * t, pitch, 60.0f);
+
+        cloud_reproject_stats_t stats;
+        cloud_reproject_t full;
+        cloud_reproject_stats_t reference_stats;
+        if(is_synthetic){
+            cloud_reproject_frame(&reproject, params, shade_synthetic, &params, width, height, &image, 0, &stats);
+            cloud_reproject_frame(&full, params, shade_synthetic, &params, width, height, &reference, 0, &reference_stats);
+        }else{
+            cloud_reproject_render(&reproject, params, volumes.samplers, width, height, &image, 0, &stats);
+            cloud_reproject_render(&full, params, volumes.samplers, width, height, &reference, 0, &reference_stats);
+        }
+
+        total_seconds += stats.seconds;
+        total_reference_seconds += reference_stats.seconds;
+        total_marched += stats.marched_fraction();
+        last_difference = get_mean_difference(image, reference);
+        printf("  frame %3u%s: %5.1f%% marched (%5.1f%% scheduled, %5.1f%% fallback), %5.1f%% reprojected, %5.1f%% sky, %8.2f ms, mean difference %.5f\n", frame,
+            (frame < num_frames) ? "      " : " still",
+            100.0 * stats.marched_fraction(), 100.0 * stats.num_scheduled / stats.num_pixels, 100.0 * stats.num_fallbacks / stats.num_pixels,
+            100.0 * stats.num_reprojected / stats.num_pixels, 100.0 * stats.num_missed / stats.num_pixels, stats.seconds * 1000.0, last_difference);
+    }
+
+    unsigned int num_total_frames = num_frames + num_hold_frames;
+    printf("  %.1f%% marched per frame on average, %.2f ms/frame against %.2f ms marching everything (%.1fx)\n", 100.0 * total_marched / num_total_frames,
+        total_seconds * 1000.0 / num_total_frames, total_reference_seconds * 1000.0 / num_total_frames, (total_seconds > 0.0) ? total_reference_seconds / total_seconds : 0.0);
+
+    // A full Bayer cycle of a still camera marches every pixel once, from
+    // there the history is the full frame give or take bilinear rounding
+    if(num_hold_frames >= CLOUD_REPROJECT_BLOCK_PIXELS){
+        bool is_converged = (last_difference <= 0.001f);
+        printf("  after %u still frames the image %s the full march\n", num_hold_frames, is_converged ? "matches" : "DOESN'T MATCH");
+        return is_converged ? 0 : 1;
+    }
+    return 0;
+}
+
+// Packets only part from the scalar march by the batched coverage noise,
+// which stays within NOISE_BATCH_TOLERANCE before the march compounds it
+static const float PACKET_MAX_DIFFERENCE = 0.001f;
+
+TOOL_VERB(bench_packet, "[-width N] [-height N] [-runs N] [-steps slider|adaptive] [-base N] [-detail N] [-cache dir|none] [-weather texel_m] [-light cell_m]", "scalar and packet march rays/sec per simd level, fails if packets drift from scalar")
+{
+    unsigned int width = (unsigned int)atoi(get_option(argc, argv, "-width", "1920"));
+    unsigned int height = (unsigned int)atoi(get_option(argc, argv, "-height", "1080"));
+    unsigned int num_runs = (unsigned int)atoi(get_option(argc, argv, "-runs", "1"));
+    const char* steps = get_option(argc, argv, "-steps", "slider");
+    if((width == 0) || (height == 0) || (num_runs == 0)){
+        printf("bench_packet: invalid size or run count\n");
+        return 1;
+    }
+    if((strcmp(steps, "slider") != 0) && (strcmp(steps, "adaptive") != 0)){
+        printf("bench_packet: invalid step count, expected slider or adaptive\n");
+        return 1;
+    }
+
+    render_volumes_t volumes;
+    if(!load_render_volumes(argc, argv, &volumes)){
+        printf("bench_packet: couldn't set up the noise volumes\n");
+        return 1;
+    }
+
+    cloud_raymarch_params_t params;
+    cloud_raymarch_set_defaults(&params);
+    cloud_raymarch_load_from_config(&params);
+    params.adaptive_steps = (strcmp(steps, "adaptive") == 0);
+    if(!load_render_weather(argc, argv, params, &volumes)){
+        printf("bench_packet: couldn't bake the weather map\n");
+        return 1;
+    }
+    if(!load_render_light(argc, argv, params, &volumes)){
+        printf("bench_packet: couldn't build the light volume\n");
+        return 1;
+    }
+
+    SimdLevel detected_level = cpu_get_simd_level();
+    printf("bench_packet %ux%u, %s steps, best of %u\n", width, height, params.adaptive_steps ? "adaptive" : "slider", num_runs);
+
+    // The scalar march is the reference, then packets at every level that has them
+    int result = 0;
+    cloud_image_t reference;
+    double scalar_seconds = 0.0;
+    for(unsigned int level = 0; level <= (unsigned int)detected_level; ++level){
+        cpu_set_max_simd_level((SimdLevel)level);
+
+        cloud_image_t image;
+        cloud_raymarch_stats_t best;
+        best.seconds = 0.0;
+        for(unsigned int run = 0; run < num_runs; ++run){
+            cloud_raymarch_stats_t stats;
+            if(level == 0){
+                cloud_raymarch_render(params, volumes.samplers, width, height, &image, 0, &stats);
+            }else{
+                cloud_raymarch_render_packets(params, volumes.samplers, width, height, &image, 0, &stats);
+            }
+            if((run == 0) || (stats.seconds < best.seconds)){
+                best = stats;
+            }
+        }
+
+        const char* verdict = "reference";
+        float max_difference = 0.0f;
+        if(level == 0){
+            reference = image;
+            scalar_seconds = best.seconds;
+        }else{
+            max_difference = get_max_difference(reference.pixels, image.pixels);
+            bool matches = (max_difference <= PACKET_MAX_DIFFERENCE);
+            result = matches ? result : 1;
+            verdict = matches ? "matches scalar" : "DOESN'T MATCH";
+        }
+
+        printf("  %-7s %-7s %8.2f ms/frame, %6.3f M rays/sec, %7.2f steps/ray, %5.2fx  %s\n", (level == 0) ? "scalar" : "packets", cpu_get_simd_level_name((SimdLevel)level), best.seconds * 1000.0,
+            (best.seconds > 0.0) ? best.num_rays / best.seconds / 1000000.0 : 0.0, (best.num_rays > 0) ? (double)best.num_steps / best.num_rays : 0.0,
+            (best.seconds > 0.0) ? scalar_seconds / best.seconds : 0.0, verdict);
+        if(level > 0){
+            printf("                  max difference %.6f, mean %.8f\n", max_difference, get_mean_difference(reference, image));
+        }
+    }
+    cpu_set_max_simd_level(detected_level);
+
+    return result;
+}
+
+// What App hands the device each frame, kept in memory so bench_path pays
+// for the copies without one
+struct null_output_t
+{
+    cloud_parameters_data_t     cloud_buffer;
+    float                       midi_buffer[CLOUD_MIDI_NUM_CONTROLS * 2];
+    std::vector<unsigned char>  weather_texture;
+};
+
+TOOL_VERB(bench_path, "<file.path> [-frames N] [-out file.json] [-weather texel_m] [-weather-size N] [-budget ms] [-width N -height N] [-scale 1|2|4] [-base N] [-detail N] [-cache dir|none]", "scripted camera path at a fixed step, per frame CPU timings and percentiles")
+{
+    const char* path_file = get_positional_arg(argc, argv, 0);
+    const char* out_file = get_option(argc, argv, "-out", nullptr);
+    float texel_size = (float)atof(get_option(argc, argv, "-weather", "100"));
+    unsigned int weather_size = (unsigned int)atoi(get_option(argc, argv, "-weather-size", "2048"));
+    float budget_ms = (float)atof(get_option(argc, argv, "-budget", "1"));
+    unsigned int render_width = (unsigned int)atoi(get_option(argc, argv, "-width", "0"));
+    unsigned int render_height = (unsigned int)atoi(get_option(argc, argv, "-height", "0"));
+    const char* num_frames = get_option(argc, argv, "-frames", nullptr);
+    const char* scale = get_option(argc, argv, "-scale", nullptr);
+    if(nullptr == path_file){
+        printf("bench_path: missing path file\n");
+        return 1;
+    }
+    if((texel_size < 0.0f) || ((texel_size > 0.0f) && (weather_size == 0)) || (budget_ms < 0.0f)){
+        printf("bench_path: invalid weather map texel size, size or budget\n");
+        return 1;
+    }
+    if((render_width == 0) != (render_height == 0)){
+        printf("bench_path: invalid render size, needs both -width and -height\n");
+        return 1;
+    }
+
+    cloud_upsample_t upsample;
+    cloud_upsample_load_from_config(&upsample);
+    upsample.scale = (nullptr != scale) ? (unsigned int)atoi(scale) : upsample.scale;
+    if(!cloud_upsample_is_valid_scale(upsample.scale)){
+        printf("bench_path: invalid scale, needs 1, 2 or 4\n");
+        return 1;
+    }
+
+    cloud_bench_path_t path;
+    if(!cloud_bench_load_path(&path, path_file)){
+        printf("bench_path: couldn't load \"%s\"\n", path_file);
+        return 1;
+    }
+    path.num_frames = (nullptr != num_frames) ? (unsigned int)atoi(num_frames) : path.num_frames;
+    if(path.num_frames == 0){
+        printf("bench_path: invalid frame count\n");
+        return 1;
+    }
+
+    bool do_render = (render_width > 0);
+    render_volumes_t volumes;
+    if(do_render && !load_render_volumes(argc, argv, &volumes)){
+        printf("bench_path: couldn't set up the noise volumes\n");
+        return 1;
+    }
+
+    bool use_weather = (texel_size > 0.0f);
+    null_output_t output;
+    if(use_weather){
+        cloud_weather_init(&volumes.weather, weather_size, texel_size);
+        output.weather_texture.resize((size_t)weather_size * weather_size * 4);
+        volumes.samplers.weather = &volumes.weather;
+    }
+
+    printf("bench_path %s: %u frames at %g fps, %u keys over %.1f s\n", path_file, path.num_frames, path.fps, (unsigned int)path.keys.size(), path.keys.back().seconds);
+    if(do_render){
+        printf("  rendering %ux%u packets on the CPU at 1/%u resolution\n", render_width, render_height, upsample.scale);
+    }
+
+    // App::Update's CPU side a frame at a time, fixed steps and nothing to present
+    cloud_bench_recorder_t recorder;
+    cloud_raymarch_params_t params;
+    cloud_image_t image;
+    for(unsigned int frame = 0; frame < path.num_frames; ++frame){
+        cloud_bench_begin_frame(&recorder);
+        {
+            cloud_bench_scope_t scope(&recorder, "camera");
+            cloud_bench_get_params(path, frame, &params);
+        }
+        {
+            cloud_bench_scope_t scope(&recorder, "weather");
+            params.cloud.weather_map = Vector4(use_weather ? 1.0f / volumes.weather.get_extent() : 0.0f, use_weather ? 1.0f : 0.0f, 0.0f, 0.0f);
+            if(use_weather){
+                Vector3 camera_pos = params.cloud.transform.get_translation().GetXYZ();
+                cloud_weather_update(&volumes.weather, params, camera_pos.x, camera_pos.z, budget_ms);
+
+                // The rows UpdateRegionRGBA8 would copy up
+                size_t texture_pitch = (size_t)weather_size * 4;
+                for(const cloud_weather_rect_t& rect : volumes.weather.updated_rects){
+                    size_t row_bytes = (size_t)(rect.max_x - rect.min_x) * 4;
+                    for(int z = rect.min_z; z < rect.max_z; ++z){
+                        memcpy(output.weather_texture.data() + ((size_t)z * texture_pitch) + ((size_t)rect.min_x * 4),
+                            volumes.weather.texels.get_voxel((unsigned int)rect.min_x, (unsigned int)z, 0), row_bytes);
+                    }
+                }
+                volumes.weather.updated_rects.clear();
+            }
+        }
+        {
+            cloud_bench_scope_t scope(&recorder, "constant_buffers");
+            output.cloud_buffer = params.cloud;
+            memcpy(output.midi_buffer, params.knobs, sizeof(params.knobs));
+            memcpy(output.midi_buffer + CLOUD_MIDI_NUM_CONTROLS, params.sliders, sizeof(params.sliders));
+        }
+        if(do_render){
+            cloud_bench_scope_t scope(&recorder, "render");
+            cloud_upsample_render(&upsample, params, volumes.samplers, render_width, render_height, &image);
+        }
+        cloud_bench_end_frame(&recorder);
+    }
+    if(use_weather){
+        cloud_weather_wait(&volumes.weather);
+    }
+
+    printf("  %-18s %9s %9s %9s %9s %9s\n", "ms", "mean", "p50", "p95", "p99", "max");
+    for(size_t i = 0; i <= recorder.scopes.size(); ++i){
+        const char* name = (i == 0) ? "frame" : recorder.scopes[i - 1].name.c_str();
+        cloud_bench_summary_t summary;
+        cloud_bench_get_summary((i == 0) ? recorder.frame_seconds : recorder.scopes[i - 1].frame_seconds, &summary);
+        printf("  %-18s %9.3f %9.3f %9.3f %9.3f %9.3f\n", name, summary.mean * 1000.0, summary.p50 * 1000.0, summary.p95 * 1000.0, summary.p99 * 1000.0, summary.max * 1000.0);
+    }
+
+    if(nullptr != out_file){
+        if(!cloud_bench_write_json(recorder, path, out_file)){
+            printf("bench_path: couldn't write \"%s\"\n", out_file);
+            return 1;
+        }
+        printf("  wrote %s\n", out_file);
+    }
+    return 0;
+}
+
+TOOL_VERB(bench_upsample, "[-width N] [-height N] [-runs N] [-depth-sigma s] [-transmittance-sigma s] [-out prefix] [-base N] [-detail N] [-cache dir|none] [-weather texel_m] [-light cell_m]", "half and quarter res march plus upsample against full res, fails if a simd level drifts")
+{
+    unsigned int width = (unsigned int)atoi(get_option(argc, argv, "-width", "1920"));
+    unsigned int height = (unsigned int)atoi(get_option(argc, argv, "-height", "1080"));
+    unsigned int num_runs = (unsigned int)atoi(get_option(argc, argv, "-runs", "1"));
+    const char* out_prefix = get_option(argc, argv, "-out", nullptr);
+    const char* depth_sigma = get_option(argc, argv, "-depth-sigma", nullptr);
+    const char* transmittance_sigma = get_option(argc, argv, "-transmittance-sigma", nullptr);
+    if((width == 0) || (height == 0) || (num_runs == 0)){
+        printf("bench_upsample: invalid size or run count\n");
+        return 1;
+    }
+
+    cloud_upsample_t upsample;
+    cloud_upsample_load_from_config(&upsample);
+    upsample.depth_sigma = (nullptr != depth_sigma) ? (float)atof(depth_sigma) : upsample.depth_sigma;
+    upsample.transmittance_sigma = (nullptr != transmittance_sigma) ? (float)atof(transmittance_sigma) : upsample.transmittance_sigma;
+
+    render_volumes_t volumes;
+    if(!load_render_volumes(argc, argv, &volumes)){
+        printf("bench_upsample: couldn't set up the noise volumes\n");
+        return 1;
+    }
+
+    cloud_raymarch_params_t params;
+    cloud_raymarch_set_defaults(&params);
+    cloud_raymarch_load_from_config(&params);
+    if(!load_render_weather(argc, argv, params, &volumes)){
+        printf("bench_upsample: couldn't bake the weather map\n");
+        return 1;
+    }
+    if(!load_render_light(argc, argv, params, &volumes)){
+        printf("bench_upsample: couldn't build the light volume\n");
+        return 1;
+    }
+
+    printf("bench_upsample %ux%u, depth sigma %g, transmittance sigma %g, best of %u\n", width, height, upsample.depth_sigma, upsample.transmittance_sigma, num_runs);
+
+    cloud_image_t reference;
+    cloud_raymarch_stats_t reference_stats;
+    for(unsigned int run = 0; run < num_runs; ++run){
+        cloud_raymarch_stats_t stats;
+        cloud_raymarch_render_packets(params, volumes.samplers, width, height, &reference, 0, &stats);
+        if((run == 0) || (stats.seconds < reference_stats.seconds)){
+            reference_stats = stats;
+        }
+    }
+    printf("  full     %8.2f ms march\n", reference_stats.seconds * 1000.0);
+    if(nullptr != out_prefix){
+        cloud_image_save_png(reference, (std::string(out_prefix) + "_full.png").c_str());
+    }
+
+    int result = 0;
+    SimdLevel detected_level = cpu_get_simd_level();
+    for(unsigned int scale = 2; scale <= CLOUD_UPSAMPLE_MAX_SCALE; scale *= 2){
+        upsample.scale = scale;
+        upsample.has_guides = false;
+
+        // The first run makes the guides, later ones keep them like a still camera would
+        cloud_image_t image;
+        cloud_upsample_stats_t best;
+        double guide_seconds = 0.0;
+        for(unsigned int run = 0; run < num_runs; ++run){
+            cloud_upsample_stats_t stats;
+            cloud_upsample_render(&upsample, params, volumes.samplers, width, height, &image, 0, &stats);
+            guide_seconds = (run == 0) ? stats.guide_seconds : guide_seconds;
+            if((run == 0) || (stats.render_seconds + stats.upsample_seconds < best.render_seconds + best.upsample_seconds)){
+                best = stats;
+            }
+        }
+        double seconds = best.render_seconds + best.upsample_seconds;
+
+        // Same low image, every term off
+        cloud_upsample_t bilinear = upsample;
+        bilinear.depth_sigma = 0.0f;
+        bilinear.transmittance_sigma = 0.0f;
+        cloud_image_t bilinear_image;
+        cloud_upsample_image(bilinear, upsample.low_image, upsample.low_depth, upsample.full_depth, width, height, &bilinear_image);
+
+        printf("  1/%u      %8.2f ms march %ux%u, %6.2f ms upsample, %6.2f ms guides, %5.2fx faster\n", scale, best.render_seconds * 1000.0, best.low_width, best.low_height,
+            best.upsample_seconds * 1000.0, guide_seconds * 1000.0, (seconds > 0.0) ? reference_stats.seconds / seconds : 0.0);
+        printf("           mean difference %.5f, on screen %.5f, bilinear %.5f, on screen %.5f\n", get_mean_difference(image, reference), get_display_difference(image, reference),
+            get_mean_difference(bilinear_image, reference), get_display_difference(bilinear_image, reference));
+        if(nullptr != out_prefix){
+            std::string filename = std::string(out_prefix) + "_" + std::to_string(scale) + ".png";
+            cloud_image_save_png(image, filename.c_str());
+            filename = std::string(out_prefix) + "_" + std::to_string(scale) + "_bilinear.png";
+            cloud_image_save_png(bilinear_image, filename.c_str());
+        }
+
+        // Every level does the scalar pixel's ops, so they should agree to the bit
+        for(unsigned int level = 0; level <= (unsigned int)detected_level; ++level){
+            cpu_set_max_simd_level((SimdLevel)level);
+            cloud_image_t level_image;
+            double start = get_current_time_seconds();
+            cloud_upsample_image(upsample, upsample.low_image, upsample.low_depth, upsample.full_depth, width, height, &level_image);
+            double level_seconds = get_current_time_seconds() - start;
+
+            float max_difference = get_max_difference(level_image.pixels, image.pixels);
+            bool matches = (max_difference == 0.0f);
+            result = matches ? result : 1;
+            printf("           upsample %-7s %8.2f ms, %7.1f M pixels/sec  %s\n", cpu_get_simd_level_name((SimdLevel)level), level_seconds * 1000.0,
+                (level_seconds > 0.0) ? (double)width * height / level_seconds / 1000000.0 : 0.0, matches ? "matches" : "DOESN'T MATCH");
+        }
+        cpu_set_max_simd_level(detected_level);
+    }
+    return result;
+}
+
+TOOL_VERB(bench_weather, "[-size N] [-texel m] [-scroll m] [-frames N] [-budget ms] [-samples N]", "weather map bake and scroll times, fails if a scroll drifts from a full bake")
+{
+    unsigned int size = (unsigned int)atoi(get_option(argc, argv, "-size", "1024"));
+    float texel_size = (float)atof(get_option(argc, argv, "-texel", "100"));
+    float scroll = (float)atof(get_option(argc, argv, "-scroll", "5000"));
+    unsigned int num_frames = (unsigned int)atoi(get_option(argc, argv, "-frames", "16"));
+    float budget_ms = (float)atof(get_option(argc, argv, "-budget", "2"));
+    unsigned int num_samples = (unsigned int)atoi(get_option(argc, argv, "-samples", "1000000"));
+    if((size == 0) || !(texel_size > 0.0f) || (num_frames == 0) || (budget_ms < 0.0f) || (num_samples == 0)){
+        printf("bench_weather: invalid size, texel size, frame count, budget or sample count\n");
+        return 1;
+    }
+
+    cloud_raymarch_params_t params;
+    cloud_raymarch_set_defaults(&params);
+    cloud_raymarch_load_from_config(&params);
+
+    cloud_weather_map_t map;
+    cloud_weather_init(&map, size, texel_size);
+    cloud_weather_bake(&map, params, 0.0f, 0.0f);
+    double bake_seconds = map.bake_seconds;
+    printf("bench_weather: %u^2 texels of %.0f m (%.1f km across)\n", size, texel_size, map.get_extent() / 1000.0f);
+    printf("  full bake:  %8.2f ms, %.2f M texels/sec on %u workers\n", bake_seconds * 1000.0, (bake_seconds > 0.0) ? (double)size * size / bake_seconds / 1000000.0 : 0.0, job_get_max_workers());
+
+    // Drifts diagonally a frame at a time, stepping whatever each frame exposed
+    size_t num_texels_before = map.num_texels_baked;
+    double scroll_start_seconds = map.bake_seconds;
+    unsigned int num_steps = 0;
+    for(unsigned int frame = 1; frame <= num_frames; ++frame){
+        float t = (float)frame / (float)num_frames;
+        cloud_weather_scroll(&map, scroll * t, -0.5f * scroll * t);
+        cloud_weather_step(&map, params, budget_ms);
+        ++num_steps;
+    }
+    while(!cloud_weather_step(&map, params, budget_ms)){
+        ++num_steps;
+    }
+    double scroll_seconds = map.bake_seconds - scroll_start_seconds;
+    size_t num_scroll_texels = map.num_texels_baked - num_texels_before;
+    printf("  scrolled %.0f m over %u frames: %zu texels rebaked in %u steps of %.2f ms, %.2f ms total\n", scroll, num_frames, num_scroll_texels, num_steps, budget_ms,
+        scroll_seconds * 1000.0);
+
+    // The scrolled map has to hold exactly what a fresh bake there would
+    cloud_weather_map_t reference;
+    cloud_weather_init(&reference, size, texel_size);
+    cloud_weather_bake(&reference, params, scroll, -0.5f * scroll);
+    bool matches = (reference.origin_x == map.origin_x) && (reference.origin_z == map.origin_z) && (reference.texels.data == map.texels.data);
+    printf("  scrolled map %s a full bake at the new position\n", matches ? "matches" : "DOESN'T MATCH");
+
+    // What density sampling pays for coverage either way, a texel in from the
+    // window's edges where bilinear reads wrap onto the far side
+    std::vector<float> xs(num_samples);
+    std::vector<float> zs(num_samples);
+    float extent = map.get_extent() - (2.0f * texel_size);
+    for(unsigned int i = 0; i < num_samples; ++i){
+        xs[i] = scroll + (((float)rand() / (float)RAND_MAX) - 0.5f) * extent;
+        zs[i] = (-0.5f * scroll) + (((float)rand() / (float)RAND_MAX) - 0.5f) * extent;
+    }
+
+    float checksum = 0.0f;
+    double perlin_start = get_current_time_seconds();
+    for(unsigned int i = 0; i < num_samples; ++i){
+        checksum += cloud_raymarch_get_coverage(params, xs[i], zs[i]);
+    }
+    double perlin_seconds = get_current_time_seconds() - perlin_start;
+
+    double map_start = get_current_time_seconds();
+    for(unsigned int i = 0; i < num_samples; ++i){
+        checksum += cloud_weather_get_coverage(map, xs[i], zs[i]);
+    }
+    double map_seconds = get_current_time_seconds() - map_start;
+
+    float max_difference = 0.0f;
+    double total_difference = 0.0;
+    for(unsigned int i = 0; i < num_samples; ++i){
+        float difference = fabsf(cloud_weather_get_coverage(map, xs[i], zs[i]) - cloud_raymarch_get_coverage(params, xs[i], zs[i]));
+        max_difference = (difference > max_difference) ? difference : max_difference;
+        total_difference += difference;
+    }
+
+    printf("  coverage: per sample Perlin %.2f M/sec, weather map %.2f M/sec (%.1fx), checksum %.1f\n", (perlin_seconds > 0.0) ? num_samples / perlin_seconds / 1000000.0 : 0.0,
+        (map_seconds > 0.0) ? num_samples / map_seconds / 1000000.0 : 0.0, (map_seconds > 0.0) ? perlin_seconds / map_seconds : 0.0, checksum);
+    printf("  map against per sample: mean difference %.4f, max %.4f\n", total_difference / num_samples, max_difference);
+
+    return matches ? 0 : 1;
+}
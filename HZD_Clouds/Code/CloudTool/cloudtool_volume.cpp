@@ -0,0 +1,780 @@
+#include "CloudTool/cloudtool.h"
+
+#include "Game/cloud_noise_gen.h"
+
+#include "Engine/Core/Time.hpp"
+#include "Engine/Core/cpu.h"
+#include "Engine/Core/job.h"
+#include "Engine/Volume/volume_bc.h"
+#include "Engine/Volume/volume_file.h"
+#include "Engine/Volume/volume_layout.h"
+#include "Engine/Volume/volume_mips.h"
+#include "Engine/Volume/volume_sampler.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+//-----------------------------------------------------
+// Volume verbs
+//
+// Mip chains, block compression, sampling and layouts of any volume file.
+
+TOOL_VERB(mips, "<in.vol|in.dat|in.texture> <out.vol> [-filter kaiser|box]", "writes a volume file with a CPU built mip chain")
+{
+    const char* in_path = get_positional_arg(argc, argv, 0);
+    const char* out_path = get_positional_arg(argc, argv, 1);
+    const char* filter_name = get_option(argc, argv, "-filter", "kaiser");
+    if((nullptr == in_path) || (nullptr == out_path)){
+        printf("mips: missing arguments\n");
+        return 1;
+    }
+
+    // Only the top level of the input is used, any mips it has get rebuilt
+    volume_file_t file;
+    volume_buffer_t raw;
+    volume_view_t top;
+    VolumeFormat format = VOLUME_FORMAT_RGBA8;
+    if(has_extension(in_path, VOLUME_FILE_EXTENSION)){
+        if(!volume_file_open(&file, in_path, VOLUME_FILE_VERIFY_CHECKSUM)){
+            printf("mips: couldn't open \"%s\"\n", in_path);
+            return 1;
+        }
+        // Compressed files get decoded and the chain is rebuilt uncompressed
+        format = volume_file_get_format(file);
+        if(volume_format_is_compressed(format)){
+            if(!volume_file_copy_mip(file, 0, &raw)){
+                printf("mips: couldn't decode \"%s\"\n", in_path);
+                volume_file_close(&file);
+                return 1;
+            }
+            format = volume_format_get_decoded(format);
+            top = raw.get_view();
+        }else{
+            top = volume_file_get_mip(file, 0);
+        }
+    }else{
+        if(!volume_file_load_raw(in_path, format, 0, 0, 0, &raw)){
+            printf("mips: \"%s\" isn't a cube shaped RGBA8 volume\n", in_path);
+            return 1;
+        }
+        top = raw.get_view();
+    }
+
+    volume_mip_stats_t stats;
+    stats.seconds = 0.0;
+    stats.num_mips = 1;
+    bool saved = save_volume_with_mips(out_path, format, top, filter_name, &stats);
+    if(volume_file_is_open(file)){
+        volume_file_close(&file);
+    }
+
+    if(!saved){
+        printf("mips: failed to write \"%s\"\n", out_path);
+        return 1;
+    }
+
+    printf("%s -> %s, %ux%ux%u %s, %u mips (%s) in %.2f ms\n", in_path, out_path, top.width, top.height, top.depth, volume_format_get_name(format), stats.num_mips, filter_name, stats.seconds * 1000.0);
+    return 0;
+}
+
+static void fill_bench_mip_volume(volume_buffer_t* volume, VolumeFormat format, unsigned int size)
+{
+    volume->resize(size, size, size, volume_format_get_bytes_per_voxel(format));
+
+    // Smooth-ish ramps plus noise, so the Kaiser lobes actually have something to overshoot
+    unsigned int state = 0x2545f491;
+    for(unsigned int z = 0; z < size; ++z){
+        for(unsigned int y = 0; y < size; ++y){
+            unsigned char* voxel = volume->get_voxel(0, y, z);
+            for(unsigned int x = 0; x < size; ++x){
+                state ^= state << 13;
+                state ^= state >> 17;
+                state ^= state << 5;
+
+                float value = ((float)((x + y + z) % 64) / 64.0f) * 0.75f + ((float)(state & 0xff) / 255.0f) * 0.25f;
+                if(format == VOLUME_FORMAT_R16F){
+                    ((unsigned short*)voxel)[x] = volume_float_to_half(value);
+                }else{
+                    unsigned int channels = volume_format_get_num_channels(format);
+                    for(unsigned int c = 0; c < channels; ++c){
+                        voxel[(x * channels) + c] = (unsigned char)(value * 255.0f) ^ (unsigned char)(c * 37);
+                    }
+                }
+            }
+        }
+    }
+}
+
+static bool mip_chains_match(const std::vector<volume_buffer_t>& a, const std::vector<volume_buffer_t>& b)
+{
+    if(a.size() != b.size()){
+        return false;
+    }
+    for(size_t i = 0; i < a.size(); ++i){
+        if(a[i].data != b[i].data){
+            return false;
+        }
+    }
+    return true;
+}
+
+TOOL_VERB(bench_mips, "[-size N] [-runs N]", "times mip chain builds per format, filter and simd level")
+{
+    unsigned int size = (unsigned int)atoi(get_option(argc, argv, "-size", "128"));
+    unsigned int num_runs = (unsigned int)atoi(get_option(argc, argv, "-runs", "3"));
+    if((size == 0) || (num_runs == 0)){
+        printf("bench_mips: invalid size or run count\n");
+        return 1;
+    }
+
+    SimdLevel detected_level = cpu_get_simd_level();
+    unsigned int max_workers = job_get_max_workers();
+    printf("bench_mips %u^3, full chain, best of %u, %u workers\n", size, num_runs, max_workers);
+
+    int result = 0;
+    for(unsigned int f = 0; f < NUM_VOLUME_FORMATS; ++f){
+        VolumeFormat format = (VolumeFormat)f;
+        if(volume_format_is_compressed(format)){
+            continue;
+        }
+
+        volume_buffer_t top;
+        fill_bench_mip_volume(&top, format, size);
+
+        for(unsigned int m = 0; m < NUM_VOLUME_MIP_FILTERS; ++m){
+            VolumeMipFilter filter = (VolumeMipFilter)m;
+
+            // Every SIMD level has to produce the scalar result exactly
+            std::vector<volume_buffer_t> reference;
+            for(unsigned int level = 0; level <= (unsigned int)detected_level; ++level){
+                cpu_set_max_simd_level((SimdLevel)level);
+
+                std::vector<volume_buffer_t> mips;
+                volume_mip_stats_t best;
+                best.seconds = 0.0;
+                for(unsigned int run = 0; run < num_runs; ++run){
+                    volume_mip_stats_t stats;
+                    volume_mips_build(top.get_view(), format, filter, &mips, 0, 0, &stats);
+                    if((run == 0) || (stats.seconds < best.seconds)){
+                        best = stats;
+                    }
+                }
+
+                bool matches = true;
+                if(level == 0){
+                    reference.swap(mips);
+                }else{
+                    matches = mip_chains_match(reference, mips);
+                    result = matches ? result : 1;
+                }
+
+                printf("  %-6s %-7s %-7s %8.2f ms  %6.2f GB/s  %s\n", volume_format_get_name(format), volume_mip_filter_get_name(filter), cpu_get_simd_level_name((SimdLevel)level),
+                    best.seconds * 1000.0, best.bytes_per_second() / (1024.0 * 1024.0 * 1024.0), (level == 0) ? "reference" : (matches ? "matches scalar" : "MISMATCH"));
+            }
+        }
+    }
+    cpu_set_max_simd_level(detected_level);
+
+    // Thread scaling on the case the game actually builds
+    volume_buffer_t top;
+    fill_bench_mip_volume(&top, VOLUME_FORMAT_RGBA8, size);
+
+    double single_seconds = 0.0;
+    for(unsigned int workers = 1; workers <= max_workers; ++workers){
+        std::vector<volume_buffer_t> mips;
+        volume_mip_stats_t best;
+        best.seconds = 0.0;
+        for(unsigned int run = 0; run < num_runs; ++run){
+            volume_mip_stats_t stats;
+            volume_mips_build(top.get_view(), VOLUME_FORMAT_RGBA8, VOLUME_MIP_FILTER_KAISER, &mips, 0, workers, &stats);
+            if((run == 0) || (stats.seconds < best.seconds)){
+                best = stats;
+            }
+        }
+
+        single_seconds = (workers == 1) ? best.seconds : single_seconds;
+        printf("  rgba8 kaiser %2u workers: %8.2f ms, %.2fx\n", best.num_workers, best.seconds * 1000.0, single_seconds / best.seconds);
+    }
+    return result;
+}
+
+static const char* s_channel_names = "rgba";
+
+TOOL_VERB(compress, "<in.vol|in.dat|in.texture> <out.vol>", "writes a 4x4x4 block compressed volume file")
+{
+    const char* in_path = get_positional_arg(argc, argv, 0);
+    const char* out_path = get_positional_arg(argc, argv, 1);
+    if((nullptr == in_path) || (nullptr == out_path)){
+        printf("compress: missing arguments\n");
+        return 1;
+    }
+
+    // Every mip of a volume file gets compressed, a headerless file is just its top level
+    volume_file_t file;
+    volume_buffer_t raw;
+    std::vector<volume_view_t> mips;
+    VolumeFormat format = VOLUME_FORMAT_RGBA8;
+    if(has_extension(in_path, VOLUME_FILE_EXTENSION)){
+        if(!volume_file_open(&file, in_path, VOLUME_FILE_VERIFY_CHECKSUM)){
+            printf("compress: couldn't open \"%s\"\n", in_path);
+            return 1;
+        }
+        format = volume_file_get_format(file);
+        for(unsigned int i = 0; !volume_format_is_compressed(format) && (i < volume_file_get_num_mips(file)); ++i){
+            mips.push_back(volume_file_get_mip(file, i));
+        }
+    }else{
+        if(!volume_file_load_raw(in_path, format, 0, 0, 0, &raw)){
+            printf("compress: \"%s\" isn't a cube shaped RGBA8 volume\n", in_path);
+            return 1;
+        }
+        mips.push_back(raw.get_view());
+    }
+
+    if((format != VOLUME_FORMAT_RGBA8) && (format != VOLUME_FORMAT_R8)){
+        printf("compress: %s volumes can't be compressed, only rgba8 and r8\n", volume_format_get_name(format));
+        volume_file_close(&file);
+        return 1;
+    }
+
+    std::vector<volume_bc_t> compressed(mips.size());
+    std::vector<volume_bc_view_t> views;
+    volume_bc_stats_t top_stats;
+    size_t raw_bytes = 0;
+    size_t compressed_bytes = 0;
+    double seconds = 0.0;
+    for(size_t i = 0; i < mips.size(); ++i){
+        volume_bc_stats_t stats;
+        volume_bc_encode(mips[i], format, &compressed[i], 0, &stats);
+        top_stats = (i == 0) ? stats : top_stats;
+        raw_bytes += stats.raw_bytes;
+        compressed_bytes += stats.compressed_bytes;
+        seconds += stats.seconds;
+        views.push_back(compressed[i].get_view());
+    }
+
+    bool saved = volume_file_save_bc(out_path, views.data(), (unsigned int)views.size());
+    if(volume_file_is_open(file)){
+        volume_file_close(&file);
+    }
+
+    if(!saved){
+        printf("compress: failed to write \"%s\"\n", out_path);
+        return 1;
+    }
+
+    printf("%s -> %s, %ux%ux%u %s, %u mip(s), %zu -> %zu bytes (%.2f:1) in %.2f ms\n", in_path, out_path, views[0].width, views[0].height, views[0].depth,
+        volume_format_get_name(volume_bc_get_format(views[0].num_channels)), (unsigned int)views.size(), raw_bytes, compressed_bytes, (double)raw_bytes / (double)compressed_bytes, seconds * 1000.0);
+    for(unsigned int c = 0; c < top_stats.num_channels; ++c){
+        printf("  %c: PSNR %6.2f dB, max error %u\n", s_channel_names[c], top_stats.psnr(c), top_stats.max_error[c]);
+    }
+    return 0;
+}
+
+TOOL_VERB(bench_compress, "[base|detail] [-size N] [-runs N]", "compression ratio, error per channel and decode speed")
+{
+    const char* type_name = get_positional_arg(argc, argv, 0);
+    CloudNoiseType type = CLOUD_NOISE_BASE;
+    if((nullptr != type_name) && !cloud_noise_get_type_from_name(&type, type_name)){
+        printf("bench_compress: expected base or detail\n");
+        return 1;
+    }
+
+    unsigned int size = (unsigned int)atoi(get_option(argc, argv, "-size", "128"));
+    unsigned int num_runs = (unsigned int)atoi(get_option(argc, argv, "-runs", "5"));
+    if((size == 0) || (num_runs == 0)){
+        printf("bench_compress: invalid size or run count\n");
+        return 1;
+    }
+
+    // Real noise, the error only means something on the data we ship
+    noise_gen_paramters_data_t params;
+    cloud_noise_gen_set_defaults(&params);
+    cloud_noise_gen_load_from_config(&params);
+
+    volume_buffer_t source;
+    cloud_noise_bake(type, params, size, size, size, &source);
+
+    unsigned int max_workers = job_get_max_workers();
+    printf("bench_compress %s %u^3, best of %u, %u workers\n", cloud_noise_get_type_name(type), size, num_runs, max_workers);
+
+    volume_bc_t compressed;
+    volume_bc_stats_t encode_stats;
+    volume_bc_encode(source.get_view(), VOLUME_FORMAT_RGBA8, &compressed, 0, &encode_stats);
+    volume_bc_view_t view = compressed.get_view();
+
+    const double megabyte = 1024.0 * 1024.0;
+    const double gigabyte = megabyte * 1024.0;
+    printf("  encode: %.2f ms, %.2f MB -> %.2f MB, %.2f:1\n", encode_stats.seconds * 1000.0, encode_stats.raw_bytes / megabyte, encode_stats.compressed_bytes / megabyte, encode_stats.ratio());
+    for(unsigned int c = 0; c < encode_stats.num_channels; ++c){
+        printf("    %c: PSNR %6.2f dB, max error %u\n", s_channel_names[c], encode_stats.psnr(c), encode_stats.max_error[c]);
+    }
+
+    // The full decode has to land on exactly the error the encoder measured
+    volume_buffer_t decoded;
+    volume_bc_decode(view, &decoded);
+
+    volume_bc_stats_t check;
+    volume_bc_measure_error(source.get_view(), decoded.get_view(), &check);
+    bool matches = true;
+    for(unsigned int c = 0; c < encode_stats.num_channels; ++c){
+        matches = matches && (check.mse[c] == encode_stats.mse[c]) && (check.max_error[c] == encode_stats.max_error[c]);
+    }
+    printf("  decode %s the encoder's error\n", matches ? "matches" : "DOESN'T MATCH");
+
+    // Single worker per SIMD level, every level has to give the scalar bytes
+    SimdLevel detected_level = cpu_get_simd_level();
+    for(unsigned int level = 0; level <= (unsigned int)detected_level; ++level){
+        cpu_set_max_simd_level((SimdLevel)level);
+
+        volume_buffer_t level_decoded;
+        volume_bc_stats_t best;
+        best.seconds = 0.0;
+        for(unsigned int run = 0; run < num_runs; ++run){
+            volume_bc_stats_t stats;
+            volume_bc_decode(view, &level_decoded, 1, &stats);
+            if((run == 0) || (stats.seconds < best.seconds)){
+                best = stats;
+            }
+        }
+
+        bool level_matches = (level_decoded.data == decoded.data);
+        matches = matches && level_matches;
+        printf("  decode %-7s %8.2f ms, %6.2f GB/s  %s\n", cpu_get_simd_level_name((SimdLevel)level), best.seconds * 1000.0, best.bytes_per_second() / gigabyte, level_matches ? "matches" : "MISMATCH");
+    }
+    cpu_set_max_simd_level(detected_level);
+
+    double single_seconds = 0.0;
+    for(unsigned int workers = 1; workers <= max_workers; ++workers){
+        volume_bc_stats_t best;
+        best.seconds = 0.0;
+        for(unsigned int run = 0; run < num_runs; ++run){
+            volume_bc_stats_t stats;
+            volume_bc_decode(view, &decoded, workers, &stats);
+            if((run == 0) || (stats.seconds < best.seconds)){
+                best = stats;
+            }
+        }
+
+        single_seconds = (workers == 1) ? best.seconds : single_seconds;
+        printf("  decode %2u workers: %8.2f ms, %6.2f GB/s, %.2fx\n", best.num_workers, best.seconds * 1000.0, best.bytes_per_second() / gigabyte, single_seconds / best.seconds);
+    }
+
+    // Streaming: random regions through a cache an eighth of the volume, never
+    // smaller than the pages one region can straddle
+    const unsigned int num_requests = 256;
+    unsigned int region_size = (size < 32) ? size : 32;
+    unsigned int pages_per_axis = ((region_size + VOLUME_BC_PAGE_SIZE - 1) / VOLUME_BC_PAGE_SIZE) + 1;
+    size_t page_bytes = (size_t)VOLUME_BC_PAGE_SIZE * VOLUME_BC_PAGE_SIZE * VOLUME_BC_PAGE_SIZE * view.num_channels;
+    size_t min_cache_bytes = (size_t)pages_per_axis * pages_per_axis * pages_per_axis * page_bytes;
+    size_t cache_bytes = decoded.data.size() / 8;
+    cache_bytes = (cache_bytes > min_cache_bytes) ? cache_bytes : min_cache_bytes;
+
+    volume_bc_cache_t cache;
+    volume_bc_cache_init(&cache, view, cache_bytes);
+
+    unsigned int state = 0x2545f491;
+    bool stream_matches = true;
+    double stream_start = get_current_time_seconds();
+    for(unsigned int i = 0; i < num_requests; ++i){
+        unsigned int origin[3];
+        for(unsigned int axis = 0; axis < 3; ++axis){
+            state ^= state << 13;
+            state ^= state >> 17;
+            state ^= state << 5;
+            origin[axis] = state % (size - region_size + 1);
+        }
+
+        volume_brick_t region = { origin[0], origin[1], origin[2], origin[0] + region_size, origin[1] + region_size, origin[2] + region_size };
+        if(!volume_bc_cache_request(&cache, region)){
+            stream_matches = false;
+            break;
+        }
+
+        for(unsigned int z = region.min_z; z < region.max_z; ++z){
+            for(unsigned int y = region.min_y; y < region.max_y; ++y){
+                for(unsigned int x = region.min_x; x < region.max_x; ++x){
+                    const unsigned char* voxel = volume_bc_cache_get_voxel(&cache, x, y, z);
+                    stream_matches = stream_matches && (nullptr != voxel) && (memcmp(voxel, decoded.get_voxel(x, y, z), view.num_channels) == 0);
+                }
+            }
+        }
+    }
+    double stream_seconds = get_current_time_seconds() - stream_start;
+
+    size_t num_page_requests = cache.num_hits + cache.num_misses;
+    double hit_rate = (num_page_requests > 0) ? (double)cache.num_hits / (double)num_page_requests : 0.0;
+    double page_rate = (cache.decode_seconds > 0.0) ? ((double)cache.num_misses * page_bytes) / cache.decode_seconds : 0.0;
+    printf("  stream: %u requests of %u^3 in %.2f ms, %.0f KB cache, %.1f%% page hits, %zu evictions, %6.2f GB/s page decode, %s\n", num_requests, region_size, stream_seconds * 1000.0,
+        cache_bytes / 1024.0, hit_rate * 100.0, cache.num_evictions, page_rate / gigabyte, stream_matches ? "matches full decode" : "MISMATCH");
+
+    return (matches && stream_matches) ? 0 : 1;
+}
+
+TOOL_VERB(bench_sampler, "[-size N] [-samples N] [-mip m] [-runs N]", "samples/sec per format, address mode and simd level, fails if a level drifts from scalar")
+{
+    unsigned int size = (unsigned int)atoi(get_option(argc, argv, "-size", "128"));
+    unsigned int num_samples = (unsigned int)atoi(get_option(argc, argv, "-samples", "1000000"));
+    float mip = (float)atof(get_option(argc, argv, "-mip", "0.5"));
+    unsigned int num_runs = (unsigned int)atoi(get_option(argc, argv, "-runs", "3"));
+    if((size == 0) || (num_samples == 0) || (num_runs == 0)){
+        printf("bench_sampler: invalid size, sample count or run count\n");
+        return 1;
+    }
+
+    // uvw a couple of volumes either side of [0, 1] so wrap and clamp both get
+    // exercised, every 16th on a texel center
+    std::vector<float> us(num_samples);
+    std::vector<float> vs(num_samples);
+    std::vector<float> ws(num_samples);
+    unsigned int state = 0x6a09e667;
+    for(unsigned int i = 0; i < num_samples; ++i){
+        float* axes[3] = { &us[i], &vs[i], &ws[i] };
+        for(float* axis : axes){
+            state ^= state << 13;
+            state ^= state >> 17;
+            state ^= state << 5;
+            float value = ((float)(state & 0xffff) / 65535.0f) * 5.0f - 2.0f;
+            *axis = ((i % 16) == 0) ? (floorf(value * (float)size) + 0.5f) / (float)size : value;
+        }
+    }
+
+    SimdLevel detected_level = cpu_get_simd_level();
+    printf("bench_sampler %u^3, %u random samples at mip %.2f, best of %u\n", size, num_samples, mip, num_runs);
+
+    int result = 0;
+    for(unsigned int f = 0; f < NUM_VOLUME_FORMATS; ++f){
+        VolumeFormat format = (VolumeFormat)f;
+        if(volume_format_is_compressed(format)){
+            continue;
+        }
+
+        volume_buffer_t top;
+        std::vector<volume_buffer_t> mips;
+        fill_bench_mip_volume(&top, format, size);
+        volume_mips_build(top.get_view(), format, VOLUME_MIP_FILTER_BOX, &mips);
+
+        std::vector<volume_view_t> views;
+        volume_mips_get_views(top.get_view(), mips, &views);
+
+        for(unsigned int a = 0; a < NUM_VOLUME_ADDRESS_MODES; ++a){
+            VolumeAddressMode address = (VolumeAddressMode)a;
+            volume_sampler_t sampler;
+            volume_sampler_init(&sampler, views.data(), (unsigned int)views.size(), format, address);
+
+            // Every SIMD level has to give the single sample path's bits
+            std::vector<float> reference;
+            double scalar_seconds = 0.0;
+            for(unsigned int level = 0; level <= (unsigned int)detected_level; ++level){
+                cpu_set_max_simd_level((SimdLevel)level);
+
+                std::vector<float> rgba((size_t)num_samples * 4);
+                double best_seconds = 0.0;
+                for(unsigned int run = 0; run < num_runs; ++run){
+                    double start = get_current_time_seconds();
+                    volume_sample_trilinear_batch(sampler, us.data(), vs.data(), ws.data(), num_samples, mip, rgba.data());
+                    double seconds = get_current_time_seconds() - start;
+                    best_seconds = ((run == 0) || (seconds < best_seconds)) ? seconds : best_seconds;
+                }
+
+                bool matches = true;
+                if(level == 0){
+                    reference.swap(rgba);
+                    scalar_seconds = best_seconds;
+                }else{
+                    matches = (memcmp(reference.data(), rgba.data(), reference.size() * sizeof(float)) == 0);
+                    result = matches ? result : 1;
+                }
+
+                printf("  %-6s %-5s %-7s %8.2f M samples/sec  %5.2fx  %s\n", volume_format_get_name(format), (address == VOLUME_ADDRESS_WRAP) ? "wrap" : "clamp",
+                    cpu_get_simd_level_name((SimdLevel)level), (best_seconds > 0.0) ? num_samples / best_seconds / 1000000.0 : 0.0,
+                    (best_seconds > 0.0) ? scalar_seconds / best_seconds : 0.0, (level == 0) ? "reference" : (matches ? "matches scalar" : "MISMATCH"));
+            }
+        }
+    }
+    cpu_set_max_simd_level(detected_level);
+
+    return result;
+}
+
+static bool volumes_match_linear(const volume_buffer_t& linear, const volume_buffer_t& other)
+{
+    volume_buffer_t converted;
+    volume_convert_layout(other.get_view(), VOLUME_LAYOUT_LINEAR, &converted);
+    return (linear.width == converted.width) && (linear.height == converted.height) && (linear.depth == converted.depth) && (linear.data == converted.data);
+}
+
+TOOL_VERB(bench_layout, "[-size N] [-rays N] [-steps N] [-mip m] [-bake N]", "random ray sampling in linear and bricked volumes, fails if the layouts disagree")
+{
+    unsigned int size = (unsigned int)atoi(get_option(argc, argv, "-size", "256"));
+    unsigned int num_rays = (unsigned int)atoi(get_option(argc, argv, "-rays", "100000"));
+    unsigned int num_steps = (unsigned int)atoi(get_option(argc, argv, "-steps", "64"));
+    float mip = (float)atof(get_option(argc, argv, "-mip", "0"));
+    unsigned int bake_size = (unsigned int)atoi(get_option(argc, argv, "-bake", "64"));
+    if((size == 0) || (num_rays == 0) || (num_steps == 0) || (bake_size == 0)){
+        printf("bench_layout: invalid size, ray count, step count or bake size\n");
+        return 1;
+    }
+
+    printf("bench_layout %u^3 rgba8, %u bricks\n", size, VOLUME_BRICK_SIZE);
+    int result = 0;
+
+    // Both ways, a round trip has to give back the same bytes
+    volume_buffer_t linear;
+    fill_bench_mip_volume(&linear, VOLUME_FORMAT_RGBA8, size);
+
+    volume_buffer_t bricked;
+    volume_layout_stats_t to_bricked;
+    volume_convert_layout(linear.get_view(), VOLUME_LAYOUT_BRICKED, &bricked, 0, &to_bricked);
+
+    volume_buffer_t round_trip;
+    volume_layout_stats_t to_linear;
+    volume_convert_layout(bricked.get_view(), VOLUME_LAYOUT_LINEAR, &round_trip, 0, &to_linear);
+
+    bool round_trip_matches = (round_trip.data == linear.data);
+    result = round_trip_matches ? result : 1;
+    printf("  convert: to bricked %.2f ms (%.2f GB/s), to linear %.2f ms (%.2f GB/s) on %u workers, round trip %s\n", to_bricked.seconds * 1000.0,
+        to_bricked.bytes_per_second() / (1024.0 * 1024.0 * 1024.0), to_linear.seconds * 1000.0, to_linear.bytes_per_second() / (1024.0 * 1024.0 * 1024.0), to_linear.num_workers,
+        round_trip_matches ? "matches" : "DOESN'T MATCH");
+
+    // Noise baked straight into bricks has to be the linear bake rearranged
+    noise_gen_paramters_data_t noise_params;
+    cloud_noise_gen_set_defaults(&noise_params);
+    cloud_noise_gen_load_from_config(&noise_params);
+
+    volume_buffer_t baked[NUM_VOLUME_LAYOUTS];
+    double bake_seconds[NUM_VOLUME_LAYOUTS];
+    for(unsigned int l = 0; l < NUM_VOLUME_LAYOUTS; ++l){
+        baked[l].resize(bake_size, bake_size, bake_size, 4, (VolumeLayout)l);
+
+        volume_fill_stats_t stats;
+        cloud_noise_bake_channels(CLOUD_NOISE_BASE, noise_params, CLOUD_NOISE_CHANNEL_ALL, &baked[l], 0, &stats);
+        bake_seconds[l] = stats.seconds;
+    }
+
+    bool bake_matches = volumes_match_linear(baked[VOLUME_LAYOUT_LINEAR], baked[VOLUME_LAYOUT_BRICKED]);
+    result = bake_matches ? result : 1;
+    printf("  base noise bake %u^3: linear %.2f ms, bricked %.2f ms, bricked bake %s\n", bake_size, bake_seconds[VOLUME_LAYOUT_LINEAR] * 1000.0, bake_seconds[VOLUME_LAYOUT_BRICKED] * 1000.0,
+        bake_matches ? "matches" : "DOESN'T MATCH");
+
+    // Same for a mip chain built from either
+    std::vector<volume_buffer_t> mips[NUM_VOLUME_LAYOUTS];
+    volume_mips_build(linear.get_view(), VOLUME_FORMAT_RGBA8, VOLUME_MIP_FILTER_BOX, &mips[VOLUME_LAYOUT_LINEAR]);
+    volume_mips_build(bricked.get_view(), VOLUME_FORMAT_RGBA8, VOLUME_MIP_FILTER_BOX, &mips[VOLUME_LAYOUT_BRICKED]);
+
+    bool mips_match = (mips[VOLUME_LAYOUT_LINEAR].size() == mips[VOLUME_LAYOUT_BRICKED].size());
+    for(size_t i = 0; mips_match && (i < mips[VOLUME_LAYOUT_LINEAR].size()); ++i){
+        mips_match = volumes_match_linear(mips[VOLUME_LAYOUT_LINEAR][i], mips[VOLUME_LAYOUT_BRICKED][i]);
+    }
+    result = mips_match ? result : 1;
+    printf("  mip chain from bricked %s\n", mips_match ? "matches" : "DOESN'T MATCH");
+
+    // Rays from anywhere in any direction, a texel per step, sampled in ray order
+    // the way a march would
+    size_t num_samples = (size_t)num_rays * num_steps;
+    std::vector<float> us(num_samples);
+    std::vector<float> vs(num_samples);
+    std::vector<float> ws(num_samples);
+    unsigned int state = 0xbb67ae85;
+    float step_uvw = 1.0f / (float)size;
+    for(unsigned int ray = 0; ray < num_rays; ++ray){
+        float values[6];
+        for(float& value : values){
+            state ^= state << 13;
+            state ^= state >> 17;
+            state ^= state << 5;
+            value = (float)(state & 0xffff) / 65535.0f;
+        }
+
+        Vector3 direction(values[3] * 2.0f - 1.0f, values[4] * 2.0f - 1.0f, values[5] * 2.0f - 1.0f);
+        float length = direction.CalcLength();
+        direction = (length > 0.0001f) ? (direction * (step_uvw / length)) : Vector3(step_uvw, 0.0f, 0.0f);
+
+        for(unsigned int step = 0; step < num_steps; ++step){
+            size_t index = ((size_t)ray * num_steps) + step;
+            us[index] = values[0] + (direction.x * (float)step);
+            vs[index] = values[1] + (direction.y * (float)step);
+            ws[index] = values[2] + (direction.z * (float)step);
+        }
+    }
+
+    volume_buffer_t* tops[NUM_VOLUME_LAYOUTS] = { &linear, &bricked };
+    std::vector<float> rgba[NUM_VOLUME_LAYOUTS];
+    double ray_seconds[NUM_VOLUME_LAYOUTS];
+    for(unsigned int l = 0; l < NUM_VOLUME_LAYOUTS; ++l){
+        std::vector<volume_view_t> views;
+        volume_mips_get_views(tops[l]->get_view(), mips[l], &views);
+
+        volume_sampler_t sampler;
+        volume_sampler_init(&sampler, views.data(), (unsigned int)views.size(), VOLUME_FORMAT_RGBA8);
+
+        rgba[l].resize(num_samples * 4);
+        double start = get_current_time_seconds();
+        volume_sample_trilinear_batch(sampler, us.data(), vs.data(), ws.data(), (unsigned int)num_samples, mip, rgba[l].data());
+        ray_seconds[l] = get_current_time_seconds() - start;
+    }
+
+    bool rays_match = (rgba[VOLUME_LAYOUT_LINEAR] == rgba[VOLUME_LAYOUT_BRICKED]);
+    result = rays_match ? result : 1;
+    for(unsigned int l = 0; l < NUM_VOLUME_LAYOUTS; ++l){
+        printf("  %u rays x %u steps at mip %.2f, %-7s %8.2f M samples/sec  %5.2fx\n", num_rays, num_steps, mip, volume_layout_get_name((VolumeLayout)l),
+            (ray_seconds[l] > 0.0) ? (double)num_samples / ray_seconds[l] / 1000000.0 : 0.0, (ray_seconds[l] > 0.0) ? ray_seconds[VOLUME_LAYOUT_LINEAR] / ray_seconds[l] : 0.0);
+    }
+    printf("  bricked samples %s linear\n", rays_match ? "match" : "DON'T MATCH");
+
+    return result;
+}
+
+// Well under what the shipped volumes get (36+ dB base, 34+ dB detail), a drop
+// below this is an encoder regression rather than noise in the data
+static const double CHECK_MIN_BC_PSNR_DB = 32.0;
+
+TOOL_VERB(check_compress, "[-size N] [-min-psnr dB]", "fails on a PSNR floor miss or a decode mismatch")
+{
+    unsigned int size = (unsigned int)atoi(get_option(argc, argv, "-size", "32"));
+    double min_psnr = atof(get_option(argc, argv, "-min-psnr", "0"));
+    min_psnr = (min_psnr > 0.0) ? min_psnr : CHECK_MIN_BC_PSNR_DB;
+    if(size < 2){
+        printf("check_compress: invalid size\n");
+        return 1;
+    }
+
+    noise_gen_paramters_data_t params;
+    cloud_noise_gen_set_defaults(&params);
+    cloud_noise_gen_load_from_config(&params);
+
+    printf("check_compress %u^3 and %u^3, PSNR floor %.1f dB\n", size, size - 1, min_psnr);
+
+    // The odd size covers the partial blocks on every edge
+    int result = 0;
+    SimdLevel detected_level = cpu_get_simd_level();
+    for(unsigned int t = 0; t < NUM_CLOUD_NOISE_TYPES; ++t){
+        CloudNoiseType type = (CloudNoiseType)t;
+        for(unsigned int volume_size = size - 1; volume_size <= size; ++volume_size){
+            volume_buffer_t source;
+            cloud_noise_bake(type, params, volume_size, volume_size, volume_size, &source);
+
+            volume_bc_t compressed;
+            volume_bc_stats_t encode_stats;
+            volume_bc_encode(source.get_view(), VOLUME_FORMAT_RGBA8, &compressed, 0, &encode_stats);
+
+            bool passed = true;
+            for(unsigned int c = 0; c < encode_stats.num_channels; ++c){
+                bool channel_passed = (encode_stats.psnr(c) >= min_psnr);
+                passed = passed && channel_passed;
+                printf("  %-6s %3u^3 %c: PSNR %6.2f dB, max error %3u  %s\n", cloud_noise_get_type_name(type), volume_size, s_channel_names[c], encode_stats.psnr(c), encode_stats.max_error[c], channel_passed ? "ok" : "FAILED");
+            }
+
+            volume_buffer_t decoded;
+            volume_bc_decode(compressed.get_view(), &decoded);
+
+            volume_bc_stats_t check;
+            volume_bc_measure_error(source.get_view(), decoded.get_view(), &check);
+            bool matches = (decoded.width == volume_size) && (decoded.height == volume_size) && (decoded.depth == volume_size);
+            for(unsigned int c = 0; c < encode_stats.num_channels; ++c){
+                matches = matches && (check.mse[c] == encode_stats.mse[c]) && (check.max_error[c] == encode_stats.max_error[c]);
+            }
+            printf("  %-6s %3u^3 decode %s the encoder's error\n", cloud_noise_get_type_name(type), volume_size, matches ? "matches" : "DOESN'T MATCH");
+            passed = passed && matches;
+
+            for(unsigned int level = 0; level <= (unsigned int)detected_level; ++level){
+                cpu_set_max_simd_level((SimdLevel)level);
+                volume_buffer_t level_decoded;
+                volume_bc_decode(compressed.get_view(), &level_decoded);
+
+                bool level_matches = (level_decoded.data == decoded.data);
+                passed = passed && level_matches;
+                printf("  %-6s %3u^3 decode %-7s %s\n", cloud_noise_get_type_name(type), volume_size, cpu_get_simd_level_name((SimdLevel)level), level_matches ? "ok" : "MISMATCH");
+            }
+            cpu_set_max_simd_level(detected_level);
+
+            result = passed ? result : 1;
+        }
+    }
+    return result;
+}
+
+static bool check_mip_chain(const volume_buffer_t& top, VolumeFormat format, VolumeMipFilter filter, std::vector<volume_buffer_t>* out_mips)
+{
+    volume_mips_build(top.get_view(), format, filter, out_mips);
+
+    // Mip 0 is the top, the chain holds 1..N and ends at 1x1x1
+    unsigned int expected_count = volume_mips_get_full_count(top.width, top.height, top.depth);
+    bool passed = ((unsigned int)out_mips->size() + 1 == expected_count);
+
+    unsigned int width = top.width;
+    unsigned int height = top.height;
+    unsigned int depth = top.depth;
+    for(const volume_buffer_t& mip : *out_mips){
+        width = (width > 1) ? (width / 2) : 1;
+        height = (height > 1) ? (height / 2) : 1;
+        depth = (depth > 1) ? (depth / 2) : 1;
+        passed = passed && (mip.width == width) && (mip.height == height) && (mip.depth == depth);
+        passed = passed && (mip.bytes_per_voxel == top.bytes_per_voxel) && (mip.data.size() == mip.get_num_voxels() * mip.bytes_per_voxel);
+    }
+    passed = passed && (width == 1) && (height == 1) && (depth == 1);
+    return passed;
+}
+
+TOOL_VERB(check_mips, "", "fails on a wrong mip count, size or constant volume drift")
+{
+    UNUSED(argc);
+    UNUSED(argv);
+
+    // Cubes, odd and flat sizes, one axis bottoming out long before the others
+    struct mip_case_t { unsigned int width; unsigned int height; unsigned int depth; };
+    static const mip_case_t mip_cases[] = { { 1, 1, 1 }, { 2, 2, 2 }, { 32, 32, 32 }, { 33, 17, 9 }, { 64, 8, 1 }, { 5, 128, 3 } };
+
+    printf("check_mips\n");
+
+    int result = 0;
+    SimdLevel detected_level = cpu_get_simd_level();
+    for(unsigned int f = 0; f < NUM_VOLUME_FORMATS; ++f){
+        VolumeFormat format = (VolumeFormat)f;
+        if(volume_format_is_compressed(format)){
+            continue;
+        }
+
+        unsigned int bytes_per_voxel = volume_format_get_bytes_per_voxel(format);
+        for(const mip_case_t& mip_case : mip_cases){
+            // A constant volume has to stay that constant all the way down, whatever the filter
+            volume_buffer_t top;
+            top.resize(mip_case.width, mip_case.height, mip_case.depth, bytes_per_voxel);
+            unsigned char constant_voxel[4] = { 23, 84, 145, 206 };
+            if(format == VOLUME_FORMAT_R16F){
+                unsigned short half = volume_float_to_half(0.375f);
+                memcpy(constant_voxel, &half, sizeof(half));
+            }
+            for(size_t i = 0; i < top.get_num_voxels(); ++i){
+                memcpy(&top.data[i * bytes_per_voxel], constant_voxel, bytes_per_voxel);
+            }
+
+            for(unsigned int m = 0; m < NUM_VOLUME_MIP_FILTERS; ++m){
+                VolumeMipFilter filter = (VolumeMipFilter)m;
+
+                std::vector<volume_buffer_t> reference;
+                bool passed = check_mip_chain(top, format, filter, &reference);
+                for(const volume_buffer_t& mip : reference){
+                    for(size_t i = 0; passed && (i < mip.get_num_voxels()); ++i){
+                        passed = (memcmp(&mip.data[i * bytes_per_voxel], constant_voxel, bytes_per_voxel) == 0);
+                    }
+                }
+
+                for(unsigned int level = 1; level <= (unsigned int)detected_level; ++level){
+                    cpu_set_max_simd_level((SimdLevel)level);
+                    std::vector<volume_buffer_t> mips;
+                    passed = check_mip_chain(top, format, filter, &mips) && mip_chains_match(reference, mips) && passed;
+                }
+                cpu_set_max_simd_level(detected_level);
+
+                result = passed ? result : 1;
+                printf("  %-6s %-7s %3ux%3ux%3u: %2u levels  %s\n", volume_format_get_name(format), volume_mip_filter_get_name(filter), mip_case.width, mip_case.height, mip_case.depth,
+                    (unsigned int)reference.size() + 1, passed ? "ok" : "FAILED");
+            }
+        }
+    }
+    return result;
+}
@@ -20,7 +20,10 @@
 #include "Engine/RHI/RHIDeviceContext.hpp"
 #include "Engine/RHI/ConstantBuffer.hpp"
 #include "Engine/RHI/ShaderProgram.hpp"
+#include "Engine/RHI/RHITexture2D.hpp"
 #include "Engine/RHI/RHITexture3D.hpp"
+#include "Engine/Volume/volume_file.h"
+#include "Engine/Volume/volume_mips.h"
 
 #include "Engine/Renderer/Font.hpp"
 
@@ -63,31 +66,7 @@ COMMAND(set_wind_speed, "Sets the wind speed")
 
 COMMAND(save_clouds, "Saves clouds")
 {    
-    ConfigSet("base_worley_scale", g_theApp->m_noise_gen_data.worley_scale);
-    ConfigSet("base_worley_num_octaves", (int)g_theApp->m_noise_gen_data.worley_num_octaves);
-    ConfigSet("base_worley_octave_persistence", g_theApp->m_noise_gen_data.worley_octave_persistence);
-    ConfigSet("base_worley_octave_scale", g_theApp->m_noise_gen_data.worley_octave_scale);
-
-    ConfigSet("base_perlin_scale", g_theApp->m_noise_gen_data.perlin_scale);
-    ConfigSet("base_perlin_num_octaves", (int)g_theApp->m_noise_gen_data.perlin_num_octaves);
-    ConfigSet("base_perlin_octave_persistence", g_theApp->m_noise_gen_data.perlin_octave_persistence);
-    ConfigSet("base_perlin_octave_scale", g_theApp->m_noise_gen_data.perlin_octave_scale);
-    ConfigSet("generation_xyz_scale", g_theApp->m_noise_gen_data.generation_all_scale);
-    ConfigSet("generation_z_scale", g_theApp->m_noise_gen_data.generation_z_scale);
-
-    ConfigSet("base_worley_one_scale", g_theApp->m_noise_gen_data.worley_one_scale);
-    ConfigSet("base_worley_two_scale", g_theApp->m_noise_gen_data.worley_two_scale);
-    ConfigSet("base_worley_three_scale", g_theApp->m_noise_gen_data.worley_three_scale);
-    ConfigSet("base_fbm_worley_scale", (int)g_theApp->m_noise_gen_data.worley_only_num_octaves);
-    ConfigSet("base_fbm_worley_octave_persistence", g_theApp->m_noise_gen_data.worley_only_octave_persistence);
-    ConfigSet("base_fbm_worley_octave_scale", g_theApp->m_noise_gen_data.worley_only_octave_scale);
-
-    ConfigSet("detail_worley_one_scale", g_theApp->m_noise_gen_data.detail_worley_one_scale);
-    ConfigSet("detail_worley_two_scale", g_theApp->m_noise_gen_data.detail_worley_two_scale);
-    ConfigSet("detail_worley_three_scale", g_theApp->m_noise_gen_data.detail_worley_three_scale);
-    ConfigSet("detail_worley_num_octaves", (int)g_theApp->m_noise_gen_data.detail_worley_num_octaves);
-    ConfigSet("detail_worley_octave_peristence", g_theApp->m_noise_gen_data.detail_worley_octave_persistence);
-    ConfigSet("detail_worley_octave_scale", g_theApp->m_noise_gen_data.detail_worley_octave_scale);
+    cloud_noise_gen_save_to_config(g_theApp->m_noise_gen_data);
 
     ConfigSet("cloud_sample_scale", g_theApp->m_cloud_data.scale);
     ConfigSet("cloud_coverage", g_theApp->m_cloud_data.coverage);
@@ -98,9 +77,80 @@ COMMAND(save_clouds, "Saves clouds")
 
     ConfigSystemSaveToFile("Data/Config.dat");
 
-    // TODO, write out current textures to file
-    g_theApp->m_cloud_base->save_to_file("Data/Images/cloud_base_4.texture");
-    g_theApp->m_cloud_detail->save_to_file("Data/Images/cloud_base_4.texture");
+    g_theApp->save_noise_volume_to_cache(&g_theApp->m_base_noise_volume, g_theApp->m_cloud_base);
+    g_theApp->save_noise_volume_to_cache(&g_theApp->m_detail_noise_volume, g_theApp->m_cloud_detail);
+}
+
+COMMAND(save_noise_textures, "[string:kaiser|box] Writes the noise textures, mips included, over the shipped .vol files")
+{
+    VolumeMipFilter filter = VOLUME_MIP_FILTER_KAISER;
+    if(!args.is_at_end()){
+        std::string filter_name = args.next_string_arg();
+        if(!volume_mip_filter_from_name(&filter, filter_name.c_str())){
+            console_error("Unknown mip filter \"%s\"", filter_name.c_str());
+            return;
+        }
+    }
+
+    const char* filenames[2] = { "Data/Images/gg_base_noise.vol", "Data/Images/gg_detail_noise.vol" };
+    RHITexture3D* textures[2] = { g_theApp->m_cloud_base, g_theApp->m_cloud_detail };
+    for(unsigned int i = 0; i < 2; ++i){
+        if(textures[i]->save_to_file(filenames[i], filter)){
+            console_success("Saved %s (%s mips)", filenames[i], volume_mip_filter_get_name(filter));
+        }else{
+            console_error("Failed to save %s", filenames[i]);
+        }
+    }
+}
+
+COMMAND(noise_regen_budget, "[float:ms] Per-frame budget for noise regen (F6/F7), 0 regens in one go")
+{
+    if(!args.is_at_end()){
+        g_theApp->m_noise_regen_budget_ms = max(0.0f, args.next_float_arg());
+    }
+    console_info("noise regen budget: %.2f ms/frame", g_theApp->m_noise_regen_budget_ms);
+}
+
+static void print_noise_regen_status(const cloud_noise_volume_t& noise_volume)
+{
+    const char* name = cloud_noise_get_type_name(noise_volume.type);
+    if(!noise_volume.is_regenerating){
+        console_info("%s noise: idle", name);
+        return;
+    }
+
+    float progress = volume_fill_task_get_progress(noise_volume.regen_task);
+    double seconds_remaining = volume_fill_task_get_seconds_remaining(noise_volume.regen_task);
+    if(seconds_remaining < 0.0){
+        console_info("%s noise: %.1f%%", name, progress * 100.0f);
+    }else{
+        console_info("%s noise: %.1f%%, ~%.1f s left", name, progress * 100.0f, seconds_remaining);
+    }
+}
+
+COMMAND(noise_regen_status, "Shows progress of any running noise regen")
+{
+    print_noise_regen_status(g_theApp->m_base_noise_volume);
+    print_noise_regen_status(g_theApp->m_detail_noise_volume);
+}
+
+COMMAND(weather_map, "[bool] Coverage from the baked weather map instead of per-sample noise")
+{
+    if(!args.is_at_end()){
+        g_theApp->m_use_weather_map = args.next_bool_arg();
+    }
+
+    const cloud_weather_map_t& map = g_theApp->m_weather_map;
+    console_info("weather map: %s, %u^2 texels of %.0f m, %zu texels baked in %.2f ms", g_theApp->m_use_weather_map ? "on" : "off", map.size, map.texel_size,
+        map.num_texels_baked, map.bake_seconds * 1000.0);
+}
+
+COMMAND(weather_map_budget, "[float:ms] Per-frame budget for weather map strips, 0 bakes them in one go")
+{
+    if(!args.is_at_end()){
+        g_theApp->m_weather_budget_ms = max(0.0f, args.next_float_arg());
+    }
+    console_info("weather map budget: %.2f ms/frame", g_theApp->m_weather_budget_ms);
 }
 
 App::App()
@@ -119,6 +169,10 @@ App::App()
     ,m_slice_shader(nullptr)
     ,m_regen_base_noise(false)
     ,m_regen_detail_noise(false)
+    ,m_noise_regen_budget_ms(4.0f)
+    ,m_weather_texture(nullptr)
+    ,m_use_weather_map(true)
+    ,m_weather_budget_ms(1.0f)
     ,m_base_perlin_worley_slider(nullptr)
     ,m_base_fbm_worley_slider(nullptr)
     ,m_detail_noise_slider(nullptr)
@@ -131,12 +185,20 @@ App::App()
     ,m_perlin_worley_a(nullptr)
 	,m_sun_pos(0.25f)
 	,m_sun_distance(10000000.f)
+    ,m_is_benchmarking(false)
+    ,m_bench_frame(0)
+    ,m_bench_out(nullptr)
 {
 	g_theGame = new Game();
 }
 
 App::~App()
 {
+    // A regen dropped mid-way still has helper jobs writing its pending volume
+    volume_fill_task_wait(&m_base_noise_volume.regen_task);
+    volume_fill_task_wait(&m_detail_noise_volume.regen_task);
+    cloud_weather_wait(&m_weather_map);
+
     SAFE_DELETE(m_perlin_worley_r);
     SAFE_DELETE(m_perlin_worley_g);
     SAFE_DELETE(m_perlin_worley_b);
@@ -147,6 +209,7 @@ App::~App()
     SAFE_DELETE(m_cloud_settings_slider);
     SAFE_DELETE(m_cloud_base);
     SAFE_DELETE(m_cloud_detail);
+    SAFE_DELETE(m_weather_texture);
     SAFE_DELETE(m_cloud_data_buffer);
     SAFE_DELETE(m_old_clouds_shader);
     SAFE_DELETE(m_new_clouds_shader);
@@ -166,17 +229,99 @@ void App::Run()
 
 void App::init()
 {
+    init_vis_settings();
+    init_noise_cache();
+
+    // CPU copies for regen, the first regen bakes every channel unless the cache had them
+    cloud_noise_volume_init(&m_base_noise_volume, CLOUD_NOISE_BASE, 128);
+    cloud_noise_volume_init(&m_detail_noise_volume, CLOUD_NOISE_DETAIL, 32);
+
     m_cloud_base = new RHITexture3D(g_theRenderer->m_device);
 	m_cloud_base->m_generate_mips = true;
-    m_cloud_base->LoadFromFilenameRGBA8("Data/Images/gg_base_noise.dat", 128, 128, 128);
+    load_noise_volume(&m_base_noise_volume, m_cloud_base, "Data/Images/gg_base_noise");
 
     m_cloud_detail = new RHITexture3D(g_theRenderer->m_device);
 	m_cloud_detail->m_generate_mips = true;
-    m_cloud_detail->LoadFromFilenameRGBA8("Data/Images/gg_detail_noise.dat", 32, 32, 32);
+    load_noise_volume(&m_detail_noise_volume, m_cloud_detail, "Data/Images/gg_detail_noise");
+
+    // Reaches past the horizon at the top of the layer, the first update bakes it
+    cloud_weather_init(&m_weather_map, 2048, 100.0f);
+    m_weather_texture = new RHITexture2D(g_theRenderer->m_device, m_weather_map.size, m_weather_map.size, IMAGE_FORMAT_RGBA8);
 
-    init_vis_settings();
     init_sliders();
     InitRendering();
+    init_bench();
+}
+
+// bench_path runs a scripted camera path at a fixed step with the frame
+// limiter off, then writes the timings to bench_out and quits
+void App::init_bench()
+{
+    const char* path_file = nullptr;
+    if(!ConfigGetString(&path_file, CONFIG_BENCH_PATH_NAME)){
+        return;
+    }
+    if(!cloud_bench_load_path(&m_bench_path, path_file)){
+        log_warningf("Benchmark path [%s] didn't load, running normally", path_file);
+        return;
+    }
+
+    m_bench_out = "Data/Bench/results.json";
+    ConfigGetString(&m_bench_out, CONFIG_BENCH_OUT_NAME);
+
+    m_is_benchmarking = true;
+    m_bench_frame = 0;
+    m_cloud_data = m_bench_path.cloud;
+    m_viewFov = m_bench_path.fov_degrees;
+    g_theRenderer->m_timeBufferData.gameTime = 0.0f;
+    log_printf("Benchmarking [%s], %u frames at %g fps", path_file, m_bench_path.num_frames, m_bench_path.fps);
+}
+
+void App::init_noise_cache()
+{
+    const char* directory = "Data/Cache/Noise/";
+    int max_mb = 256;
+    ConfigGetString(&directory, CONFIG_NOISE_CACHE_DIRECTORY_NAME);
+    ConfigGetInt(&max_mb, CONFIG_NOISE_CACHE_MAX_MB_NAME);
+
+    if(!volume_cache_init(&m_noise_cache, directory, (uint64_t)max(0, max_mb) * 1024 * 1024)){
+        log_warningf("Couldn't create noise cache directory [%s]", directory);
+    }
+}
+
+// Cache entries carry their mip chain, so they're uploaded straight from the
+// same mapping the CPU copy came out of
+bool App::load_noise_from_cache(cloud_noise_volume_t* noise_volume, RHITexture3D* texture)
+{
+    volume_file_t file;
+    if(!cloud_noise_volume_load_from_cache(noise_volume, m_noise_cache, m_noise_gen_data, &file)){
+        return false;
+    }
+
+    if(!texture->LoadFromVolumeFile(file)){
+        texture->LoadFromVolumeRGBA8(noise_volume->volume);
+    }
+    volume_file_close(&file);
+    return true;
+}
+
+// Cached bake for the current params if there is one, otherwise the shipped volume.
+// <fallback_name> has no extension, a .vol is preferred over the old headerless .dat.
+void App::load_noise_volume(cloud_noise_volume_t* noise_volume, RHITexture3D* texture, const char* fallback_name)
+{
+    if(load_noise_from_cache(noise_volume, texture)){
+        log_printf("Loaded %s noise from cache", cloud_noise_get_type_name(noise_volume->type));
+        return;
+    }
+
+    std::string volume_filename = std::string(fallback_name) + VOLUME_FILE_EXTENSION;
+    if(texture->LoadFromVolumeFile(volume_filename.c_str())){
+        return;
+    }
+
+    const volume_buffer_t& volume = noise_volume->volume;
+    std::string raw_filename = std::string(fallback_name) + ".dat";
+    texture->LoadFromFilenameRGBA8(raw_filename.c_str(), volume.width, volume.height, volume.depth);
 }
 
 void App::init_sliders()
@@ -278,73 +423,13 @@ void App::init_sliders()
 void App::init_vis_settings()
 {
     // DEFAULTS
-    // Setup initial noise generation data
-    m_noise_gen_data.start_slice                        = 0;
-    m_noise_gen_data.worley_scale                       = 0.10f;
-    m_noise_gen_data.worley_num_octaves                 = 4;
-    m_noise_gen_data.worley_octave_persistence          = 0.5f;
-    m_noise_gen_data.worley_octave_scale                = 2.0f;
-    m_noise_gen_data.perlin_scale                       = 12.5f;
-    m_noise_gen_data.perlin_num_octaves                 = 4;
-    m_noise_gen_data.perlin_octave_persistence          = 2.0f;
-    m_noise_gen_data.perlin_octave_scale                = 0.5f;
-
-    m_noise_gen_data.worley_one_scale                   = 0.15f;
-    m_noise_gen_data.worley_two_scale                   = 0.25f;
-    m_noise_gen_data.worley_three_scale                 = 0.35f;
-    m_noise_gen_data.worley_only_num_octaves            = 4;
-    m_noise_gen_data.worley_only_octave_persistence     = 0.5f;
-    m_noise_gen_data.worley_only_octave_scale           = 2.0f;
-
-    m_noise_gen_data.detail_worley_one_scale            = 1.5f;
-    m_noise_gen_data.detail_worley_two_scale            = 2.5f;
-    m_noise_gen_data.detail_worley_three_scale          = 3.5f;
-    m_noise_gen_data.detail_worley_num_octaves          = 4;
-    m_noise_gen_data.detail_worley_octave_persistence   = 0.5f;
-    m_noise_gen_data.detail_worley_octave_scale         = 2.0f;
-
-    m_noise_gen_data.generation_all_scale               = 1.0f;
-    m_noise_gen_data.generation_z_scale                 = 50.0f;
+    cloud_noise_gen_set_defaults(&m_noise_gen_data);
 
     // Setup initial cloud data
-    m_cloud_data.scale                                  = 0.000025f;
-    m_cloud_data.coverage                               = 0.585002170f;
-    m_cloud_data.cloud_layer_top_y                      = 6000.f;
-    m_cloud_data.cloud_layer_bottom_y                   = 4500.f;
-    m_cloud_data.sun_position                           = Vector3(10000000.0f, 1000000.0f, 10000000.0f);
-    m_cloud_data.light_step_size                        = 100.0f;
-    m_cloud_data.detail_scale                           = 0.00005f;
-    m_cloud_data.stratus_grad                           = Vector4(0.05f, 0.08f, 0.14f, 0.16f);
-    m_cloud_data.cumulus_grad                           = Vector4(0.05f, 0.20f, 0.50f, 0.65f);
-    m_cloud_data.cumulonumbis_grad                      = Vector4(0.05f, 0.15f, 0.8f, 0.9f);
-    m_cloud_data.wind                                   = Vector4(0.0f, 0.0f, 1.0f, 0.f);
+    cloud_parameters_set_defaults(&m_cloud_data);
 
     // LOAD FROM CONFIG
-    ConfigGetFloat(&m_noise_gen_data.worley_scale, "base_worley_scale");
-    ConfigGetInt((int*)&m_noise_gen_data.worley_num_octaves, "base_worley_num_octaves");
-    ConfigGetFloat(&m_noise_gen_data.worley_octave_persistence, "base_worley_octave_persistence");
-    ConfigGetFloat(&m_noise_gen_data.worley_octave_scale, "base_worley_octave_scale");
-
-    ConfigGetFloat(&m_noise_gen_data.perlin_scale, "base_perlin_scale");
-    ConfigGetInt((int*)&m_noise_gen_data.perlin_num_octaves, "base_perlin_num_octaves");
-    ConfigGetFloat(&m_noise_gen_data.perlin_octave_persistence, "base_perlin_octave_persistence");
-    ConfigGetFloat(&m_noise_gen_data.perlin_octave_scale, "base_perlin_octave_scale");
-    ConfigGetFloat(&m_noise_gen_data.generation_all_scale,"generation_xyz_scale");
-    ConfigGetFloat(&m_noise_gen_data.generation_z_scale,"generation_z_scale");
-
-    ConfigGetFloat(&m_noise_gen_data.worley_one_scale, "base_worley_one_scale");
-    ConfigGetFloat(&m_noise_gen_data.worley_two_scale, "base_worley_two_scale");
-    ConfigGetFloat(&m_noise_gen_data.worley_three_scale,"base_worley_three_scale");
-    ConfigGetInt((int*)&m_noise_gen_data.worley_only_num_octaves,"base_fbm_worley_scale");
-    ConfigGetFloat(&m_noise_gen_data.worley_only_octave_persistence, "base_fbm_worley_octave_persistence");
-    ConfigGetFloat(&m_noise_gen_data.worley_only_octave_scale, "base_fbm_worley_octave_scale");
-
-    ConfigGetFloat(&m_noise_gen_data.detail_worley_one_scale, "detail_worley_one_scale");
-    ConfigGetFloat(&m_noise_gen_data.detail_worley_two_scale, "detail_worley_two_scale");
-    ConfigGetFloat(&m_noise_gen_data.detail_worley_three_scale, "detail_worley_three_scale");
-    ConfigGetInt((int*)&m_noise_gen_data.detail_worley_num_octaves, "detail_worley_num_octaves");
-    ConfigGetFloat(&m_noise_gen_data.detail_worley_octave_persistence, "detail_worley_octave_peristence");
-    ConfigGetFloat(&m_noise_gen_data.detail_worley_octave_scale, "detail_worley_octave_scale");
+    cloud_noise_gen_load_from_config(&m_noise_gen_data);
 
     ConfigGetFloat(&m_cloud_data.scale, "cloud_sample_scale");
     ConfigGetFloat(&m_cloud_data.coverage, "cloud_coverage");
@@ -359,6 +444,9 @@ void App::InitRendering()
 	// load up config options
 	ConfigGetRgba(&m_clear_color, CONFIG_CLEAR_COLOR_NAME);
 	ConfigGetFloat(&m_viewFov, CONFIG_FOV_NAME);
+	ConfigGetFloat(&m_noise_regen_budget_ms, CONFIG_NOISE_REGEN_BUDGET_NAME);
+	ConfigGetBool(&m_use_weather_map, CONFIG_WEATHER_MAP_NAME);
+	ConfigGetFloat(&m_weather_budget_ms, CONFIG_WEATHER_MAP_BUDGET_NAME);
 
 	m_appFont = g_theRenderer->m_device->CreateFontFromFile(APP_FONT);
 
@@ -414,6 +502,10 @@ void App::OnLostFocus()
 
 void App::RunFrame()
 {
+    if(m_is_benchmarking){
+        cloud_bench_begin_frame(&m_bench_recorder);
+    }
+
 	BeginFrame();
 
 	if(!g_theRenderer->m_output->IsOpen()){
@@ -425,10 +517,23 @@ void App::RunFrame()
 	Render();
 
 	EndFrame();
+
+    if(m_is_benchmarking){
+        cloud_bench_end_frame(&m_bench_recorder);
+        ++m_bench_frame;
+        if(m_bench_frame == m_bench_path.num_frames){
+            if(cloud_bench_write_json(m_bench_recorder, m_bench_path, m_bench_out)){
+                log_printf("Benchmark done, wrote [%s]", m_bench_out);
+            }
+            SetIsQuitting(true);
+        }
+    }
 }
 
 void App::BeginFrame()
 {
+    cloud_bench_scope_t bench_scope(get_bench_recorder(), "begin_frame");
+
 	StepTime();
 
 	g_theInputSystem->BeginFrame();
@@ -454,6 +559,15 @@ void App::BeginFrame()
 
 	g_theRenderer->m_output->ProcessMessages();
 	g_theRenderer->Update(m_deltaSeconds);
+
+    // The path owns the clock and the board, whatever the MIDI device says
+    if(m_is_benchmarking){
+        g_theRenderer->m_timeBufferData.gameTime = cloud_bench_get_frame_seconds(m_bench_path, m_bench_frame);
+        memcpy(g_theRenderer->m_midiData.knobs, m_bench_path.knobs, sizeof(m_bench_path.knobs));
+        memcpy(g_theRenderer->m_midiData.sliders, m_bench_path.sliders, sizeof(m_bench_path.sliders));
+        g_theRenderer->m_timeBuffer->Update(g_theRenderer->m_deviceContext, &g_theRenderer->m_timeBufferData);
+        g_theRenderer->m_midiBuffer->Update(g_theRenderer->m_deviceContext, &g_theRenderer->m_midiData);
+    }
 }
 
 void App::Update(float deltaSeconds)
@@ -462,7 +576,14 @@ void App::Update(float deltaSeconds)
 		SetIsQuitting(true);
 	}
 
-	g_theGame->Update(deltaSeconds);
+    {
+        cloud_bench_scope_t bench_scope(get_bench_recorder(), "game");
+        if(m_is_benchmarking){
+            update_bench_camera();
+        }else{
+            g_theGame->Update(deltaSeconds);
+        }
+    }
 
     float focal_length = 1.0f / TanDegrees(m_viewFov / 2.0f); 
 
@@ -506,27 +627,38 @@ void App::Update(float deltaSeconds)
         }
     }
 
-	Vector4 s = Vector4(0.0f, 0.0f, 1.0f, 0.0f);
+	m_cloud_data.sun_position = cloud_raymarch_get_sun_position(m_sun_pos);
 
-	float rot_degs = MapFloatToRange(m_sun_pos, 0.0f, 1.0f, 0.0f, -180.0f);
-	Matrix4 rot = Matrix4::make_rotation_x_degrees(rot_degs);
-
-	Vector4 new_sun_dir = s * rot;
-	new_sun_dir *= 1000000.0f;
+    {
+        cloud_bench_scope_t bench_scope(get_bench_recorder(), "sliders");
+        m_base_perlin_worley_slider->update(deltaSeconds);
+        m_base_fbm_worley_slider->update(deltaSeconds);
+        m_detail_noise_slider->update(deltaSeconds);
+        m_cloud_settings_slider->update(deltaSeconds);
+        m_perlin_worley_r->update(deltaSeconds);
+        m_perlin_worley_g->update(deltaSeconds);
+        m_perlin_worley_b->update(deltaSeconds);
+        m_perlin_worley_a->update(deltaSeconds);
+    }
 
-	m_cloud_data.sun_position = new_sun_dir.xyz;
+    {
+        cloud_bench_scope_t bench_scope(get_bench_recorder(), "noise_regen");
 
-    m_base_perlin_worley_slider->update(deltaSeconds);
-    m_base_fbm_worley_slider->update(deltaSeconds);
-    m_detail_noise_slider->update(deltaSeconds);
-    m_cloud_settings_slider->update(deltaSeconds);
-    m_perlin_worley_r->update(deltaSeconds);
-    m_perlin_worley_g->update(deltaSeconds);
-    m_perlin_worley_b->update(deltaSeconds);
-    m_perlin_worley_a->update(deltaSeconds);
+        // Volumes regenerating at the same time split the budget
+        unsigned int num_regenerating = (m_base_noise_volume.is_regenerating ? 1 : 0) + (m_detail_noise_volume.is_regenerating ? 1 : 0);
+        float regen_budget_ms = m_noise_regen_budget_ms / (float)max(1U, num_regenerating);
+        update_noise_regen(&m_base_noise_volume, m_cloud_base, &m_regen_base_noise, regen_budget_ms);
+        update_noise_regen(&m_detail_noise_volume, m_cloud_detail, &m_regen_detail_noise, regen_budget_ms);
+    }
 
     m_cloud_data.focal_length = focal_length;
     m_cloud_data.transform = g_theGame->m_camera->GetWorldTransform();
+    {
+        cloud_bench_scope_t bench_scope(get_bench_recorder(), "weather");
+        update_weather_map();
+    }
+
+    cloud_bench_scope_t bench_scope(get_bench_recorder(), "constant_buffers");
     m_cloud_data_buffer->Update(g_theRenderer->m_deviceContext, &m_cloud_data);
 
     m_noise_gen_parameters_buffer->Update(g_theRenderer->m_deviceContext, &m_noise_gen_data);
@@ -534,6 +666,8 @@ void App::Update(float deltaSeconds)
 
 void App::Render()
 {
+    cloud_bench_scope_t bench_scope(get_bench_recorder(), "render");
+
 	g_theRenderer->SetColorTarget(nullptr, nullptr);
 	//g_theRenderer->ClearColor(m_clear_color);
 	g_theRenderer->ClearColor(Rgba(126, 192, 238, 255));
@@ -543,14 +677,6 @@ void App::Render()
 	int windowHeight = g_theRenderer->m_output->GetHeight();
 	g_theRenderer->SetViewport(0, 0, windowWidth, windowHeight);
 
-    if(m_regen_base_noise){
-        //render_regen_base_noise();
-    }
-    
-    if(m_regen_detail_noise){
-        //render_regen_detail_noise();
-    }
-
     render_clouds();
 
 	g_theRenderer->SetView(g_theGame->m_camera->GetViewTransform());
@@ -574,9 +700,94 @@ void App::Render()
 
 	console_render();
 
+    cloud_bench_scope_t present_scope(get_bench_recorder(), "present");
 	g_theRenderer->Present();
 }
 
+void App::save_noise_volume_to_cache(cloud_noise_volume_t* noise_volume, RHITexture3D* texture)
+{
+    const char* name = cloud_noise_get_type_name(noise_volume->type);
+    if(noise_volume->is_regenerating){
+        console_warning("%s noise is still regenerating, not cached", name);
+        return;
+    }
+
+    // Whatever is on screen may predate the current params, make sure what gets cached matches them
+    if(cloud_noise_volume_update(noise_volume, m_noise_gen_data) != 0){
+        texture->LoadFromVolumeRGBA8(noise_volume->volume);
+    }
+
+    if(cloud_noise_volume_save_to_cache(*noise_volume, m_noise_cache)){
+        const volume_buffer_t& volume = noise_volume->volume;
+        uint64_t key = cloud_noise_get_cache_key(noise_volume->type, noise_volume->baked_params, volume.width, volume.height, volume.depth);
+        console_success("%s noise saved to %s", name, volume_cache_get_path(m_noise_cache, key).c_str());
+    }else{
+        console_error("Failed to cache %s noise", name);
+    }
+}
+
+// Only the channels fed by parameters that changed since the last regen get rebaked
+void App::regen_noise_volume(cloud_noise_volume_t* noise_volume, RHITexture3D* texture)
+{
+    if(load_noise_from_cache(noise_volume, texture)){
+        log_printf("Regen %s noise: loaded from cache", cloud_noise_get_type_name(noise_volume->type));
+        return;
+    }
+
+    volume_fill_stats_t stats;
+    unsigned int channels = cloud_noise_volume_update(noise_volume, m_noise_gen_data, 0, &stats);
+    if(channels == 0){
+        log_printf("Regen %s noise: nothing changed", cloud_noise_get_type_name(noise_volume->type));
+        return;
+    }
+
+    texture->LoadFromVolumeRGBA8(noise_volume->volume);
+    cloud_noise_volume_save_to_cache(*noise_volume, m_noise_cache);
+    log_printf("Regen %s noise: channels %s%s%s%s in %.2f ms", 
+        cloud_noise_get_type_name(noise_volume->type),
+        (channels & CLOUD_NOISE_CHANNEL_R) ? "R" : "",
+        (channels & CLOUD_NOISE_CHANNEL_G) ? "G" : "",
+        (channels & CLOUD_NOISE_CHANNEL_B) ? "B" : "",
+        (channels & CLOUD_NOISE_CHANNEL_A) ? "A" : "",
+        stats.seconds * 1000.0);
+}
+
+// The texture keeps showing the old noise until the regen swaps the new volume in.
+// A request made mid-regen waits and picks up whatever changed in the meantime.
+void App::update_noise_regen(cloud_noise_volume_t* noise_volume, RHITexture3D* texture, bool* regen_requested, float budget_ms)
+{
+    const char* name = cloud_noise_get_type_name(noise_volume->type);
+
+    if(*regen_requested && !noise_volume->is_regenerating){
+        *regen_requested = false;
+
+        if(m_noise_regen_budget_ms <= 0.0f){
+            regen_noise_volume(noise_volume, texture);
+            return;
+        }
+
+        // Going back to a setting that was baked before is just a load
+        if(load_noise_from_cache(noise_volume, texture)){
+            console_info("regen %s noise: loaded from cache", name);
+            return;
+        }
+
+        if(!cloud_noise_volume_begin_regen(noise_volume, m_noise_gen_data)){
+            log_printf("Regen %s noise: nothing changed", name);
+            return;
+        }
+        console_info("regen %s noise: %u bricks at %.2f ms/frame", name, noise_volume->regen_task.num_bricks, m_noise_regen_budget_ms);
+    }
+
+    if(cloud_noise_volume_step_regen(noise_volume, budget_ms)){
+        texture->LoadFromVolumeRGBA8(noise_volume->volume);
+        cloud_noise_volume_save_to_cache(*noise_volume, m_noise_cache);
+
+        const volume_fill_task_t& task = noise_volume->regen_task;
+        console_success("regen %s noise: done in %.2f s over %u frames (%.2f ms of work)", name, get_current_time_seconds() - task.start_seconds, task.num_steps, task.step_seconds * 1000.0);
+    }
+}
+
 void App::render_regen_base_noise()
 {
     g_theRenderer->SetTexture(0, nullptr);
@@ -648,6 +859,49 @@ void App::render_regen_detail_noise()
     g_theRenderer->SetColorTarget();
 }
 
+// Follows the camera and the wind, the texture only gets the strips that changed
+void App::update_weather_map()
+{
+    m_cloud_data.weather_map = Vector4(1.0f / m_weather_map.get_extent(), m_use_weather_map ? 1.0f : 0.0f, 0.0f, 0.0f);
+    if(!m_use_weather_map){
+        return;
+    }
+
+    // What the shader reads the board and clock from
+    cloud_raymarch_params_t params;
+    params.cloud = m_cloud_data;
+    for(unsigned int i = 0; i < CLOUD_MIDI_NUM_CONTROLS; ++i){
+        params.knobs[i] = g_theRenderer->m_midiData.knobs[i];
+        params.sliders[i] = g_theRenderer->m_midiData.sliders[i];
+    }
+    params.game_time = g_theRenderer->m_timeBufferData.gameTime;
+
+    const Vector3& camera_pos = g_theGame->m_camera->m_position;
+    cloud_weather_update(&m_weather_map, params, camera_pos.x, camera_pos.z, m_weather_budget_ms);
+
+    for(const cloud_weather_rect_t& rect : m_weather_map.updated_rects){
+        const unsigned char* texels = m_weather_map.texels.get_voxel((unsigned int)rect.min_x, (unsigned int)rect.min_z, 0);
+        m_weather_texture->UpdateRegionRGBA8((unsigned int)rect.min_x, (unsigned int)rect.min_z, (unsigned int)(rect.max_x - rect.min_x), (unsigned int)(rect.max_z - rect.min_z),
+            texels, m_weather_map.texels.get_row_pitch());
+    }
+    m_weather_map.updated_rects.clear();
+}
+
+// Puts the camera and sun where the path has them this frame, instead of the mouse and keys
+void App::update_bench_camera()
+{
+    cloud_bench_key_t key = cloud_bench_get_key(m_bench_path, cloud_bench_get_frame_seconds(m_bench_path, m_bench_frame));
+
+    Camera3d* camera = g_theGame->m_camera;
+    camera->m_position = key.position;
+    camera->m_yawDegreesAboutY = key.yaw_degrees;
+    camera->m_pitchDegreesAboutX = key.pitch_degrees;
+    camera->m_rollDegreesAboutZ = 0.0f;
+    camera->m_rotation = Matrix4::make_rotation_x_degrees(key.pitch_degrees) * Matrix4::make_rotation_y_degrees(key.yaw_degrees);
+
+    m_sun_pos = key.sun_pos;
+}
+
 void App::render_clouds()
 {
     g_theRenderer->EnableDepth(true, true);
@@ -661,6 +915,7 @@ void App::render_clouds()
 	g_theRenderer->SetOrthoProjection(AABB2::ZERO_TO_ONE);
     g_theRenderer->m_deviceContext->SetTexture(0, m_cloud_base);
     g_theRenderer->m_deviceContext->SetTexture(1, m_cloud_detail);
+    g_theRenderer->m_deviceContext->SetTexture(2, m_weather_texture);
     g_theRenderer->SetShaderProgram(m_clouds_shader);
     g_theRenderer->DrawQuad2d(AABB2::ZERO_TO_ONE);
 
@@ -674,7 +929,10 @@ void App::EndFrame()
 		g_theInputSystem->EndFrame();
 	}
 
-	BurnLeftOverFrameTime();
+    // Waiting out the frame would only time the limiter
+    if(!m_is_benchmarking){
+        BurnLeftOverFrameTime();
+    }
 }
 
 void App::StepTime()
@@ -683,6 +941,9 @@ void App::StepTime()
 
 	m_deltaSeconds = (float)(timeNowSeconds - m_timeOfLastFrameSeconds);
 	m_deltaSeconds = Min(m_deltaSeconds, 0.1f); // Cap delta seconds to a tenth of a second
+    if(m_is_benchmarking){
+        m_deltaSeconds = 1.0f / m_bench_path.fps;
+    }
 
 	m_timeOfLastFrameSeconds = timeNowSeconds;
 }
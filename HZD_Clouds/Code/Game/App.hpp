@@ -1,6 +1,10 @@
 #pragma once
 
 #include "Game/slider_group.h"
+#include "Game/cloud_bench.h"
+#include "Game/cloud_noise_gen.h"
+#include "Game/cloud_parameters.h"
+#include "Game/cloud_weather.h"
 
 #include "Engine/Core/Window.hpp"
 #include "Engine/Renderer/SimpleRenderer.hpp"
@@ -11,63 +15,7 @@ class Font;
 class ShaderProgram;
 class ConstantBuffer;
 class RHITexture3D;
-
-struct cloud_parameters_data_t
-{
-    Matrix4     transform;
-
-    float       focal_length;
-    float       scale;
-    float       coverage;
-    float       cloud_layer_top_y;
-
-    float       cloud_layer_bottom_y;
-    Vector3     sun_position;
-
-    float       light_step_size;
-    float       detail_scale;
-    Vector2     padding;
-
-    Vector4     stratus_grad;
-    Vector4     cumulus_grad;
-    Vector4     cumulonumbis_grad;
-    Vector4     wind;
-};
-
-struct noise_gen_paramters_data_t
-{
-    unsigned int    start_slice;
-    float           worley_scale;
-    unsigned int    worley_num_octaves;
-    float           worley_octave_persistence;
-
-    float           worley_octave_scale;
-    float           perlin_scale;
-    unsigned int    perlin_num_octaves;
-    float           perlin_octave_persistence;
-
-    float           perlin_octave_scale;
-    float           worley_one_scale;
-    float           worley_two_scale;
-    float           worley_three_scale;
-
-    unsigned int    worley_only_num_octaves;
-    float           worley_only_octave_persistence;
-    float           worley_only_octave_scale;
-    float           detail_worley_one_scale;
-
-    float           detail_worley_two_scale;
-    float           detail_worley_three_scale;
-    unsigned int    detail_worley_num_octaves;
-    float           detail_worley_octave_persistence;
-
-    float           detail_worley_octave_scale;
-    float           generation_all_scale;
-    float           generation_z_scale;
-    float           padding;
-
-    Vector4         view_mask;
-};
+class RHITexture2D;
 
 class App
 {
@@ -99,6 +47,10 @@ public:
     RHITexture3D*       m_cloud_base;
     RHITexture3D*       m_cloud_detail;
 
+    cloud_noise_volume_t    m_base_noise_volume;
+    cloud_noise_volume_t    m_detail_noise_volume;
+    volume_cache_t          m_noise_cache;
+
     SliderGroup*        m_base_perlin_worley_slider;
     SliderGroup*        m_base_fbm_worley_slider;
     SliderGroup*        m_detail_noise_slider;
@@ -111,6 +63,12 @@ public:
 
     bool                m_regen_base_noise;
     bool                m_regen_detail_noise;
+    float               m_noise_regen_budget_ms; // per frame, 0 regens in one blocking go
+
+    cloud_weather_map_t m_weather_map;
+    RHITexture2D*       m_weather_texture;
+    bool                m_use_weather_map;
+    float               m_weather_budget_ms;    // per frame for strips the camera and wind expose, 0 bakes them right away
 
     bool                m_render_sliders_overlap;
     bool                m_force_show_mouse;
@@ -118,13 +76,24 @@ public:
 	float				m_sun_pos;
 	float				m_sun_distance;
 
+    // Set by the bench_path config key, runs the path at a fixed step and quits
+    bool                    m_is_benchmarking;
+    cloud_bench_path_t      m_bench_path;
+    cloud_bench_recorder_t  m_bench_recorder;
+    unsigned int            m_bench_frame;
+    const char*             m_bench_out;
+
 public:
 	App();
 	~App();
 
     void init();
     void init_vis_settings();
+    void init_noise_cache();
+    bool load_noise_from_cache(cloud_noise_volume_t* noise_volume, RHITexture3D* texture);
+    void load_noise_volume(cloud_noise_volume_t* noise_volume, RHITexture3D* texture, const char* fallback_name);
     void init_sliders();
+    void init_bench();
 	void InitRendering();
 
 	void Run();
@@ -155,7 +124,13 @@ public:
 	void BurnLeftOverFrameTime();
 
 public:
+    void save_noise_volume_to_cache(cloud_noise_volume_t* noise_volume, RHITexture3D* texture);
+    void regen_noise_volume(cloud_noise_volume_t* noise_volume, RHITexture3D* texture);
+    void update_noise_regen(cloud_noise_volume_t* noise_volume, RHITexture3D* texture, bool* regen_requested, float budget_ms);
     void render_regen_base_noise();
     void render_regen_detail_noise();
+    void update_weather_map();
     void render_clouds();
+    void update_bench_camera();
+    cloud_bench_recorder_t* get_bench_recorder() { return m_is_benchmarking ? &m_bench_recorder : nullptr; }
 };
\ No newline at end of file
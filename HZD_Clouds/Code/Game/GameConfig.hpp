@@ -16,4 +16,11 @@ static const char*	CONFIG_RESOLUTION_HEIGHT_NAME	= "resolutionHeight";
 static const char*	CONFIG_CLEAR_COLOR_NAME			= "clearColor";
 static const char*	CONFIG_LIMIT_FPS_NAME			= "limitFPS";
 static const char*	CONFIG_FPS_NAME					= "fps";
-static const char*	CONFIG_FOV_NAME					= "fov";
\ No newline at end of file
+static const char*	CONFIG_FOV_NAME					= "fov";
+static const char*	CONFIG_NOISE_REGEN_BUDGET_NAME	= "noise_regen_budget_ms";
+static const char*	CONFIG_WEATHER_MAP_NAME			= "weather_map";
+static const char*	CONFIG_WEATHER_MAP_BUDGET_NAME	= "weather_map_budget_ms";
+static const char*	CONFIG_NOISE_CACHE_DIRECTORY_NAME	= "noise_cache_directory";
+static const char*	CONFIG_NOISE_CACHE_MAX_MB_NAME		= "noise_cache_max_mb";
+static const char*	CONFIG_BENCH_PATH_NAME			= "bench_path";
+static const char*	CONFIG_BENCH_OUT_NAME			= "bench_out";
\ No newline at end of file
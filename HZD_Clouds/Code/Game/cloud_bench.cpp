@@ -0,0 +1,392 @@
+#include "Game/cloud_bench.h"
+
+#include "Engine/Core/FileUtils.hpp"
+#include "Engine/Core/Time.hpp"
+#include "Engine/Core/crt_compat.h"
+#include "Engine/Core/log.h"
+
+#include <algorithm>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+//-----------------------------------------------------
+// Internal helpers
+
+#define MAX_LINE_TOKENS     8
+
+// Splits on spaces and tabs in place, stopping at a comment
+static unsigned int tokenize_line(char* line, char** out_tokens)
+{
+    unsigned int num_tokens = 0;
+    char* c = line;
+    while(*c != '\0'){
+        while((*c == ' ') || (*c == '\t') || (*c == '\r')){
+            *c++ = '\0';
+        }
+        if((*c == '\0') || (*c == '#')){
+            *c = '\0';
+            break;
+        }
+        if(num_tokens == MAX_LINE_TOKENS){
+            return MAX_LINE_TOKENS + 1;
+        }
+        out_tokens[num_tokens++] = c;
+        while((*c != '\0') && (*c != ' ') && (*c != '\t') && (*c != '\r') && (*c != '#')){
+            ++c;
+        }
+        if(*c == '#'){
+            *c = '\0';
+            break;
+        }
+    }
+    return num_tokens;
+}
+
+static bool parse_float(const char* token, float* out_value)
+{
+    char* end;
+    *out_value = strtof(token, &end);
+    return (end != token) && (*end == '\0');
+}
+
+// The constant buffer fields a path can set and how many floats each takes
+static float* get_cloud_field(cloud_parameters_data_t* cloud, const char* name, unsigned int* out_count)
+{
+    struct field_t
+    {
+        const char*     name;
+        float*          value;
+        unsigned int    count;
+    };
+    const field_t fields[] = {
+        { "scale",                  &cloud->scale,                  1 },
+        { "coverage",               &cloud->coverage,               1 },
+        { "cloud_layer_top_y",      &cloud->cloud_layer_top_y,      1 },
+        { "cloud_layer_bottom_y",   &cloud->cloud_layer_bottom_y,   1 },
+        { "light_step_size",        &cloud->light_step_size,        1 },
+        { "detail_scale",           &cloud->detail_scale,           1 },
+        { "stratus_grad",           &cloud->stratus_grad.x,         4 },
+        { "cumulus_grad",           &cloud->cumulus_grad.x,         4 },
+        { "cumulonumbis_grad",      &cloud->cumulonumbis_grad.x,    4 },
+        { "wind",                   &cloud->wind.x,                 4 },
+    };
+    for(const field_t& field : fields){
+        if(strcmp(field.name, name) == 0){
+            *out_count = field.count;
+            return field.value;
+        }
+    }
+    return nullptr;
+}
+
+// One line of a path file, false if it's malformed
+static bool parse_path_line(cloud_bench_path_t* path, char** tokens, unsigned int num_tokens, bool* out_has_frames)
+{
+    const char* setting = tokens[0];
+    float values[MAX_LINE_TOKENS];
+    unsigned int first_value = (strcmp(setting, "cloud") == 0) ? 2 : 1;
+    for(unsigned int i = first_value; i < num_tokens; ++i){
+        if(!parse_float(tokens[i], &values[i - first_value])){
+            return false;
+        }
+    }
+    unsigned int num_values = (num_tokens > first_value) ? num_tokens - first_value : 0;
+
+    if(strcmp(setting, "fps") == 0){
+        if(num_values != 1){
+            return false;
+        }
+        path->fps = values[0];
+        return (path->fps > 0.0f);
+    }
+    if(strcmp(setting, "frames") == 0){
+        if(num_values != 1){
+            return false;
+        }
+        path->num_frames = (unsigned int)values[0];
+        *out_has_frames = true;
+        return (values[0] >= 1.0f);
+    }
+    if(strcmp(setting, "fov") == 0){
+        if(num_values != 1){
+            return false;
+        }
+        path->fov_degrees = values[0];
+        return (path->fov_degrees > 0.0f) && (path->fov_degrees < 180.0f);
+    }
+    if((strcmp(setting, "knob") == 0) || (strcmp(setting, "slider") == 0)){
+        if((num_values != 2) || !(values[0] >= 0.0f) || (values[0] >= (float)CLOUD_MIDI_NUM_CONTROLS)){
+            return false;
+        }
+        float* controls = (setting[0] == 'k') ? path->knobs : path->sliders;
+        controls[(unsigned int)values[0]] = values[1];
+        return true;
+    }
+    if(strcmp(setting, "cloud") == 0){
+        unsigned int count = 0;
+        float* field = (num_tokens > 1) ? get_cloud_field(&path->cloud, tokens[1], &count) : nullptr;
+        if((nullptr == field) || (num_values != count)){
+            return false;
+        }
+        memcpy(field, values, count * sizeof(float));
+        return true;
+    }
+    if(strcmp(setting, "key") == 0){
+        if(num_values != 7){
+            return false;
+        }
+        cloud_bench_key_t key;
+        key.seconds         = values[0];
+        key.position        = Vector3(values[1], values[2], values[3]);
+        key.yaw_degrees     = values[4];
+        key.pitch_degrees   = values[5];
+        key.sun_pos         = values[6];
+        if(!path->keys.empty() && !(key.seconds > path->keys.back().seconds)){
+            return false;
+        }
+        path->keys.push_back(key);
+        return true;
+    }
+    return false;
+}
+
+static unsigned int get_scope_index(cloud_bench_recorder_t* recorder, const char* name)
+{
+    for(unsigned int i = 0; i < (unsigned int)recorder->scopes.size(); ++i){
+        if(recorder->scopes[i].name == name){
+            return i;
+        }
+    }
+
+    // Frames before this scope first ran didn't spend anything in it
+    cloud_bench_scope_times_t scope;
+    scope.name = name;
+    scope.current = 0.0;
+    scope.frame_seconds.assign(recorder->frame_seconds.size(), 0.0);
+    recorder->scopes.push_back(scope);
+    return (unsigned int)recorder->scopes.size() - 1;
+}
+
+static void write_summary(FILE* file, const std::vector<double>& seconds)
+{
+    cloud_bench_summary_t summary;
+    cloud_bench_get_summary(seconds, &summary);
+    fprintf(file, "{ \"mean\": %.4f, \"p50\": %.4f, \"p90\": %.4f, \"p95\": %.4f, \"p99\": %.4f, \"max\": %.4f }",
+        summary.mean * 1000.0, summary.p50 * 1000.0, summary.p90 * 1000.0, summary.p95 * 1000.0, summary.p99 * 1000.0, summary.max * 1000.0);
+}
+
+static void write_milliseconds(FILE* file, const std::vector<double>& seconds)
+{
+    fprintf(file, "[");
+    for(size_t i = 0; i < seconds.size(); ++i){
+        fprintf(file, "%s%.4f", (i > 0) ? ", " : "", seconds[i] * 1000.0);
+    }
+    fprintf(file, "]");
+}
+
+//-----------------------------------------------------
+// Public API
+
+cloud_bench_scope_t::cloud_bench_scope_t(cloud_bench_recorder_t* recorder, const char* name)
+    :m_recorder(recorder)
+    ,m_index(0)
+    ,m_start(0.0)
+{
+    if(nullptr != m_recorder){
+        m_index = get_scope_index(m_recorder, name);
+        m_start = get_current_time_seconds();
+    }
+}
+
+cloud_bench_scope_t::~cloud_bench_scope_t()
+{
+    if(nullptr != m_recorder){
+        m_recorder->scopes[m_index].current += get_current_time_seconds() - m_start;
+    }
+}
+
+bool cloud_bench_load_path(cloud_bench_path_t* path, const char* filename)
+{
+    path->name = filename;
+    path->keys.clear();
+    path->num_frames    = 0;
+    path->fps           = 60.0f;
+    path->fov_degrees   = 60.0f;
+    cloud_parameters_set_defaults(&path->cloud);
+
+    cloud_raymarch_params_t defaults;
+    cloud_raymarch_set_defaults(&defaults);
+    memcpy(path->knobs, defaults.knobs, sizeof(path->knobs));
+    memcpy(path->sliders, defaults.sliders, sizeof(path->sliders));
+
+    std::vector<std::string> lines;
+    if(!LoadTextFileLinesToBuffer(filename, lines)){
+        log_warningf("Couldn't read benchmark path [%s]", filename);
+        return false;
+    }
+
+    bool has_frames = false;
+    for(size_t i = 0; i < lines.size(); ++i){
+        std::vector<char> line(lines[i].begin(), lines[i].end());
+        line.push_back('\0');
+
+        char* tokens[MAX_LINE_TOKENS];
+        unsigned int num_tokens = tokenize_line(line.data(), tokens);
+        if(num_tokens == 0){
+            continue;
+        }
+        if((num_tokens > MAX_LINE_TOKENS) || !parse_path_line(path, tokens, num_tokens, &has_frames)){
+            log_warningf("Bad line %u in benchmark path [%s]: %s", (unsigned int)i + 1, filename, lines[i].c_str());
+            return false;
+        }
+    }
+
+    if(path->keys.empty()){
+        log_warningf("Benchmark path [%s] has no keys", filename);
+        return false;
+    }
+    if(!has_frames){
+        path->num_frames = (unsigned int)(path->keys.back().seconds * path->fps) + 1;
+    }
+    return true;
+}
+
+cloud_bench_key_t cloud_bench_get_key(const cloud_bench_path_t& path, float seconds)
+{
+    const std::vector<cloud_bench_key_t>& keys = path.keys;
+    if(seconds <= keys.front().seconds){
+        return keys.front();
+    }
+    if(seconds >= keys.back().seconds){
+        return keys.back();
+    }
+
+    size_t next = 1;
+    while(keys[next].seconds < seconds){
+        ++next;
+    }
+    const cloud_bench_key_t& a = keys[next - 1];
+    const cloud_bench_key_t& b = keys[next];
+    float t = (seconds - a.seconds) / (b.seconds - a.seconds);
+
+    cloud_bench_key_t key;
+    key.seconds         = seconds;
+    key.position        = a.position + ((b.position - a.position) * t);
+    key.yaw_degrees     = a.yaw_degrees + ((b.yaw_degrees - a.yaw_degrees) * t);
+    key.pitch_degrees   = a.pitch_degrees + ((b.pitch_degrees - a.pitch_degrees) * t);
+    key.sun_pos         = a.sun_pos + ((b.sun_pos - a.sun_pos) * t);
+    return key;
+}
+
+float cloud_bench_get_frame_seconds(const cloud_bench_path_t& path, unsigned int frame)
+{
+    return (float)((double)frame / (double)path.fps);
+}
+
+void cloud_bench_get_params(const cloud_bench_path_t& path, unsigned int frame, cloud_raymarch_params_t* out_params)
+{
+    float seconds = cloud_bench_get_frame_seconds(path, frame);
+    cloud_bench_key_t key = cloud_bench_get_key(path, seconds);
+
+    *out_params = cloud_raymarch_params_t();
+    out_params->cloud = path.cloud;
+    cloud_raymarch_set_camera(out_params, key.position, key.yaw_degrees, key.pitch_degrees, path.fov_degrees);
+    out_params->cloud.sun_position = cloud_raymarch_get_sun_position(key.sun_pos);
+    memcpy(out_params->knobs, path.knobs, sizeof(out_params->knobs));
+    memcpy(out_params->sliders, path.sliders, sizeof(out_params->sliders));
+    out_params->game_time = seconds;
+}
+
+void cloud_bench_begin_frame(cloud_bench_recorder_t* recorder)
+{
+    for(cloud_bench_scope_times_t& scope : recorder->scopes){
+        scope.current = 0.0;
+    }
+    recorder->frame_start = get_current_time_seconds();
+}
+
+void cloud_bench_end_frame(cloud_bench_recorder_t* recorder)
+{
+    recorder->frame_seconds.push_back(get_current_time_seconds() - recorder->frame_start);
+    for(cloud_bench_scope_times_t& scope : recorder->scopes){
+        scope.frame_seconds.push_back(scope.current);
+        scope.current = 0.0;
+    }
+}
+
+void cloud_bench_get_summary(const std::vector<double>& seconds, cloud_bench_summary_t* out_summary)
+{
+    memset(out_summary, 0, sizeof(*out_summary));
+    if(seconds.empty()){
+        return;
+    }
+
+    std::vector<double> sorted = seconds;
+    std::sort(sorted.begin(), sorted.end());
+
+    double total = 0.0;
+    for(double value : sorted){
+        total += value;
+    }
+
+    // Nearest rank, the smallest value at least <percent> of the samples are under or at
+    size_t count = sorted.size();
+    auto get_percentile = [&](double percent) -> double {
+        size_t rank = (size_t)ceil(percent / 100.0 * (double)count);
+        return sorted[(rank > 0) ? rank - 1 : 0];
+    };
+
+    out_summary->mean   = total / (double)count;
+    out_summary->p50    = get_percentile(50.0);
+    out_summary->p90    = get_percentile(90.0);
+    out_summary->p95    = get_percentile(95.0);
+    out_summary->p99    = get_percentile(99.0);
+    out_summary->max    = sorted.back();
+}
+
+bool cloud_bench_write_json(const cloud_bench_recorder_t& recorder, const cloud_bench_path_t& path, const char* filename)
+{
+    FILE* file;
+    errno_t error_code = fopen_s(&file, filename, "w");
+    if(error_code != 0){
+        log_warningf("Couldn't write benchmark results [%s]", filename);
+        return false;
+    }
+
+    // The path name is a file name, only backslashes need escaping
+    std::string name;
+    for(char c : path.name){
+        name += c;
+        if(c == '\\'){
+            name += c;
+        }
+    }
+
+    fprintf(file, "{\n");
+    fprintf(file, "  \"path\": \"%s\",\n", name.c_str());
+    fprintf(file, "  \"fps\": %g,\n", path.fps);
+    fprintf(file, "  \"frames\": %u,\n", (unsigned int)recorder.frame_seconds.size());
+    fprintf(file, "  \"units\": \"ms\",\n");
+
+    fprintf(file, "  \"summary\": {\n    \"frame\": ");
+    write_summary(file, recorder.frame_seconds);
+    for(const cloud_bench_scope_times_t& scope : recorder.scopes){
+        fprintf(file, ",\n    \"%s\": ", scope.name.c_str());
+        write_summary(file, scope.frame_seconds);
+    }
+    fprintf(file, "\n  },\n");
+
+    fprintf(file, "  \"per_frame\": {\n    \"frame\": ");
+    write_milliseconds(file, recorder.frame_seconds);
+    for(const cloud_bench_scope_times_t& scope : recorder.scopes){
+        fprintf(file, ",\n    \"%s\": ", scope.name.c_str());
+        write_milliseconds(file, scope.frame_seconds);
+    }
+    fprintf(file, "\n  }\n}\n");
+
+    bool is_written = (ferror(file) == 0);
+    fclose(file);
+    return is_written;
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include "Game/cloud_raymarch.h"
+
+#include <string>
+#include <vector>
+
+//-----------------------------------------------------
+// Cloud benchmark
+//
+// Scripted camera paths for timings that repeat from run to run. A path is
+// keyframes of camera position, yaw, pitch and sun, plus the cloud constant
+// buffer, fov and MIDI board, all held fixed. Frame n sits at n / fps
+// seconds whatever the machine does, so every run sees the same frames.
+// Keys are linear in between, yaw included, so a path turning through 360
+// writes 350 then 370 rather than wrapping.
+//
+// The file is text, one setting per line, # to the end of a line a comment:
+//
+//     fps 60
+//     frames 600                      # defaults to the last key's time
+//     fov 60
+//     cloud coverage 0.6              # any cloud_parameters_data_t field, vectors take 4
+//     knob 0 0.025                    # MIDI.KNOB_0
+//     slider 5 0.5
+//     key 0  0 100 0  0 -20  0.25     # seconds, x y z, yaw pitch, sun (App's 0..1)
+//
+// A recorder collects frame times and named scopes inside them, and writes
+// them out as JSON with percentiles. Scopes sum when they run more than once
+// a frame and read 0 for frames they didn't run in. A scope opened inside
+// another counts toward both.
+
+struct cloud_bench_key_t
+{
+    float       seconds;
+    Vector3     position;
+    float       yaw_degrees;
+    float       pitch_degrees;
+    float       sun_pos;
+};
+
+struct cloud_bench_path_t
+{
+    std::string                     name;
+    std::vector<cloud_bench_key_t>  keys;       // by time
+    unsigned int                    num_frames;
+    float                           fps;
+    float                           fov_degrees;
+    cloud_parameters_data_t         cloud;
+    float                           knobs[CLOUD_MIDI_NUM_CONTROLS];
+    float                           sliders[CLOUD_MIDI_NUM_CONTROLS];
+};
+
+struct cloud_bench_scope_times_t
+{
+    std::string             name;
+    double                  current;            // this frame so far
+    std::vector<double>     frame_seconds;
+};
+
+struct cloud_bench_recorder_t
+{
+    double                                  frame_start;
+    std::vector<double>                     frame_seconds;
+    std::vector<cloud_bench_scope_times_t>  scopes;
+
+    cloud_bench_recorder_t()
+        :frame_start(0.0)
+    {}
+};
+
+struct cloud_bench_summary_t
+{
+    double  mean;
+    double  p50;
+    double  p90;
+    double  p95;
+    double  p99;
+    double  max;
+};
+
+// Times the rest of the enclosing block into <recorder>'s <name> scope, nothing with a null recorder
+class cloud_bench_scope_t
+{
+public:
+    cloud_bench_scope_t(cloud_bench_recorder_t* recorder, const char* name);
+    ~cloud_bench_scope_t();
+
+private:
+    cloud_bench_recorder_t*     m_recorder;
+    unsigned int                m_index;
+    double                      m_start;
+};
+
+// Defaults are App's look and camera at 60 fps, what the file doesn't set
+// stays that way. False if the file can't be read or has a bad line, which
+// is logged. A path needs at least one key.
+bool    cloud_bench_load_path(cloud_bench_path_t* path, const char* filename);
+
+// The camera and sun at <seconds>, held at the ends
+cloud_bench_key_t cloud_bench_get_key(const cloud_bench_path_t& path, float seconds);
+float   cloud_bench_get_frame_seconds(const cloud_bench_path_t& path, unsigned int frame);
+
+// What the shader reads for <frame>: the path's constant buffer with the
+// camera and sun filled in, its board, and the game time at that frame
+void    cloud_bench_get_params(const cloud_bench_path_t& path, unsigned int frame, cloud_raymarch_params_t* out_params);
+
+void    cloud_bench_begin_frame(cloud_bench_recorder_t* recorder);
+void    cloud_bench_end_frame(cloud_bench_recorder_t* recorder);
+
+// Nearest rank percentiles, all zero for no samples
+void    cloud_bench_get_summary(const std::vector<double>& seconds, cloud_bench_summary_t* out_summary);
+
+// Per frame and summary milliseconds for the frame and every scope
+bool    cloud_bench_write_json(const cloud_bench_recorder_t& recorder, const cloud_bench_path_t& path, const char* filename);
@@ -0,0 +1,466 @@
+#include "Game/cloud_light.h"
+#include "Game/cloud_weather.h"
+
+#include "Engine/Core/Time.hpp"
+#include "Engine/Core/job.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+//-----------------------------------------------------
+// Internal helpers
+
+// The light cone's sample count, see calc_incident_light
+static const unsigned int NUM_LIGHT_TAPS        = 6;
+
+// Resample once the wind has pushed the noise up this much of a cell
+static const float MAX_WIND_DRIFT_CELLS         = 0.25f;
+
+// Sun moves smaller than this, in degrees, keep the gathered transmittance
+static const float LIGHT_ANGLE_TOLERANCE        = 0.1f;
+
+// A full sample reaches low enough for the center to move this much of the
+// lattice's width away from the planet's axis before the layer curves off the bottom
+static const float PLACEMENT_SLACK              = 0.25f;
+
+static const double INNER_LAYER_RADIUS          = (double)CLOUD_PLANET_RADIUS + CLOUD_LAYER_INNER_HEIGHT;
+
+// A run of lattice points along x, every row of y
+struct light_span_t
+{
+    unsigned int    z;
+    unsigned int    min_x;
+    unsigned int    max_x;
+};
+
+struct light_pass_t
+{
+    cloud_light_volume_t*               light;
+    const cloud_raymarch_params_t*      params;
+    const cloud_raymarch_volumes_t*     volumes;
+    float                               wind_distance;
+    float                               mip_level;
+    Vector3                             light_dir;
+    float                               step_size;
+    std::vector<light_span_t>           spans;
+};
+
+static inline float get_wind_distance(const cloud_raymarch_params_t& params)
+{
+    return params.game_time * (params.knobs[6] * 1000.0f);
+}
+
+static inline Vector3 get_lattice_pos(const cloud_light_volume_t& light, unsigned int x, unsigned int y, unsigned int z)
+{
+    return Vector3((float)(light.origin_x + (int)x) * light.cell_size, light.min_y + ((float)y * light.cell_height), (float)(light.origin_z + (int)z) * light.cell_size);
+}
+
+static inline Vector3 to_cloud_space(const Vector3& world_pos, float wind_distance)
+{
+    float lean = cloud_raymarch_get_height_fraction(world_pos) * CLOUD_WIND_TOP_OFFSET;
+    return Vector3(world_pos.x + wind_distance + lean, world_pos.y, world_pos.z);
+}
+
+// The lean depends on the height fraction, which depends on x through the
+// planet's curve, so the world x is settled in a couple of rounds
+static Vector3 to_world_space(const Vector3& cloud_pos, float wind_distance)
+{
+    Vector3 world_pos(cloud_pos.x - wind_distance, cloud_pos.y, cloud_pos.z);
+    float unleaned_x = world_pos.x;
+    for(unsigned int i = 0; i < 2; ++i){
+        world_pos.x = unleaned_x - (cloud_raymarch_get_height_fraction(world_pos) * CLOUD_WIND_TOP_OFFSET);
+    }
+    return world_pos;
+}
+
+// Fractional lattice coordinates of <cloud_pos>, false off the lattice in xz. y always clamps.
+static bool get_lattice_coords(const cloud_light_volume_t& light, const Vector3& cloud_pos, float* out_coords)
+{
+    float max_x = (float)(light.num_points_x - 1);
+    float max_y = (float)(light.num_points_y - 1);
+    float max_z = (float)(light.num_points_z - 1);
+
+    out_coords[0] = (cloud_pos.x / light.cell_size) - (float)light.origin_x;
+    out_coords[1] = (cloud_pos.y - light.min_y) / light.cell_height;
+    out_coords[2] = (cloud_pos.z / light.cell_size) - (float)light.origin_z;
+
+    bool is_inside = (out_coords[0] >= 0.0f) && (out_coords[0] <= max_x) && (out_coords[2] >= 0.0f) && (out_coords[2] <= max_z);
+
+    out_coords[0] = (out_coords[0] < 0.0f) ? 0.0f : ((out_coords[0] > max_x) ? max_x : out_coords[0]);
+    out_coords[1] = (out_coords[1] < 0.0f) ? 0.0f : ((out_coords[1] > max_y) ? max_y : out_coords[1]);
+    out_coords[2] = (out_coords[2] < 0.0f) ? 0.0f : ((out_coords[2] > max_z) ? max_z : out_coords[2]);
+    return is_inside;
+}
+
+// Coordinates already clamped, every axis has at least two points
+static float read_trilinear(const cloud_light_volume_t& light, const std::vector<float>& values, const float* coords)
+{
+    unsigned int x0 = (unsigned int)coords[0];
+    unsigned int y0 = (unsigned int)coords[1];
+    unsigned int z0 = (unsigned int)coords[2];
+    x0 = (x0 + 1 < light.num_points_x) ? x0 : light.num_points_x - 2;
+    y0 = (y0 + 1 < light.num_points_y) ? y0 : light.num_points_y - 2;
+    z0 = (z0 + 1 < light.num_points_z) ? z0 : light.num_points_z - 2;
+
+    float fx = coords[0] - (float)x0;
+    float fy = coords[1] - (float)y0;
+    float fz = coords[2] - (float)z0;
+
+    size_t row = light.num_points_x;
+    size_t slice = row * light.num_points_y;
+    const float* v = values.data() + light.get_index(x0, y0, z0);
+
+    float c00 = v[0] + ((v[1] - v[0]) * fx);
+    float c10 = v[row] + ((v[row + 1] - v[row]) * fx);
+    float c01 = v[slice] + ((v[slice + 1] - v[slice]) * fx);
+    float c11 = v[slice + row] + ((v[slice + row + 1] - v[slice + row]) * fx);
+
+    float c0 = c00 + ((c10 - c00) * fy);
+    float c1 = c01 + ((c11 - c01) * fy);
+    return c0 + ((c1 - c0) * fz);
+}
+
+static void sample_span(unsigned int span_index, void* user_data)
+{
+    light_pass_t* pass = (light_pass_t*)user_data;
+    cloud_light_volume_t& light = *pass->light;
+    const light_span_t& span = pass->spans[span_index];
+
+    for(unsigned int y = 0; y < light.num_points_y; ++y){
+        float* density = light.density.data() + light.get_index(0, y, span.z);
+        for(unsigned int x = span.min_x; x < span.max_x; ++x){
+            Vector3 world_pos = to_world_space(get_lattice_pos(light, x, y, span.z), pass->wind_distance);
+            density[x] = cloud_raymarch_sample_density(*pass->params, *pass->volumes, world_pos, pass->mip_level, true);
+        }
+    }
+}
+
+// The light cone's taps without the jitter, each read off the density lattice
+static void gather_span(unsigned int span_index, void* user_data)
+{
+    light_pass_t* pass = (light_pass_t*)user_data;
+    cloud_light_volume_t& light = *pass->light;
+    const light_span_t& span = pass->spans[span_index];
+    Vector3 light_step = pass->light_dir * pass->step_size;
+
+    for(unsigned int y = 0; y < light.num_points_y; ++y){
+        float* transmittance = light.transmittance.data() + light.get_index(0, y, span.z);
+        for(unsigned int x = span.min_x; x < span.max_x; ++x){
+            Vector3 pos = to_world_space(get_lattice_pos(light, x, y, span.z), pass->wind_distance);
+
+            float total_density = 0.0f;
+            for(unsigned int i = 0; i < NUM_LIGHT_TAPS; ++i){
+                float coords[3];
+                get_lattice_coords(light, to_cloud_space(pos, pass->wind_distance), coords);
+                total_density += read_trilinear(light, light.density, coords);
+                pos = pos + light_step;
+            }
+            transmittance[x] = expf(-total_density);
+        }
+    }
+}
+
+// Where the lattice goes around <center_x, center_z>, and how low the layer's
+// bottom curves over its footprint were the center <slack> further out
+static void get_placement(const cloud_light_volume_t& light, float center_x, float center_z, float wind_distance, float slack, int* out_origin_x, int* out_origin_z, float* out_min_y)
+{
+    float cloud_x = center_x + wind_distance + (0.5f * CLOUD_WIND_TOP_OFFSET);
+    *out_origin_x = (int)floorf(cloud_x / light.cell_size) - (int)(light.num_points_x / 2);
+    *out_origin_z = (int)floorf(center_z / light.cell_size) - (int)(light.num_points_z / 2);
+
+    double half_extent = (0.5 * (double)light.num_points_x + 1.0) * light.cell_size;
+    double far_x = fabs((double)center_x) + half_extent + slack + CLOUD_WIND_TOP_OFFSET;
+    double far_z = fabs((double)center_z) + half_extent + slack;
+    double bottom_sq = (INNER_LAYER_RADIUS * INNER_LAYER_RADIUS) - (far_x * far_x) - (far_z * far_z);
+    double bottom = ((bottom_sq > 0.0) ? sqrt(bottom_sq) : 0.0) - (double)CLOUD_PLANET_RADIUS;
+    *out_min_y = (floorf((float)bottom / light.cell_height) - 1.0f) * light.cell_height;
+}
+
+static Vector3 get_light_dir(const cloud_raymarch_params_t& params, float center_x, float center_z)
+{
+    Vector3 center(center_x, 0.5f * (CLOUD_LAYER_INNER_HEIGHT + CLOUD_LAYER_OUTER_HEIGHT), center_z);
+    return (params.cloud.sun_position - center).Normalized();
+}
+
+// Index ranges along one axis within <reach> of the <d> points that scrolled
+// in, and with <include_dropped_edge> within <reach> of the edge it scrolled
+// away from, where taps that read past the old edge clamp now
+static unsigned int get_scroll_ranges(int d, int num_points, int reach, bool include_dropped_edge, int* out_ranges)
+{
+    if(d == 0){
+        return 0;
+    }
+
+    int new0 = (d > 0) ? num_points - d : 0;
+    int new1 = (d > 0) ? num_points : -d;
+    out_ranges[0] = (new0 - reach < 0) ? 0 : new0 - reach;
+    out_ranges[1] = (new1 + reach > num_points) ? num_points : new1 + reach;
+    if(!include_dropped_edge){
+        return 1;
+    }
+
+    int edge0 = (d > 0) ? 0 : num_points - reach;
+    int edge1 = (d > 0) ? reach : num_points;
+    edge0 = (edge0 < 0) ? 0 : edge0;
+    edge1 = (edge1 > num_points) ? num_points : edge1;
+    if((edge0 <= out_ranges[1]) && (edge1 >= out_ranges[0])){
+        out_ranges[0] = (edge0 < out_ranges[0]) ? edge0 : out_ranges[0];
+        out_ranges[1] = (edge1 > out_ranges[1]) ? edge1 : out_ranges[1];
+        return 1;
+    }
+    out_ranges[2] = edge0;
+    out_ranges[3] = edge1;
+    return 2;
+}
+
+// Rows of z in the z ranges are whole spans, the rest only span the x ranges
+static void add_scroll_spans(const cloud_light_volume_t& light, int dx, int dz, int reach, bool include_dropped_edge, std::vector<light_span_t>* out_spans)
+{
+    int x_ranges[4];
+    int z_ranges[4];
+    unsigned int num_x_ranges = get_scroll_ranges(dx, (int)light.num_points_x, reach, include_dropped_edge, x_ranges);
+    unsigned int num_z_ranges = get_scroll_ranges(dz, (int)light.num_points_z, reach, include_dropped_edge, z_ranges);
+
+    out_spans->clear();
+    for(unsigned int z = 0; z < light.num_points_z; ++z){
+        bool is_whole_row = false;
+        for(unsigned int r = 0; r < num_z_ranges; ++r){
+            is_whole_row |= ((int)z >= z_ranges[2 * r]) && ((int)z < z_ranges[(2 * r) + 1]);
+        }
+
+        light_span_t span;
+        span.z = z;
+        if(is_whole_row){
+            span.min_x = 0;
+            span.max_x = light.num_points_x;
+            out_spans->push_back(span);
+            continue;
+        }
+        for(unsigned int r = 0; r < num_x_ranges; ++r){
+            span.min_x = (unsigned int)x_ranges[2 * r];
+            span.max_x = (unsigned int)x_ranges[(2 * r) + 1];
+            out_spans->push_back(span);
+        }
+    }
+}
+
+static void add_all_spans(const cloud_light_volume_t& light, std::vector<light_span_t>* out_spans)
+{
+    out_spans->resize(light.num_points_z);
+    for(unsigned int z = 0; z < light.num_points_z; ++z){
+        (*out_spans)[z].z = z;
+        (*out_spans)[z].min_x = 0;
+        (*out_spans)[z].max_x = light.num_points_x;
+    }
+}
+
+static unsigned int count_span_points(const cloud_light_volume_t& light, const std::vector<light_span_t>& spans)
+{
+    unsigned int num_points = 0;
+    for(const light_span_t& span : spans){
+        num_points += (span.max_x - span.min_x) * light.num_points_y;
+    }
+    return num_points;
+}
+
+// Moves what's still on the lattice <dx, dz> points over, the rest is left for sampling
+static void shift_values(const cloud_light_volume_t& light, int dx, int dz, std::vector<float>* values)
+{
+    std::vector<float> shifted(values->size(), 0.0f);
+
+    int num_x = (int)light.num_points_x;
+    int src_x0 = (dx > 0) ? dx : 0;
+    int dst_x0 = (dx > 0) ? 0 : -dx;
+    int run = num_x - ((dx > 0) ? dx : -dx);
+
+    for(unsigned int z = 0; z < light.num_points_z; ++z){
+        int src_z = (int)z + dz;
+        if((src_z < 0) || (src_z >= (int)light.num_points_z)){
+            continue;
+        }
+        for(unsigned int y = 0; y < light.num_points_y; ++y){
+            const float* src = values->data() + light.get_index(0, y, (unsigned int)src_z);
+            float* dst = shifted.data() + light.get_index(0, y, z);
+            memcpy(dst + dst_x0, src + src_x0, (size_t)run * sizeof(float));
+        }
+    }
+    values->swap(shifted);
+}
+
+static void start_pass(cloud_light_volume_t* light, const cloud_raymarch_params_t& params, const cloud_raymarch_volumes_t& volumes, float center_x, float center_z, light_pass_t* out_pass)
+{
+    out_pass->light         = light;
+    out_pass->params        = &params;
+    out_pass->volumes       = &volumes;
+    out_pass->wind_distance = get_wind_distance(params);
+    out_pass->mip_level     = params.knobs[7] * 10.0f;
+    out_pass->light_dir     = get_light_dir(params, center_x, center_z);
+    out_pass->step_size     = params.knobs[8] * 500.0f;
+}
+
+static void run_sample(light_pass_t* pass, unsigned int max_workers)
+{
+    cloud_light_volume_t* light = pass->light;
+    double start = get_current_time_seconds();
+
+    light->num_density_samples += count_span_points(*light, pass->spans);
+    unsigned int num_workers = job_parallel_for((unsigned int)pass->spans.size(), sample_span, pass, max_workers);
+    light->num_workers = (num_workers > light->num_workers) ? num_workers : light->num_workers;
+
+    light->sample_seconds += get_current_time_seconds() - start;
+}
+
+static void run_gather(light_pass_t* pass, unsigned int max_workers)
+{
+    cloud_light_volume_t* light = pass->light;
+    double start = get_current_time_seconds();
+
+    unsigned int num_workers = job_parallel_for((unsigned int)pass->spans.size(), gather_span, pass, max_workers);
+    light->num_workers = (num_workers > light->num_workers) ? num_workers : light->num_workers;
+
+    light->is_built     = true;
+    light->light_dir    = pass->light_dir;
+    light->step_size    = pass->step_size;
+    light->gather_seconds += get_current_time_seconds() - start;
+}
+
+static void resample(cloud_light_volume_t* light, light_pass_t* pass, int origin_x, int origin_z, float min_y, unsigned int max_workers)
+{
+    const cloud_raymarch_params_t& params = *pass->params;
+    const cloud_raymarch_volumes_t& volumes = *pass->volumes;
+
+    // Rows sit on whole multiples of the cell height, up to a cell above the
+    // top of the layer where the height fraction has saturated and clamping y
+    // reads what's further up
+    float max_y = (ceilf(CLOUD_LAYER_OUTER_HEIGHT / light->cell_height) + 1.0f) * light->cell_height;
+    light->num_points_y = (unsigned int)((max_y - min_y) / light->cell_height + 0.5f) + 1;
+    light->origin_x     = origin_x;
+    light->origin_z     = origin_z;
+    light->min_y        = min_y;
+
+    size_t num_points = (size_t)light->num_points_x * light->num_points_y * light->num_points_z;
+    light->density.assign(num_points, 0.0f);
+    light->transmittance.assign(num_points, 1.0f);
+
+    add_all_spans(*light, &pass->spans);
+    run_sample(pass, max_workers);
+
+    light->is_sampled       = true;
+    light->base_data        = volumes.base.mips[0].data;
+    light->base_scale       = params.knobs[0];
+    light->light_mip        = params.knobs[7];
+    light->coverage_time    = params.game_time * params.knobs[5];
+    light->weather          = volumes.weather;
+    light->weather_version  = (nullptr != volumes.weather) ? volumes.weather->version : 0;
+    light->wind_distance    = pass->wind_distance;
+}
+
+//-----------------------------------------------------
+// Public API
+
+void cloud_light_init(cloud_light_volume_t* light, float radius, float cell_size, float cell_height)
+{
+    unsigned int num_cells = (unsigned int)ceilf((2.0f * radius) / cell_size);
+    num_cells = (num_cells > 0) ? num_cells : 1;
+
+    light->cell_size        = cell_size;
+    light->cell_height      = cell_height;
+    light->num_points_x     = num_cells + 1;
+    light->num_points_y     = 0;
+    light->num_points_z     = num_cells + 1;
+    light->density.clear();
+    light->transmittance.clear();
+    light->is_sampled       = false;
+    light->is_built         = false;
+}
+
+unsigned int cloud_light_update(cloud_light_volume_t* light, const cloud_raymarch_params_t& params, const cloud_raymarch_volumes_t& volumes, float center_x, float center_z, unsigned int max_workers)
+{
+    light->num_density_samples  = 0;
+    light->sample_seconds       = 0.0;
+    light->gather_seconds       = 0.0;
+    light->num_workers          = 0;
+
+    light_pass_t pass;
+    start_pass(light, params, volumes, center_x, center_z, &pass);
+
+    int origin_x, origin_z;
+    float min_y, slack_min_y;
+    float slack = PLACEMENT_SLACK * (float)(light->num_points_x - 1) * light->cell_size;
+    get_placement(*light, center_x, center_z, pass.wind_distance, 0.0f, &origin_x, &origin_z, &min_y);
+    get_placement(*light, center_x, center_z, pass.wind_distance, slack, &origin_x, &origin_z, &slack_min_y);
+    int dx = origin_x - light->origin_x;
+    int dz = origin_z - light->origin_z;
+
+    bool is_current = light->is_sampled
+        && (light->base_data == volumes.base.mips[0].data)
+        && (light->base_scale == params.knobs[0])
+        && (light->light_mip == params.knobs[7])
+        && (light->coverage_time == params.game_time * params.knobs[5])
+        && (light->weather == volumes.weather)
+        && ((nullptr == volumes.weather) || (light->weather_version == volumes.weather->version))
+        && (fabsf(0.1f * (pass.wind_distance - light->wind_distance)) <= MAX_WIND_DRIFT_CELLS * light->cell_height)
+        && (min_y >= light->min_y)
+        && (abs(dx) < (int)light->num_points_x)
+        && (abs(dz) < (int)light->num_points_z);
+
+    unsigned int result = CLOUD_LIGHT_UPDATE_NONE;
+    if(!is_current){
+        resample(light, &pass, origin_x, origin_z, slack_min_y, max_workers);
+        result = CLOUD_LIGHT_UPDATE_RESAMPLED;
+    }else if((dx != 0) || (dz != 0)){
+        shift_values(*light, dx, dz, &light->density);
+        shift_values(*light, dx, dz, &light->transmittance);
+        light->origin_x = origin_x;
+        light->origin_z = origin_z;
+
+        add_scroll_spans(*light, dx, dz, 0, false, &pass.spans);
+        run_sample(&pass, max_workers);
+        result = CLOUD_LIGHT_UPDATE_SCROLLED;
+    }
+
+    float cos_tolerance = cosf(LIGHT_ANGLE_TOLERANCE * (3.14159265f / 180.0f));
+    bool is_light_current = light->is_built
+        && (light->step_size == pass.step_size)
+        && (DotProduct(light->light_dir, pass.light_dir) >= cos_tolerance);
+
+    if((result == CLOUD_LIGHT_UPDATE_RESAMPLED) || !is_light_current){
+        // Keeps gathering along the direction it had, the sun hasn't moved enough to matter
+        pass.light_dir = is_light_current ? light->light_dir : pass.light_dir;
+        add_all_spans(*light, &pass.spans);
+        run_gather(&pass, max_workers);
+        result |= CLOUD_LIGHT_UPDATE_GATHERED;
+    }else if(result == CLOUD_LIGHT_UPDATE_SCROLLED){
+        // Everything whose taps can reach the new points or the dropped edge:
+        // the taps span the light steps plus the whole lean of the tops in cloud space
+        float reach = ((float)(NUM_LIGHT_TAPS - 1) * pass.step_size + CLOUD_WIND_TOP_OFFSET) / light->cell_size;
+        pass.light_dir = light->light_dir;
+        add_scroll_spans(*light, dx, dz, (int)ceilf(reach) + 1, true, &pass.spans);
+        run_gather(&pass, max_workers);
+        result |= CLOUD_LIGHT_UPDATE_GATHERED;
+    }
+    return result;
+}
+
+void cloud_light_build(cloud_light_volume_t* light, const cloud_raymarch_params_t& params, const cloud_raymarch_volumes_t& volumes, float center_x, float center_z, unsigned int max_workers)
+{
+    light->is_sampled   = false;
+    light->is_built     = false;
+    cloud_light_update(light, params, volumes, center_x, center_z, max_workers);
+}
+
+bool cloud_light_get_transmittance(const cloud_light_volume_t& light, const cloud_raymarch_params_t& params, const Vector3& world_pos, float* out_transmittance)
+{
+    if(!light.is_built){
+        return false;
+    }
+
+    float coords[3];
+    if(!get_lattice_coords(light, to_cloud_space(world_pos, get_wind_distance(params)), coords)){
+        return false;
+    }
+
+    *out_transmittance = read_trilinear(light, light.transmittance, coords);
+    return true;
+}
@@ -0,0 +1,123 @@
+#pragma once
+
+#include "Game/cloud_raymarch.h"
+
+#include <vector>
+
+//-----------------------------------------------------
+// Cloud light volume
+//
+// Sun transmittance cached on a lattice over the cloud layer, so a primary
+// sample reads one trilinear value instead of marching the light cone.
+//
+// The lattice lives in cloud space, x being world x plus the wind distance
+// plus the lean of the tops (sample_density's offsets along x), y and z
+// world. The clouds sit still in that space as the wind blows: moving the
+// camera or the wind only scrolls the lattice, and the cells that scroll in
+// are the only ones sampled. What the lattice stores is two things:
+//
+//  - the cheap density at every point, at the light cone's base mip. This is
+//    the expensive half, it reads the base noise and the coverage.
+//  - the transmittance, gathered from that density along the light: the
+//    shader's light march is a window of six samples a light
+//    step apart rather than a running integral, so every point sums its
+//    window of trilinear density reads. Columns of points are split across
+//    GENERIC jobs. No noise is read, so the sun can move without resampling.
+//
+// Against the cone march this drops the cone's jitter and the coarser mips
+// of the far samples, and sees the density at lattice resolution.
+// cloud_raymarch_get_light_transmittance is the cone march to compare with.
+//
+// The wind also pushes the noise up by a tenth of its distance, which isn't
+// part of cloud space, so the density is sampled again from scratch once
+// that has moved it a quarter of a cell. The base volume, base scale, light
+// mip, coverage animation and weather map resample everything too.
+
+enum CloudLightUpdate
+{
+    CLOUD_LIGHT_UPDATE_NONE         = 0,
+    CLOUD_LIGHT_UPDATE_RESAMPLED    = 1 << 0,   // every density point sampled
+    CLOUD_LIGHT_UPDATE_SCROLLED     = 1 << 1,   // only the points that scrolled in
+    CLOUD_LIGHT_UPDATE_GATHERED     = 1 << 2,   // transmittance gathered again
+};
+
+struct cloud_light_volume_t
+{
+    float                       cell_size;          // xz, meters
+    float                       cell_height;        // y, meters
+    unsigned int                num_points_x;
+    unsigned int                num_points_y;
+    unsigned int                num_points_z;
+    int                         origin_x;           // cloud space lattice index of point 0, cell_size apart
+    int                         origin_z;
+    float                       min_y;              // world y of the lowest row
+    std::vector<float>          density;            // x fastest, then y, then z
+    std::vector<float>          transmittance;      // same lattice
+
+    // What the density was sampled for
+    bool                        is_sampled;
+    const unsigned char*        base_data;
+    float                       base_scale;
+    float                       light_mip;
+    float                       coverage_time;
+    float                       wind_distance;      // at the last full sample
+    const cloud_weather_map_t*  weather;
+    unsigned int                weather_version;
+
+    // What the transmittance was gathered for
+    bool                        is_built;
+    Vector3                     light_dir;          // world, toward the sun
+    float                       step_size;
+
+    // The last update
+    unsigned int                num_density_samples;
+    double                      sample_seconds;
+    double                      gather_seconds;
+    unsigned int                num_workers;
+
+    cloud_light_volume_t()
+        :cell_size(0.0f)
+        ,cell_height(0.0f)
+        ,num_points_x(0)
+        ,num_points_y(0)
+        ,num_points_z(0)
+        ,origin_x(0)
+        ,origin_z(0)
+        ,min_y(0.0f)
+        ,is_sampled(false)
+        ,base_data(nullptr)
+        ,base_scale(0.0f)
+        ,light_mip(0.0f)
+        ,coverage_time(0.0f)
+        ,wind_distance(0.0f)
+        ,weather(nullptr)
+        ,weather_version(0)
+        ,is_built(false)
+        ,light_dir(0.0f, 1.0f, 0.0f)
+        ,step_size(0.0f)
+        ,num_density_samples(0)
+        ,sample_seconds(0.0)
+        ,gather_seconds(0.0)
+        ,num_workers(0)
+    {}
+
+    size_t get_index(unsigned int x, unsigned int y, unsigned int z) const  { return ((size_t)z * num_points_y + y) * num_points_x + x; }
+};
+
+// Lattice of <cell_size> by <cell_height> cells covering <radius> around the
+// center given to each update, from below the curved layer's bottom at that
+// radius to above its top. Nothing is sampled yet.
+void    cloud_light_init(cloud_light_volume_t* light, float radius, float cell_size, float cell_height);
+
+// Brings the volume up to date for <params> around world <center_x, center_z>,
+// doing only what changed, see CloudLightUpdate. Needs job_system_init,
+// <max_workers> 0 uses every core. Sun moves under a tenth of a degree keep
+// the transmittance as it is.
+unsigned int cloud_light_update(cloud_light_volume_t* light, const cloud_raymarch_params_t& params, const cloud_raymarch_volumes_t& volumes, float center_x, float center_z, unsigned int max_workers = 0);
+
+// Samples and gathers everything from scratch
+void    cloud_light_build(cloud_light_volume_t* light, const cloud_raymarch_params_t& params, const cloud_raymarch_volumes_t& volumes, float center_x, float center_z, unsigned int max_workers = 0);
+
+// Transmittance toward the sun at <world_pos>, false off the lattice or when
+// the volume isn't built. The lookup stands in for the light cone's expf(-density).
+bool    cloud_light_get_transmittance(const cloud_light_volume_t& light, const cloud_raymarch_params_t& params, const Vector3& world_pos, float* out_transmittance);
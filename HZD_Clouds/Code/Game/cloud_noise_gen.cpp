@@ -0,0 +1,523 @@
+#include "Game/cloud_noise_gen.h"
+
+#include "Engine/Core/Config.hpp"
+#include "Engine/Math/MathUtils.hpp"
+#include "Engine/Math/Noise.hpp"
+#include "Engine/Volume/volume_layout.h"
+#include "Engine/Volume/volume_mips.h"
+
+#include <stddef.h>
+#include <string.h>
+#include <vector>
+
+//-----------------------------------------------------
+// Internal helpers
+
+// The shaders divide SV_RenderTargetArrayIndex by these to get z
+static const float  BASE_NOISE_Z_DIVISOR    = 128.0f;
+static const float  DETAIL_NOISE_Z_DIVISOR  = 127.0f;
+
+// Lattice period of the Perlin half of calculate_perlin_worley
+static const int    BASE_PERLIN_WRAP        = 4;
+
+// Part of every cache key, bump it whenever the bake output changes for the same parameters
+static const unsigned int CLOUD_NOISE_CACHE_VERSION = 1;
+
+// Cached volumes carry their whole mip chain, built with this
+static const VolumeMipFilter CLOUD_NOISE_MIP_FILTER = VOLUME_MIP_FILTER_KAISER;
+
+static const char*  s_cloud_noise_type_names[NUM_CLOUD_NOISE_TYPES] = {
+    "base",
+    "detail"
+};
+
+struct noise_row_t
+{
+    std::vector<float> xs;
+    std::vector<float> ys;
+    std::vector<float> zs;
+    std::vector<float> channels[4];
+    std::vector<float> perlin;
+
+    noise_row_t(unsigned int width)
+        :xs(width)
+        ,ys(width)
+        ,zs(width)
+        ,perlin(width)
+    {
+        for(unsigned int i = 0; i < 4; ++i){
+            channels[i].resize(width);
+        }
+    }
+};
+
+struct bake_brick_data_t
+{
+    CloudNoiseType                      type;
+    const noise_gen_paramters_data_t*   params;
+    unsigned int                        channel_mask;
+};
+
+// Which channels each parameter feeds, per noise type. Anything not listed
+// (start_slice, padding, view_mask) is shader plumbing and never dirties a bake.
+struct param_channel_binding_t
+{
+    size_t          offset;
+    size_t          size;
+    unsigned int    channels[NUM_CLOUD_NOISE_TYPES];
+};
+
+#define PARAM_CHANNEL_BINDING(field, base_channels, detail_channels) \
+    { offsetof(noise_gen_paramters_data_t, field), sizeof(((noise_gen_paramters_data_t*)nullptr)->field), { base_channels, detail_channels } }
+
+static const unsigned int CLOUD_NOISE_CHANNELS_GBA = CLOUD_NOISE_CHANNEL_G | CLOUD_NOISE_CHANNEL_B | CLOUD_NOISE_CHANNEL_A;
+static const unsigned int CLOUD_NOISE_CHANNELS_RGB = CLOUD_NOISE_CHANNEL_R | CLOUD_NOISE_CHANNEL_G | CLOUD_NOISE_CHANNEL_B;
+
+static const param_channel_binding_t s_param_channel_bindings[] = {
+    PARAM_CHANNEL_BINDING(worley_scale,                     CLOUD_NOISE_CHANNEL_R,      0),
+    PARAM_CHANNEL_BINDING(worley_num_octaves,               CLOUD_NOISE_CHANNEL_R,      0),
+    PARAM_CHANNEL_BINDING(worley_octave_persistence,        CLOUD_NOISE_CHANNEL_R,      0),
+    PARAM_CHANNEL_BINDING(worley_octave_scale,              CLOUD_NOISE_CHANNEL_R,      0),
+    PARAM_CHANNEL_BINDING(perlin_scale,                     CLOUD_NOISE_CHANNEL_R,      0),
+    PARAM_CHANNEL_BINDING(perlin_num_octaves,               CLOUD_NOISE_CHANNEL_R,      0),
+    PARAM_CHANNEL_BINDING(perlin_octave_persistence,        CLOUD_NOISE_CHANNEL_R,      0),
+    PARAM_CHANNEL_BINDING(perlin_octave_scale,              CLOUD_NOISE_CHANNEL_R,      0),
+
+    PARAM_CHANNEL_BINDING(worley_one_scale,                 CLOUD_NOISE_CHANNEL_G,      0),
+    PARAM_CHANNEL_BINDING(worley_two_scale,                 CLOUD_NOISE_CHANNEL_B,      0),
+    PARAM_CHANNEL_BINDING(worley_three_scale,               CLOUD_NOISE_CHANNEL_A,      0),
+    PARAM_CHANNEL_BINDING(worley_only_num_octaves,          CLOUD_NOISE_CHANNELS_GBA,   0),
+    PARAM_CHANNEL_BINDING(worley_only_octave_persistence,   CLOUD_NOISE_CHANNELS_GBA,   0),
+    PARAM_CHANNEL_BINDING(worley_only_octave_scale,         CLOUD_NOISE_CHANNELS_GBA,   0),
+
+    PARAM_CHANNEL_BINDING(detail_worley_one_scale,          0,                          CLOUD_NOISE_CHANNEL_R),
+    PARAM_CHANNEL_BINDING(detail_worley_two_scale,          0,                          CLOUD_NOISE_CHANNEL_G),
+    PARAM_CHANNEL_BINDING(detail_worley_three_scale,        0,                          CLOUD_NOISE_CHANNEL_B),
+    PARAM_CHANNEL_BINDING(detail_worley_num_octaves,        0,                          CLOUD_NOISE_CHANNELS_RGB),
+    PARAM_CHANNEL_BINDING(detail_worley_octave_persistence, 0,                          CLOUD_NOISE_CHANNELS_RGB),
+    PARAM_CHANNEL_BINDING(detail_worley_octave_scale,       0,                          CLOUD_NOISE_CHANNELS_RGB),
+
+    PARAM_CHANNEL_BINDING(generation_all_scale,             CLOUD_NOISE_CHANNEL_ALL,    CLOUD_NOISE_CHANNELS_RGB),
+    PARAM_CHANNEL_BINDING(generation_z_scale,               CLOUD_NOISE_CHANNEL_ALL,    CLOUD_NOISE_CHANNELS_RGB),
+};
+
+static float range_map(float value, float in_min, float in_max, float out_min, float out_max)
+{
+    return ((value - in_min) / (in_max - in_min)) * (out_max - out_min) + out_min;
+}
+
+// The noise render targets are UNORM, so the GPU saturates and rounds to nearest
+static unsigned char unorm8_from_float(float value)
+{
+    value = Clamp(value, 0.0f, 1.0f);
+    return (unsigned char)(value * 255.0f + 0.5f);
+}
+
+// SV_Position is the pixel center, the shaders then map it with (p + 1) * 0.5
+static float map_pixel_to_noise_space(unsigned int pixel)
+{
+    return (((float)pixel + 0.5f) + 1.0f) * 0.5f;
+}
+
+static void fill_row_positions(noise_row_t* row, const noise_gen_paramters_data_t& params, unsigned int min_x, unsigned int width, unsigned int y, unsigned int z, float z_divisor)
+{
+    float pos_y = map_pixel_to_noise_space(y) * params.generation_all_scale;
+    float pos_z = (((float)z / z_divisor) * params.generation_all_scale) * params.generation_z_scale;
+
+    for(unsigned int x = 0; x < width; ++x){
+        row->xs[x] = map_pixel_to_noise_space(min_x + x) * params.generation_all_scale;
+        row->ys[x] = pos_y;
+        row->zs[x] = pos_z;
+    }
+}
+
+// 1 - worley fbm, used by every channel except base R
+static void compute_inverted_worley_row(noise_row_t* row, float* out, unsigned int width, float scale, unsigned int num_octaves, float octave_persistence, float octave_scale)
+{
+    get_hashed_worley_noise_3d_batch(row->xs.data(), row->ys.data(), row->zs.data(), out, width, scale, num_octaves, octave_persistence, octave_scale, true);
+    for(unsigned int x = 0; x < width; ++x){
+        out[x] = 1.0f - out[x];
+    }
+}
+
+static void bake_base_row(noise_row_t* row, const noise_gen_paramters_data_t& params, unsigned int width, unsigned int channel_mask)
+{
+    // R: calculate_perlin_worley
+    if(channel_mask & CLOUD_NOISE_CHANNEL_R){
+        float* perlin_worley = row->channels[0].data();
+        get_hashed_worley_noise_3d_batch(row->xs.data(), row->ys.data(), row->zs.data(), perlin_worley, width, params.worley_scale, params.worley_num_octaves, params.worley_octave_persistence, params.worley_octave_scale, true);
+        Compute3dPerlinNoiseZeroToOneWrappedBatch(row->xs.data(), row->ys.data(), row->zs.data(), row->perlin.data(), width, params.perlin_scale, params.perlin_num_octaves, params.perlin_octave_persistence, params.perlin_octave_scale, BASE_PERLIN_WRAP, true, 0U);
+
+        for(unsigned int x = 0; x < width; ++x){
+            float worley = perlin_worley[x] * 15.0f;
+            float perlin = row->perlin[x] * 20.0f;
+            perlin_worley[x] = range_map(perlin, worley, 20.0f, 0.0f, 1.0f);
+        }
+    }
+
+    // GBA: calculate_worley_one/two/three
+    if(channel_mask & CLOUD_NOISE_CHANNEL_G){
+        compute_inverted_worley_row(row, row->channels[1].data(), width, params.worley_one_scale, params.worley_only_num_octaves, params.worley_only_octave_persistence, params.worley_only_octave_scale);
+    }
+    if(channel_mask & CLOUD_NOISE_CHANNEL_B){
+        compute_inverted_worley_row(row, row->channels[2].data(), width, params.worley_two_scale, params.worley_only_num_octaves, params.worley_only_octave_persistence, params.worley_only_octave_scale);
+    }
+    if(channel_mask & CLOUD_NOISE_CHANNEL_A){
+        compute_inverted_worley_row(row, row->channels[3].data(), width, params.worley_three_scale, params.worley_only_num_octaves, params.worley_only_octave_persistence, params.worley_only_octave_scale);
+    }
+}
+
+static void bake_detail_row(noise_row_t* row, const noise_gen_paramters_data_t& params, unsigned int width, unsigned int channel_mask)
+{
+    if(channel_mask & CLOUD_NOISE_CHANNEL_R){
+        compute_inverted_worley_row(row, row->channels[0].data(), width, params.detail_worley_one_scale, params.detail_worley_num_octaves, params.detail_worley_octave_persistence, params.detail_worley_octave_scale);
+    }
+    if(channel_mask & CLOUD_NOISE_CHANNEL_G){
+        compute_inverted_worley_row(row, row->channels[1].data(), width, params.detail_worley_two_scale, params.detail_worley_num_octaves, params.detail_worley_octave_persistence, params.detail_worley_octave_scale);
+    }
+    if(channel_mask & CLOUD_NOISE_CHANNEL_B){
+        compute_inverted_worley_row(row, row->channels[2].data(), width, params.detail_worley_three_scale, params.detail_worley_num_octaves, params.detail_worley_octave_persistence, params.detail_worley_octave_scale);
+    }
+
+    if(channel_mask & CLOUD_NOISE_CHANNEL_A){
+        float* alpha = row->channels[3].data();
+        for(unsigned int x = 0; x < width; ++x){
+            alpha[x] = 1.0f;
+        }
+    }
+}
+
+static void bake_brick(volume_buffer_t* volume, const volume_brick_t& brick, void* user_data)
+{
+    bake_brick_data_t* data = (bake_brick_data_t*)user_data;
+    cloud_noise_bake_brick(data->type, *data->params, data->channel_mask, volume, brick);
+}
+
+static void regen_brick(volume_buffer_t* volume, const volume_brick_t& brick, void* user_data)
+{
+    cloud_noise_volume_t* noise_volume = (cloud_noise_volume_t*)user_data;
+    cloud_noise_bake_brick(noise_volume->type, noise_volume->pending_params, noise_volume->pending_channels, volume, brick);
+}
+
+//-----------------------------------------------------
+// Public API
+
+void cloud_noise_gen_set_defaults(noise_gen_paramters_data_t* params)
+{
+    params->start_slice                         = 0;
+    params->worley_scale                        = 0.10f;
+    params->worley_num_octaves                  = 4;
+    params->worley_octave_persistence           = 0.5f;
+    params->worley_octave_scale                 = 2.0f;
+    params->perlin_scale                        = 12.5f;
+    params->perlin_num_octaves                  = 4;
+    params->perlin_octave_persistence           = 2.0f;
+    params->perlin_octave_scale                 = 0.5f;
+
+    params->worley_one_scale                    = 0.15f;
+    params->worley_two_scale                    = 0.25f;
+    params->worley_three_scale                  = 0.35f;
+    params->worley_only_num_octaves             = 4;
+    params->worley_only_octave_persistence      = 0.5f;
+    params->worley_only_octave_scale            = 2.0f;
+
+    params->detail_worley_one_scale             = 1.5f;
+    params->detail_worley_two_scale             = 2.5f;
+    params->detail_worley_three_scale           = 3.5f;
+    params->detail_worley_num_octaves           = 4;
+    params->detail_worley_octave_persistence    = 0.5f;
+    params->detail_worley_octave_scale          = 2.0f;
+
+    params->generation_all_scale                = 1.0f;
+    params->generation_z_scale                  = 50.0f;
+}
+
+void cloud_noise_gen_load_from_config(noise_gen_paramters_data_t* params)
+{
+    ConfigGetFloat(&params->worley_scale, "base_worley_scale");
+    ConfigGetInt((int*)&params->worley_num_octaves, "base_worley_num_octaves");
+    ConfigGetFloat(&params->worley_octave_persistence, "base_worley_octave_persistence");
+    ConfigGetFloat(&params->worley_octave_scale, "base_worley_octave_scale");
+
+    ConfigGetFloat(&params->perlin_scale, "base_perlin_scale");
+    ConfigGetInt((int*)&params->perlin_num_octaves, "base_perlin_num_octaves");
+    ConfigGetFloat(&params->perlin_octave_persistence, "base_perlin_octave_persistence");
+    ConfigGetFloat(&params->perlin_octave_scale, "base_perlin_octave_scale");
+    ConfigGetFloat(&params->generation_all_scale,"generation_xyz_scale");
+    ConfigGetFloat(&params->generation_z_scale,"generation_z_scale");
+
+    ConfigGetFloat(&params->worley_one_scale, "base_worley_one_scale");
+    ConfigGetFloat(&params->worley_two_scale, "base_worley_two_scale");
+    ConfigGetFloat(&params->worley_three_scale,"base_worley_three_scale");
+    ConfigGetInt((int*)&params->worley_only_num_octaves,"base_fbm_worley_scale");
+    ConfigGetFloat(&params->worley_only_octave_persistence, "base_fbm_worley_octave_persistence");
+    ConfigGetFloat(&params->worley_only_octave_scale, "base_fbm_worley_octave_scale");
+
+    ConfigGetFloat(&params->detail_worley_one_scale, "detail_worley_one_scale");
+    ConfigGetFloat(&params->detail_worley_two_scale, "detail_worley_two_scale");
+    ConfigGetFloat(&params->detail_worley_three_scale, "detail_worley_three_scale");
+    ConfigGetInt((int*)&params->detail_worley_num_octaves, "detail_worley_num_octaves");
+    ConfigGetFloat(&params->detail_worley_octave_persistence, "detail_worley_octave_peristence");
+    ConfigGetFloat(&params->detail_worley_octave_scale, "detail_worley_octave_scale");
+}
+
+void cloud_noise_gen_save_to_config(const noise_gen_paramters_data_t& params)
+{
+    ConfigSet("base_worley_scale", params.worley_scale);
+    ConfigSet("base_worley_num_octaves", (int)params.worley_num_octaves);
+    ConfigSet("base_worley_octave_persistence", params.worley_octave_persistence);
+    ConfigSet("base_worley_octave_scale", params.worley_octave_scale);
+
+    ConfigSet("base_perlin_scale", params.perlin_scale);
+    ConfigSet("base_perlin_num_octaves", (int)params.perlin_num_octaves);
+    ConfigSet("base_perlin_octave_persistence", params.perlin_octave_persistence);
+    ConfigSet("base_perlin_octave_scale", params.perlin_octave_scale);
+    ConfigSet("generation_xyz_scale", params.generation_all_scale);
+    ConfigSet("generation_z_scale", params.generation_z_scale);
+
+    ConfigSet("base_worley_one_scale", params.worley_one_scale);
+    ConfigSet("base_worley_two_scale", params.worley_two_scale);
+    ConfigSet("base_worley_three_scale", params.worley_three_scale);
+    ConfigSet("base_fbm_worley_scale", (int)params.worley_only_num_octaves);
+    ConfigSet("base_fbm_worley_octave_persistence", params.worley_only_octave_persistence);
+    ConfigSet("base_fbm_worley_octave_scale", params.worley_only_octave_scale);
+
+    ConfigSet("detail_worley_one_scale", params.detail_worley_one_scale);
+    ConfigSet("detail_worley_two_scale", params.detail_worley_two_scale);
+    ConfigSet("detail_worley_three_scale", params.detail_worley_three_scale);
+    ConfigSet("detail_worley_num_octaves", (int)params.detail_worley_num_octaves);
+    ConfigSet("detail_worley_octave_peristence", params.detail_worley_octave_persistence);
+    ConfigSet("detail_worley_octave_scale", params.detail_worley_octave_scale);
+}
+
+const char* cloud_noise_get_type_name(CloudNoiseType type)
+{
+    return (type < NUM_CLOUD_NOISE_TYPES) ? s_cloud_noise_type_names[type] : "unknown";
+}
+
+bool cloud_noise_get_type_from_name(CloudNoiseType* out_type, const char* name)
+{
+    for(unsigned int i = 0; i < NUM_CLOUD_NOISE_TYPES; ++i){
+        if(strcmp(s_cloud_noise_type_names[i], name) == 0){
+            *out_type = (CloudNoiseType)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+unsigned int cloud_noise_get_dirty_channels(CloudNoiseType type, const noise_gen_paramters_data_t& baked_params, const noise_gen_paramters_data_t& params)
+{
+    unsigned int dirty_channels = 0;
+    for(const param_channel_binding_t& binding : s_param_channel_bindings){
+        const unsigned char* baked_field = (const unsigned char*)&baked_params + binding.offset;
+        const unsigned char* field = (const unsigned char*)&params + binding.offset;
+        if(memcmp(baked_field, field, binding.size) != 0){
+            dirty_channels |= binding.channels[type];
+        }
+    }
+    return dirty_channels;
+}
+
+void cloud_noise_bake_brick(CloudNoiseType type, const noise_gen_paramters_data_t& params, unsigned int channel_mask, volume_buffer_t* volume, const volume_brick_t& brick)
+{
+    float z_divisor = (type == CLOUD_NOISE_BASE) ? BASE_NOISE_Z_DIVISOR : DETAIL_NOISE_Z_DIVISOR;
+    unsigned int width = brick.max_x - brick.min_x;
+    noise_row_t row(width);
+
+    for(unsigned int z = brick.min_z; z < brick.max_z; ++z){
+        for(unsigned int y = brick.min_y; y < brick.max_y; ++y){
+            fill_row_positions(&row, params, brick.min_x, width, y, z, z_divisor);
+
+            if(type == CLOUD_NOISE_BASE){
+                bake_base_row(&row, params, width, channel_mask);
+            }else{
+                bake_detail_row(&row, params, width, channel_mask);
+            }
+
+            // Strided writes, channels outside the mask keep whatever is already in the volume.
+            // A linear row is one run, a bricked one a run per brick.
+            for(unsigned int x0 = 0; x0 < width;){
+                unsigned int run = volume->get_row_run(brick.min_x + x0);
+                run = (run < width - x0) ? run : (width - x0);
+
+                unsigned char* out_run = volume->get_voxel(brick.min_x + x0, y, z);
+                for(unsigned int c = 0; c < 4; ++c){
+                    if((channel_mask & (1U << c)) == 0){
+                        continue;
+                    }
+
+                    const float* channel = row.channels[c].data() + x0;
+                    for(unsigned int x = 0; x < run; ++x){
+                        out_run[(x * 4) + c] = unorm8_from_float(channel[x]);
+                    }
+                }
+                x0 += run;
+            }
+        }
+    }
+}
+
+void cloud_noise_bake_channels(CloudNoiseType type, const noise_gen_paramters_data_t& params, unsigned int channel_mask, volume_buffer_t* volume, unsigned int max_workers, volume_fill_stats_t* out_stats)
+{
+    bake_brick_data_t data;
+    data.type           = type;
+    data.params         = &params;
+    data.channel_mask   = channel_mask & CLOUD_NOISE_CHANNEL_ALL;
+
+    volume_fill(volume, bake_brick, &data, 0, max_workers, out_stats);
+}
+
+void cloud_noise_bake(CloudNoiseType type, const noise_gen_paramters_data_t& params, unsigned int width, unsigned int height, unsigned int depth, volume_buffer_t* out_volume, unsigned int max_workers, volume_fill_stats_t* out_stats)
+{
+    out_volume->resize(width, height, depth, 4);
+    cloud_noise_bake_channels(type, params, CLOUD_NOISE_CHANNEL_ALL, out_volume, max_workers, out_stats);
+}
+
+void cloud_noise_volume_init(cloud_noise_volume_t* noise_volume, CloudNoiseType type, unsigned int size, VolumeLayout layout)
+{
+    // Helpers from a regen this replaces still write into pending_volume
+    volume_fill_task_wait(&noise_volume->regen_task);
+    noise_volume->regen_task        = volume_fill_task_t();
+
+    noise_volume->type              = type;
+    noise_volume->is_baked          = false;
+    noise_volume->pending_channels  = 0;
+    noise_volume->is_regenerating   = false;
+    noise_volume->volume.resize(size, size, size, 4, layout);
+    noise_volume->baked_params      = noise_gen_paramters_data_t();
+    noise_volume->pending_params    = noise_gen_paramters_data_t();
+}
+
+static unsigned int get_volume_dirty_channels(const cloud_noise_volume_t& noise_volume, const noise_gen_paramters_data_t& params)
+{
+    if(!noise_volume.is_baked){
+        return CLOUD_NOISE_CHANNEL_ALL;
+    }
+    return cloud_noise_get_dirty_channels(noise_volume.type, noise_volume.baked_params, params);
+}
+
+unsigned int cloud_noise_volume_update(cloud_noise_volume_t* noise_volume, const noise_gen_paramters_data_t& params, unsigned int max_workers, volume_fill_stats_t* out_stats)
+{
+    unsigned int dirty_channels = get_volume_dirty_channels(*noise_volume, params);
+
+    if(dirty_channels != 0){
+        cloud_noise_bake_channels(noise_volume->type, params, dirty_channels, &noise_volume->volume, max_workers, out_stats);
+        noise_volume->baked_params = params;
+        noise_volume->is_baked = true;
+    }
+    return dirty_channels;
+}
+
+bool cloud_noise_volume_begin_regen(cloud_noise_volume_t* noise_volume, const noise_gen_paramters_data_t& params)
+{
+    if(noise_volume->is_regenerating){
+        return false;
+    }
+
+    unsigned int dirty_channels = get_volume_dirty_channels(*noise_volume, params);
+    if(dirty_channels == 0){
+        return false;
+    }
+
+    // Clean channels carry over from the live volume, dirty ones get overwritten brick by brick
+    noise_volume->pending_volume    = noise_volume->volume;
+    noise_volume->pending_params    = params;
+    noise_volume->pending_channels  = dirty_channels;
+    noise_volume->is_regenerating   = true;
+    volume_fill_task_begin(&noise_volume->regen_task, &noise_volume->pending_volume, regen_brick, noise_volume);
+    return true;
+}
+
+bool cloud_noise_volume_step_regen(cloud_noise_volume_t* noise_volume, float budget_ms, unsigned int max_workers)
+{
+    if(!noise_volume->is_regenerating){
+        return false;
+    }
+
+    if(!volume_fill_task_step(&noise_volume->regen_task, budget_ms, max_workers)){
+        return false;
+    }
+
+    // Swapping the buffers is just a pointer exchange, readers never see a half baked volume
+    noise_volume->volume.data.swap(noise_volume->pending_volume.data);
+    noise_volume->baked_params      = noise_volume->pending_params;
+    noise_volume->is_baked          = true;
+    noise_volume->is_regenerating   = false;
+    return true;
+}
+
+uint64_t cloud_noise_get_cache_key(CloudNoiseType type, const noise_gen_paramters_data_t& params, unsigned int width, unsigned int height, unsigned int depth)
+{
+    // Volumes are always RGBA8 unorm for now, so the format is just the voxel size
+    unsigned int header[6] = { CLOUD_NOISE_CACHE_VERSION, (unsigned int)type, width, height, depth, 4 };
+    uint64_t key = volume_cache_hash(header, sizeof(header));
+
+    for(const param_channel_binding_t& binding : s_param_channel_bindings){
+        if(binding.channels[type] != 0){
+            key = volume_cache_hash((const unsigned char*)&params + binding.offset, binding.size, key);
+        }
+    }
+    return key;
+}
+
+bool cloud_noise_volume_load_from_cache(cloud_noise_volume_t* noise_volume, const volume_cache_t& cache, const noise_gen_paramters_data_t& params, volume_file_t* out_file)
+{
+    if(noise_volume->is_regenerating){
+        return false;
+    }
+
+    const volume_buffer_t& volume = noise_volume->volume;
+    uint64_t key = cloud_noise_get_cache_key(noise_volume->type, params, volume.width, volume.height, volume.depth);
+
+    volume_file_t file;
+    if(!volume_cache_open(cache, key, &file)){
+        return false;
+    }
+
+    volume_buffer_t cached;
+    bool same_layout = volume_file_copy_mip(file, 0, &cached)
+        && (cached.width == volume.width) && (cached.height == volume.height) && (cached.depth == volume.depth) && (cached.bytes_per_voxel == volume.bytes_per_voxel);
+    if(!same_layout){
+        volume_file_close(&file);
+        return false;
+    }
+
+    // Cache entries are linear like everything on disk
+    volume_set_layout(&cached, volume.layout);
+    noise_volume->volume.data.swap(cached.data);
+    noise_volume->baked_params = params;
+    noise_volume->is_baked = true;
+
+    if(nullptr != out_file){
+        *out_file = file;
+    }else{
+        volume_file_close(&file);
+    }
+    return true;
+}
+
+bool cloud_noise_volume_save_to_cache(const cloud_noise_volume_t& noise_volume, const volume_cache_t& cache)
+{
+    if(!noise_volume.is_baked){
+        return false;
+    }
+
+    // Files only take linear volumes, a bricked one is saved through a linear copy
+    volume_buffer_t linear;
+    if(noise_volume.volume.layout != VOLUME_LAYOUT_LINEAR){
+        volume_convert_layout(noise_volume.volume.get_view(), VOLUME_LAYOUT_LINEAR, &linear);
+    }
+
+    const volume_buffer_t& volume = (noise_volume.volume.layout == VOLUME_LAYOUT_LINEAR) ? noise_volume.volume : linear;
+    uint64_t key = cloud_noise_get_cache_key(noise_volume.type, noise_volume.baked_params, volume.width, volume.height, volume.depth);
+
+    std::vector<volume_buffer_t> mips;
+    if(!volume_mips_build(volume.get_view(), VOLUME_FORMAT_RGBA8, CLOUD_NOISE_MIP_FILTER, &mips)){
+        return false;
+    }
+
+    std::vector<volume_view_t> views;
+    volume_mips_get_views(volume.get_view(), mips, &views);
+    return volume_cache_store(cache, key, VOLUME_FORMAT_RGBA8, views.data(), (unsigned int)views.size());
+}
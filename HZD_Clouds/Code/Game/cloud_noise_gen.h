@@ -0,0 +1,129 @@
+#pragma once
+
+#include "Engine/Math/Vector4.hpp"
+#include "Engine/Volume/volume_cache.h"
+#include "Engine/Volume/volume_fill.h"
+
+//-----------------------------------------------------
+// Cloud noise generation
+//
+// CPU port of 3d_base_noise.frag / 3d_detail_noise.frag. Volumes come out in
+// the same RGBA8 layout LoadFromFilenameRGBA8 reads ((z * h + y) * w + x) * 4,
+// so the game and the offline tools can share baked .dat files. Volumes
+// sized bricked (see volume_buffer.h) are baked bricked directly, for CPU
+// reads that march through them.
+
+// Matches noise_gen_parameters_buffer (b4) in the noise-gen shaders, keep in sync
+struct noise_gen_paramters_data_t
+{
+    unsigned int    start_slice;
+    float           worley_scale;
+    unsigned int    worley_num_octaves;
+    float           worley_octave_persistence;
+
+    float           worley_octave_scale;
+    float           perlin_scale;
+    unsigned int    perlin_num_octaves;
+    float           perlin_octave_persistence;
+
+    float           perlin_octave_scale;
+    float           worley_one_scale;
+    float           worley_two_scale;
+    float           worley_three_scale;
+
+    unsigned int    worley_only_num_octaves;
+    float           worley_only_octave_persistence;
+    float           worley_only_octave_scale;
+    float           detail_worley_one_scale;
+
+    float           detail_worley_two_scale;
+    float           detail_worley_three_scale;
+    unsigned int    detail_worley_num_octaves;
+    float           detail_worley_octave_persistence;
+
+    float           detail_worley_octave_scale;
+    float           generation_all_scale;
+    float           generation_z_scale;
+    float           padding;
+
+    Vector4         view_mask;
+};
+
+enum CloudNoiseType : unsigned int
+{
+    CLOUD_NOISE_BASE,   // R = perlin-worley, GBA = worley fbm
+    CLOUD_NOISE_DETAIL, // RGB = worley fbm, A = 1
+    NUM_CLOUD_NOISE_TYPES
+};
+
+enum CloudNoiseChannel : unsigned int
+{
+    CLOUD_NOISE_CHANNEL_R   = (1 << 0),
+    CLOUD_NOISE_CHANNEL_G   = (1 << 1),
+    CLOUD_NOISE_CHANNEL_B   = (1 << 2),
+    CLOUD_NOISE_CHANNEL_A   = (1 << 3),
+    CLOUD_NOISE_CHANNEL_ALL = 0xF
+};
+
+// A baked RGBA8 volume plus the parameters it was baked with, so edits only
+// rebake the channels they actually feed. Progressive regens bake into
+// pending_volume and only swap it into volume once every brick is done.
+struct cloud_noise_volume_t
+{
+    CloudNoiseType              type;
+    volume_buffer_t             volume;
+    noise_gen_paramters_data_t  baked_params;
+    bool                        is_baked;
+
+    volume_buffer_t             pending_volume;
+    noise_gen_paramters_data_t  pending_params;
+    unsigned int                pending_channels;
+    volume_fill_task_t          regen_task;
+    bool                        is_regenerating;
+};
+
+void            cloud_noise_gen_set_defaults(noise_gen_paramters_data_t* params);
+void            cloud_noise_gen_load_from_config(noise_gen_paramters_data_t* params);
+void            cloud_noise_gen_save_to_config(const noise_gen_paramters_data_t& params);
+
+const char*     cloud_noise_get_type_name(CloudNoiseType type);
+bool            cloud_noise_get_type_from_name(CloudNoiseType* out_type, const char* name);
+
+// Channels of <type> that differ between a bake with <baked_params> and one with <params>
+unsigned int    cloud_noise_get_dirty_channels(CloudNoiseType type, const noise_gen_paramters_data_t& baked_params, const noise_gen_paramters_data_t& params);
+
+// Bakes the channels in <channel_mask> for the voxels inside <brick> of an already sized RGBA8 <volume>, linear or bricked,
+// other channels are left untouched. Like the shaders, positions are per voxel (not normalized to the
+// volume size), so bigger volumes cover more of the noise field.
+void            cloud_noise_bake_brick(CloudNoiseType type, const noise_gen_paramters_data_t& params, unsigned int channel_mask, volume_buffer_t* volume, const volume_brick_t& brick);
+
+// Patches the channels in <channel_mask> of an already sized RGBA8 <volume> through volume_fill.
+// Blocks until done, needs job_system_init. <max_workers> 0 uses every core.
+void            cloud_noise_bake_channels(CloudNoiseType type, const noise_gen_paramters_data_t& params, unsigned int channel_mask, volume_buffer_t* volume, unsigned int max_workers = 0, volume_fill_stats_t* out_stats = nullptr);
+
+// Sizes <out_volume> and bakes every channel
+void            cloud_noise_bake(CloudNoiseType type, const noise_gen_paramters_data_t& params, unsigned int width, unsigned int height, unsigned int depth, volume_buffer_t* out_volume, unsigned int max_workers = 0, volume_fill_stats_t* out_stats = nullptr);
+
+// Cache loads and saves convert a bricked <layout> to and from the linear files
+void            cloud_noise_volume_init(cloud_noise_volume_t* noise_volume, CloudNoiseType type, unsigned int size, VolumeLayout layout = VOLUME_LAYOUT_LINEAR);
+
+// Rebakes whatever <params> dirtied since the last update (everything on the first one).
+// Returns the channels that were rebaked, 0 if the volume was already up to date.
+unsigned int    cloud_noise_volume_update(cloud_noise_volume_t* noise_volume, const noise_gen_paramters_data_t& params, unsigned int max_workers = 0, volume_fill_stats_t* out_stats = nullptr);
+
+// Progressive regen, for editing without stalling frames. begin returns false if
+// nothing is dirty (or a regen is already running), step returns true on the call
+// that finishes and swaps the new volume in.
+bool            cloud_noise_volume_begin_regen(cloud_noise_volume_t* noise_volume, const noise_gen_paramters_data_t& params);
+bool            cloud_noise_volume_step_regen(cloud_noise_volume_t* noise_volume, float budget_ms, unsigned int max_workers = 0);
+
+// Cache key for a volume of <type> baked with <params>. Only parameters that feed <type> go into
+// the key, so e.g. detail tweaks never invalidate cached base noise.
+uint64_t        cloud_noise_get_cache_key(CloudNoiseType type, const noise_gen_paramters_data_t& params, unsigned int width, unsigned int height, unsigned int depth);
+
+// Loads the volume baked with <params> if the cache has it. Not allowed mid-regen.
+// With <out_file> the entry stays mapped there for an upload of its mips, the
+// caller closes it.
+bool            cloud_noise_volume_load_from_cache(cloud_noise_volume_t* noise_volume, const volume_cache_t& cache, const noise_gen_paramters_data_t& params, volume_file_t* out_file = nullptr);
+// Stores the volume plus a CPU built mip chain, so loading it never needs GenerateMips
+bool            cloud_noise_volume_save_to_cache(const cloud_noise_volume_t& noise_volume, const volume_cache_t& cache);
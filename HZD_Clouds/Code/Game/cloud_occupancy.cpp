@@ -0,0 +1,498 @@
+#include "Game/cloud_occupancy.h"
+#include "Game/cloud_weather.h"
+
+#include "Engine/Core/Time.hpp"
+#include "Engine/Core/job.h"
+
+#include <math.h>
+#include <string.h>
+
+//-----------------------------------------------------
+// Internal helpers
+
+// Cells are bounded a little past their edges, so positions that drift off
+// by float error while stepping across a skipped cell are still covered
+static const float CELL_PADDING                 = 4.0f;
+
+// Slack on every bound for the float math in sample_density, and the batched
+// coverage samples' NOISE_BATCH_TOLERANCE
+static const float BOUND_EPSILON                = 0.001f;
+
+// Coverage is Perlin noise, bounded from samples this many to a cell edge
+static const unsigned int COVERAGE_SAMPLES_PER_CELL = 16;
+
+static const double INNER_LAYER_RADIUS          = (double)CLOUD_PLANET_RADIUS + CLOUD_LAYER_INNER_HEIGHT;
+static const double OUTER_LAYER_RADIUS          = (double)CLOUD_PLANET_RADIUS + CLOUD_LAYER_OUTER_HEIGHT;
+
+struct occupancy_build_t
+{
+    cloud_occupancy_t*                  occupancy;
+    const cloud_raymarch_params_t*      params;
+    const volume_sampler_t*             base;
+    const cloud_weather_map_t*          weather;
+
+    // sample_density's offsets that don't depend on height
+    float                               wind_x;
+    float                               wind_y;
+    float                               base_scale;
+    unsigned int                        mips[2];
+    unsigned int                        num_mips;
+
+    // Coverage sampled over the wind-shifted grid
+    float                               coverage_origin_x;
+    float                               coverage_origin_z;
+    float                               coverage_spacing;
+    float                               coverage_slope;
+    unsigned int                        coverage_num_x;
+    unsigned int                        coverage_num_z;
+    std::vector<float>                  coverage;
+};
+
+static unsigned int min_uint(unsigned int a, unsigned int b)
+{
+    return (a < b) ? a : b;
+}
+
+static void sample_coverage_row(unsigned int row, void* user_data)
+{
+    occupancy_build_t* build = (occupancy_build_t*)user_data;
+
+    float z = build->coverage_origin_z + ((float)row * build->coverage_spacing);
+    float* samples = build->coverage.data() + ((size_t)row * build->coverage_num_x);
+    cloud_raymarch_get_coverage_row(*build->params, build->coverage_origin_x, build->coverage_spacing, z, build->coverage_num_x, samples);
+}
+
+// Largest coverage over a shifted xz rectangle. Every point in it is within
+// half the spacing along x and along z of a sample, and coverage can't climb
+// faster than its slope bound along either.
+static float get_max_coverage(const occupancy_build_t& build, float x0, float x1, float z0, float z1)
+{
+    // Bilinear reads never leave the range of the texels they blend
+    if(nullptr != build.weather){
+        return cloud_weather_get_max_coverage(*build.weather, x0, z0, x1, z1);
+    }
+
+    int i0 = (int)floorf((x0 - build.coverage_origin_x) / build.coverage_spacing);
+    int i1 = (int)ceilf((x1 - build.coverage_origin_x) / build.coverage_spacing);
+    int j0 = (int)floorf((z0 - build.coverage_origin_z) / build.coverage_spacing);
+    int j1 = (int)ceilf((z1 - build.coverage_origin_z) / build.coverage_spacing);
+
+    i0 = (i0 < 0) ? 0 : i0;
+    j0 = (j0 < 0) ? 0 : j0;
+    i1 = (i1 >= (int)build.coverage_num_x) ? (int)build.coverage_num_x - 1 : i1;
+    j1 = (j1 >= (int)build.coverage_num_z) ? (int)build.coverage_num_z - 1 : j1;
+
+    float max_coverage = 0.0f;
+    for(int j = j0; j <= j1; ++j){
+        const float* row = build.coverage.data() + ((size_t)j * build.coverage_num_x);
+        for(int i = i0; i <= i1; ++i){
+            max_coverage = (row[i] > max_coverage) ? row[i] : max_coverage;
+        }
+    }
+    return max_coverage + (build.coverage_slope * build.coverage_spacing);
+}
+
+// Texels a trilinear read anywhere in [lo, hi] can touch along an axis of
+// <size>, false when that's all of them
+static bool get_texel_range(double lo, double hi, double scale, unsigned int size, int* out_t0, int* out_t1)
+{
+    *out_t0 = (int)floor((lo * scale * size) - 0.5);
+    *out_t1 = (int)floor((hi * scale * size) - 0.5) + 1;
+    return (*out_t1 - *out_t0 + 1) < (int)size;
+}
+
+static inline int wrap_texel(int t, int size)
+{
+    t %= size;
+    return (t < 0) ? t + size : t;
+}
+
+// Largest r and smallest fBm of the base noise inside a world box, over
+// every mip the march blends
+static void get_base_range(const occupancy_build_t& build, const double* box_min, const double* box_max, float* out_max_r, float* out_min_fbm)
+{
+    unsigned char max_r = 0;
+    float min_fbm = 255.0f;
+
+    for(unsigned int m = 0; m < build.num_mips; ++m){
+        const volume_view_t& mip = build.base->mips[build.mips[m]];
+
+        int x0, x1, y0, y1, z0, z1;
+        if(!get_texel_range(box_min[0], box_max[0], build.base_scale, mip.width, &x0, &x1)){
+            x0 = 0;
+            x1 = (int)mip.width - 1;
+        }
+        if(!get_texel_range(box_min[1], box_max[1], build.base_scale, mip.height, &y0, &y1)){
+            y0 = 0;
+            y1 = (int)mip.height - 1;
+        }
+        if(!get_texel_range(box_min[2], box_max[2], build.base_scale, mip.depth, &z0, &z1)){
+            z0 = 0;
+            z1 = (int)mip.depth - 1;
+        }
+
+        for(int z = z0; z <= z1; ++z){
+            for(int y = y0; y <= y1; ++y){
+                for(int x = x0; x <= x1; ++x){
+                    const unsigned char* voxel = mip.get_voxel(wrap_texel(x, mip.width), wrap_texel(y, mip.height), wrap_texel(z, mip.depth));
+                    float fbm = (voxel[1] * 0.625f) + (voxel[2] * 0.25f) + (voxel[3] * 0.125f);
+                    max_r = (voxel[0] > max_r) ? voxel[0] : max_r;
+                    min_fbm = (fbm < min_fbm) ? fbm : min_fbm;
+                }
+            }
+        }
+    }
+
+    *out_max_r = (float)max_r * (1.0f / 255.0f);
+    *out_min_fbm = min_fbm * (1.0f / 255.0f);
+}
+
+// The gradient rises to 1 over [0.05, 0.15], holds to 0.4 and falls by 0.85
+static float get_max_height_gradient(float hf0, float hf1)
+{
+    if((hf1 >= 0.15f) && (hf0 <= 0.4f)){
+        return 1.0f;
+    }
+    return fmaxf(cloud_raymarch_get_density_height_gradient(hf0), cloud_raymarch_get_density_height_gradient(hf1));
+}
+
+static void build_row(unsigned int cz, void* user_data)
+{
+    occupancy_build_t* build = (occupancy_build_t*)user_data;
+    cloud_occupancy_t* occupancy = build->occupancy;
+    cloud_occupancy_level_t& level = occupancy->levels[0];
+
+    double z0 = (double)occupancy->origin_z + ((double)cz * level.cell_size) - CELL_PADDING;
+    double z1 = z0 + level.cell_size + (2.0 * CELL_PADDING);
+    double nearest_z = (z0 > 0.0) ? z0 : ((z1 < 0.0) ? z1 : 0.0);
+    double farthest_z = (fabs(z0) > fabs(z1)) ? z0 : z1;
+
+    for(unsigned int cx = 0; cx < level.num_cells_x; ++cx){
+        double x0 = (double)occupancy->origin_x + ((double)cx * level.cell_size) - CELL_PADDING;
+        double x1 = x0 + level.cell_size + (2.0 * CELL_PADDING);
+        double nearest_x = (x0 > 0.0) ? x0 : ((x1 < 0.0) ? x1 : 0.0);
+        double farthest_x = (fabs(x0) > fabs(x1)) ? x0 : x1;
+
+        // Horizontal distance from the planet's axis, which sets how far the shell has curved down
+        double min_d2 = (nearest_x * nearest_x) + (nearest_z * nearest_z);
+        double max_d2 = (farthest_x * farthest_x) + (farthest_z * farthest_z);
+
+        for(unsigned int cy = 0; cy < level.num_cells_y; ++cy){
+            double r0 = INNER_LAYER_RADIUS + ((double)cy * level.cell_height) - CELL_PADDING;
+            double r1 = r0 + level.cell_height + (2.0 * CELL_PADDING);
+
+            float hf0 = cloud_saturate((float)((r0 - INNER_LAYER_RADIUS) / (OUTER_LAYER_RADIUS - INNER_LAYER_RADIUS)));
+            float hf1 = cloud_saturate((float)((r1 - INNER_LAYER_RADIUS) / (OUTER_LAYER_RADIUS - INNER_LAYER_RADIUS)));
+            float max_gradient = get_max_height_gradient(hf0, hf1);
+
+            float max_density = 0.0f;
+            if(max_gradient > 0.0f){
+                // The box sample_density reads after pushing by the wind and leaning the tops
+                double box_min[3];
+                double box_max[3];
+                box_min[0] = x0 + build->wind_x + (hf0 * CLOUD_WIND_TOP_OFFSET);
+                box_max[0] = x1 + build->wind_x + (hf1 * CLOUD_WIND_TOP_OFFSET);
+                box_min[1] = ((r0 * r0 > max_d2) ? sqrt((r0 * r0) - max_d2) : 0.0) - CLOUD_PLANET_RADIUS + build->wind_y;
+                box_max[1] = sqrt((r1 * r1) - min_d2) - CLOUD_PLANET_RADIUS + build->wind_y;
+                box_min[2] = z0;
+                box_max[2] = z1;
+
+                float max_coverage = get_max_coverage(*build, (float)box_min[0], (float)box_max[0], (float)z0, (float)z1);
+
+                float max_r, min_fbm;
+                get_base_range(*build, box_min, box_max, &max_r, &min_fbm);
+
+                // range_map(r, -(1 - fbm), 1, 0, 1) grows with r and shrinks with fbm
+                float max_base = ((max_r + 1.0f - min_fbm) / (2.0f - min_fbm)) * max_gradient;
+                max_density = cloud_saturate(max_base + max_coverage - 1.0f + BOUND_EPSILON);
+            }
+
+            level.max_density[level.get_index(cx, cy, cz)] = max_density;
+        }
+    }
+}
+
+// Odd counts round up, so the last coarse cell along an axis hangs past the
+// fine level. Nothing bounds that part, it counts as occupied.
+static void build_coarser_level(const cloud_occupancy_level_t& fine, cloud_occupancy_level_t* out_coarse)
+{
+    out_coarse->num_cells_x = (fine.num_cells_x + 1) / 2;
+    out_coarse->num_cells_y = (fine.num_cells_y + 1) / 2;
+    out_coarse->num_cells_z = (fine.num_cells_z + 1) / 2;
+    out_coarse->cell_size = fine.cell_size * 2.0f;
+    out_coarse->cell_height = fine.cell_height * 2.0f;
+    out_coarse->max_density.assign((size_t)out_coarse->num_cells_x * out_coarse->num_cells_y * out_coarse->num_cells_z, 0.0f);
+
+    for(unsigned int z = 0; z < out_coarse->num_cells_z * 2; ++z){
+        for(unsigned int y = 0; y < out_coarse->num_cells_y * 2; ++y){
+            for(unsigned int x = 0; x < out_coarse->num_cells_x * 2; ++x){
+                bool is_inside = (x < fine.num_cells_x) && (y < fine.num_cells_y) && (z < fine.num_cells_z);
+                float& coarse = out_coarse->max_density[out_coarse->get_index(x / 2, y / 2, z / 2)];
+                coarse = fmaxf(coarse, is_inside ? fine.max_density[fine.get_index(x, y, z)] : 1.0f);
+            }
+        }
+    }
+}
+
+// Cell under <world_pos>, false outside the grid or the layer
+static bool get_cell(const cloud_occupancy_t& occupancy, unsigned int level_index, const Vector3& world_pos, double radius, unsigned int* out_x, unsigned int* out_y, unsigned int* out_z)
+{
+    const cloud_occupancy_level_t& level = occupancy.levels[level_index];
+
+    float fx = (world_pos.x - occupancy.origin_x) / level.cell_size;
+    float fz = (world_pos.z - occupancy.origin_z) / level.cell_size;
+    double fy = (radius - INNER_LAYER_RADIUS) / level.cell_height;
+    if((fx < 0.0f) || (fz < 0.0f) || (fy < 0.0)){
+        return false;
+    }
+
+    *out_x = (unsigned int)fx;
+    *out_y = (unsigned int)fy;
+    *out_z = (unsigned int)fz;
+    return (*out_x < level.num_cells_x) && (*out_y < level.num_cells_y) && (*out_z < level.num_cells_z);
+}
+
+static double get_distance_to_planet_center(const Vector3& world_pos)
+{
+    double dy = (double)world_pos.y + CLOUD_PLANET_RADIUS;
+    return sqrt(((double)world_pos.x * world_pos.x) + (dy * dy) + ((double)world_pos.z * world_pos.z));
+}
+
+// How far along <ray_dir> until the ray leaves the cell, through a side or
+// the slab's top or bottom sphere
+static double get_cell_exit_distance(const cloud_occupancy_t& occupancy, unsigned int level_index, unsigned int cx, unsigned int cy, unsigned int cz, const Vector3& world_pos, const Vector3& ray_dir)
+{
+    const cloud_occupancy_level_t& level = occupancy.levels[level_index];
+
+    double exit = 1e30;
+
+    double x0 = (double)occupancy.origin_x + ((double)cx * level.cell_size);
+    if(ray_dir.x > 0.0f){
+        exit = fmin(exit, (x0 + level.cell_size - world_pos.x) / ray_dir.x);
+    }else if(ray_dir.x < 0.0f){
+        exit = fmin(exit, (x0 - world_pos.x) / ray_dir.x);
+    }
+
+    double z0 = (double)occupancy.origin_z + ((double)cz * level.cell_size);
+    if(ray_dir.z > 0.0f){
+        exit = fmin(exit, (z0 + level.cell_size - world_pos.z) / ray_dir.z);
+    }else if(ray_dir.z < 0.0f){
+        exit = fmin(exit, (z0 - world_pos.z) / ray_dir.z);
+    }
+
+    double lx = world_pos.x;
+    double ly = (double)world_pos.y + CLOUD_PLANET_RADIUS;
+    double lz = world_pos.z;
+    double b = (ray_dir.x * lx) + (ray_dir.y * ly) + (ray_dir.z * lz);
+    double l2 = (lx * lx) + (ly * ly) + (lz * lz);
+
+    // always inside the top sphere, so there's always a way out through it
+    double r1 = INNER_LAYER_RADIUS + ((double)(cy + 1) * level.cell_height);
+    double discr1 = (b * b) - (l2 - (r1 * r1));
+    exit = fmin(exit, -b + sqrt(fmax(discr1, 0.0)));
+
+    // the bottom sphere only if the ray is heading down into it
+    double r0 = INNER_LAYER_RADIUS + ((double)cy * level.cell_height);
+    double discr0 = (b * b) - (l2 - (r0 * r0));
+    if((discr0 >= 0.0) && (b < 0.0)){
+        exit = fmin(exit, -b - sqrt(discr0));
+    }
+
+    return (exit > 0.0) ? exit : 0.0;
+}
+
+//-----------------------------------------------------
+// Public API
+
+void cloud_occupancy_init(cloud_occupancy_t* occupancy, float center_x, float center_z, float radius, float cell_size, unsigned int num_layers)
+{
+    unsigned int num_cells = (unsigned int)ceilf((2.0f * radius) / cell_size);
+    num_cells = (num_cells > 0) ? num_cells : 1;
+    num_layers = (num_layers > 0) ? num_layers : 1;
+
+    occupancy->origin_x = center_x - (0.5f * num_cells * cell_size);
+    occupancy->origin_z = center_z - (0.5f * num_cells * cell_size);
+
+    cloud_occupancy_level_t& level = occupancy->levels[0];
+    level.num_cells_x = num_cells;
+    level.num_cells_y = num_layers;
+    level.num_cells_z = num_cells;
+    level.cell_size = cell_size;
+    level.cell_height = (CLOUD_LAYER_OUTER_HEIGHT - CLOUD_LAYER_INNER_HEIGHT) / (float)num_layers;
+    level.max_density.assign((size_t)num_cells * num_cells * num_layers, 1.0f);
+
+    occupancy->num_levels = 1;
+    occupancy->is_built = false;
+}
+
+void cloud_occupancy_build(cloud_occupancy_t* occupancy, const cloud_raymarch_params_t& params, const cloud_raymarch_volumes_t& volumes, unsigned int max_workers)
+{
+    double start = get_current_time_seconds();
+    cloud_occupancy_level_t& level = occupancy->levels[0];
+
+    occupancy_build_t build;
+    build.occupancy     = occupancy;
+    build.params        = &params;
+    build.base          = &volumes.base;
+    build.weather       = volumes.weather;
+
+    // Same offsets as sample_density
+    float wind_distance = params.game_time * (params.knobs[6] * 1000.0f);
+    build.wind_x        = wind_distance;
+    build.wind_y        = 0.1f * wind_distance;
+    build.base_scale    = cloud_range_map(params.knobs[0], 0.0f, 1.0f, 0.0f, 0.001f);
+
+    // The two mips volume_sample_trilinear blends for the march's mip
+    float max_mip = (float)(volumes.base.num_mips - 1);
+    float mip = params.knobs[1] * 10.0f;
+    mip = !(mip > 0.0f) ? 0.0f : ((mip > max_mip) ? max_mip : mip);
+    build.mips[0] = (unsigned int)mip;
+    build.mips[1] = build.mips[0] + 1;
+    build.num_mips = ((mip > (float)build.mips[0]) && (build.mips[1] < volumes.base.num_mips)) ? 2 : 1;
+
+    // Coverage samples over everything the shifted cells can reach
+    build.coverage_spacing = level.cell_size / (float)COVERAGE_SAMPLES_PER_CELL;
+    build.coverage_slope = cloud_raymarch_get_coverage_max_slope();
+    build.coverage_origin_x = occupancy->origin_x + build.wind_x - CELL_PADDING - build.coverage_spacing;
+    build.coverage_origin_z = occupancy->origin_z - CELL_PADDING - build.coverage_spacing;
+    float extent = level.num_cells_x * level.cell_size;
+    build.coverage_num_x = (unsigned int)ceilf((extent + CLOUD_WIND_TOP_OFFSET + (2.0f * CELL_PADDING)) / build.coverage_spacing) + 3;
+    build.coverage_num_z = (unsigned int)ceilf((level.num_cells_z * level.cell_size + (2.0f * CELL_PADDING)) / build.coverage_spacing) + 3;
+    if(nullptr == build.weather){
+        build.coverage.resize((size_t)build.coverage_num_x * build.coverage_num_z);
+        job_parallel_for(build.coverage_num_z, sample_coverage_row, &build, max_workers);
+    }
+    occupancy->num_workers = job_parallel_for(level.num_cells_z, build_row, &build, max_workers);
+
+    occupancy->num_empty_cells = 0;
+    for(float max_density : level.max_density){
+        occupancy->num_empty_cells += (max_density <= 0.0f) ? 1 : 0;
+    }
+
+    occupancy->num_levels = 1;
+    while(occupancy->num_levels < CLOUD_OCCUPANCY_MAX_LEVELS){
+        const cloud_occupancy_level_t& fine = occupancy->levels[occupancy->num_levels - 1];
+        if((fine.num_cells_x == 1) && (fine.num_cells_y == 1) && (fine.num_cells_z == 1)){
+            break;
+        }
+        build_coarser_level(fine, &occupancy->levels[occupancy->num_levels]);
+        ++occupancy->num_levels;
+    }
+
+    occupancy->is_built         = true;
+    occupancy->base_data        = volumes.base.mips[0].data;
+    occupancy->base_scale       = params.knobs[0];
+    occupancy->march_mip        = params.knobs[1];
+    occupancy->coverage_time    = params.game_time * params.knobs[5];
+    occupancy->weather          = volumes.weather;
+    occupancy->weather_version  = (nullptr != volumes.weather) ? volumes.weather->version : 0;
+    occupancy->wind_distance    = wind_distance;
+    occupancy->build_seconds    = get_current_time_seconds() - start;
+}
+
+bool cloud_occupancy_update(cloud_occupancy_t* occupancy, const cloud_raymarch_params_t& params, const cloud_raymarch_volumes_t& volumes, unsigned int max_workers)
+{
+    bool is_current = occupancy->is_built
+        && (occupancy->base_data == volumes.base.mips[0].data)
+        && (occupancy->base_scale == params.knobs[0])
+        && (occupancy->march_mip == params.knobs[1])
+        && (occupancy->coverage_time == params.game_time * params.knobs[5])
+        && (occupancy->weather == volumes.weather)
+        && ((nullptr == volumes.weather) || (occupancy->weather_version == volumes.weather->version))
+        && (occupancy->wind_distance == params.game_time * (params.knobs[6] * 1000.0f));
+
+    if(is_current){
+        return false;
+    }
+
+    cloud_occupancy_build(occupancy, params, volumes, max_workers);
+    return true;
+}
+
+float cloud_occupancy_get_max_density(const cloud_occupancy_t& occupancy, unsigned int level, const Vector3& world_pos)
+{
+    unsigned int cx, cy, cz;
+    if((level >= occupancy.num_levels) || !get_cell(occupancy, level, world_pos, get_distance_to_planet_center(world_pos), &cx, &cy, &cz)){
+        return 1.0f;
+    }
+    return occupancy.levels[level].max_density[occupancy.levels[level].get_index(cx, cy, cz)];
+}
+
+unsigned int cloud_occupancy_get_num_empty_steps(const cloud_occupancy_t& occupancy, const Vector3& world_pos, const Vector3& ray_dir, float step_size)
+{
+    double radius = get_distance_to_planet_center(world_pos);
+
+    for(int level_index = (int)occupancy.num_levels - 1; level_index >= 0; --level_index){
+        unsigned int cx, cy, cz;
+        if(!get_cell(occupancy, (unsigned int)level_index, world_pos, radius, &cx, &cy, &cz)){
+            return 0;
+        }
+
+        const cloud_occupancy_level_t& level = occupancy.levels[level_index];
+        if(level.max_density[level.get_index(cx, cy, cz)] > 0.0f){
+            continue;
+        }
+
+        // Only steps strictly inside the cell, the current one always is
+        double exit = get_cell_exit_distance(occupancy, (unsigned int)level_index, cx, cy, cz, world_pos, ray_dir);
+        unsigned int num_steps = (unsigned int)(exit / step_size);
+        return (num_steps > 0) ? num_steps : 1;
+    }
+    return 0;
+}
+
+void cloud_occupancy_march(const cloud_occupancy_t* occupancy, const cloud_raymarch_params_t& params, const cloud_raymarch_volumes_t& volumes, const Vector3& start, const Vector3& end, cloud_density_ray_t* out_ray)
+{
+    memset(out_ray, 0, sizeof(*out_ray));
+    out_ray->transmittance = 1.0f;
+
+    // Same setup as do_cloud_ray_march
+    Vector3 ray_disp = end - start;
+    Vector3 ray_dir = ray_disp.Normalized();
+
+    unsigned int num_steps = (unsigned int)(params.sliders[5] * 128.0f);
+    if(num_steps == 0){
+        return;
+    }
+
+    Vector3 ds = ray_disp / (float)num_steps;
+    float step_size = ds.CalcLength();
+    float absorption_mult = -params.sliders[4] * step_size;
+    float mip = params.knobs[1] * 10.0f;
+
+    bool can_skip = (nullptr != occupancy) && occupancy->is_built && (step_size > 0.0f);
+
+    Vector3 pos = start;
+    unsigned int i = 0;
+    while(i < num_steps){
+        if(can_skip){
+            unsigned int num_empty = cloud_occupancy_get_num_empty_steps(*occupancy, pos, ray_dir, step_size);
+            if(num_empty > 0){
+                num_empty = min_uint(num_empty, num_steps - i);
+
+                // Empty steps leave the transmittance alone. The position is still
+                // stepped one at a time so later samples land exactly where the
+                // shader's would.
+                for(unsigned int k = 0; k < num_empty; ++k){
+                    pos = pos + ds;
+                }
+                i += num_empty;
+                out_ray->num_skipped_steps += num_empty;
+                continue;
+            }
+        }
+
+        float density = cloud_saturate(cloud_raymarch_sample_density(params, volumes, pos, mip, false));
+        ++out_ray->num_density_samples;
+        ++i;
+
+        out_ray->transmittance *= expf(absorption_mult * density);
+        if(out_ray->transmittance <= 0.00001f){
+            break;
+        }
+
+        pos = pos + ds;
+    }
+
+    out_ray->num_steps = i;
+}
@@ -0,0 +1,122 @@
+#pragma once
+
+#include "Game/cloud_raymarch.h"
+
+#include <vector>
+
+//-----------------------------------------------------
+// Cloud occupancy
+//
+// Upper bounds on sample_density over coarse cells of the cloud layer, so a
+// march can hop over air instead of sampling it. Cells are square columns of
+// the xz plane cut into slabs of altitude (distance from the planet center),
+// which follows the curve of the layer. A cell's bound takes the largest base
+// noise and coverage its wind-shifted footprint can read and the best height
+// gradient its altitudes allow. Coverage is sampled on a grid and bounded in
+// between by its slope, see cloud_raymarch_get_coverage_max_slope, or read
+// off the texels of the volumes' weather map when there is one. Each
+// coarser level holds the max of the 2x2x2 cells under it, with any part
+// hanging past the finer level counted as occupied.
+//
+// Density comes out of sample_density as base + coverage - 1 before the
+// detail erosion, which only ever takes density away, so a cell whose bound
+// is 0 saturates to 0 everywhere inside it.
+//
+// Bounds depend on the base volume, base scale, march mip, wind, coverage
+// animation and weather map. cloud_occupancy_update rebuilds when any of
+// those moved.
+
+#define CLOUD_OCCUPANCY_MAX_LEVELS      8
+
+struct cloud_occupancy_level_t
+{
+    unsigned int        num_cells_x;
+    unsigned int        num_cells_y;        // altitude slabs
+    unsigned int        num_cells_z;
+    float               cell_size;          // xz, meters
+    float               cell_height;        // altitude, meters
+    std::vector<float>  max_density;        // x fastest, then altitude, then z
+
+    cloud_occupancy_level_t()
+        :num_cells_x(0)
+        ,num_cells_y(0)
+        ,num_cells_z(0)
+        ,cell_size(0.0f)
+        ,cell_height(0.0f)
+    {}
+
+    size_t get_index(unsigned int x, unsigned int y, unsigned int z) const  { return ((size_t)z * num_cells_y + y) * num_cells_x + x; }
+};
+
+struct cloud_occupancy_t
+{
+    float                       origin_x;           // world xz of the grid's corner
+    float                       origin_z;
+    cloud_occupancy_level_t     levels[CLOUD_OCCUPANCY_MAX_LEVELS];
+    unsigned int                num_levels;
+
+    // What the bounds were built for
+    bool                        is_built;
+    const unsigned char*        base_data;
+    float                       base_scale;
+    float                       march_mip;
+    float                       coverage_time;
+    float                       wind_distance;
+    const cloud_weather_map_t*  weather;
+    unsigned int                weather_version;
+
+    double                      build_seconds;
+    unsigned int                num_workers;
+    unsigned int                num_empty_cells;    // finest level
+
+    cloud_occupancy_t()
+        :origin_x(0.0f)
+        ,origin_z(0.0f)
+        ,num_levels(0)
+        ,is_built(false)
+        ,base_data(nullptr)
+        ,base_scale(0.0f)
+        ,march_mip(0.0f)
+        ,coverage_time(0.0f)
+        ,wind_distance(0.0f)
+        ,weather(nullptr)
+        ,weather_version(0)
+        ,build_seconds(0.0)
+        ,num_workers(0)
+        ,num_empty_cells(0)
+    {}
+};
+
+// What a density march did, with or without skipping
+struct cloud_density_ray_t
+{
+    float           transmittance;
+    unsigned int    num_steps;              // of the shader's fixed step count, sampled or skipped
+    unsigned int    num_skipped_steps;
+    unsigned int    num_density_samples;
+};
+
+// Grid of <cell_size> columns covering <radius> around <center_x, center_z>,
+// with the layer's thickness cut into <num_layers> slabs. Nothing is built yet.
+void    cloud_occupancy_init(cloud_occupancy_t* occupancy, float center_x, float center_z, float radius, float cell_size, unsigned int num_layers);
+
+// Rebuilds every level for <params>, z rows of columns split across GENERIC
+// jobs plus the caller. Needs job_system_init, <max_workers> 0 uses every core.
+void    cloud_occupancy_build(cloud_occupancy_t* occupancy, const cloud_raymarch_params_t& params, const cloud_raymarch_volumes_t& volumes, unsigned int max_workers = 0);
+
+// Builds only if something the bounds depend on changed, returns whether it did
+bool    cloud_occupancy_update(cloud_occupancy_t* occupancy, const cloud_raymarch_params_t& params, const cloud_raymarch_volumes_t& volumes, unsigned int max_workers = 0);
+
+// Bound of the cell under <world_pos>, 1 outside the grid
+float   cloud_occupancy_get_max_density(const cloud_occupancy_t& occupancy, unsigned int level, const Vector3& world_pos);
+
+// Steps of <step_size> along <ray_dir> from <world_pos> that sit in one empty
+// cell, the coarsest empty level's, 0 when the cell under it isn't empty or
+// it's off the grid. The renderer's march skips these.
+unsigned int cloud_occupancy_get_num_empty_steps(const cloud_occupancy_t& occupancy, const Vector3& world_pos, const Vector3& ray_dir, float step_size);
+
+// The transmittance half of do_cloud_ray_march between <start> and <end>,
+// same steps and the same early out. With <occupancy> the steps that fall in
+// empty cells are skipped a whole cell at a time, without it every step is
+// sampled; both give the same transmittance to the bit.
+void    cloud_occupancy_march(const cloud_occupancy_t* occupancy, const cloud_raymarch_params_t& params, const cloud_raymarch_volumes_t& volumes, const Vector3& start, const Vector3& end, cloud_density_ray_t* out_ray);
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "Engine/Math/Matrix4.hpp"
+#include "Engine/Math/Vector2.hpp"
+#include "Engine/Math/Vector3.hpp"
+#include "Engine/Math/Vector4.hpp"
+
+// Matches view_camera_buffer (b4) in the cloud shaders, keep in sync
+struct cloud_parameters_data_t
+{
+    Matrix4     transform;
+
+    float       focal_length;
+    float       scale;
+    float       coverage;
+    float       cloud_layer_top_y;
+
+    float       cloud_layer_bottom_y;
+    Vector3     sun_position;
+
+    float       light_step_size;
+    float       detail_scale;
+    Vector2     padding;
+
+    Vector4     stratus_grad;
+    Vector4     cumulus_grad;
+    Vector4     cumulonumbis_grad;
+    Vector4     wind;
+    Vector4     weather_map;    // x 1 / extent in meters, y 1 when the weather map is bound
+};
+
+// The look App starts from before the config has its say. Camera, focal
+// length and weather map are left for the frame to fill in.
+inline void cloud_parameters_set_defaults(cloud_parameters_data_t* data)
+{
+    *data = cloud_parameters_data_t();
+    data->scale                 = 0.000025f;
+    data->coverage              = 0.585002170f;
+    data->cloud_layer_top_y     = 6000.f;
+    data->cloud_layer_bottom_y  = 4500.f;
+    data->sun_position          = Vector3(10000000.0f, 1000000.0f, 10000000.0f);
+    data->light_step_size       = 100.0f;
+    data->detail_scale          = 0.00005f;
+    data->stratus_grad          = Vector4(0.05f, 0.08f, 0.14f, 0.16f);
+    data->cumulus_grad          = Vector4(0.05f, 0.20f, 0.50f, 0.65f);
+    data->cumulonumbis_grad     = Vector4(0.05f, 0.15f, 0.8f, 0.9f);
+    data->wind                  = Vector4(0.0f, 0.0f, 1.0f, 0.f);
+}
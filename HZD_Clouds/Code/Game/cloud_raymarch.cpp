@@ -0,0 +1,576 @@
+#include "Game/cloud_raymarch.h"
+#include "Game/cloud_light.h"
+#include "Game/cloud_occupancy.h"
+#include "Game/cloud_raymarch_lanes.h"
+#include "Game/cloud_weather.h"
+
+#include "Engine/Core/Config.hpp"
+#include "Engine/Core/crt_compat.h"
+#include "Engine/Core/Time.hpp"
+#include "Engine/Core/cpu.h"
+#include "Engine/Core/job.h"
+#include "Engine/Math/MathUtils.hpp"
+#include "Engine/Math/Noise.hpp"
+
+#include "ThirdParty/stb/stb_image_write.h"
+
+#include <math.h>
+#include <stdio.h>
+
+//-----------------------------------------------------
+// Internal helpers
+
+const Vector3 RANDOM_VECTORS[NUM_LIGHT_STEPS] =
+{
+    Vector3(0.38051305f, 0.92453449f, -0.02111345f),
+    Vector3(-0.50625799f, -0.03590792f, -0.86163418f),
+    Vector3(-0.32509218f, -0.94557439f, 0.01428793f),
+    Vector3(0.09026238f, -0.27376545f, 0.95755165f),
+    Vector3(0.28128598f, 0.42443639f, -0.86065785f),
+    Vector3(-0.16852403f, 0.14748697f, 0.97460106f)
+};
+
+static unsigned int ray_sphere_intersect(const Vector3& ray_origin, Vector3 ray_dir, const Vector3& sphere_origin, float sphere_radius, float* out_t)
+{
+    ray_dir.Normalize();
+
+    Vector3 l = ray_origin - sphere_origin;
+
+    float a = 1.0f;
+    float b = 2.0f * DotProduct(ray_dir, l);
+    float c = DotProduct(l, l) - (sphere_radius * sphere_radius);
+
+    float discr = (b * b) - (4.0f * a * c);
+
+    if(discr < 0.0f){
+        out_t[0] = out_t[1] = 0.0f;
+        return 0;
+    }else if(fabsf(discr) - 0.00005f <= 0.0f){
+        out_t[0] = out_t[1] = -0.5f * b / a;
+        return 1;
+    }
+
+    float q = (b > 0.0f) ? -0.5f * (b + sqrtf(discr)) : -0.5f * (b - sqrtf(discr));
+    float h1 = q / a;
+    float h2 = c / q;
+    out_t[0] = (h1 < h2) ? h1 : h2;
+    out_t[1] = (h1 < h2) ? h2 : h1;
+    if(out_t[0] < 0.0f){
+        out_t[0] = out_t[1];
+        return (out_t[0] < 0.0f) ? 0 : 1;
+    }
+    return 2;
+}
+
+static float sample_density(const march_context_t& context, Vector3 world_pos, float mip_level, bool do_cheap)
+{
+    const cloud_raymarch_params_t& params = *context.params;
+    ++context.counters->num_density_samples;
+
+    float height_fraction = cloud_raymarch_get_height_fraction(world_pos);
+
+    // wind, tops of the clouds pushed along with it
+    Vector3 wind_direction(1.0f, 0.0f, 0.0f);
+    float cloud_speed = params.knobs[6] * 1000.0f;
+
+    world_pos = world_pos + (wind_direction * (height_fraction * CLOUD_WIND_TOP_OFFSET));
+    world_pos = world_pos + ((wind_direction + Vector3(0.0f, 0.1f, 0.0f)) * (params.game_time * cloud_speed));
+
+    // base shape, dilated by the low frequency fBm
+    float scale = cloud_range_map(params.knobs[0], 0.0f, 1.0f, 0.0f, 0.001f);
+    float low_freq_noises[4];
+    volume_sample_trilinear(context.volumes->base, world_pos.x * scale, world_pos.y * scale, world_pos.z * scale, mip_level, low_freq_noises);
+
+    float low_freq_fbm = (low_freq_noises[1] * 0.625f) + (low_freq_noises[2] * 0.25f) + (low_freq_noises[3] * 0.125f);
+    float base_cloud = cloud_range_map(low_freq_noises[0], -(1.0f - low_freq_fbm), 1.0f, 0.0f, 1.0f);
+    base_cloud *= cloud_raymarch_get_density_height_gradient(height_fraction);
+
+    // coverage, smaller clouds come out lighter
+    float cloud_coverage = (nullptr != context.volumes->weather)
+        ? cloud_weather_get_coverage(*context.volumes->weather, world_pos.x, world_pos.z)
+        : cloud_raymarch_get_coverage(params, world_pos.x, world_pos.z);
+    float base_cloud_with_coverage = cloud_range_map(base_cloud, 1.0f - cloud_coverage, 1.0f, 0.0f, 1.0f);
+    base_cloud_with_coverage *= cloud_coverage;
+
+    float final_cloud = base_cloud_with_coverage;
+    if(!do_cheap){
+        // erode with the detail noise, wispy at the bottom and billowy higher up
+        float detail_scale = cloud_range_map(params.knobs[2], 0.0f, 1.0f, 0.0f, 0.001f);
+        float high_frequency_noises[4];
+        volume_sample_trilinear(context.volumes->detail, world_pos.x * detail_scale, world_pos.y * detail_scale, world_pos.z * detail_scale, 0.0f, high_frequency_noises);
+
+        float high_freq_fbm = (high_frequency_noises[1] * 0.625f) + (high_frequency_noises[2] * 0.25f) + (high_frequency_noises[3] * 0.125f);
+        float high_freq_noise_modifier = Interpolate(high_freq_fbm, 1.0f - high_freq_fbm, cloud_saturate(height_fraction * 10.0f));
+
+        final_cloud = cloud_range_map(final_cloud, high_freq_noise_modifier * 0.2f, 1.0f, 0.0f, 1.0f);
+    }
+
+    return final_cloud;
+}
+
+// The light cone from <start_pos> toward <light_pos>
+static float march_light_cone(const march_context_t& context, const Vector3& start_pos, const Vector3& light_pos)
+{
+    const cloud_raymarch_params_t& params = *context.params;
+    float step_size = params.knobs[8] * 500.0f;
+    float mip_level = params.knobs[7] * 10.0f;
+
+    float cone_radius = 5.0f;
+    Vector3 to_light = (light_pos - start_pos).Normalized();
+
+    Vector3 pos = start_pos;
+    float total_density = 0.0f;
+    for(unsigned int i = 1; i <= NUM_LIGHT_STEPS; ++i){
+        Vector3 cone_pos = pos + (RANDOM_VECTORS[i - 1] * (cone_radius * (float)i));
+
+        int mip_offset = (int)((float)i * 0.5f);
+        total_density += sample_density(context, cone_pos, mip_level + (float)mip_offset, true);
+
+        pos = pos + (to_light * step_size);
+    }
+
+    return expf(-total_density);
+}
+
+// Light reaching <start_pos>, scaled by the phase function. <phase> doesn't
+// change along a ray so the caller works it out once.
+static Vector3 calc_incident_light(const march_context_t& context, const Vector3& start_pos, const Vector3& light_pos, float phase, const Vector3& scattering_coef)
+{
+    const cloud_light_volume_t* light = context.volumes->light;
+
+    float transmittance;
+    if((nullptr != light) && cloud_light_get_transmittance(*light, *context.params, start_pos, &transmittance)){
+        ++context.counters->num_light_lookups;
+    }else{
+        transmittance = march_light_cone(context, start_pos, light_pos);
+    }
+    return scattering_coef * (transmittance * phase);
+}
+
+static void do_cloud_ray_march(const march_context_t& context, const Vector3& cloud_layer_start, const Vector3& cloud_layer_end, const Vector3& to_light, float* out_rgba)
+{
+    const cloud_raymarch_params_t& params = *context.params;
+    out_rgba[0] = out_rgba[1] = out_rgba[2] = out_rgba[3] = 0.0f;
+
+    Vector3 ray_disp = cloud_layer_end - cloud_layer_start;
+    Vector3 ray_dir = ray_disp.Normalized();
+
+    // The shader divides by zero steps and marches nothing, same black pixel
+    unsigned int num_steps = get_num_steps(params, ray_dir);
+    if(num_steps == 0){
+        return;
+    }
+
+    Vector3 ds = ray_disp / (float)num_steps;
+    float step_size = ds.CalcLength();
+
+    float cos_angle = DotProduct(to_light.Normalized(), ray_dir);
+    float phase = get_phase(params, cos_angle);
+
+    Vector3 scattering_coef(params.sliders[0] * 2.0f, params.sliders[1] * 2.0f, params.sliders[2] * 2.0f);
+    float absorption_mult = -params.sliders[4] * step_size;
+    float mip = params.knobs[1] * 10.0f;
+
+    float transmittance = 1.0f;
+    Vector3 color(0.0f, 0.0f, 0.0f);
+    float opacity = 0.0f;
+
+    // Steps in empty cells have 0 density, which leaves transmittance and
+    // opacity exactly where they were, so their density sample goes. Color
+    // still blends in every step's light, except while transmittance is still
+    // 1 when each step overwrites it. Those light marches go too, bar the one
+    // for the step before sampling starts again.
+    bool can_skip = (nullptr != context.occupancy) && context.occupancy->is_built && (step_size > 0.0f);
+    unsigned int num_empty_steps = 0;
+    bool is_light_deferred = false;
+    Vector3 deferred_light_pos;
+
+    Vector3 pos = cloud_layer_start;
+    for(unsigned int i = 0; i < num_steps; ++i){
+        ++context.counters->num_steps;
+
+        if(can_skip && (num_empty_steps == 0)){
+            num_empty_steps = cloud_occupancy_get_num_empty_steps(*context.occupancy, pos, ray_dir, step_size);
+        }
+
+        float density = 0.0f;
+        if(num_empty_steps > 0){
+            --num_empty_steps;
+            ++context.counters->num_skipped_steps;
+
+            if(transmittance == 1.0f){
+                is_light_deferred = true;
+                deferred_light_pos = pos;
+                pos = pos + ds;
+                continue;
+            }
+        }else{
+            if(is_light_deferred){
+                color = calc_incident_light(context, deferred_light_pos, params.cloud.sun_position, phase, scattering_coef);
+                is_light_deferred = false;
+            }
+            density = cloud_saturate(sample_density(context, pos, mip, false));
+        }
+
+        float dt = expf(absorption_mult * density);
+        transmittance *= dt;
+
+        Vector3 incident_light = calc_incident_light(context, pos, params.cloud.sun_position, phase, scattering_coef);
+
+        color = (color * (1.0f - transmittance)) + (incident_light * transmittance);
+        opacity += (1.0f - opacity) * (1.0f - dt);
+
+        if(transmittance <= 0.00001f){
+            break;
+        }
+
+        pos = pos + ds;
+    }
+
+    // gamma, then premultiply
+    const float inv_gamma = 1.0f / 2.2f;
+    out_rgba[0] = powf(fabsf(color.x), inv_gamma) * opacity;
+    out_rgba[1] = powf(fabsf(color.y), inv_gamma) * opacity;
+    out_rgba[2] = powf(fabsf(color.z), inv_gamma) * opacity;
+    out_rgba[3] = opacity;
+}
+
+static void march_pixel(const march_context_t& context, float u, float v, float* out_rgba)
+{
+    Vector3 eye_world_pos;
+    Vector3 ray_dir;
+    cloud_raymarch_get_ray(*context.params, u, v, &eye_world_pos, &ray_dir);
+
+    Vector3 light = (context.params->cloud.sun_position - eye_world_pos).Normalized();
+
+    Vector3 cloud_layer_start;
+    Vector3 cloud_layer_end;
+    if(!cloud_raymarch_get_cloud_layer(eye_world_pos, ray_dir, &cloud_layer_start, &cloud_layer_end)){
+        out_rgba[0] = out_rgba[1] = out_rgba[2] = out_rgba[3] = 0.0f;
+        return;
+    }
+
+    ++context.counters->num_rays;
+    do_cloud_ray_march(context, cloud_layer_start, cloud_layer_end, light, out_rgba);
+}
+
+static void render_tile(unsigned int tile, void* user_data)
+{
+    render_pass_t* pass = (render_pass_t*)user_data;
+    cloud_image_t* image = pass->image;
+
+    march_context_t context;
+    context.params      = pass->params;
+    context.volumes     = pass->volumes;
+    context.occupancy   = pass->occupancy;
+    context.counters    = &pass->tile_counters[tile];
+
+    unsigned int x0 = (tile % pass->num_tiles_x) * CLOUD_RAYMARCH_TILE_SIZE;
+    unsigned int y0 = (tile / pass->num_tiles_x) * CLOUD_RAYMARCH_TILE_SIZE;
+    unsigned int x1 = (x0 + CLOUD_RAYMARCH_TILE_SIZE < image->width) ? x0 + CLOUD_RAYMARCH_TILE_SIZE : image->width;
+    unsigned int y1 = (y0 + CLOUD_RAYMARCH_TILE_SIZE < image->height) ? y0 + CLOUD_RAYMARCH_TILE_SIZE : image->height;
+
+    float inv_width = 1.0f / (float)image->width;
+    float inv_height = 1.0f / (float)image->height;
+    for(unsigned int y = y0; y < y1; ++y){
+        float v = ((float)y + 0.5f) * inv_height;
+        for(unsigned int x = x0; x < x1; ++x){
+            float u = ((float)x + 0.5f) * inv_width;
+            march_pixel(context, u, v, image->get_pixel(x, y));
+        }
+    }
+}
+
+// Both renders, <tile_cb> marching the tiles
+static void render_frame(const cloud_raymarch_params_t& params, const cloud_raymarch_volumes_t& volumes, const cloud_occupancy_t* occupancy, job_item_cb tile_cb, unsigned int width, unsigned int height,
+    cloud_image_t* out_image, unsigned int max_workers, cloud_raymarch_stats_t* out_stats)
+{
+    double start = get_current_time_seconds();
+
+    out_image->width = width;
+    out_image->height = height;
+    out_image->pixels.resize((size_t)width * height * 4);
+
+    render_pass_t pass;
+    pass.params         = &params;
+    pass.volumes        = &volumes;
+    pass.occupancy      = occupancy;
+    pass.image          = out_image;
+    pass.num_tiles_x    = (width + CLOUD_RAYMARCH_TILE_SIZE - 1) / CLOUD_RAYMARCH_TILE_SIZE;
+    pass.num_tiles      = pass.num_tiles_x * ((height + CLOUD_RAYMARCH_TILE_SIZE - 1) / CLOUD_RAYMARCH_TILE_SIZE);
+
+    march_counters_t zero_counters;
+    memset(&zero_counters, 0, sizeof(zero_counters));
+    pass.tile_counters.assign(pass.num_tiles, zero_counters);
+
+    unsigned int num_workers = job_parallel_for(pass.num_tiles, tile_cb, &pass, max_workers);
+
+    if(nullptr != out_stats){
+        memset(out_stats, 0, sizeof(*out_stats));
+        out_stats->seconds      = get_current_time_seconds() - start;
+        out_stats->num_tiles    = pass.num_tiles;
+        out_stats->num_workers  = num_workers;
+        out_stats->num_pixels   = (uint64_t)width * height;
+        for(const march_counters_t& counters : pass.tile_counters){
+            out_stats->num_rays             += counters.num_rays;
+            out_stats->num_steps            += counters.num_steps;
+            out_stats->num_density_samples  += counters.num_density_samples;
+            out_stats->num_skipped_steps    += counters.num_skipped_steps;
+            out_stats->num_light_lookups    += counters.num_light_lookups;
+        }
+    }
+}
+
+//-----------------------------------------------------
+// Public API
+
+void cloud_raymarch_set_defaults(cloud_raymarch_params_t* params)
+{
+    *params = cloud_raymarch_params_t();
+    params->cloud.sun_position = Vector3(10000000.0f, 1000000.0f, 10000000.0f);
+    cloud_raymarch_set_camera(params, Vector3(0.0f, 100.0f, 0.0f), 0.0f, -20.0f, 60.0f);
+
+    params->knobs[0]    = 0.025f;   // base noise scale
+    params->knobs[1]    = 0.0f;     // march mip
+    params->knobs[2]    = 0.05f;    // detail noise scale
+    params->knobs[5]    = 0.0f;     // coverage animation
+    params->knobs[6]    = 0.0f;     // wind speed
+    params->knobs[7]    = 0.1f;     // light cone mip
+    params->knobs[8]    = 0.2f;     // light cone step
+
+    params->sliders[0]  = 0.5f;     // scattering rgb
+    params->sliders[1]  = 0.5f;
+    params->sliders[2]  = 0.5f;
+    params->sliders[4]  = 0.02f;    // absorption
+    params->sliders[5]  = 0.5f;     // march steps / 128
+    params->sliders[6]  = 0.2f;     // eccentricity
+    params->sliders[7]  = 0.5f;     // silver lining intensity
+    params->sliders[8]  = 0.1f;     // silver lining spread
+}
+
+void cloud_raymarch_load_from_config(cloud_raymarch_params_t* params)
+{
+    char name[32];
+    for(unsigned int i = 0; i < CLOUD_MIDI_NUM_CONTROLS; ++i){
+        sprintf_s(name, "cloud_midi_knob_%u", i);
+        ConfigGetFloat(&params->knobs[i], name);
+
+        sprintf_s(name, "cloud_midi_slider_%u", i);
+        ConfigGetFloat(&params->sliders[i], name);
+    }
+    ConfigGetFloat(&params->game_time, "cloud_game_time");
+    ConfigGetBool(&params->adaptive_steps, "cloud_adaptive_steps");
+}
+
+void cloud_raymarch_set_camera(cloud_raymarch_params_t* params, const Vector3& position, float yaw_degrees, float pitch_degrees, float fov_degrees)
+{
+    Matrix4 rotation = Matrix4::make_rotation_x_degrees(pitch_degrees) * Matrix4::make_rotation_y_degrees(yaw_degrees);
+    params->cloud.transform = rotation * Matrix4::make_translation(position);
+    params->cloud.focal_length = 1.0f / TanDegrees(fov_degrees / 2.0f);
+}
+
+Vector3 cloud_raymarch_get_sun_position(float sun_pos)
+{
+    float rot_degs = MapFloatToRange(sun_pos, 0.0f, 1.0f, 0.0f, -180.0f);
+    Vector4 sun_dir = Vector4(0.0f, 0.0f, 1.0f, 0.0f) * Matrix4::make_rotation_x_degrees(rot_degs);
+    return (sun_dir * 1000000.0f).GetXYZ();
+}
+
+void cloud_raymarch_get_ray(const cloud_raymarch_params_t& params, float u, float v, Vector3* out_origin, Vector3* out_dir)
+{
+    const cloud_parameters_data_t& cloud = params.cloud;
+
+    // get_ndc, aspect fixed at 16:9 like the shader
+    float ndc_x = ((u * 2.0f) - 1.0f) * (16.0f / 9.0f);
+    float ndc_y = ((1.0f - v) * 2.0f) - 1.0f;
+
+    // transform._11_12_13 etc. are the bases as the constant buffer lays them out
+    Vector3 right = cloud.transform.get_i_basis().GetXYZ();
+    Vector3 up = cloud.transform.get_j_basis().GetXYZ();
+    Vector3 forward = cloud.transform.get_k_basis().GetXYZ();
+
+    *out_dir = ((forward * cloud.focal_length) + (right * ndc_x) + (up * ndc_y)).Normalized();
+    *out_origin = cloud.transform.get_translation().GetXYZ();
+}
+
+bool cloud_raymarch_get_cloud_layer(const Vector3& eye_pos, const Vector3& ray_dir, Vector3* out_start, Vector3* out_end)
+{
+    Vector3 planet_center = get_planet_center();
+    float eye_to_world_center_distance = CalcDistance(eye_pos, planet_center);
+
+    float inner_t[2];
+    unsigned int inner_num_intersections = ray_sphere_intersect(eye_pos, ray_dir, planet_center, INNER_LAYER_RADIUS, inner_t);
+
+    float outer_t[2];
+    unsigned int outer_num_intersections = ray_sphere_intersect(eye_pos, ray_dir, planet_center, OUTER_LAYER_RADIUS, outer_t);
+
+    Vector3 inner_cloud_hit = eye_pos + (ray_dir * inner_t[0]);
+    Vector3 outer_cloud_hit = eye_pos + (ray_dir * outer_t[0]);
+
+    // under the clouds
+    if(eye_to_world_center_distance < INNER_LAYER_RADIUS){
+        // below horizon
+        if(inner_cloud_hit.y < 0.0f){
+            return false;
+        }
+
+        *out_start = inner_cloud_hit;
+        *out_end = outer_cloud_hit;
+        return true;
+    }
+
+    // over the clouds, the shader leaves its below horizon test commented out here
+    if(eye_to_world_center_distance > OUTER_LAYER_RADIUS){
+        if((outer_num_intersections == 0) || (inner_num_intersections == 0)){
+            return false;
+        }
+
+        *out_start = outer_cloud_hit;
+        *out_end = inner_cloud_hit;
+        return true;
+    }
+
+    // in between
+    *out_start = eye_pos;
+    *out_end = (inner_num_intersections > 0) ? inner_cloud_hit : outer_cloud_hit;
+    return true;
+}
+
+float cloud_raymarch_get_coverage(const cloud_raymarch_params_t& params, float x, float z)
+{
+    // The shader passes octave_scale (1.5) where persistence goes and
+    // persistence (0.5) where octave scale goes, kept so the frames match
+    float coverage = Compute3dPerlinNoiseZeroToOne(x, z, params.game_time * 1000.0f * params.knobs[5], COVERAGE_SCALE, COVERAGE_NUM_OCTAVES, COVERAGE_PERSISTENCE, COVERAGE_OCTAVE_SCALE, true, 0);
+    return cloud_saturate(coverage);
+}
+
+void cloud_raymarch_get_coverage_row(const cloud_raymarch_params_t& params, float x0, float spacing, float z, unsigned int count, float* out_coverage)
+{
+    std::vector<float> xs(count);
+    std::vector<float> zs(count, z);
+    for(unsigned int i = 0; i < count; ++i){
+        xs[i] = x0 + ((float)i * spacing);
+    }
+
+    cloud_raymarch_get_coverage_batch(params, xs.data(), zs.data(), count, out_coverage);
+}
+
+void cloud_raymarch_get_coverage_batch(const cloud_raymarch_params_t& params, const float* xs, const float* zs, unsigned int count, float* out_coverage)
+{
+    std::vector<float> times(count, params.game_time * 1000.0f * params.knobs[5]);
+    Compute3dPerlinNoiseZeroToOneBatch(xs, zs, times.data(), out_coverage, count, COVERAGE_SCALE, COVERAGE_NUM_OCTAVES, COVERAGE_PERSISTENCE, COVERAGE_OCTAVE_SCALE, true, 0);
+    for(unsigned int i = 0; i < count; ++i){
+        out_coverage[i] = cloud_saturate(out_coverage[i]);
+    }
+}
+
+float cloud_raymarch_get_coverage_max_slope()
+{
+    // One octave of Compute3dPerlinNoise is 1.6667 times a trilinear blend of
+    // gradient dots, gradients having +-1/sqrt(3) components and weights
+    // 3t^2 - 2t^3. Along x the blend changes by the weighted gradient x, at
+    // most 1/sqrt(3), plus the weight's slope, at most 1.5, times the blended
+    // east minus west dots. Those are at most (1 + 2|dy| + 2|dz|) / sqrt(3)
+    // apart and the smoothstep blend keeps each of |dy|, |dz| to 0.5 on
+    // average, so sqrt(3). Same along y.
+    const float sqrt_3 = sqrtf(3.0f);
+    float octave_slope = 1.66666666f * ((1.0f / sqrt_3) + (1.5f * sqrt_3));
+
+    // Octaves are averaged by amplitude at their own frequency
+    float amplitude = 1.0f;
+    float frequency = 1.0f;
+    float total_amplitude = 0.0f;
+    float total_slope = 0.0f;
+    for(unsigned int octave = 0; octave < COVERAGE_NUM_OCTAVES; ++octave){
+        total_slope += amplitude * frequency * octave_slope;
+        total_amplitude += amplitude;
+        amplitude *= COVERAGE_PERSISTENCE;
+        frequency *= COVERAGE_OCTAVE_SCALE;
+    }
+
+    // Renormalizing runs the [0, 1] mapped sum through 3t^2 - 2t^3 (slope 1.5)
+    // and back, zero to one halves it, saturate only flattens
+    return 0.5f * 1.5f * (total_slope / total_amplitude) / COVERAGE_SCALE;
+}
+
+float cloud_raymarch_get_height_fraction(const Vector3& world_pos)
+{
+    float to_planet_center_dist = CalcDistance(world_pos, get_planet_center());
+    return cloud_saturate(cloud_range_map(to_planet_center_dist, INNER_LAYER_RADIUS, OUTER_LAYER_RADIUS, 0.0f, 1.0f));
+}
+
+// The shader works out cumulus too but returns stratus
+float cloud_raymarch_get_density_height_gradient(float height_fraction)
+{
+    return cloud_saturate(cloud_range_map(height_fraction, 0.05f, 0.15f, 0.0f, 1.0f)) * cloud_saturate(cloud_range_map(height_fraction, 0.4f, 0.85f, 1.0f, 0.0f));
+}
+
+float cloud_raymarch_sample_density(const cloud_raymarch_params_t& params, const cloud_raymarch_volumes_t& volumes, const Vector3& world_pos, float mip_level, bool do_cheap)
+{
+    march_counters_t counters;
+    memset(&counters, 0, sizeof(counters));
+
+    march_context_t context;
+    context.params      = &params;
+    context.volumes     = &volumes;
+    context.occupancy   = nullptr;
+    context.counters    = &counters;
+    return sample_density(context, world_pos, mip_level, do_cheap);
+}
+
+float cloud_raymarch_get_light_transmittance(const cloud_raymarch_params_t& params, const cloud_raymarch_volumes_t& volumes, const Vector3& world_pos)
+{
+    march_counters_t counters;
+    memset(&counters, 0, sizeof(counters));
+
+    march_context_t context;
+    context.params      = &params;
+    context.volumes     = &volumes;
+    context.occupancy   = nullptr;
+    context.counters    = &counters;
+    return march_light_cone(context, world_pos, params.cloud.sun_position);
+}
+
+void cloud_raymarch_pixel(const cloud_raymarch_params_t& params, const cloud_raymarch_volumes_t& volumes, float u, float v, float* out_rgba)
+{
+    march_counters_t counters;
+    memset(&counters, 0, sizeof(counters));
+
+    march_context_t context;
+    context.params      = &params;
+    context.volumes     = &volumes;
+    context.occupancy   = nullptr;
+    context.counters    = &counters;
+    march_pixel(context, u, v, out_rgba);
+}
+
+void cloud_raymarch_render(const cloud_raymarch_params_t& params, const cloud_raymarch_volumes_t& volumes, unsigned int width, unsigned int height, cloud_image_t* out_image, unsigned int max_workers, cloud_raymarch_stats_t* out_stats, const cloud_occupancy_t* occupancy)
+{
+    render_frame(params, volumes, occupancy, render_tile, width, height, out_image, max_workers, out_stats);
+}
+
+void cloud_raymarch_render_packets(const cloud_raymarch_params_t& params, const cloud_raymarch_volumes_t& volumes, unsigned int width, unsigned int height, cloud_image_t* out_image, unsigned int max_workers, cloud_raymarch_stats_t* out_stats)
+{
+    job_item_cb tile_cb;
+    switch(cpu_get_simd_level()){
+        case SIMD_LEVEL_AVX2:
+            tile_cb = cloud_raymarch_render_tile_avx2;
+            break;
+        case SIMD_LEVEL_SSE41:
+            tile_cb = render_tile_packets<simd4_t>;
+            break;
+        default:
+            tile_cb = render_tile;
+            break;
+    }
+    render_frame(params, volumes, nullptr, tile_cb, width, height, out_image, max_workers, out_stats);
+}
+
+bool cloud_image_save_png(const cloud_image_t& image, const char* filename)
+{
+    std::vector<unsigned char> rgba(image.pixels.size());
+    for(size_t i = 0; i < image.pixels.size(); ++i){
+        rgba[i] = (unsigned char)((cloud_saturate(image.pixels[i]) * 255.0f) + 0.5f);
+    }
+    return stbi_write_png(filename, (int)image.width, (int)image.height, 4, rgba.data(), (int)image.width * 4) != 0;
+}
@@ -0,0 +1,147 @@
+#pragma once
+
+#include "Game/cloud_parameters.h"
+#include "Engine/Volume/volume_sampler.h"
+
+#include <stdint.h>
+#include <vector>
+
+//-----------------------------------------------------
+// Cloud raymarch
+//
+// CPU reference for hzd_clouds_new.frag. The layer intersection, density,
+// light cone and march follow the shader line for line, quirks included, so
+// a frame rendered here is what the GPU draws give or take float ordering.
+// Useful for checking shader changes and for profiling the march without a
+// device.
+//
+// The image is cut into CLOUD_RAYMARCH_TILE_SIZE tiles that GENERIC jobs and
+// the calling thread pull off a shared counter. cloud_raymarch_render_packets
+// marches each tile row a SIMD register of rays at a time instead of one.
+
+#define CLOUD_MIDI_NUM_CONTROLS     9
+#define CLOUD_RAYMARCH_TILE_SIZE    32
+
+// The shell the clouds live in and the lean of their tops, as in the shader
+#define CLOUD_PLANET_RADIUS         1000000.0f
+#define CLOUD_LAYER_INNER_HEIGHT    1500.0f     // above the ground
+#define CLOUD_LAYER_OUTER_HEIGHT    4000.0f
+#define CLOUD_WIND_TOP_OFFSET       500.0f
+
+struct cloud_light_volume_t;
+struct cloud_occupancy_t;
+struct cloud_weather_map_t;
+
+struct cloud_raymarch_params_t
+{
+    cloud_parameters_data_t     cloud;                              // only transform, focal_length and sun_position are read
+    float                       knobs[CLOUD_MIDI_NUM_CONTROLS];     // MIDI.KNOB_n in the shader
+    float                       sliders[CLOUD_MIDI_NUM_CONTROLS];   // MIDI.SLIDER_n
+    float                       game_time;
+    bool                        adaptive_steps;                     // 64 to 128 steps by horizontalness, the shader's commented out alternative to SLIDER_5
+};
+
+// Base and detail noise, both RGBA8 with their mips. With a <weather> map
+// coverage is read from it instead of evaluated per sample. With a built
+// <light> volume the sun's transmittance is read from it instead of marching
+// the light cone, wherever it covers.
+struct cloud_raymarch_volumes_t
+{
+    volume_sampler_t                base;
+    volume_sampler_t                detail;
+    const cloud_weather_map_t*      weather;
+    const cloud_light_volume_t*     light;
+
+    cloud_raymarch_volumes_t()
+        :weather(nullptr)
+        ,light(nullptr)
+    {}
+};
+
+// What the fragment shader writes: premultiplied RGBA float, rows top to bottom
+struct cloud_image_t
+{
+    unsigned int        width;
+    unsigned int        height;
+    std::vector<float>  pixels;
+
+    cloud_image_t()
+        :width(0)
+        ,height(0)
+    {}
+
+    float*          get_pixel(unsigned int x, unsigned int y)           { return pixels.data() + (((size_t)y * width) + x) * 4; }
+    const float*    get_pixel(unsigned int x, unsigned int y) const     { return pixels.data() + (((size_t)y * width) + x) * 4; }
+};
+
+struct cloud_raymarch_stats_t
+{
+    double          seconds;
+    unsigned int    num_tiles;
+    unsigned int    num_workers;
+    uint64_t        num_pixels;
+    uint64_t        num_rays;               // pixels whose ray hit the cloud layer
+    uint64_t        num_steps;              // primary march steps
+    uint64_t        num_skipped_steps;      // of those, steps in empty occupancy cells that weren't sampled
+    uint64_t        num_density_samples;    // sample_density calls, light cone included
+    uint64_t        num_light_lookups;      // light cones read off the light volume instead
+
+    double steps_per_pixel() const          { return (num_pixels > 0) ? (double)num_steps / (double)num_pixels : 0.0; }
+    double samples_per_second() const       { return (seconds > 0.0) ? (double)num_density_samples / seconds : 0.0; }
+};
+
+inline float cloud_saturate(float value)
+{
+    return (value < 0.0f) ? 0.0f : ((value > 1.0f) ? 1.0f : value);
+}
+
+// Unclamped, like the shader's
+inline float cloud_range_map(float value, float in_min, float in_max, float out_min, float out_max)
+{
+    return out_min + (((value - in_min) / (in_max - in_min)) * (out_max - out_min));
+}
+
+// Board settings that give a readable frame, the real board starts at all zeroes
+void    cloud_raymarch_set_defaults(cloud_raymarch_params_t* params);
+
+// cloud_midi_knob_N / cloud_midi_slider_N and cloud_game_time override the defaults
+void    cloud_raymarch_load_from_config(cloud_raymarch_params_t* params);
+
+// Fills transform and focal_length the way Camera3d and App do
+void    cloud_raymarch_set_camera(cloud_raymarch_params_t* params, const Vector3& position, float yaw_degrees, float pitch_degrees, float fov_degrees);
+
+// Where App puts the sun for its 0..1 sun slider, a half turn about x from
+// the +z horizon at 0 to the -z one at 1
+Vector3 cloud_raymarch_get_sun_position(float sun_pos);
+
+// The shader's building blocks, for the acceleration structures that have to agree with it
+void    cloud_raymarch_get_ray(const cloud_raymarch_params_t& params, float u, float v, Vector3* out_origin, Vector3* out_dir);
+bool    cloud_raymarch_get_cloud_layer(const Vector3& eye_pos, const Vector3& ray_dir, Vector3* out_start, Vector3* out_end);
+float   cloud_raymarch_get_coverage(const cloud_raymarch_params_t& params, float x, float z);
+float   cloud_raymarch_get_coverage_max_slope();   // most coverage can change per meter along x or along z
+// <count> coverage values <spacing> apart along x from <x0, z>, batched, so within NOISE_BATCH_TOLERANCE of the above
+void    cloud_raymarch_get_coverage_row(const cloud_raymarch_params_t& params, float x0, float spacing, float z, unsigned int count, float* out_coverage);
+void    cloud_raymarch_get_coverage_batch(const cloud_raymarch_params_t& params, const float* xs, const float* zs, unsigned int count, float* out_coverage);
+float   cloud_raymarch_get_height_fraction(const Vector3& world_pos);
+float   cloud_raymarch_get_density_height_gradient(float height_fraction);
+float   cloud_raymarch_sample_density(const cloud_raymarch_params_t& params, const cloud_raymarch_volumes_t& volumes, const Vector3& world_pos, float mip_level, bool do_cheap);
+// The light cone's transmittance toward the sun from <world_pos>, always marched
+float   cloud_raymarch_get_light_transmittance(const cloud_raymarch_params_t& params, const cloud_raymarch_volumes_t& volumes, const Vector3& world_pos);
+
+// One fragment, <u, v> being the full screen quad's uv
+void    cloud_raymarch_pixel(const cloud_raymarch_params_t& params, const cloud_raymarch_volumes_t& volumes, float u, float v, float* out_rgba);
+
+// Renders a <width> x <height> frame. Needs job_system_init, <max_workers> 0 uses every core.
+// A built <occupancy> skips the density samples of steps in empty cells, the
+// frame comes out the same to the bit.
+void    cloud_raymarch_render(const cloud_raymarch_params_t& params, const cloud_raymarch_volumes_t& volumes, unsigned int width, unsigned int height, cloud_image_t* out_image, unsigned int max_workers = 0, cloud_raymarch_stats_t* out_stats = nullptr, const cloud_occupancy_t* occupancy = nullptr);
+
+// cloud_raymarch_render with rays marched in packets along each tile row, 8
+// wide at AVX2 and 4 at SSE4.1 by cpu_get_simd_level(), one at a time below
+// that. Lanes follow the scalar march's float order, so the frames only part
+// by what the batched coverage noise does, NOISE_BATCH_TOLERANCE before the
+// march. There's no occupancy skipping.
+void    cloud_raymarch_render_packets(const cloud_raymarch_params_t& params, const cloud_raymarch_volumes_t& volumes, unsigned int width, unsigned int height, cloud_image_t* out_image, unsigned int max_workers = 0, cloud_raymarch_stats_t* out_stats = nullptr);
+
+// Clamped to 8 bit, straight from the premultiplied values
+bool    cloud_image_save_png(const cloud_image_t& image, const char* filename);
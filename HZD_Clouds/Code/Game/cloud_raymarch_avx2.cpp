@@ -0,0 +1,9 @@
+#include "Game/cloud_raymarch_lanes.h"
+
+//-----------------------------------------------------
+// Public API
+
+void cloud_raymarch_render_tile_avx2(unsigned int tile, void* user_data)
+{
+    render_tile_packets<simd8_t>(tile, user_data);
+}
@@ -0,0 +1,623 @@
+#pragma once
+
+#include "Game/cloud_raymarch.h"
+#include "Game/cloud_light.h"
+#include "Game/cloud_occupancy.h"
+#include "Game/cloud_weather.h"
+
+#include "Engine/Math/MathUtils.hpp"
+#include "Engine/Math/Noise.hpp"
+#include "Engine/Math/simd.h"
+
+#include <math.h>
+
+//-----------------------------------------------------
+// Cloud Raymarch Lanes
+//
+// What the scalar march and the packet march share, and the packet march
+// itself. cloud_raymarch.cpp builds the scalar and simd4_t renders,
+// cloud_raymarch_avx2.cpp the simd8_t one and is the only file built for
+// AVX2. The functions are static so each file compiles its own copy.
+
+static const float M_PI_F                   = 3.1415926535897932384626433832795f;
+static const float INNER_LAYER_RADIUS       = CLOUD_PLANET_RADIUS + CLOUD_LAYER_INNER_HEIGHT;
+static const float OUTER_LAYER_RADIUS       = CLOUD_PLANET_RADIUS + CLOUD_LAYER_OUTER_HEIGHT;
+static const unsigned int NUM_LIGHT_STEPS   = 6;
+
+// The coverage noise's parameters, see cloud_raymarch_get_coverage
+static const float COVERAGE_SCALE               = 1000.0f;
+static const unsigned int COVERAGE_NUM_OCTAVES  = 3;
+static const float COVERAGE_PERSISTENCE         = 1.5f;
+static const float COVERAGE_OCTAVE_SCALE        = 0.5f;
+
+// random vectors on the unit sphere, same as the shader. Defined in
+// cloud_raymarch.cpp so their constructors don't run as AVX2 code at startup.
+extern const Vector3 RANDOM_VECTORS[NUM_LIGHT_STEPS];
+
+// Per thread tallies, summed into the stats once the frame is done
+struct march_counters_t
+{
+    uint64_t    num_rays;
+    uint64_t    num_steps;
+    uint64_t    num_density_samples;
+    uint64_t    num_skipped_steps;
+    uint64_t    num_light_lookups;
+};
+
+struct march_context_t
+{
+    const cloud_raymarch_params_t*  params;
+    const cloud_raymarch_volumes_t* volumes;
+    const cloud_occupancy_t*        occupancy;
+    march_counters_t*               counters;
+};
+
+struct render_pass_t
+{
+    const cloud_raymarch_params_t*  params;
+    const cloud_raymarch_volumes_t* volumes;
+    const cloud_occupancy_t*        occupancy;
+    cloud_image_t*                  image;
+    unsigned int                    num_tiles_x;
+    unsigned int                    num_tiles;
+    std::vector<march_counters_t>   tile_counters;
+};
+
+static inline Vector3 get_planet_center()
+{
+    return Vector3(0.0f, -CLOUD_PLANET_RADIUS, 0.0f);
+}
+
+// Keeps the shader's "/ 4.0 * M_PI", which multiplies by pi instead of dividing by 4 pi
+static float henyey_greenstein(float cos_angle, float eccentricity)
+{
+    float e2 = eccentricity * eccentricity;
+    return ((1.0f - e2) / powf(fabsf(1.0f + e2 - (2.0f * eccentricity * cos_angle)), 1.5f)) / 4.0f * M_PI_F;
+}
+
+// SLIDER_5's override, or with adaptive_steps the lerp(64, 128, horizontalness) the shader has commented out
+static unsigned int get_num_steps(const cloud_raymarch_params_t& params, const Vector3& ray_dir)
+{
+    if(params.adaptive_steps){
+        float horizontalness = 1.0f - fabsf(DotProduct(ray_dir, Vector3(0.0f, 1.0f, 0.0f)));
+        return (unsigned int)(64.0f + (horizontalness * (128.0f - 64.0f)));
+    }
+    return (unsigned int)(params.sliders[5] * 128.0f);
+}
+
+// Forward scattering or the silver lining, whichever is brighter
+static float get_phase(const cloud_raymarch_params_t& params, float cos_angle)
+{
+    float eccentricity = params.sliders[6];
+    float silver_intensity = params.sliders[7] * 2.0f;
+    float silver_spread = params.sliders[8];
+    float phase_forward = henyey_greenstein(cos_angle, eccentricity);
+    float phase_silver = silver_intensity * henyey_greenstein(cos_angle, 0.99f - silver_spread);
+    return (phase_forward > phase_silver) ? phase_forward : phase_silver;
+}
+
+//-----------------------------------------------------
+// Packets
+//
+// The march in cloud_raymarch.cpp, a SIMD register of rays at a time, side by side along a
+// tile row. The rays share an eye, so the layer intersection works out the
+// eye's terms once for the packet. Every lane keeps its own step count, step
+// length and phase. A lane whose ray is out of steps or past the
+// transmittance cutoff is masked off while the rest carry on, and the packet
+// stops when none are left. Lane ops keep the scalar float order.
+
+template<typename SIMD>
+struct packet_vector3_t
+{
+    typename SIMD::vfloat   x;
+    typename SIMD::vfloat   y;
+    typename SIMD::vfloat   z;
+};
+
+static __forceinline void sample_volume_lanes(const volume_sampler_t& sampler, __m128 u, __m128 v, __m128 w, float mip, __m128* out_rgba)
+{
+    volume_sample_trilinear_x4(sampler, u, v, w, mip, out_rgba);
+}
+
+static __forceinline void sample_volume_lanes(const volume_sampler_t& sampler, __m256 u, __m256 v, __m256 w, float mip, __m256* out_rgba)
+{
+    volume_sample_trilinear_x8(sampler, u, v, w, mip, out_rgba);
+}
+
+static inline unsigned int count_lanes(int mask)
+{
+    unsigned int count = 0;
+    for(; mask != 0; mask &= mask - 1){
+        ++count;
+    }
+    return count;
+}
+
+template<typename SIMD>
+static __forceinline typename SIMD::vfloat get_lane_mask(int mask)
+{
+    alignas(SIMD_ALIGN_BYTES) int lanes[SIMD::WIDTH];
+    for(unsigned int lane = 0; lane < SIMD::WIDTH; ++lane){
+        lanes[lane] = ((mask >> lane) & 1) ? -1 : 0;
+    }
+    return SIMD::as_float(SIMD::load_int(lanes));
+}
+
+template<typename SIMD>
+static __forceinline typename SIMD::vfloat negate_lanes(typename SIMD::vfloat value)
+{
+    return SIMD::bit_xor(value, SIMD::set1(-0.0f));
+}
+
+// Same as cloud_saturate, NaN included
+template<typename SIMD>
+static __forceinline typename SIMD::vfloat saturate_lanes(typename SIMD::vfloat value)
+{
+    typename SIMD::vfloat zero = SIMD::zero();
+    typename SIMD::vfloat one = SIMD::set1(1.0f);
+    return SIMD::select(SIMD::cmp_lt(value, zero), zero, SIMD::select(SIMD::cmp_gt(value, one), one, value));
+}
+
+template<typename SIMD>
+static __forceinline typename SIMD::vfloat range_map_lanes(typename SIMD::vfloat value, typename SIMD::vfloat in_min, typename SIMD::vfloat in_max, typename SIMD::vfloat out_min, typename SIMD::vfloat out_max)
+{
+    return SIMD::add(out_min, SIMD::mul(SIMD::div(SIMD::sub(value, in_min), SIMD::sub(in_max, in_min)), SIMD::sub(out_max, out_min)));
+}
+
+// expf a lane at a time, a step only needs two
+template<typename SIMD>
+static __forceinline typename SIMD::vfloat exp_lanes(typename SIMD::vfloat value)
+{
+    alignas(SIMD_ALIGN_BYTES) float values[SIMD::WIDTH];
+    SIMD::store(values, value);
+    for(unsigned int lane = 0; lane < SIMD::WIDTH; ++lane){
+        values[lane] = expf(values[lane]);
+    }
+    return SIMD::load(values);
+}
+
+template<typename SIMD>
+static __forceinline packet_vector3_t<SIMD> select_lanes(typename SIMD::vfloat mask, const packet_vector3_t<SIMD>& a, const packet_vector3_t<SIMD>& b)
+{
+    packet_vector3_t<SIMD> result;
+    result.x = SIMD::select(mask, a.x, b.x);
+    result.y = SIMD::select(mask, a.y, b.y);
+    result.z = SIMD::select(mask, a.z, b.z);
+    return result;
+}
+
+// <origin> + <dir> * <t>
+template<typename SIMD>
+static __forceinline packet_vector3_t<SIMD> get_ray_point_lanes(const Vector3& origin, const packet_vector3_t<SIMD>& dir, typename SIMD::vfloat t)
+{
+    packet_vector3_t<SIMD> result;
+    result.x = SIMD::add(SIMD::set1(origin.x), SIMD::mul(dir.x, t));
+    result.y = SIMD::add(SIMD::set1(origin.y), SIMD::mul(dir.y, t));
+    result.z = SIMD::add(SIMD::set1(origin.z), SIMD::mul(dir.z, t));
+    return result;
+}
+
+// ray_sphere_intersect for rays out of one <ray_origin>, returning the lanes
+// with any hit. Only the nearer distance comes back, it's all the layer needs.
+template<typename SIMD>
+static typename SIMD::vfloat ray_sphere_intersect_lanes(const Vector3& ray_origin, packet_vector3_t<SIMD> ray_dir, const Vector3& sphere_origin, float sphere_radius, typename SIMD::vfloat* out_t)
+{
+    typedef typename SIMD::vfloat vfloat;
+
+    vfloat length = SIMD::sqrt(SIMD::add(SIMD::add(SIMD::mul(ray_dir.x, ray_dir.x), SIMD::mul(ray_dir.y, ray_dir.y)), SIMD::mul(ray_dir.z, ray_dir.z)));
+    vfloat inverse_length = SIMD::div(SIMD::set1(1.0f), length);
+    vfloat has_length = SIMD::cmp_gt(length, SIMD::zero());
+    ray_dir.x = SIMD::select(has_length, SIMD::mul(ray_dir.x, inverse_length), ray_dir.x);
+    ray_dir.y = SIMD::select(has_length, SIMD::mul(ray_dir.y, inverse_length), ray_dir.y);
+    ray_dir.z = SIMD::select(has_length, SIMD::mul(ray_dir.z, inverse_length), ray_dir.z);
+
+    // The origin's terms, the same for every lane
+    Vector3 l = ray_origin - sphere_origin;
+    float a = 1.0f;
+    float c = DotProduct(l, l) - (sphere_radius * sphere_radius);
+    float four_a_c = 4.0f * a * c;
+
+    vfloat dot = SIMD::add(SIMD::add(SIMD::mul(ray_dir.x, SIMD::set1(l.x)), SIMD::mul(ray_dir.y, SIMD::set1(l.y))), SIMD::mul(ray_dir.z, SIMD::set1(l.z)));
+    vfloat b = SIMD::mul(SIMD::set1(2.0f), dot);
+    vfloat discr = SIMD::sub(SIMD::mul(b, b), SIMD::set1(four_a_c));
+
+    vfloat all_lanes = SIMD::as_float(SIMD::set1_int(-1));
+    vfloat is_miss = SIMD::cmp_lt(discr, SIMD::zero());
+    vfloat abs_discr = SIMD::bit_and(discr, SIMD::as_float(SIMD::set1_int(0x7fffffff)));
+    vfloat is_tangent = SIMD::cmp_le(SIMD::sub(abs_discr, SIMD::set1(0.00005f)), SIMD::zero());
+    vfloat tangent_t = SIMD::div(SIMD::mul(SIMD::set1(-0.5f), b), SIMD::set1(a));
+
+    vfloat root = SIMD::sqrt(discr);
+    vfloat q = SIMD::select(SIMD::cmp_gt(b, SIMD::zero()), SIMD::mul(SIMD::set1(-0.5f), SIMD::add(b, root)), SIMD::mul(SIMD::set1(-0.5f), SIMD::sub(b, root)));
+    vfloat h1 = SIMD::div(q, SIMD::set1(a));
+    vfloat h2 = SIMD::div(SIMD::set1(c), q);
+    vfloat is_h1_nearer = SIMD::cmp_lt(h1, h2);
+    vfloat t0 = SIMD::select(is_h1_nearer, h1, h2);
+    vfloat t1 = SIMD::select(is_h1_nearer, h2, h1);
+    t0 = SIMD::select(SIMD::cmp_lt(t0, SIMD::zero()), t1, t0);
+    vfloat is_ahead = SIMD::bit_xor(SIMD::cmp_lt(t0, SIMD::zero()), all_lanes);
+
+    *out_t = SIMD::select(is_miss, SIMD::zero(), SIMD::select(is_tangent, tangent_t, t0));
+    return SIMD::bit_and(SIMD::bit_xor(is_miss, all_lanes), SIMD::bit_or(is_tangent, is_ahead));
+}
+
+// cloud_raymarch_get_cloud_layer for rays out of <eye_pos>, returning the lanes that reach the layer
+template<typename SIMD>
+static int get_cloud_layer_lanes(const Vector3& eye_pos, const packet_vector3_t<SIMD>& ray_dir, packet_vector3_t<SIMD>* out_start, packet_vector3_t<SIMD>* out_end)
+{
+    typedef typename SIMD::vfloat vfloat;
+
+    Vector3 planet_center = get_planet_center();
+    float eye_to_world_center_distance = CalcDistance(eye_pos, planet_center);
+
+    vfloat inner_t, outer_t;
+    vfloat inner_hits = ray_sphere_intersect_lanes<SIMD>(eye_pos, ray_dir, planet_center, INNER_LAYER_RADIUS, &inner_t);
+    vfloat outer_hits = ray_sphere_intersect_lanes<SIMD>(eye_pos, ray_dir, planet_center, OUTER_LAYER_RADIUS, &outer_t);
+
+    packet_vector3_t<SIMD> inner_cloud_hit = get_ray_point_lanes<SIMD>(eye_pos, ray_dir, inner_t);
+    packet_vector3_t<SIMD> outer_cloud_hit = get_ray_point_lanes<SIMD>(eye_pos, ray_dir, outer_t);
+
+    // under the clouds, below horizon rays miss
+    if(eye_to_world_center_distance < INNER_LAYER_RADIUS){
+        *out_start = inner_cloud_hit;
+        *out_end = outer_cloud_hit;
+        return SIMD::move_mask(SIMD::bit_xor(SIMD::cmp_lt(inner_cloud_hit.y, SIMD::zero()), SIMD::as_float(SIMD::set1_int(-1))));
+    }
+
+    // over the clouds
+    if(eye_to_world_center_distance > OUTER_LAYER_RADIUS){
+        *out_start = outer_cloud_hit;
+        *out_end = inner_cloud_hit;
+        return SIMD::move_mask(SIMD::bit_and(inner_hits, outer_hits));
+    }
+
+    // in between
+    out_start->x = SIMD::set1(eye_pos.x);
+    out_start->y = SIMD::set1(eye_pos.y);
+    out_start->z = SIMD::set1(eye_pos.z);
+    *out_end = select_lanes<SIMD>(inner_hits, inner_cloud_hit, outer_cloud_hit);
+    return (1 << SIMD::WIDTH) - 1;
+}
+
+// sample_density for every lane, the caller counts the samples
+template<typename SIMD>
+static typename SIMD::vfloat sample_density_lanes(const march_context_t& context, packet_vector3_t<SIMD> world_pos, float mip_level, bool do_cheap)
+{
+    typedef typename SIMD::vfloat vfloat;
+    const cloud_raymarch_params_t& params = *context.params;
+    vfloat zero = SIMD::zero();
+    vfloat one = SIMD::set1(1.0f);
+
+    // cloud_raymarch_get_height_fraction, the planet center's x and z are 0
+    vfloat dy = SIMD::sub(world_pos.y, SIMD::set1(-CLOUD_PLANET_RADIUS));
+    vfloat to_planet_center_dist = SIMD::sqrt(SIMD::add(SIMD::add(SIMD::mul(world_pos.x, world_pos.x), SIMD::mul(dy, dy)), SIMD::mul(world_pos.z, world_pos.z)));
+    vfloat height_fraction = saturate_lanes<SIMD>(range_map_lanes<SIMD>(to_planet_center_dist, SIMD::set1(INNER_LAYER_RADIUS), SIMD::set1(OUTER_LAYER_RADIUS), zero, one));
+
+    // wind, tops of the clouds pushed along with it
+    float cloud_speed = params.knobs[6] * 1000.0f;
+    float wind_distance = params.game_time * cloud_speed;
+    world_pos.x = SIMD::add(SIMD::add(world_pos.x, SIMD::mul(height_fraction, SIMD::set1(CLOUD_WIND_TOP_OFFSET))), SIMD::set1(wind_distance));
+    world_pos.y = SIMD::add(world_pos.y, SIMD::set1(0.1f * wind_distance));
+
+    // base shape, dilated by the low frequency fBm
+    vfloat scale = SIMD::set1(cloud_range_map(params.knobs[0], 0.0f, 1.0f, 0.0f, 0.001f));
+    vfloat low_freq_noises[4];
+    sample_volume_lanes(context.volumes->base, SIMD::mul(world_pos.x, scale), SIMD::mul(world_pos.y, scale), SIMD::mul(world_pos.z, scale), mip_level, low_freq_noises);
+
+    vfloat low_freq_fbm = SIMD::add(SIMD::add(SIMD::mul(low_freq_noises[1], SIMD::set1(0.625f)), SIMD::mul(low_freq_noises[2], SIMD::set1(0.25f))), SIMD::mul(low_freq_noises[3], SIMD::set1(0.125f)));
+    vfloat base_cloud = range_map_lanes<SIMD>(low_freq_noises[0], negate_lanes<SIMD>(SIMD::sub(one, low_freq_fbm)), one, zero, one);
+    vfloat gradient = SIMD::mul(saturate_lanes<SIMD>(range_map_lanes<SIMD>(height_fraction, SIMD::set1(0.05f), SIMD::set1(0.15f), zero, one)),
+        saturate_lanes<SIMD>(range_map_lanes<SIMD>(height_fraction, SIMD::set1(0.4f), SIMD::set1(0.85f), one, zero)));
+    base_cloud = SIMD::mul(base_cloud, gradient);
+
+    // coverage, smaller clouds come out lighter
+    alignas(SIMD_ALIGN_BYTES) float xs[SIMD::WIDTH];
+    alignas(SIMD_ALIGN_BYTES) float zs[SIMD::WIDTH];
+    alignas(SIMD_ALIGN_BYTES) float coverages[SIMD::WIDTH];
+    SIMD::store(xs, world_pos.x);
+    SIMD::store(zs, world_pos.z);
+    vfloat cloud_coverage;
+    if(nullptr != context.volumes->weather){
+        for(unsigned int lane = 0; lane < SIMD::WIDTH; ++lane){
+            coverages[lane] = cloud_weather_get_coverage(*context.volumes->weather, xs[lane], zs[lane]);
+        }
+        cloud_coverage = SIMD::load(coverages);
+    }else{
+        alignas(SIMD_ALIGN_BYTES) float times[SIMD::WIDTH];
+        SIMD::store(times, SIMD::set1(params.game_time * 1000.0f * params.knobs[5]));
+        Compute3dPerlinNoiseZeroToOneBatch(xs, zs, times, coverages, SIMD::WIDTH, COVERAGE_SCALE, COVERAGE_NUM_OCTAVES, COVERAGE_PERSISTENCE, COVERAGE_OCTAVE_SCALE, true, 0);
+        cloud_coverage = saturate_lanes<SIMD>(SIMD::load(coverages));
+    }
+    vfloat final_cloud = SIMD::mul(range_map_lanes<SIMD>(base_cloud, SIMD::sub(one, cloud_coverage), one, zero, one), cloud_coverage);
+
+    if(!do_cheap){
+        // erode with the detail noise, wispy at the bottom and billowy higher up
+        vfloat detail_scale = SIMD::set1(cloud_range_map(params.knobs[2], 0.0f, 1.0f, 0.0f, 0.001f));
+        vfloat high_frequency_noises[4];
+        sample_volume_lanes(context.volumes->detail, SIMD::mul(world_pos.x, detail_scale), SIMD::mul(world_pos.y, detail_scale), SIMD::mul(world_pos.z, detail_scale), 0.0f, high_frequency_noises);
+
+        vfloat high_freq_fbm = SIMD::add(SIMD::add(SIMD::mul(high_frequency_noises[1], SIMD::set1(0.625f)), SIMD::mul(high_frequency_noises[2], SIMD::set1(0.25f))), SIMD::mul(high_frequency_noises[3], SIMD::set1(0.125f)));
+        vfloat fraction = saturate_lanes<SIMD>(SIMD::mul(height_fraction, SIMD::set1(10.0f)));
+        vfloat high_freq_noise_modifier = SIMD::add(SIMD::mul(high_freq_fbm, SIMD::sub(one, fraction)), SIMD::mul(SIMD::sub(one, high_freq_fbm), fraction));
+
+        final_cloud = range_map_lanes<SIMD>(final_cloud, SIMD::mul(high_freq_noise_modifier, SIMD::set1(0.2f)), one, zero, one);
+    }
+
+    return final_cloud;
+}
+
+// march_light_cone for every lane
+template<typename SIMD>
+static typename SIMD::vfloat march_light_cone_lanes(const march_context_t& context, const packet_vector3_t<SIMD>& start_pos, const Vector3& light_pos)
+{
+    typedef typename SIMD::vfloat vfloat;
+    const cloud_raymarch_params_t& params = *context.params;
+    vfloat step_size = SIMD::set1(params.knobs[8] * 500.0f);
+    float mip_level = params.knobs[7] * 10.0f;
+
+    float cone_radius = 5.0f;
+    packet_vector3_t<SIMD> to_light;
+    to_light.x = SIMD::sub(SIMD::set1(light_pos.x), start_pos.x);
+    to_light.y = SIMD::sub(SIMD::set1(light_pos.y), start_pos.y);
+    to_light.z = SIMD::sub(SIMD::set1(light_pos.z), start_pos.z);
+    vfloat length = SIMD::sqrt(SIMD::add(SIMD::add(SIMD::mul(to_light.x, to_light.x), SIMD::mul(to_light.y, to_light.y)), SIMD::mul(to_light.z, to_light.z)));
+    vfloat inverse_length = SIMD::div(SIMD::set1(1.0f), length);
+    vfloat has_length = SIMD::cmp_gt(length, SIMD::zero());
+    to_light.x = SIMD::select(has_length, SIMD::mul(to_light.x, inverse_length), to_light.x);
+    to_light.y = SIMD::select(has_length, SIMD::mul(to_light.y, inverse_length), to_light.y);
+    to_light.z = SIMD::select(has_length, SIMD::mul(to_light.z, inverse_length), to_light.z);
+
+    packet_vector3_t<SIMD> pos = start_pos;
+    vfloat total_density = SIMD::zero();
+    for(unsigned int i = 1; i <= NUM_LIGHT_STEPS; ++i){
+        float spread = cone_radius * (float)i;
+        packet_vector3_t<SIMD> cone_pos;
+        cone_pos.x = SIMD::add(pos.x, SIMD::set1(RANDOM_VECTORS[i - 1].x * spread));
+        cone_pos.y = SIMD::add(pos.y, SIMD::set1(RANDOM_VECTORS[i - 1].y * spread));
+        cone_pos.z = SIMD::add(pos.z, SIMD::set1(RANDOM_VECTORS[i - 1].z * spread));
+
+        int mip_offset = (int)((float)i * 0.5f);
+        total_density = SIMD::add(total_density, sample_density_lanes<SIMD>(context, cone_pos, mip_level + (float)mip_offset, true));
+
+        pos.x = SIMD::add(pos.x, SIMD::mul(to_light.x, step_size));
+        pos.y = SIMD::add(pos.y, SIMD::mul(to_light.y, step_size));
+        pos.z = SIMD::add(pos.z, SIMD::mul(to_light.z, step_size));
+    }
+
+    return exp_lanes<SIMD>(negate_lanes<SIMD>(total_density));
+}
+
+// The sun's transmittance at <pos> for the lanes in <mask>, off the light
+// volume where it covers, the cone marched for the rest
+template<typename SIMD>
+static typename SIMD::vfloat get_light_transmittance_lanes(const march_context_t& context, const packet_vector3_t<SIMD>& pos, int mask)
+{
+    const cloud_light_volume_t* light = context.volumes->light;
+    const Vector3& light_pos = context.params->cloud.sun_position;
+
+    if(nullptr == light){
+        context.counters->num_density_samples += NUM_LIGHT_STEPS * count_lanes(mask);
+        return march_light_cone_lanes<SIMD>(context, pos, light_pos);
+    }
+
+    alignas(SIMD_ALIGN_BYTES) float xs[SIMD::WIDTH];
+    alignas(SIMD_ALIGN_BYTES) float ys[SIMD::WIDTH];
+    alignas(SIMD_ALIGN_BYTES) float zs[SIMD::WIDTH];
+    alignas(SIMD_ALIGN_BYTES) float transmittances[SIMD::WIDTH];
+    SIMD::store(xs, pos.x);
+    SIMD::store(ys, pos.y);
+    SIMD::store(zs, pos.z);
+
+    int cone_mask = 0;
+    for(unsigned int lane = 0; lane < SIMD::WIDTH; ++lane){
+        transmittances[lane] = 1.0f;
+        if(((mask >> lane) & 1) == 0){
+            continue;
+        }
+        if(cloud_light_get_transmittance(*light, *context.params, Vector3(xs[lane], ys[lane], zs[lane]), &transmittances[lane])){
+            ++context.counters->num_light_lookups;
+        }else{
+            cone_mask |= 1 << lane;
+        }
+    }
+
+    typename SIMD::vfloat transmittance = SIMD::load(transmittances);
+    if(cone_mask != 0){
+        context.counters->num_density_samples += NUM_LIGHT_STEPS * count_lanes(cone_mask);
+        transmittance = SIMD::select(get_lane_mask<SIMD>(cone_mask), march_light_cone_lanes<SIMD>(context, pos, light_pos), transmittance);
+    }
+    return transmittance;
+}
+
+// march_pixel for the pixels at <us> along <v>, <valid_mask> being the lanes with a pixel
+template<typename SIMD>
+static void march_packet(const march_context_t& context, const float* us, float v, int valid_mask, float* const* out_rgba)
+{
+    typedef typename SIMD::vfloat vfloat;
+    const unsigned int WIDTH = SIMD::WIDTH;
+    const cloud_raymarch_params_t& params = *context.params;
+
+    Vector3 eye_world_pos;
+    alignas(SIMD_ALIGN_BYTES) float dir_xs[WIDTH];
+    alignas(SIMD_ALIGN_BYTES) float dir_ys[WIDTH];
+    alignas(SIMD_ALIGN_BYTES) float dir_zs[WIDTH];
+    for(unsigned int lane = 0; lane < WIDTH; ++lane){
+        Vector3 ray_dir;
+        cloud_raymarch_get_ray(params, us[lane], v, &eye_world_pos, &ray_dir);
+        dir_xs[lane] = ray_dir.x;
+        dir_ys[lane] = ray_dir.y;
+        dir_zs[lane] = ray_dir.z;
+    }
+
+    Vector3 to_light = (params.cloud.sun_position - eye_world_pos).Normalized();
+
+    packet_vector3_t<SIMD> ray_dir;
+    ray_dir.x = SIMD::load(dir_xs);
+    ray_dir.y = SIMD::load(dir_ys);
+    ray_dir.z = SIMD::load(dir_zs);
+
+    packet_vector3_t<SIMD> layer_start, layer_end;
+    int hit_mask = get_cloud_layer_lanes<SIMD>(eye_world_pos, ray_dir, &layer_start, &layer_end) & valid_mask;
+    context.counters->num_rays += count_lanes(hit_mask);
+
+    // What do_cloud_ray_march works out before its loop, per lane
+    alignas(SIMD_ALIGN_BYTES) float start_xs[WIDTH], start_ys[WIDTH], start_zs[WIDTH];
+    alignas(SIMD_ALIGN_BYTES) float end_xs[WIDTH], end_ys[WIDTH], end_zs[WIDTH];
+    SIMD::store(start_xs, layer_start.x);
+    SIMD::store(start_ys, layer_start.y);
+    SIMD::store(start_zs, layer_start.z);
+    SIMD::store(end_xs, layer_end.x);
+    SIMD::store(end_ys, layer_end.y);
+    SIMD::store(end_zs, layer_end.z);
+
+    alignas(SIMD_ALIGN_BYTES) float ds_xs[WIDTH], ds_ys[WIDTH], ds_zs[WIDTH];
+    alignas(SIMD_ALIGN_BYTES) float phases[WIDTH];
+    alignas(SIMD_ALIGN_BYTES) float absorption_mults[WIDTH];
+    unsigned int num_steps[WIDTH];
+    unsigned int max_num_steps = 0;
+    Vector3 light_dir = to_light.Normalized();
+    for(unsigned int lane = 0; lane < WIDTH; ++lane){
+        ds_xs[lane] = ds_ys[lane] = ds_zs[lane] = 0.0f;
+        phases[lane] = absorption_mults[lane] = 0.0f;
+        num_steps[lane] = 0;
+        if(((hit_mask >> lane) & 1) == 0){
+            continue;
+        }
+
+        Vector3 ray_disp = Vector3(end_xs[lane], end_ys[lane], end_zs[lane]) - Vector3(start_xs[lane], start_ys[lane], start_zs[lane]);
+        Vector3 lane_dir = ray_disp.Normalized();
+
+        // Zero steps stays black, as in the shader
+        num_steps[lane] = get_num_steps(params, lane_dir);
+        if(num_steps[lane] == 0){
+            continue;
+        }
+        max_num_steps = (num_steps[lane] > max_num_steps) ? num_steps[lane] : max_num_steps;
+
+        Vector3 ds = ray_disp / (float)num_steps[lane];
+        ds_xs[lane] = ds.x;
+        ds_ys[lane] = ds.y;
+        ds_zs[lane] = ds.z;
+        phases[lane] = get_phase(params, DotProduct(light_dir, lane_dir));
+        absorption_mults[lane] = -params.sliders[4] * ds.CalcLength();
+    }
+
+    packet_vector3_t<SIMD> ds;
+    ds.x = SIMD::load(ds_xs);
+    ds.y = SIMD::load(ds_ys);
+    ds.z = SIMD::load(ds_zs);
+    vfloat phase = SIMD::load(phases);
+    vfloat absorption_mult = SIMD::load(absorption_mults);
+    float mip = params.knobs[1] * 10.0f;
+
+    vfloat one = SIMD::set1(1.0f);
+    vfloat scattering_r = SIMD::set1(params.sliders[0] * 2.0f);
+    vfloat scattering_g = SIMD::set1(params.sliders[1] * 2.0f);
+    vfloat scattering_b = SIMD::set1(params.sliders[2] * 2.0f);
+    vfloat cutoff = SIMD::set1(0.00001f);
+
+    vfloat transmittance = one;
+    vfloat color_r = SIMD::zero();
+    vfloat color_g = SIMD::zero();
+    vfloat color_b = SIMD::zero();
+    vfloat opacity = SIMD::zero();
+
+    // Lanes drop out once past the cutoff or their own step count
+    int live_mask = hit_mask;
+    packet_vector3_t<SIMD> pos = layer_start;
+    for(unsigned int i = 0; i < max_num_steps; ++i){
+        int active_mask = live_mask;
+        for(unsigned int lane = 0; lane < WIDTH; ++lane){
+            active_mask &= (i < num_steps[lane]) ? ~0 : ~(1 << lane);
+        }
+        if(active_mask == 0){
+            break;
+        }
+        vfloat active = get_lane_mask<SIMD>(active_mask);
+        unsigned int num_active = count_lanes(active_mask);
+        context.counters->num_steps += num_active;
+        context.counters->num_density_samples += num_active;
+
+        vfloat density = saturate_lanes<SIMD>(sample_density_lanes<SIMD>(context, pos, mip, false));
+        vfloat dt = exp_lanes<SIMD>(SIMD::mul(absorption_mult, density));
+        vfloat step_transmittance = SIMD::mul(transmittance, dt);
+
+        vfloat light_phase = SIMD::mul(get_light_transmittance_lanes<SIMD>(context, pos, active_mask), phase);
+        vfloat color_weight = SIMD::sub(one, step_transmittance);
+        vfloat step_r = SIMD::add(SIMD::mul(color_r, color_weight), SIMD::mul(SIMD::mul(scattering_r, light_phase), step_transmittance));
+        vfloat step_g = SIMD::add(SIMD::mul(color_g, color_weight), SIMD::mul(SIMD::mul(scattering_g, light_phase), step_transmittance));
+        vfloat step_b = SIMD::add(SIMD::mul(color_b, color_weight), SIMD::mul(SIMD::mul(scattering_b, light_phase), step_transmittance));
+        vfloat step_opacity = SIMD::add(opacity, SIMD::mul(SIMD::sub(one, opacity), SIMD::sub(one, dt)));
+
+        transmittance = SIMD::select(active, step_transmittance, transmittance);
+        color_r = SIMD::select(active, step_r, color_r);
+        color_g = SIMD::select(active, step_g, color_g);
+        color_b = SIMD::select(active, step_b, color_b);
+        opacity = SIMD::select(active, step_opacity, opacity);
+
+        live_mask &= ~SIMD::move_mask(SIMD::bit_and(active, SIMD::cmp_le(step_transmittance, cutoff)));
+
+        pos.x = SIMD::add(pos.x, ds.x);
+        pos.y = SIMD::add(pos.y, ds.y);
+        pos.z = SIMD::add(pos.z, ds.z);
+    }
+
+    // gamma, then premultiply
+    alignas(SIMD_ALIGN_BYTES) float rs[WIDTH], gs[WIDTH], bs[WIDTH], opacities[WIDTH];
+    SIMD::store(rs, color_r);
+    SIMD::store(gs, color_g);
+    SIMD::store(bs, color_b);
+    SIMD::store(opacities, opacity);
+
+    const float inv_gamma = 1.0f / 2.2f;
+    for(unsigned int lane = 0; lane < WIDTH; ++lane){
+        if(((valid_mask >> lane) & 1) == 0){
+            continue;
+        }
+        float* rgba = out_rgba[lane];
+        rgba[0] = powf(fabsf(rs[lane]), inv_gamma) * opacities[lane];
+        rgba[1] = powf(fabsf(gs[lane]), inv_gamma) * opacities[lane];
+        rgba[2] = powf(fabsf(bs[lane]), inv_gamma) * opacities[lane];
+        rgba[3] = opacities[lane];
+    }
+}
+
+template<typename SIMD>
+static void render_tile_packets(unsigned int tile, void* user_data)
+{
+    render_pass_t* pass = (render_pass_t*)user_data;
+    cloud_image_t* image = pass->image;
+
+    march_context_t context;
+    context.params      = pass->params;
+    context.volumes     = pass->volumes;
+    context.occupancy   = nullptr;
+    context.counters    = &pass->tile_counters[tile];
+
+    unsigned int x0 = (tile % pass->num_tiles_x) * CLOUD_RAYMARCH_TILE_SIZE;
+    unsigned int y0 = (tile / pass->num_tiles_x) * CLOUD_RAYMARCH_TILE_SIZE;
+    unsigned int x1 = (x0 + CLOUD_RAYMARCH_TILE_SIZE < image->width) ? x0 + CLOUD_RAYMARCH_TILE_SIZE : image->width;
+    unsigned int y1 = (y0 + CLOUD_RAYMARCH_TILE_SIZE < image->height) ? y0 + CLOUD_RAYMARCH_TILE_SIZE : image->height;
+
+    // A short packet at the tile's edge repeats its last pixel in the spare lanes
+    float inv_width = 1.0f / (float)image->width;
+    float inv_height = 1.0f / (float)image->height;
+    float us[SIMD::WIDTH];
+    float* pixels[SIMD::WIDTH];
+    for(unsigned int y = y0; y < y1; ++y){
+        float v = ((float)y + 0.5f) * inv_height;
+        for(unsigned int x = x0; x < x1; x += SIMD::WIDTH){
+            int valid_mask = 0;
+            for(unsigned int lane = 0; lane < SIMD::WIDTH; ++lane){
+                unsigned int lane_x = (x + lane < x1) ? x + lane : x1 - 1;
+                valid_mask |= (x + lane < x1) ? (1 << lane) : 0;
+                us[lane] = ((float)lane_x + 0.5f) * inv_width;
+                pixels[lane] = image->get_pixel(lane_x, y);
+            }
+            march_packet<SIMD>(context, us, v, valid_mask, pixels);
+        }
+    }
+}
+
+// The simd8_t tile, only use it after checking cpu_has_avx2()
+void    cloud_raymarch_render_tile_avx2(unsigned int tile, void* user_data);
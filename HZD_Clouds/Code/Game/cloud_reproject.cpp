@@ -0,0 +1,249 @@
+#include "Game/cloud_reproject.h"
+
+#include "Engine/Core/Time.hpp"
+#include "Engine/Core/job.h"
+
+#include <math.h>
+#include <string.h>
+
+//-----------------------------------------------------
+// Internal helpers
+
+// 4x4 ordered dither, each slot's pixel as far from the previous ones as it gets
+static const unsigned int BAYER_4X4[CLOUD_REPROJECT_BLOCK_SIZE][CLOUD_REPROJECT_BLOCK_SIZE] =
+{
+    {  0,  8,  2, 10 },
+    { 12,  4, 14,  6 },
+    {  3, 11,  1,  9 },
+    { 15,  7, 13,  5 }
+};
+
+// Bilinear weight a history texel whose ray missed the layer can have and still be left out
+static const float MAX_MISSED_WEIGHT        = 0.01f;
+
+// Per row tallies, summed into the stats once the frame is done
+struct reproject_counters_t
+{
+    uint64_t    num_scheduled;
+    uint64_t    num_fallbacks;
+    uint64_t    num_reprojected;
+    uint64_t    num_missed;
+};
+
+struct reproject_pass_t
+{
+    const cloud_reproject_t*            reproject;
+    const cloud_raymarch_params_t*      params;
+    cloud_parameters_data_t             history_camera;
+    cloud_shade_cb                      shade;
+    void*                               user_data;
+    unsigned int                        slot;
+    bool                                has_history;
+    cloud_image_t*                      image;
+    std::vector<float>                  depth;
+    std::vector<reproject_counters_t>   row_counters;
+};
+
+struct raymarch_shade_t
+{
+    const cloud_raymarch_params_t*      params;
+    const cloud_raymarch_volumes_t*     volumes;
+};
+
+// Bilinear read of the history at <world_pos>, false if it's off screen or
+// the history reached the layer at a different distance there
+static bool read_history(const reproject_pass_t& pass, const Vector3& world_pos, float* out_rgba)
+{
+    const cloud_reproject_t& reproject = *pass.reproject;
+    const cloud_image_t& history = reproject.history;
+
+    float u, v;
+    if(!cloud_reproject_get_uv(pass.history_camera, world_pos, &u, &v)){
+        return false;
+    }
+
+    // Pixel centers sit at half texels
+    float px = (u * (float)history.width) - 0.5f;
+    float py = (v * (float)history.height) - 0.5f;
+    if(!(px >= 0.0f) || !(py >= 0.0f) || (px > (float)(history.width - 1)) || (py > (float)(history.height - 1))){
+        return false;
+    }
+
+    unsigned int x0 = (unsigned int)px;
+    unsigned int y0 = (unsigned int)py;
+    x0 = (x0 + 1 < history.width) ? x0 : history.width - 2;
+    y0 = (y0 + 1 < history.height) ? y0 : history.height - 2;
+    float fx = px - (float)x0;
+    float fy = py - (float)y0;
+
+    // Texels whose rays missed the layer can only sit at the edge of a bilinear
+    // read, past the horizon. A hair of weight on them is dropped, more means
+    // the sky's edge moved through here.
+    unsigned int xs[4] = { x0, x0 + 1, x0, x0 + 1 };
+    unsigned int ys[4] = { y0, y0, y0 + 1, y0 + 1 };
+    float weights[4] = { (1.0f - fx) * (1.0f - fy), fx * (1.0f - fy), (1.0f - fx) * fy, fx * fy };
+    float total_weight = 0.0f;
+    float depth = 0.0f;
+    for(unsigned int t = 0; t < 4; ++t){
+        float texel_depth = reproject.history_depth[((size_t)ys[t] * history.width) + xs[t]];
+        if(!(texel_depth > 0.0f)){
+            if(weights[t] > MAX_MISSED_WEIGHT){
+                return false;
+            }
+            weights[t] = 0.0f;
+        }
+        total_weight += weights[t];
+        depth += weights[t] * texel_depth;
+    }
+
+    // The layer distance the history has there against the one this point is at
+    float expected_depth = CalcDistance(world_pos, pass.history_camera.transform.get_translation().GetXYZ());
+    depth /= total_weight;
+    if(fabsf(depth - expected_depth) > expected_depth * reproject.max_depth_difference){
+        return false;
+    }
+
+    out_rgba[0] = out_rgba[1] = out_rgba[2] = out_rgba[3] = 0.0f;
+    for(unsigned int t = 0; t < 4; ++t){
+        const float* texel = history.get_pixel(xs[t], ys[t]);
+        float weight = weights[t] / total_weight;
+        for(unsigned int c = 0; c < 4; ++c){
+            out_rgba[c] += texel[c] * weight;
+        }
+    }
+    return true;
+}
+
+static void reproject_row(unsigned int y, void* user_data)
+{
+    reproject_pass_t* pass = (reproject_pass_t*)user_data;
+    cloud_image_t* image = pass->image;
+    reproject_counters_t& counters = pass->row_counters[y];
+
+    float v = ((float)y + 0.5f) / (float)image->height;
+    const unsigned int* bayer_row = BAYER_4X4[y % CLOUD_REPROJECT_BLOCK_SIZE];
+    for(unsigned int x = 0; x < image->width; ++x){
+        float u = ((float)x + 0.5f) / (float)image->width;
+        float* rgba = image->get_pixel(x, y);
+        float* depth = pass->depth.data() + ((size_t)y * image->width) + x;
+
+        Vector3 eye_pos, ray_dir, layer_start, layer_end;
+        cloud_raymarch_get_ray(*pass->params, u, v, &eye_pos, &ray_dir);
+        if(!cloud_raymarch_get_cloud_layer(eye_pos, ray_dir, &layer_start, &layer_end)){
+            rgba[0] = rgba[1] = rgba[2] = rgba[3] = 0.0f;
+            *depth = 0.0f;
+            ++counters.num_missed;
+            continue;
+        }
+        *depth = CalcDistance(layer_start, eye_pos);
+
+        if(pass->has_history && (bayer_row[x % CLOUD_REPROJECT_BLOCK_SIZE] != pass->slot)){
+            if(read_history(*pass, layer_start, rgba)){
+                ++counters.num_reprojected;
+                continue;
+            }
+            ++counters.num_fallbacks;
+        }else{
+            ++counters.num_scheduled;
+        }
+        pass->shade(u, v, pass->user_data, rgba);
+    }
+}
+
+static void shade_raymarch(float u, float v, void* user_data, float* out_rgba)
+{
+    const raymarch_shade_t* shade = (const raymarch_shade_t*)user_data;
+    cloud_raymarch_pixel(*shade->params, *shade->volumes, u, v, out_rgba);
+}
+
+//-----------------------------------------------------
+// Public API
+
+void cloud_reproject_reset(cloud_reproject_t* reproject)
+{
+    reproject->frame_index = 0;
+    reproject->has_history = false;
+}
+
+bool cloud_reproject_get_uv(const cloud_parameters_data_t& camera, const Vector3& world_pos, float* out_u, float* out_v)
+{
+    Vector3 right = camera.transform.get_i_basis().GetXYZ();
+    Vector3 up = camera.transform.get_j_basis().GetXYZ();
+    Vector3 forward = camera.transform.get_k_basis().GetXYZ();
+    Vector3 to_pos = world_pos - camera.transform.get_translation().GetXYZ();
+
+    // get_ray's dir is forward * focal_length + right * ndc_x + up * ndc_y, normalized
+    float depth = DotProduct(to_pos, forward);
+    if(!(depth > 0.0f)){
+        return false;
+    }
+    float ndc_x = DotProduct(to_pos, right) * camera.focal_length / depth;
+    float ndc_y = DotProduct(to_pos, up) * camera.focal_length / depth;
+
+    *out_u = ((ndc_x / (16.0f / 9.0f)) + 1.0f) * 0.5f;
+    *out_v = 1.0f - ((ndc_y + 1.0f) * 0.5f);
+    return true;
+}
+
+void cloud_reproject_frame(cloud_reproject_t* reproject, const cloud_raymarch_params_t& params, cloud_shade_cb shade, void* user_data, unsigned int width, unsigned int height,
+    cloud_image_t* out_image, unsigned int max_workers, cloud_reproject_stats_t* out_stats)
+{
+    double start = get_current_time_seconds();
+
+    // Bilinear reads need two texels each way
+    bool is_same_size = (reproject->history.width == width) && (reproject->history.height == height);
+    if(!is_same_size || (width < 2) || (height < 2)){
+        reproject->has_history = false;
+    }
+
+    out_image->width = width;
+    out_image->height = height;
+    out_image->pixels.resize((size_t)width * height * 4);
+
+    reproject_pass_t pass;
+    pass.reproject      = reproject;
+    pass.params         = &params;
+    pass.shade          = shade;
+    pass.user_data      = user_data;
+    pass.slot           = reproject->frame_index % CLOUD_REPROJECT_BLOCK_PIXELS;
+    pass.has_history    = reproject->has_history;
+    pass.image          = out_image;
+    pass.depth.resize((size_t)width * height);
+
+    pass.history_camera = cloud_parameters_data_t();
+    pass.history_camera.transform       = reproject->history_transform;
+    pass.history_camera.focal_length    = reproject->history_focal_length;
+
+    pass.row_counters.assign(height, reproject_counters_t());
+
+    unsigned int num_workers = job_parallel_for(height, reproject_row, &pass, max_workers);
+
+    reproject->history = *out_image;
+    reproject->history_depth.swap(pass.depth);
+    reproject->history_transform = params.cloud.transform;
+    reproject->history_focal_length = params.cloud.focal_length;
+    reproject->has_history = true;
+    ++reproject->frame_index;
+
+    if(nullptr != out_stats){
+        memset(out_stats, 0, sizeof(*out_stats));
+        out_stats->seconds      = get_current_time_seconds() - start;
+        out_stats->num_workers  = num_workers;
+        out_stats->num_pixels   = (uint64_t)width * height;
+        for(const reproject_counters_t& counters : pass.row_counters){
+            out_stats->num_scheduled    += counters.num_scheduled;
+            out_stats->num_fallbacks    += counters.num_fallbacks;
+            out_stats->num_reprojected  += counters.num_reprojected;
+            out_stats->num_missed       += counters.num_missed;
+        }
+    }
+}
+
+void cloud_reproject_render(cloud_reproject_t* reproject, const cloud_raymarch_params_t& params, const cloud_raymarch_volumes_t& volumes, unsigned int width, unsigned int height,
+    cloud_image_t* out_image, unsigned int max_workers, cloud_reproject_stats_t* out_stats)
+{
+    raymarch_shade_t shade;
+    shade.params    = &params;
+    shade.volumes   = &volumes;
+    cloud_reproject_frame(reproject, params, shade_raymarch, &shade, width, height, out_image, max_workers, out_stats);
+}
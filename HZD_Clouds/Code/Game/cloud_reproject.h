@@ -0,0 +1,86 @@
+#pragma once
+
+#include "Game/cloud_raymarch.h"
+
+#include <stdint.h>
+#include <vector>
+
+//-----------------------------------------------------
+// Cloud reprojection
+//
+// Marches one pixel of every 4x4 block a frame and carries the rest over
+// from the previous one. The pixels marched fresh follow a Bayer order, so a
+// still camera has every pixel up to date after 16 frames.
+//
+// Every other pixel finds where it was last frame. Its ray meets the cloud
+// layer at some point, and that point goes through the last frame's camera
+// (cloud_parameters_data_t::transform, Camera3d::GetWorldTransform in the
+// game). The history is read bilinearly there. The point is where the ray
+// enters the layer, which is all a pixel knows before it marches.
+//
+// A pixel falls back to a full march when any of these is true:
+//  - it lands off the last frame
+//  - the history reached the layer at a different distance there, or
+//    missed it, since that's something else showing through
+//  - there's no history yet
+// Rays that miss the layer are black, with nothing to march or carry over.
+//
+// Pixels are shaded through a callback, so synthetic images can stand in for
+// the raymarcher in tests. Rows are split across GENERIC jobs.
+
+#define CLOUD_REPROJECT_BLOCK_SIZE      4
+#define CLOUD_REPROJECT_BLOCK_PIXELS    (CLOUD_REPROJECT_BLOCK_SIZE * CLOUD_REPROJECT_BLOCK_SIZE)
+
+// Premultiplied RGBA for the pixel at <u, v>, as cloud_raymarch_pixel writes it
+typedef void (*cloud_shade_cb)(float u, float v, void* user_data, float* out_rgba);
+
+struct cloud_reproject_stats_t
+{
+    double          seconds;
+    unsigned int    num_workers;
+    uint64_t        num_pixels;
+    uint64_t        num_scheduled;          // this frame's Bayer slot, always marched
+    uint64_t        num_fallbacks;          // marched because they couldn't be reprojected
+    uint64_t        num_reprojected;
+    uint64_t        num_missed;             // rays that miss the layer, neither
+
+    uint64_t get_num_marched() const        { return num_scheduled + num_fallbacks; }
+    double marched_fraction() const         { return (num_pixels > 0) ? (double)get_num_marched() / (double)num_pixels : 0.0; }
+};
+
+struct cloud_reproject_t
+{
+    unsigned int        frame_index;        // picks the Bayer slot
+    bool                has_history;
+    cloud_image_t       history;
+    std::vector<float>  history_depth;      // eye to layer distance per pixel, 0 where the ray missed
+    Matrix4             history_transform;
+    float               history_focal_length;
+
+    // Tolerance on a history texel's layer distance, relative
+    float               max_depth_difference;
+
+    cloud_reproject_t()
+        :frame_index(0)
+        ,has_history(false)
+        ,history_focal_length(0.0f)
+        ,max_depth_difference(0.05f)
+    {}
+};
+
+// Drops the history, the next frame marches everything
+void    cloud_reproject_reset(cloud_reproject_t* reproject);
+
+// Where <world_pos> lands on screen through <camera>, false behind it. The
+// inverse of cloud_raymarch_get_ray, uv outside [0, 1] being off screen.
+bool    cloud_reproject_get_uv(const cloud_parameters_data_t& camera, const Vector3& world_pos, float* out_u, float* out_v);
+
+// One frame for the camera in <params>, shading the pixels it can't carry
+// over with <shade>. A size change drops the history. Needs job_system_init,
+// <max_workers> 0 uses every core.
+void    cloud_reproject_frame(cloud_reproject_t* reproject, const cloud_raymarch_params_t& params, cloud_shade_cb shade, void* user_data, unsigned int width, unsigned int height,
+            cloud_image_t* out_image, unsigned int max_workers = 0, cloud_reproject_stats_t* out_stats = nullptr);
+
+// cloud_reproject_frame with cloud_raymarch_pixel doing the shading
+void    cloud_reproject_render(cloud_reproject_t* reproject, const cloud_raymarch_params_t& params, const cloud_raymarch_volumes_t& volumes, unsigned int width, unsigned int height,
+            cloud_image_t* out_image, unsigned int max_workers = 0, cloud_reproject_stats_t* out_stats = nullptr);
@@ -0,0 +1,195 @@
+#include "Game/cloud_upsample.h"
+
+#include "Engine/Core/Config.hpp"
+#include "Engine/Core/Time.hpp"
+#include "Engine/Core/cpu.h"
+#include "Engine/Core/job.h"
+#include "Engine/Core/log.h"
+#include "Game/cloud_upsample_lanes.h"
+
+#include <string.h>
+
+//-----------------------------------------------------
+// Internal helpers
+
+struct depth_pass_t
+{
+    const cloud_raymarch_params_t*  params;
+    unsigned int                    width;
+    unsigned int                    height;
+    float*                          depth;
+};
+
+static void depth_row(unsigned int y, void* user_data)
+{
+    const depth_pass_t* pass = (const depth_pass_t*)user_data;
+    float v = ((float)y + 0.5f) / (float)pass->height;
+    float* depth = pass->depth + ((size_t)y * pass->width);
+    for(unsigned int x = 0; x < pass->width; ++x){
+        float u = ((float)x + 0.5f) / (float)pass->width;
+        Vector3 eye_pos, ray_dir, layer_start, layer_end;
+        cloud_raymarch_get_ray(*pass->params, u, v, &eye_pos, &ray_dir);
+        depth[x] = cloud_raymarch_get_cloud_layer(eye_pos, ray_dir, &layer_start, &layer_end) ? CalcDistance(layer_start, eye_pos) : 0.0f;
+    }
+}
+
+// Pixel centers line up, so pixel <i> of <full_size> sits at (i + 0.5) * low / full - 0.5 texels
+static upsample_coord_t get_upsample_coord(unsigned int i, unsigned int full_size, unsigned int low_size)
+{
+    float p = (((float)i + 0.5f) * (float)low_size / (float)full_size) - 0.5f;
+    float max_p = (float)(low_size - 1);
+    p = (p < 0.0f) ? 0.0f : ((p > max_p) ? max_p : p);
+
+    upsample_coord_t coord;
+    coord.low0 = (int)p;
+    coord.low1 = ((unsigned int)coord.low0 + 1 < low_size) ? coord.low0 + 1 : coord.low0;
+    coord.frac = p - (float)coord.low0;
+    return coord;
+}
+
+static void upsample_row(unsigned int y, void* user_data)
+{
+    const upsample_pass_t* pass = (const upsample_pass_t*)user_data;
+    for(unsigned int x = 0; x < pass->width; ++x){
+        upsample_pixel(*pass, x, y, pass->image->get_pixel(x, y));
+    }
+}
+
+static bool has_guides_for(const cloud_upsample_t& upsample, const cloud_raymarch_params_t& params, unsigned int width, unsigned int height)
+{
+    return upsample.has_guides
+        && (upsample.guide_width == width) && (upsample.guide_height == height) && (upsample.guide_scale == upsample.scale)
+        && (upsample.guide_focal_length == params.cloud.focal_length)
+        && (memcmp(&upsample.guide_transform, &params.cloud.transform, sizeof(Matrix4)) == 0);
+}
+
+//-----------------------------------------------------
+// Public API
+
+bool cloud_upsample_is_valid_scale(unsigned int scale)
+{
+    return (scale == 1) || (scale == 2) || (scale == CLOUD_UPSAMPLE_MAX_SCALE);
+}
+
+void cloud_upsample_load_from_config(cloud_upsample_t* upsample)
+{
+    int scale = (int)upsample->scale;
+    if(ConfigGetInt(&scale, "cloud_resolution_scale")){
+        if(cloud_upsample_is_valid_scale((unsigned int)scale)){
+            upsample->scale = (unsigned int)scale;
+        }else{
+            log_warningf("cloud_resolution_scale %d isn't 1, 2 or 4, keeping %u", scale, upsample->scale);
+        }
+    }
+    ConfigGetFloat(&upsample->depth_sigma, "cloud_upsample_depth_sigma");
+    ConfigGetFloat(&upsample->transmittance_sigma, "cloud_upsample_transmittance_sigma");
+}
+
+unsigned int cloud_upsample_get_low_size(unsigned int size, unsigned int scale)
+{
+    return (size + scale - 1) / scale;
+}
+
+void cloud_upsample_get_depth(const cloud_raymarch_params_t& params, unsigned int width, unsigned int height, std::vector<float>* out_depth, unsigned int max_workers)
+{
+    out_depth->resize((size_t)width * height);
+
+    depth_pass_t pass;
+    pass.params = &params;
+    pass.width  = width;
+    pass.height = height;
+    pass.depth  = out_depth->data();
+    job_parallel_for(height, depth_row, &pass, max_workers);
+}
+
+unsigned int cloud_upsample_image(const cloud_upsample_t& upsample, const cloud_image_t& low_image, const std::vector<float>& low_depth, const std::vector<float>& full_depth,
+    unsigned int width, unsigned int height, cloud_image_t* out_image, unsigned int max_workers)
+{
+    out_image->width = width;
+    out_image->height = height;
+    out_image->pixels.resize((size_t)width * height * 4);
+    if((width == 0) || (height == 0) || (low_image.width == 0) || (low_image.height == 0)){
+        return 0;
+    }
+
+    upsample_pass_t pass;
+    pass.low_image                  = &low_image;
+    pass.low_depth                  = low_depth.data();
+    pass.full_depth                 = full_depth.data();
+    pass.width                      = width;
+    pass.inv_depth_sigma            = (upsample.depth_sigma > 0.0f) ? 1.0f / upsample.depth_sigma : 0.0f;
+    pass.inv_transmittance_sigma    = (upsample.transmittance_sigma > 0.0f) ? 1.0f / upsample.transmittance_sigma : 0.0f;
+    pass.image                      = out_image;
+
+    pass.column_low0.resize(width);
+    pass.column_low1.resize(width);
+    pass.column_frac.resize(width);
+    for(unsigned int x = 0; x < width; ++x){
+        upsample_coord_t coord = get_upsample_coord(x, width, low_image.width);
+        pass.column_low0[x] = coord.low0;
+        pass.column_low1[x] = coord.low1;
+        pass.column_frac[x] = coord.frac;
+    }
+    pass.rows.resize(height);
+    for(unsigned int y = 0; y < height; ++y){
+        pass.rows[y] = get_upsample_coord(y, height, low_image.height);
+    }
+
+    job_item_cb row_cb;
+    switch(cpu_get_simd_level()){
+        case SIMD_LEVEL_AVX2:
+            row_cb = cloud_upsample_row_avx2;
+            break;
+        case SIMD_LEVEL_SSE41:
+            row_cb = upsample_row_lanes<simd4_t>;
+            break;
+        default:
+            row_cb = upsample_row;
+            break;
+    }
+    return job_parallel_for(height, row_cb, &pass, max_workers);
+}
+
+void cloud_upsample_render(cloud_upsample_t* upsample, const cloud_raymarch_params_t& params, const cloud_raymarch_volumes_t& volumes, unsigned int width, unsigned int height,
+    cloud_image_t* out_image, unsigned int max_workers, cloud_upsample_stats_t* out_stats)
+{
+    cloud_upsample_stats_t stats;
+    memset(&stats, 0, sizeof(stats));
+
+    if(upsample->scale <= 1){
+        cloud_raymarch_render_packets(params, volumes, width, height, out_image, max_workers, &stats.render);
+        stats.render_seconds    = stats.render.seconds;
+        stats.num_workers       = stats.render.num_workers;
+        stats.low_width         = width;
+        stats.low_height        = height;
+    }else{
+        unsigned int low_width = cloud_upsample_get_low_size(width, upsample->scale);
+        unsigned int low_height = cloud_upsample_get_low_size(height, upsample->scale);
+        cloud_raymarch_render_packets(params, volumes, low_width, low_height, &upsample->low_image, max_workers, &stats.render);
+
+        if(!has_guides_for(*upsample, params, width, height)){
+            double guide_start = get_current_time_seconds();
+            cloud_upsample_get_depth(params, low_width, low_height, &upsample->low_depth, max_workers);
+            cloud_upsample_get_depth(params, width, height, &upsample->full_depth, max_workers);
+            stats.guide_seconds = get_current_time_seconds() - guide_start;
+
+            upsample->has_guides            = true;
+            upsample->guide_transform       = params.cloud.transform;
+            upsample->guide_focal_length    = params.cloud.focal_length;
+            upsample->guide_width           = width;
+            upsample->guide_height          = height;
+            upsample->guide_scale           = upsample->scale;
+        }
+
+        double upsample_start = get_current_time_seconds();
+        stats.num_workers       = cloud_upsample_image(*upsample, upsample->low_image, upsample->low_depth, upsample->full_depth, width, height, out_image, max_workers);
+        stats.upsample_seconds  = get_current_time_seconds() - upsample_start;
+        stats.render_seconds    = stats.render.seconds;
+        stats.low_width         = low_width;
+        stats.low_height        = low_height;
+    }
+
+    if(nullptr != out_stats){
+        *out_stats = stats;
+    }
+}
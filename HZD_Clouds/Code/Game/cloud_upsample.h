@@ -0,0 +1,102 @@
+#pragma once
+
+#include "Game/cloud_raymarch.h"
+
+#include <vector>
+
+//-----------------------------------------------------
+// Cloud upsample
+//
+// Marches the clouds at a half or a quarter of the resolution and brings
+// them back up with a joint bilateral filter. Every full resolution pixel
+// blends the four low resolution texels around it. Each texel gets its
+// bilinear weight, cut down when either of these doesn't match:
+//
+//  - depth, how far the ray travels to reach the cloud layer. Both
+//    resolutions have it exactly, since it only takes a ray-sphere test per
+//    pixel. It changes sharply toward the horizon, and texels that missed
+//    the layer get no weight at all.
+//  - transmittance, the texel's alpha against the alpha of the texel
+//    nearest the pixel, which keeps cloud edges from smearing across clear
+//    sky
+//
+// Both falloffs are 1 / (1 + (difference / sigma)^2), a sigma of 0 turns
+// one off. With both off it's a plain bilinear upsample. Pixels whose rays
+// miss the layer come out black, like the march leaves them.
+//
+// Rows are split across GENERIC jobs. Within a row the pixels are done a
+// SIMD register at a time, 8 wide at AVX2 and 4 at SSE4.1, picked by
+// cpu_get_simd_level(). The lanes do the scalar pixel's float ops in the
+// same order, so every level gives the same image. The depth guides are
+// kept until the camera or the size changes.
+//
+// Only the CPU renders use this. The game draws its clouds in the pixel
+// shader at full resolution, so the scale is a CloudTool setting: the
+// cloud_resolution_scale config key, or bench_path -scale.
+
+#define CLOUD_UPSAMPLE_MAX_SCALE    4
+
+struct cloud_upsample_stats_t
+{
+    double                  render_seconds;         // the low resolution march
+    double                  guide_seconds;          // depth guides, 0 when they were kept
+    double                  upsample_seconds;
+    unsigned int            num_workers;
+    unsigned int            low_width;
+    unsigned int            low_height;
+    cloud_raymarch_stats_t  render;
+};
+
+struct cloud_upsample_t
+{
+    unsigned int        scale;                  // 1, 2 or 4, 1 marches every pixel
+    float               depth_sigma;            // relative
+    float               transmittance_sigma;
+
+    cloud_image_t       low_image;
+    std::vector<float>  low_depth;              // eye to layer distance per pixel, 0 where the ray missed
+    std::vector<float>  full_depth;
+
+    // The camera the depth guides were made for
+    bool                has_guides;
+    Matrix4             guide_transform;
+    float               guide_focal_length;
+    unsigned int        guide_width;
+    unsigned int        guide_height;
+    unsigned int        guide_scale;
+
+    cloud_upsample_t()
+        :scale(2)
+        ,depth_sigma(0.1f)
+        ,transmittance_sigma(0.25f)
+        ,has_guides(false)
+        ,guide_focal_length(0.0f)
+        ,guide_width(0)
+        ,guide_height(0)
+        ,guide_scale(0)
+    {}
+};
+
+bool            cloud_upsample_is_valid_scale(unsigned int scale);
+
+// cloud_resolution_scale, cloud_upsample_depth_sigma and cloud_upsample_transmittance_sigma
+// override the defaults, an invalid scale is logged and left alone
+void            cloud_upsample_load_from_config(cloud_upsample_t* upsample);
+
+// Low resolution size of a <size> axis, rounded up
+unsigned int    cloud_upsample_get_low_size(unsigned int size, unsigned int scale);
+
+// Eye to layer distance for every pixel of a <width> x <height> frame, 0
+// where the ray misses the layer. Needs job_system_init, <max_workers> 0 uses every core.
+void            cloud_upsample_get_depth(const cloud_raymarch_params_t& params, unsigned int width, unsigned int height, std::vector<float>* out_depth, unsigned int max_workers = 0);
+
+// <low_image> brought up to <width> x <height> with <upsample>'s sigmas,
+// guided by the depths of both. Returns the number of workers used.
+unsigned int    cloud_upsample_image(const cloud_upsample_t& upsample, const cloud_image_t& low_image, const std::vector<float>& low_depth, const std::vector<float>& full_depth,
+                    unsigned int width, unsigned int height, cloud_image_t* out_image, unsigned int max_workers = 0);
+
+// Marches <params> at 1 / scale with cloud_raymarch_render_packets and
+// upsamples to <width> x <height>, making the depth guides when the camera
+// has moved
+void            cloud_upsample_render(cloud_upsample_t* upsample, const cloud_raymarch_params_t& params, const cloud_raymarch_volumes_t& volumes, unsigned int width, unsigned int height,
+                    cloud_image_t* out_image, unsigned int max_workers = 0, cloud_upsample_stats_t* out_stats = nullptr);
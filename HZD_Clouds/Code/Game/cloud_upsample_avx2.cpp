@@ -0,0 +1,9 @@
+#include "Game/cloud_upsample_lanes.h"
+
+//-----------------------------------------------------
+// Public API
+
+void cloud_upsample_row_avx2(unsigned int y, void* user_data)
+{
+    upsample_row_lanes<simd8_t>(y, user_data);
+}
@@ -0,0 +1,194 @@
+#pragma once
+
+#include "Game/cloud_upsample.h"
+
+#include "Engine/Math/simd.h"
+
+#include <string.h>
+
+//-----------------------------------------------------
+// Cloud Upsample Lanes
+//
+// The pass and row kernels of cloud_upsample_image, shared by
+// cloud_upsample.cpp (scalar and simd4_t) and cloud_upsample_avx2.cpp
+// (simd8_t), which is the only file built for AVX2. The functions are static
+// so each file compiles its own copy.
+
+// Where a row or column of the full frame reads the low one: the two texels
+// either side and how far along it is between them
+struct upsample_coord_t
+{
+    int     low0;
+    int     low1;
+    float   frac;
+};
+
+struct upsample_pass_t
+{
+    const cloud_image_t*            low_image;
+    const float*                    low_depth;
+    const float*                    full_depth;
+    unsigned int                    width;
+    float                           inv_depth_sigma;            // 0 when the term is off
+    float                           inv_transmittance_sigma;
+    std::vector<int>                column_low0;
+    std::vector<int>                column_low1;
+    std::vector<float>              column_frac;
+    std::vector<upsample_coord_t>   rows;
+    cloud_image_t*                  image;
+};
+
+// One pixel, the reference the lanes below follow op for op
+static void upsample_pixel(const upsample_pass_t& pass, unsigned int x, unsigned int y, float* out_rgba)
+{
+    const upsample_coord_t& row = pass.rows[y];
+    float depth = pass.full_depth[((size_t)y * pass.width) + x];
+    out_rgba[0] = out_rgba[1] = out_rgba[2] = out_rgba[3] = 0.0f;
+    if(!(depth > 0.0f)){
+        return;
+    }
+
+    int low_width = (int)pass.low_image->width;
+    float fx = pass.column_frac[x];
+    float fy = row.frac;
+    int taps[4] = {
+        (row.low0 * low_width) + pass.column_low0[x],
+        (row.low0 * low_width) + pass.column_low1[x],
+        (row.low1 * low_width) + pass.column_low0[x],
+        (row.low1 * low_width) + pass.column_low1[x]
+    };
+    float bilinear[4] = {
+        (1.0f - fx) * (1.0f - fy),
+        fx * (1.0f - fy),
+        (1.0f - fx) * fy,
+        fx * fy
+    };
+
+    const float* texels[4];
+    for(unsigned int t = 0; t < 4; ++t){
+        texels[t] = pass.low_image->pixels.data() + ((size_t)taps[t] * 4);
+    }
+    float anchor_alpha = texels[((fy < 0.5f) ? 0 : 2) + ((fx < 0.5f) ? 0 : 1)][3];
+
+    float inv_depth = 1.0f / depth;
+    float weights[4];
+    for(unsigned int t = 0; t < 4; ++t){
+        float tap_depth = pass.low_depth[taps[t]];
+        float depth_difference = ((depth - tap_depth) * inv_depth) * pass.inv_depth_sigma;
+        float alpha_difference = (texels[t][3] - anchor_alpha) * pass.inv_transmittance_sigma;
+        float depth_weight = 1.0f / (1.0f + (depth_difference * depth_difference));
+        float alpha_weight = 1.0f / (1.0f + (alpha_difference * alpha_difference));
+        weights[t] = (tap_depth > 0.0f) ? (bilinear[t] * depth_weight) * alpha_weight : 0.0f;
+    }
+
+    float total_weight = ((weights[0] + weights[1]) + weights[2]) + weights[3];
+    if(!(total_weight > 0.0f)){
+        return;
+    }
+    float inv_total_weight = 1.0f / total_weight;
+    for(unsigned int c = 0; c < 4; ++c){
+        float sum = (((weights[0] * texels[0][c]) + (weights[1] * texels[1][c])) + (weights[2] * texels[2][c])) + (weights[3] * texels[3][c]);
+        out_rgba[c] = sum * inv_total_weight;
+    }
+}
+
+template<typename SIMD>
+static void upsample_row_lanes(unsigned int y, void* user_data)
+{
+    typedef typename SIMD::vfloat vfloat;
+    typedef typename SIMD::vint vint;
+    const unsigned int W = SIMD::WIDTH;
+
+    const upsample_pass_t* pass = (const upsample_pass_t*)user_data;
+    const upsample_coord_t& row = pass->rows[y];
+    const float* low_pixels = pass->low_image->pixels.data();
+    const float* full_depth = pass->full_depth + ((size_t)y * pass->width);
+    int low_width = (int)pass->low_image->width;
+
+    const vfloat zero = SIMD::zero();
+    const vfloat one = SIMD::set1(1.0f);
+    const vfloat half = SIMD::set1(0.5f);
+    const vfloat fy = SIMD::set1(row.frac);
+    const vfloat one_minus_fy = SIMD::set1(1.0f - row.frac);
+    const vfloat inv_depth_sigma = SIMD::set1(pass->inv_depth_sigma);
+    const vfloat inv_transmittance_sigma = SIMD::set1(pass->inv_transmittance_sigma);
+    const vint row0 = SIMD::set1_int(row.low0 * low_width);
+    const vint row1 = SIMD::set1_int(row.low1 * low_width);
+    const bool is_top_nearest = (row.frac < 0.5f);
+
+    alignas(SIMD_ALIGN_BYTES) float lanes[4][W];
+
+    unsigned int x = 0;
+    for(; x + W <= pass->width; x += W){
+        vfloat depth = SIMD::load(full_depth + x);
+        vfloat is_hit = SIMD::cmp_gt(depth, zero);
+        if(SIMD::move_mask(is_hit) == 0){
+            memset(pass->image->get_pixel(x, y), 0, W * 4 * sizeof(float));
+            continue;
+        }
+
+        vint column0 = SIMD::load_int(pass->column_low0.data() + x);
+        vint column1 = SIMD::load_int(pass->column_low1.data() + x);
+        vfloat fx = SIMD::load(pass->column_frac.data() + x);
+        vfloat one_minus_fx = SIMD::sub(one, fx);
+
+        vint taps[4] = {
+            SIMD::add_int(row0, column0),
+            SIMD::add_int(row0, column1),
+            SIMD::add_int(row1, column0),
+            SIMD::add_int(row1, column1)
+        };
+        vfloat bilinear[4] = {
+            SIMD::mul(one_minus_fx, one_minus_fy),
+            SIMD::mul(fx, one_minus_fy),
+            SIMD::mul(one_minus_fx, fy),
+            SIMD::mul(fx, fy)
+        };
+
+        // RGBA interleaved, channel c of tap t is at tap * 4 + c
+        vint texel_offsets[4];
+        vfloat alphas[4];
+        for(unsigned int t = 0; t < 4; ++t){
+            texel_offsets[t] = SIMD::template shift_left<2>(taps[t]);
+            alphas[t] = SIMD::gather(low_pixels + 3, texel_offsets[t]);
+        }
+        vfloat is_left_nearest = SIMD::cmp_lt(fx, half);
+        vfloat anchor_alpha = is_top_nearest ? SIMD::select(is_left_nearest, alphas[0], alphas[1]) : SIMD::select(is_left_nearest, alphas[2], alphas[3]);
+
+        vfloat inv_depth = SIMD::div(one, depth);
+        vfloat weights[4];
+        for(unsigned int t = 0; t < 4; ++t){
+            vfloat tap_depth = SIMD::gather(pass->low_depth, taps[t]);
+            vfloat depth_difference = SIMD::mul(SIMD::mul(SIMD::sub(depth, tap_depth), inv_depth), inv_depth_sigma);
+            vfloat alpha_difference = SIMD::mul(SIMD::sub(alphas[t], anchor_alpha), inv_transmittance_sigma);
+            vfloat depth_weight = SIMD::div(one, SIMD::add(one, SIMD::mul(depth_difference, depth_difference)));
+            vfloat alpha_weight = SIMD::div(one, SIMD::add(one, SIMD::mul(alpha_difference, alpha_difference)));
+            weights[t] = SIMD::bit_and(SIMD::cmp_gt(tap_depth, zero), SIMD::mul(SIMD::mul(bilinear[t], depth_weight), alpha_weight));
+        }
+
+        vfloat total_weight = SIMD::add(SIMD::add(SIMD::add(weights[0], weights[1]), weights[2]), weights[3]);
+        vfloat is_covered = SIMD::bit_and(is_hit, SIMD::cmp_gt(total_weight, zero));
+        vfloat inv_total_weight = SIMD::div(one, total_weight);
+        for(unsigned int c = 0; c < 4; ++c){
+            vfloat sum = SIMD::mul(weights[0], SIMD::gather(low_pixels + c, texel_offsets[0]));
+            sum = SIMD::add(sum, SIMD::mul(weights[1], SIMD::gather(low_pixels + c, texel_offsets[1])));
+            sum = SIMD::add(sum, SIMD::mul(weights[2], SIMD::gather(low_pixels + c, texel_offsets[2])));
+            sum = SIMD::add(sum, SIMD::mul(weights[3], SIMD::gather(low_pixels + c, texel_offsets[3])));
+            SIMD::store(lanes[c], SIMD::select(is_covered, SIMD::mul(sum, inv_total_weight), zero));
+        }
+
+        float* out = pass->image->get_pixel(x, y);
+        for(unsigned int lane = 0; lane < W; ++lane){
+            for(unsigned int c = 0; c < 4; ++c){
+                out[(lane * 4) + c] = lanes[c][lane];
+            }
+        }
+    }
+
+    for(; x < pass->width; ++x){
+        upsample_pixel(*pass, x, y, pass->image->get_pixel(x, y));
+    }
+}
+
+// The simd8_t row, only use it after checking cpu_has_avx2()
+void    cloud_upsample_row_avx2(unsigned int y, void* user_data);
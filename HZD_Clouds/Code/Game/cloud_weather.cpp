@@ -0,0 +1,394 @@
+#include "Game/cloud_weather.h"
+
+#include "Engine/Core/Time.hpp"
+#include "Engine/Math/Noise.hpp"
+
+#include <math.h>
+#include <string.h>
+
+//-----------------------------------------------------
+// Internal helpers
+
+// Coverage is batched in whole groups of this many world texels, the widest
+// batch kernel's lanes, so no texel ever lands in the scalar leftovers and a
+// texel bakes to the same byte whichever rect it's part of
+static const int COVERAGE_GROUP_SIZE            = 8;
+
+// Cloud type, broad regions of one kind of cloud
+static const float TYPE_SCALE                   = 12000.0f;
+static const unsigned int TYPE_NUM_OCTAVES      = 2;
+static const unsigned int TYPE_SEED             = 1;
+
+// Precipitation, patches inside the covered areas
+static const float PRECIPITATION_SCALE          = 4000.0f;
+static const unsigned int PRECIPITATION_NUM_OCTAVES = 3;
+static const unsigned int PRECIPITATION_SEED    = 2;
+static const float PRECIPITATION_THRESHOLD      = 0.55f;
+static const float PRECIPITATION_FULL           = 0.85f;
+
+static const size_t TEXEL_BYTES                 = 4;
+
+static int wrap_texel(int t, unsigned int size)
+{
+    int wrapped = t % (int)size;
+    return (wrapped < 0) ? wrapped + (int)size : wrapped;
+}
+
+static int floor_to_multiple(int value, int multiple)
+{
+    int remainder = value % multiple;
+    return (remainder < 0) ? (value - remainder - multiple) : (value - remainder);
+}
+
+static unsigned char to_unorm8(float value)
+{
+    return (unsigned char)((cloud_saturate(value) * 255.0f) + 0.5f);
+}
+
+static cloud_weather_rect_t get_window(const cloud_weather_map_t& map)
+{
+    cloud_weather_rect_t window;
+    window.min_x = map.origin_x;
+    window.min_z = map.origin_z;
+    window.max_x = map.origin_x + (int)map.size;
+    window.max_z = map.origin_z + (int)map.size;
+    return window;
+}
+
+static cloud_weather_rect_t intersect_rects(const cloud_weather_rect_t& a, const cloud_weather_rect_t& b)
+{
+    cloud_weather_rect_t rect;
+    rect.min_x = (a.min_x > b.min_x) ? a.min_x : b.min_x;
+    rect.min_z = (a.min_z > b.min_z) ? a.min_z : b.min_z;
+    rect.max_x = (a.max_x < b.max_x) ? a.max_x : b.max_x;
+    rect.max_z = (a.max_z < b.max_z) ? a.max_z : b.max_z;
+    return rect;
+}
+
+static void set_origin(cloud_weather_map_t* map, float center_x, float center_z)
+{
+    map->origin_x = (int)floorf(center_x / map->texel_size) - (int)(map->size / 2);
+    map->origin_z = (int)floorf(center_z / map->texel_size) - (int)(map->size / 2);
+}
+
+// One brick of the rect being baked, rows of world texels
+static void bake_brick(volume_buffer_t* volume, const volume_brick_t& brick, void* user_data)
+{
+    const cloud_weather_map_t* map = (const cloud_weather_map_t*)user_data;
+    const cloud_weather_rect_t& rect = map->baking_rect;
+    const cloud_raymarch_params_t& params = map->baking_params;
+
+    int tx0 = rect.min_x + (int)brick.min_x;
+    int group_x0 = floor_to_multiple(tx0, COVERAGE_GROUP_SIZE);
+    int group_x1 = floor_to_multiple(rect.min_x + (int)brick.max_x + COVERAGE_GROUP_SIZE - 1, COVERAGE_GROUP_SIZE);
+    unsigned int count = (unsigned int)(group_x1 - group_x0);
+
+    float xs[CLOUD_WEATHER_BRICK_SIZE + (2 * COVERAGE_GROUP_SIZE)];
+    float zs[CLOUD_WEATHER_BRICK_SIZE + (2 * COVERAGE_GROUP_SIZE)];
+    float coverage[CLOUD_WEATHER_BRICK_SIZE + (2 * COVERAGE_GROUP_SIZE)];
+    for(unsigned int i = 0; i < count; ++i){
+        xs[i] = ((float)(group_x0 + (int)i) + 0.5f) * map->texel_size;
+    }
+
+    for(unsigned int y = brick.min_y; y < brick.max_y; ++y){
+        float z = ((float)(rect.min_z + (int)y) + 0.5f) * map->texel_size;
+        for(unsigned int i = 0; i < count; ++i){
+            zs[i] = z;
+        }
+        cloud_raymarch_get_coverage_batch(params, xs, zs, count, coverage);
+
+        unsigned char* texel = volume->get_voxel(brick.min_x, y, 0);
+        for(unsigned int x = brick.min_x; x < brick.max_x; ++x){
+            unsigned int i = (unsigned int)(rect.min_x + (int)x - group_x0);
+            float type = Compute2dPerlinNoiseZeroToOne(xs[i], z, TYPE_SCALE, TYPE_NUM_OCTAVES, 0.5f, 2.0f, true, TYPE_SEED);
+            float rain = Compute2dPerlinNoiseZeroToOne(xs[i], z, PRECIPITATION_SCALE, PRECIPITATION_NUM_OCTAVES, 0.5f, 2.0f, true, PRECIPITATION_SEED);
+            float precipitation = coverage[i] * cloud_saturate(cloud_range_map(rain, PRECIPITATION_THRESHOLD, PRECIPITATION_FULL, 0.0f, 1.0f));
+
+            texel[CLOUD_WEATHER_COVERAGE]       = to_unorm8(coverage[i]);
+            texel[CLOUD_WEATHER_TYPE]           = to_unorm8(type);
+            texel[CLOUD_WEATHER_PRECIPITATION]  = to_unorm8(precipitation);
+            texel[3]                            = 255;
+            texel += TEXEL_BYTES;
+        }
+    }
+}
+
+// The storage texels <rect> (within one window) lands on, split where it wraps
+static void add_updated_rects(cloud_weather_map_t* map, const cloud_weather_rect_t& rect)
+{
+    int size = (int)map->size;
+    int sx = wrap_texel(rect.min_x, map->size);
+    int sz = wrap_texel(rect.min_z, map->size);
+    int width = rect.max_x - rect.min_x;
+    int height = rect.max_z - rect.min_z;
+
+    int x_ranges[2][2] = { { sx, (sx + width < size) ? sx + width : size }, { 0, sx + width - size } };
+    int z_ranges[2][2] = { { sz, (sz + height < size) ? sz + height : size }, { 0, sz + height - size } };
+    for(unsigned int j = 0; j < 2; ++j){
+        for(unsigned int i = 0; i < 2; ++i){
+            cloud_weather_rect_t storage_rect;
+            storage_rect.min_x = x_ranges[i][0];
+            storage_rect.max_x = x_ranges[i][1];
+            storage_rect.min_z = z_ranges[j][0];
+            storage_rect.max_z = z_ranges[j][1];
+            if(!storage_rect.is_empty()){
+                map->updated_rects.push_back(storage_rect);
+            }
+        }
+    }
+}
+
+// Copies the baked rect in, only what's still inside the window
+static void finish_rect(cloud_weather_map_t* map)
+{
+    map->is_baking_rect = false;
+
+    const cloud_weather_rect_t& rect = map->baking_rect;
+    cloud_weather_rect_t clipped = intersect_rects(rect, get_window(*map));
+    if(clipped.is_empty()){
+        return;
+    }
+
+    for(int tz = clipped.min_z; tz < clipped.max_z; ++tz){
+        int tx = clipped.min_x;
+        while(tx < clipped.max_x){
+            int sx = wrap_texel(tx, map->size);
+            int run = (int)map->size - sx;
+            run = (run < clipped.max_x - tx) ? run : clipped.max_x - tx;
+
+            const unsigned char* src = map->rect_texels.get_voxel((unsigned int)(tx - rect.min_x), (unsigned int)(tz - rect.min_z), 0);
+            unsigned char* dst = map->texels.get_voxel((unsigned int)sx, (unsigned int)wrap_texel(tz, map->size), 0);
+            memcpy(dst, src, (size_t)run * TEXEL_BYTES);
+            tx += run;
+        }
+    }
+
+    add_updated_rects(map, clipped);
+    map->num_texels_baked += (size_t)(clipped.max_x - clipped.min_x) * (size_t)(clipped.max_z - clipped.min_z);
+    ++map->version;
+}
+
+static void queue_rect(cloud_weather_map_t* map, int min_x, int min_z, int max_x, int max_z)
+{
+    cloud_weather_rect_t rect;
+    rect.min_x = min_x;
+    rect.min_z = min_z;
+    rect.max_x = max_x;
+    rect.max_z = max_z;
+    if(!rect.is_empty()){
+        map->pending_rects.push_back(rect);
+    }
+}
+
+// Pops pending rects until one still has texels in the window, false when none do
+static bool begin_next_rect(cloud_weather_map_t* map, const cloud_raymarch_params_t& params)
+{
+    while(!map->pending_rects.empty()){
+        cloud_weather_rect_t rect = intersect_rects(map->pending_rects.front(), get_window(*map));
+        map->pending_rects.erase(map->pending_rects.begin());
+        if(rect.is_empty()){
+            continue;
+        }
+
+        map->baking_rect = rect;
+        map->baking_params = params;
+        map->rect_texels.resize((unsigned int)(rect.max_x - rect.min_x), (unsigned int)(rect.max_z - rect.min_z), 1, TEXEL_BYTES);
+        volume_fill_task_begin(&map->rect_task, &map->rect_texels, bake_brick, map, CLOUD_WEATHER_BRICK_SIZE);
+        map->is_baking_rect = true;
+        return true;
+    }
+    return false;
+}
+
+
+//-----------------------------------------------------
+// Public API
+
+void cloud_weather_init(cloud_weather_map_t* map, unsigned int size, float texel_size)
+{
+    cloud_weather_wait(map);
+
+    map->size = size;
+    map->texel_size = texel_size;
+    map->origin_x = 0;
+    map->origin_z = 0;
+    map->texels.resize(size, size, 1, TEXEL_BYTES);
+    map->is_baked = false;
+    map->is_baking_rect = false;
+    map->pending_rects.clear();
+    map->updated_rects.clear();
+    map->bake_seconds = 0.0;
+    map->num_texels_baked = 0;
+}
+
+void cloud_weather_bake(cloud_weather_map_t* map, const cloud_raymarch_params_t& params, float center_x, float center_z, unsigned int max_workers)
+{
+    double start = get_current_time_seconds();
+
+    cloud_weather_wait(map);
+    map->is_baking_rect = false;
+    map->pending_rects.clear();
+
+    set_origin(map, center_x, center_z);
+    map->baking_rect = get_window(*map);
+    map->baking_params = params;
+    map->rect_texels.resize(map->size, map->size, 1, TEXEL_BYTES);
+    volume_fill(&map->rect_texels, bake_brick, map, CLOUD_WEATHER_BRICK_SIZE, max_workers);
+    finish_rect(map);
+
+    map->is_baked = true;
+    map->coverage_time = params.game_time * params.knobs[5];
+    map->bake_seconds += get_current_time_seconds() - start;
+}
+
+bool cloud_weather_scroll(cloud_weather_map_t* map, float center_x, float center_z)
+{
+    cloud_weather_rect_t old_window = get_window(*map);
+    set_origin(map, center_x, center_z);
+    cloud_weather_rect_t window = get_window(*map);
+    if((window.min_x == old_window.min_x) && (window.min_z == old_window.min_z)){
+        return false;
+    }
+
+    cloud_weather_rect_t kept = intersect_rects(window, old_window);
+    if(kept.is_empty()){
+        queue_rect(map, window.min_x, window.min_z, window.max_x, window.max_z);
+        return true;
+    }
+
+    // Full height columns on the side it moved toward, then the rows above or below what's kept
+    if(window.min_x > old_window.min_x){
+        queue_rect(map, old_window.max_x, window.min_z, window.max_x, window.max_z);
+    }else{
+        queue_rect(map, window.min_x, window.min_z, old_window.min_x, window.max_z);
+    }
+
+    if(window.min_z > old_window.min_z){
+        queue_rect(map, kept.min_x, old_window.max_z, kept.max_x, window.max_z);
+    }else{
+        queue_rect(map, kept.min_x, window.min_z, kept.max_x, old_window.min_z);
+    }
+    return true;
+}
+
+bool cloud_weather_step(cloud_weather_map_t* map, const cloud_raymarch_params_t& params, float budget_ms, unsigned int max_workers)
+{
+    double start = get_current_time_seconds();
+    bool is_budgeted = (budget_ms > 0.0f);
+
+    for(;;){
+        if(!map->is_baking_rect && !begin_next_rect(map, params)){
+            break;
+        }
+
+        float elapsed_ms = (float)((get_current_time_seconds() - start) * 1000.0);
+        float step_budget_ms = is_budgeted ? (budget_ms - elapsed_ms) : 1.0e9f;
+        if(volume_fill_task_step(&map->rect_task, step_budget_ms, max_workers)){
+            finish_rect(map);
+        }else if(map->rect_task.next_brick >= map->rect_task.num_bricks){
+            // Every brick is claimed, only helpers are left
+            if(is_budgeted){
+                break;
+            }
+            volume_fill_task_wait(&map->rect_task);
+            finish_rect(map);
+        }
+
+        if(is_budgeted && ((get_current_time_seconds() - start) * 1000.0 >= budget_ms)){
+            break;
+        }
+    }
+
+    map->bake_seconds += get_current_time_seconds() - start;
+    return cloud_weather_is_idle(*map);
+}
+
+bool cloud_weather_update(cloud_weather_map_t* map, const cloud_raymarch_params_t& params, float camera_x, float camera_z, float budget_ms, unsigned int max_workers)
+{
+    // Same shift as sample_density, the map lives where coverage is read
+    float wind_distance = params.game_time * (params.knobs[6] * 1000.0f);
+    float center_x = camera_x + wind_distance;
+
+    if(!map->is_baked){
+        cloud_weather_bake(map, params, center_x, camera_z, max_workers);
+        return true;
+    }
+
+    cloud_weather_scroll(map, center_x, camera_z);
+
+    // An animated coverage is followed one whole refresh at a time
+    float coverage_time = params.game_time * params.knobs[5];
+    if((coverage_time != map->coverage_time) && cloud_weather_is_idle(*map)){
+        cloud_weather_rect_t window = get_window(*map);
+        queue_rect(map, window.min_x, window.min_z, window.max_x, window.max_z);
+        map->coverage_time = coverage_time;
+    }
+
+    return cloud_weather_step(map, params, budget_ms, max_workers);
+}
+
+void cloud_weather_wait(cloud_weather_map_t* map)
+{
+    if(map->is_baking_rect){
+        volume_fill_task_wait(&map->rect_task);
+    }
+}
+
+bool cloud_weather_is_idle(const cloud_weather_map_t& map)
+{
+    return !map.is_baking_rect && map.pending_rects.empty();
+}
+
+void cloud_weather_sample(const cloud_weather_map_t& map, float x, float z, float* out_channels)
+{
+    float u = (x / map.texel_size) - 0.5f;
+    float v = (z / map.texel_size) - 0.5f;
+    float u0 = floorf(u);
+    float v0 = floorf(v);
+    float fu = u - u0;
+    float fv = v - v0;
+
+    unsigned int x0 = (unsigned int)wrap_texel((int)u0, map.size);
+    unsigned int z0 = (unsigned int)wrap_texel((int)v0, map.size);
+    unsigned int x1 = (x0 + 1 < map.size) ? x0 + 1 : 0;
+    unsigned int z1 = (z0 + 1 < map.size) ? z0 + 1 : 0;
+
+    const unsigned char* t00 = map.texels.get_voxel(x0, z0, 0);
+    const unsigned char* t10 = map.texels.get_voxel(x1, z0, 0);
+    const unsigned char* t01 = map.texels.get_voxel(x0, z1, 0);
+    const unsigned char* t11 = map.texels.get_voxel(x1, z1, 0);
+    for(unsigned int c = 0; c < NUM_CLOUD_WEATHER_CHANNELS; ++c){
+        float top = (float)t00[c] + (((float)t10[c] - (float)t00[c]) * fu);
+        float bottom = (float)t01[c] + (((float)t11[c] - (float)t01[c]) * fu);
+        out_channels[c] = (top + ((bottom - top) * fv)) * (1.0f / 255.0f);
+    }
+}
+
+float cloud_weather_get_coverage(const cloud_weather_map_t& map, float x, float z)
+{
+    float channels[NUM_CLOUD_WEATHER_CHANNELS];
+    cloud_weather_sample(map, x, z, channels);
+    return channels[CLOUD_WEATHER_COVERAGE];
+}
+
+float cloud_weather_get_max_coverage(const cloud_weather_map_t& map, float x0, float z0, float x1, float z1)
+{
+    int i0 = (int)floorf((x0 / map.texel_size) - 0.5f);
+    int i1 = (int)floorf((x1 / map.texel_size) - 0.5f) + 1;
+    int j0 = (int)floorf((z0 / map.texel_size) - 0.5f);
+    int j1 = (int)floorf((z1 / map.texel_size) - 0.5f) + 1;
+
+    // Past a full turn every texel is touched
+    i1 = (i1 - i0 >= (int)map.size) ? i0 + (int)map.size - 1 : i1;
+    j1 = (j1 - j0 >= (int)map.size) ? j0 + (int)map.size - 1 : j1;
+
+    unsigned char max_coverage = 0;
+    for(int j = j0; j <= j1; ++j){
+        unsigned int sz = (unsigned int)wrap_texel(j, map.size);
+        for(int i = i0; i <= i1; ++i){
+            unsigned char coverage = map.texels.get_voxel((unsigned int)wrap_texel(i, map.size), sz, 0)[CLOUD_WEATHER_COVERAGE];
+            max_coverage = (coverage > max_coverage) ? coverage : max_coverage;
+        }
+    }
+    return (float)max_coverage * (1.0f / 255.0f);
+}
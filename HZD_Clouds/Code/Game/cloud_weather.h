@@ -0,0 +1,121 @@
+#pragma once
+
+#include "Game/cloud_raymarch.h"
+#include "Engine/Volume/volume_fill.h"
+
+#include <vector>
+
+//-----------------------------------------------------
+// Cloud weather map
+//
+// Coverage, cloud type and precipitation baked into a 2D RGBA8 map on the
+// CPU, so density samples read coverage bilinearly instead of evaluating
+// three octaves of 3D Perlin each. The map is a <size> x <size> window of
+// <texel_size> texels over the wind-shifted xz plane sample_density reads
+// coverage in. Storage is toroidal, world texel (tx, tz) lives at
+// (tx mod size, tz mod size), so a wrap sampler reads it at uv = xz / extent
+// and scrolling the window only rebakes the strips it newly exposes.
+//
+// Texels hold their world texel's center, the same place a GPU bilinear
+// read puts them. Reads past the window alias onto its far side, so the
+// window should reach the horizon.
+//
+// Bakes run through volume_fill on a scratch buffer the size of the rect and
+// are copied in once the rect is done, the map only ever holds whole rects.
+
+#define CLOUD_WEATHER_BRICK_SIZE    64
+
+enum CloudWeatherChannel : unsigned int
+{
+    CLOUD_WEATHER_COVERAGE = 0,     // cloud_raymarch_get_coverage at the bake's coverage time
+    CLOUD_WEATHER_TYPE,             // 0 stratus .. 1 cumulonimbus, low frequency Perlin
+    CLOUD_WEATHER_PRECIPITATION,    // only where there's coverage
+    NUM_CLOUD_WEATHER_CHANNELS
+};
+
+// World texel range [min, max) on each axis, or storage texels for updated_rects
+struct cloud_weather_rect_t
+{
+    int     min_x;
+    int     min_z;
+    int     max_x;
+    int     max_z;
+
+    bool    is_empty() const    { return (min_x >= max_x) || (min_z >= max_z); }
+};
+
+struct cloud_weather_map_t
+{
+    unsigned int                        size;
+    float                               texel_size;         // meters
+    int                                 origin_x;           // world texel of the window's min corner
+    int                                 origin_z;
+    volume_buffer_t                     texels;             // size x size x 1 RGBA8, toroidal
+
+    bool                                is_baked;
+    unsigned int                        version;            // bumped whenever texels change
+    float                               coverage_time;      // of the last full bake or refresh started
+
+    // Time-sliced bakes, world texel rects oldest first
+    std::vector<cloud_weather_rect_t>   pending_rects;
+    bool                                is_baking_rect;
+    cloud_weather_rect_t                baking_rect;
+    cloud_raymarch_params_t             baking_params;
+    volume_buffer_t                     rect_texels;
+    volume_fill_task_t                  rect_task;
+
+    // Storage rects changed since the owner last cleared this, for uploads
+    std::vector<cloud_weather_rect_t>   updated_rects;
+
+    double                              bake_seconds;       // spent in bakes and steps so far
+    size_t                              num_texels_baked;
+
+    cloud_weather_map_t()
+        :size(0)
+        ,texel_size(0.0f)
+        ,origin_x(0)
+        ,origin_z(0)
+        ,is_baked(false)
+        ,version(0)
+        ,coverage_time(0.0f)
+        ,is_baking_rect(false)
+        ,bake_seconds(0.0)
+        ,num_texels_baked(0)
+    {}
+
+    float get_extent() const        { return (float)size * texel_size; }
+};
+
+// A <size> x <size> map of <texel_size> texels, nothing baked yet
+void    cloud_weather_init(cloud_weather_map_t* map, unsigned int size, float texel_size);
+
+// Bakes the whole window centered on <center_x, center_z> (wind-shifted)
+// right away, dropping any pending rects. Bricks are split across GENERIC
+// jobs plus the caller, needs job_system_init, <max_workers> 0 uses every core.
+void    cloud_weather_bake(cloud_weather_map_t* map, const cloud_raymarch_params_t& params, float center_x, float center_z, unsigned int max_workers = 0);
+
+// Moves the window to <center_x, center_z> and queues the strips it exposed,
+// returns whether it moved. Nothing is baked until the next step.
+bool    cloud_weather_scroll(cloud_weather_map_t* map, float center_x, float center_z);
+
+// Bakes queued rects for up to <budget_ms>, <budget_ms> 0 bakes them all.
+// Like volume_fill_task_step it always makes some progress and never waits
+// on helpers, so cloud_weather_wait before freeing a map that isn't done.
+// Returns true once nothing is left.
+bool    cloud_weather_step(cloud_weather_map_t* map, const cloud_raymarch_params_t& params, float budget_ms, unsigned int max_workers = 0);
+
+// Per frame: bakes the first time, follows the camera at <camera_x, camera_z>
+// shifted by the wind the way sample_density is, queues a full refresh once
+// the map is idle and the coverage animation has moved, then steps.
+bool    cloud_weather_update(cloud_weather_map_t* map, const cloud_raymarch_params_t& params, float camera_x, float camera_z, float budget_ms, unsigned int max_workers = 0);
+
+void    cloud_weather_wait(cloud_weather_map_t* map);
+bool    cloud_weather_is_idle(const cloud_weather_map_t& map);
+
+// Bilinear like a linear wrap sampler, <x, z> wind-shifted. Every channel 0..1.
+void    cloud_weather_sample(const cloud_weather_map_t& map, float x, float z, float* out_channels);
+float   cloud_weather_get_coverage(const cloud_weather_map_t& map, float x, float z);
+
+// Largest coverage a bilinear read anywhere in [x0, x1] x [z0, z1] can return,
+// the max of every texel those reads touch
+float   cloud_weather_get_max_coverage(const cloud_weather_map_t& map, float x0, float z0, float x1, float z1);
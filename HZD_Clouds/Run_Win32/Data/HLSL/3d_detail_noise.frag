@@ -67,12 +67,12 @@ float calculate_detail_worley_one(float3 pos)
 
 float calculate_detail_worley_two(float3 pos)
 {
-    return 1.0f - get_worley_noise_3d(pos, WORLEY_TWO_SCALE, DETAIL_WORLEY_NUM_OCTAVES, DETAIL_WORLEY_OCTAVE_PERSISTENCE, DETAIL_WORLEY_OCTAVE_SCALE, true);
+    return 1.0f - get_worley_noise_3d(pos, DETAIL_WORLEY_TWO_SCALE, DETAIL_WORLEY_NUM_OCTAVES, DETAIL_WORLEY_OCTAVE_PERSISTENCE, DETAIL_WORLEY_OCTAVE_SCALE, true);
 }
 
 float calculate_detail_worley_three(float3 pos)
 {
-    return 1.0f - get_worley_noise_3d(pos, WORLEY_THREE_SCALE, DETAIL_WORLEY_NUM_OCTAVES, DETAIL_WORLEY_OCTAVE_PERSISTENCE, DETAIL_WORLEY_OCTAVE_SCALE, true);
+    return 1.0f - get_worley_noise_3d(pos, DETAIL_WORLEY_THREE_SCALE, DETAIL_WORLEY_NUM_OCTAVES, DETAIL_WORLEY_OCTAVE_PERSISTENCE, DETAIL_WORLEY_OCTAVE_SCALE, true);
 }
 
 // Needs to output float4(Perlin-Worley, Worley, Worley, Worley)
@@ -15,6 +15,7 @@
 
 Texture3D <float4> tBaseImage : register(t0);
 Texture3D <float4> tDetailImage : register(t1);
+Texture2D <float4> tWeatherMap : register(t2);     // r coverage, g cloud type, b precipitation, see cloud_weather.h
 
 
 
@@ -85,6 +86,7 @@ cbuffer view_camera_buffer : register(b4)
     float4 CUMULUS_GRADIENT;
     float4 CUMULONUMBIS_GRADIENT;
     float4 WIND;
+    float4 WEATHER_MAP;     // x 1 / extent in meters, y 1 when tWeatherMap is bound
 }
 
 
@@ -263,6 +265,12 @@ bool get_cloud_layer(in float3 eye_pos, in float3 ray_dir, out float3 cloud_laye
 
 float get_coverage(float2 world_xz)
 {
+    // baked on the CPU, toroidal so the wrap sampler reads it straight from world xz
+    if (WEATHER_MAP.y > 0.0f)
+    {
+        return tWeatherMap.SampleLevel(sSampler, world_xz * WEATHER_MAP.x, 0).r;
+    }
+
 	//float scale = MIDI.SLIDER_0 * 10000.0f;
 	//int num_octaves = (int)(MIDI.SLIDER_1 * 10.0f);
 	//float octave_scale = MIDI.SLIDER_2 * 4.0f;